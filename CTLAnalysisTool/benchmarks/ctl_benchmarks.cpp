@@ -0,0 +1,162 @@
+#include <benchmark/benchmark.h>
+#include "../include/parser.h"
+#include "../include/formula_utils.h"
+#include "../include/CTLautomaton.h"
+#include "../include/property_generator.h"
+#ifdef USE_Z3
+#include "../include/SMTInterfaces/Z3SMTInterface.h"
+#endif
+
+#include <string>
+#include <vector>
+
+using namespace ctl;
+
+// Every benchmark takes (formula depth, atoms per class) from its arguments and
+// works on a fixed, seeded sample of generated properties, so runs compare.
+// The generator stops early at random, so samples are drawn with the depth as
+// a minimum complexity as well as a maximum.
+namespace {
+
+constexpr size_t kSample = 16;
+
+GenerationConfig configFor(const benchmark::State& state, double temporal_probability = 0.6) {
+    GenerationConfig config;
+    config.num_classes = 1;
+    config.max_depth = static_cast<size_t>(state.range(0));
+    config.max_atoms_per_class = static_cast<size_t>(state.range(1));
+    config.temporal_probability = temporal_probability;
+    config.binary_probability = 0.9;
+    config.use_time_intervals = false;
+    return config;
+}
+
+std::vector<std::shared_ptr<CTLProperty>> sample(const GenerationConfig& config) {
+    return benchmark_utils::generateComplexProperties(kSample, config.max_depth, config.max_depth, config);
+}
+
+// (refined, base) pairs over the same sample
+std::vector<std::pair<std::shared_ptr<CTLProperty>, std::shared_ptr<CTLProperty>>> samplePairs(
+    const GenerationConfig& config) {
+    PropertyGenerator generator(config);
+    std::vector<std::pair<std::shared_ptr<CTLProperty>, std::shared_ptr<CTLProperty>>> pairs;
+    for (const auto& base : sample(config)) pairs.emplace_back(generator.refineProperty(*base, 0), base);
+    return pairs;
+}
+
+std::vector<std::string> sampleStrings(const GenerationConfig& config) {
+    std::vector<std::string> formulas;
+    for (const auto& property : sample(config)) formulas.push_back(property->toString());
+    return formulas;
+}
+
+void shapes(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"depth", "atoms"});
+    for (int depth : {2, 4, 6}) {
+        for (int atoms : {2, 8}) b->Args({depth, atoms});
+    }
+}
+
+} // end anonymous namespace
+
+static void BM_Lexer(benchmark::State& state) {
+    const auto formulas = sampleStrings(configFor(state));
+    size_t i = 0;
+    for (auto _ : state) {
+        Lexer lexer(formulas[i++ % formulas.size()]);
+        benchmark::DoNotOptimize(lexer.getTokens().data());
+    }
+}
+BENCHMARK(BM_Lexer)->Apply(shapes);
+
+static void BM_Parser(benchmark::State& state) {
+    const auto formulas = sampleStrings(configFor(state));
+    std::vector<Lexer> lexers;
+    for (const auto& formula : formulas) lexers.emplace_back(formula);
+    size_t i = 0;
+    for (auto _ : state) {
+        Parser parser(lexers[i++ % lexers.size()].getTokens());
+        benchmark::DoNotOptimize(parser.parse());
+    }
+}
+BENCHMARK(BM_Parser)->Apply(shapes);
+
+static void BM_PreprocessFormula(benchmark::State& state) {
+    const auto properties = sample(configFor(state));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(formula_utils::preprocessFormula(properties[i++ % properties.size()]->getFormula()));
+    }
+}
+BENCHMARK(BM_PreprocessFormula)->Apply(shapes);
+
+static void BM_BuildAutomaton(benchmark::State& state) {
+    const auto properties = sample(configFor(state));
+    size_t i = 0;
+    for (auto _ : state) {
+        CTLAutomaton automaton(properties[i++ % properties.size()]->getFormula());
+        benchmark::DoNotOptimize(automaton.getInitialStateId());
+    }
+}
+BENCHMARK(BM_BuildAutomaton)->Apply(shapes);
+
+// Pair kernels build both automata in every iteration, so expanded moves and
+// complements are not reused from an earlier one
+static void BM_Simulates(benchmark::State& state) {
+    const auto pairs = samplePairs(configFor(state));
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& [refined, base] = pairs[i++ % pairs.size()];
+        CTLAutomaton refined_automaton(refined->getFormula());
+        CTLAutomaton base_automaton(base->getFormula());
+        benchmark::DoNotOptimize(base_automaton.simulates(refined_automaton));
+    }
+}
+BENCHMARK(BM_Simulates)->Apply(shapes);
+
+static void BM_LanguageIncludes(benchmark::State& state) {
+    const auto pairs = samplePairs(configFor(state));
+    const auto engine = static_cast<EmptinessEngine>(state.range(2));
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& [refined, base] = pairs[i++ % pairs.size()];
+        CTLAutomaton refined_automaton(refined->getFormula());
+        CTLAutomaton base_automaton(base->getFormula());
+        benchmark::DoNotOptimize(base_automaton.languageIncludes(refined_automaton, engine));
+    }
+}
+BENCHMARK(BM_LanguageIncludes)->Apply([](benchmark::internal::Benchmark* b) {
+    b->ArgNames({"depth", "atoms", "engine"});
+    for (int depth : {2, 4}) {
+        for (int atoms : {2, 8}) {
+            for (auto engine : {EmptinessEngine::FIXPOINT, EmptinessEngine::ON_THE_FLY, EmptinessEngine::ANTICHAIN}) {
+                b->Args({depth, atoms, static_cast<int>(engine)});
+            }
+        }
+    }
+});
+
+#ifdef USE_Z3
+// Guards are propositional: the samples below have no temporal operators
+static void BM_ParseStringToZ3(benchmark::State& state) {
+    const auto formulas = sampleStrings(configFor(state, 0.0));
+    z3::context ctx;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(formula_utils::parseStringToZ3(formulas[i++ % formulas.size()], ctx));
+    }
+}
+BENCHMARK(BM_ParseStringToZ3)->Apply(shapes);
+
+static void BM_Z3IsSatisfiable(benchmark::State& state) {
+    const auto formulas = sampleStrings(configFor(state, 0.0));
+    Z3SMTInterface smt;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(smt.isSatisfiable(formulas[i++ % formulas.size()]));
+    }
+}
+BENCHMARK(BM_Z3IsSatisfiable)->Apply(shapes);
+#endif
+
+BENCHMARK_MAIN();
@@ -5,16 +5,24 @@
 #include "utils.h"
 #include "property.h"
 #include "parser.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
 
 
 void printUsage()
 {
-    std::cout << "Usage: collect_formula_info <input> [output_dir]\n";
+    std::cout << "Usage: collect_formula_info <input> [output_dir] [-j <threads>]\n";
     std::cout << "Collects information about CTL formulas from the input.\n";
     std::cout << "Input can be either a single .txt file containing CTL formulas (one per line),\n";
     std::cout << "or a directory containing multiple .txt files.\n";
     std::cout << "If output_dir is not provided, 'formula_info' will be used.\n";
+    std::cout << "Files and formulas are analyzed on <threads> threads (default: all cores).\n";
 }
 
 struct FolderStats {
@@ -26,34 +34,181 @@ struct FolderStats {
     double avg_boolean_atoms = 0.0;
 };
 
-FolderStats analyze_folder(const std::string& input, const std::string& output_dir, const std::string& postfix)
+// What one formula contributes to the totals of its file
+struct FormulaInfo {
+    size_t size = 0;
+    size_t num_atoms = 0;
+    int simple_atoms = 0;
+    int comparison_atoms = 0;
+    int boolean_atoms = 0;
+};
+
+// Running sums of one file. Every term is an integer, so the order in which
+// the chunks of a file are merged does not change them
+struct FileTotals {
+    int size = 0;
+    double atomic_complexity = 0.0;
+    double num_atoms = 0.0;
+    double simple_atoms = 0.0;
+    double comparison_atoms = 0.0;
+    double boolean_atoms = 0.0;
+
+    void add(const FormulaInfo& info) {
+        size += info.size;
+        num_atoms += info.num_atoms;
+        simple_atoms += info.simple_atoms;
+        comparison_atoms += info.comparison_atoms;
+        boolean_atoms += info.boolean_atoms;
+        // Simple atoms = 1 point, Comparisons = 2 points, Boolean combinations = 3 points
+        atomic_complexity += info.simple_atoms * 1.0 + info.comparison_atoms * 2.0 + info.boolean_atoms * 3.0;
+    }
+    void merge(const FileTotals& other) {
+        size += other.size;
+        atomic_complexity += other.atomic_complexity;
+        num_atoms += other.num_atoms;
+        simple_atoms += other.simple_atoms;
+        comparison_atoms += other.comparison_atoms;
+        boolean_atoms += other.boolean_atoms;
+    }
+};
+
+// A property file, mapped, its formulas summed by the pool as they are analyzed
+struct FileJob {
+    std::string path;
+    std::unique_ptr<ctl::MappedFile> file;
+    std::vector<std::string_view> properties;  // into file
+    std::mutex mutex;
+    FileTotals totals;  // guarded by mutex
+};
+
+struct FolderJob {
+    std::string postfix;
+    std::vector<std::unique_ptr<FileJob>> files;
+    bool failed = false;  // reported already; all averages are 0
+};
+
+// Formulas per task: enough to amortize the submit, few enough to spread a
+// large file over every worker
+constexpr size_t kFormulasPerTask = 64;
+
+// Per worker, the info of every formula text the worker has analyzed;
+// nullopt if it does not parse. Datasets repeat formulas across files
+using FormulaCache = std::unordered_map<std::string, std::optional<FormulaInfo>>;
+
+FormulaInfo describeFormula(std::string_view prop_str)
 {
-    
+    FormulaInfo info;
+    auto formula = ctl::formula_utils::preprocessFormula(*ctl::Parser::parseFormula(prop_str));
+    auto property = ctl::CTLProperty::create(formula);
+    info.size = property->size();
+
+    // Get atomic propositions for counting (just variable names)
+    info.num_atoms = property->getAtomicPropositions().size();
+
+    // Get atomic propositions for complexity analysis (includes comparisons and boolean combos)
+    for (const auto& atom : ctl::formula_utils::getAtomicForAnalysis(*formula)) {
+        // Check if atom contains comparison operators
+        bool has_comparison = (atom.find("<=") != std::string::npos ||
+                             atom.find(">=") != std::string::npos ||
+                             atom.find("==") != std::string::npos ||
+                             atom.find("!=") != std::string::npos ||
+                             atom.find('<') != std::string::npos ||
+                             atom.find('>') != std::string::npos);
+
+        // Check if atom contains boolean combinations (& or |, not just negation)
+        bool has_boolean_combo = (atom.find('&') != std::string::npos ||
+                                 atom.find('|') != std::string::npos);
+
+        // Classify the atom
+        if (has_boolean_combo) {
+            // Complex boolean expression combining multiple atoms
+            info.boolean_atoms++;
+        } else if (has_comparison) {
+            // Comparison (including negated comparisons like !(x <= y))
+            info.comparison_atoms++;
+        } else {
+            // Simple atomic proposition (just a variable name, possibly negated)
+            info.simple_atoms++;
+        }
+    }
+    return info;
+}
+
+// Maps the files of a folder (or the single input file) and queues their formulas
+FolderJob plan_folder(const std::string& input, const std::string& postfix)
+{
+    FolderJob job;
+    job.postfix = postfix;
+
      // Check if input exists
     if (!ctl::pathExists(input)) {
         std::cerr << "Error: Input path does not exist: " << input << "\n";
-        return FolderStats{};
+        job.failed = true;
+        return job;
     }
 
-    
     // Determine if input is a file or folder
-    bool is_folder = ctl::isDirectory(input);
     std::vector<std::string> input_files;
-    
-    if (is_folder) {
+    if (ctl::isDirectory(input)) {
         input_files = ctl::getTextFilesInDirectory(input);
         if (input_files.empty()) {
             std::cerr << "Error: No .txt files found in folder: " << input << "\n";
-            return FolderStats{};
+            job.failed = true;
+            return job;
         }
     } else {
         // Single file
         input_files.push_back(input);
     }
 
+    for (const auto& path : input_files) {
+        auto file = std::make_unique<FileJob>();
+        file->path = path;
+        // The main tool's loader: lines are views into the mapping
+        file->file = std::make_unique<ctl::MappedFile>(path);
+        file->properties = ctl::splitPropertyLines(file->file->contents());
+        job.files.push_back(std::move(file));
+    }
+    return job;
+}
+
+void submit_folder(FolderJob& job, ctl::WorkStealingPool& pool, std::vector<FormulaCache>& caches)
+{
+    for (auto& file : job.files) {
+        FileJob* target = file.get();
+        for (size_t begin = 0; begin < target->properties.size(); begin += kFormulasPerTask) {
+            const size_t end = std::min(begin + kFormulasPerTask, target->properties.size());
+            pool.submit([target, begin, end, &caches](size_t worker) {
+                FormulaCache& cache = caches[worker];
+                FileTotals totals;
+                for (size_t i = begin; i < end; ++i) {
+                    const std::string_view prop_str = target->properties[i];
+                    auto [it, inserted] = cache.try_emplace(std::string(prop_str));
+                    if (inserted) {
+                        try {
+                            it->second = describeFormula(prop_str);
+                        }
+                        catch (const std::exception& e) {
+                            std::cerr << "Warning: Failed to parse property '" << prop_str
+                                      << "': " << e.what() << std::endl;
+                        }
+                    }
+                    if (it->second) totals.add(*it->second);
+                }
+                std::lock_guard<std::mutex> lock(target->mutex);
+                target->totals.merge(totals);
+            });
+        }
+    }
+}
+
+// Writes the per-file CSV of a finished folder and averages its files
+FolderStats finish_folder(const FolderJob& job, const std::string& output_dir)
+{
+    if (job.failed) return FolderStats{};
 
     // In this folder, we create one output file called "info.csv"
-    std::string output_file = ctl::joinPaths(output_dir, "info_per_file_" + postfix + ".csv");
+    std::string output_file = ctl::joinPaths(output_dir, "info_per_file_" + job.postfix + ".csv");
     std::ofstream ofs(output_file);
     if (!ofs.is_open()) {
         std::cerr << "Error: Failed to open output file for writing: " << output_file << "\n";
@@ -70,99 +225,32 @@ FolderStats analyze_folder(const std::string& input, const std::string& output_d
     double total_comparison_atoms = 0.0;
     double total_boolean_atoms = 0.0;
 
-    for (const auto& file : input_files) {
-        auto properties = ctl::loadPropertiesFromFile(file);
-
-        int total_size_per_file = 0;
-        double total_atomic_complexity_per_file = 0.0;
-        double total_num_atoms_per_file = 0.0;
-        double total_simple_atoms_per_file = 0.0;
-        double total_comparison_atoms_per_file = 0.0;
-        double total_boolean_atoms_per_file = 0.0;
-        
-        for (const auto& prop_str : properties) {
-            try {
-                auto formula = ctl::formula_utils::preprocessFormula(*ctl::Parser::parseFormula(prop_str));
-                auto property = ctl::CTLProperty::create(formula);
-                total_size_per_file += property->size();
-                
-                // Get atomic propositions for counting (just variable names)
-                auto simple_atoms = property->getAtomicPropositions();
-                total_num_atoms_per_file += simple_atoms.size();
-  
-                // Get atomic propositions for complexity analysis (includes comparisons and boolean combos)
-                auto atoms_for_analysis = ctl::formula_utils::getAtomicForAnalysis(*formula);
-                
-                // Analyze each atomic proposition for complexity
-                int simple_count = 0;
-                int comparison_count = 0;
-                int boolean_count = 0;
-                
-                for (const auto& atom : atoms_for_analysis) {
-                    // Check if atom contains comparison operators
-                    bool has_comparison = (atom.find("<=") != std::string::npos ||
-                                         atom.find(">=") != std::string::npos ||
-                                         atom.find("==") != std::string::npos ||
-                                         atom.find("!=") != std::string::npos ||
-                                         atom.find('<') != std::string::npos ||
-                                         atom.find('>') != std::string::npos);
-                    
-                    // Check if atom contains boolean combinations (& or |, not just negation)
-                    bool has_boolean_combo = (atom.find('&') != std::string::npos ||
-                                             atom.find('|') != std::string::npos);
-                    
-                    // Classify the atom
-                    if (has_boolean_combo) {
-                        // Complex boolean expression combining multiple atoms
-                        boolean_count++;
-                    } else if (has_comparison) {
-                        // Comparison (including negated comparisons like !(x <= y))
-                        comparison_count++;
-                    } else {
-                        // Simple atomic proposition (just a variable name, possibly negated)
-                        simple_count++;
-                    }
-                }
-                
-                total_simple_atoms_per_file += simple_count;
-                total_comparison_atoms_per_file += comparison_count;
-                total_boolean_atoms_per_file += boolean_count;
-                
-                // Calculate atomic complexity score for this property
-                // Simple atoms = 1 point, Comparisons = 2 points, Boolean combinations = 3 points
-                double atomic_complexity = simple_count * 1.0 + comparison_count * 2.0 + boolean_count * 3.0;
-                total_atomic_complexity_per_file += atomic_complexity;
-                
-            }
-            catch (const std::exception& e) {
-                std::cerr << "Warning: Failed to parse property '" << prop_str 
-                          << "': " << e.what() << std::endl;
-                continue;
-            }
-        }
+    for (const auto& file : job.files) {
+        const FileTotals& totals = file->totals;
+        const size_t num_properties = file->properties.size();
 
         //write to CSV
         //file name is file - .txt
-        std::string file_name = file;;
+        std::string file_name = file->path;
         if (file_name.size() >= 4 && file_name.substr(file_name.size() - 4) == ".txt") {
             file_name = file_name.substr(0, file_name.size() - 4);
             //remove path
             size_t pos = file_name.find_last_of("/\\");
             if (pos != std::string::npos) {
-                file_name = file_name.substr(pos + 1);;
+                file_name = file_name.substr(pos + 1);
             }
         }
         
-        double avg_size = properties.size() > 0 ? (double)total_size_per_file / properties.size() : 0.0;
-        double avg_atomic_complexity = properties.size() > 0 ? total_atomic_complexity_per_file / properties.size() : 0.0;
-        double avg_num_atoms = properties.size() != 0 ? total_num_atoms_per_file / properties.size() : 0.0;
-        double avg_simple = properties.size() > 0 ? total_simple_atoms_per_file / properties.size() : 0.0;
-        double avg_comparison = properties.size() > 0 ? total_comparison_atoms_per_file / properties.size() : 0.0;
-        double avg_boolean = properties.size() > 0 ? total_boolean_atoms_per_file / properties.size() : 0.0;
+        double avg_size = num_properties > 0 ? (double)totals.size / num_properties : 0.0;
+        double avg_atomic_complexity = num_properties > 0 ? totals.atomic_complexity / num_properties : 0.0;
+        double avg_num_atoms = num_properties != 0 ? totals.num_atoms / num_properties : 0.0;
+        double avg_simple = num_properties > 0 ? totals.simple_atoms / num_properties : 0.0;
+        double avg_comparison = num_properties > 0 ? totals.comparison_atoms / num_properties : 0.0;
+        double avg_boolean = num_properties > 0 ? totals.boolean_atoms / num_properties : 0.0;
         
         ofs << file_name << "," 
-            << properties.size() << "," 
-            << total_size_per_file << "," 
+            << num_properties << "," 
+            << totals.size << "," 
             << avg_size << ","
             << avg_atomic_complexity << ","
             << avg_num_atoms << ","
@@ -179,7 +267,7 @@ FolderStats analyze_folder(const std::string& input, const std::string& output_d
     }
     
     // Calculate averages across all files and return
-    size_t num_files = input_files.size();
+    size_t num_files = job.files.size();
     FolderStats stats;
     stats.avg_size = num_files > 0 ? total_size / num_files : 0.0;
     stats.avg_atomic_complexity = num_files > 0 ? total_atomic_complexity / num_files : 0.0;
@@ -196,14 +284,24 @@ int main(int argc, char* argv[]) {
     
     std::string input;
     std::string output_dir = "formula_info";
+    size_t num_threads = std::thread::hardware_concurrency();
 
-    if (argc < 2) {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-j" || arg == "--threads") && i + 1 < argc) {
+            num_threads = std::stoul(argv[++i]);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.empty()) {
         printUsage();
         return 1;
     }
-    input = argv[1];
-    if (argc >= 3) {
-        output_dir = argv[2];
+    input = positional[0];
+    if (positional.size() >= 2) {
+        output_dir = positional[1];
     }
 
 
@@ -254,6 +352,9 @@ int main(int argc, char* argv[]) {
     
 
 
+    // Every folder's formulas go to one pool, so small folders do not leave
+    // workers idle; the outputs are then written in folder and file order
+    std::vector<FolderJob> jobs;
     for (int i=0; i < input_directories.size(); i++) {
         //postfix is the last part of the path
         std::string postfix = input_directories[i];
@@ -261,7 +362,19 @@ int main(int argc, char* argv[]) {
         if (pos != std::string::npos) {
             postfix = postfix.substr(pos + 1);;
         }
-        FolderStats stats = analyze_folder(input_directories[i], output_dir, postfix);
+        jobs.push_back(plan_folder(input_directories[i], postfix));
+    }
+
+    ctl::WorkStealingPool pool(std::max<size_t>(num_threads, 1));
+    std::vector<FormulaCache> caches(pool.size());
+    for (auto& job : jobs) {
+        submit_folder(job, pool, caches);
+    }
+    pool.wait();
+
+    for (const auto& job : jobs) {
+        const std::string& postfix = job.postfix;
+        FolderStats stats = finish_folder(job, output_dir);
         
         std::cout << postfix << ":\n";
         std::cout << "  Avg Size: " << stats.avg_size << "\n";
@@ -7,12 +7,28 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <algorithm>
+#include <mutex>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <cstdlib>
+#include <limits>
 #include "Analyzers/Refinement.h"
 #include "parser.h"
 #include "synthetic_benchmark.h"
 #include "ExternalCTLSAT/ctl_sat.h"
 #include "utils.h"
 #include "types.h"
+#include "smt_context_manager.h"
+#include "work_stealing_pool.h"
+#include "automaton_budget.h"
+#include "analysis_server.h"
+#include "automaton_cache.h"
+#include "scaling_benchmark.h"
+#include "trace.h"
+#include "log.h"
+#include "progress_reporter.h"
+#include <sstream>
 
 void printUsage(const char* program_name) {
     std::cout << "Usage: " << program_name << " [options] <input_file_or_folder>\n";
@@ -24,30 +40,127 @@ void printUsage(const char* program_name) {
     std::cout << "  -p, --parallel       Enable parallel analysis (default)\n";
     std::cout << "  -j, --threads <n>    Number of threads to use\n";
     std::cout << "  -v, --verbose        Verbose output\n";
+    std::cout << "  --log-level <level>  error, warn, info, debug or trace (default: info)\n";
     std::cout << "  --no-parallel        Disable parallel analysis\n";
     std::cout << "  --no-transitive      Disable transitive closure optimization\n";
+    std::cout << "  --no-prefilter       Check every pair semantically, even those decidable from signatures\n";
+    std::cout << "  --polarity-classes   Group properties only through atoms they share with the same polarity\n";
+    std::cout << "  --class-simulation   Compute the simulations of a class in one fixpoint instead of per pair\n";
+    std::cout << "  --shared-subformulas Share subformula moves and simulation verdicts within a class\n";
+    std::cout << "  --compositional      Split pairs on top-level | and & and cache the part verdicts for the run\n";
+    std::cout << "  --pipeline           Overlap pruning, class building and refinement (parallel runs without checkpoints)\n";
+    std::cout << "  --portfolio          Race simulation, full inclusion and the external SAT backend (if set) on each pair\n";
+    std::cout << "  --joint-pairs        Decide both directions of a pair in one task, sharing their setup\n";
+    std::cout << "  --witness-pool       Model check each pair against the models of earlier refutations in its class\n";
+    std::cout << "  --no-dedup           Analyze duplicate properties separately instead of merging equal formulas\n";
     std::cout << "  --semantic           Use semantic refinement (ABTA-based)\n";
     std::cout << "  --use-full-language-inclusion  Use full language inclusion for refinement checking\n";
     std::cout << "  --use-simulation      Use simulation for refinement checking\n";
+    std::cout << "  --emptiness <engine>  Emptiness engine for language inclusion: fixpoint, otf, antichain or auto (default: fixpoint)\n";
+    std::cout << "  --bdd-guards          Decide propositional guards with BDDs, SMT only for comparisons\n";
     std::cout << "  --use-extern-sat <interface>  Specify which external SAT interface to use (CTLSAT, MOMOCTL, MLSOLVER)\n";
     std::cout << "  --sat-path <path>  Specify the path to the external SAT solver\n";
+    std::cout << "  --sat-workers <n>    Maximum number of concurrent external solver processes (default: threads)\n";
+    std::cout << "  --sat-timeout <s>    Kill an external solver query after <s> seconds (default: no limit)\n";
+    std::cout << "  --sat-memory <mb>    Limit the address space of each external solver process (default: no limit)\n";
+    std::cout << "  --check-timeout <s>  Cancel a refinement check after <s> seconds and leave its pair undecided (default: no limit)\n";
+    std::cout << "  --checkpoint-interval <s>  Save analysis progress to <output>/checkpoint.bin every <s> seconds\n";
+    std::cout << "  --resume             Skip the work saved in checkpoint.bin by an interrupted run (implies checkpointing)\n";
+    std::cout << "  --shard <k>/<N>      Distributed worker: analyze only shard k of N and save it to <output>/shard-k-of-N.ckpt\n";
+    std::cout << "  --shard-rows <n>     Split classes of more than <n> properties into row blocks across shards (default: 64)\n";
+    std::cout << "  --merge-shards <N>   Distributed coordinator: restore the N shard checkpoints in <output>, finish and report\n";
+    std::cout << "  --cost-model <csv>   Fit the check-time model to the samples in <csv>, then append this run's samples\n";
+    std::cout << "  --max-automaton-memory <mb>  Evict least recently used automata beyond <mb> MB, rebuilding them on demand\n";
+    std::cout << "  --cache-dir <dir>    Reuse refinement/satisfiability verdicts stored in <dir> across runs\n";
+    std::cout << "  --automaton-cache <dir>  Save built automata to <dir> and load them from there in later runs\n";
+    std::cout << "  --manifest <file>    Process the property files listed in <file>, one path per line\n";
+    std::cout << "  --file-jobs <n>      Analyze up to <n> input files at once, sharing the threads (default: 1)\n";
+    std::cout << "  --json <file>        Also stream one JSON object per input file to <file>\n";
+    std::cout << "  --progress <file>    Append a JSON progress line (pairs left, rates, ETA, caches, RSS, threads) to <file> periodically\n";
+    std::cout << "  --progress-interval <s>  Seconds between progress lines (default: 10)\n";
+    std::cout << "  --stats-json <file>  Also write the SMT, simulation, product and SCC counters per input file to <file>\n";
+    std::cout << "  --trace <file>       Write a Chrome trace (chrome://tracing, Perfetto) of phases and checks to <file>\n";
+    std::cout << "  --serve <socket>     Keep the analysis resident and answer queries on a Unix socket (the input, if any, is loaded first)\n";
+    std::cout << "\n";
+    std::cout << "Scaling benchmark (no input needed):\n";
+    std::cout << "  --scaling <file>     Sweep generated classes and write one JSON line per point to <file>\n";
+    std::cout << "  --scaling-sizes <list>    Class sizes n, comma separated (default: 8,16,32)\n";
+    std::cout << "  --scaling-depths <list>   Formula depths (default: 2,4)\n";
+    std::cout << "  --scaling-threads <list>  Thread counts (default: 1,2,4)\n";
+    std::cout << "  --scaling-engines <list>  simulation, inclusion, ctlsat, mlsolver (default: simulation,inclusion)\n";
     std::cout << "\n";
     std::cout << "Input can be either a .txt file or a folder containing .txt files.\n";
-    std::cout << "If a folder is provided, all .txt files will be processed.\n";
+    std::cout << "If a folder is provided, all .txt files will be processed, largest first,\n";
+    std::cout << "in one process with shared caches and a single results CSV.\n";
     std::cout << "\n";
 
 
     std::cout << "Input file should contain one CTL formula per line.\n";
 }
 
+// Comma separated list, e.g. "1,2,4"
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    for (std::string item; std::getline(in, item, ',');) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// Values of numeric options. A malformed or out-of-range one ends the run
+// with an error instead of an uncaught exception
+size_t sizeOption(const std::string& option, const std::string& value) {
+    try {
+        size_t used = 0;
+        const unsigned long long parsed = std::stoull(value, &used);
+        if (used == value.size() && value[0] != '-' && parsed <= std::numeric_limits<size_t>::max()) return parsed;
+    } catch (const std::exception&) {
+    }
+    std::cerr << "Error: " << option << " expects a non-negative integer, got '" << value << "'\n";
+    std::exit(1);
+}
+
+double numberOption(const std::string& option, const std::string& value) {
+    try {
+        size_t used = 0;
+        const double parsed = std::stod(value, &used);
+        if (used == value.size() && parsed >= 0) return parsed;
+    } catch (const std::exception&) {
+    }
+    std::cerr << "Error: " << option << " expects a non-negative number, got '" << value << "'\n";
+    std::exit(1);
+}
+
 int main(int argc, char* argv[]) {
     std::string input_file;
     std::string output_dir = "output";
     bool use_syntactic = false;
+    bool use_prefilter = true;
+    bool use_polarity_classes = false;
+    bool use_class_simulation = false;
+    bool use_shared_subformulas = false;
+    bool use_compositional = false;
+    bool use_pipeline = false;
+    bool use_portfolio = false;
+    bool use_joint_pairs = false;
+    bool use_witness_pool = false;
+    bool use_dedup = true;
     bool use_parallel = false;  
     bool use_transitive = true;  
     bool use_language_inclusion = true;
+    ctl::EmptinessEngine emptiness_engine = ctl::EmptinessEngine::FIXPOINT;
     size_t num_threads = std::thread::hardware_concurrency();
+    size_t sat_workers = 0;      // 0: one solver process per analysis thread
+    size_t sat_timeout_s = 0;    // 0: no per-query limit
+    size_t sat_memory_mb = 0;    // 0: no per-query limit
+    double check_timeout_s = 0;  // 0: no per-check limit
+    size_t checkpoint_interval_s = 0;  // 0: no checkpoint unless resuming
+    bool resume = false;
+    size_t shard_index = 0;
+    size_t shard_count = 0;      // 0: not a shard worker
+    size_t shard_rows = 64;
+    size_t merge_shards = 0;     // 0: not a coordinator
     ctl::AvailableCTLSATInterfaces sat_interface = ctl::AvailableCTLSATInterfaces::CTLSAT;
     bool verbose = false;
     bool use_extern_sat = false;
@@ -58,6 +171,18 @@ int main(int argc, char* argv[]) {
     std::string input_csv;
     std::string output_csv = "benchmark_results.csv";
     std::string sat_path = "./extern/ctl-sat";
+    std::string cache_dir;
+    std::string cost_samples;    // empty: default cost model, nothing recorded
+    std::string progress_file;
+    double progress_interval_s = 10;
+    std::string manifest;
+    std::string json_results;
+    std::string trace_file;
+    std::string stats_json;
+    size_t file_jobs = 1;
+    std::string scaling_output;
+    std::string serve_socket;
+    ctl::ScalingConfig scaling_config;
     // Parse command line arguments
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -82,10 +207,51 @@ int main(int argc, char* argv[]) {
             use_parallel = false;
         } else if (arg == "--no-transitive") {
             use_transitive = false;
+        } else if (arg == "--no-prefilter") {
+            use_prefilter = false;
+        } else if (arg == "--polarity-classes") {
+            use_polarity_classes = true;
+        } else if (arg == "--class-simulation") {
+            use_class_simulation = true;
+        } else if (arg == "--shared-subformulas") {
+            use_shared_subformulas = true;
+        } else if (arg == "--compositional") {
+            use_compositional = true;
+        } else if (arg == "--pipeline") {
+            use_pipeline = true;
+        } else if (arg == "--portfolio") {
+            use_portfolio = true;
+        } else if (arg == "--joint-pairs") {
+            use_joint_pairs = true;
+        } else if (arg == "--witness-pool") {
+            use_witness_pool = true;
+        } else if (arg == "--no-dedup") {
+            use_dedup = false;
         } else if (arg == "--use-full-language-inclusion") {
             use_language_inclusion = true;
         } else if (arg == "--use-simulation") {
             use_language_inclusion = false;
+        } else if (arg == "--emptiness") {
+            if (i + 1 < argc) {
+                std::string engine_str = argv[++i];
+                if (engine_str == "fixpoint") {
+                    emptiness_engine = ctl::EmptinessEngine::FIXPOINT;
+                } else if (engine_str == "otf") {
+                    emptiness_engine = ctl::EmptinessEngine::ON_THE_FLY;
+                } else if (engine_str == "antichain") {
+                    emptiness_engine = ctl::EmptinessEngine::ANTICHAIN;
+                } else if (engine_str == "auto") {
+                    emptiness_engine = ctl::EmptinessEngine::AUTO;
+                } else {
+                    std::cerr << "Error: Unknown emptiness engine: " << engine_str << "\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --emptiness option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--bdd-guards") {
+            ctl::SMTContextManager::setPropositionalGuards(true);
         } else if (arg == "--use-extern-sat") {
             use_extern_sat = true;
             if (i + 1 < argc) {
@@ -113,15 +279,168 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Error: --ctl-sat-path option requires an argument\n";
                 return 1;
             }
+        } else if (arg == "--sat-workers" || arg == "--sat-timeout" || arg == "--sat-memory") {
+            if (i + 1 < argc) {
+                size_t value = sizeOption(arg, argv[++i]);
+                if (arg == "--sat-workers") sat_workers = value;
+                else if (arg == "--sat-timeout") sat_timeout_s = value;
+                else sat_memory_mb = value;
+            } else {
+                std::cerr << "Error: " << arg << " option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--check-timeout") {
+            if (i + 1 < argc) {
+                check_timeout_s = numberOption(arg, argv[++i]);
+            } else {
+                std::cerr << "Error: --check-timeout option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--checkpoint-interval") {
+            if (i + 1 < argc) {
+                checkpoint_interval_s = sizeOption(arg, argv[++i]);
+            } else {
+                std::cerr << "Error: --checkpoint-interval option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--resume") {
+            resume = true;
+        } else if (arg == "--shard") {
+            std::string value = i + 1 < argc ? argv[++i] : "";
+            size_t slash = value.find('/');
+            if (slash == std::string::npos) {
+                std::cerr << "Error: --shard option requires <k>/<N>\n";
+                return 1;
+            }
+            shard_index = sizeOption(arg, value.substr(0, slash));
+            shard_count = sizeOption(arg, value.substr(slash + 1));
+            if (shard_count == 0 || shard_index >= shard_count) {
+                std::cerr << "Error: --shard " << value << " is not a shard of " << shard_count << "\n";
+                return 1;
+            }
+        } else if (arg == "--shard-rows" || arg == "--merge-shards") {
+            if (i + 1 < argc) {
+                (arg == "--shard-rows" ? shard_rows : merge_shards) = sizeOption(arg, argv[++i]);
+            } else {
+                std::cerr << "Error: " << arg << " option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--max-automaton-memory") {
+            if (i + 1 < argc) {
+                ctl::AutomatonBudget::instance().setLimit(sizeOption(arg, argv[++i]) * 1024 * 1024);
+            } else {
+                std::cerr << "Error: --max-automaton-memory option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--progress") {
+            if (i + 1 < argc) {
+                progress_file = argv[++i];
+            } else {
+                std::cerr << "Error: --progress option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--progress-interval") {
+            if (i + 1 < argc) {
+                progress_interval_s = numberOption(arg, argv[++i]);
+            } else {
+                std::cerr << "Error: --progress-interval option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--cost-model") {
+            if (i + 1 < argc) {
+                cost_samples = argv[++i];
+            } else {
+                std::cerr << "Error: --cost-model option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--automaton-cache") {
+            if (i + 1 < argc) {
+                ctl::AutomatonCache::instance().setDirectory(argv[++i]);
+            } else {
+                std::cerr << "Error: --automaton-cache option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--cache-dir") {
+            if (i + 1 < argc) {
+                cache_dir = argv[++i];
+            } else {
+                std::cerr << "Error: --cache-dir option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--manifest" || arg == "--json" || arg == "--trace" || arg == "--stats-json") {
+            if (i + 1 < argc) {
+                (arg == "--manifest" ? manifest
+                 : arg == "--json" ? json_results
+                 : arg == "--trace" ? trace_file
+                 : stats_json) = argv[++i];
+            } else {
+                std::cerr << "Error: " << arg << " option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--file-jobs") {
+            if (i + 1 < argc) {
+                file_jobs = std::max<size_t>(1, sizeOption(arg, argv[++i]));
+            } else {
+                std::cerr << "Error: --file-jobs option requires an argument\n";
+                return 1;
+            }
         } else if (arg == "-j" || arg == "--threads") {
             if (i + 1 < argc) {
-                num_threads = std::stoul(argv[++i]);
+                num_threads = sizeOption(arg, argv[++i]);
             } else {
                 std::cerr << "Error: -j option requires an argument\n";
                 return 1;
             }
+        } else if (arg == "--serve") {
+            if (i + 1 < argc) {
+                serve_socket = argv[++i];
+            } else {
+                std::cerr << "Error: --serve option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--scaling") {
+            if (i + 1 < argc) {
+                scaling_output = argv[++i];
+            } else {
+                std::cerr << "Error: --scaling option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--scaling-sizes" || arg == "--scaling-depths" || arg == "--scaling-threads") {
+            if (i + 1 < argc) {
+                auto& values = arg == "--scaling-sizes" ? scaling_config.class_sizes
+                             : arg == "--scaling-depths" ? scaling_config.depths
+                             : scaling_config.thread_counts;
+                values.clear();
+                for (const auto& item : splitList(argv[++i])) values.push_back(sizeOption(arg, item));
+            } else {
+                std::cerr << "Error: " << arg << " option requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "--scaling-engines") {
+            if (i + 1 < argc) {
+                scaling_config.engines.clear();
+                for (const auto& item : splitList(argv[++i])) {
+                    auto engine = ctl::ScalingEngineFromString(item);
+                    if (!engine) {
+                        std::cerr << "Error: Unknown scaling engine " << item << "\n";
+                        return 1;
+                    }
+                    scaling_config.engines.push_back(*engine);
+                }
+            } else {
+                std::cerr << "Error: --scaling-engines option requires an argument\n";
+                return 1;
+            }
         } else if (arg == "-v" || arg == "--verbose") {
             verbose = true;
+        } else if (arg == "--log-level") {
+            ctl::log::Level level;
+            if (i + 1 < argc && ctl::log::levelFromString(argv[++i], level)) {
+                ctl::log::setLevel(level);
+            } else {
+                std::cerr << "Error: --log-level requires one of error, warn, info, debug, trace\n";
+                return 1;
+            }
         } else if (arg[0] != '-') {
             input_file = arg;
         } else {
@@ -135,23 +454,107 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    if (input_file.empty()) {
+    // Options shared by every analyzer of the run, per input file or served
+    auto configureAnalyzer = [&](ctl::RefinementAnalyzer& analyzer, size_t threads,
+                                 const std::shared_ptr<ctl::RefinementCache>& cache) {
+        analyzer.setParallelAnalysis(use_parallel);
+        analyzer.setSyntacticRefinement(use_syntactic);
+        analyzer.setThreads(threads);
+        analyzer.setUseTransitiveOptimization(use_transitive);
+        analyzer.setUsePrefilter(use_prefilter);
+        analyzer.setPolarityClasses(use_polarity_classes);
+        analyzer.setClassSimulation(use_class_simulation);
+        analyzer.setSharedSubformulas(use_shared_subformulas);
+        analyzer.setCompositionalRefinement(use_compositional);
+        analyzer.setPipelinedAnalysis(use_pipeline);
+        analyzer.setPortfolio(use_portfolio);
+        analyzer.setJointPairs(use_joint_pairs);
+        analyzer.setWitnessPool(use_witness_pool);
+        analyzer.setDeduplication(use_dedup);
+        analyzer.setFullLanguageInclusion(use_language_inclusion);
+        analyzer.setEmptinessEngine(emptiness_engine);
+        analyzer.setCheckTimeout(std::chrono::milliseconds(static_cast<long long>(check_timeout_s * 1000)));
+
+        //analyzer.setUseCTLSAT(use_extern_sat);
+        //analyzer.createCTLSATInterface(sat_path);
+        if (use_extern_sat) {
+            analyzer.setExternalSATInterface(sat_interface, sat_path);
+            analyzer.setExternalSATLimits(sat_workers ? sat_workers : threads,
+                                          std::chrono::seconds(sat_timeout_s),
+                                          sat_memory_mb * 1024 * 1024);
+        }
+        if (cache) {
+            analyzer.setCache(cache);
+        }
+        analyzer.setVerbose(verbose);
+    };
+
+    if (!serve_socket.empty()) {
+        std::shared_ptr<ctl::RefinementCache> cache;
+        if (!cache_dir.empty()) {
+            cache = std::make_shared<ctl::RefinementCache>(cache_dir);
+        }
+        ctl::AnalysisServer server([&](ctl::RefinementAnalyzer& analyzer) {
+            configureAnalyzer(analyzer, num_threads, cache);
+        });
+        if (!input_file.empty()) {
+            std::cout << server.handle("load\t" + input_file) << "\n";
+        }
+        try {
+            std::cout << "Serving on " << serve_socket << std::endl;
+            server.serve(serve_socket);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!scaling_output.empty()) {
+        std::ofstream out(scaling_output);
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot open file for writing: " << scaling_output << "\n";
+            return 1;
+        }
+        scaling_config.sat_path = sat_path;
+        scaling_config.emptiness = emptiness_engine;
+        const size_t failed = ctl::ScalingBenchmark(scaling_config).run(out);
+        std::cout << "Scaling results written to: " << scaling_output << "\n";
+        return failed == 0 ? 0 : 1;
+    }
+
+    if (input_file.empty() && manifest.empty()) {
         std::cerr << "Error: No input file or folder specified\n";
         printUsage(argv[0]);
         return 1;
     }
     
     // Check if input exists
-    if (!ctl::pathExists(input_file)) {
+    if (!input_file.empty() && !ctl::pathExists(input_file)) {
         std::cerr << "Error: Input path does not exist: " << input_file << "\n";
         return 1;
     }
     
     // Determine if input is a file or folder
-    bool is_folder = ctl::isDirectory(input_file);
+    bool is_folder = !input_file.empty() && ctl::isDirectory(input_file);
     std::vector<std::string> input_files;
     
-    if (is_folder) {
+    if (!manifest.empty()) {
+        try {
+            ctl::MappedFile listing(manifest);
+            for (auto path : ctl::splitPropertyLines(listing.contents())) input_files.emplace_back(path);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        for (const auto& path : input_files) {
+            if (!ctl::pathExists(path)) {
+                std::cerr << "Error: Input path does not exist: " << path << "\n";
+                return 1;
+            }
+        }
+        if (!input_file.empty()) input_files.push_back(input_file);
+    } else if (is_folder) {
         input_files = ctl::getTextFilesInDirectory(input_file);
         if (input_files.empty()) {
             std::cerr << "Error: No .txt files found in folder: " << input_file << "\n";
@@ -164,6 +567,21 @@ int main(int argc, char* argv[]) {
         // Single file
         input_files.push_back(input_file);
     }
+
+    if (input_files.empty()) {
+        std::cerr << "Error: No input files listed in manifest: " << manifest << "\n";
+        return 1;
+    }
+
+    // Largest files first, so the long ones do not finish last on their own
+    std::vector<std::pair<off_t, std::string>> by_size;
+    for (auto& path : input_files) {
+        struct stat info;
+        by_size.emplace_back(stat(path.c_str(), &info) == 0 ? info.st_size : 0, std::move(path));
+    }
+    std::stable_sort(by_size.begin(), by_size.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    input_files.clear();
+    for (auto& entry : by_size) input_files.push_back(std::move(entry.second));
     
     // Handle output directory
     if (ctl::pathExists(output_dir)) {
@@ -184,11 +602,82 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    // CSV results file
+    // CSV results file, opened once and streamed to as each input finishes
     std::string csv_results = output_dir + "/analysis_results.csv";
-    bool first_file = true;
+    std::ofstream csv_out(csv_results);
+    if (!csv_out) {
+        std::cerr << "Error: Cannot open file for writing: " << csv_results << "\n";
+        return 1;
+    }
+    ctl::RefinementAnalyzer::writeCsvHeader(csv_out);
+    csv_out.flush();
+    std::ofstream json_out;
+    if (!json_results.empty()) {
+        json_out.open(json_results);
+        if (!json_out) {
+            std::cerr << "Error: Cannot open file for writing: " << json_results << "\n";
+            return 1;
+        }
+    }
+    std::ofstream stats_out;
+    if (!stats_json.empty()) {
+        stats_out.open(stats_json);
+        if (!stats_out) {
+            std::cerr << "Error: Cannot open file for writing: " << stats_json << "\n";
+            return 1;
+        }
+    }
+    std::ofstream trace_out;
+    if (!trace_file.empty()) {
+        trace_out.open(trace_file);
+        if (!trace_out) {
+            std::cerr << "Error: Cannot open file for writing: " << trace_file << "\n";
+            return 1;
+        }
+#ifndef CTL_TRACING
+        std::cout << "Warning: built without CTL_TRACING, the trace will be empty\n";
+#endif
+        ctl::trace::Tracer::instance().start();
+    }
+    std::mutex output_mutex;  // guards the result streams and stdout between concurrent inputs
+    std::mutex cost_samples_mutex;  // one input at a time reads or appends the cost samples
+    // Output files still being written, with the analyzers they read from
+    struct PendingOutputs {
+        std::shared_ptr<ctl::RefinementAnalyzer> analyzer;
+        std::future<void> written;
+    };
+    std::vector<PendingOutputs> pending_outputs;
+    std::mutex pending_outputs_mutex;
+    // Releases the analyzers whose outputs are written (all of them, waiting, if wait)
+    auto finishOutputs = [&](bool wait) {
+        std::vector<PendingOutputs> finished;
+        {
+            std::lock_guard<std::mutex> lock(pending_outputs_mutex);
+            auto ready = std::stable_partition(pending_outputs.begin(), pending_outputs.end(), [wait](auto& p) {
+                return !wait && p.written.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+            });
+            std::move(ready, pending_outputs.end(), std::back_inserter(finished));
+            pending_outputs.erase(ready, pending_outputs.end());
+        }
+        for (auto& outputs : finished) outputs.written.get();
+    };
+    file_jobs = std::min(file_jobs, input_files.size());
     
     try {
+        // One cache for every input file of this run
+        std::shared_ptr<ctl::RefinementCache> cache;
+        if (!cache_dir.empty()) {
+            cache = std::make_shared<ctl::RefinementCache>(cache_dir);
+        }
+        // Reports until the end of this scope, after the last input
+        std::unique_ptr<ctl::ProgressReporter> progress;
+        if (!progress_file.empty()) {
+            progress = std::make_unique<ctl::ProgressReporter>(
+                progress_file,
+                std::chrono::milliseconds(static_cast<long long>(std::max(progress_interval_s, 0.1) * 1000)),
+                cache.get());
+        }
+
         if (verbose) {
             std::cout << "RefinementBasedCTLReduction Tool\n";
             std::cout << "================================\n";
@@ -197,6 +686,10 @@ int main(int argc, char* argv[]) {
             std::cout << "Parallel analysis: " << (use_parallel ? "Enabled" : "Disabled") << "\n";
             std::cout << "Transitive optimization: " << (use_transitive ? "Enabled" : "Disabled") << "\n";
             std::cout << "Full language inclusion: " << (use_language_inclusion ? "Enabled" : "Disabled") << "\n";
+            if (use_language_inclusion) {
+                std::cout << "  Emptiness engine: " << ctl::EmptinessEngineToString(emptiness_engine) << "\n";
+            }
+            std::cout << "Guard decisions: " << (ctl::SMTContextManager::propositionalGuards() ? "BDD + SMT" : "SMT") << "\n";
             std::cout << "Using method: " << (use_extern_sat ? "External SAT" : "Automaton Based") << "\n";
             if (use_extern_sat){
                 std::cout << "  Interface: " << ctl::AvailableCTLSATInterfacesToString(sat_interface) << std::endl;
@@ -205,11 +698,15 @@ int main(int argc, char* argv[]) {
             if (use_parallel) {
                 std::cout << "Number of threads: " << num_threads << "\n";
             }
+            if (cache) {
+                std::cout << "Verdict cache: " << cache_dir << " (" << cache->size() << " entries)\n";
+            }
             std::cout << "\n";
         }
         
-        // Process each input file
-        for (const auto& current_input : input_files) {
+        // Process one input file; several may run at once with --file-jobs
+        const size_t threads_per_file = std::max<size_t>(1, num_threads / file_jobs);
+        auto processFile = [&](const std::string& current_input) {
             // Extract filename for reporting
             std::string input_name = current_input;
             size_t last_slash = input_name.find_last_of("/\\");
@@ -230,46 +727,25 @@ int main(int argc, char* argv[]) {
                 std::cout << "Loading properties from file...\n";
             }
             
-            auto analyzer = ctl::RefinementAnalyzer(current_input);
+            // Shared with the output writers, which may still run after this input
+            auto analyzer_owner = std::make_shared<ctl::RefinementAnalyzer>(current_input);
+            auto& analyzer = *analyzer_owner;
             
             // Configure analyzer
-            analyzer.setParallelAnalysis(use_parallel);
-            analyzer.setSyntacticRefinement(use_syntactic);
-            analyzer.setThreads(num_threads);
-            analyzer.setUseTransitiveOptimization(use_transitive);
-            analyzer.setFullLanguageInclusion(use_language_inclusion);
-
-            //analyzer.setUseCTLSAT(use_extern_sat);
-            //analyzer.createCTLSATInterface(sat_path);
-            if (use_extern_sat) {
-                analyzer.setExternalSATInterface(sat_interface, sat_path);
+            configureAnalyzer(analyzer, threads_per_file, cache);
+            if (!cost_samples.empty()) {
+                std::lock_guard<std::mutex> samples_lock(cost_samples_mutex);
+                const size_t fitted = analyzer.getCostModel().calibrate(cost_samples);
+                if (verbose && fitted > 0) {
+                    std::cout << "Cost model calibrated from " << fitted << " samples in " << cost_samples << "\n";
+                }
+                analyzer.getCostModel().setRecording(true);
             }
-            analyzer.setVerbose(verbose);
             if (verbose) {
                 //std::cout << "Loaded " << analyzer->getProperties().size() << " properties\n";
                 std::cout << "Starting analysis...\n";
             }
             
-            // Perform analysis
-            auto result = analyzer.analyze();
-            
-            auto end_time = std::chrono::high_resolution_clock::now();
-            auto total_duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-            
-            // Output results
-            if (verbose) {
-                std::cout << "Analysis completed in " << total_duration.count() << " ms\n";
-                std::cout << "\nResults:\n";
-                std::cout << "- Total properties: " << result.total_properties << "\n";
-                std::cout << "- Equivalence classes: " << result.equivalence_classes << "\n";
-                std::cout << "- Total refinements: " << result.total_refinements << "\n";
-                std::cout << "- Required properties: " << result.required_properties << "\n";
-                std::cout << "- Properties removed: " << (result.total_properties - result.required_properties) << "\n";
-                std::cout << "- Parsing time: " << result.parsing_time.count() << " ms\n";
-                std::cout << "- Equivalence time: " << result.equivalence_time.count() << " ms\n";
-                std::cout << "- Refinement time: " << result.refinement_time.count() << " ms\n";
-            }
-            
             // Create subdirectory for this file if processing multiple files
             std::string file_output_dir = output_dir;
             if (input_files.size() > 1) {
@@ -281,11 +757,10 @@ int main(int argc, char* argv[]) {
                 
                 // Create a single subfolder called FileSpecific
                 file_output_dir = output_dir + "/FileSpecific";
-                if (!ctl::pathExists(file_output_dir)) {
-                    if (!ctl::createDirectory(file_output_dir)) {
-                        std::cerr << "Warning: Failed to create subdirectory: " << file_output_dir << "\n";
-                        file_output_dir = output_dir;
-                    }
+                if (!ctl::isDirectory(file_output_dir) && !ctl::createDirectory(file_output_dir) &&
+                    !ctl::isDirectory(file_output_dir)) {
+                    std::cerr << "Warning: Failed to create subdirectory: " << file_output_dir << "\n";
+                    file_output_dir = output_dir;
                 }
 
                 file_output_dir = file_output_dir + "/" + folder_name;
@@ -299,29 +774,99 @@ int main(int argc, char* argv[]) {
                 
             }
             
-            // Write output files
-            std::string report_file = file_output_dir + "/refinement_analysis.txt";
-            analyzer.writeReport(report_file, result);
+            const std::chrono::seconds checkpoint_interval(checkpoint_interval_s ? checkpoint_interval_s : 300);
+            std::string shard_file;
+            if (shard_count > 0) {
+                shard_file = file_output_dir + "/shard-" + std::to_string(shard_index) + "-of-" +
+                             std::to_string(shard_count) + ".ckpt";
+                analyzer.setCheckpoint(shard_file, checkpoint_interval, resume);
+                analyzer.setShard(shard_index, shard_count, shard_rows);
+            } else if (checkpoint_interval_s > 0 || resume || merge_shards > 0) {
+                analyzer.setCheckpoint(file_output_dir + "/checkpoint.bin", checkpoint_interval, resume);
+            }
+            for (size_t k = 0; k < merge_shards; ++k) {
+                analyzer.addShardResults(file_output_dir + "/shard-" + std::to_string(k) + "-of-" +
+                                         std::to_string(merge_shards) + ".ckpt");
+            }
+
+            // Per-pair results are written as they are decided
+            analyzer.setResultStream(file_output_dir + "/info_per_property.csv");
+
+            // Perform analysis
+            auto result = analyzer.analyze();
+            if (cache) {
+                cache->flush();
+            }
+            if (!cost_samples.empty()) {
+                std::lock_guard<std::mutex> samples_lock(cost_samples_mutex);
+                try {
+                    analyzer.getCostModel().writeSamples(cost_samples);
+                } catch (const std::exception& e) {
+                    std::cerr << "Warning: " << e.what() << "\n";
+                }
+            }
+            if (shard_count > 0) {
+                // A worker's results are only complete once the coordinator merges them
+                std::lock_guard<std::mutex> output_lock(output_mutex);
+                std::cout << "Shard " << shard_index << "/" << shard_count << " of " << input_name
+                          << " saved to " << shard_file << "\n";
+                return;
+            }
             
-            analyzer.writeGraphs(file_output_dir);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto total_duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+            
+            // Output results
+            std::unique_lock<std::mutex> output_lock(output_mutex);
+            if (verbose) {
+                std::cout << "Analysis completed in " << total_duration.count() << " ms\n";
+                std::cout << "\nResults:\n";
+                std::cout << "- Total properties: " << result.total_properties << "\n";
+                std::cout << "- Duplicates merged: " << result.duplicate_properties << "\n";
+                std::cout << "- Equivalence classes: " << result.equivalence_classes << "\n";
+                std::cout << "- Total refinements: " << result.total_refinements << "\n";
+                if (result.unknown_refinements > 0) {
+                    std::cout << "- Undecided pairs (check timeout): " << result.unknown_refinements << "\n";
+                }
+                std::cout << "- Required properties: " << result.required_properties << "\n";
+                std::cout << "- Properties removed: " << (result.total_properties - result.required_properties) << "\n";
+                std::cout << "- Parsing time: " << result.parsing_time.count() << " ms\n";
+                std::cout << "- Equivalence time: " << result.equivalence_time.count() << " ms\n";
+                std::cout << "- Refinement time: " << result.refinement_time.count() << " ms\n";
+                std::cout << "- Guard SAT cache: " << result.guard_cache_hits << " hits, "
+                          << result.guard_cache_misses << " misses\n";
+                std::cout << "- Pre-filter: " << result.prefilter_refines << " refining, "
+                          << result.prefilter_rejected << " non-refining, "
+                          << result.prefilter_undecided << " undecided pairs\n";
+                if (cache) {
+                    std::cout << "- Verdict cache: " << cache->hits() << " hits, "
+                              << cache->misses() << " misses (cumulative)\n";
+                }
+            }
+            output_lock.unlock();
             
+            // Write output files in the background, next to the analysis of the
+            // remaining inputs; the run waits for them before it finishes
+            std::string report_file = file_output_dir + "/refinement_analysis.txt";
             std::string required_props_file = file_output_dir + "/required_properties.txt";
-            analyzer.writeRequiredProperties(required_props_file);
-
-            std::string false_props_file = file_output_dir + "/false_properties.txt";
-            analyzer.writeEmptyProperties(false_props_file);
-
-            std::string info_per_property_file = file_output_dir + "/info_per_property.csv";
-            analyzer.writeInfoPerProperty(info_per_property_file);
+            finishOutputs(false);
+            {
+                std::lock_guard<std::mutex> lock(pending_outputs_mutex);
+                pending_outputs.push_back({analyzer_owner, analyzer.writeOutputsAsync(file_output_dir, result)});
+            }
 
-            // Write CSV results
-            analyzer.writeCsvResults(
-                csv_results, 
-                input_name, 
-                result, 
-                total_duration.count(), 
-                !first_file);
-            first_file = false;
+            // Stream the CSV (and JSON) row
+            output_lock.lock();
+            ctl::RefinementAnalyzer::writeCsvRow(csv_out, input_name, result, total_duration.count());
+            csv_out.flush();
+            if (json_out.is_open()) {
+                ctl::RefinementAnalyzer::writeJsonRow(json_out, input_name, result, total_duration.count());
+                json_out.flush();
+            }
+            if (stats_out.is_open()) {
+                analyzer.writeStatisticsJsonRow(stats_out, input_name);
+                stats_out.flush();
+            }
             
             if (verbose) {
                 std::cout << "\nOutput files written to: " << file_output_dir << "\n";
@@ -336,12 +881,37 @@ int main(int argc, char* argv[]) {
                           << result.total_refinements << " refinements, "
                           << (result.total_properties - result.required_properties) << " removed\n";
             }
+        };
+
+        if (file_jobs <= 1) {
+            for (const auto& current_input : input_files) processFile(current_input);
+        } else {
+            // Inputs are queued largest first; idle workers steal the rest
+            ctl::WorkStealingPool pool(file_jobs);
+            for (const auto& current_input : input_files) {
+                pool.submit([&processFile, &current_input](size_t) { processFile(current_input); });
+            }
+            pool.wait();
+        }
+        finishOutputs(true);
+        if (trace_out.is_open()) {
+            ctl::trace::Tracer::instance().stop();
+            ctl::trace::Tracer::instance().writeChromeTrace(trace_out);
         }
       
         std::cout << "\n========================================\n";
         std::cout << "Analysis completed successfully!\n";
         std::cout << "Processed " << input_files.size() << " file(s)\n";
         std::cout << "CSV results written to: " << csv_results << "\n";
+        if (json_out.is_open()) {
+            std::cout << "JSON results written to: " << json_results << "\n";
+        }
+        if (stats_out.is_open()) {
+            std::cout << "Statistics written to: " << stats_json << "\n";
+        }
+        if (trace_out.is_open()) {
+            std::cout << "Trace written to: " << trace_file << "\n";
+        }
         std::cout << "========================================\n";
         
         return 0;
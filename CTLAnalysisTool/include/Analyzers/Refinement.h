@@ -7,12 +7,23 @@
 #include "memory_tracker.h"
 #include "types.h"
 #include "analyzerInterface.h"
+#include "refinement_prefilter.h"
+#include "statistics.h"
+#include "run_checkpoint.h"
+#include "cost_model.h"
+#include "bit_matrix.h"
+#include "witness_pool.h"
 
 #include <vector>
 #include <unordered_map>
 #include <thread>
 #include <future>
+#include <mutex>
 #include <functional>
+#include <ostream>
+#include <fstream>
+#include <span>
+#include <optional>
 
 
 
@@ -29,8 +40,12 @@ private:
     
     std::vector<std::vector<std::shared_ptr<CTLProperty>>> equivalence_classes_;
     std::vector<RefinementGraph> refinement_graphs_;
+    // Set once the graphs are final, by __updateRequiredProperties
+    std::vector<std::shared_ptr<CTLProperty>> required_properties_;
     std::vector<std::string> false_properties_strings_;
-    std::vector<size_t> false_properties_index_;
+    std::vector<size_t> false_properties_index_;  // their positions before pruning, ascending
+    std::vector<size_t> property_positions_;      // see getPropertyPositions()
+    size_t positions_assigned_ = 0;               // reanalyze() numbers added properties on
     
 
     size_t total_skipped_ = 0;
@@ -38,6 +53,25 @@ private:
     //bool use_parallel_analysis_ = true;
     bool use_syntactic_refinement_ = true;
     bool use_full_language_inclusion_ = false;  // New option for product-based approach
+    EmptinessEngine emptiness_engine_ = EmptinessEngine::FIXPOINT;
+    bool use_prefilter_ = true;
+    bool use_polarity_classes_ = false;
+    bool use_class_simulation_ = false;
+    bool use_shared_subformulas_ = false;
+    bool use_compositional_refinement_ = false;
+    bool use_pipeline_ = false;
+    bool use_portfolio_ = false;
+    bool use_joint_pairs_ = false;
+    bool use_witness_pool_ = false;
+    std::chrono::milliseconds check_timeout_{0};
+    std::unique_ptr<RunCheckpoint> checkpoint_;
+    bool resume_ = false;
+    size_t shard_index_ = 0;
+    size_t shard_count_ = 0;  // 0: not a shard worker
+    size_t shard_row_block_ = 64;
+    std::vector<std::string> shard_results_;
+    std::unique_ptr<RefinementPrefilter> prefilter_ = std::make_unique<RefinementPrefilter>();
+    std::unique_ptr<CostModel> cost_model_ = std::make_unique<CostModel>();
     //size_t threads_ = std::thread::hardware_concurrency();
     
 public:
@@ -60,13 +94,97 @@ public:
     //void setParallelAnalysis(bool enabled) { use_parallel_analysis_ = enabled; }
     void setSyntacticRefinement(bool enabled) { use_syntactic_refinement_ = enabled; }
     void setFullLanguageInclusion(bool enabled) { use_full_language_inclusion_ = enabled; }
+    // How full language inclusion decides emptiness of each product
+    void setEmptinessEngine(EmptinessEngine engine) { emptiness_engine_ = engine; }
+    // Decide trivial pairs from cached property signatures before building automata
+    void setUsePrefilter(bool enabled) { use_prefilter_ = enabled; }
+    const RefinementPrefilter& getPrefilter() const { return *prefilter_; }
+    // Split classes further: properties only go together through an atom
+    // they share with the same polarity (see refinement_prefilter.h), unless
+    // the one-state samples leave open that one of them is valid
+    void setPolarityClasses(bool enabled) { use_polarity_classes_ = enabled; }
+    // Answer the simulation checks of a class from one greatest fixpoint over
+    // all its automata (CTLAutomaton::simulationPreorder), computed by the
+    // first pair of the class that needs one, instead of one fixpoint per pair
+    void setClassSimulation(bool enabled) { use_class_simulation_ = enabled; }
+    // Give the automata of each class one SubformulaStore, so the moves of a
+    // subformula are expanded once per class and simulation verdicts between
+    // subformulas carry from one pair of the class to the next
+    void setSharedSubformulas(bool enabled) { use_shared_subformulas_ = enabled; }
+    // Split pairs on a top-level disjunction of the refining property and a
+    // top-level conjunction of the refined one (CTLProperty::refines)
+    void setCompositionalRefinement(bool enabled) { use_compositional_refinement_ = enabled; }
+    // Parallel analysis without barriers between the phases: each property is
+    // pruned (building its automaton) as its own task, and the pairs of a
+    // class go on the same pool as soon as every property that could join
+    // it is checked. Same classes and graphs as the phased analysis; not
+    // used with a checkpoint or an external SAT backend
+    void setPipelinedAnalysis(bool enabled) { use_pipeline_ = enabled; }
+    // Decide each pair by a race (portfolio.cpp): the syntactic rules and the
+    // class simulation first, then simulation, full language inclusion and
+    // the external SAT backend, if set, run at once and the first definitive
+    // verdict cancels the others. Pairs go one by one even with a backend set,
+    // and the verdicts are those of full inclusion
+    void setPortfolio(bool enabled) { use_portfolio_ = enabled; }
+    // Decide i->j and j->i in one task when neither is known yet, so both
+    // directions share their setup. With simulation the two fixpoints share
+    // the indexed moves and one entailment oracle (CTLAutomaton::MutualSimulation);
+    // other engines run the two checks back to back on warm per-thread caches
+    void setJointPairs(bool enabled) { use_joint_pairs_ = enabled; }
+    // Keep the models the emptiness games find for refuted pairs in a pool
+    // per class (witness_pool.h) and model check each later pair of the class
+    // against them before its own check. Only full inclusion (directly or in
+    // a portfolio) finds models; the external backends report verdicts only
+    void setWitnessPool(bool enabled) { use_witness_pool_ = enabled; }
     //void setThreads(size_t threads) { threads_ = threads; }
     void setUseTransitiveOptimization(bool use_transitive);
+    // Time budget of each refinement check, 0 for none. A check that runs out
+    // is cancelled and its pair becomes an unknown edge of the class graph
+    void setCheckTimeout(std::chrono::milliseconds timeout) { check_timeout_ = timeout; }
+    // Saves the progress of analyze() to path every interval (see run_checkpoint.h).
+    // With resume, a checkpoint an earlier run of the same input and mode left
+    // there is restored first, and its finished classes and pairs are skipped
+    void setCheckpoint(const std::string& path, std::chrono::seconds interval, bool resume);
+    const RunCheckpoint* getCheckpoint() const { return checkpoint_.get(); }
+    /**
+     * @brief Distributed runs over processes that share a filesystem (shard.cpp).
+     * A worker set to shard index of count only analyzes its share of the
+     * work: whole classes, and blocks of row_block rows of larger classes,
+     * spread over the shards by estimated cost the same way on every worker.
+     * It needs a checkpoint, which receives its graphs and pair verdicts;
+     * its own graphs of other classes have no edges. The coordinator adds
+     * the workers' checkpoints with addShardResults, then analyze() restores
+     * them like a resume and checks only what no worker finished.
+     */
+    void setShard(size_t index, size_t count, size_t row_block = 64);
+    void addShardResults(const std::string& checkpoint_path) { shard_results_.push_back(checkpoint_path); }
+    // Estimated check times (cost_model.h) order the parallel analysis longest
+    // first. Calibrate it, or have it record the checks, before analyze()
+    CostModel& getCostModel() { return *cost_model_; }
+    const CostModel& getCostModel() const { return *cost_model_; }
 
     // Main analysis methods
     AnalysisResult analyze() override;
     void buildEquivalenceClasses();
     void analyzeRefinements();
+
+    // Incremental analysis: after a first analyze(), reanalyze() only checks the
+    // pairs involving added properties against the classes they touch, and
+    // rebuilds from known verdicts the classes a removal splits.
+    size_t addProperties(const std::vector<std::string>& property_strings);
+    // Properties already built, e.g. with their automata
+    void addProperties(const std::vector<std::shared_ptr<CTLProperty>>& properties);
+    bool removeProperty(const std::string& formula);
+    AnalysisResult reanalyze();
+    // One query with the checks, caches and options of the analysis; the
+    // properties need not belong to the suite (see analysis_server.h)
+    bool isSatisfiable(const CTLProperty& property) const { return !__isPropertyEmpty(property); }
+    PropertyResult checkPair(const CTLProperty& refining, const CTLProperty& refined) const {
+        return checkRefinement(refining, refined);
+    }
+    // Drops what the analysis keeps by the address of a queried property,
+    // before it is destroyed and the address is reused
+    void forgetQuery(const CTLProperty& property) { prefilter_->forget(property); }
     
     // Memory management
     static void clearGlobalCaches();
@@ -74,6 +192,9 @@ public:
     
     // Getters
     const std::vector<std::shared_ptr<CTLProperty>>& getProperties() const { return properties_; }
+    // Position of each of getProperties() before the unsatisfiable ones were
+    // pruned (after deduplication); empty until analyze() prunes
+    const std::vector<size_t>& getPropertyPositions() const { return property_positions_; }
     const std::vector<std::vector<std::shared_ptr<CTLProperty>>>& getEquivalenceClasses() const { 
         return equivalence_classes_; 
     }
@@ -85,28 +206,149 @@ public:
     void writeRequiredProperties(const std::string& filename) const;
     void writeEmptyProperties(const std::string& filename) const;
     void writeInfoPerProperty(const std::string& filename) const;
+    /**
+     * @brief Writes the report, the graphs and the required, false and
+     * duplicate properties into output_directory as parallel tasks, the
+     * graphs spread over several of them.
+     *
+     * Returns at once, so the caller can go on with other work; the future
+     * rethrows the first failure. The analyzer must stay alive and unchanged
+     * until it is ready.
+     */
+    std::future<void> writeOutputsAsync(const std::string& output_directory, const AnalysisResult& result) const;
+    /**
+     * @brief Streams every per-pair result to the given CSV as soon as it is
+     * decided (same columns as writeInfoPerProperty) instead of keeping all
+     * n² of them in memory until the analysis ends.
+     */
+    void setResultStream(const std::string& filename);
     void writeCsvResults(const std::string& csv_path, 
                         const std::string& input_name,
                         const AnalysisResult& result,
                         long long total_time_ms,
                         bool append = false) const;
+    // The same row on an open stream, so one output can collect many inputs
+    static void writeCsvHeader(std::ostream& out);
+    static void writeCsvRow(std::ostream& out, const std::string& input_name,
+                            const AnalysisResult& result, long long total_time_ms);
+    // One JSON object per line with the fields of the CSV row
+    static void writeJsonRow(std::ostream& out, const std::string& input_name,
+                             const AnalysisResult& result, long long total_time_ms);
     // Statistics
-    std::vector<std::shared_ptr<CTLProperty>> getRequiredProperties() const;
+    // One per component of mutually refining properties that nothing outside
+    // it refines; computed when analyze() or reanalyze() finishes
+    const std::vector<std::shared_ptr<CTLProperty>>& getRequiredProperties() const { return required_properties_; }
+    // Result counts, plus the hot-path counters (see statistics.h) of the
+    // last analyze() or reanalyze()
     std::unordered_map<std::string, size_t> getStatistics() const;
+    const StatisticValues& getHotPathStatistics() const { return hot_path_statistics_; }
+    // One JSON object per line with the hot-path counters
+    void writeStatisticsJsonRow(std::ostream& out, const std::string& input_name) const;
     TransitiveOptimizationStats getTransitiveOptimizationStats() const;
     
 private:
     // Helper methods
     void _analyzeRefinementClassSerial(size_t class_index, bool use_transitive = true);
+    void __updateRequiredProperties();
     void analyzeRefinementClassParallel();
     void analyzeRefinementsParallelOptimized();
+    // Prunes, groups and refines in one task graph (setPipelinedAnalysis)
+    void __analyzePipelined();
+    // The pair tasks of one class on the pool, with the transitive closure
+    // they share; on_done runs after the last of them, if the class has pairs
+    struct PairSchedule;
+    std::unique_ptr<PairSchedule> __schedulePairs(WorkStealingPool& pool,
+                                                  const std::vector<std::shared_ptr<CTLProperty>>& class_properties,
+                                                  const std::vector<double>& row_costs,
+                                                  std::function<void()> on_done);
+    // The graph of a class whose scheduled pairs are all done
+    RefinementGraph __scheduledGraph(const std::vector<std::shared_ptr<CTLProperty>>& class_properties,
+                                     PairSchedule& schedule, size_t class_index);
+    // Estimated cost of a class, and of each of its rows into row_costs
+    double __classCost(const std::vector<std::shared_ptr<CTLProperty>>& class_properties,
+                       std::vector<double>& row_costs) const;
+    // External SAT: submit each class to the backend as batches of queries
+    void analyzeRefinementsBatched();
+    RefinementGraph __analyzeClassBatch(const std::vector<std::shared_ptr<CTLProperty>>& class_properties);
 
 
-    void _checkAndRemoveUnsatisfiableProperties();
+    // pool: evaluates the SCC blocks of each property's automaton on it
+    void _checkAndRemoveUnsatisfiableProperties(WorkStealingPool* pool = nullptr);
     void _checkAndRemoveUnsatisfiablePropertiesParallel();
+    void _checkAndRemoveUnsatisfiablePropertiesBatch();
+    // Compacts properties_ to the entries not flagged, keeping their order
+    // and property_positions_, and records the flagged ones as unsatisfiable
+    void __removeProperties(const std::vector<char>& is_false);
     
-    // Helper method for refinement checking
-    PropertyResult checkRefinement(const CTLProperty& prop1, const CTLProperty& prop2) const;
+    // Classes of properties linked by shared atoms (see buildEquivalenceClasses),
+    // as indices into properties in order of their first member
+    std::vector<std::vector<size_t>> __groupByAtoms(const std::vector<std::shared_ptr<CTLProperty>>& properties,
+                                                    bool polarity_classes) const;
+    // One SubformulaStore for the members of a class
+    void __shareSubformulas(const std::vector<std::shared_ptr<CTLProperty>>& members) const;
+
+    // Builds the automaton of every property that takes part in a pair check,
+    // on threads_ threads, so the refinement phase only reads them
+    void __buildAutomata();
+
+    // The simulations of both directions of one pair on one index, set up
+    // by the first direction that needs one (setJointPairs)
+    struct PairSimulation {
+        const CTLProperty* first = nullptr;
+        const CTLProperty* second = nullptr;
+        std::shared_ptr<const CTLAutomaton> first_automaton = nullptr;  // kept resident meanwhile
+        std::shared_ptr<const CTLAutomaton> second_automaton = nullptr;
+        std::unique_ptr<CTLAutomaton::MutualSimulation> simulation = nullptr;
+    };
+    // Helper method for refinement checking; joint shares the simulation of
+    // the reverse direction
+    PropertyResult checkRefinement(const CTLProperty& prop1, const CTLProperty& prop2,
+                                   PairSimulation* joint = nullptr) const;
+    // Both directions: first refines second, then second refines first
+    std::pair<PropertyResult, PropertyResult> __checkBothDirections(const CTLProperty& first,
+                                                                    const CTLProperty& second) const;
+    // Whether refining, one of the pair, refines the other by simulation
+    bool __pairSimulation(PairSimulation& pair, const CTLProperty& refining) const;
+    // Satisfiability through the persistent cache, if one is set
+    bool __isPropertyEmpty(const CTLProperty& property, WorkStealingPool* pool = nullptr) const;
+    // Validity the same way, for the satisfiable properties of the pre-pass;
+    // a sampled counter-model of the prefilter settles it without automata
+    bool __isPropertyValid(const CTLProperty& property, WorkStealingPool* pool = nullptr) const;
+    // A pair settled by the satisfiability or validity already known of its
+    // sides: nothing refines an unsatisfiable property but one, a valid one
+    // is refined by everything and refines only valid ones
+    static std::optional<bool> __decideBySatisfiability(const CTLProperty& refining, const CTLProperty& refined);
+    std::string __refinementCacheMode() const;
+    // Verdict of the portfolio race for a pair (setPortfolio): UNSAT if
+    // refining refines refined, SAT if not, TIMEOUT if no engine decided it
+    // within the check timeout
+    SatVerdict __racePortfolio(const CTLProperty& refining, const CTLProperty& refined) const;
+    // Workers for the engines a check does not run itself, created on first use
+    WorkStealingPool& __portfolioPool(size_t helpers) const;
+    mutable std::mutex portfolio_pool_mutex_;
+    mutable std::unique_ptr<WorkStealingPool> portfolio_pool_;
+
+    // Simulation verdicts of one class, filled by the first pair that needs them
+    struct ClassSimulation {
+        std::vector<std::shared_ptr<CTLProperty>> members;
+        std::unordered_map<const CTLProperty*, size_t> index;
+        std::once_flag computed;
+        bool failed = false;  // too large or out of time: its pairs are checked one by one
+        BitMatrix preorder;   // see CTLAutomaton::simulationPreorder
+    };
+    // Whether refined's automaton simulates refining's, from the preorder of
+    // the class of both; none if they share no class or it was not computed
+    std::optional<bool> __classSimulation(const CTLProperty& refining, const CTLProperty& refined) const;
+    // Entry of a class for __classSimulation; the caller holds class_simulations_mutex_
+    void __registerClassSimulation(const std::vector<std::shared_ptr<CTLProperty>>& members) const;
+    mutable std::mutex class_simulations_mutex_;
+    mutable std::unordered_map<const CTLProperty*, std::shared_ptr<ClassSimulation>> class_simulations_;  // by member
+    // The witness pool of refining's class, none if it is in no class
+    std::shared_ptr<WitnessPool> __witnessPool(const CTLProperty& refining) const;
+    mutable std::mutex witness_pools_mutex_;
+    mutable std::unordered_map<const CTLProperty*, std::shared_ptr<WitnessPool>> witness_pools_;  // by member
+    // Visiting order for the pairs of a class, weakest property first (see refinement_analysis.cpp)
+    std::vector<size_t> __strengthOrder(const std::vector<std::shared_ptr<CTLProperty>>& class_properties) const;
     
     
     // Progress bar display
@@ -114,10 +356,19 @@ private:
     // Parallel execution helpers
     std::vector<std::future<RefinementGraph>> createAnalysisTasks();
     RefinementGraph _analyzeClassTask(const std::vector<std::shared_ptr<CTLProperty>>& class_properties);
-    RefinementGraph _analyzeClassTaskOptimized(const std::vector<std::shared_ptr<CTLProperty>>& class_properties);
+    // Per-pair results go to the stream if one is set, otherwise to result_per_property_
+    void __recordResults(std::span<const PropertyResult> results);
+    void __recordResult(const PropertyResult& result) { __recordResults({&result, 1}); }
+    void __writeResultRow(std::ostream& out, const PropertyResult& result) const;
+    std::unique_ptr<std::ofstream> result_stream_;
+    // Guards result_per_property_ and result_stream_ while class tasks run concurrently
+    std::mutex result_mutex_;
     
     // Transitive optimization methods
     void applyTransitiveOptimization(AnalysisResult& result);
+    // Accounts one class of n properties in transitive_stats_
+    void __recordTransitiveStats(size_t n, size_t skipped_pairs, size_t refuted_pairs, size_t condensed_pairs,
+                                 size_t condensed_properties);
     void updateGraphWithOptimization(RefinementGraph& graph, 
                                    const std::unordered_set<std::string>& eliminated_properties);
     
@@ -130,6 +381,47 @@ private:
     
     // Transitive optimization data
     TransitiveOptimizationStats transitive_stats_;
+    StatisticValues hot_path_statistics_{};
+
+    // Incremental analysis state
+    struct PropertyPair {
+        const CTLProperty* refining;
+        const CTLProperty* refined;
+        bool operator==(const PropertyPair& o) const { return refining == o.refining && refined == o.refined; }
+    };
+    struct PropertyPairHash {
+        size_t operator()(const PropertyPair& p) const {
+            return std::hash<const void*>{}(p.refining) ^ (std::hash<const void*>{}(p.refined) << 1);
+        }
+    };
+    std::unordered_map<PropertyPair, bool, PropertyPairHash> known_verdicts_;
+    std::vector<std::shared_ptr<CTLProperty>> pending_properties_;
+    bool analyzed_ = false;
+
+    void __recordVerdicts(const RefinementGraph& graph);
+    RefinementGraph __analyzeClassIncremental(const std::vector<std::shared_ptr<CTLProperty>>& class_properties,
+                                              size_t& checked_pairs, size_t& reused_pairs);
+    AnalysisResult __collectResult(std::chrono::high_resolution_clock::time_point start_time) const;
+
+    // Checkpointing (checkpoint.cpp)
+    uint64_t __checkpointFingerprint() const;
+    // Saved graph of every class a resumed run finished before, by class index
+    std::vector<std::optional<RefinementGraph>> __restoreFinishedClasses() const;
+    void __checkpointClass(const RefinementGraph& graph) const;
+    void __saveCheckpoint() const;
+
+    // Sharding (shard.cpp): rows [row_begin, row_end) of a class
+    struct ShardUnit {
+        size_t class_index;
+        size_t row_begin;
+        size_t row_end;
+    };
+    // The units of this shard; classes are all classes, in class order
+    std::vector<ShardUnit> __shardUnits(
+        const std::vector<std::vector<std::shared_ptr<CTLProperty>>>& classes) const;
+    // Checks every pair of the given row blocks, leaving the verdicts in the checkpoint
+    void __analyzeRowBlocks(const std::vector<std::vector<std::shared_ptr<CTLProperty>>>& classes,
+                            const std::vector<ShardUnit>& blocks);
 };
 
 // Utility functions
@@ -139,7 +431,7 @@ namespace analyzer_utils {
     std::vector<std::string> loadPropertiesFromFile(const std::string& filename);
     
     // Export functions
-    void exportToCSV(const AnalysisResult& result, const std::string& filename);
+    void exportToCSV(const RefinementAnalyzer& analyzer, const std::string& filename);
     void exportToJSON(const AnalysisResult& result, const std::string& filename);
     
     // Statistics functions
@@ -1,6 +1,9 @@
 #include "analyzerInterface.h"
 #include "property.h"
 #include "types.h"
+#include <fstream>
+#include <functional>
+#include <mutex>
 
 namespace ctl{
     class SATAnalyzer : public Analyzer {
@@ -12,6 +15,13 @@ namespace ctl{
         AnalysisResult analyze() override;
         PropertyResult checkSAT(const CTLProperty& property) const;
 
+        /**
+         * @brief Streams every per-property result to the given CSV as soon as it
+         * completes (same columns as writeInfoPerProperty) instead of keeping it
+         * in memory, so long sweeps use constant memory and leave partial results.
+         */
+        void setResultStream(const std::string& filename);
+
         void writeInfoPerProperty(const std::string& filename) const;
         void writeEmptyProperties(const std::string& filename) const;
         void writeCsvResults(const std::string& csv_path, 
@@ -20,6 +30,16 @@ namespace ctl{
                         long long total_time_ms,
                         bool append = false) const;
     private:
+        using ResultSink = std::function<void(const PropertyResult&)>;
+        // External backends: all cache misses submitted through one checkMany batch
+        void __checkSATBatch(const ResultSink& sink) const;
+        // Automaton backend: one task per property on a work-stealing pool
+        void __checkSATParallel(const ResultSink& sink) const;
+        void __writeResultRow(std::ostream& out, const PropertyResult& result) const;
+
+        std::unique_ptr<std::ofstream> result_stream_;
+        std::mutex result_mutex_;
+
         std::vector<std::string> false_properties_strings_;
         std::vector<size_t> false_properties_index_;
     };
@@ -10,6 +10,8 @@
 #include <cassert>
 #include <algorithm>
 #include <functional>
+#include <span>
+#include <mutex>
 #include "visitors.h"
 #include "formula.h"
 #include "formula_utils.h"
@@ -17,16 +19,24 @@
 #include "types.h"
 #include "SCCBlocks.h"
 #include "SMTInterface.h"
+#include "smt_context_manager.h"
 #include "game_graph.h"
+#include "bit_matrix.h"
+#include "arena.h"
+#include "subformula_store.h"
 
 #include "transitions.h"
 
 namespace ctl {
 
+class WorkStealingPool;
 
 
-
-
+// Once buildFromFormula returns the automaton is frozen: every derived
+// structure (state index, SCC blocks and their DAG) is final, so any number
+// of threads may share it without locks. The only state filled later are the
+// per-state moves, the complement and the self-simulation, each behind a
+// once_flag.
 class CTLAutomaton {
 public:
     CTLAutomaton() = default;
@@ -43,14 +53,50 @@ public:
     void buildFromFormula(const CTLFormula& formula, bool symbolic = false);
 
 
-    bool languageIncludes(const CTLAutomaton& other) const;
+    // L(this) ⊇ L(other), decided by the given emptiness engine
+    bool languageIncludes(const CTLAutomaton& other, EmptinessEngine engine = EmptinessEngine::FIXPOINT) const;
+    // Pair-product check: true proves L(this) ⊇ L(other), false may be spurious
     bool languageIncludesOF(const CTLAutomaton& other) const;
+    // Macro-state game on other x ¬this, states pruned by simulation, stops at
+    // the first finite counterexample tree (written to counterexample if given)
+    bool languageIncludesAntichain(const CTLAutomaton& other, std::string* counterexample = nullptr) const;
+    // The engine AUTO uses for languageIncludes(included) called on including
+    static EmptinessEngine chooseEmptinessEngine(const CTLAutomaton& including, const CTLAutomaton& included);
+    // SCC blocks with a least or greatest fixpoint, i.e. not simple
+    size_t numNonSimpleBlocks() const;
     bool simulates(const CTLAutomaton& other) const;
     bool isSimulatedBy(const CTLAutomaton& other) const;
+    // R(i, j) iff state j of other simulates state i of this, so L(i) ⊆ L(j)
+    BitMatrix simulationRelation(const CTLAutomaton& other) const;
+    // P(i, j) iff automata[j] simulates automata[i], every pair from one
+    // greatest fixpoint over the disjoint union of the automata
+    static BitMatrix simulationPreorder(std::span<const CTLAutomaton* const> automata);
+    /**
+     * @brief The simulations between two automata in both directions, each
+     * computed when first asked for. The moves of both automata are indexed
+     * once, by the first direction that needs a fixpoint, and one entailment
+     * oracle of the calling thread answers the queries of both; use it on
+     * one thread. A direction cancelled mid-fixpoint leaves the index usable
+     */
+    class MutualSimulation {
+    public:
+        MutualSimulation(const CTLAutomaton& a, const CTLAutomaton& b);
+        ~MutualSimulation();
+        // Whether b simulates a if forward, else whether a simulates b
+        bool simulated(bool forward);
+
+    private:
+        struct Index;
+        const CTLAutomaton& a_;
+        const CTLAutomaton& b_;
+        std::unique_ptr<Index> index_;
+    };
 
     void print() const;
     std::string toString() const;
-    bool isEmpty() const;
+    // With a pool, the symbolic pre-pass evaluates independent SCC blocks
+    // concurrently on it; it must not be called from one of the pool's tasks
+    bool isEmpty(WorkStealingPool* pool = nullptr) const;
     bool isState(std::string_view state_name) const {
         return v_states_.end() != std::find_if(v_states_.begin(), v_states_.end(),
                                        [state_name](const CTLStatePtr& s) {
@@ -67,12 +113,32 @@ public:
 
     std::string_view getStateOfFormula(const CTLFormula& f) const;
     bool isAccepting(const std::string_view state_name) const;
+
+    // Dense state layout, valid once the automaton is built. Ids are positions in
+    // the state vector; names are kept for printing and the string-keyed API.
+    size_t numStates() const { return v_states_.size(); }
+    StateId getStateId(std::string_view state_name) const;
+    std::string_view getStateName(StateId id) const { return v_states_[id]->name; }
+    StateId getInitialStateId() const { return initial_state_id_; }
+    std::span<const StateId> getSuccessors(StateId id) const {
+        return { succ_targets_.data() + succ_offsets_[id], succ_targets_.data() + succ_offsets_[id + 1] };
+    }
+    std::span<const CTLTransitionPtr> getTransitions(StateId id) const {
+        return { trans_flat_.data() + trans_offsets_[id], trans_flat_.data() + trans_offsets_[id + 1] };
+    }
+    bool isAccepting(StateId id) const {
+        return (accepting_bits_[id >> 6] >> (id & 63)) & 1u;
+    }
     
     std::string getFormulaString() const;
     CTLFormulaPtr getFormula() const;
     CTLFormulaPtr getNegatedFormula() const;
 
-    std::unordered_map<std::string_view, std::vector<Move>> getExpandedTransitions() const {throw std::runtime_error("getExpandedTransitions() not implemented yet"); }
+    // Moves of a state: one clause per transition of its ε-closure, guards collected
+    // in atoms and child obligations in next_states. Unsatisfiable guard combinations
+    // are pruned. Expanded on first use and kept for every later check this automaton
+    // takes part in; safe to call from several threads.
+    const std::vector<Move>& getExpandedTransitions(StateId id) const;
 
     std::string getRawFormula() const { return s_raw_formula_; }
     std::string getRawNegation() const { return "!(" + s_raw_formula_ + ")"; }
@@ -82,26 +148,49 @@ public:
         return std::make_unique<CTLAutomaton>(*this);
     }
 
-    CTLAutomatonPtr getComplement() const {
-        return std::make_unique<CTLAutomaton>(*getNegatedFormula());
-    }
+    // Automaton of the negated formula, built on first use and kept for every
+    // later inclusion check against this automaton; safe to call from several threads
+    const CTLAutomaton& getComplement() const;
+
+    // Share moves and simulation verdicts with the other automata using the
+    // store (null stops sharing); the complement uses it as well. Call it
+    // while no other thread reads the automaton, e.g. right after building
+    void useSubformulaStore(std::shared_ptr<SubformulaStore> store);
+    SubformulaStore* subformulaStore() const { return store_.get(); }
+    // Store id of the state's formula; only with a store
+    SubformulaStore::Id subformulaId(StateId id) const { return store_ids_[id]; }
 
     
     // Public wrapper for satisfiability checking (for OTF product construction)
     bool isSatisfiable(const std::unordered_set<std::string>& g, bool without_parsing = false) const { return __isSatisfiable(g, without_parsing); }
+    // Conjunction of interned guards, e.g. the atoms of a move
+    bool isSatisfiable(std::span<const GuardTable::Id> atoms) const;
+    // isSatisfiable without an automaton: the guard cache, the solver-free
+    // deciders, then the calling thread's solver
+    static bool guardsSatisfiable(const std::unordered_set<std::string>& g, bool without_parsing = false);
 
     bool verbose() const { return verbose_; }
+    // Bytes of states, transitions and clauses held in the arena
+    size_t arenaBytes() const { return arena_->bytesUsed(); }
     void setVerbose(bool v) { verbose_ = v; }
 
     // Build a symbolic parity game from the automaton
     SymbolicParityGame buildGameGraph() const;
 
+    // Same as !isEmpty(): decided by the emptiness game, no external solver
     bool checkCtlSatisfiability() const;
     
 private:
+    // Reads the SCC blocks and their order, see symbolic_evaluator.h
+    friend class SymbolicEvaluator;
+    // Saves and restores states, transitions and moves, see automaton_cache.h
+    friend class AutomatonCache;
+
     CTLFormulaPtr p_original_formula_;
     CTLFormulaPtr p_negated_formula_;
     std::string s_raw_formula_;
+    // Owns every state, transition and clause/literal array of this automaton
+    std::unique_ptr<Arena> arena_ = std::make_unique<Arena>();
     std::vector<CTLStatePtr> v_states_;
     std::vector<CTLStatePtr> v_removed_states_;
     std::string_view initial_state_;
@@ -109,15 +198,37 @@ private:
     std::unordered_map<std::string_view, std::vector<CTLTransitionPtr>> m_transitions_;
     std::unordered_map<std::string_view, BinaryOperator> m_state_operator_;
     bool verbose_ = false;
-    mutable std::unordered_map<std::string_view, std::vector<Move>> m_expanded_transitions_;
-    mutable std::unique_ptr<SCCBlocks> blocks_;
-    mutable std::unordered_set<std::string_view> s_accepting_states_;
-    mutable std::unordered_map<size_t, std::string_view> formula_hash_to_state_cache_;
-    mutable std::vector<std::unordered_set<int>> block_edges_;
-    mutable std::vector<int> topological_order_;
+    std::unique_ptr<SCCBlocks> blocks_;
+    std::unordered_set<std::string_view> s_accepting_states_;
+    std::unordered_map<size_t, std::string_view> formula_hash_to_state_cache_;
+    std::vector<std::unordered_set<int>> block_edges_;
+    std::vector<int> topological_order_;
+
+    // CSR successor/transition arrays and accepting bitset, see __buildStateIndex
+    std::unordered_map<std::string_view, StateId> state_ids_;
+    StateId initial_state_id_ = INVALID_STATE_ID;
+    std::vector<uint32_t> succ_offsets_;
+    std::vector<StateId> succ_targets_;
+    std::vector<uint32_t> trans_offsets_;
+    std::vector<CTLTransitionPtr> trans_flat_;
+    std::vector<uint64_t> accepting_bits_;
+
+    // Expanded moves by state id, each slot filled once, see getExpandedTransitions
+    mutable std::vector<std::vector<Move>> expanded_moves_;
+    mutable std::unique_ptr<std::once_flag[]> expanded_once_;
+    // ¬this, built once so its moves and simulation are shared as well, see getComplement
+    mutable std::shared_ptr<CTLAutomaton> complement_;
+    mutable std::once_flag complement_once_;
+    // simulationRelation(*this), for pruning macro-states, see __selfSimulation
+    mutable std::unique_ptr<BitMatrix> self_simulation_;
+    mutable std::once_flag self_simulation_once_;
+    // Class-level moves and verdicts, see useSubformulaStore
+    std::shared_ptr<SubformulaStore> store_;
+    std::vector<SubformulaStore::Id> store_ids_;                    // by state
+    std::unordered_map<SubformulaStore::Id, StateId> store_states_;  // state of each store id
     
-    // SMT interface for satisfiability checking
-    mutable std::unique_ptr<SMTInterface> smt_interface_;
+    // SMT interface for satisfiability checking, borrowed from the calling thread
+    SMTInterface& __smt() const { return SMTContextManager::guards(); }
     
     // handy shorthands for "no letter constraint" and directions
     std::string GTrue = "true";
@@ -137,10 +248,28 @@ private:
 
 private:
       void __buildFromFormula( bool symbolic);
-      void __decideBlockTypes() const;
+      // Preprocessed, interned formula and its negation
+      void __setFormula(const CTLFormula& formula);
+      // One state per closure formula, helpers of A(φ R ψ) states come later
+      void __createStates();
+      // Helper states q_ax = AX(q) and q_or = φ ∨ q_ax of the A(φ R ψ) state q
+      std::pair<CTLStatePtr, CTLStatePtr> __addReleaseHelpers(const CTLStatePtr& state);
+      // addTransition with a guard already checked for satisfiability
+      void __addTransition(std::string_view from, Guard guard, const std::vector<Clause>& clauses, bool is_dnf);
+      // State index, SCC blocks and their DAG of the states and transitions
+      void __finishBuild();
+      bool __languageIncludesFixpoint(const CTLAutomaton& other) const;
+      void __decideBlockTypes();
+      // Last build step: derives the SCC DAG and its topological order
+      void __freeze();
       
       std::string __handleProp (const std::string& proposition, bool symbolic);
       void __handleStatesAndTransitions(bool symbolic);
+      void __buildStateIndex();
+      std::vector<Move> __expandMoves(StateId id) const;
+      // __expandMoves through the store: published once per subformula
+      std::vector<Move> __sharedMoves(StateId id) const;
+      const BitMatrix& __selfSimulation() const;
       std::vector<std::vector<std::string_view>> __computeSCCs() const;
       bool __isSatisfiable (const std::string& g, bool without_parsing = false) const;
       bool __isSatisfiable(const std::unordered_set<std::string>& g, bool without_parsing = false) const ;
@@ -155,24 +284,6 @@ private:
       Guard createGuardFromString(const std::string& guard) const;
       void __clean();
   
-        // Symbolic parity game solver functions
-        WinningRegion symPre(const SymbolicParityGame& game, const WinningRegion& target_region) const;
-        Guard evaluateRule(const SymbolicGameEdge& edge, const WinningRegion& target_region) const;
-        Guard evaluateClause(const Clause& clause, const WinningRegion& target_region) const;
-        WinningRegion symbolicAttractor(const SymbolicParityGame& game, const WinningRegion& target, Player sigma) const;
-        WinningRegion symbolicTrap(const SymbolicParityGame& game, const WinningRegion& domain, Player sigma) const;
-        std::pair<WinningRegion, WinningRegion> symbolicSolveRecursive(const SymbolicParityGame& game) const;
-        
-        
-        // Helper functions for formula manipulation
-        Guard makeOr(const Guard& left, const Guard& right) const;
-        Guard makeAnd(const Guard& left, const Guard& right) const;
-        Guard makeTrue() const;
-        Guard makeFalse() const;
-        bool isEquivalentToTrue(const Guard& g) const;
-        bool isEquivalentToFalse(const Guard& g) const;
-        bool winningRegionsEqual(const WinningRegion& a, const WinningRegion& b) const;
-
         bool __isSatisfiableUnion(const std::unordered_set<std::string>& base, const std::unordered_set<std::string>& add) const;
         void __appendGuard(std::unordered_set<std::string>& base, const std::unordered_set<std::string>& add) const;
         
@@ -182,42 +293,9 @@ private:
                                      const CTLAutomaton& automaton_a, const CTLAutomaton& automaton_b) const;
         bool __areMovesCompatible(const Move& move_a, const Move& move_b) const;
         
-        // Product state hash function
-        struct ProductStateHash {
-            size_t operator()(const std::pair<std::string_view, std::string_view>& p) const {
-                return std::hash<std::string_view>{}(p.first) ^ 
-                       (std::hash<std::string_view>{}(p.second) << 1);
-            }
-        };
-        
-        void __computeReachableProductStates(
-            const std::pair<std::string_view, std::string_view>& initial_state,
-            const CTLAutomaton& automaton_a, const CTLAutomaton& automaton_b,
-            std::unordered_set<std::pair<std::string_view, std::string_view>, ProductStateHash>& reachable_states,
-            std::unordered_map<std::pair<std::string_view, std::string_view>,
-                              std::unordered_set<std::pair<std::string_view, std::string_view>, ProductStateHash>,
-                              ProductStateHash>& product_successors) const;
-        
-        std::vector<std::unordered_set<std::pair<std::string_view, std::string_view>, ProductStateHash>> 
-        __computeProductSCCs(
-            const std::unordered_set<std::pair<std::string_view, std::string_view>, ProductStateHash>& reachable_states,
-            const std::unordered_map<std::pair<std::string_view, std::string_view>,
-                                    std::unordered_set<std::pair<std::string_view, std::string_view>, ProductStateHash>,
-                                    ProductStateHash>& product_successors) const;
-        
-        bool __hasAcceptingCycle(
-            const std::unordered_set<std::pair<std::string_view, std::string_view>, ProductStateHash>& scc,
-            const CTLAutomaton& automaton_a, const CTLAutomaton& automaton_b,
-            const std::unordered_map<std::pair<std::string_view, std::string_view>,
-                                    std::unordered_set<std::pair<std::string_view, std::string_view>, ProductStateHash>,
-                                    ProductStateHash>& product_successors) const;
-        
-        
-
-        
 
-        std::vector<int>& __getTopologicalOrder() const;
-        std::vector<std::unordered_set<int>>& __getDAG() const;
+        const std::vector<int>& __getTopologicalOrder() const { return topological_order_; }
+        const std::vector<std::unordered_set<int>>& __getDAG() const { return block_edges_; }
         
 
 };
@@ -1,11 +1,53 @@
 
 
 #pragma once
+#include "ExternalCTLSAT/process_pool.h"
+#include "types.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 namespace ctl {
     class ExternalCTLSATInterface {
         public:
+            virtual ~ExternalCTLSATInterface() = default;
             void setVerbose(bool verbose) { verbose_ = verbose; }
 
+            // Bound the number of concurrent solver processes and the time of each query
+            void setWorkers(size_t workers) { process_pool_->setSize(workers); }
+            void setQueryTimeout(std::chrono::milliseconds timeout) { process_pool_->setTimeout(timeout); }
+            void setQueryMemoryLimit(size_t bytes) { process_pool_->setMemoryLimit(bytes); }
+            // Share one process pool between several interfaces
+            void setProcessPool(std::shared_ptr<SolverProcessPool> pool) { process_pool_ = std::move(pool); }
+            SolverProcessPool& processPool() const { return *process_pool_; }
+            // Classify one query, telling solver timeouts and failures apart from UNSAT.
+            // Safe to call concurrently: atom mappings are private to the calling thread.
+            virtual SatVerdict checkSatisfiable(const std::string& formula) const = 0;
+            // Verdict of the query formula1 & !formula2; UNSAT means formula1 refines formula2.
+            // Each side is translated to backend syntax once and the query is the
+            // combination of the two translations.
+            SatVerdict checkRefinement(const std::string& formula1, const std::string& formula2) const;
+            // Forget the cached translations and start a fresh atom mapping, once per run
+            void clearTranslations();
+            size_t cachedTranslations() const;
+            // Called once per query as soon as its verdict is known, possibly from
+            // several threads at once: (index in the batch, verdict, solver time)
+            using VerdictCallback = std::function<void(size_t, SatVerdict, std::chrono::milliseconds)>;
+            // Classify a whole batch of queries, verdicts in input order. Backends that
+            // accept several formulas per run override this; by default the queries are
+            // dispatched concurrently through the process pool.
+            virtual std::vector<SatVerdict> checkMany(const std::vector<std::string>& formulas,
+                                                      const VerdictCallback& on_verdict = nullptr) const;
+            // Batched checkRefinement over (refining, refined) pairs, dispatched like checkMany
+            std::vector<SatVerdict> refinesMany(
+                const std::vector<std::pair<std::string, std::string>>& pairs,
+                const VerdictCallback& on_verdict = nullptr) const;
             // Check if formula is satisfiable
             virtual bool isSatisfiable(const std::string& formula, bool with_clearing=false) const = 0;
 
@@ -16,7 +58,36 @@ namespace ctl {
             virtual bool equivalent(const std::string& formula1, const std::string& formula2) const = 0;
            
         protected:
+            // Backend syntax of formula under the interface's own atom mapping, which
+            // every translation extends; throws if the formula cannot be translated.
+            // Called with the translation lock held.
+            virtual std::string __translate(const std::string& formula) const = 0;
+            // Start the interface's atom mapping over
+            virtual void __resetMapping() const = 0;
+            // The query "(refining) & !(refined)" from two translations under one mapping
+            virtual std::string __refinementQuery(const std::string& refining, const std::string& refined) const = 0;
+            // Classify a query already in backend syntax; formula is its source, for messages
+            virtual SatVerdict __checkTranslated(const std::string& query, const std::string& formula) const = 0;
+
             bool verbose_ = false;
             std::string sat_path_;
+            std::shared_ptr<SolverProcessPool> process_pool_ = std::make_shared<SolverProcessPool>();
+
+        private:
+            struct Translation {
+                std::string text;
+                uint64_t generation = 0;  // of the mapping it was made under
+            };
+
+            // The refinement query in backend syntax, or nullopt if the formulas
+            // cannot be translated under one mapping
+            std::optional<std::string> __translatedQuery(const std::string& refining, const std::string& refined) const;
+            std::vector<SatVerdict> __dispatch(size_t count, const std::function<SatVerdict(size_t)>& check,
+                                               const VerdictCallback& on_verdict) const;
+
+            mutable std::mutex translation_mutex_;
+            // Translations of an older generation used atoms of a discarded mapping
+            mutable std::unordered_map<std::string, Translation> translations_;
+            mutable uint64_t translation_generation_ = 1;
     };
 }
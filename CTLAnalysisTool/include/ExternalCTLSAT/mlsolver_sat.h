@@ -14,6 +14,9 @@ class MLSolverInterface: public ExternalCTLSATInterface {
 public:
     explicit MLSolverInterface(const std::string& sat_path = "./extern/mlsolver-sat");
     
+    // Classify formula as SAT, UNSAT, TIMEOUT or ERROR
+    SatVerdict checkSatisfiable(const std::string& formula) const override;
+
     // Check if formula is satisfiable
     bool isSatisfiable(const std::string& formula, bool with_clearing=false) const override;
 
@@ -29,7 +32,15 @@ public:
     // Run CTL-SAT with given formula and return output
     std::string runMLSolver(const std::string& formula) const;
 
-    
+protected:
+    std::string __translate(const std::string& formula) const override;
+    void __resetMapping() const override;
+    std::string __refinementQuery(const std::string& refining, const std::string& refined) const override;
+    SatVerdict __checkTranslated(const std::string& query, const std::string& formula) const override;
+
+private:
+    // Shared by the translations of the refinement queries
+    mutable MLSolverParser::Mapping mapping_;
 };
 
 } // namespace ctl
\ No newline at end of file
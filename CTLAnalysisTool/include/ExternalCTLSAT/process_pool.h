@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Outcome of one external solver invocation.
+ */
+struct ProcessResult {
+    std::string output;
+    int exit_code = -1;
+    int term_signal = 0;  // signal that ended the solver, 0 if it exited normally
+    bool timed_out = false;
+};
+
+/**
+ * @brief Bounded, thread-safe launcher for external solver processes.
+ *
+ * Solvers are started directly with fork/exec (no intermediate shell) and
+ * their output is drained through large non-blocking reads. At most size()
+ * solver processes run at once; further callers block until a slot frees
+ * up, so one pool can be shared by every analyzer thread. A query that
+ * exceeds the timeout is killed and reported with timed_out set; a memory
+ * limit caps the address space of every solver process (RLIMIT_AS).
+ */
+class SolverProcessPool {
+public:
+    explicit SolverProcessPool(size_t size = std::thread::hardware_concurrency(),
+                               std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+    /**
+     * @brief Runs argv[0] with the given arguments and collects its stdout
+     * (and stderr when merge_stderr is set). Blocks while the pool is full.
+     * Throws std::runtime_error if the process cannot be started.
+     */
+    ProcessResult run(const std::vector<std::string>& argv, bool merge_stderr = false);
+
+    void setSize(size_t size);
+    size_t size() const;
+
+    // 0 disables the per-query timeout
+    void setTimeout(std::chrono::milliseconds timeout) { timeout_ms_.store(timeout.count()); }
+    std::chrono::milliseconds timeout() const { return std::chrono::milliseconds(timeout_ms_.load()); }
+
+    // 0 disables the per-query memory limit
+    void setMemoryLimit(size_t bytes) { memory_limit_bytes_.store(bytes); }
+    size_t memoryLimit() const { return memory_limit_bytes_.load(); }
+
+    size_t launched() const { return launched_.load(std::memory_order_relaxed); }
+    size_t timeouts() const { return timeouts_.load(std::memory_order_relaxed); }
+
+private:
+    void __acquire();
+    void __release();
+
+    mutable std::mutex mutex_;
+    std::condition_variable slot_free_;
+    size_t size_;
+    size_t active_ = 0;
+    std::atomic<long long> timeout_ms_;
+    std::atomic<size_t> memory_limit_bytes_{0};
+    std::atomic<size_t> launched_{0};
+    std::atomic<size_t> timeouts_{0};
+};
+
+} // namespace ctl
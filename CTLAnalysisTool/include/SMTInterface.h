@@ -7,6 +7,8 @@
 
 namespace ctl {
 
+class EntailmentSession;
+
 /**
  * @brief Abstract interface for SMT solver operations
  * 
@@ -40,6 +42,12 @@ public:
      */
     virtual std::unique_ptr<SMTInterface> clone() const = 0;
 
+    /**
+     * @brief Incremental entailment queries on this interface's solver
+     * (see entailment_session.h); the default answers each query with isSatisfiable()
+     */
+    virtual std::unique_ptr<EntailmentSession> openEntailmentSession() const;
+
 
      
      virtual void* createAndSimplify(const std::string& formula) const =0;
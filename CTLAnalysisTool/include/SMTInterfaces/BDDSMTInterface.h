@@ -0,0 +1,75 @@
+#ifndef BDDSMTINTERFACE_H
+#define BDDSMTINTERFACE_H
+#include "../SMTInterface.h"
+#include "../bdd.h"
+#include "../entailment_session.h"
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+namespace ctl {
+
+class CTLFormula;
+
+/**
+ * @brief SMT interface that decides propositional guards with BDDs
+ *
+ * Guards built only from atoms, true/false, !, &, | and -> are lowered to a
+ * BDD once and answered by a node comparison; every atom seen by one
+ * instance shares its variable order. Guards with arithmetic comparisons
+ * (or strings the CTL parser does not accept) go to the wrapped SMT solver.
+ * Like the solvers it wraps, an instance belongs to one thread.
+ */
+class BDDSMTInterface : public SMTInterface {
+public:
+    explicit BDDSMTInterface(std::unique_ptr<SMTInterface> fallback = createDefaultSMTInterface());
+    // Borrows fallback, which must outlive this instance and serve the same thread
+    explicit BDDSMTInterface(SMTInterface& fallback);
+    ~BDDSMTInterface() override = default;
+
+    bool isSatisfiable(const std::string& formula, bool without_parsing = false) const override;
+    bool isSatisfiable(const std::unordered_set<std::string>& formulas, bool without_parsing = false) const override;
+    bool isSatisfiable(void* formula) const override { return fallback_->isSatisfiable(formula); }
+
+    std::unique_ptr<SMTInterface> clone() const override;
+    // Entailment between guard sets is the wrapped solver's job
+    std::unique_ptr<EntailmentSession> openEntailmentSession() const override { return fallback_->openEntailmentSession(); }
+
+    void* createAndSimplify(const std::string& formula) const override { return fallback_->createAndSimplify(formula); }
+    std::string simplify(const std::string& formula) const override { return fallback_->simplify(formula); }
+    void* getFalse() const override { return fallback_->getFalse(); }
+    void* getTrue() const override { return fallback_->getTrue(); }
+    void* makeOr(void* left, void* right) const override { return fallback_->makeOr(left, right); }
+    void* makeAnd(void* left, void* right) const override { return fallback_->makeAnd(left, right); }
+
+    /**
+     * @brief Whether guard a implies guard b; nullopt if either is not propositional
+     */
+    std::optional<bool> entails(const std::string& a, const std::string& b) const;
+
+    /**
+     * @brief Whether two guards denote the same function; nullopt if either is not propositional
+     */
+    std::optional<bool> equivalent(const std::string& a, const std::string& b) const;
+
+    /**
+     * @brief BDD of a guard, or nullopt if it needs the SMT solver
+     */
+    std::optional<BddManager::Node> toBdd(const std::string& formula) const;
+
+    size_t bddQueries() const { return bdd_queries_; }
+    size_t fallbackQueries() const { return fallback_queries_; }
+
+private:
+    std::optional<BddManager::Node> __lower(const CTLFormula& formula) const;
+
+    std::unique_ptr<SMTInterface> owned_fallback_;
+    SMTInterface* fallback_;
+    mutable BddManager manager_;
+    mutable std::unordered_map<std::string, std::optional<BddManager::Node>> bdd_cache_;
+    mutable size_t bdd_queries_ = 0;
+    mutable size_t fallback_queries_ = 0;
+};
+
+} // namespace ctl
+#endif // BDDSMTINTERFACE_H
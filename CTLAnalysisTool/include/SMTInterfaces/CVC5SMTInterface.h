@@ -3,17 +3,22 @@
 #ifdef USE_CVC5
 #include "../SMTInterface.h"
 #include <cvc5/cvc5.h>
+#include <deque>
 #include <memory>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
 namespace ctl {
 
 /**
  * @brief CVC5-based implementation of the SMT interface
- * 
+ *
  * This class uses the CVC5 SMT solver to check formula satisfiability.
  * Each instance has its own CVC5 solver, making it thread-safe
- * when each thread uses its own instance.
+ * when each thread uses its own instance. Guards are lowered from their
+ * AST once per instance, and queries are checks under assumptions on the
+ * one incremental solver, which is never rebuilt.
  */
 class CVC5SMTInterface : public SMTInterface {
 public:
@@ -30,55 +35,53 @@ public:
 
     bool isSatisfiable(const std::string& formula, bool without_parsing = false) const override;
     bool isSatisfiable(const std::unordered_set<std::string>& formulas, bool without_parsing = false) const override;
-    
+    bool isSatisfiable(void* formula) const override;
+
     std::unique_ptr<SMTInterface> clone() const override;
-    std::string simplify(const std::string& formula) const override
-    [
-        // Implement simplification using CVC5
-        cvc5::Term term = parseToCVC5Term(formula);
-        cvc5::Term simplified = solver_->simplify(term);
-        return simplified.toString();
-    
-    ]
+    // Indicators asserted in a scope of this instance's solver, checked under assumptions
+    std::unique_ptr<EntailmentSession> openEntailmentSession() const override;
+    std::string simplify(const std::string& formula) const override;
+    void* createAndSimplify(const std::string& formula) const override;
 
-    void* createAndSimplify(const std::string& formula) const override {
-        cvc5::Term term = parseToCVC5Term(formula);
-        cvc5::Term simplified = solver_->simplify(term);
-        return new cvc5::Term(simplified);
-    }
-    bool isSatisfiable(void* formula) const override {
-        if (formula == nullptr) return true; // empty formula is satisfiable
-        cvc5::Term* term = reinterpret_cast<cvc5::Term*>(formula);
-        try {
-            solver_->push();
-            solver_->assertFormula(*term);
-            cvc5::Result result = solver_->checkSat();
-            solver_->pop();
-            return result.isSat();
-        } catch (const std::exception& e) {
-            try {
-                solver_->pop();
-            } catch (...) {
-                // Ignore errors during cleanup
-            }
-            throw std::runtime_error(std::string("CVC5 satisfiability check failed: ") + e.what());
-        }
-    }
+    // Terms handed out as void* point into handles_ and live as long as this instance
+    void* getFalse() const override { return __handle(solver_->mkFalse()); }
+    void* getTrue() const override { return __handle(solver_->mkTrue()); }
+    void* makeOr(void* left, void* right) const override;
+    void* makeAnd(void* left, void* right) const override;
 
     /**
-     * @brief Parse a string formula into a CVC5 term
-     * @param str The formula string
-     * @return A CVC5 term
+     * @brief The CVC5 solver owned by this instance
      */
-    cvc5::Term parseToCVC5Term(const std::string& str) const;
+    cvc5::Solver& getSolver() const { return *solver_; }
+
+    /**
+     * @brief CVC5 term for a guard/atom string, lowered once per instance and cached
+     */
+    const cvc5::Term& getTerm(const std::string& formula) const;
+
+    /**
+     * @brief checkSatAssuming() on the solver, bounded by timeout_ms if given
+     */
+    cvc5::Result checkAssuming(const std::vector<cvc5::Term>& assumptions,
+                               std::optional<unsigned> timeout_ms) const;
+
+private:
+    // checkAssuming() bounded by the calling thread's cancellation deadline;
+    // throws CheckCancelled when the deadline cut the query off
+    bool __checkSat(const std::vector<cvc5::Term>& assumptions) const;
+    void* __handle(cvc5::Term term) const;
 
     // Each instance has its own CVC5 solver
     // This ensures thread safety when each thread uses its own CVC5SMTInterface instance
     mutable std::unique_ptr<cvc5::Solver> solver_;
-    
-    // Optional: cache for parsed terms (per instance)
-    // Commented out for now to avoid potential issues, can be enabled if needed
-    // mutable std::unordered_map<std::string, cvc5::Term> term_cache_;
+    mutable bool timeout_set_ = false;  // solver_ carries a time limit from an earlier check
+
+    // Constants by sort and name (formula_utils::CVC5Symbols), shared by every term of solver_
+    mutable std::unordered_map<std::string, cvc5::Term> symbols_;
+    // Lowered terms by guard string (per instance, so per thread)
+    mutable std::unordered_map<std::string, cvc5::Term> term_cache_;
+    // Terms behind the void* handles; a deque keeps their addresses stable
+    mutable std::deque<cvc5::Term> handles_;
 };
 
 } // namespace ctl
@@ -2,6 +2,8 @@
 #define Z3SMTINTERFACE_H
 #ifdef USE_Z3
 #include "../SMTInterface.h"
+#include "../log.h"
+#include "../solverPool.h"
 #include <z3++.h>
 #include <memory>
 #include <unordered_map>
@@ -34,12 +36,14 @@ public:
     bool isSatisfiable(const std::unordered_set<std::string>& formulas, bool without_parsing = false) const override;
     
     std::unique_ptr<SMTInterface> clone() const override;
+    // Indicators on a solver leased from solverPool(), checked under assumptions
+    std::unique_ptr<EntailmentSession> openEntailmentSession() const override;
     std::string simplify(const std::string& formula) const override;
     void* createAndSimplify(const std::string& formula) const override {
         z3::expr expr = parseToZ3Expression(formula);
         Z3_ast a = expr.simplify();
-        std::cout << "Z3SMTInterface::createAndSimplify called with formula: " << formula 
-                  << " => simplified to: " << z3::to_expr(*ctx_, a) << "\n";
+        CTL_LOG(TRACE, false, "Z3SMTInterface::createAndSimplify called with formula: " << formula
+                              << " => simplified to: " << z3::to_expr(*ctx_, a));
         auto n = reinterpret_cast<void*>(a);
         if (n == nullptr){
             throw std::runtime_error("Z3 simplification returned null");
@@ -47,6 +51,25 @@ public:
         return n;
     }
     bool isSatisfiable(void* formula) const override;
+
+    /**
+     * @brief The Z3 context owned by this instance
+     */
+    z3::context& getContext() const { return *ctx_; }
+
+    /**
+     * @brief Further solvers on getContext(), for checks that need their own
+     * assertions (e.g. entailment oracles); leased and returned, not rebuilt
+     */
+    Z3SolverPool& solverPool() const { return *solver_pool_; }
+
+    /**
+     * @brief Z3 expression for a guard/atom string, lowered once per instance and cached
+     * (up to kMaxCachedExpressions, then the cache starts over, so the reference
+     * is only valid until the next call)
+     */
+    const z3::expr& getExpression(const std::string& formula) const;
+    static constexpr size_t kMaxCachedExpressions = size_t(1) << 16;
     void* getFalse() const override {
         Z3_ast false_expr = ctx_->bool_val(false);
         return reinterpret_cast<void*>(false_expr);
@@ -76,14 +99,21 @@ private:
      */
     z3::expr parseToZ3Expression(const std::string& str) const;
 
+    // solver_->check() bounded by the calling thread's cancellation deadline;
+    // throws CheckCancelled when the deadline cut the query off
+    bool __checkSat() const;
+    mutable bool deadline_set_ = false;  // solver_ carries a timeout from an earlier deadline
+
     // Each instance has its own Z3 context and solver
     // This ensures thread safety when each thread uses its own Z3SMTInterface instance
     std::unique_ptr<z3::context> ctx_;
     mutable std::unique_ptr<z3::solver> solver_;
+    // Declared after ctx_, so its solvers go before the context
+    std::unique_ptr<Z3SolverPool> solver_pool_;
     
-    // Optional: cache for parsed expressions (per instance)
-    // Commented out for now to avoid potential issues, can be enabled if needed
-    // mutable std::unordered_map<std::string, std::shared_ptr<z3::expr>> expr_cache_;
+    // Lowered expressions by guard string (per instance, so per thread).
+    // Declared after ctx_ so it is destroyed before the context.
+    mutable std::unordered_map<std::string, z3::expr> expr_cache_;
 };
 
 } // namespace ctl
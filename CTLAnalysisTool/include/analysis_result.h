@@ -12,17 +12,27 @@ struct AnalysisResult {
     size_t total_properties;
     size_t equivalence_classes;
     size_t total_refinements;
+    size_t unknown_refinements = 0;  // pairs left undecided by the per-check timeout
     size_t required_properties = 0;  // Properties with in-degree 0 (not refined by others)
-    std::vector<RefinementGraph> class_graphs;
-    std::vector<std::vector<std::shared_ptr<CTLProperty>>> equivalence_class_properties;
     std::chrono::milliseconds parsing_time;
     std::chrono::milliseconds equivalence_time;
+    std::chrono::milliseconds automaton_time{0};  // building the automata, before any pair is checked
     std::chrono::milliseconds refinement_time;
     std::chrono::milliseconds total_time;
     
     // Transitive optimization results
     size_t transitive_eliminated = 0;
     size_t false_properties = 0;
+    size_t duplicate_properties = 0;  // inputs merged into an equal earlier property
+
+    // Guard satisfiability cache activity during this analysis
+    size_t guard_cache_hits = 0;
+    size_t guard_cache_misses = 0;
+
+    // Refinement pairs decided by the signature pre-filter, without automata
+    size_t prefilter_refines = 0;
+    size_t prefilter_rejected = 0;
+    size_t prefilter_undecided = 0;
 
     size_t peak_memory_kb = 0;
     size_t refinement_memory_kb = 0;
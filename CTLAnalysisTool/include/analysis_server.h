@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Analyzers/Refinement.h"
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Long-lived analysis of a property suite that answers queries.
+ *
+ * Keeps one RefinementAnalyzer with its suite, class graphs and known
+ * verdicts resident, together with the most recently queried properties, so
+ * the automata, guard caches and solver contexts built for one query serve
+ * the next. Beyond its capacity the least recently queried property is
+ * dropped with its automaton; a load drops them all, together with the
+ * compositional verdicts of the earlier suites. The capacity does not bound
+ * memory: FormulaFactory and GuardTable never release what they interned
+ * (node addresses and guard ids key other caches), so they grow with the
+ * distinct formulas seen, and each solver thread keeps its own cache of
+ * lowered guards, up to Z3SMTInterface::kMaxCachedExpressions.
+ *
+ * Requests are single lines of tab-separated fields (formulas never contain
+ * a tab); each is answered by one JSON object on one line, with "ok" and the
+ * time taken in "micros":
+ *
+ *   load <file>             analyze the suite in a property file
+ *   suite <f1> <f2> ...     analyze the suite of the given formulas
+ *   sat <f>                 {"satisfiable"}
+ *   refines <f> <g>         {"refines"}: whether f refines g
+ *   insert <f>              add f to the suite and reanalyze (only the pairs
+ *                           of its class are checked): {"satisfiable",
+ *                           "refines", "refined_by", "equivalent"} list the
+ *                           members of its class, or {"duplicate_of"} if
+ *                           the suite already holds the formula
+ *   remove <f>              {"removed"}
+ *   stats                   suite size, classes and hot-path counters
+ *   shutdown                stops serve() after the answer
+ *
+ * Errors are answered with "ok": false and "error". handle() is not
+ * thread-safe; serve() takes one connection at a time and its requests in
+ * order, while each analysis runs on the analyzer's own threads.
+ */
+class AnalysisServer {
+public:
+    static constexpr size_t kDefaultQueryCapacity = 256;
+
+    // configure applies the tool's options to every analyzer the server creates
+    explicit AnalysisServer(std::function<void(RefinementAnalyzer&)> configure = {},
+                            size_t query_capacity = kDefaultQueryCapacity);
+
+    // The JSON answer to one request line, without the newline
+    std::string handle(const std::string& request);
+
+    // Serves clients on a Unix domain socket at path until a shutdown
+    // request. Throws std::runtime_error if the socket cannot be set up
+    void serve(const std::string& socket_path);
+
+private:
+    std::string __load(std::unique_ptr<RefinementAnalyzer> analyzer);
+    std::string __insert(const std::string& formula);
+    std::string __stats() const;
+    // The analyzer of the suite, an empty one until a suite is loaded
+    RefinementAnalyzer& __analyzer();
+    // The suite's property with the formula's canonical text, else the one
+    // an earlier query built, else a new one kept for later queries
+    std::shared_ptr<CTLProperty> __property(const std::string& formula);
+    const CTLProperty* __suiteMember(const std::string& canonical) const;
+    // Rebuilds members_ after the suite changed
+    void __indexSuite();
+    void __forgetQuery(const std::string& canonical);
+    // Drops the least recently queried properties beyond capacity, once no
+    // request holds them
+    void __trimQueries();
+
+    using Query = std::pair<std::string, std::shared_ptr<CTLProperty>>;  // canonical text, property
+
+    std::function<void(RefinementAnalyzer&)> configure_;
+    std::unique_ptr<RefinementAnalyzer> analyzer_;
+    std::unordered_map<std::string, std::shared_ptr<CTLProperty>> members_;  // the suite, by canonical text
+    size_t query_capacity_;
+    std::list<Query> queried_;  // most recently used first
+    std::unordered_map<std::string, std::list<Query>::iterator> queried_index_;  // of queried_
+    std::atomic<bool> stopping_{false};
+};
+
+} // namespace ctl
@@ -2,10 +2,13 @@
 #include "types.h"
 #include "analysis_result.h"
 #include "Factories/externalSatFactory.h"
+#include "refinement_cache.h"
 #include <vector>
 #include <memory>
 #include <thread>
+#include <chrono>
 #include <string>
+#include <string_view>
 
 namespace ctl{
     class Analyzer {
@@ -17,8 +20,23 @@ namespace ctl{
             void setThreads(size_t threads) { threads_ = threads; }
             void setExternalSATInterface(AvailableCTLSATInterfaces interface_type, const std::string& sat_path) {
                 external_sat_interface_set_ = true;
+                external_sat_interface_type_ = interface_type;
                 external_sat_interface_ = ExternalSatFactory::createExternalSATInterface(interface_type, sat_path);
             }
+            // Concurrency and per-query time/memory limits of the external SAT backend
+            void setExternalSATLimits(size_t workers, std::chrono::milliseconds timeout,
+                                      size_t memory_limit_bytes = 0) {
+                if (!external_sat_interface_) return;
+                external_sat_interface_->setWorkers(workers);
+                external_sat_interface_->setQueryTimeout(timeout);
+                external_sat_interface_->setQueryMemoryLimit(memory_limit_bytes);
+            }
+            // Persist verdicts in the given directory and reuse them across runs
+            void setCacheDirectory(const std::string& directory) {
+                cache_ = std::make_shared<RefinementCache>(directory);
+            }
+            void setCache(std::shared_ptr<RefinementCache> cache) { cache_ = std::move(cache); }
+            RefinementCache* getCache() const { return cache_.get(); }
             //return reference to pointer to external sat interface
             const ExternalCTLSATInterface* getExternalSATInterface() const {
                 if (!external_sat_interface_set_) {
@@ -37,29 +55,60 @@ namespace ctl{
             }
             bool isVerbose() const { return verbose_; }
 
+            // Merge properties with equal normalized formulas before analysis (on by default)
+            void setDeduplication(bool enabled) { deduplicate_ = enabled; }
+            // Every parsed input property in input order, and the analyzed property standing for each
+            const std::vector<std::shared_ptr<CTLProperty>>& getInputProperties() const { return input_properties_; }
+            const std::vector<std::shared_ptr<CTLProperty>>& getInputRepresentatives() const {
+                return input_representatives_;
+            }
+            // Per-pair (or per-property) results kept by the last analysis, empty when streamed
+            const std::vector<PropertyResult>& getPropertyResults() const { return result_per_property_; }
+            // CSV listing every input property with the input index of its representative
+            void writeDuplicateProperties(const std::string& filename) const;
 
 
-    protected:
 
-        void __initialize_properties(const std::vector<std::string>& property_strings)
-        {
-            properties_.reserve(property_strings.size());
-            for (const auto& prop_str : property_strings) {
-                try {
-                    properties_.push_back(CTLProperty::create(prop_str, verbose_));
-                } catch (const std::exception& e) {
-                    std::cerr << "Warning: Failed to parse property '" << prop_str 
-                              << "': " << e.what() << std::endl;
-                }
-            }
+    protected:
 
+        // Cache mode of satisfiability verdicts: which backend produced them
+        std::string __satisfiabilityCacheMode() const {
+            if (!external_sat_interface_set_) return "automaton";
+            return "extsat:" + AvailableCTLSATInterfacesToString(external_sat_interface_type_);
         }
 
+        void __initialize_properties(const std::vector<std::string>& property_strings);
+        // Maps the file and parses its properties, see splitPropertyLines
+        void __initialize_properties_from_file(const std::string& filename);
+        /**
+         * @brief Parses the given property texts on up to threads_ threads into
+         * pre-reserved slots, then appends the parsed ones to properties_ and
+         * reports parse failures, both in input order.
+         */
+        void __parse_properties(const std::vector<std::string_view>& texts);
+
+        /**
+         * @brief Keeps one property per normalized formula (toNNF, then
+         * normalizeToCore, compared by hash and structure). The inputs and
+         * their representatives are remembered so reports can still list every
+         * input property under its original index. Runs once per analyzer.
+         * @return number of properties merged into an earlier equal one
+         */
+        size_t __deduplicate_properties();
+        // Input index of the first input property p stands for, npos if unknown
+        size_t __inputIndex(const CTLProperty* property) const;
+
+        bool deduplicate_ = true;
+        std::vector<std::shared_ptr<CTLProperty>> input_properties_;
+        std::vector<std::shared_ptr<CTLProperty>> input_representatives_;
+
         bool use_parallel_analysis_ = true;
         bool external_sat_interface_set_ = false;
         bool verbose_ = false;
         size_t threads_ = std::thread::hardware_concurrency();
+        AvailableCTLSATInterfaces external_sat_interface_type_ = AvailableCTLSATInterfaces::NONE;
         std::unique_ptr<ExternalCTLSATInterface> external_sat_interface_;
+        std::shared_ptr<RefinementCache> cache_;
         std::vector<std::shared_ptr<CTLProperty>> properties_;
         std::vector<PropertyResult> result_per_property_;
 
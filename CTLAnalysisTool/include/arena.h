@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace ctl {
+
+/**
+ * @brief Monotonic arena: objects are bump-allocated from a few large blocks
+ * and all released together when the arena is destroyed.
+ *
+ * Block sizes double, so an arena holding n bytes makes O(log n) heap calls in
+ * total. Objects with a non-trivial destructor are chained and destroyed in
+ * reverse order of creation; trivially destructible arrays (literals, clause
+ * views) cost nothing on release. Pointers stay valid for the arena's
+ * lifetime. Not thread-safe: an automaton fills its arena while it is built
+ * and only reads it afterwards.
+ */
+class Arena {
+public:
+    explicit Arena(size_t first_block = 4096) : next_block_size_(first_block) {}
+    ~Arena() {
+        for (Finalizer* f = finalizers_; f; f = f->next) f->destroy(f->object);
+        while (blocks_) {
+            Block* next = blocks_->next;
+            std::free(blocks_);
+            blocks_ = next;
+        }
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        if constexpr (std::is_trivially_destructible_v<T>) {
+            return ::new (__allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        } else {
+            // The finalizer is linked only once T is constructed, so a throwing
+            // constructor leaves nothing to destroy
+            auto* f = static_cast<Finalizer*>(__allocate(sizeof(Finalizer), alignof(Finalizer)));
+            T* object = ::new (__allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            f->destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+            f->object = object;
+            f->next = finalizers_;
+            finalizers_ = f;
+            return object;
+        }
+    }
+
+    // Copy of [first, last) into arena storage
+    template <typename T, typename It>
+    std::span<T> copyArray(It first, It last) {
+        static_assert(std::is_trivially_destructible_v<T>, "Arena arrays hold trivially destructible values only");
+        const size_t n = static_cast<size_t>(std::distance(first, last));
+        if (n == 0) return {};
+        T* data = static_cast<T*>(__allocate(n * sizeof(T), alignof(T)));
+        std::uninitialized_copy(first, last, data);
+        return {data, n};
+    }
+
+    // Value-initialized array of n elements
+    template <typename T>
+    std::span<T> allocateArray(size_t n) {
+        static_assert(std::is_trivially_destructible_v<T>, "Arena arrays hold trivially destructible values only");
+        if (n == 0) return {};
+        T* data = static_cast<T*>(__allocate(n * sizeof(T), alignof(T)));
+        std::uninitialized_value_construct_n(data, n);
+        return {data, n};
+    }
+
+    // Bytes handed out so far, alignment padding included
+    size_t bytesUsed() const { return used_; }
+    size_t numBlocks() const { return num_blocks_; }
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+    struct Finalizer {
+        Finalizer* next;
+        void (*destroy)(void*);
+        void* object;
+    };
+
+    void* __allocate(size_t bytes, size_t align) {
+        size_t space = static_cast<size_t>(end_ - cursor_);
+        void* p = cursor_;
+        if (!cursor_ || !std::align(align, bytes, p, space)) {
+            __grow(bytes + align);
+            space = static_cast<size_t>(end_ - cursor_);
+            p = cursor_;
+            std::align(align, bytes, p, space);
+        }
+        char* next = static_cast<char*>(p) + bytes;
+        used_ += static_cast<size_t>(next - cursor_);
+        cursor_ = next;
+        return p;
+    }
+
+    void __grow(size_t at_least) {
+        size_t size = next_block_size_;
+        while (size < at_least) size *= 2;
+        next_block_size_ = size * 2;
+        auto* block = static_cast<Block*>(std::malloc(sizeof(Block) + size));
+        if (!block) throw std::bad_alloc();
+        block->next = blocks_;
+        block->size = size;
+        blocks_ = block;
+        ++num_blocks_;
+        cursor_ = reinterpret_cast<char*>(block + 1);
+        end_ = cursor_ + size;
+    }
+
+    Block* blocks_ = nullptr;
+    Finalizer* finalizers_ = nullptr;
+    char* cursor_ = nullptr;
+    char* end_ = nullptr;
+    size_t next_block_size_;
+    size_t used_ = 0;
+    size_t num_blocks_ = 0;
+};
+
+} // namespace ctl
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace ctl {
+
+class CTLProperty;
+
+/**
+ * @brief Process-wide memory budget for the automata cached by properties.
+ *
+ * Properties report each automaton they build together with its size; once
+ * the total exceeds the limit, the least recently used automata are released
+ * and rebuilt by their property on the next access. An automaton owns its
+ * complement and expanded moves, so those go with it. Callers that hold a
+ * CTLProperty::automatonHandle() keep an evicted automaton alive until they
+ * drop the handle. With the default limit of 0 nothing is tracked and
+ * automata live as long as their property.
+ */
+class AutomatonBudget {
+public:
+    static AutomatonBudget& instance();
+
+    // Limit in bytes, 0 for none. Lowering it evicts at the next admit()
+    void setLimit(size_t bytes) { limit_.store(bytes, std::memory_order_relaxed); }
+    size_t limit() const { return limit_.load(std::memory_order_relaxed); }
+    bool enabled() const { return limit() != 0; }
+
+    // Records a newly built automaton of property, then evicts others until
+    // the total fits. Never evicts the automaton just admitted.
+    void admit(const CTLProperty* property, size_t bytes);
+    // Marks the automaton of property as most recently used
+    void touch(const CTLProperty* property);
+    // The property dropped its automaton by itself
+    void forget(const CTLProperty* property);
+
+    size_t residentBytes() const;
+    size_t evictions() const { return evictions_.load(std::memory_order_relaxed); }
+
+private:
+    AutomatonBudget() = default;
+
+    struct Entry {
+        const CTLProperty* property;
+        size_t bytes;
+    };
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;  // most recently used at the front
+    std::unordered_map<const CTLProperty*, std::list<Entry>::iterator> index_;
+    size_t resident_ = 0;
+    std::atomic<size_t> limit_{0};
+    std::atomic<size_t> evictions_{0};
+};
+
+} // namespace ctl
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ctl {
+
+class CTLAutomaton;
+class CTLFormula;
+
+/**
+ * @brief Built automata saved across runs, one binary file per formula.
+ *
+ * A file is keyed by the hash of the preprocessed formula and holds what is
+ * costly to build: the state table (closure size and the A(φ R ψ) states
+ * that own helper states), the accepting bits, every transition in CSR
+ * order with its guard already checked for satisfiability and its clauses
+ * as (direction, state id) literals, and the moves expanded so far. Guard
+ * texts are stored once in a table and referenced by index. Loading maps
+ * the file, recomputes the closure (it owns the state formulas, which have
+ * no stable binary form) and fills the arena from the file with no solver
+ * call or DNF expansion; the state index and SCC blocks are rederived in
+ * linear time. The file also holds the formula text, so a hash collision or
+ * a file of an older format is ignored and the automaton rebuilt.
+ *
+ * Files are written to a temporary name and renamed, so concurrent runs
+ * sharing the directory never read a partial file. Moves are expanded
+ * lazily during a run; update() rewrites the file of an automaton that
+ * gained moves since it was saved or loaded.
+ */
+class AutomatonCache {
+public:
+    static AutomatonCache& instance();
+
+    // Directory of the cache files, created if missing; empty disables the cache
+    void setDirectory(std::string directory);
+    bool enabled() const;
+
+    // Automaton of formula: loaded if the cache is enabled and has it, else
+    // built, and then saved if the cache is enabled
+    std::shared_ptr<CTLAutomaton> obtain(const CTLFormula& formula, bool verbose = false);
+
+    // Automaton of formula saved by an earlier run, null if there is none
+    std::shared_ptr<CTLAutomaton> load(const CTLFormula& formula, bool verbose = false);
+    // Writes the file of a built automaton, with the moves expanded so far
+    void save(const CTLAutomaton& automaton);
+    // Saves the automaton, and its complement if built, again if it expanded
+    // moves since it was saved or loaded; call it while no check reads the
+    // automaton, e.g. after the analysis
+    void update(const CTLAutomaton& automaton);
+
+private:
+    AutomatonCache() = default;
+
+    std::string __path(size_t formula_hash) const;
+    void __write(const CTLAutomaton& automaton) const;  // throws std::runtime_error
+
+    mutable std::mutex mutex_;
+    std::string directory_;
+    // States whose moves are in the file, by automaton saved or loaded and
+    // not updated yet. An address reused by a later automaton only costs a
+    // skipped or an extra write
+    std::unordered_map<const CTLAutomaton*, size_t> saved_moves_;
+};
+
+} // namespace ctl
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Minimal reduced ordered BDD package for propositional guards.
+ *
+ * Nodes are hash-consed in a unique table, so two functions are equal iff
+ * their handles are, and a conjunction is unsatisfiable iff it is FALSE_NODE.
+ * Variables are ordered by first use; one manager therefore gives all guards
+ * it sees a single shared order. Not thread-safe: use one manager per thread.
+ */
+class BddManager {
+public:
+    using Node = uint32_t;
+    static constexpr Node FALSE_NODE = 0;
+    static constexpr Node TRUE_NODE = 1;
+
+    BddManager();
+
+    Node variable(const std::string& atom);
+    Node negate(Node a);
+    Node conj(Node a, Node b);
+    Node disj(Node a, Node b);
+    bool implies(Node a, Node b) { return conj(a, negate(b)) == FALSE_NODE; }
+
+    size_t numNodes() const { return nodes_.size(); }
+    size_t numVariables() const { return order_.size(); }
+
+private:
+    enum class Op : uint8_t { AND, OR, NOT };
+
+    struct BddNode {
+        uint32_t level; Node low; Node high;
+        bool operator==(const BddNode& o) const { return level == o.level && low == o.low && high == o.high; }
+    };
+    struct BddNodeHash {
+        size_t operator()(const BddNode& n) const {
+            return (size_t{n.level} * 0x9e3779b97f4a7c15ULL) ^ (size_t{n.low} << 21) ^ n.high;
+        }
+    };
+
+    Node __make(uint32_t level, Node low, Node high);
+    Node __apply(Op op, Node a, Node b);
+
+    static uint64_t __pack(uint32_t a, uint32_t b) { return (uint64_t{a} << 32) | b; }
+
+    std::vector<BddNode> nodes_;
+    std::unordered_map<std::string, uint32_t> order_;         // atom -> level
+    std::unordered_map<BddNode, Node, BddNodeHash> unique_;
+    std::unordered_map<uint64_t, Node> computed_[3];           // per Op: (a, b) -> result
+};
+
+} // namespace ctl
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Dense rows x cols boolean matrix packed into 64-bit words.
+ *
+ * Each row occupies a whole number of words, so rows can be scanned or
+ * combined word-at-a-time.
+ */
+class BitMatrix {
+public:
+    BitMatrix() = default;
+    BitMatrix(size_t rows, size_t cols, bool value = false)
+        : rows_(rows), cols_(cols), words_per_row_((cols + 63) / 64),
+          bits_(rows * words_per_row_, 0) {
+        if (value) setAll();
+    }
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+
+    bool test(size_t r, size_t c) const {
+        return (bits_[r * words_per_row_ + (c >> 6)] >> (c & 63)) & 1u;
+    }
+    void set(size_t r, size_t c) {
+        bits_[r * words_per_row_ + (c >> 6)] |= (uint64_t{1} << (c & 63));
+    }
+    void reset(size_t r, size_t c) {
+        bits_[r * words_per_row_ + (c >> 6)] &= ~(uint64_t{1} << (c & 63));
+    }
+
+    void setAll() {
+        for (size_t r = 0; r < rows_; ++r) {
+            uint64_t* row = rowData(r);
+            for (size_t w = 0; w < words_per_row_; ++w) row[w] = ~uint64_t{0};
+            // Keep the padding bits of the last word clear
+            if (cols_ & 63) row[words_per_row_ - 1] = (uint64_t{1} << (cols_ & 63)) - 1;
+        }
+    }
+
+    size_t count() const {
+        size_t n = 0;
+        for (uint64_t w : bits_) n += static_cast<size_t>(__builtin_popcountll(w));
+        return n;
+    }
+
+    /**
+     * @brief row(dst) |= row(src), word at a time.
+     * @return true if any bit of row dst changed
+     */
+    bool orRow(size_t dst, size_t src) {
+        uint64_t* d = rowData(dst);
+        const uint64_t* s = rowData(src);
+        uint64_t changed = 0;
+        for (size_t w = 0; w < words_per_row_; ++w) {
+            const uint64_t merged = d[w] | s[w];
+            changed |= merged ^ d[w];
+            d[w] = merged;
+        }
+        return changed != 0;
+    }
+
+    // True if row r of this matrix and row other_row of other share a set bit
+    bool rowsIntersect(size_t r, const BitMatrix& other, size_t other_row) const {
+        const uint64_t* a = rowData(r);
+        const uint64_t* b = other.rowData(other_row);
+        for (size_t w = 0; w < words_per_row_ && w < other.words_per_row_; ++w) {
+            if (a[w] & b[w]) return true;
+        }
+        return false;
+    }
+
+    // Calls f(c) for every set bit c of row r, in increasing column order
+    template <class F>
+    void forEachInRow(size_t r, F&& f) const {
+        const uint64_t* row = rowData(r);
+        for (size_t w = 0; w < words_per_row_; ++w) {
+            for (uint64_t bits = row[w]; bits; bits &= bits - 1) {
+                f(w * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+            }
+        }
+    }
+
+    size_t wordsPerRow() const { return words_per_row_; }
+    uint64_t* rowData(size_t r) { return bits_.data() + r * words_per_row_; }
+    const uint64_t* rowData(size_t r) const { return bits_.data() + r * words_per_row_; }
+
+private:
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    size_t words_per_row_ = 0;
+    std::vector<uint64_t> bits_;
+};
+
+/**
+ * @brief Square bit matrix that many threads may update concurrently.
+ *
+ * Rows start on their own 64-byte cache line, so threads working on
+ * different rows do not false-share. Bits are only ever set; set() and
+ * orRow() use atomic fetch_or on whole words, so concurrent closure
+ * updates never lose a bit.
+ */
+class AtomicBitMatrix {
+public:
+    static constexpr size_t kCacheLine = 64;
+    static constexpr size_t kWordsPerLine = kCacheLine / sizeof(uint64_t);
+
+    explicit AtomicBitMatrix(size_t n)
+        : n_(n), words_per_row_(((n + 63) / 64 + kWordsPerLine - 1) / kWordsPerLine * kWordsPerLine),
+          bits_(static_cast<std::atomic<uint64_t>*>(
+              ::operator new[](std::max<size_t>(1, n_ * words_per_row_) * sizeof(std::atomic<uint64_t>),
+                               std::align_val_t(kCacheLine)))) {
+        for (size_t k = 0; k < n_ * words_per_row_; ++k) new (&bits_[k]) std::atomic<uint64_t>(0);
+    }
+
+    size_t size() const { return n_; }
+
+    bool test(size_t r, size_t c, std::memory_order order = std::memory_order_acquire) const {
+        return (word(r, c).load(order) >> (c & 63)) & 1u;
+    }
+    void set(size_t r, size_t c) {
+        word(r, c).fetch_or(uint64_t{1} << (c & 63), std::memory_order_release);
+    }
+    // Sets the bit; true if it was set already, so one caller claims it
+    bool testAndSet(size_t r, size_t c) {
+        const uint64_t bit = uint64_t{1} << (c & 63);
+        return word(r, c).fetch_or(bit, std::memory_order_acq_rel) & bit;
+    }
+
+    /**
+     * @brief row(dst) |= row(src); words of src that are zero or already
+     * contained in dst are skipped without a read-modify-write.
+     */
+    void orRow(size_t dst, size_t src) {
+        std::atomic<uint64_t>* d = bits_.get() + dst * words_per_row_;
+        const std::atomic<uint64_t>* s = bits_.get() + src * words_per_row_;
+        for (size_t w = 0; w < words_per_row_; ++w) {
+            const uint64_t bits = s[w].load(std::memory_order_relaxed);
+            if (bits & ~d[w].load(std::memory_order_relaxed)) d[w].fetch_or(bits, std::memory_order_relaxed);
+        }
+    }
+
+    // True if row r of this matrix and row other_row of other share a set bit
+    bool rowsIntersect(size_t r, const AtomicBitMatrix& other, size_t other_row) const {
+        const std::atomic<uint64_t>* a = bits_.get() + r * words_per_row_;
+        const std::atomic<uint64_t>* b = other.bits_.get() + other_row * other.words_per_row_;
+        for (size_t w = 0; w < words_per_row_ && w < other.words_per_row_; ++w) {
+            if (a[w].load(std::memory_order_acquire) & b[w].load(std::memory_order_acquire)) return true;
+        }
+        return false;
+    }
+
+    // Calls f(c) for every bit of row r set at the time its word is read
+    template <class F>
+    void forEachInRow(size_t r, F&& f) const {
+        const std::atomic<uint64_t>* row = bits_.get() + r * words_per_row_;
+        for (size_t w = 0; w < words_per_row_; ++w) {
+            for (uint64_t bits = row[w].load(std::memory_order_acquire); bits; bits &= bits - 1) {
+                f(w * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+            }
+        }
+    }
+
+private:
+    struct AlignedDelete {
+        void operator()(std::atomic<uint64_t>* p) const {
+            ::operator delete[](p, std::align_val_t(kCacheLine));
+        }
+    };
+
+    std::atomic<uint64_t>& word(size_t r, size_t c) const { return bits_[r * words_per_row_ + (c >> 6)]; }
+
+    size_t n_;
+    size_t words_per_row_;
+    std::unique_ptr<std::atomic<uint64_t>[], AlignedDelete> bits_;
+};
+
+} // namespace ctl
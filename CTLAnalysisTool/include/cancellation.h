@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+
+namespace ctl {
+
+// Thrown at a checkpoint once the active token has expired
+class CheckCancelled : public std::runtime_error {
+public:
+    CheckCancelled() : std::runtime_error("check cancelled: time budget exceeded") {}
+};
+
+/**
+ * @brief Deadline and cancel flag of one refinement check.
+ *
+ * A token is handed to CTLProperty::refines, which installs it for the
+ * calling thread with a CancellationScope. The automaton algorithms, the SMT
+ * interfaces and the external solver pool then reach it through current()
+ * instead of an extra parameter on every call: simulation and game loops
+ * call checkpoint(), Z3 queries get the remaining time as their timeout and
+ * solver processes are killed at the deadline.
+ */
+class CancellationToken {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CancellationToken() = default;  // no deadline, cancelled only by cancel()
+    explicit CancellationToken(std::chrono::milliseconds budget) : deadline_(Clock::now() + budget) {}
+
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    bool cancelled() const {
+        return cancelled_.load(std::memory_order_relaxed) || (deadline_ && Clock::now() >= *deadline_);
+    }
+    // Time left before the deadline, none without one
+    std::optional<std::chrono::milliseconds> remaining() const {
+        if (!deadline_) return std::nullopt;
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(*deadline_ - Clock::now());
+        return std::max(left, std::chrono::milliseconds(0));
+    }
+
+    // The token installed for the calling thread, if any
+    static const CancellationToken* current() { return current_; }
+
+private:
+    friend class CancellationScope;
+    static inline thread_local const CancellationToken* current_ = nullptr;
+
+    std::optional<Clock::time_point> deadline_;
+    std::atomic<bool> cancelled_{false};
+};
+
+// Installs a token for the calling thread; scopes nest
+class CancellationScope {
+public:
+    explicit CancellationScope(const CancellationToken* token) : previous_(CancellationToken::current_) {
+        if (token) CancellationToken::current_ = token;
+    }
+    ~CancellationScope() { CancellationToken::current_ = previous_; }
+    CancellationScope(const CancellationScope&) = delete;
+    CancellationScope& operator=(const CancellationScope&) = delete;
+
+private:
+    const CancellationToken* previous_;
+};
+
+namespace cancellation {
+
+// Throws CheckCancelled if the calling thread's token has expired
+inline void checkpoint() {
+    const CancellationToken* token = CancellationToken::current();
+    if (token && token->cancelled()) throw CheckCancelled();
+}
+
+// Milliseconds left on the calling thread's token, none without a deadline
+inline std::optional<std::chrono::milliseconds> remaining() {
+    const CancellationToken* token = CancellationToken::current();
+    return token ? token->remaining() : std::nullopt;
+}
+
+} // namespace cancellation
+
+} // namespace ctl
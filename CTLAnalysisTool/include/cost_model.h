@@ -0,0 +1,110 @@
+#pragma once
+
+#include "property.h"
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Predicts how long a refinement check of one pair will take, from
+ * features that are cheap to read off the two properties.
+ *
+ * Features of a property: its closure size, the number of automaton states
+ * and DNF clauses (moves before expansion), and how many least fixpoint
+ * (EF, AF, EU, AU), greatest fixpoint (EG, AG, EW, AW, ER, AR) and next
+ * (EX, AX) operators it has. States and clauses are read from the automaton
+ * when it is already built and estimated from the closure size otherwise;
+ * features() never builds one.
+ *
+ * The model is linear in the logarithm of the check time,
+ *
+ *     log t(phi1, phi2) = w0 + sum_k a_k x_k(phi1) + sum_k b_k x_k(phi2),
+ *
+ * with size, states and clauses entering as logarithms. It is therefore a
+ * product of a refining and a refined factor, so the total cost of a class
+ * or a row is found in linear time. The default weights only rank pairs;
+ * calibrate() fits them, in microseconds, to the samples a previous run
+ * recorded with writeSamples().
+ *
+ * Estimates are thread-safe; record() may be called from several threads.
+ */
+class CostModel {
+public:
+    static constexpr size_t kFeatures = 6;
+
+    struct Features {
+        double size = 0;
+        double states = 0;
+        double moves = 0;
+        double least = 0;
+        double greatest = 0;
+        double next = 0;
+    };
+
+    CostModel();
+
+    // from_automaton: read states and clauses from an already built automaton
+    static Features features(const CTLProperty& property, bool from_automaton = true);
+
+    // Multiplicative share of one side of a pair in its estimated cost
+    double refiningFactor(const Features& refining) const;
+    double refinedFactor(const Features& refined) const;
+    // Estimated check time; in microseconds once calibrated
+    double estimate(const Features& refining, const Features& refined) const;
+    double estimate(const CTLProperty& refining, const CTLProperty& refined) const {
+        return estimate(features(refining), features(refined));
+    }
+
+    /**
+     * @brief Estimated cost of checking every ordered pair of the class, and
+     * of every row: row i holds the pairs (i, j), j != i.
+     */
+    double classCost(const std::vector<Features>& members, std::vector<double>* row_costs = nullptr) const;
+
+    /**
+     * @brief Fits the weights to the samples in a file written by
+     * writeSamples(), by ridge-regularized least squares on the log time.
+     * Malformed lines are skipped.
+     * @return number of samples used; with fewer than the number of weights
+     * the model is left unchanged and 0 is returned
+     */
+    size_t calibrate(const std::string& samples_path);
+    bool calibrated() const { return calibrated_; }
+
+    // Collect a sample per record() call; off by default
+    void setRecording(bool enabled) { recording_ = enabled; }
+    bool recording() const { return recording_; }
+    void record(const Features& refining, const Features& refined, std::chrono::microseconds taken);
+    size_t samples() const;
+    /**
+     * @brief Appends the recorded samples to a CSV file, writing the header if
+     * the file is new. Throws std::runtime_error if it cannot be written
+     */
+    void writeSamples(const std::string& path) const;
+
+private:
+    static constexpr size_t kWeights = 1 + 2 * kFeatures;
+    using Row = std::array<double, kWeights>;
+
+    static std::array<double, kFeatures> __terms(const Features& features);
+    static Row __row(const Features& refining, const Features& refined);
+
+    std::array<double, kWeights> weights_;
+    bool calibrated_ = false;
+    bool recording_ = false;
+
+    struct Sample {
+        Features refining;
+        Features refined;
+        double latency_us;
+    };
+    mutable std::mutex samples_mutex_;
+    std::vector<Sample> samples_;
+};
+
+} // namespace ctl
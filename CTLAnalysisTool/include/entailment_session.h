@@ -0,0 +1,48 @@
+#pragma once
+
+#include "guard_table.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+
+namespace ctl {
+
+class SMTInterface;
+
+/**
+ * @brief Incremental guard entailment on one solver, whatever the backend.
+ *
+ * Guards are asserted once, each behind a fresh indicator literal
+ * (indicator -> guard), and a query assumes the indicators it needs: the
+ * solver keeps what it learned between queries and nothing is retracted.
+ * An indicator that is not assumed constrains nothing, so the asserted
+ * implications never change another query's answer. SMTInterface hands
+ * out sessions (openEntailmentSession()); a session belongs to the thread
+ * of the interface that opened it and must end before that interface.
+ */
+class EntailmentSession {
+public:
+    using Literal = uint32_t;
+    enum class Verdict { SAT, UNSAT, UNKNOWN };
+
+    virtual ~EntailmentSession() = default;
+
+    // Indicator that, when assumed, makes the guard hold
+    virtual Literal assume(GuardTable::Id guard) = 0;
+    // Indicator that, when assumed, makes at least one of the guards fail
+    virtual Literal assumeNotAll(std::span<const GuardTable::Id> guards) = 0;
+    // Whether the assumed indicators can hold together; UNKNOWN if the
+    // solver gave up, e.g. when the timeout (milliseconds) ran out
+    virtual Verdict check(std::span<const Literal> assumptions, std::optional<unsigned> timeout_ms) = 0;
+};
+
+/**
+ * @brief Session for backends without incremental assumptions: every
+ * check() is one SMTInterface::isSatisfiable() over the guard strings.
+ * Correct on any interface, but each query starts from scratch.
+ */
+std::unique_ptr<EntailmentSession> openStringEntailmentSession(const SMTInterface& smt);
+
+} // namespace ctl
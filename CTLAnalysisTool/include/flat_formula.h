@@ -0,0 +1,71 @@
+#pragma once
+
+#include "formula.h"
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Flat, index-based copy of a formula: one node per distinct
+ * subformula, children stored before their parents.
+ *
+ * Nodes hold an opcode and child indices, so traversals are loops over an
+ * array with no virtual calls, no reference counting and no children()
+ * vectors. Because children precede parents, a single forward pass is a
+ * post-order walk and the root is always the last node. Each node keeps a
+ * pointer to the CTLFormula it was built from; for interned formulas that
+ * is the canonical node, which serves the existing pointer-based API
+ * (automaton states, equality, printing). The FlatFormula does not own
+ * those nodes: the source formula must outlive it.
+ */
+class FlatFormula {
+public:
+    using NodeId = uint32_t;
+    static constexpr NodeId NONE = std::numeric_limits<NodeId>::max();
+
+    struct Node {
+        FormulaType type;
+        uint8_t op = 0;           // BinaryOperator or TemporalOperator, 0 for other types
+        NodeId first = NONE;      // operand, left side or first temporal operand
+        NodeId second = NONE;     // right side or second temporal operand
+        const CTLFormula* source; // view of the same subformula as a CTLFormula
+
+        BinaryOperator binaryOp() const { return static_cast<BinaryOperator>(op); }
+        TemporalOperator temporalOp() const { return static_cast<TemporalOperator>(op); }
+        bool isLeaf() const { return first == NONE; }
+    };
+
+    FlatFormula() = default;
+    explicit FlatFormula(const CTLFormula& root);
+
+    std::span<const Node> nodes() const { return nodes_; }
+    size_t size() const { return nodes_.size(); }
+    bool empty() const { return nodes_.empty(); }
+    NodeId root() const { return static_cast<NodeId>(nodes_.size() - 1); }
+    const Node& operator[](NodeId id) const { return nodes_[id]; }
+
+    /**
+     * @brief Subformula closure in automaton state order: every node in
+     * post-order, each atom followed by its negation. Negated atoms of the
+     * formula itself are not repeated.
+     */
+    std::vector<const CTLFormula*> closure() const;
+    size_t closureSize() const;
+
+    /**
+     * @brief Variables of the atoms and comparisons, as AtomCollectorVisitor
+     * reports them. Each distinct leaf is examined once.
+     */
+    std::unordered_set<std::string> atomicPropositions() const;
+
+private:
+    std::vector<Node> nodes_;
+};
+
+} // namespace ctl
@@ -13,14 +13,30 @@ namespace ctl {
 
 
 // Abstract base class for CTL formulas
-class CTLFormula {
+class CTLFormula : public std::enable_shared_from_this<CTLFormula> {
 public:
     virtual ~CTLFormula() = default;
     virtual std::string toString() const = 0;
     virtual std::string toNuSMVString() const = 0;
-    virtual CTLFormulaPtr clone() const = 0;
-    virtual bool equals(const CTLFormula& other) const = 0;
-    virtual size_t hash() const = 0;
+
+    // Interned nodes (see FormulaFactory) are unique and immutable: clone() shares
+    // them, equals() is a pointer comparison and hash() is computed once.
+    CTLFormulaPtr clone() const {
+        if (interned_) return std::const_pointer_cast<CTLFormula>(shared_from_this());
+        return copy();
+    }
+    bool equals(const CTLFormula& other) const {
+        if (this == &other) return true;
+        if (interned_ && other.interned_) return false;
+        return structurallyEquals(other);
+    }
+    size_t hash() const { return interned_ ? hash_ : computeHash(); }
+    bool isInterned() const { return interned_; }
+
+    // Node-level implementations behind clone(), equals() and hash()
+    virtual CTLFormulaPtr copy() const = 0;
+    virtual bool structurallyEquals(const CTLFormula& other) const = 0;
+    virtual size_t computeHash() const = 0;
     
     // Visitor pattern for tree traversal
     virtual void accept(class CTLFormulaVisitor& visitor) const = 0;
@@ -34,8 +50,10 @@ public:
     virtual std::vector<CTLFormulaPtr> children() const = 0;
     virtual FormulaType getType() const = 0;
 
-    
-    
+private:
+    friend class FormulaFactory;
+    bool interned_ = false;
+    size_t hash_ = 0;
 };
 
 // Atomic proposition
@@ -47,12 +65,12 @@ public:
 
     std::string toString() const override { return "(" + proposition + ")"; }
     std::string toNuSMVString() const override { return "(" + proposition + ")"; }
-    CTLFormulaPtr clone() const override { 
+    CTLFormulaPtr copy() const override { 
         return std::make_shared<AtomicFormula>(proposition); 
     }
     
-    bool equals(const CTLFormula& other) const override;
-    size_t hash() const override;
+    bool structurallyEquals(const CTLFormula& other) const override;
+    size_t computeHash() const override;
     void accept(class CTLFormulaVisitor& visitor) const override;
     bool isAtomic() const override { return true; }
     FormulaType getType() const override { return FormulaType::ATOMIC; }
@@ -81,7 +99,7 @@ public:
         return variable + " " + operator_ + " " + value; 
     }
     
-    CTLFormulaPtr clone() const override {
+    CTLFormulaPtr copy() const override {
         return std::make_shared<ComparisonFormula>(variable, operator_, value);
     }
 
@@ -99,8 +117,8 @@ public:
 
 
     
-    bool equals(const CTLFormula& other) const override;
-    size_t hash() const override;
+    bool structurallyEquals(const CTLFormula& other) const override;
+    size_t computeHash() const override;
     void accept(class CTLFormulaVisitor& visitor) const override;
     bool isAtomic() const override { return true; }
     FormulaType getType() const override { return FormulaType::COMPARISON; }
@@ -116,12 +134,12 @@ public:
     
     std::string toString() const override { return value ? "true" : "false"; }
     std::string toNuSMVString() const override { return value ? "TRUE" : "FALSE"; }
-    CTLFormulaPtr clone() const override { 
+    CTLFormulaPtr copy() const override { 
         return std::make_shared<BooleanLiteral>(value); 
     }
     
-    bool equals(const CTLFormula& other) const override;
-    size_t hash() const override;
+    bool structurallyEquals(const CTLFormula& other) const override;
+    size_t computeHash() const override;
     void accept(class CTLFormulaVisitor& visitor) const override;
     bool isAtomic() const override { return true; }
     FormulaType getType() const override { return FormulaType::BOOLEAN_LITERAL; }
@@ -137,9 +155,9 @@ public:
     
     std::string toString() const override;
     std::string toNuSMVString() const override;
-    CTLFormulaPtr clone() const override;
-    bool equals(const CTLFormula& other) const override;
-    size_t hash() const override;
+    CTLFormulaPtr copy() const override;
+    bool structurallyEquals(const CTLFormula& other) const override;
+    size_t computeHash() const override;
     void accept(class CTLFormulaVisitor& visitor) const override;
     bool isUnary() const override { return true; }
     FormulaType getType() const override { return FormulaType::NEGATION; }
@@ -163,9 +181,9 @@ public:
     
     std::string toString() const override;
     std::string toNuSMVString() const override;
-    CTLFormulaPtr clone() const override;
-    bool equals(const CTLFormula& other) const override;
-    size_t hash() const override;
+    CTLFormulaPtr copy() const override;
+    bool structurallyEquals(const CTLFormula& other) const override;
+    size_t computeHash() const override;
     void accept(class CTLFormulaVisitor& visitor) const override;
     bool isBinary() const override { return true; }
     FormulaType getType() const override { return FormulaType::BINARY; }
@@ -199,9 +217,9 @@ public:
     
     std::string toString() const override;
     std::string toNuSMVString() const override;
-    CTLFormulaPtr clone() const override;
-    bool equals(const CTLFormula& other) const override;
-    size_t hash() const override;
+    CTLFormulaPtr copy() const override;
+    bool structurallyEquals(const CTLFormula& other) const override;
+    size_t computeHash() const override;
     void accept(class CTLFormulaVisitor& visitor) const override;
     bool isTemporal() const override { return true; }
     bool isBinary() const override { return second_operand != nullptr; }
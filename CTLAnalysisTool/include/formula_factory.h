@@ -0,0 +1,65 @@
+#pragma once
+
+#include "formula.h"
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ctl {
+
+/**
+ * @brief Process-wide hash-consing table for CTL formulas.
+ *
+ * intern() rebuilds a formula bottom-up so that every structurally distinct
+ * node exists exactly once. Interned nodes are immutable and shared by every
+ * property and automaton that contains them; equality between two interned
+ * nodes is a pointer comparison and each node's hash is computed once.
+ * Interned nodes are never released, so entries stay unique for the lifetime
+ * of the process.
+ */
+class FormulaFactory {
+public:
+    static FormulaFactory& instance();
+
+    /**
+     * @brief Returns the canonical node for the formula, interning its subformulas.
+     * Already interned formulas are returned unchanged.
+     */
+    CTLFormulaPtr intern(const CTLFormulaPtr& formula);
+
+    /**
+     * @brief Number of distinct nodes interned so far.
+     */
+    size_t size() const;
+
+private:
+    FormulaFactory() = default;
+
+    struct NodeKey {
+        FormulaType type;
+        int op = 0;
+        int lower = 0;
+        int upper = 0;
+        std::string payload = {};
+        const CTLFormula* first = nullptr;
+        const CTLFormula* second = nullptr;
+
+        bool operator==(const NodeKey& o) const {
+            return type == o.type && op == o.op && lower == o.lower && upper == o.upper &&
+                   first == o.first && second == o.second && payload == o.payload;
+        }
+    };
+
+    struct NodeKeyHash {
+        size_t operator()(const NodeKey& k) const noexcept;
+    };
+
+    CTLFormulaPtr __intern(const CTLFormulaPtr& formula);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<NodeKey, CTLFormulaPtr, NodeKeyHash> table_;
+};
+
+} // namespace ctl
@@ -30,18 +30,6 @@ namespace ctl {
 namespace formula_utils {
     
 
-    struct FormulaKey {
-    std::string s;
-    explicit FormulaKey(const CTLFormula& f) : s(f.toString()) {}
-    bool operator==(const FormulaKey& o) const { return s == o.s; }
-    };
-    
-    struct FormulaKeyHash {
-        std::size_t operator()(const FormulaKey& k) const noexcept {
-            return std::hash<std::string>{}(k.s);
-        }
-    };
-
     // Collect all atomic propositions from a formula
     std::unordered_set<std::string> collectAtomicPropositions(const CTLFormula& formula);
     
@@ -70,19 +58,47 @@ namespace formula_utils {
 
     CTLFormulaPtr Conjunction(const CTLFormulaPtr& lhs, const CTLFormulaPtr& rhs);
 
-    void collectClosureDFS(
-    const CTLFormula& f,
-    std::unordered_map<FormulaKey, const CTLFormula*, FormulaKeyHash>& seen,
-    std::vector<const CTLFormula*>& outTopo); 
 
 #ifdef USE_Z3
      z3::expr parseStringToZ3(const std::string& str, z3::context& ctx, bool as_bool=true);
      z3::expr parseStringToZ3(const std::string_view& str, z3::context& ctx, bool as_bool=true);
+
+    /**
+     * @brief Lowers a propositional formula AST directly into a Z3 expression.
+     * Atoms become Boolean constants, comparison operands integer terms.
+     * Throws std::runtime_error on temporal operators.
+     */
+     z3::expr lowerToZ3(const CTLFormula& formula, z3::context& ctx, bool as_bool=true);
+
+    /**
+     * @brief Guard string to Z3: parses once with the CTL parser and lowers the AST,
+     * falling back to parseStringToZ3 for strings the parser does not accept.
+     */
+     z3::expr guardToZ3(const std::string& guard, z3::context& ctx);
 #endif
 
 #ifdef USE_CVC5
-     cvc5::Term parseStringToCVC5(const std::string& str, cvc5::Solver& solver, bool as_bool=true);
-     cvc5::Term parseStringToCVC5(const std::string_view& str, cvc5::Solver& solver, bool as_bool=true);
+    /**
+     * @brief CVC5 constants by sort and name. Unlike a Z3 context, cvc5 makes
+     * a new constant on every mkConst(), so all terms of one solver share a
+     * table for "p" to denote the same atom in each of them.
+     */
+     using CVC5Symbols = std::unordered_map<std::string, cvc5::Term>;
+
+     cvc5::Term parseStringToCVC5(const std::string& str, cvc5::Solver& solver, CVC5Symbols& symbols, bool as_bool=true);
+     cvc5::Term parseStringToCVC5(const std::string_view& str, cvc5::Solver& solver, CVC5Symbols& symbols, bool as_bool=true);
+
+    /**
+     * @brief Lowers a propositional formula AST directly into a CVC5 term,
+     * like lowerToZ3. Throws std::runtime_error on temporal operators.
+     */
+     cvc5::Term lowerToCVC5(const CTLFormula& formula, cvc5::Solver& solver, CVC5Symbols& symbols, bool as_bool=true);
+
+    /**
+     * @brief Guard string to CVC5, like guardToZ3: lowers the parsed AST,
+     * falling back to parseStringToCVC5 for strings the parser does not accept.
+     */
+     cvc5::Term guardToCVC5(const std::string& guard, cvc5::Solver& solver, CVC5Symbols& symbols);
 #endif
     
    // // Simplify formula (remove double negations, etc.)
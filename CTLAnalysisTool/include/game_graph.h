@@ -4,6 +4,8 @@
 #include <unordered_set>
 #include <vector>
 #include <memory>
+#include <span>
+#include <cstdint>
 
 #include "types.h"
 #include "transitions.h"
@@ -19,64 +21,62 @@ namespace ctl {
 
     
 
-    // Symbolic game node representing an automaton state
+    // Symbolic game node representing an automaton state; its owner and
+    // priority are in the parallel arrays of the game
     struct SymbolicGameNode {
         std::string_view state_name;      // The automaton state name
-        Player owner;                      // Which player controls this node
-        int priority;                      // Parity priority (0 = even/good, 1 = odd/bad)
         CTLFormulaPtr formula;            // The formula this state represents
         BinaryOperator top_operator;      // The top-level operator (AND, OR, NONE)
         
         SymbolicGameNode() 
-            : state_name(""), owner(Player::Player1_Eloise), 
-              priority(0), formula(nullptr), top_operator(BinaryOperator::NONE) {}
+            : state_name(""), formula(nullptr), top_operator(BinaryOperator::NONE) {}
         
-        SymbolicGameNode(std::string_view name, Player p, int prio, 
-                        CTLFormulaPtr f, BinaryOperator op)
-            : state_name(name), owner(p), priority(prio), 
-              formula(f), top_operator(op) {}
+        SymbolicGameNode(std::string_view name, CTLFormulaPtr f, BinaryOperator op)
+            : state_name(name), formula(f), top_operator(op) {}
     };
 
 
-    // Symbolic game edge representing a transition
+    // Symbolic game edge representing a transition. The guard and the DNF
+    // clauses stay in the automaton's arena; the edge only points at them
     struct SymbolicGameEdge {
-        std::string_view source;          // Source state
-        Guard symbol;                      // Guard/constraint on this transition
-        std::vector<Clause> clauses;      // DNF: disjunction of conjunctions (φ₁ ∨ φ₂ ∨ ...)
+        StateId source = INVALID_STATE_ID;
+        const CTLTransition* transition = nullptr;
         
         SymbolicGameEdge() = default;
-        SymbolicGameEdge(std::string_view src, const Guard& symbol, const std::vector<Clause>& clauses)
-            : source(src), symbol(symbol), clauses(clauses) {}
+        SymbolicGameEdge(StateId src, const CTLTransition* transition)
+            : source(src), transition(transition) {}
         
-        // Get all target states reachable from this edge
-        std::unordered_set<std::string_view> getTargetStates() const {
-            std::unordered_set<std::string_view> targets;
-            for (const auto& conj : clauses) {
-                for (const auto& atom : conj.literals) {
-                    targets.insert(atom.qnext);
-                }
-            }
-            return targets;
-        }
+        const Guard& symbol() const { return transition->guard; }
+        // DNF: disjunction of conjunctions (φ₁ ∨ φ₂ ∨ ...)
+        std::span<const ClauseView> clauses() const { return transition->clauses; }
     };
 
     // The symbolic parity game structure
     // This represents an implicit game graph where:
-    // - Nodes are automaton states
+    // - Nodes are automaton states, indexed by StateId
     // - Edges are defined by transition rules (in DNF)
     // - Ownership determines who makes moves
     // - Priorities define the winning condition
+    // Edges are stored once, grouped by source, with CSR offsets forward
+    // and backward, so attractor sweeps walk contiguous arrays
     struct SymbolicParityGame {
-        // Map from state name to game node information
-        std::unordered_map<std::string_view, SymbolicGameNode> nodes;
-        
-        // Map from state name to its outgoing edges (transitions in DNF)
-        std::unordered_map<std::string_view, std::vector<SymbolicGameEdge>> out_edges;
-
-        std::unordered_map<std::string_view, std::vector<SymbolicGameEdge>> in_edges;
+        // Per state
+        std::vector<SymbolicGameNode> nodes;
+        std::vector<Player> owners;
+        std::vector<uint8_t> priorities;
+
+        // Out edges of s: edges[out_offsets[s], out_offsets[s + 1])
+        std::vector<SymbolicGameEdge> edges;
+        std::vector<uint32_t> out_offsets;
+        // Distinct targets of edge e: targets[target_offsets[e], target_offsets[e + 1])
+        std::vector<StateId> targets;
+        std::vector<uint32_t> target_offsets;
+        // Indices of the edges into s: in_edges[in_offsets[s], in_offsets[s + 1])
+        std::vector<uint32_t> in_edges;
+        std::vector<uint32_t> in_offsets;
         
         // Initial state of the game
-        std::string_view initial_state;
+        StateId initial_state = INVALID_STATE_ID;
         
         // The automaton that defines the game rules
         // This is not owned by the game, just a reference
@@ -91,24 +91,21 @@ namespace ctl {
         
         SymbolicParityGame() : automaton(nullptr) {}
         
+        size_t numStates() const { return nodes.size(); }
+        
         // Get the outgoing edges from a state
-        const std::vector<SymbolicGameEdge>& getEdgesFrom(std::string_view state) const {
-            static const std::vector<SymbolicGameEdge> empty;
-            auto it = out_edges.find(state);
-            if (it != out_edges.end()) {
-                return it->second;
-            }
-            return empty;
+        std::span<const SymbolicGameEdge> getEdgesFrom(StateId state) const {
+            return {edges.data() + out_offsets[state], edges.data() + out_offsets[state + 1]};
+        }
+        
+        // Get the indices into edges of the incoming edges to a state
+        std::span<const uint32_t> getEdgesTo(StateId state) const {
+            return {in_edges.data() + in_offsets[state], in_edges.data() + in_offsets[state + 1]};
         }
         
-        // Get the incoming edges to a state
-        const std::vector<SymbolicGameEdge>& getEdgesTo(std::string_view state) const {
-            static const std::vector<SymbolicGameEdge> empty;
-            auto it = in_edges.find(state);
-            if (it != in_edges.end()) {
-                return it->second;
-            }
-            return empty;
+        // Get all target states reachable from an edge, each once
+        std::span<const StateId> getTargetStates(uint32_t edge) const {
+            return {targets.data() + target_offsets[edge], targets.data() + target_offsets[edge + 1]};
         }
         
         // Print the game structure for debugging
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+
+namespace ctl {
+
+/**
+ * @brief Process-wide, thread-safe LRU cache of guard satisfiability verdicts.
+ *
+ * Keys are canonical: the atoms of a guard conjunction are sorted and joined,
+ * so the same set of atoms hits the same entry regardless of the order in
+ * which it was built or which property produced it.
+ */
+class GuardSatCache {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+    static GuardSatCache& instance();
+
+    static std::string makeKey(const std::unordered_set<std::string>& atoms, bool without_parsing);
+    static std::string makeKey(const std::string& formula, bool without_parsing);
+
+    std::optional<bool> lookup(const std::string& key);
+    void insert(const std::string& key, bool satisfiable);
+
+    void setCapacity(size_t capacity);
+    void clear();
+
+    size_t size() const;
+    size_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    size_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    GuardSatCache() = default;
+    void __evictIfNeeded();
+
+    using Entry = std::pair<std::string, bool>;
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;  // most recently used at the front
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t capacity_ = DEFAULT_CAPACITY;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+};
+
+} // namespace ctl
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ctl {
+
+/**
+ * @brief Process-wide, thread-safe hash-consing table for guard strings.
+ *
+ * Every distinct guard is stored once and identified by a dense id, so two
+ * guards are equal iff their ids are. The constants have fixed ids: the empty
+ * guard and "true" share TRUE_ID, "false" is FALSE_ID.
+ */
+class GuardTable {
+public:
+    using Id = uint32_t;
+    static constexpr Id TRUE_ID = 0;
+    static constexpr Id FALSE_ID = 1;
+
+    static GuardTable& instance();
+
+    Id intern(const std::string& guard);
+    const std::string& text(Id id) const;
+    size_t size() const;
+
+private:
+    GuardTable();
+
+    mutable std::mutex mutex_;
+    std::deque<std::string> texts_;  // by id; a deque keeps references stable
+    std::unordered_map<std::string, Id> ids_;
+};
+
+} // namespace ctl
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "guard_table.h"
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ctl {
+
+class CTLFormula;
+
+/**
+ * @brief Guards decided without a solver: conjunctions of Boolean atoms and
+ * of single-variable integer comparisons against constants.
+ *
+ * Each variable of a conjunction is an integer interval with a few excluded
+ * points (x != c), each atom a fixed value, so satisfiability of a guard
+ * conjunction and entailment between two of them are a few bound updates.
+ * A guard with a disjunction, an implication, a negated conjunction or a
+ * comparison between two variables is relational: it has no literal form,
+ * and a query that involves it goes to the SMT solver. Comparisons are
+ * over the integers, as the Z3 lowering declares their variables.
+ */
+class IntervalDomain {
+public:
+    // x <= c, x >= c, x == c, x != c, or a Boolean atom or its negation
+    struct Literal {
+        enum class Kind : uint8_t { ATOM, NOT_ATOM, LE, GE, EQ, NE };
+        std::string variable;
+        Kind kind;
+        int64_t value = 0;
+
+        Literal negated() const;
+    };
+
+    // A guard as a conjunction of literals; never_holds for a constant false part
+    struct Conjunction {
+        std::vector<Literal> literals;
+        bool never_holds = false;
+    };
+
+    static IntervalDomain& instance();
+
+    // Literal form of the guard, parsed once; null if the guard is relational
+    const Conjunction* lookup(GuardTable::Id guard);
+    // Literal form of a guard formula, none if it is relational
+    static std::optional<Conjunction> toConjunction(const CTLFormula& guard);
+
+    // Whether the guards can hold together; none if one of them is relational
+    std::optional<bool> satisfiable(std::span<const GuardTable::Id> guards);
+    // Whether the premise guards imply every conclusion guard; none if one is relational
+    std::optional<bool> entails(std::span<const GuardTable::Id> premise, std::span<const GuardTable::Id> conclusion);
+
+private:
+    IntervalDomain() = default;
+
+    mutable std::mutex mutex_;
+    // By guard id; entries are never removed, so the pointers handed out stay valid
+    std::unordered_map<GuardTable::Id, std::optional<Conjunction>> conjunctions_;
+};
+
+} // namespace ctl
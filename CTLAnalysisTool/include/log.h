@@ -0,0 +1,49 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+// Most detailed level compiled in (0 error .. 4 trace); set by CMake
+#ifndef CTL_LOG_LEVEL
+#define CTL_LOG_LEVEL 3
+#endif
+
+namespace ctl::log {
+
+enum class Level : int { ERROR = 0, WARN = 1, INFO = 2, DEBUG = 3, TRACE = 4 };
+
+// Runtime verbosity; INFO unless set. A message is printed if its level is
+// compiled in and either the verbosity reaches it or its caller is verbose.
+void setLevel(Level level);
+Level level();
+bool levelFromString(const std::string& name, Level& level);
+
+inline bool enabled(Level message_level, bool verbose = false) {
+    return verbose || static_cast<int>(message_level) <= static_cast<int>(level());
+}
+
+// Writes one whole line under a single lock: ERROR and WARN to stderr,
+// the rest to stdout
+void write(Level message_level, const std::string& line);
+
+} // namespace ctl::log
+
+/**
+ * CTL_LOG(LEVEL, verbose, message) logs a stream expression, e.g.
+ *   CTL_LOG(DEBUG, verbose_, "Converted formula: " << formula);
+ * Levels above CTL_LOG_LEVEL compile to nothing, message included; enabled
+ * ones format the message only when it will be printed.
+ */
+#define CTL_LOG(LEVEL, verbose, message)                                                        \
+    do {                                                                                        \
+        if constexpr (static_cast<int>(::ctl::log::Level::LEVEL) <= CTL_LOG_LEVEL) {            \
+            if (::ctl::log::enabled(::ctl::log::Level::LEVEL, (verbose))) {                     \
+                std::ostringstream ctl_log_line;                                                \
+                ctl_log_line << message;                                                        \
+                ::ctl::log::write(::ctl::log::Level::LEVEL, ctl_log_line.str());                \
+            }                                                                                   \
+        }                                                                                       \
+    } while (0)
+
+#define CTL_LOG_ERROR(message) CTL_LOG(ERROR, false, message)
+#define CTL_LOG_WARN(message) CTL_LOG(WARN, false, message)
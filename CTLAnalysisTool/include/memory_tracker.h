@@ -2,6 +2,7 @@
 #define MEMORY_UTILS_H
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 #ifdef __linux__
@@ -59,8 +60,9 @@ inline size_t getPeakMemoryUsage() {
     size_t peak_kb = 0;
     
     while (std::getline(status, line)) {
-        if (line.substr(0, 6) == "VmPeak:") {
-            sscanf(line.c_str(), "VmPeak: %zu", &peak_kb);
+        // Peak resident set, matching the Windows figure below
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            sscanf(line.c_str(), "VmHWM: %zu", &peak_kb);
             return peak_kb;
         }
     }
@@ -75,6 +77,47 @@ inline size_t getPeakMemoryUsage() {
     return 0;
 }
 
+/**
+ * @brief Bytes the calling thread has allocated and released through
+ * operator new/delete since it started.
+ *
+ * Counted by the replacement allocation functions in memory_tracker.cpp, so
+ * reading them is two thread-local loads: no system call, no allocation, and
+ * no interference from other threads. Both stay zero when the build disables
+ * CTL_ALLOCATION_COUNTERS or the C library cannot report block sizes. Unlike
+ * the snapshots above, which read /proc and are meant for phase boundaries,
+ * these are cheap enough to take around every single check.
+ */
+struct ThreadAllocations {
+    uint64_t allocated_bytes = 0;
+    uint64_t freed_bytes = 0;
+};
+
+ThreadAllocations threadAllocations();
+
+// Whether threadAllocations() reports real counts in this build
+bool allocationCountersEnabled();
+
+/**
+ * @brief Heap growth of the calling thread from construction to retainedKB():
+ * bytes allocated and not yet released, clamped at zero when the thread
+ * freed more than it allocated.
+ */
+class AllocationScope {
+public:
+    AllocationScope() : start_(threadAllocations()) {}
+
+    size_t retainedKB() const {
+        const ThreadAllocations now = threadAllocations();
+        const uint64_t allocated = now.allocated_bytes - start_.allocated_bytes;
+        const uint64_t freed = now.freed_bytes - start_.freed_bytes;
+        return allocated > freed ? static_cast<size_t>((allocated - freed) / 1024) : 0;
+    }
+
+private:
+    ThreadAllocations start_;
+};
+
 } // namespace memory_utils
 } // namespace ctl
 
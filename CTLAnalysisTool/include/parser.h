@@ -2,7 +2,10 @@
 
 #include "formula.h"
 #include <exception>
+#include <span>
 #include <sstream>
+#include <string_view>
+#include <unordered_map>
 
 namespace ctl {
 
@@ -23,10 +26,11 @@ public:
     size_t position() const { return position_; }
 };
 
-// Lexer class for tokenizing CTL formulas
+// Lexer class for tokenizing CTL formulas. The input is not copied: it and
+// the tokens viewing it must outlive every use of getTokens().
 class Lexer {
 private:
-    std::string input_;
+    std::string_view input_;
     size_t position_;
     std::vector<Token> tokens_;
     
@@ -40,16 +44,18 @@ private:
     void tokenize();
     
 public:
-    explicit Lexer(const std::string& input);
+    explicit Lexer(std::string_view input);
     const std::vector<Token>& getTokens() const { return tokens_; }
     std::string getErrorContext(size_t pos, size_t context_size = 10) const;
 };
 
-// Recursive descent parser for CTL formulas with proper precedence handling
+// Recursive descent parser for CTL formulas with proper precedence handling.
+// The tokens are borrowed from the lexer, not copied.
 class Parser {
 private:
-    std::vector<Token> tokens_;
+    std::span<const Token> tokens_;
     size_t current_token_;
+    std::unordered_map<std::string_view, CTLFormulaPtr> atoms_;  // by name, see atom()
     
     const Token& current() const;
     const Token& peek(size_t offset = 1) const;
@@ -67,17 +73,18 @@ private:
     CTLFormulaPtr parse_temporal();
     CTLFormulaPtr parse_primary();
     // Helper methods
+    CTLFormulaPtr atom(std::string_view name);
     TimeInterval parse_time_interval();
     BinaryOperator token_to_binary_operator(TokenType type);
     TemporalOperator token_to_temporal_operator(TokenType type);
     std::string comparison_token_to_string(TokenType type);
     
 public:
-    explicit Parser(const std::vector<Token>& tokens);
+    explicit Parser(std::span<const Token> tokens);
     CTLFormulaPtr parse();
     
     // Static convenience method
-    static CTLFormulaPtr parseFormula(const std::string& input);
+    static CTLFormulaPtr parseFormula(std::string_view input);
 };
 
 
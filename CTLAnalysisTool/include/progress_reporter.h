@@ -0,0 +1,67 @@
+#pragma once
+
+#include "refinement_cache.h"
+#include "statistics.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace ctl {
+
+/**
+ * @brief Periodic, machine-readable progress of a run, one JSON object per line.
+ *
+ * A background thread appends a line every interval and a last one when the
+ * reporter is destroyed. Each line has the pairs planned, decided and
+ * remaining, the refinement checks run, pair and check rates over the last
+ * interval, an ETA from the rate since the reporter started, the seconds
+ * since a pair was last decided (a stall shows as a growing value with
+ * pairs remaining), guard and verdict cache hit rates, the resident set
+ * size and the CPU utilization of every thread of the process over the
+ * last interval. Pair and check counts come from the process-wide
+ * statistics, so concurrent inputs are summed. Thread utilization is read
+ * from /proc and is only reported on Linux.
+ */
+class ProgressReporter {
+public:
+    // cache: the verdict cache of the run, if any, for its hit rate
+    ProgressReporter(const std::string& path, std::chrono::milliseconds interval,
+                     const RefinementCache* cache = nullptr);
+    ~ProgressReporter();
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    // Takes a sample now: the JSON line, without the newline. Rates are
+    // relative to the previous sample
+    std::string sample();
+
+private:
+    void __run();
+
+    std::ofstream out_;
+    std::chrono::milliseconds interval_;
+    const RefinementCache* cache_;
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start_;
+    StatisticValues start_values_{};
+
+    std::mutex sample_mutex_;  // guards the previous sample below
+    Clock::time_point last_time_;
+    StatisticValues last_values_{};
+    Clock::time_point last_progress_;
+    std::map<long, unsigned long long> last_thread_ticks_;  // tid -> user + system clock ticks
+
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace ctl
@@ -2,11 +2,16 @@
 
 #include "formula.h"
 #include "CTLautomaton.h"
+#include "flat_formula.h"
 
 #include "ExternSATInterface.h"
+#include "cancellation.h"
 
 #include <unordered_set>
 #include <functional>
+#include <atomic>
+#include <mutex>
+#include <optional>
 
 namespace ctl {
 
@@ -29,10 +34,19 @@ struct CTLFormulaEqual {
 class CTLProperty {
 private:
     CTLFormulaPtr formula_;
+    FlatFormula flat_;  // formula_ as a node array, for the syntactic traversals
     bool verbose_ = false;
     mutable std::shared_ptr<CTLAutomaton> automaton_; // Lazy initialization
+    // automaton_ once built; lets readers skip automaton_mutex_
+    mutable std::atomic<const CTLAutomaton*> automaton_ready_{nullptr};
+    mutable std::mutex automaton_mutex_;
+    std::shared_ptr<SubformulaStore> subformula_store_;  // see setSubformulaStore(), guarded by automaton_mutex_
     mutable std::unordered_set<std::string> atomic_props_; // Cache
     mutable bool atomic_props_computed_ = false;
+    std::vector<std::string> grouping_atoms_;  // see groupingAtoms()
+    std::vector<uint8_t> grouping_polarities_; // one per grouping atom
+    mutable std::atomic<int8_t> satisfiable_{-1}; // see knownSatisfiable(); -1 unknown
+    mutable std::atomic<int8_t> valid_{-1};       // see knownValid(); -1 unknown
     
     // Static cache for parsed properties
     static std::unordered_map<std::string, std::shared_ptr<CTLProperty>> property_cache_;
@@ -42,11 +56,12 @@ private:
     
 public:
     explicit CTLProperty(const std::string& formula_str, bool encode_comparison =false);
-    explicit CTLProperty(CTLFormulaPtr formula);
-    ~CTLProperty() = default; // Let shared_ptr handle cleanup automatically
+    explicit CTLProperty(CTLFormulaPtr formula, bool encode_comparison = false);
+    ~CTLProperty();
     
     // Factory method with caching
     static std::shared_ptr<CTLProperty> create(const std::string& formula_str, bool verbose = false, bool encode_comparison = false);
+    // Takes the AST as is, without printing and parsing it again
     static std::shared_ptr<CTLProperty> create(CTLFormulaPtr formula, bool verbose = false, bool encode_comparison = false);
     
     // Memory management
@@ -58,21 +73,45 @@ public:
     const CTLFormulaPtr& getFormulaPtr() const { return formula_; }
     std::string toString() const { return formula_->toString(); }
     std::string toNuSMVString() const { return formula_->toNuSMVString(); }
-    size_t size() const { 
-        std::unordered_map<formula_utils::FormulaKey, const CTLFormula*, formula_utils::FormulaKeyHash> seen;
-        std::vector<const CTLFormula*> topo;
-        formula_utils::collectClosureDFS(*formula_, seen, topo);
-        return topo.size(); 
-    }
+    // Number of automaton states before helper states: the closure size
+    size_t size() const { return flat_.closureSize(); }
+    const FlatFormula& flat() const { return flat_; }
     
     // Atomic propositions (cached)
     const std::unordered_set<std::string>& getAtomicPropositions() const;
+    // The atomic propositions that tie properties into one equivalence class,
+    // i.e. without boolean and numeric literals, sorted; classified once
+    // when the formula is parsed
+    const std::vector<std::string>& groupingAtoms() const { return grouping_atoms_; }
+    // How each of groupingAtoms() occurs: kPositive under an even number of
+    // negations (the left side of -> counts as one), kNegative under an odd
+    // number, or both. Variables of comparisons and of propositions over
+    // several variables count as both: their values are not independent
+    static constexpr uint8_t kPositive = 1;
+    static constexpr uint8_t kNegative = 2;
+    const std::vector<uint8_t>& groupingPolarities() const { return grouping_polarities_; }
     
-    // ABTA (lazy initialization)
+    // ABTA (lazy initialization); built once even when several threads ask
+    // for it, and read-only from then on. Under an AutomatonBudget the
+    // reference is only safe while nothing else can evict it; concurrent
+    // callers use automatonHandle(), which keeps the automaton alive
     const CTLAutomaton& automaton() const;
+    std::shared_ptr<const CTLAutomaton> automatonHandle() const;
+    // The automaton if it is built, null otherwise; never builds it
+    std::shared_ptr<const CTLAutomaton> builtAutomaton() const;
+    // Drops the cached automaton; the next access rebuilds it
+    void releaseAutomaton() const;
+    // Store shared with the other properties of its class, used by the
+    // automaton (and any rebuild of it), see CTLAutomaton::useSubformulaStore.
+    // Not while checks read the automaton
+    void setSubformulaStore(std::shared_ptr<SubformulaStore> store);
+    // ABTA of the negated formula, built once and owned by automaton(), so
+    // clearInstanceCaches releases it together with the automaton
+    const CTLAutomaton& complement() const { return automaton().getComplement(); }
 
     void simplify() const;
-    bool isEmpty() const;
+    // pool: see CTLAutomaton::isEmpty. The verdict is kept, see knownSatisfiable()
+    bool isEmpty(WorkStealingPool* pool = nullptr) const;
     bool isEmpty(const ExternalCTLSATInterface& sat_interface) const;
     bool isSatisfiable(const ExternalCTLSATInterface& sat_interface) const {
         return !isEmpty(sat_interface);
@@ -80,13 +119,29 @@ public:
     bool isSatisfiable() const {
         return !isEmpty();
     }
+    // Satisfiability once isEmpty() or setSatisfiable() decided it. It
+    // survives releaseAutomaton() and clearInstanceCaches(), so later phases
+    // and analyzers sharing the property do not check it again
+    std::optional<bool> knownSatisfiable() const;
+    void setSatisfiable(bool satisfiable) const { satisfiable_.store(satisfiable, std::memory_order_relaxed); }
+    // Validity: emptiness of the complement automaton, kept like satisfiability
+    bool isValid(WorkStealingPool* pool = nullptr) const;
+    std::optional<bool> knownValid() const;
+    void setValid(bool valid) const { valid_.store(valid, std::memory_order_relaxed); }
     
     bool verbose() const { return verbose_; }
     void setVerbose(bool v) { verbose_ = v; }
     // Refinement checking
-    bool refines(const CTLProperty& other, bool use_syntactic = true, bool use_full_inclusion = false) const;
+    // engine only applies to full language inclusion. With a token, the check
+    // throws CheckCancelled once the token expires (see cancellation.h).
+    // compositional splits a top-level disjunction of this and a top-level
+    // conjunction of other into part pairs, see __refinesComposed()
+    bool refines(const CTLProperty& other, bool use_syntactic = true, bool use_full_inclusion = false,
+                 EmptinessEngine engine = EmptinessEngine::FIXPOINT,
+                 const CancellationToken* token = nullptr, bool compositional = false) const;
     bool refinesSyntactic(const CTLProperty& other) const;
-    bool refinesSemantic(const CTLProperty& other, bool use_full_inclusion = false) const;
+    bool refinesSemantic(const CTLProperty& other, bool use_full_inclusion = false,
+                         EmptinessEngine engine = EmptinessEngine::FIXPOINT) const;
     
 
     bool refines(const CTLProperty& other, const ExternalCTLSATInterface& sat_interface) const {
@@ -102,18 +157,20 @@ public:
     bool operator!=(const CTLProperty& other) const { return !equals(other); }
     
 private:
-    // Syntactic refinement checking
-    bool refinementCheck(const CTLFormula& f1, const CTLFormula& f2) const;
-    bool refinementCheckAtomic(const CTLFormula& f1, const CTLFormula& f2) const;
-    bool refinementCheckNegation(const NegationFormula& f1, const CTLFormula& f2) const;
-    bool refinementCheckBinary(const BinaryFormula& f1, const CTLFormula& f2) const;
-    bool refinementCheckTemporal(const TemporalFormula& f1, const CTLFormula& f2) const;
+    // Syntactic refinement over the flat formulas of two properties, see property.cpp
+    struct SyntacticCheck;
     
+    void __classifyAtoms();
+    // (p1 | p2) -> q iff p1 -> q and p2 -> q, and p -> (q1 & q2) iff p -> q1
+    // and p -> q2: every part pair is decided on its own, each verdict kept
+    // for the rest of the run by interned part formulas. A part simulation
+    // misses falls back to the whole pair, since simulation is incomplete
+    bool __refinesComposed(const CTLProperty& other, bool use_syntactic, bool use_full_inclusion,
+                           EmptinessEngine engine) const;
+
     // Helper for interval subsumption
     static bool intervalSubsumes(const TimeInterval& inner, const TimeInterval& outer);
-    
-    // Helper for temporal operator ordering
-    static bool temporalOperatorRefines(TemporalOperator op1, TemporalOperator op2);
+
 };
 
 // Hash specialization for unordered containers
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Persistent store of refinement and satisfiability verdicts.
+ *
+ * Verdicts live in an append-only log (`verdicts.tsv`) inside the cache
+ * directory. Each entry is keyed by the canonical printed form of the
+ * formula(s) and by the check mode (simulation, language inclusion or the
+ * external SAT backend), so results obtained under one mode are never
+ * reused for another. The log is read once when the cache is opened; new
+ * verdicts are buffered and appended by flush() under an exclusive file
+ * lock, while loading takes a shared lock, so several tool runs may use the
+ * same directory concurrently. Lookups and stores are thread-safe.
+ */
+class RefinementCache {
+public:
+    /**
+     * @brief Opens (creating if needed) the cache stored in the given directory.
+     * Throws std::runtime_error if the directory cannot be created.
+     */
+    explicit RefinementCache(const std::string& directory);
+    ~RefinementCache();
+
+    RefinementCache(const RefinementCache&) = delete;
+    RefinementCache& operator=(const RefinementCache&) = delete;
+
+    std::optional<bool> lookupRefinement(const std::string& mode, const std::string& refining,
+                                         const std::string& refined) const;
+    void storeRefinement(const std::string& mode, const std::string& refining,
+                         const std::string& refined, bool refines);
+
+    std::optional<bool> lookupSatisfiable(const std::string& mode, const std::string& formula) const;
+    void storeSatisfiable(const std::string& mode, const std::string& formula, bool satisfiable);
+
+    /**
+     * @brief Appends the verdicts stored since the last flush to the log.
+     */
+    void flush();
+
+    size_t size() const;
+    size_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    size_t misses() const { return misses_.load(std::memory_order_relaxed); }
+    const std::string& directory() const { return directory_; }
+
+private:
+    static std::string __key(char kind, const std::string& mode,
+                             const std::string& first, const std::string& second = "");
+    std::optional<bool> __lookup(const std::string& key) const;
+    void __store(std::string key, bool verdict);
+    void __load();
+
+    std::string directory_;
+    std::string log_path_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, bool> verdicts_;
+    std::vector<std::pair<std::string, bool>> pending_;
+    mutable std::atomic<size_t> hits_{0};
+    mutable std::atomic<size_t> misses_{0};
+};
+
+} // namespace ctl
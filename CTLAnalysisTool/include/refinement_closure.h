@@ -0,0 +1,168 @@
+#pragma once
+
+#include "bit_matrix.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace ctl {
+
+/**
+ * @brief Known refinement facts of one equivalence class, closed under both polarities.
+ *
+ * Positive facts are kept transitively closed row by row (i->j adds j's
+ * row to i's). Negative facts come from the two contrapositives of
+ * transitivity:
+ *   - j->k and not i->k imply not i->j (refuted by the target),
+ *   - h->i and not h->j imply not i->j (refuted by the source).
+ * Transposed copies of both matrices make every inference a word-parallel
+ * row intersection. Matrix is BitMatrix for a single thread or
+ * AtomicBitMatrix when several workers record facts concurrently; every
+ * inference only ever uses recorded facts, so a stale read only costs a
+ * missed skip.
+ *
+ * Mutually refining properties are condensed online: once i->j and j->i
+ * are known, both map to one representative (the smaller index) whose rows
+ * and columns carry the facts of the whole group, and every later fact and
+ * query goes through representatives. Call finalize() once all workers are
+ * done, before reading refines().
+ */
+template <class Matrix>
+class RefinementClosure {
+public:
+    enum class Inference { UNKNOWN, IMPLIED, EQUIVALENT, REFUTED, REFUTED_BY_TARGET, REFUTED_BY_SOURCE };
+
+    explicit RefinementClosure(size_t n)
+        : n_(n), reach_(make(n)), reach_t_(make(n)), refuted_(make(n)), refuted_t_(make(n)),
+          representative_(std::make_unique<std::atomic<size_t>[]>(n)) {
+        for (size_t k = 0; k < n; ++k) representative_[k].store(k, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Decides i->j from recorded facts if possible. A refutation is
+     * recorded, so later inferences can build on it.
+     */
+    Inference infer(size_t i, size_t j, bool negative = true) {
+        i = representative(i);
+        j = representative(j);
+        if (i == j) return Inference::EQUIVALENT;
+        if (reach_.test(i, j)) return Inference::IMPLIED;
+        if (!negative) return Inference::UNKNOWN;
+        // A condensed pair may have been checked already through other members
+        if (refuted_.test(i, j)) return Inference::REFUTED;
+        if (refuted_.rowsIntersect(i, reach_, j)) {
+            __refute(i, j);
+            return Inference::REFUTED_BY_TARGET;
+        }
+        if (reach_t_.rowsIntersect(i, refuted_t_, j)) {
+            __refute(i, j);
+            return Inference::REFUTED_BY_SOURCE;
+        }
+        return Inference::UNKNOWN;
+    }
+
+    // Without transitive, facts are only recorded: no closure, no condensation
+    void addRefines(size_t i, size_t j, bool transitive = true) {
+        CTL_TRACE_SPAN("closure", "addRefines");
+        if (!transitive) {
+            reach_.set(i, j);
+            reach_t_.set(j, i);
+            return;
+        }
+        i = representative(i);
+        j = representative(j);
+        if (i == j) return;
+        reach_.set(i, j);
+        reach_t_.set(j, i);
+        // TRANSITIVE CLOSURE: If i->j, then i can reach everything j can reach
+        reach_.orRow(i, j);
+        reach_.forEachInRow(i, [this, i](size_t k) { reach_t_.set(k, i); });
+        // CONDENSATION: If also j->i, both are one property from now on
+        if (reach_.test(j, i)) __merge(i, j);
+    }
+
+    // Only proven non-refinements: a miss of a sound but incomplete check would
+    // refute other pairs through the contrapositives
+    void addRefuted(size_t i, size_t j) {
+        CTL_TRACE_SPAN("closure", "addRefuted");
+        __refute(representative(i), representative(j));
+    }
+
+    size_t representative(size_t i) const {
+        size_t r = representative_[i].load(std::memory_order_acquire);
+        while (r != i) {
+            i = r;
+            r = representative_[i].load(std::memory_order_acquire);
+        }
+        return r;
+    }
+
+    size_t merges() const { return merges_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Moves facts a concurrent worker recorded on a member after its
+     * group was merged over to the representative. Not thread-safe.
+     */
+    void finalize() {
+        for (size_t m = 0; m < n_; ++m) {
+            const size_t r = representative(m);
+            if (r != m) reach_t_.forEachInRow(m, [this, r](size_t x) { reach_.set(x, r); });
+        }
+        for (size_t m = 0; m < n_; ++m) {
+            const size_t r = representative(m);
+            if (r != m) reach_.orRow(r, m);
+        }
+    }
+
+    bool refines(size_t i, size_t j) const {
+        if (i == j) return false;
+        const size_t ri = representative(i), rj = representative(j);
+        return ri == rj || reach_.test(ri, rj);
+    }
+
+private:
+    static Matrix make(size_t n) {
+        if constexpr (std::is_same_v<Matrix, BitMatrix>) return BitMatrix(n, n);
+        else return Matrix(n);
+    }
+
+    void __refute(size_t i, size_t j) {
+        refuted_.set(i, j);
+        refuted_t_.set(j, i);
+    }
+
+    void __merge(size_t a, size_t b) {
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        a = representative(a);
+        b = representative(b);
+        if (a == b) return;
+        const size_t keep = std::min(a, b), gone = std::max(a, b);
+        // Rows and columns of the representative cover the whole group
+        reach_.orRow(keep, gone);
+        reach_t_.orRow(keep, gone);
+        refuted_.orRow(keep, gone);
+        refuted_t_.orRow(keep, gone);
+        reach_t_.forEachInRow(gone, [this, keep](size_t x) { reach_.set(x, keep); });
+        reach_.forEachInRow(gone, [this, keep](size_t x) { reach_t_.set(x, keep); });
+        refuted_t_.forEachInRow(gone, [this, keep](size_t x) { refuted_.set(x, keep); });
+        refuted_.forEachInRow(gone, [this, keep](size_t x) { refuted_t_.set(x, keep); });
+        representative_[gone].store(keep, std::memory_order_release);
+        merges_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    size_t n_;
+    Matrix reach_;      // reach_(i, j): i refines j
+    Matrix reach_t_;    // transpose of reach_
+    Matrix refuted_;    // refuted_(i, j): i does not refine j
+    Matrix refuted_t_;  // transpose of refuted_
+    std::unique_ptr<std::atomic<size_t>[]> representative_;
+    std::mutex merge_mutex_;
+    std::atomic<size_t> merges_{0};
+};
+
+} // namespace ctl
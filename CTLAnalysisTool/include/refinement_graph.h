@@ -1,5 +1,6 @@
 #pragma once
 #include "property.h"
+#include "bit_matrix.h"
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
@@ -23,35 +24,65 @@ public:
     
 private:
     std::vector<std::shared_ptr<CTLProperty>> nodes_;
-    std::vector<Edge> edges_;
-    std::unordered_map<size_t, std::vector<size_t>> adjacency_list_;
-    
-    // For transitive optimization access
-    std::vector<std::vector<size_t>> adjacency_; // Direct adjacency matrix access
+    std::vector<Edge> unknown_edges_;  // pairs whose check ran out of time
+
+    // Every recorded refinement, bit-packed for O(1) hasEdge. Nodes added
+    // since the last addEdge have no row yet; it grows on the next one
+    BitMatrix edge_bits_;
+    size_t edge_count_ = 0;
+
+    // The transitive reduction of edge_bits_, derived on first use after a
+    // change, and the closure it was derived from. A chain of n refinements
+    // keeps n - 1 edges here instead of n(n - 1) / 2
+    mutable bool reduction_valid_ = false;
+    mutable std::vector<Edge> edges_;
+    mutable std::unordered_map<size_t, std::vector<size_t>> adjacency_list_;
+    mutable BitMatrix closure_;
+
+    void __growEdgeBits();
+    void __reduce() const;
+    // Drops the node and everything recorded about it; later indices shift down
+    void __removeNode(size_t index);
     
 public:
     void addNode(std::shared_ptr<CTLProperty> property);
-    void addEdge(size_t from, size_t to);
+    void addEdge(size_t from, size_t to);  // adding an existing edge is a no-op
     bool hasEdge(size_t from, size_t to) const;
+    // Refinement of from by to was not decided: its check timed out
+    void addUnknownEdge(size_t from, size_t to);
+    bool isUnknown(size_t from, size_t to) const;
+    const std::vector<Edge>& getUnknownEdges() const { return unknown_edges_; }
     
     const std::vector<std::shared_ptr<CTLProperty>>& getNodes() const { return nodes_; }
-    const std::vector<Edge>& getEdges() const { return edges_; }
+    // The transitive reduction: a ring through every set of mutually refining
+    // nodes, in index order, and the Hasse diagram between those sets, from
+    // their lowest index. Implied refinements are left out; hasEdge and
+    // hasPath still answer them
+    const std::vector<Edge>& getEdges() const {
+        if (!reduction_valid_) __reduce();
+        return edges_;
+    }
     const std::unordered_map<size_t, std::vector<size_t>>& getAdjacencyList() const { 
+        if (!reduction_valid_) __reduce();
         return adjacency_list_; 
     }
+    // Every recorded refinement, implied ones included, by source then target
+    std::vector<Edge> getRecordedEdges() const;
     
     // Graph algorithms
     std::vector<size_t> topologicalSort() const;
     std::vector<std::vector<size_t>> findStronglyConnectedComponents() const;
+    // Reachable along one or more recorded refinements
     bool hasPath(size_t from, size_t to) const;
     
-    // Visualization
+    // Visualization, of the transitive reduction
     void toDot(const std::string& filename, const std::string& title = "Refinement Graph") const;
     void toPNG(const std::string& filename, const std::string& title = "Refinement Graph") const;
     
     // Statistics
     size_t getNodeCount() const { return nodes_.size(); }
-    size_t getEdgeCount() const { return edges_.size(); }
+    // Recorded refinements, implied ones included
+    size_t getEdgeCount() const { return edge_count_; }
     double getDensity() const;
     std::vector<size_t> getInDegrees() const;
     std::vector<size_t> getOutDegrees() const;
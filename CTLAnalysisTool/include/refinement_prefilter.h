@@ -0,0 +1,101 @@
+#pragma once
+
+#include "property.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Sound pre-checks that decide refinement pairs before any automaton is built.
+ *
+ * Every property gets a cached signature: the variables it mentions, by polarity, and
+ * its truth table over a fixed sample of one-state models (a single state with
+ * a self loop, where every temporal operator collapses to a boolean one). A
+ * sampled model satisfying phi1 but not phi2 is a genuine counterexample to
+ * phi1 -> phi2. Properties over disjoint variables cannot refine each other
+ * unless phi2 is valid, since models of phi1 and of !phi2 combine into one
+ * product model. The same holds when every shared variable occurs with
+ * opposite polarities (CTLProperty::groupingPolarities): both formulas are
+ * monotone in it, so fixing it to true (or false) everywhere keeps a model of
+ * phi1 and one of !phi2, which then share no variable that matters.
+ * Formulas with arithmetic comparisons are not sampled (their atoms are not
+ * independent), so only the polarity check applies to them.
+ *
+ * One-state models cannot tell AF from AG or EX from AX, so every property
+ * is also model checked on a fixed family of small random Kripke structures
+ * (total transition relations, random labels, state 0 initial). An explicit
+ * CTL checker evaluates all of them at once, one bit per model in each
+ * state's words, and the bits of the initial state form a second
+ * fingerprint: a model of phi1 that is not one of phi2 refutes phi1 -> phi2
+ * with a word-wise and-not. Bounded time intervals are not checked.
+ *
+ * check() is thread-safe; signatures are computed once per property.
+ */
+class RefinementPrefilter {
+public:
+    enum class Decision { UNKNOWN, REFINES, DOES_NOT_REFINE };
+
+    static constexpr size_t kSampleWords = 4;  // 256 sampled one-state models
+    static constexpr size_t kModelWords = 4;   // 256 random Kripke models
+    static constexpr size_t kModelStates = 4;  // states per Kripke model
+
+    struct Signature {
+        // Bitsets over prefilter-wide variable ids, by polarity; mixed variables are in both
+        std::vector<uint64_t> positive, negative;
+        std::array<uint64_t, kSampleWords> truth{};      // bit k: holds in sampled model k
+        bool sampled = false;                            // truth is meaningful
+        std::array<uint64_t, kModelWords> models{};      // bit k: holds in Kripke model k
+        bool model_checked = false;                      // models is meaningful
+        bool is_true = false;                            // the literal "true"
+        bool is_false = false;                           // the literal "false"
+        std::atomic<bool> satisfiable{false};            // proven satisfiable by the analysis
+    };
+
+    Decision check(const CTLProperty& refining, const CTLProperty& refined);
+
+    // Record that the analysis proved the property satisfiable
+    void noteSatisfiable(const CTLProperty& property);
+    // A sampled one-state model falsifies the property, so it is not valid
+    bool hasCounterModel(const CTLProperty& property);
+    // Number of sampled one-state models satisfying the property, -1 if it
+    // is not sampled. Fewer models means a (likely) stronger property.
+    int sampledModels(const CTLProperty& property);
+    // Drop the signature of a property that left the analysis
+    void forget(const CTLProperty& property);
+
+    size_t decidedRefines() const { return decided_refines_.load(std::memory_order_relaxed); }
+    size_t decidedNonRefines() const { return decided_non_refines_.load(std::memory_order_relaxed); }
+    size_t undecided() const { return undecided_.load(std::memory_order_relaxed); }
+    // Non-refinements only a Kripke model refuted, a subset of decidedNonRefines()
+    size_t refutedByModels() const { return refuted_by_models_.load(std::memory_order_relaxed); }
+
+private:
+    // Truth in every Kripke model, by state: bit k of word w is model 64 * w + k
+    using ModelTruth = std::array<std::array<uint64_t, kModelWords>, kModelStates>;
+
+    Signature& __signature(const CTLProperty& property);
+    bool __sample(const CTLFormula& formula, std::array<uint64_t, kSampleWords>& out);
+    bool __modelCheck(const CTLFormula& formula, ModelTruth& out);
+    uint32_t __variableId(const std::string& name);
+    uint32_t __leafId(const std::string& leaf);
+
+    std::shared_mutex mutex_;
+    std::unordered_map<const CTLProperty*, std::unique_ptr<Signature>> signatures_;
+    std::unordered_map<std::string, uint32_t> variable_ids_;
+    std::unordered_map<std::string, uint32_t> leaf_ids_;
+
+    std::atomic<size_t> decided_refines_{0};
+    std::atomic<size_t> decided_non_refines_{0};
+    std::atomic<size_t> undecided_{0};
+    std::atomic<size_t> refuted_by_models_{0};
+};
+
+} // namespace ctl
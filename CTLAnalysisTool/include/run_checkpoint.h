@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Progress of one analysis run, saved to a compact binary file.
+ *
+ * Holds what a resumed run can skip: satisfiability results of the
+ * unsatisfiable-property pass, the verdict of every decided pair (the
+ * remaining pairs of an unfinished class are its pending queue) and the
+ * edges of every finished class graph. Formulas are stored once in a table
+ * and referenced by index. The file is tagged with a fingerprint of the
+ * input and check mode; a file from a different run is ignored.
+ *
+ * Stores are thread-safe. maybeSave() writes the file once the interval has
+ * passed since the last write, to a temporary file renamed over the old one,
+ * so a run killed mid-write leaves the previous checkpoint intact. Unlike
+ * RefinementCache, a checkpoint belongs to one input and is not shared.
+ */
+class RunCheckpoint {
+public:
+    using Edge = std::pair<uint32_t, uint32_t>;
+
+    // Edges of a finished class, between positions in its member list
+    struct FinishedClass {
+        std::vector<Edge> edges;
+        std::vector<Edge> unknown_edges;
+    };
+
+    RunCheckpoint(std::string path, std::chrono::seconds interval);
+
+    /**
+     * @brief Starts recording the run with the given fingerprint. With resume,
+     * first restores the file if it was saved by a run with the same one.
+     * @return true if earlier progress was restored
+     */
+    bool begin(uint64_t fingerprint, bool resume);
+
+    std::optional<bool> lookupSatisfiable(const std::string& formula) const;
+    void storeSatisfiable(const std::string& formula, bool satisfiable);
+
+    std::optional<bool> lookupRefinement(const std::string& refining, const std::string& refined) const;
+    void storeRefinement(const std::string& refining, const std::string& refined, bool refines);
+
+    // members: the formulas of the class, in class order
+    std::optional<FinishedClass> lookupClass(const std::vector<std::string>& members) const;
+    void storeClass(const std::vector<std::string>& members, FinishedClass finished);
+
+    /**
+     * @brief Adds the results saved at path by another process of the same
+     * run (same fingerprint), such as a shard worker. Where both hold a
+     * result, the one already held is kept.
+     * @return false if the file is missing, unreadable or from another run
+     */
+    bool absorb(const std::string& path);
+
+    // Writes the file if the interval has passed since the last write
+    void maybeSave();
+    // Writes the file now. Throws std::runtime_error if it cannot be written
+    void save();
+
+    const std::string& path() const { return path_; }
+    size_t decidedPairs() const;
+    size_t finishedClasses() const;
+
+private:
+    uint32_t __index(const std::string& formula);  // under mutex_
+    std::optional<uint32_t> __find(const std::string& formula) const;
+    std::string __serialize() const;
+    bool __deserialize(const std::string& data, uint64_t fingerprint);
+
+    std::string path_;
+    std::chrono::seconds interval_;
+    uint64_t fingerprint_ = 0;
+
+    mutable std::mutex mutex_;
+    std::vector<std::string> formulas_;
+    std::unordered_map<std::string, uint32_t> formula_index_;
+    std::unordered_map<uint32_t, bool> satisfiable_;
+    std::unordered_map<uint64_t, bool> refinements_;  // refining << 32 | refined
+    std::map<std::vector<uint32_t>, FinishedClass> classes_;
+
+    std::mutex save_mutex_;  // one writer at a time
+    std::atomic<int64_t> last_save_ns_{0};
+};
+
+} // namespace ctl
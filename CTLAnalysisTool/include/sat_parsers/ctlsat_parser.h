@@ -26,6 +26,18 @@ namespace ctl {
  */
 class CTLSATParser {
 public:
+    /**
+     * @brief The atoms assigned to comparisons and propositions so far
+     *
+     * Formulas converted under one mapping share their atoms, so their
+     * translations can be combined into one query without converting again.
+     */
+    struct Mapping {
+        std::unordered_map<std::string, std::string> comparisons;
+        std::unordered_map<std::string, std::string> atoms;
+        int next_atom_id = 1;
+    };
+
     /**
      * @brief Convert a CTL formula to CTLSAT format string
      * @param formula The CTL formula to convert
@@ -43,6 +55,26 @@ public:
      * @return String in CTLSAT format (e.g., "AG(p^q)")
      */
     static std::string convertString(const std::string& formula_str);
+
+    /**
+     * @brief Convert a CTL formula string under an explicit mapping
+     * @param formula_str The CTL formula string
+     * @param mapping The mapping to extend, instead of the per-thread one
+     * @return String in CTLSAT format
+     */
+    static std::string convertString(const std::string& formula_str, Mapping& mapping);
+
+    /**
+     * @brief Combine two translations into the query "(refining) & !(refined)"
+     *
+     * Both must have been converted under the same mapping. The result is the
+     * translation of the combined formula under that mapping.
+     *
+     * @param refining The converted refining formula
+     * @param refined The converted refined formula
+     * @return The query in CTLSAT format; unsatisfiable iff refining refines refined
+     */
+    static std::string refinementQuery(const std::string& refining, const std::string& refined);
     
     /**
      * @brief Get the mapping from comparison strings to atomic propositions
@@ -52,6 +84,9 @@ public:
     
     /**
      * @brief Clear the comparison mapping (useful for starting fresh conversions)
+     *
+     * Mappings are kept per thread, so clearing only affects conversions made
+     * by the calling thread and concurrent solver queries cannot interfere.
      */
     static void clearComparisonMapping();
 
@@ -59,28 +94,27 @@ private:
     /**
      * @brief Internal recursive conversion function
      * @param formula The formula to convert
+     * @param mapping The mapping that assigns its atoms
      * @return String representation in CTLSAT format
      */
-    static std::string convertFormula(const CTLFormula& formula);
+    static std::string convertFormula(const CTLFormula& formula, Mapping& mapping);
     
     /**
      * @brief Get or create an atom for a comparison expression
      * @param comparison The comparison expression as a string
      * @return The atomic proposition assigned to this comparison (e.g., "a")
      */
-    static std::string getComparisonAtom(const std::string& comparison);
+    static std::string getComparisonAtom(const std::string& comparison, Mapping& mapping);
     
     /**
      * @brief Get or create a letter for an atomic proposition
      * @param atom The atomic proposition as a string
      * @return The single letter assigned to this atom (e.g., "a", "b", "c")
      */
-    static std::string getAtomLetter(const std::string& atom);
+    static std::string getAtomLetter(const std::string& atom, Mapping& mapping);
     
-    // Static members to track mappings
-    static std::unordered_map<std::string, std::string> comparison_map_;
-    static std::unordered_map<std::string, std::string> atom_map_;
-    static int next_atom_id_;
+    // Per-thread mapping of the conversions without an explicit one
+    static thread_local Mapping mapping_;
 };
 
 } // namespace ctl
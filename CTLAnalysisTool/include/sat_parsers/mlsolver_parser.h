@@ -31,6 +31,18 @@ namespace ctl {
  */
 class MLSolverParser {
 public:
+    /**
+     * @brief The atoms assigned to comparisons and propositions so far
+     *
+     * Formulas converted under one mapping share their atoms, so their
+     * translations can be combined into one query without converting again.
+     */
+    struct Mapping {
+        std::unordered_map<std::string, std::string> comparisons;
+        std::unordered_map<std::string, std::string> atoms;
+        int next_atom_id = 1;
+    };
+
     /**
      * @brief Convert a CTL formula to MLSolver format string
      * @param formula The CTL formula to convert
@@ -48,6 +60,26 @@ public:
      * @return String in MLSolver format (e.g., "A G (p & q)")
      */
     static std::string convertString(const std::string& formula_str);
+
+    /**
+     * @brief Convert a CTL formula string under an explicit mapping
+     * @param formula_str The CTL formula string
+     * @param mapping The mapping to extend, instead of the per-thread one
+     * @return String in MLSolver format
+     */
+    static std::string convertString(const std::string& formula_str, Mapping& mapping);
+
+    /**
+     * @brief Combine two translations into the query "(refining) & !(refined)"
+     *
+     * Both must have been converted under the same mapping. The result is the
+     * translation of the combined formula under that mapping.
+     *
+     * @param refining The converted refining formula
+     * @param refined The converted refined formula
+     * @return The query in MLSolver format; unsatisfiable iff refining refines refined
+     */
+    static std::string refinementQuery(const std::string& refining, const std::string& refined);
     
     /**
      * @brief Get the mapping from comparison strings to atomic propositions
@@ -57,6 +89,9 @@ public:
     
     /**
      * @brief Clear the comparison mapping (useful for starting fresh conversions)
+     *
+     * Mappings are kept per thread, so clearing only affects conversions made
+     * by the calling thread and concurrent solver queries cannot interfere.
      */
     static void clearComparisonMapping();
 
@@ -64,28 +99,30 @@ private:
     /**
      * @brief Internal recursive conversion function
      * @param formula The formula to convert
+     * @param mapping The mapping that assigns its atoms
      * @return String representation in MLSolver format
      */
-    static std::string convertFormula(const CTLFormula& formula);
+    static std::string convertFormula(const CTLFormula& formula, Mapping& mapping);
     
     /**
      * @brief Get or create an atom for a comparison expression
      * @param comparison The comparison expression as a string
      * @return The atomic proposition assigned to this comparison (e.g., "p_1")
      */
-    static std::string getComparisonAtom(const std::string& comparison);
+    static std::string getComparisonAtom(const std::string& comparison, Mapping& mapping);
     
     /**
      * @brief Get or create an atom identifier for an atomic proposition
      * @param atom The atomic proposition as a string
      * @return The identifier assigned to this atom (e.g., "p_1", "p_2")
      */
-    static std::string getAtomIdentifier(const std::string& atom);
+    static std::string getAtomIdentifier(const std::string& atom, Mapping& mapping);
+
+    // "! " before an atom, "! (...)" around anything larger
+    static std::string negate(const std::string& operand);
     
-    // Static members to track mappings
-    static std::unordered_map<std::string, std::string> comparison_map_;
-    static std::unordered_map<std::string, std::string> atom_map_;
-    static int next_atom_id_;
+    // Per-thread mapping of the conversions without an explicit one
+    static thread_local Mapping mapping_;
 };
 
 } // namespace ctl
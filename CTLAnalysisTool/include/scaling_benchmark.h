@@ -0,0 +1,81 @@
+#pragma once
+
+#include "types.h"
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ctl {
+
+// Refinement checker measured by a scaling run
+enum class ScalingEngine {
+    SIMULATION,          // ABTA simulation
+    LANGUAGE_INCLUSION,  // ABTA language inclusion with ScalingConfig::emptiness
+    CTL_SAT,             // external CTL-SAT solver
+    MLSOLVER             // external MLSolver
+};
+
+std::string ScalingEngineToString(ScalingEngine engine);
+std::optional<ScalingEngine> ScalingEngineFromString(const std::string& name);
+
+// The sweep: every combination of the lists below is one point
+struct ScalingConfig {
+    std::vector<size_t> class_sizes{8, 16, 32};
+    std::vector<size_t> depths{2, 4};
+    std::vector<size_t> thread_counts{1, 2, 4};
+    std::vector<ScalingEngine> engines{ScalingEngine::SIMULATION, ScalingEngine::LANGUAGE_INCLUSION};
+    size_t atoms = 4;
+    EmptinessEngine emptiness = EmptinessEngine::FIXPOINT;
+    std::string sat_path = "./extern/ctl-sat";  // for the external engines
+    unsigned int seed = 42;
+};
+
+struct ScalingPoint {
+    size_t class_size = 0;
+    size_t depth = 0;
+    size_t threads = 0;
+    ScalingEngine engine = ScalingEngine::SIMULATION;
+    size_t properties = 0;     // analyzed, after unsatisfiable and duplicate inputs are dropped
+    size_t checks = 0;         // pairs handed to the checker (pre-filter and cache included)
+    size_t skipped = 0;        // pairs decided by the transitive closure
+    double wall_ms = 0.0;      // whole analysis
+    double checks_per_sec = 0.0;
+    double p50_ms = 0.0;       // per-check latency
+    double p99_ms = 0.0;
+    double skip_ratio = 0.0;   // skipped / (checks + skipped)
+    size_t peak_rss_kb = 0;
+    std::string error;         // empty on success
+};
+
+/**
+ * @brief Throughput sweep over generated properties.
+ *
+ * Each point generates one equivalence class of class_size properties from
+ * PropertyGenerator (seeded, so reruns see the same formulas) and analyzes it
+ * with the given engine on the given number of threads. Points run in a
+ * forked child process: caches start cold and the peak RSS is the point's
+ * own. Strong scaling reads the rows of one class size across thread counts;
+ * weak scaling pairs class sizes with thread counts of equal work per thread.
+ */
+class ScalingBenchmark {
+public:
+    explicit ScalingBenchmark(ScalingConfig config = ScalingConfig{});
+
+    // Runs every point and writes one JSON object per line to out
+    // @return number of points that failed
+    size_t run(std::ostream& out) const;
+
+    // One point in the calling process
+    ScalingPoint runPoint(size_t class_size, size_t depth, size_t threads, ScalingEngine engine) const;
+
+    static void writeJson(std::ostream& out, const ScalingPoint& point);
+
+private:
+    // runPoint in a child process; the child's JSON line, or a failed point
+    std::string __runPointIsolated(size_t class_size, size_t depth, size_t threads, ScalingEngine engine) const;
+
+    ScalingConfig config_;
+};
+
+} // namespace ctl
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Read-only view of a graph in compressed sparse row form.
+ *
+ * Vertices are 0..size()-1 and the successors of v are
+ * targets[offsets[v], offsets[v + 1]). The view owns nothing.
+ */
+template <class Id, class Offset = uint32_t>
+struct CSRGraphView {
+    std::span<const Offset> offsets;  // size() + 1 entries
+    std::span<const Id> targets;
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::span<const Id> successors(size_t v) const {
+        return targets.subspan(offsets[v], offsets[v + 1] - offsets[v]);
+    }
+};
+
+/**
+ * @brief Strongly connected components, stored flat.
+ *
+ * Component c consists of members[offsets[c], offsets[c + 1]). Components
+ * come successors first (reverse topological order of the condensation),
+ * and within one the vertices come in the order Tarjan's stack pops them.
+ */
+struct SCCDecomposition {
+    std::vector<uint32_t> component;  // component by vertex
+    std::vector<uint32_t> members;    // vertices grouped by component
+    std::vector<uint32_t> offsets;    // size() + 1 entries
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::span<const uint32_t> operator[](size_t c) const {
+        return std::span<const uint32_t>(members).subspan(offsets[c], offsets[c + 1] - offsets[c]);
+    }
+};
+
+/**
+ * @brief Tarjan's SCC algorithm without recursion.
+ *
+ * The DFS keeps an explicit stack of (vertex, next successor) frames, so
+ * deep graphs cannot overflow the call stack, and all bookkeeping lives in
+ * a few arrays sized once per call: nothing is allocated per vertex. A
+ * vertex is on Tarjan's stack iff it has an index but no component yet.
+ * Graph needs size() and successors(v) returning a range of vertex ids,
+ * as CSRGraphView provides.
+ */
+template <class Graph>
+SCCDecomposition stronglyConnectedComponents(const Graph& graph) {
+    constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    const size_t n = graph.size();
+
+    SCCDecomposition result;
+    result.component.assign(n, NONE);
+    result.members.reserve(n);
+    result.offsets.push_back(0);
+
+    std::vector<uint32_t> index(n, NONE), low(n, 0);
+    std::vector<uint32_t> open;                       // Tarjan's stack
+    std::vector<std::pair<uint32_t, size_t>> frames;  // DFS: vertex, next successor
+    uint32_t timer = 0;
+
+    auto visit = [&](uint32_t v) {
+        index[v] = low[v] = timer++;
+        open.push_back(v);
+        frames.emplace_back(v, 0);
+    };
+
+    for (size_t root = 0; root < n; ++root) {
+        if (index[root] != NONE) continue;
+        visit(static_cast<uint32_t>(root));
+        while (!frames.empty()) {
+            const uint32_t v = frames.back().first;
+            const auto successors = graph.successors(v);
+            if (frames.back().second < successors.size()) {
+                const uint32_t w = static_cast<uint32_t>(successors[frames.back().second++]);
+                if (index[w] == NONE) visit(w);
+                else if (result.component[w] == NONE) low[v] = std::min(low[v], index[w]);
+                continue;
+            }
+
+            // All successors explored: report to the parent, close the SCC at its root
+            frames.pop_back();
+            if (!frames.empty()) {
+                const uint32_t parent = frames.back().first;
+                low[parent] = std::min(low[parent], low[v]);
+            }
+            if (low[v] != index[v]) continue;
+            const uint32_t c = static_cast<uint32_t>(result.size());
+            uint32_t w;
+            do {
+                w = open.back();
+                open.pop_back();
+                result.component[w] = c;
+                result.members.push_back(w);
+            } while (w != v);
+            result.offsets.push_back(static_cast<uint32_t>(result.members.size()));
+        }
+    }
+    return result;
+}
+
+} // namespace ctl
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ctl {
+
+/**
+ * @brief Vector of trivially copyable values with N elements stored inline.
+ *
+ * Up to N elements live inside the object, so short sequences (the atoms and
+ * successors of a move) need no heap allocation and sit next to each other in
+ * memory. Larger sequences spill to a heap buffer. Equality compares the raw
+ * bytes, which is exact for padding-free element types.
+ */
+template <typename T, uint32_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector holds trivially copyable values only");
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+    SmallVector(const SmallVector& other) { __assign(other); }
+    SmallVector(SmallVector&& other) noexcept { __take(other); }
+    ~SmallVector() { __release(); }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            size_ = 0;
+            __assign(other);
+        }
+        return *this;
+    }
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            __release();
+            __take(other);
+        }
+        return *this;
+    }
+
+    T* data() { return heap_ ? heap_ : inline_; }
+    const T* data() const { return heap_ ? heap_ : inline_; }
+    uint32_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T* begin() { return data(); }
+    T* end() { return data() + size_; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size_; }
+    T& operator[](uint32_t i) { return data()[i]; }
+    const T& operator[](uint32_t i) const { return data()[i]; }
+
+    void clear() { size_ = 0; }
+    void reserve(uint32_t capacity) { if (capacity > capacity_) __grow(capacity); }
+
+    void push_back(const T& value) {
+        if (size_ == capacity_) __grow(capacity_ * 2);
+        data()[size_++] = value;
+    }
+
+    T* insert(T* pos, const T& value) {
+        const uint32_t at = static_cast<uint32_t>(pos - data());
+        if (size_ == capacity_) __grow(capacity_ * 2);
+        T* base = data();
+        std::memmove(base + at + 1, base + at, (size_ - at) * sizeof(T));
+        base[at] = value;
+        ++size_;
+        return base + at;
+    }
+
+    bool operator==(const SmallVector& other) const {
+        return size_ == other.size_ && std::memcmp(data(), other.data(), size_ * sizeof(T)) == 0;
+    }
+    bool operator!=(const SmallVector& other) const { return !(*this == other); }
+
+private:
+    void __assign(const SmallVector& other) {
+        reserve(other.size_);
+        std::memcpy(data(), other.data(), other.size_ * sizeof(T));
+        size_ = other.size_;
+    }
+
+    // Leaves other empty and inline
+    void __take(SmallVector& other) {
+        if (other.heap_) {
+            heap_ = other.heap_;
+            capacity_ = other.capacity_;
+            other.heap_ = nullptr;
+            other.capacity_ = N;
+        } else {
+            std::memcpy(inline_, other.inline_, other.size_ * sizeof(T));
+        }
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+
+    void __release() {
+        delete[] heap_;
+        heap_ = nullptr;
+        capacity_ = N;
+        size_ = 0;
+    }
+
+    void __grow(uint32_t capacity) {
+        T* grown = new T[capacity];
+        std::memcpy(grown, data(), size_ * sizeof(T));
+        delete[] heap_;
+        heap_ = grown;
+        capacity_ = capacity;
+    }
+
+    T inline_[N];
+    T* heap_ = nullptr;
+    uint32_t size_ = 0;
+    uint32_t capacity_ = N;
+};
+
+} // namespace ctl
@@ -0,0 +1,70 @@
+#ifndef SMT_CONTEXT_MANAGER_H
+#define SMT_CONTEXT_MANAGER_H
+
+#include "SMTInterface.h"
+#include <atomic>
+#include <cstddef>
+
+#ifdef USE_Z3
+#include <z3++.h>
+#endif
+
+namespace ctl {
+
+#ifdef USE_Z3
+class Z3SMTInterface;
+#endif
+
+/**
+ * @brief Hands out one SMT interface (context + solver) per thread.
+ *
+ * Automata no longer own a solver: every satisfiability query borrows the
+ * interface of the calling thread. Worker threads therefore never share a
+ * solver, and an analysis creates at most one context per worker instead of
+ * one per automaton. Expressions obtained from local() (e.g. Guard::sat_expr)
+ * are only meaningful on the thread that created them.
+ */
+class SMTContextManager {
+public:
+    /**
+     * @brief The SMT interface owned by the calling thread, created on first use.
+     */
+    static SMTInterface& local();
+
+    /**
+     * @brief The interface automata ask about guards: a BDD front end over
+     * local() when propositional guards are enabled, local() otherwise.
+     */
+    static SMTInterface& guards();
+
+    /**
+     * @brief Decide propositional guards with BDDs (process-wide, default off).
+     */
+    static void setPropositionalGuards(bool enabled) { s_bdd_guards_.store(enabled, std::memory_order_relaxed); }
+    static bool propositionalGuards() { return s_bdd_guards_.load(std::memory_order_relaxed); }
+
+#ifdef USE_Z3
+    /**
+     * @brief The Z3 context behind local(), for code that builds z3::expr directly.
+     */
+    static z3::context& localZ3Context();
+
+    /**
+     * @brief local() as its concrete Z3 type, for its cached guard expressions.
+     */
+    static Z3SMTInterface& localZ3();
+#endif
+
+    /**
+     * @brief Number of thread-local interfaces created so far in this process.
+     */
+    static size_t contextsCreated() { return s_created_.load(std::memory_order_relaxed); }
+
+private:
+    static std::atomic<size_t> s_created_;
+    static std::atomic<bool> s_bdd_guards_;
+};
+
+} // namespace ctl
+
+#endif // SMT_CONTEXT_MANAGER_H
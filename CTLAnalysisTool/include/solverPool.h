@@ -1,44 +1,94 @@
 #pragma once
+#ifdef USE_Z3
 #include <z3++.h>
-#include <vector>
+#include <atomic>
+#include <cstddef>
 #include <memory>
-#include <mutex>
-struct Z3SolverPool {
-        std::vector<std::unique_ptr<z3::solver>> solvers;
-        std::vector<bool> in_use;
-        std::mutex pool_mutex;
-        z3::context* ctx;
-        
-        Z3SolverPool(z3::context* context, size_t pool_size = 8) : ctx(context) {
-            solvers.reserve(pool_size);
-            in_use.resize(pool_size, false);
-            for (size_t i = 0; i < pool_size; ++i) {
-                solvers.push_back(std::make_unique<z3::solver>(*ctx));
+#include <utility>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Reusable Z3 solvers on one context, handed out as RAII leases.
+ *
+ * Creating a z3::solver is a measurable part of a small check, so solvers
+ * are returned to a free list instead of destroyed: a returned solver is
+ * reset (no assertions, no timeout) and the next lease takes it back. Like
+ * the context it belongs to, a pool serves one thread (each thread-local
+ * Z3SMTInterface owns one), so the free list needs no lock. A lease must
+ * end before its pool, and on the pool's thread.
+ */
+class Z3SolverPool {
+public:
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept
+            : pool_(std::exchange(other.pool_, nullptr)), solver_(std::move(other.solver_)) {}
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                __release();
+                pool_ = std::exchange(other.pool_, nullptr);
+                solver_ = std::move(other.solver_);
             }
+            return *this;
         }
-        
-        // Acquire a solver from the pool
-        std::pair<z3::solver*, size_t> acquire() {
-            std::lock_guard<std::mutex> lock(pool_mutex);
-            for (size_t i = 0; i < solvers.size(); ++i) {
-                if (!in_use[i]) {
-                    in_use[i] = true;
-                    return {solvers[i].get(), i};
-                }
-            }
-            std::cout << "Warning: Z3 Solver Pool exhausted, creating new solver." << std::endl;
-            // Pool exhausted - create new solver
-            size_t idx = solvers.size();
-            solvers.push_back(std::make_unique<z3::solver>(*ctx));
-            in_use.push_back(true);
-            return {solvers[idx].get(), idx};
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() { __release(); }
+
+        z3::solver& operator*() const { return *solver_; }
+        z3::solver* operator->() const { return solver_.get(); }
+
+    private:
+        friend class Z3SolverPool;
+        Lease(Z3SolverPool& pool, std::unique_ptr<z3::solver> solver)
+            : pool_(&pool), solver_(std::move(solver)) {}
+        void __release() {
+            if (pool_ && solver_) pool_->__giveBack(std::move(solver_));
+            pool_ = nullptr;
         }
-        
-        // Release solver back to pool
-        void release(size_t idx) {
-            std::lock_guard<std::mutex> lock(pool_mutex);
-            if (idx < in_use.size()) {
-                in_use[idx] = false;
-            }
+
+        Z3SolverPool* pool_;
+        std::unique_ptr<z3::solver> solver_;
+    };
+
+    explicit Z3SolverPool(z3::context& context) : ctx_(context) {}
+    Z3SolverPool(const Z3SolverPool&) = delete;
+    Z3SolverPool& operator=(const Z3SolverPool&) = delete;
+
+    // An idle solver, or a new one if every solver is leased
+    Lease acquire() {
+        if (free_.empty()) {
+            s_created_.fetch_add(1, std::memory_order_relaxed);
+            return Lease(*this, std::make_unique<z3::solver>(ctx_));
+        }
+        std::unique_ptr<z3::solver> solver = std::move(free_.back());
+        free_.pop_back();
+        return Lease(*this, std::move(solver));
+    }
+
+    size_t idle() const { return free_.size(); }
+    // Solvers created by every pool of the process
+    static size_t solversCreated() { return s_created_.load(std::memory_order_relaxed); }
+
+private:
+    void __giveBack(std::unique_ptr<z3::solver> solver) {
+        try {
+            solver->reset();
+            z3::params params(ctx_);
+            params.set("timeout", 4294967295u);  // no limit, as for a new solver
+            solver->set(params);
+        } catch (const z3::exception&) {
+            return;  // not reusable: destroy it
         }
-    };
\ No newline at end of file
+        free_.push_back(std::move(solver));
+    }
+
+    z3::context& ctx_;
+    std::vector<std::unique_ptr<z3::solver>> free_;
+    static inline std::atomic<size_t> s_created_{0};
+};
+
+} // namespace ctl
+#endif // USE_Z3
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ctl {
+
+// Hot-path counters, process-wide
+enum class Statistic : uint8_t {
+    SMT_QUERIES,               // satisfiability and entailment queries sent to a solver
+    SMT_TIME_NS,               // time spent in them
+    GUARD_CACHE_HITS,
+    GUARD_CACHE_MISSES,
+    SIMULATION_CHECKS,         // simulation relations computed
+    SIMULATION_INITIAL_PAIRS,  // pairs in R before refinement, summed over checks
+    SIMULATION_ITERATIONS,     // worklist pairs processed
+    SIMULATION_PAIRS_PRUNED,   // pairs removed from R
+    PRODUCT_STATES,            // on-the-fly product states explored
+    PRODUCT_EDGES,             // product successors generated
+    GAME_POSITIONS,            // emptiness/antichain game positions
+    GAME_CHOICES,
+    AUTOMATA_BUILT,
+    AUTOMATA_LOADED,           // automata restored from the automaton cache instead of built
+    AUTOMATON_STATES,          // states of the automata built
+    SCCS,                      // SCCs of the automata built
+    PAIRS_PLANNED,             // ordered pairs the refinement phase set out to decide
+    PAIRS_DECIDED,             // of those, checked or inferred so far
+    REFINEMENT_CHECKS,         // refinement checks actually run, not answered from a cache
+    SATISFIABILITY_SHORTCUTS,  // pairs decided from the satisfiability or validity of a side
+    CLASS_SIMULATIONS,         // class-wide simulation preorders computed
+    SHARED_MOVES_REUSED,       // state moves taken from the class's subformula store
+    SHARED_SIMULATION_VERDICTS, // simulation pairs decided by the subformula store
+    INTERVAL_DECISIONS,        // guard queries the interval domain decided without SMT
+    TRUTH_TABLE_DECISIONS,     // propositional guard queries decided by truth tables
+    PORTFOLIO_SYNTACTIC_WINS,  // portfolio pairs decided by the syntactic rules before the race
+    PORTFOLIO_SIMULATION_WINS, // portfolio races won by simulation (class-wide or per pair)
+    PORTFOLIO_INCLUSION_WINS,  // won by full language inclusion
+    PORTFOLIO_EXTERNAL_SAT_WINS, // won by the external SAT backend
+    WITNESSES_KEPT,            // models of refuted pairs added to a class's witness pool
+    WITNESS_REFUTATIONS,       // pairs a pooled witness refuted before any check
+    COUNT
+};
+
+constexpr size_t kStatisticCount = static_cast<size_t>(Statistic::COUNT);
+using StatisticValues = std::array<uint64_t, kStatisticCount>;
+
+// snake_case name, as used in JSON and getStatistics()
+const char* StatisticToString(Statistic statistic);
+
+/**
+ * @brief Registry of the hot-path counters.
+ *
+ * Every thread counts into its own cache-line aligned block, which only that
+ * thread writes, so add() is a relaxed load and store with no contention
+ * between workers. snapshot() sums the blocks, including those of threads
+ * that have finished. Counts are process-wide: take a snapshot before and
+ * after a phase and subtract to attribute them, as RefinementAnalyzer does
+ * for analyze(). Analyses running concurrently see each other's counts.
+ */
+class Statistics {
+public:
+    static Statistics& instance();
+
+    void add(Statistic statistic, uint64_t amount = 1);
+    StatisticValues snapshot() const;
+
+private:
+    Statistics() = default;
+
+    struct alignas(64) ThreadCounters {
+        std::array<std::atomic<uint64_t>, kStatisticCount> values{};
+    };
+    ThreadCounters& __local();
+
+    mutable std::mutex mutex_;  // guards threads_
+    std::vector<std::unique_ptr<ThreadCounters>> threads_;
+};
+
+inline StatisticValues operator-(const StatisticValues& after, const StatisticValues& before) {
+    StatisticValues delta{};
+    for (size_t i = 0; i < kStatisticCount; ++i) delta[i] = after[i] - before[i];
+    return delta;
+}
+
+// Counts one solver query and its duration
+class SmtQueryScope {
+public:
+    SmtQueryScope() : start_(std::chrono::steady_clock::now()) {}
+    ~SmtQueryScope() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        Statistics::instance().add(Statistic::SMT_QUERIES);
+        Statistics::instance().add(Statistic::SMT_TIME_NS,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+    SmtQueryScope(const SmtQueryScope&) = delete;
+    SmtQueryScope& operator=(const SmtQueryScope&) = delete;
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace ctl
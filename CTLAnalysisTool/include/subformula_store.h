@@ -0,0 +1,59 @@
+#pragma once
+
+#include "formula.h"
+#include "transitions.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief What the automata of one equivalence class know about their
+ * states, keyed by the interned formula of the state.
+ *
+ * The sub-automaton below a state depends on nothing but the state's
+ * formula, so what is derived from it holds in every automaton that has a
+ * state for that formula: its DNF moves, and whether it simulates the state
+ * of another formula. Automata using a store (CTLAutomaton::useSubformulaStore)
+ * expand the moves of a subformula once for the whole class and seed their
+ * simulation fixpoints with the verdicts earlier checks of the class found.
+ * Moves are kept over store ids: Move::next_states name subformulas, and
+ * each automaton maps them to its own states. Thread-safe.
+ */
+class SubformulaStore {
+public:
+    using Id = uint32_t;
+    // (spoiler, duplicator, duplicator simulates spoiler)
+    using Verdict = std::tuple<Id, Id, bool>;
+
+    // Dense id of the formula, the same for every equal formula
+    Id id(const CTLFormulaPtr& formula);
+    // Number of distinct subformulas seen
+    size_t size() const;
+
+    // Moves over store ids, null until some automaton published them
+    std::shared_ptr<const std::vector<Move>> moves(Id state) const;
+    // Keeps moves unless others were published first; returns the kept ones
+    std::shared_ptr<const std::vector<Move>> publishMoves(Id state, std::vector<Move> moves);
+
+    // Whether duplicator's state simulates spoiler's, if a finished check found out
+    std::optional<bool> simulated(Id spoiler, Id duplicator) const;
+    void recordSimulations(std::span<const Verdict> verdicts);
+
+private:
+    static uint64_t __key(Id spoiler, Id duplicator) { return (uint64_t{spoiler} << 32) | duplicator; }
+
+    mutable std::mutex mutex_;
+    std::unordered_map<const CTLFormula*, Id> ids_;  // by interned node
+    std::vector<std::shared_ptr<const std::vector<Move>>> moves_;  // by id
+    std::unordered_map<uint64_t, bool> simulations_;
+};
+
+} // namespace ctl
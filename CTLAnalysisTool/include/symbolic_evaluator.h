@@ -1,103 +1,82 @@
 #pragma once
 
-#include <string>
-#include <unordered_set>
-#include <unordered_map>
+#include <atomic>
+#include <cstdint>
 #include <vector>
-#include <memory>
+
 #include "types.h"
-#include "formula.h"
+#include "transitions.h"
 
 namespace ctl {
 
-// Forward declarations
 class CTLAutomaton;
-class SCCBlocks;
-class SMTInterface;
-
-/**
- * SymbolicTransition: Represents a raw transition in symbolic form
- * without expanding it into explicit Move objects.
- * 
- * Contains:
- * - guard: the propositional constraint that must be satisfied
- * - disjuncts: OR of conjunctions, each conjunction is a list of obligations
- * 
- * Each obligation is (dir, state) where:
- * - dir = -1 means "evaluate state's formula symbolically"
- * - dir >= 0 means "temporal child at direction dir must satisfy state"
- */
-struct SymbolicTransition {
-    std::string guard;
-    std::vector<Clause> disjuncts;
-};
+class WorkStealingPool;
 
 /**
  * On-the-fly symbolic evaluator for CTL automaton emptiness checking.
- * 
- * Instead of expanding transitions via expandMoveRevisited, this evaluator
- * interprets transitions symbolically during fixpoint computation.
+ *
+ * Instead of expanding transitions into moves, the evaluator interprets
+ * each transition's clauses directly: a state is good if every one of its
+ * transitions has a clause whose obligations are all good states. Blocks
+ * of the SCC DAG are evaluated successors first (__getTopologicalOrder()
+ * in reverse), each as a greatest fixpoint if it has an accepting state and
+ * as a least fixpoint otherwise, and the good states of a finished block
+ * are kept for every block above it. Guards are checked together: those
+ * every run has to satisfy at one tree node (the forced guards of a state
+ * and of the states its single-clause transitions demand at the same node),
+ * plus those of the clause considered. The work is linear in the size of
+ * the automaton, with one guard query per state and per clause of a
+ * transition with a choice.
+ *
+ * A block only reads its own states and those of its DAG successors, so
+ * evaluate(pool) runs every block whose successors are done on the pool at
+ * once; finishing a block releases the blocks above it.
+ *
+ * Judging states one at a time over-approximates non-emptiness: obligations
+ * different states put on the same child are not conjoined, so AG p & AF !p
+ * passes. The evaluator therefore only refutes; a good initial state says
+ * nothing, and CTLAutomaton::isEmpty() then decides by the emptiness game.
  */
 class SymbolicEvaluator {
 public:
-    SymbolicEvaluator(
-        const CTLAutomaton* automaton,
-        const std::vector<CTLStatePtr>& states,
-        const std::unordered_map<std::string_view, std::vector<CTLTransitionPtr>>& transitions,
-        const std::unordered_map<std::string_view, BinaryOperator>& state_operators,
-        const SCCBlocks* blocks,
-        const SMTInterface* smt_interface
-    );
+    explicit SymbolicEvaluator(const CTLAutomaton& automaton);
 
-    // Main evaluation entry point
-    bool evaluateState(
-        std::string_view state_name,
-        int current_block,
-        const std::unordered_set<std::string_view>& in_block_good,
-        const std::vector<std::unordered_set<std::string_view>>& good_states,
-        bool block_is_universal
-    ) const;
+    // False only if the automaton accepts no tree
+    bool mayBeNonEmpty();
+    // The state's verdict, evaluating the blocks it depends on first
+    bool isGood(StateId state);
+    // Evaluates every block, independent blocks concurrently on the pool.
+    // Must not be called from one of the pool's own tasks
+    void evaluate(WorkStealingPool& pool);
 
-private:
-    const CTLAutomaton* automaton_;
-    const std::vector<CTLStatePtr>& states_;
-    const std::unordered_map<std::string_view, std::vector<CTLTransitionPtr>>& transitions_;
-    const std::unordered_map<std::string_view, BinaryOperator>& state_operators_;
-    const SCCBlocks* blocks_;
-    const SMTInterface* smt_interface_;
-    
-    // Cache for state formulas
-    mutable std::unordered_map<std::string_view, CTLFormulaPtr> state_formula_cache_;
-
-    // Get formula for a state
-    const CTLFormula* getStateFormula(
-        std::string_view state_name
-    ) const;
+    size_t evaluatedBlocks() const { return evaluated_blocks_.load(std::memory_order_relaxed); }
 
-    // Evaluate a single disjunct (conjunction of obligations)
-    bool evaluateConjunct(
-        const Clause& conjunct,
-        const std::unordered_set<std::string>& guard_atoms,
-        int current_block,
-        const std::unordered_set<std::string_view>& in_block_good,
-        const std::vector<std::unordered_set<std::string_view>>& good_states,
-        bool block_is_universal
-    ) const;
-
-    // Check if an obligation is satisfied
-    bool isObligationSatisfied(
-        const Atom& obligation,
-        int current_block,
-        const std::unordered_set<std::string_view>& in_block_good,
-        const std::vector<std::unordered_set<std::string_view>>& good_states
-    ) const;
+private:
+    void __evaluateUpTo(int block);
+    void __evaluateBlock(int block);
+    bool __evaluateState(int block, StateId state);
+    bool __clauseHolds(int block, const ClauseView& clause);
+    bool __clauseViable(StateId state, const ClauseView& clause);
 
+    // Guards any run must satisfy wherever state is, sorted and unique
+    const std::vector<GuardTable::Id>& __forcedGuards(StateId state);
+    bool __forcedSatisfiable(StateId state);
 
+    const CTLAutomaton& automaton_;
+    std::vector<int> block_of_;                 // SCC block by state
+    std::vector<std::vector<StateId>> members_; // states by SCC block
+    std::vector<int> evaluation_order_;         // blocks, successors first
+    size_t next_block_ = 0;                     // position in evaluation_order_
+    // Written by the task of the state's (or block's) own block only and
+    // read by the blocks above it once it is done
+    std::vector<uint8_t> block_done_;
+    std::vector<uint8_t> good_;                 // valid once the state's block is done
+    std::atomic<size_t> evaluated_blocks_{0};
 
-    // Check if a set of atoms is satisfiable
-    bool isSatisfiable(
-        const std::unordered_set<std::string>& atoms
-    ) const;
+    // Filled when the state's block is evaluated, like good_
+    std::vector<uint8_t> forced_known_;
+    std::vector<std::vector<GuardTable::Id>> forced_;
+    std::vector<int8_t> forced_satisfiable_;    // -1 unknown
 };
 
 } // namespace ctl
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace ctl::trace {
+
+// One completed span; name and category are string literals
+struct Event {
+    const char* category;
+    const char* name;
+    int64_t start_ns;
+    int64_t duration_ns;
+};
+
+/**
+ * @brief Process-wide span recorder with one ring buffer per thread.
+ *
+ * Recording is a clock read and a store into the calling thread's own buffer:
+ * no lock and no allocation once the buffer exists. A full buffer overwrites
+ * its oldest spans. Buffers outlive their threads, so the spans of finished
+ * pool workers are still exported. Export after stop(), once the traced
+ * threads are done.
+ *
+ * Spans are placed with CTL_TRACE_SPAN, which compiles to nothing unless the
+ * build defines CTL_TRACING; with tracing compiled in but not started a span
+ * costs one relaxed load.
+ */
+class Tracer {
+public:
+    static Tracer& instance();
+
+    // Clears earlier spans and starts recording, keeping up to
+    // events_per_thread spans per thread
+    void start(size_t events_per_thread = 1 << 16);
+    void stop() { enabled_.store(false, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    void record(const char* category, const char* name, int64_t start_ns, int64_t end_ns);
+
+    // Chrome trace event JSON, readable by chrome://tracing and Perfetto
+    void writeChromeTrace(std::ostream& out) const;
+    size_t eventCount() const;
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    Tracer() = default;
+
+    struct ThreadBuffer {
+        std::vector<Event> ring;
+        uint64_t written = 0;  // total spans recorded, the ring keeps the last ring.size()
+        uint32_t tid;
+    };
+    ThreadBuffer& __local();
+
+    std::atomic<bool> enabled_{false};
+    size_t capacity_ = 1 << 16;
+    int64_t origin_ns_ = 0;
+    mutable std::mutex mutex_;  // guards buffers_
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+// Records the enclosing scope as one span if tracing was enabled when it began
+class Span {
+public:
+    Span(const char* category, const char* name)
+        : category_(category), name_(name), start_ns_(Tracer::instance().enabled() ? Tracer::now() : -1) {}
+    ~Span() {
+        if (start_ns_ >= 0) Tracer::instance().record(category_, name_, start_ns_, Tracer::now());
+    }
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* category_;
+    const char* name_;
+    int64_t start_ns_;
+};
+
+} // namespace ctl::trace
+
+#define CTL_TRACE_CONCAT_INNER(a, b) a##b
+#define CTL_TRACE_CONCAT(a, b) CTL_TRACE_CONCAT_INNER(a, b)
+#ifdef CTL_TRACING
+#define CTL_TRACE_SPAN(category, name) \
+    ::ctl::trace::Span CTL_TRACE_CONCAT(ctl_trace_span_, __LINE__)(category, name)
+#else
+#define CTL_TRACE_SPAN(category, name) static_cast<void>(0)
+#endif
@@ -5,13 +5,87 @@
 #include <set>
 #include <iostream>
 #include <memory>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <span>
+#include "guard_table.h"
+#include "small_vector.h"
 
 namespace ctl {
 
-struct Literal { int dir; std::string_view qnext; };    // (dir, q')
+// Dense automaton state index: position of the state in CTLAutomaton's state vector
+using StateId = uint32_t;
+constexpr StateId INVALID_STATE_ID = std::numeric_limits<StateId>::max();
+
+struct Literal { int dir; std::string_view qnext; StateId qid = INVALID_STATE_ID; };    // (dir, q'), qid filled after build
 struct Clause {  std::vector<Literal> literals; };       // ∧ of literals
+struct ClauseView { std::span<Literal> literals; };      // Clause stored in an automaton's arena
 using FromToPair = std::pair<std::string_view, std::string_view>;
 
+// Child obligation of a move: state must hold at the child in direction dir.
+// Two 32-bit fields without padding, so moves compare bytewise.
+struct MoveSuccessor {
+    int32_t dir;
+    StateId state;
+
+    bool operator==(const MoveSuccessor& o) const { return dir == o.dir && state == o.state; }
+    bool operator<(const MoveSuccessor& o) const { return dir != o.dir ? dir < o.dir : state < o.state; }
+};
+
+// One DNF choice of a state: the guards (GuardTable ids) the node label must
+// satisfy and the obligations of its children. Both sequences are sorted and
+// free of duplicates, so equal moves have equal bytes.
+struct Move {
+    SmallVector<GuardTable::Id, 4> atoms;
+    SmallVector<MoveSuccessor, 4> next_states;
+
+    // Insert keeping the order; false if already present
+    bool addAtom(GuardTable::Id id) { return __insertSorted(atoms, id); }
+    bool addNextState(int32_t dir, StateId state) { return __insertSorted(next_states, MoveSuccessor{dir, state}); }
+
+    bool operator==(const Move& o) const noexcept {
+        return atoms == o.atoms && next_states == o.next_states;
+    }
+
+    // Every tree node o accepts, this move accepts as well: o asks for at
+    // least the same guards and child obligations, so o is redundant next to it
+    bool subsumes(const Move& o) const {
+        return std::includes(o.atoms.begin(), o.atoms.end(), atoms.begin(), atoms.end()) &&
+               std::includes(o.next_states.begin(), o.next_states.end(), next_states.begin(), next_states.end());
+    }
+
+    size_t hash() const noexcept {
+        size_t h = 1469598103934665603u;
+        for (GuardTable::Id a : atoms) h = (h ^ a) * 1099511628211u;
+        h = (h ^ 0xffffffffu) * 1099511628211u;  // separates atoms from successors
+        for (const auto& s : next_states) h = (h ^ ((uint64_t(uint32_t(s.dir)) << 32) | s.state)) * 1099511628211u;
+        return h;
+    }
+
+    std::string toString() const {
+        std::string result = "Atoms: { ";
+        for (GuardTable::Id atom : atoms) {
+            result += GuardTable::instance().text(atom) + " ";
+        }
+        result += "} | Next States: { ";
+        for (const auto& s : next_states) {
+            result += "(" + std::to_string(s.dir) + ", " + std::to_string(s.state) + ") ";
+        }
+        result += "}";
+        return result;
+    }
+
+private:
+    template <typename Seq, typename T>
+    static bool __insertSorted(Seq& seq, const T& value) {
+        auto it = std::lower_bound(seq.begin(), seq.end(), value);
+        if (it != seq.end() && *it == value) return false;
+        seq.insert(it, value);
+        return true;
+    }
+};
+
 
 
 
@@ -24,14 +98,17 @@ using sat_expr = cvc5::Term;
 
 
 
+// Guard on the node label, hash-consed in the GuardTable: equality and the
+// constant checks compare ids, the text is only needed for printing and SMT
 struct Guard{
     std::string pretty_string;
     void* sat_expr;
-    Guard() {
-        pretty_string= "";
-        sat_expr= NULL;
-    }
-    Guard(const std::string& ps) : pretty_string(ps) {sat_expr= NULL; }
+    GuardTable::Id id;
+    Guard() : sat_expr(NULL), id(GuardTable::TRUE_ID) {}
+    Guard(const std::string& ps)
+        : pretty_string(ps), sat_expr(NULL), id(GuardTable::instance().intern(ps)) {}
+    bool isTrue() const { return id == GuardTable::TRUE_ID; }
+    bool isFalse() const { return id == GuardTable::FALSE_ID; }
     std::string toString() const {
         return pretty_string;
     }
@@ -42,7 +119,7 @@ struct Guard{
 
 // overload == operator for Guard
 inline bool operator==(const Guard& a, const Guard& b) {
-    return std::hash<std::string>{}(a.pretty_string) == std::hash<std::string>{}(b.pretty_string);
+    return a.id == b.id;
 }
 
 
@@ -61,13 +138,29 @@ inline std::string operator+(const std::string& s, const Guard& g) {
 struct CTLTransition { 
         Guard guard; 
         std::string_view from;
-        std::vector<Clause> clauses;
+        std::span<ClauseView> clauses;   // views into the owning automaton's arena
         bool is_dnf; // guard ∧ (∨ Clause) or // guard ∧ (∧ Disj) if CNF
         CTLTransition() = default;
+
+        // Owning copy of the clauses, for consumers that outlive the automaton
+        std::vector<Clause> copyClauses() const {
+            std::vector<Clause> out;
+            out.reserve(clauses.size());
+            for (const auto& c : clauses) out.push_back(Clause{ { c.literals.begin(), c.literals.end() } });
+            return out;
+        }
 }; 
 
 
 
-using CTLTransitionPtr = std::shared_ptr<CTLTransition>;
+// Non-owning: transitions live in the arena of the automaton that built them
+using CTLTransitionPtr = CTLTransition*;
 
-}
\ No newline at end of file
+}
+
+namespace std {
+    template<>
+    struct hash<ctl::Move> {
+        size_t operator()(ctl::Move const& m) const noexcept { return m.hash(); }
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "guard_table.h"
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ctl {
+
+class CTLFormula;
+
+/**
+ * @brief Propositional guards over few atoms decided by truth tables.
+ *
+ * A query over n <= kMaxAtoms distinct Boolean atoms is decided by
+ * evaluating every guard on all 2^n valuations at once: valuations are bits
+ * of max(1, 2^n / 64) words, so a guard is a handful of word-wise and/or/not
+ * passes that the compiler vectorizes. Each guard is compiled once into a
+ * postfix program over its own atoms; a query maps them into the union of
+ * the supports. A guard with a comparison is not propositional, and a query
+ * involving one, or spanning more atoms, is left to the SMT solver.
+ */
+class TruthTableKernel {
+public:
+    static constexpr size_t kMaxAtoms = 16;
+
+    // A guard as a postfix program over its atoms, sorted by name
+    struct Program {
+        enum class Op : uint8_t { ATOM, TRUE, FALSE, NOT, AND, OR };
+        struct Instruction {
+            Op op;
+            uint16_t atom = 0;  // index into atoms for ATOM
+        };
+        std::vector<std::string> atoms;
+        std::vector<Instruction> code;
+        size_t depth = 0;  // stack slots evaluation needs
+    };
+
+    static TruthTableKernel& instance();
+
+    // Program of the guard, compiled once; null if it is not propositional or too wide
+    const Program* lookup(GuardTable::Id guard);
+    // Program of a guard formula, none if it is not propositional or too wide
+    static std::optional<Program> compile(const CTLFormula& guard);
+
+    // Whether the guards can hold together; none if the kernel cannot tell
+    std::optional<bool> satisfiable(std::span<const GuardTable::Id> guards);
+    // Whether the premise guards imply every conclusion guard; none if the kernel cannot tell
+    std::optional<bool> entails(std::span<const GuardTable::Id> premise, std::span<const GuardTable::Id> conclusion);
+
+private:
+    TruthTableKernel() = default;
+
+    mutable std::mutex mutex_;
+    // By guard id; entries are never removed, so the pointers handed out stay valid
+    std::unordered_map<GuardTable::Id, std::optional<Program>> programs_;
+};
+
+} // namespace ctl
@@ -103,13 +103,13 @@ enum class TokenType {
     INVALID
 };
 
-// Token structure
+// Token structure; value views the lexer's input, which must outlive the token
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value;
     size_t position;
     
-    Token(TokenType t, const std::string& v, size_t pos) 
+    Token(TokenType t, std::string_view v, size_t pos) 
         : type(t), value(v), position(pos) {}
 };
 
@@ -170,7 +170,8 @@ struct CTLState {
 
 
 
-using CTLStatePtr = std::shared_ptr<CTLState>;
+// Non-owning: states live in the arena of the automaton that built them
+using CTLStatePtr = CTLState*;
 
 
 
@@ -207,74 +208,59 @@ enum class SCCBlockType {
     // Hash function for SimPair
     struct SimPairHash {
         std::size_t operator()(const SimPair& p) const {
-            auto a = std::hash<std::string>{}(
-                std::string(p.q_phi) + ""
-            );
-            auto b = std::hash<std::string>{}(
-                std::string(p.q_phi_prime) + ""
-            );
+            auto a = std::hash<std::string_view>{}(p.q_phi);
+            auto b = std::hash<std::string_view>{}(p.q_phi_prime);
             return a ^ (b << 1);
         }
     };
 
-    // Represent a move in Python-style: (atoms, next_states)
-    // atoms: set of atomic propositions that must hold
-    // next_states: set of (direction, state) pairs for temporal requirements
-    struct DirectionStatePair {
-        int dir;
-        std::string_view state;
-        
-        bool operator==(const DirectionStatePair& other) const {
-            return dir == other.dir && state == other.state;
-        }
-    };
-    
-    struct DirectionStatePairHash {
-        std::size_t operator()(const DirectionStatePair& p) const {
-            return std::hash<int>{}(p.dir) ^ (std::hash<std::string_view>{}(p.state) << 1);
-        }
-    };
 
-    struct Move {
-        std::unordered_set<std::string> atoms;
-        std::unordered_set<DirectionStatePair, DirectionStatePairHash> next_states;
-        
-        // Default constructor
-        Move() = default;
-        
-        // Move constructor and assignment
-        Move(Move&&) = default;
-        Move& operator=(Move&&) = default;
-        
-        // Copy constructor and assignment
-        Move(const Move&) = default;
-        Move& operator=(const Move&) = default;
+// Outcome of one satisfiability query. A refinement check phi1 -> phi2 is
+// answered by the query phi1 & !phi2, so UNSAT there means "refines".
+enum class SatVerdict {
+    SAT,
+    UNSAT,
+    TIMEOUT,  // the external solver exceeded its time limit and was killed
+    ERROR     // the solver crashed, ran out of memory or printed unexpected output
+};
 
-        bool operator==(const Move& o) const noexcept {
-            return atoms == o.atoms && next_states == o.next_states;
-        }
+inline std::string SatVerdictToString(SatVerdict verdict) {
+    switch (verdict) {
+        case SatVerdict::SAT: return "SAT";
+        case SatVerdict::UNSAT: return "UNSAT";
+        case SatVerdict::TIMEOUT: return "TIMEOUT";
+        case SatVerdict::ERROR: return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
 
-        std::string toString() const {
-            std::string result = "Atoms: { ";
-            for (const auto& atom : atoms) {
-                result += atom + " ";
-            }
-            result += "} | Next States: { ";
-            for (const auto& pair : next_states) {
-                result += "(" + std::to_string(pair.dir) + ", " + std::string(pair.state) + ") ";
-            }
-            result += "}";
-            return result;
-        }
-    };
+// How languageIncludes decides emptiness of L(other) ∩ L(¬this)
+enum class EmptinessEngine {
+    FIXPOINT,    // build the combined automaton and solve its parity game
+    ON_THE_FLY,  // prove inclusion on the pair product B x ¬A, confirm witnesses by FIXPOINT
+    ANTICHAIN,   // macro-state game on B x ¬A, simulation-pruned, stops at the first finite counterexample
+    AUTO         // pick FIXPOINT or ON_THE_FLY per pair from automaton size and blocks
+};
 
+inline std::string EmptinessEngineToString(EmptinessEngine engine) {
+    switch (engine) {
+        case EmptinessEngine::FIXPOINT: return "fixpoint";
+        case EmptinessEngine::ON_THE_FLY: return "otf";
+        case EmptinessEngine::ANTICHAIN: return "antichain";
+        case EmptinessEngine::AUTO: return "auto";
+        default: return "UNKNOWN";
+    }
+}
 
 struct PropertyResult {
     bool passed;
     std::chrono::milliseconds time_taken;
     size_t property1_index;
     size_t property2_index;
-    size_t memory_used_kb = 0;  // Memory delta during this check
+    size_t memory_used_kb = 0;  // Heap retained by the checking thread, see memory_utils::AllocationScope
+    SatVerdict verdict = SatVerdict::SAT;
+    std::chrono::microseconds latency{0};  // time_taken at microsecond resolution, for percentiles
+    bool exact = false;  // a failed check is a proof of non-refinement, not only "not proven"
 };
 
 
@@ -286,6 +272,10 @@ struct TransitiveOptimizationStats {
     double optimization_ratio = 0.0;
     size_t total_eliminated = 0;
     size_t total_before_optimization = 0;
+    size_t implied_pairs = 0;   // skipped because the positive closure implied them
+    size_t refuted_pairs = 0;   // skipped because a non-refinement implied their refutation
+    size_t condensed_pairs = 0; // skipped because both sides were condensed into one property
+    size_t condensed_properties = 0;  // properties merged into an equivalent representative
 };
 
 
@@ -325,16 +315,3 @@ enum class ComparisonOp {
 
 
 } // namespace ctl
-
-
-namespace std {
-    template<>
-    struct hash<ctl::Move> {
-        size_t operator()(ctl::Move const& m) const noexcept {
-            size_t h = 1469598103934665603u;
-            for (auto &a : m.atoms) h ^= std::hash<std::string>{}(a) + 0x9e3779b97f4a7c15 + (h<<6) + (h>>2);
-            for (auto &p : m.next_states) h ^= std::hash<long long>{}(((long long)p.dir<<32) ^ std::hash<std::string>{}(std::string(p.state)));
-            return h;
-        }
-    };
-}
\ No newline at end of file
@@ -1,28 +1,31 @@
 # pragma once
 
-#include "property.h"
-#include "refinement_graph.h"
-
+#include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <unordered_map>
-#include <thread>
-#include <future>
-#include <functional>
 
 
 namespace ctl {
 
-// Union-Find data structure for equivalence classes
+// Union-Find over the dense indices 0..size()-1, with union by rank and path
+// halving. find() on an index past the end adds it (and those before it) as
+// singletons.
 class UnionFind {
 private:
-    mutable std::unordered_map<size_t, size_t> parent_;
-    std::unordered_map<size_t, size_t> rank_;
+    mutable std::vector<size_t> parent_;
+    mutable std::vector<uint8_t> rank_;
+
+    void __grow(size_t size) const;
     
 public:
+    explicit UnionFind(size_t size = 0);
+
+    size_t size() const { return parent_.size(); }
     size_t find(size_t x) const;
     void unite(size_t x, size_t y);
     bool connected(size_t x, size_t y) const;
+    // Every class, members ascending, classes by their smallest member
     std::vector<std::vector<size_t>> getEquivalenceClasses() const;
 };
 
-} // namespace ctl
\ No newline at end of file
+} // namespace ctl
@@ -4,6 +4,7 @@
 #include <dirent.h>
 #include <algorithm>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <iostream>
 #include <vector>
@@ -22,6 +23,23 @@ bool createDirectory(const std::string& path);
 // Helper function to get all .txt files in a directory
 std::vector<std::string> getTextFilesInDirectory(const std::string& dir_path);
 
+// Read-only memory map of a whole file; contents() is valid until destruction
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename);  // throws std::runtime_error
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view contents() const { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Trimmed non-empty lines of a property file that are not comments ('#' or '/')
+std::vector<std::string_view> splitPropertyLines(std::string_view contents);
 std::vector<std::string> loadPropertiesFromFile(const std::string& filename);
 std::string joinPaths(const std::string& path1, const std::string& path2);
 std::vector<std::string> getSubdirectoriesInDirectory(const std::string& dir_path);
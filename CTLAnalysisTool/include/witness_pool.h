@@ -0,0 +1,101 @@
+#pragma once
+
+#include "property.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief A finite model found by an emptiness game, kept to refute other pairs.
+ *
+ * A Kripke structure over binary branching: every state has a left and a
+ * right successor, either another state or kUnconstrained, a subtree the
+ * game left open. A state's label is the set of guards its node had to
+ * satisfy; any valuation satisfying them all will do. State 0 is initial.
+ */
+struct Witness {
+    static constexpr uint32_t kUnconstrained = std::numeric_limits<uint32_t>::max();
+
+    struct State {
+        std::vector<std::string> guards;
+        uint32_t left = kUnconstrained;
+        uint32_t right = kUnconstrained;
+    };
+    std::vector<State> states;
+};
+
+/**
+ * @brief Collects the witnesses of the non-empty emptiness games run on the
+ * calling thread while it is alive, like a CancellationScope for tokens.
+ *
+ * Games only record node labels while a capture is active, so checks that
+ * keep no witnesses pay nothing for them. Captures nest; the innermost one
+ * receives the witnesses.
+ */
+class WitnessCapture {
+public:
+    WitnessCapture() : previous_(current_) { current_ = this; }
+    ~WitnessCapture() { current_ = previous_; }
+    WitnessCapture(const WitnessCapture&) = delete;
+    WitnessCapture& operator=(const WitnessCapture&) = delete;
+
+    // The capture of the calling thread, if any
+    static WitnessCapture* current() { return current_; }
+    void add(Witness witness) { witnesses_.push_back(std::move(witness)); }
+    std::vector<Witness> take() { return std::move(witnesses_); }
+
+private:
+    static inline thread_local WitnessCapture* current_ = nullptr;
+    WitnessCapture* previous_;
+    std::vector<Witness> witnesses_;
+};
+
+/**
+ * @brief The witnesses of one class, model checked against its later pairs.
+ *
+ * A witness refutes phi1 -> phi2 if phi1 holds and phi2 fails at its initial
+ * state under every valuation its labels admit. Both are decided by a
+ * three-valued CTL check: a subformula without temporal operators is
+ * definitely true (false) at a state whose guards entail it (its negation),
+ * open otherwise, and open everywhere in an unconstrained subtree. The
+ * definitely true and definitely false states of a formula are the usual
+ * fixpoints over those, which only grow as more of them are decided, so a
+ * definite answer holds in every completion. The verdict therefore does not
+ * depend on the game the witness came from, and a witness found for one pair
+ * is sound for any pair of the class.
+ *
+ * Each witness keeps the verdict of every property checked against it.
+ * Bounded temporal operators are left open. Thread-safe.
+ */
+class WitnessPool {
+public:
+    static constexpr size_t kDefaultCapacity = 32;
+
+    explicit WitnessPool(size_t capacity = kDefaultCapacity) : capacity_(capacity) {}
+
+    // Keeps the witness unless it has it already; beyond capacity the oldest
+    // one is dropped. False if it was not kept
+    bool add(Witness witness);
+    // A kept witness satisfies refining and falsifies refined
+    bool refutes(const CTLProperty& refining, const CTLProperty& refined);
+    size_t size() const;
+
+private:
+    struct Entry;
+
+    size_t capacity_;
+    mutable std::shared_mutex mutex_;
+    std::vector<std::shared_ptr<Entry>> entries_;  // oldest first
+    std::unordered_set<std::string> keys_;         // of entries_
+};
+
+} // namespace ctl
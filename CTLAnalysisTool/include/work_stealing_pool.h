@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ctl {
+
+/**
+ * @brief Fixed-size thread pool with one task deque per worker.
+ *
+ * Workers pop from the front of their own deque and, when it runs dry,
+ * steal from the back of the other workers' deques. Threads are created
+ * once and reused for every batch of tasks until the pool is destroyed,
+ * so many small batches (e.g. one per equivalence class) do not pay for
+ * thread start-up and do not leave cores idle behind a slow stripe.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void(size_t /*worker_id*/)>;
+
+    explicit WorkStealingPool(size_t num_threads = std::thread::hardware_concurrency());
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * @brief Enqueues a task. Tasks are spread round-robin over the worker deques.
+     * The task receives the id of the worker executing it, in [0, size()).
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Blocks until every submitted task has finished.
+     * Rethrows the first exception thrown by a task, if any.
+     */
+    void wait();
+
+    size_t size() const { return workers_.size(); }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void __workerLoop(size_t worker_id);
+    bool __popLocal(size_t worker_id, Task& task);
+    bool __steal(size_t thief_id, Task& task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex state_mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+    std::atomic<size_t> queued_{0};
+    size_t pending_ = 0;             // submitted but not yet finished, guarded by state_mutex_
+    size_t next_queue_ = 0;          // round-robin cursor, guarded by state_mutex_
+    bool stopping_ = false;
+    std::exception_ptr first_error_;
+};
+
+} // namespace ctl
@@ -23,8 +23,12 @@ void printUsage(const char* program_name) {
     std::cout << "  -j, --threads <n>    Number of threads to use\n";
     std::cout << "  -v, --verbose        Verbose output\n";
     std::cout << "  --no-parallel        Disable parallel analysis\n";
+    std::cout << "  --no-dedup           Check duplicate properties separately instead of merging equal formulas\n";
     std::cout << "  --use-extern-sat <interface>  Specify which external SAT interface to use (CTLSAT, MOMOCTL, MLSOLVER)\n";
     std::cout << "  --sat-path <path>      Specify the path to the external SAT solver\n";
+    std::cout << "  --sat-workers <n>    Maximum number of concurrent external solver processes (default: threads)\n";
+    std::cout << "  --sat-timeout <s>    Kill an external solver query after <s> seconds (default: no limit)\n";
+    std::cout << "  --sat-memory <mb>    Limit the address space of each external solver process (default: no limit)\n";
     std::cout << "\n";
     std::cout << "Input can be either a .txt file or a folder containing .txt files.\n";
     std::cout << "If a folder is provided, all .txt files will be processed.\n";
@@ -42,7 +46,11 @@ int main(int argc, char* argv[]) {
     std::string output_dir = "output";
     bool use_parallel = false;  
     size_t num_threads = std::thread::hardware_concurrency();
+    size_t sat_workers = 0;      // 0: one solver process per analysis thread
+    size_t sat_timeout_s = 0;    // 0: no per-query limit
+    size_t sat_memory_mb = 0;    // 0: no per-query limit
     bool verbose = false;
+    bool use_dedup = true;
     ctl::AvailableCTLSATInterfaces sat_interface = ctl::AvailableCTLSATInterfaces::NONE;
     bool use_extern_sat = false;
     std::string sat_path = "";
@@ -63,6 +71,8 @@ int main(int argc, char* argv[]) {
             }
         } else if (arg == "-p" || arg == "--parallel") {
             use_parallel = true;
+        } else if (arg == "--no-dedup") {
+            use_dedup = false;
         } else if (arg == "--no-parallel") {
             use_parallel = false;
         } else if (arg == "-j" || arg == "--threads") {
@@ -90,6 +100,16 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Error: --sat-interface option requires an argument\n";
                 return 1;
             }
+        } else if (arg == "--sat-workers" || arg == "--sat-timeout" || arg == "--sat-memory") {
+            if (i + 1 < argc) {
+                size_t value = std::stoul(argv[++i]);
+                if (arg == "--sat-workers") sat_workers = value;
+                else if (arg == "--sat-timeout") sat_timeout_s = value;
+                else sat_memory_mb = value;
+            } else {
+                std::cerr << "Error: " << arg << " option requires an argument\n";
+                return 1;
+            }
         }else if (arg == "--sat-path") {
             if (i + 1 < argc) {
                 sat_path = argv[++i];
@@ -212,21 +232,16 @@ int main(int argc, char* argv[]) {
             }
             // Configure analyzer
             analyzer.setParallelAnalysis(use_parallel);
+            analyzer.setDeduplication(use_dedup);
             analyzer.setThreads(num_threads);
 
             if (use_extern_sat) {
                 analyzer.setExternalSATInterface(sat_interface, sat_path);
+                analyzer.setExternalSATLimits(sat_workers ? sat_workers : num_threads,
+                                              std::chrono::seconds(sat_timeout_s),
+                                              sat_memory_mb * 1024 * 1024);
             }
             analyzer.setVerbose(verbose);
-            // Perform analysis
-            auto result = analyzer.analyze();
-            auto end_time = std::chrono::high_resolution_clock::now();
-            auto total_duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-            // Output results
-            if (verbose) {
-                std::cout << "Analysis completed in " << total_duration.count() << " ms\n";
-                std::cout << "- Unsatisfiable properties: " << result.false_properties << "\n";
-            }
             // Create subdirectory for this file if processing multiple files
             std::string file_output_dir = output_dir;
             if (input_files.size() > 1) {
@@ -253,8 +268,19 @@ int main(int argc, char* argv[]) {
                     }
                 }
             }
-            std::string info_per_property_file = file_output_dir + "/info_per_property.csv";
-            analyzer.writeInfoPerProperty(info_per_property_file);
+            // Per-property verdicts are written as they complete
+            analyzer.setResultStream(file_output_dir + "/info_per_property.csv");
+            // Perform analysis
+            auto result = analyzer.analyze();
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto total_duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+            // Output results
+            if (verbose) {
+                std::cout << "Analysis completed in " << total_duration.count() << " ms\n";
+                std::cout << "- Unsatisfiable properties: " << result.false_properties << "\n";
+                std::cout << "- Guard SAT cache: " << result.guard_cache_hits << " hits, "
+                          << result.guard_cache_misses << " misses\n";
+            }
             std::string false_props_file = file_output_dir + "/false_properties.txt";
             analyzer.writeEmptyProperties(false_props_file);   
             
@@ -0,0 +1,132 @@
+#include "SMTInterfaces/BDDSMTInterface.h"
+#include "formula.h"
+#include "parser.h"
+
+namespace ctl {
+
+namespace {
+    // Same atom syntax the Z3 lowering treats as a Boolean constant
+    bool isIdentifier(const std::string& s) {
+        if (s.empty()) return false;
+        for (char ch : s) {
+            if (!std::isalnum(static_cast<unsigned char>(ch)) && ch != '_' && ch != '.') return false;
+        }
+        return true;
+    }
+}
+
+BDDSMTInterface::BDDSMTInterface(std::unique_ptr<SMTInterface> fallback)
+    : owned_fallback_(std::move(fallback)), fallback_(owned_fallback_.get()) {
+}
+
+BDDSMTInterface::BDDSMTInterface(SMTInterface& fallback)
+    : fallback_(&fallback) {
+}
+
+std::unique_ptr<SMTInterface> BDDSMTInterface::clone() const {
+    return std::make_unique<BDDSMTInterface>(fallback_->clone());
+}
+
+bool BDDSMTInterface::isSatisfiable(const std::string& formula, bool without_parsing) const {
+    if (formula == "true") return true;
+    if (formula.empty() || formula == "false") return false;
+    return isSatisfiable(std::unordered_set<std::string>{formula}, without_parsing);
+}
+
+bool BDDSMTInterface::isSatisfiable(const std::unordered_set<std::string>& formulas, bool without_parsing) const {
+    if (without_parsing) {
+        ++fallback_queries_;
+        return fallback_->isSatisfiable(formulas, without_parsing);
+    }
+    BddManager::Node conjunction = BddManager::TRUE_NODE;
+    bool arithmetic = false;
+    for (const auto& formula : formulas) {
+        if (formula == "true" || formula.empty()) continue;
+        auto node = toBdd(formula);
+        if (!node) {
+            arithmetic = true;
+            continue;
+        }
+        conjunction = manager_.conj(conjunction, *node);
+        if (conjunction == BddManager::FALSE_NODE) break;
+    }
+    // An unsatisfiable propositional part decides the whole conjunction
+    if (!arithmetic || conjunction == BddManager::FALSE_NODE) {
+        ++bdd_queries_;
+        return conjunction != BddManager::FALSE_NODE;
+    }
+    ++fallback_queries_;
+    return fallback_->isSatisfiable(formulas, without_parsing);
+}
+
+std::optional<bool> BDDSMTInterface::entails(const std::string& a, const std::string& b) const {
+    auto na = toBdd(a), nb = toBdd(b);
+    if (!na || !nb) return std::nullopt;
+    return manager_.implies(*na, *nb);
+}
+
+std::optional<bool> BDDSMTInterface::equivalent(const std::string& a, const std::string& b) const {
+    auto na = toBdd(a), nb = toBdd(b);
+    if (!na || !nb) return std::nullopt;
+    return *na == *nb;
+}
+
+std::optional<BddManager::Node> BDDSMTInterface::toBdd(const std::string& formula) const {
+    auto it = bdd_cache_.find(formula);
+    if (it != bdd_cache_.end()) return it->second;
+
+    std::optional<BddManager::Node> node;
+    if (formula.empty() || formula == "true") {
+        node = BddManager::TRUE_NODE;
+    } else if (formula == "false") {
+        node = BddManager::FALSE_NODE;
+    } else {
+        try {
+            node = __lower(*Parser::parseFormula(formula));
+        } catch (const std::exception&) {
+            node = std::nullopt;  // the SMT string parser still gets a chance
+        }
+    }
+    return bdd_cache_.emplace(formula, node).first->second;
+}
+
+std::optional<BddManager::Node> BDDSMTInterface::__lower(const CTLFormula& formula) const {
+    switch (formula.getType()) {
+        case FormulaType::BOOLEAN_LITERAL:
+            return static_cast<const BooleanLiteral&>(formula).value ? BddManager::TRUE_NODE : BddManager::FALSE_NODE;
+
+        case FormulaType::ATOMIC: {
+            const auto& prop = static_cast<const AtomicFormula&>(formula).proposition;
+            if (prop == "true" || prop == "1")  return BddManager::TRUE_NODE;
+            if (prop == "false" || prop == "0") return BddManager::FALSE_NODE;
+            if (isIdentifier(prop)) return manager_.variable(prop);
+            return std::nullopt;
+        }
+
+        case FormulaType::NEGATION: {
+            auto operand = __lower(*static_cast<const NegationFormula&>(formula).operand);
+            if (!operand) return std::nullopt;
+            return manager_.negate(*operand);
+        }
+
+        case FormulaType::BINARY: {
+            const auto& bin = static_cast<const BinaryFormula&>(formula);
+            auto l = __lower(*bin.left);
+            if (!l) return std::nullopt;
+            auto r = __lower(*bin.right);
+            if (!r) return std::nullopt;
+            switch (bin.operator_) {
+                case BinaryOperator::AND:     return manager_.conj(*l, *r);
+                case BinaryOperator::OR:      return manager_.disj(*l, *r);
+                case BinaryOperator::IMPLIES: return manager_.disj(manager_.negate(*l), *r);
+                default:                      return std::nullopt;
+            }
+        }
+
+        default:
+            // Comparisons need arithmetic; temporal operators never occur in guards
+            return std::nullopt;
+    }
+}
+
+} // namespace ctl
@@ -1,447 +1,584 @@
-
 #include "CTLautomaton.h"
 #include "formula.h"
-#include <queue>
+#include "statistics.h"
+#include "log.h"
+#include "cancellation.h"
+#include "symbolic_evaluator.h"
+#include "work_stealing_pool.h"
+#include "witness_pool.h"
 #include <algorithm>
 #include <iostream>
+#include <map>
+#include <queue>
+#include <set>
+#include <tuple>
 
 namespace ctl {
 
-    
-    bool CTLAutomaton::isEmpty() const {
-        throw std::runtime_error("isEmpty() not implemented yet");
-    }
+    namespace {
 
-    // ==================== Helper Functions for Formula Manipulation ====================
-    
-    Guard CTLAutomaton::makeTrue() const {
-        Guard g;
-        g.pretty_string = "true";
-        g.sat_expr = (void*)smt_interface_->getTrue();
-        return g;
-    }
-    
-    Guard CTLAutomaton::makeFalse() const {
-        Guard g;
-        g.pretty_string = "false";
-        g.sat_expr = (void*)smt_interface_->getFalse();
-        return g;
-    }
-    
-    Guard CTLAutomaton::makeOr(const Guard& left, const Guard& right) const {
-        // Simplifications
-        if (isEquivalentToTrue(left)) return left;
-        if (isEquivalentToTrue(right)) return right;
-        if (isEquivalentToFalse(left)) return right;
-        if (isEquivalentToFalse(right)) return left;
-        Guard g;
-        g.pretty_string = "(" + left.pretty_string + " | " + right.pretty_string + ")";
-        g.sat_expr = smt_interface_->makeOr(left.sat_expr, right.sat_expr);
-        return g;
-    }
-    
-    Guard CTLAutomaton::makeAnd(const Guard& left, const Guard& right) const {
-
-        // Simplifications
-        if (isEquivalentToFalse(left)) return left;
-        if (isEquivalentToFalse(right)) return right;
-        if (isEquivalentToTrue(left)) return right;
-        if (isEquivalentToTrue(right)) return left;
-        
-        Guard g;
-        g.pretty_string = "(" + left.pretty_string + " & " + right.pretty_string + ")";
-        g.sat_expr = smt_interface_->makeAnd(left.sat_expr, right.sat_expr);
-        return g;
-    }
-    
-    bool CTLAutomaton::isEquivalentToTrue(const Guard& g) const {
-        return std::hash<std::string>{}(g.pretty_string) == TRUE_HASH; 
-    }
-    
-    bool CTLAutomaton::isEquivalentToFalse(const Guard& g) const {
-         return std::hash<std::string>{}(g.pretty_string) == TRUE_HASH; 
-    }
-
-    
-    bool CTLAutomaton::winningRegionsEqual(const WinningRegion& a, const WinningRegion& b) const {
-        if (a.size() != b.size()) return false;
-        
-        for (const auto& [state, g_a] : a) {
-            auto it = b.find(state);
-            if (it == b.end()) return false;
-            
-            // Compare formulas (simplified comparison)
-            const auto& g_b = it->second;
-            if (!(g_a==g_b)) return false;
+    // States of one or more automata that play together at the same tree
+    // nodes, numbered consecutively: automaton k owns [base_k, base_k + n_k).
+    // Next to a state q, a state r of the same automaton with L(q) ⊆ L(r)
+    // (read off the automaton's self-simulation) adds nothing.
+    class GameArena {
+    public:
+        void add(const CTLAutomaton& automaton, const BitMatrix* implied = nullptr) {
+            parts_.push_back({&automaton, static_cast<StateId>(owner_.size()), implied});
+            owner_.resize(owner_.size() + automaton.numStates(), static_cast<uint32_t>(parts_.size() - 1));
         }
-        return true;
-    }
 
-    // ==================== Core Algorithm: Symbolic Predecessor ====================
-    
-    // Evaluate a single clause: conjunction of (direction, next_state) pairs
-    Guard CTLAutomaton::evaluateClause(const Clause& clause, const WinningRegion& target_region) const {
-        Guard result = makeTrue();
-        std::cout << "    Evaluating clause with " << clause.literals.size() << " literals" << std::endl;
-        // A clause is a conjunction: (dir1, q1) ∧ (dir2, q2) ∧ ...
-        for (const auto& literal : clause.literals) {
-            std::string_view next_state = literal.qnext;
-            
-            // Get the winning formula for the next state from the target region
-            auto it = target_region.find(next_state);
-            Guard next_formula = (it != target_region.end()) ? it->second : makeFalse();
-            
-            // Conjoin with the result
-            result = makeAnd(result, next_formula);
+        size_t parts() const { return parts_.size(); }
+        StateId initial(size_t k) const {
+            const StateId init = parts_[k].automaton->getInitialStateId();
+            return init == INVALID_STATE_ID ? INVALID_STATE_ID : parts_[k].base + init;
         }
-
-        
-        return result;
-    }
-    
-    // Evaluate a transition edge: guard ∧ (clause1 ∨ clause2 ∨ ...)
-    Guard CTLAutomaton::evaluateRule(const SymbolicGameEdge& edge, const WinningRegion& target_region) const {
-        // Parse the guard into a formula
-        Guard guard;
-        std::cout << "Evaluating rule with guard: " << edge.symbol.toString() << std::endl;
-        if (edge.symbol == makeTrue()) {
-            std::cout << "  Guard is TRUE" << std::endl;
-            guard = makeTrue();
-        } else if (edge.symbol == makeFalse()) {
-            guard = makeFalse();
-        } else {
-            std::cout << "  Guard is neither TRUE nor FALSE: " << edge.symbol.pretty_string << std::endl;
-            guard = edge.symbol;
+        std::span<const CTLTransitionPtr> transitions(StateId q) const {
+            const Part& part = parts_[owner_[q]];
+            return part.automaton->getTransitions(q - part.base);
         }
-        
-        // If guard is false, the entire transition is impossible
-        if (isEquivalentToFalse(guard)) {
-            std::cout << "  Guard is FALSE, transition impossible" << std::endl;
-            return makeFalse();
+        bool accepting(StateId q) const {
+            const Part& part = parts_[owner_[q]];
+            return part.automaton->isAccepting(q - part.base);
         }
-        
-        // Evaluate the DNF: clause1 ∨ clause2 ∨ ...
-        Guard dnf_result = makeFalse();
-        for (const auto& clause : edge.clauses) {
-            Guard clause_formula = evaluateClause(clause, target_region);
-            std::cout << "  Evaluating clause, result: " << clause_formula.pretty_string << std::endl;
-            dnf_result = makeOr(dnf_result, clause_formula);
+        // Arena id of a literal target of q's automaton
+        StateId target(StateId q, StateId local) const { return parts_[owner_[q]].base + local; }
+        // L(q) ⊆ L(r)
+        bool implies(StateId q, StateId r) const {
+            const Part& part = parts_[owner_[q]];
+            return owner_[q] == owner_[r] && part.implied && part.implied->rows() > 0 &&
+                   part.implied->test(q - part.base, r - part.base);
         }
-        
-        // Combine: guard ∧ DNF
-        return makeAnd(guard, dnf_result);
-    }
-    
-    // Compute the one-step predecessor: all states that can reach the target in one step
-    WinningRegion CTLAutomaton::symPre(const SymbolicParityGame& game, const WinningRegion& target_region) const {
-        WinningRegion pre_region;
-        
-        // For each state in the game
-        for (const auto& [state, node] : game.nodes) {
-            // Get all outgoing edges from this state
-            const auto& edges = game.getEdgesFrom(state);
-            
-            if (edges.empty()) {
-                // No outgoing edges: cannot reach target
-                pre_region[state] = makeFalse();
-                continue;
+        bool isSatisfiable(const std::unordered_set<std::string>& atoms) const {
+            return parts_.front().automaton->isSatisfiable(atoms);
+        }
+
+    private:
+        struct Part {
+            const CTLAutomaton* automaton;
+            StateId base;
+            const BitMatrix* implied;
+        };
+        std::vector<Part> parts_;
+        std::vector<uint32_t> owner_;  // part index by arena id
+    };
+
+    // Emptiness game of the conjunction of the arena's automata over binary trees.
+    //
+    // A position is the set S of states one tree node has to satisfy together,
+    // with the subset O ⊆ S of states that still owe a visit to an accepting
+    // state (Miyano-Hayashi breakpoint). Eloise picks one clause per
+    // transition of every state in the ε-closure of S, which fixes the guards
+    // the node label has to satisfy (checked symbolically by the SMT solver)
+    // and the obligations of the left and the right child. Abelard then picks
+    // a child. Eloise wins a play iff O runs empty infinitely often, so the
+    // game is a Büchi game; the automaton is non-empty iff Eloise wins from
+    // the initial position.
+    //
+    // Playing on sets keeps obligations that share a node together: solving a
+    // game per automaton state would conjoin the winning guards of different
+    // children and accept formulas like AG p & AF !p.
+    //
+    // Positions are explored breadth-first. A position Eloise wins within a
+    // finite tree is sure, and so is every position whose S is a subset of a
+    // sure S; the maximal sure sets are kept as an antichain, and exploration
+    // stops as soon as the initial position is sure.
+    class EmptinessGame {
+    public:
+        static constexpr uint32_t NO_OBLIGATION = std::numeric_limits<uint32_t>::max();
+
+        explicit EmptinessGame(const GameArena& arena, bool record_labels = false)
+            : arena_(arena), record_labels_(record_labels) {}
+
+        // True iff Eloise wins from ({initial states}, ∅)
+        bool solve() {
+            std::vector<StateId> initial;
+            for (size_t k = 0; k < arena_.parts(); ++k) {
+                if (arena_.initial(k) == INVALID_STATE_ID) return false;
+                initial.push_back(arena_.initial(k));
             }
-            
-            // Build the predecessor formula based on the player ownership
-            Guard state_formula = makeFalse();
-            
-            if (node.owner == Player::Player1_Eloise) {
-                // Player 1's turn: needs at least ONE edge to reach target (OR)
-                for (const auto& edge : edges) {
-                    Guard edge_formula = evaluateRule(edge, target_region);
-                    state_formula = makeOr(state_formula, edge_formula);
-                }
-            } else {
-                // Player 2's turn: ALL edges must lead to target (AND)
-                state_formula = makeTrue();
-                for (const auto& edge : edges) {
-                    Guard edge_formula = evaluateRule(edge, target_region);
-                    state_formula = makeAnd(state_formula, edge_formula);
-                }
+            std::sort(initial.begin(), initial.end());
+            start_ = __intern(initial, {});
+            while (!pending_.empty() && !sure_[start_]) {
+                cancellation::checkpoint();
+                const uint32_t p = pending_.front();
+                pending_.pop();
+                if (!sure_[p]) __expand(p);
             }
-            
-            pre_region[state] = state_formula;
+            return sure_[start_] || __winning(record_labels_ ? &strategy_ : nullptr)[start_];
         }
-        
-        return pre_region;
-    }
 
-    // ==================== Attractor Algorithm (Least Fixed-Point) ====================
-    
-    WinningRegion CTLAutomaton::symbolicAttractor(const SymbolicParityGame& game, 
-                                                   const WinningRegion& target, 
-                                                   Player sigma) const {
-        WinningRegion attractor = target;
-        
-        if (verbose_) {
-            std::cout << "Computing symbolic attractor for player " 
-                      << (sigma == Player::Player1_Eloise ? "Eloise" : "Abelard") << std::endl;
+        size_t positions() const { return keys_.size(); }
+        size_t choices() const {
+            size_t n = 0;
+            for (const auto& c : choices_) n += c.size();
+            return n;
         }
-        
-        int iteration = 0;
-        while (true) {
-            iteration++;
-            WinningRegion prev_attractor = attractor;
-            std::cout << "  Attractor iteration " << iteration << std::endl;
-
-            // Compute one-step predecessors
-            WinningRegion predecessors = symPre(game, attractor);
-            
-            // Update attractor based on player ownership
-            for (const auto& [state, node] : game.nodes) {
-                
-                    attractor[state] = makeOr(attractor[state], predecessors[state]);
-                
+
+        // A finite tree accepted by every automaton of the arena, if solve()
+        // found the initial position sure and labels were recorded; one node
+        // per line, children indented below their parent
+        std::string counterexample() const {
+            if (!record_labels_ || start_ == NO_OBLIGATION || !sure_[start_]) return {};
+            std::string out;
+            __printWitness(start_, 0, "", out);
+            return out;
+        }
+
+        // The model Eloise's strategy builds from the initial position, if
+        // solve() found it winning and labels were recorded: one state per
+        // position it reaches, a finite tree on sure positions and a winning
+        // Büchi strategy elsewhere, so cycles through breakpoints are fine
+        Witness witness() const {
+            Witness out;
+            if (!record_labels_ || start_ == NO_OBLIGATION) return out;
+            std::unordered_map<uint32_t, uint32_t> state_of;
+            std::vector<uint32_t> order;
+            auto visit = [&](uint32_t p) -> uint32_t {
+                if (p == NO_OBLIGATION) return Witness::kUnconstrained;
+                while (sure_[p] && sure_by_[p] != NO_OBLIGATION) p = sure_by_[p];
+                auto [it, inserted] = state_of.emplace(p, static_cast<uint32_t>(order.size()));
+                if (inserted) order.push_back(p);
+                return it->second;
+            };
+            visit(start_);
+            for (size_t k = 0; k < order.size(); ++k) {
+                const uint32_t p = order[k];
+                const uint32_t c = sure_[p] ? sure_choice_[p] : p < strategy_.size() ? strategy_[p] : NO_OBLIGATION;
+                if (c == NO_OBLIGATION) return {};  // not won after all
+                const Choice ch = choices_[p][c];
+                Witness::State state;
+                state.guards.assign(labels_[ch.label]->begin(), labels_[ch.label]->end());
+                state.left = visit(ch.left);
+                state.right = visit(ch.right);
+                out.states.push_back(std::move(state));
             }
-            
-            // Check for fixed point
-            if (winningRegionsEqual(attractor, prev_attractor)) {
-                if (verbose_) {
-                    std::cout << "  Attractor converged after " << iteration << " iterations" << std::endl;
-                }
-                break;
+            return out;
+        }
+
+    private:
+        using Key = std::vector<uint32_t>;  // sorted S, separator, sorted O
+
+        struct KeyHash {
+            size_t operator()(const Key& k) const {
+                size_t h = k.size();
+                for (uint32_t v : k) h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+                return h;
             }
-            
-            if (iteration > 1000) {
-                throw std::runtime_error("Attractor computation did not converge after 1000 iterations");
+        };
+
+        struct Choice { uint32_t left; uint32_t right; uint32_t label; };
+        using Obligations = std::map<StateId, bool>;                     // state -> owes
+
+        // Left and right child obligations, with the guards that admit them
+        struct Candidate {
+            Obligations left, right;
+            std::set<std::string> atoms;
+            bool operator<(const Candidate& o) const { return std::tie(left, right) < std::tie(o.left, o.right); }
+            bool operator==(const Candidate& o) const { return left == o.left && right == o.right; }
+        };
+
+        struct Unchosen {
+            const CTLTransition* transition;
+            bool owes;
+            StateId owner;  // arena id of the state it belongs to
+        };
+
+        // One partial Eloise move at the current node
+        struct Frame {
+            std::vector<std::pair<StateId, bool>> states;                  // states to satisfy here
+            std::vector<Unchosen> transitions;                              // transitions without a chosen clause
+            Obligations current, left, right;
+            std::unordered_set<std::string> atoms;                          // guards on the node label
+        };
+
+        uint32_t __intern(const std::vector<StateId>& states, const std::vector<StateId>& owing) {
+            if (states.empty()) return NO_OBLIGATION;
+
+            // Drop states implied by another one; of two equivalent states the lower id stays
+            Key key;
+            for (StateId r : states) {
+                const bool redundant = std::any_of(states.begin(), states.end(), [&](StateId q) {
+                    return q != r && arena_.implies(q, r) && !(r < q && arena_.implies(r, q));
+                });
+                if (!redundant) key.push_back(r);
             }
+            const size_t size = key.size();
+            key.push_back(NO_OBLIGATION);
+            for (StateId q : owing) {
+                if (std::binary_search(key.begin(), key.begin() + size, q)) key.push_back(q);
+            }
+
+            auto [it, inserted] = ids_.emplace(std::move(key), static_cast<uint32_t>(keys_.size()));
+            if (inserted) {
+                const uint32_t p = it->second;
+                keys_.push_back(&it->first);
+                choices_.emplace_back();
+                missing_.emplace_back();
+                parents_.emplace_back();
+                sure_.push_back(false);
+                sure_by_.push_back(NO_OBLIGATION);
+                sure_choice_.push_back(NO_OBLIGATION);
+                pending_.push(p);
+                // Subsumed by a sure position: its tree satisfies these states as well
+                for (uint32_t w : sure_sets_) {
+                    if (std::includes(__begin(w), __separator(w), __begin(p), __separator(p))) {
+                        __markSure(p, NO_OBLIGATION, w);
+                        break;
+                    }
+                }
+            }
+            return it->second;
         }
-        
-        return attractor;
-    }
-    
-    // ==================== Trap Computation (Greatest Fixed-Point) ====================
-    
-    // Computes the largest set of states from which Player sigma can force the game
-    // to stay within the 'domain' forever
-    WinningRegion CTLAutomaton::symbolicTrap(const SymbolicParityGame& game,
-                                             const WinningRegion& domain,
-                                             Player sigma) const {
-        WinningRegion trap = domain;
-        
-        if (verbose_) {
-            std::cout << "Computing trap for player " 
-                      << (sigma == Player::Player1_Eloise ? "Eloise" : "Abelard") << std::endl;
+
+        Key::const_iterator __begin(uint32_t p) const { return keys_[p]->begin(); }
+        Key::const_iterator __separator(uint32_t p) const {
+            return std::find(keys_[p]->begin(), keys_[p]->end(), NO_OBLIGATION);
         }
-        
-        int iteration = 0;
-        while (true) {
-            iteration++;
-            WinningRegion prev_trap = trap;
-            
-            // Compute predecessors that stay within the current trap
-            WinningRegion predecessors = symPre(game, trap);
-            
-            // A state stays in the trap if it was there before AND
-            // the player can force to stay in the trap
-            for (const auto& [state, node] : game.nodes) {
-                // The state must have been in the trap
-                Guard in_trap = trap[state];
-                
-                // AND the player must be able to move within the trap
-                Guard can_stay = predecessors[state];
-                
-                trap[state] = makeAnd(in_trap, can_stay);
+
+        bool __owes(StateId q, bool owes) const { return owes && !arena_.accepting(q); }
+
+        void __expand(uint32_t p) {
+            const Key& key = *keys_[p];
+            auto separator = std::find(key.begin(), key.end(), NO_OBLIGATION);
+            const bool breakpoint = separator + 1 == key.end();
+
+            Frame frame;
+            for (auto it = key.begin(); it != separator; ++it) {
+                // At a breakpoint every non-accepting state starts a new debt
+                const bool owes = breakpoint ? !arena_.accepting(*it)
+                                             : std::binary_search(separator + 1, key.end(), *it);
+                frame.states.emplace_back(*it, owes);
             }
-            
-            // Check for fixed point
-            if (winningRegionsEqual(trap, prev_trap)) {
-                if (verbose_) {
-                    std::cout << "  Trap converged after " << iteration << " iterations" << std::endl;
-                }
-                break;
+            std::vector<Candidate> candidates;
+            __choose(std::move(frame), candidates);
+
+            // Abelard may take either child, so the order of the two is irrelevant
+            for (auto& c : candidates) {
+                if (c.right < c.left) std::swap(c.left, c.right);
             }
-            
-            if (iteration > 1000) {
-                throw std::runtime_error("Trap computation did not converge after 1000 iterations");
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+            // Fewer obligations never hurt Eloise: keep only minimal candidates
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                bool dominated = false;
+                for (size_t j = 0; j < candidates.size() && !dominated; ++j) {
+                    dominated = j != i && __easier(candidates[j], candidates[i]);
+                }
+                if (dominated) continue;
+                const uint32_t l = __child(candidates[i].left);
+                const uint32_t r = __child(candidates[i].right);
+                const uint32_t c = static_cast<uint32_t>(choices_[p].size());
+                choices_[p].push_back({l, r, __label(candidates[i].atoms)});
+
+                // Sure once every child is
+                uint32_t missing = 0;
+                for (uint32_t child : {l, r == l ? NO_OBLIGATION : r}) {
+                    if (child == NO_OBLIGATION || sure_[child]) continue;
+                    parents_[child].emplace_back(p, c);
+                    ++missing;
+                }
+                missing_[p].push_back(missing);
+                if (missing == 0 && !sure_[p]) __markSure(p, c, NO_OBLIGATION);
             }
         }
-        
-        return trap;
-    }
 
-    // ==================== Main Solver: Nested Fixed-Point for Büchi Games ====================
-    
-    std::pair<WinningRegion, WinningRegion> CTLAutomaton::symbolicSolveRecursive(const SymbolicParityGame& game) const {
-        WinningRegion W_0, W_1;
-        
-        // BASE CASE: If there are no states, return empty winning regions
-        if (game.nodes.empty()) {
-            if (verbose_) {
-                std::cout << "Base case: empty game" << std::endl;
+        void __markSure(uint32_t p, uint32_t choice, uint32_t by) {
+            std::vector<std::pair<uint32_t, std::pair<uint32_t, uint32_t>>> worklist{{p, {choice, by}}};
+            while (!worklist.empty()) {
+                auto [q, how] = worklist.back();
+                worklist.pop_back();
+                if (sure_[q]) continue;
+                sure_[q] = true;
+                sure_by_[q] = how.second;
+                if (how.second == NO_OBLIGATION) sure_choice_[q] = how.first;
+
+                // Keep the maximal sure sets only
+                auto s_begin = __begin(q), s_end = __separator(q);
+                const bool covered = std::any_of(sure_sets_.begin(), sure_sets_.end(), [&](uint32_t w) {
+                    return std::includes(__begin(w), __separator(w), s_begin, s_end);
+                });
+                if (!covered) {
+                    std::erase_if(sure_sets_, [&](uint32_t w) {
+                        return std::includes(s_begin, s_end, __begin(w), __separator(w));
+                    });
+                    sure_sets_.push_back(q);
+                }
+
+                for (auto [parent, c] : parents_[q]) {
+                    if (--missing_[parent][c] == 0 && !sure_[parent]) {
+                        worklist.push_back({parent, {c, NO_OBLIGATION}});
+                    }
+                }
             }
-            return {W_0, W_1};
         }
-        
-        if (verbose_) {
-            std::cout << "\n=== Solving Büchi game with " << game.nodes.size() << " states ===" << std::endl;
+
+        uint32_t __label(const std::set<std::string>& atoms) {
+            if (!record_labels_) return 0;
+            auto [it, inserted] = label_ids_.emplace(atoms, static_cast<uint32_t>(labels_.size()));
+            if (inserted) labels_.push_back(&it->first);
+            return it->second;
         }
-        
-        // W will be the winning region for Player 0 (Eloise).
-        // Initialize it optimistically to all 'true'.
-        WinningRegion W;
-        for (const auto& [state, node] : game.nodes) {
-            W[state] = makeTrue();
+
+        void __printWitness(uint32_t p, size_t depth, const std::string& dir, std::string& out) const {
+            while (sure_by_[p] != NO_OBLIGATION) p = sure_by_[p];
+            const Choice& ch = choices_[p][sure_choice_[p]];
+            out.append(2 * depth, ' ');
+            out += dir + "{";
+            bool first = true;
+            for (const auto& atom : *labels_[ch.label]) {
+                out += (first ? "" : ", ") + atom;
+                first = false;
+            }
+            out += "}\n";
+            if (ch.left != NO_OBLIGATION) __printWitness(ch.left, depth + 1, "L: ", out);
+            if (ch.right != NO_OBLIGATION) __printWitness(ch.right, depth + 1, "R: ", out);
         }
-        
-        // OUTER LOOP: Greatest Fixed-Point for the overall winning region W.
-        // This is the main loop that converges to the largest set from which Eloise can win.
-        int iteration = 0;
-        while (true) {
-            iteration++;
-            if (verbose_) {
-                std::cout << "\n--- Outer GFP Iteration " << iteration << " ---" << std::endl;
+
+        // a ⊆ b on states, and every debt in a is a debt in b
+        static bool __subsumes(const Obligations& a, const Obligations& b) {
+            if (a.size() > b.size()) return false;
+            for (const auto& [q, owes] : a) {
+                auto it = b.find(q);
+                if (it == b.end() || (owes && !it->second)) return false;
             }
-            
-            WinningRegion W_prev = W;
-            
-            // Step 1: Define the target set for this iteration:
-            //         It's the set of accepting states (priority 0) that are
-            //         still considered part of the winning region W.
-            // BUG FIX 1: Target is priority 0 (even = accepting), not priority 1!
-            WinningRegion target;
-            for (const auto& [state, node] : game.nodes) {
-                if (node.priority == 0) {  // Priority 0 = even = accepting/good
-                    target[state] = W[state];
-                } else {
-                    target[state] = makeFalse();
+            return true;
+        }
+
+        // Choice a is at least as good for Eloise as choice b
+        static bool __easier(const Candidate& a, const Candidate& b) {
+            return (__subsumes(a.left, b.left) && __subsumes(a.right, b.right)) ||
+                   (__subsumes(a.left, b.right) && __subsumes(a.right, b.left));
+        }
+
+        void __choose(Frame frame, std::vector<Candidate>& candidates) {
+            // Unfold the states of this node into their transitions
+            while (!frame.states.empty()) {
+                auto [q, owes] = frame.states.back();
+                frame.states.pop_back();
+                auto [it, inserted] = frame.current.emplace(q, owes);
+                if (!inserted) {
+                    if (it->second || !owes) continue;
+                    it->second = true;  // now reached from a debt as well
                 }
-            }
-            std::cout << "Target states for this iteration:" << std::endl;
-            for (const auto& [state, formula] : target) {
-                if (!isEquivalentToFalse(formula)) {
-                    std::cout << "  State: " << state << " Formula: " << formula.pretty_string << std::endl;
+                for (const auto& t : arena_.transitions(q)) {
+                    frame.transitions.push_back({t, owes, q});
                 }
             }
-            
-            // Step 2: Compute the attractor to this target.
-            //         The attractor function itself is a least fixed-point computation (inner LFP).
-            //         This computes the set of states from which Eloise can FORCE a visit
-            //         to an accepting state within the current winning region W.
-            WinningRegion attractor = symbolicAttractor(game, target, Player::Player1_Eloise);
-            
-            // Step 3: The new winning region is this attractor.
-            //         BUG FIX 2: W = attractor, not W = trap(attractor).
-            //         Any state not in the attractor is a state from which Eloise cannot
-            //         guarantee reaching an accepting state, so it's a losing state.
-            W = attractor;
-            
-            // Check for convergence of the outer GFP loop.
-            if (winningRegionsEqual(W, W_prev)) {
-                if (verbose_) {
-                    std::cout << "Outer GFP loop converged after " << iteration << " iterations." << std::endl;
+
+            if (frame.transitions.empty()) {
+                candidates.push_back({std::move(frame.left), std::move(frame.right),
+                                      record_labels_ ? std::set<std::string>(frame.atoms.begin(), frame.atoms.end())
+                                                     : std::set<std::string>{}});
+                return;
+            }
+
+            // Branch on the transition with the fewest clauses first, so forced
+            // guards and obligations are in place before any real choice
+            size_t pick = 0;
+            for (size_t i = 1; i < frame.transitions.size() && frame.transitions[pick].transition->clauses.size() > 1; ++i) {
+                if (frame.transitions[i].transition->clauses.size() < frame.transitions[pick].transition->clauses.size()) pick = i;
+            }
+            const Unchosen u = frame.transitions[pick];
+            const CTLTransition* t = u.transition;
+            frame.transitions[pick] = frame.transitions.back();
+            frame.transitions.pop_back();
+            if (t->guard.isFalse()) return;
+            if (!t->guard.isTrue() && frame.atoms.insert(t->guard.pretty_string).second &&
+                !arena_.isSatisfiable(frame.atoms)) {
+                return;
+            }
+
+            // A clause whose obligations already hold at this node dominates the others
+            for (const auto& clause : t->clauses) {
+                if (__holds(frame, clause, u)) {
+                    __choose(std::move(frame), candidates);
+                    return;
                 }
-                break;
             }
-            
-            if (iteration > 100) {
-                throw std::runtime_error("Outer fixed-point did not converge after 100 iterations");
+
+            for (const auto& clause : t->clauses) {
+                Frame next = frame;
+                for (const auto& literal : clause.literals) {
+                    if (literal.qid == INVALID_STATE_ID) continue;
+                    const StateId q = arena_.target(u.owner, literal.qid);
+                    const bool debt = __owes(q, u.owes);
+                    if (literal.dir < 0) {
+                        next.states.emplace_back(q, debt);
+                    } else {
+                        auto& child = literal.dir == 0 ? next.left : next.right;
+                        child[q] = child[q] || debt;
+                    }
+                }
+                __choose(std::move(next), candidates);
             }
         }
-        
-        // The final W is the winning region for Player 0 (Eloise)
-        W_0 = W;
-        
-        // Player 1 (Abelard) wins where Player 0 does not.
-        // Symbolically: W_1[state] = NOT W_0[state]
-        for (const auto& [state, node] : game.nodes) {
-            // For now, we compute the complement symbolically
-            // If W_0[state] is true, then W_1[state] is false, and vice versa
-            if (isEquivalentToTrue(W_0[state])) {
-                W_1[state] = makeFalse();
-            } else if (isEquivalentToFalse(W_0[state])) {
-                W_1[state] = makeTrue();
-            } else {
-                // For complex formulas, we would need makeNot()
-                // For now, just set to false (conservative: we only care about W_0 for satisfiability)
-                W_1[state] = makeFalse();
+
+        bool __holds(const Frame& frame, const ClauseView& clause, const Unchosen& u) const {
+            for (const auto& literal : clause.literals) {
+                if (literal.qid == INVALID_STATE_ID) continue;
+                if (literal.dir >= 0) return false;
+                const StateId q = arena_.target(u.owner, literal.qid);
+                auto it = frame.current.find(q);
+                if (it == frame.current.end() || (__owes(q, u.owes) && !it->second)) return false;
             }
+            return true;
         }
-        
-        return {W_0, W_1};
-    }
-    
-    // ==================== Top-Level Function: CTL Satisfiability Check ====================
-    
-    bool CTLAutomaton::checkCtlSatisfiability() const {
-        if (verbose_) {
-            std::cout << "\n========================================" << std::endl;
-            std::cout << "Starting CTL Satisfiability Check" << std::endl;
-            std::cout << "========================================\n" << std::endl;
-        }
-        
-        // Step 1: Build the symbolic parity game from the automaton
-        SymbolicParityGame game = buildGameGraph();
-        
-        if (verbose_) {
-            std::cout << "Built symbolic parity game with " << game.nodes.size() << " nodes" << std::endl;
-        }
-        
-        // Step 2: Solve the game recursively
-        auto [W_0, W_1] = symbolicSolveRecursive(game);
-        
-        // Step 3: Get the winning formula for Player 0 (Eloise) at the initial state
-        std::string_view initial_state = game.initial_state;
-        Guard winning_formula = W_0[initial_state];
-        
-        if (verbose_) {
-            std::cout << "\n========================================" << std::endl;
-            std::cout << "Winning formula for initial state: " << std::endl;
-
-            std::cout << winning_formula.pretty_string << std::endl;
-            std::cout << "========================================\n" << std::endl;
-        }
-        
-        // Step 4: THE SMT SOLVER CALL
-        // Check if there exists any valuation that makes this formula true
-        if (isEquivalentToFalse(winning_formula)) {
-            return false;  // Trivially unsatisfiable
-        }
-        
-        if (isEquivalentToTrue(winning_formula)) {
-            return true;   // Trivially satisfiable
-        }
-        
-        bool is_sat = __isSatisfiable(winning_formula);
-        
-        if (verbose_) {
-            std::cout << "SMT solver result: " << (is_sat ? "SATISFIABLE" : "UNSATISFIABLE") << std::endl;
-        }
-        
-        return is_sat;
-    }
-
 
+        uint32_t __child(const Obligations& obligations) {
+            std::vector<StateId> states, owing;
+            for (const auto& [q, owes] : obligations) {
+                states.push_back(q);
+                if (owes) owing.push_back(q);
+            }
+            return __intern(states, owing);
+        }
 
+        // νZ. μY. (F ∩ CPre(Z)) ∪ CPre(Y), CPre(X): some choice with every child in X.
+        // Sure positions are won outright, expanded or not. strategy receives
+        // the choice that put each won position in the last Y: a breakpoint
+        // staying in Z, or a step closer to one, so following it visits
+        // breakpoints infinitely often.
+        std::vector<bool> __winning(std::vector<uint32_t>* strategy = nullptr) const {
+            const size_t n = keys_.size();
+            std::vector<bool> accepting(n);
+            for (size_t p = 0; p < n; ++p) accepting[p] = keys_[p]->back() == NO_OBLIGATION;
 
-    std::vector<std::unordered_set<int>>& CTLAutomaton::__getDAG() const
-    {
-        if (!block_edges_.empty()) {
-            return block_edges_;
-        }
+            // Choices a position appears in as a child, for the attractor counters
+            std::vector<std::vector<std::pair<uint32_t, uint32_t>>> parents(n);
+            for (uint32_t p = 0; p < n; ++p) {
+                for (uint32_t c = 0; c < choices_[p].size(); ++c) {
+                    const auto& ch = choices_[p][c];
+                    if (ch.left != NO_OBLIGATION) parents[ch.left].emplace_back(p, c);
+                    if (ch.right != NO_OBLIGATION && ch.right != ch.left) parents[ch.right].emplace_back(p, c);
+                }
+            }
+            auto children = [](const Choice& ch) {
+                return (ch.left != NO_OBLIGATION) + (ch.right != NO_OBLIGATION && ch.right != ch.left);
+            };
 
-        std::vector<std::unordered_set<int>> block_edges(blocks_->size());
-        for (int i = 0; i < (int)blocks_->size(); ++i) {
-            for (const auto& st : blocks_->blocks[i]) {
-                auto it = state_successors_.find(st);
-                if (it == state_successors_.end()) {
-                    block_edges[i] = {};
-                    continue;
+            std::vector<bool> Z(n, true);
+            while (true) {
+                cancellation::checkpoint();
+                std::vector<bool> Y(n, false);
+                std::vector<std::vector<int>> missing(n);
+                std::vector<uint32_t> worklist;
+                if (strategy) strategy->assign(n, NO_OBLIGATION);
+                for (uint32_t p = 0; p < n; ++p) {
+                    if (sure_[p]) {
+                        Y[p] = true;
+                        worklist.push_back(p);
+                    }
+                    missing[p].resize(choices_[p].size());
+                    for (uint32_t c = 0; c < choices_[p].size(); ++c) {
+                        const auto& ch = choices_[p][c];
+                        missing[p][c] = children(ch);
+                        const bool in_z = (ch.left == NO_OBLIGATION || Z[ch.left]) &&
+                                          (ch.right == NO_OBLIGATION || Z[ch.right]);
+                        if (!Y[p] && (missing[p][c] == 0 || (accepting[p] && in_z))) {
+                            Y[p] = true;
+                            worklist.push_back(p);
+                            if (strategy) (*strategy)[p] = c;
+                        }
+                    }
                 }
-                //block_edges[i] = {};
-                for (const auto& succ : it->second) {
-                    int bj = blocks_->getBlockId(succ);
-                    if (bj != i) block_edges[i].insert(bj);
+                while (!worklist.empty()) {
+                    const uint32_t q = worklist.back();
+                    worklist.pop_back();
+                    for (auto [p, c] : parents[q]) {
+                        if (--missing[p][c] == 0 && !Y[p]) {
+                            Y[p] = true;
+                            worklist.push_back(p);
+                            if (strategy) (*strategy)[p] = c;
+                        }
+                    }
                 }
+                if (Y == Z) return Z;
+                Z = std::move(Y);
             }
         }
-        block_edges_ = std::move(block_edges);
-        return block_edges_;
 
+        const GameArena& arena_;
+        const bool record_labels_;
+        uint32_t start_ = NO_OBLIGATION;
+        std::unordered_map<Key, uint32_t, KeyHash> ids_;
+        std::vector<const Key*> keys_;
+        std::vector<std::vector<Choice>> choices_;
+        std::queue<uint32_t> pending_;
+
+        // Sure wins: a finite tree witnesses them, see __markSure
+        std::vector<bool> sure_;
+        std::vector<uint32_t> sure_choice_;                  // choice whose children are all sure
+        std::vector<uint32_t> sure_by_;                      // or the sure position whose S covers this one
+        std::vector<std::vector<uint32_t>> missing_;         // children not yet sure, by choice
+        std::vector<std::vector<std::pair<uint32_t, uint32_t>>> parents_;  // (position, choice) awaiting this one
+        std::vector<uint32_t> sure_sets_;                    // antichain of maximal sure S
+        std::vector<uint32_t> strategy_;                     // by position, see __winning
+        std::map<std::set<std::string>, uint32_t> label_ids_;
+        std::vector<const std::set<std::string>*> labels_;
+    };
+
+    } // namespace
+
+
+    bool CTLAutomaton::isEmpty(WorkStealingPool* pool) const {
+        // The symbolic evaluation refutes most empty automata without
+        // expanding a move; the game decides whatever it lets through
+        SymbolicEvaluator evaluator(*this);
+        if (pool && pool->size() > 1 && blocks_->size() > 1) evaluator.evaluate(*pool);
+        if (!evaluator.mayBeNonEmpty()) {
+            CTL_LOG(DEBUG, verbose_, "Symbolic evaluation: automaton is empty after "
+                                     << evaluator.evaluatedBlocks() << " blocks");
+            return true;
+        }
+        GameArena arena;
+        arena.add(*this);
+        WitnessCapture* capture = WitnessCapture::current();
+        EmptinessGame game(arena, capture != nullptr);
+        const bool non_empty = game.solve();
+        if (non_empty && capture) capture->add(game.witness());
+        Statistics::instance().add(Statistic::GAME_POSITIONS, game.positions());
+        Statistics::instance().add(Statistic::GAME_CHOICES, game.choices());
+        CTL_LOG(DEBUG, verbose_, "Emptiness game: " << game.positions() << " positions, " << game.choices()
+                                 << " choices, automaton is " << (non_empty ? "non-empty" : "empty"));
+        return !non_empty;
+    }
+
+    bool CTLAutomaton::languageIncludesAntichain(const CTLAutomaton& other, std::string* counterexample) const {
+        if (this->getFormula()->hash() == TRUE_HASH) return true;
+        if (other.getFormula()->hash() == FALSE_HASH) return true;
+
+        // L(other) ∩ L(¬this) on the two automata side by side, with the
+        // states of each minimized by its own simulation preorder
+        const CTLAutomaton& complement = getComplement();
+        GameArena arena;
+        arena.add(other, &other.__selfSimulation());
+        arena.add(complement, &complement.__selfSimulation());
+        WitnessCapture* capture = WitnessCapture::current();
+        EmptinessGame game(arena, counterexample != nullptr || capture != nullptr);
+        const bool non_empty = game.solve();
+        if (non_empty && capture) capture->add(game.witness());
+        Statistics::instance().add(Statistic::GAME_POSITIONS, game.positions());
+        Statistics::instance().add(Statistic::GAME_CHOICES, game.choices());
+        CTL_LOG(DEBUG, verbose_, "Antichain inclusion game: " << game.positions() << " positions, " << game.choices()
+                                 << " choices, inclusion " << (non_empty ? "fails" : "holds"));
+        if (non_empty && counterexample) *counterexample = game.counterexample();
+        return !non_empty;
+    }
+
+    const BitMatrix& CTLAutomaton::__selfSimulation() const {
+        std::call_once(self_simulation_once_, [&] {
+#ifdef USE_Z3
+            self_simulation_ = std::make_unique<BitMatrix>(simulationRelation(*this));
+#else
+            self_simulation_ = std::make_unique<BitMatrix>();  // no simulation without Z3: nothing is pruned
+#endif
+        });
+        return *self_simulation_;
+    }
+
+    bool CTLAutomaton::checkCtlSatisfiability() const {
+        return !isEmpty();
     }
-}
\ No newline at end of file
+}
@@ -1,367 +1,222 @@
 #include "CTLautomaton.h"
-#include <queue>
+#include "statistics.h"
+#include "log.h"
+#include "cancellation.h"
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <unordered_map>
-#include <stack>
+#include <vector>
 
 
-#ifdef USE_ON_THE_FLY_PRODUCT
-
 // ============================================================================
 // ON-THE-FLY PRODUCT CONSTRUCTION FOR LANGUAGE INCLUSION
 // ============================================================================
-// This file implements L(B) ⊆ L(A) as emptiness of L(B) ∩ L(¬A)
-// using on-the-fly product automaton construction.
+// This file implements L(B) ⊆ L(A) as emptiness of L(B) ∩ L(¬A).
+// Product states are generated lazily while a single Couvreur-style SCC
+// search runs over them, and the search stops at the first witness of a
+// non-empty product: a combined move that leaves ¬A no obligation, or a
+// cycle that visits an accepting state of both components.
+// A product state pairs one state of each automaton, and the search follows
+// one child obligation at a time, so the product over-approximates
+// L(B) ∩ L(¬A): an empty product proves inclusion in |B| x |¬A| states,
+// while a witness may be spurious and is confirmed by the fixpoint engine.
 // ============================================================================
 namespace ctl {
 namespace {
-    // Product state: pair of (state_from_B, state_from_notA)
+    // Product state: pair of (state_from_B, state_from_notA). state_B is
+    // NO_OBLIGATION when B puts no constraint on this tree node.
+    constexpr StateId NO_OBLIGATION = INVALID_STATE_ID;
+
     struct ProductState {
-        std::string state_B;
-        std::string state_notA;
-        
-        bool operator==(const ProductState& other) const {
-            return state_B == other.state_B && state_notA == other.state_notA;
-        }
-        
-        bool operator<(const ProductState& other) const {
-            if (state_B != other.state_B) return state_B < other.state_B;
-            return state_notA < other.state_notA;
-        }
-        
-        std::string toString() const {
-            return "(" + state_B + "," + state_notA + ")";
-        }
-    };
-    
-    struct ProductStateHash {
-        size_t operator()(const ProductState& ps) const {
-            return std::hash<std::string>()(ps.state_B) ^ 
-                   (std::hash<std::string>()(ps.state_notA) << 1);
-        }
+        StateId state_B;
+        StateId state_notA;
+
+        uint64_t key() const { return (uint64_t{state_B} << 32) | state_notA; }
     };
+
+    // Acceptance marks of a product state or of a (partial) product SCC
+    constexpr uint8_t ACCEPT_B = 1;
+    constexpr uint8_t ACCEPT_NOT_A = 2;
+    constexpr uint8_t ACCEPT_BOTH = ACCEPT_B | ACCEPT_NOT_A;
+
+    // An unconstrained component accepts every subtree with a single empty move
+    const std::vector<Move> kUnconstrainedMoves(1);
+
+    const std::vector<Move>& movesOf(const CTLAutomaton& automaton, StateId id) {
+        return id == NO_OBLIGATION ? kUnconstrainedMoves : automaton.getExpandedTransitions(id);
+    }
+
+    bool acceptingIn(const CTLAutomaton& automaton, StateId id) {
+        return id == NO_OBLIGATION || automaton.isAccepting(id);
+    }
 } // end anonymous namespace
 
 // ============================================================================
 // Helper: Combine moves from B and ¬A into a product move
 // ============================================================================
+// Returns false if the moves cannot be taken together. On success the
+// product successors are appended to successors; a combined move that adds
+// none leaves ¬A nothing to prove and is a witness of non-emptiness.
 static bool combineMoves(
     const Move& move_B,
     const Move& move_notA,
-    Move& result,
-    const CTLAutomaton& automaton_B,
-    const CTLAutomaton& automaton_notA
+    std::vector<ProductState>& successors,
+    const CTLAutomaton& automaton_B
 ) {
-    // Step 1: Merge atomic guards
-    result.atoms = move_B.atoms;
-    result.atoms.insert(move_notA.atoms.begin(), move_notA.atoms.end());
-    
+    // Step 1: Merge atomic guards (both sorted guard ids)
+    SmallVector<GuardTable::Id, 8> atoms;
+    atoms.reserve(move_B.atoms.size() + move_notA.atoms.size());
+    std::set_union(move_B.atoms.begin(), move_B.atoms.end(),
+                   move_notA.atoms.begin(), move_notA.atoms.end(), std::back_inserter(atoms));
+
     // Step 2: Check if combined atoms are satisfiable
-    if (!automaton_B.isSatisfiable(result.atoms)) {
+    if (!automaton_B.isSatisfiable(atoms)) {
         return false; // Inconsistent combination, discard
     }
-    
-    // Step 3: Synchronize next-states by direction
-    // Both automata must agree on the directions they use
-    
-    // If both have no next states (terminal), this is valid
-    if (move_B.next_states.empty() && move_notA.next_states.empty()) {
-        return true;
-    }
-    
-    // Collect directions from both moves
-    std::unordered_map<int, std::unordered_set<std::string_view>> dirs_B;
-    std::unordered_map<int, std::unordered_set<std::string_view>> dirs_notA;
-    
-    for (const auto& ns : move_B.next_states) {
-        dirs_B[ns.dir].insert(ns.state);
-    }
-    
-    for (const auto& ns : move_notA.next_states) {
-        dirs_notA[ns.dir].insert(ns.state);
-    }
-    
-    // Get all unique directions
-    std::unordered_set<int> all_dirs;
-    for (const auto& [dir, _] : dirs_B) all_dirs.insert(dir);
-    for (const auto& [dir, _] : dirs_notA) all_dirs.insert(dir);
-    
-    // For each direction, both automata must have transitions (synchronization)
-    for (int dir : all_dirs) {
-        if (dirs_B.find(dir) == dirs_B.end() || dirs_notA.find(dir) == dirs_notA.end()) {
-            // Direction mismatch - cannot synchronize
-            return false;
+
+    // Step 3: Synchronize next-states by direction. Both successor lists are
+    // sorted by direction, so each direction is one contiguous range.
+    // Only directions ¬A constrains can lead to a witness; children only B
+    // constrains are side conditions and are not explored. Where B puts no
+    // constraint, its component is unconstrained
+    static const MoveSuccessor unconstrained{0, NO_OBLIGATION};
+    const auto byDir = [](const MoveSuccessor& a, const MoveSuccessor& b) { return a.dir < b.dir; };
+    for (auto it = move_notA.next_states.begin(); it != move_notA.next_states.end();) {
+        auto [b_first, b_last] = std::equal_range(move_B.next_states.begin(), move_B.next_states.end(), *it, byDir);
+        if (b_first == b_last) {
+            b_first = &unconstrained;
+            b_last = b_first + 1;
         }
-        
+        const auto notA_last = std::upper_bound(it, move_notA.next_states.end(), *it, byDir);
+
         // Create product states for all combinations at this direction
-        for (auto sb : dirs_B[dir]) {
-            for (auto sna : dirs_notA[dir]) {
-                ProductState ps{std::string(sb), std::string(sna)};
-                result.next_states.insert({dir, ps.toString()});
+        for (auto sb = b_first; sb != b_last; ++sb) {
+            for (auto sna = it; sna != notA_last; ++sna) {
+                successors.push_back({sb->state, sna->state});
             }
         }
+        it = notA_last;
     }
-    
+
     return true; // Successfully combined
 }
 
 // ============================================================================
-// On-the-fly product automaton construction with SCC computation
+// Single-pass emptiness check of the product B x ¬A
 // ============================================================================
-static void buildProductAutomaton(
+// Iterative SCC search after Couvreur: every root of a not yet completed SCC
+// carries the union of the acceptance marks of its SCC. A back edge to a live
+// state closes a cycle and merges the roots above it; as soon as the merged
+// SCC carries both marks, an accepting lasso exists and the search stops.
+// Completed SCCs are marked dead and never entered again.
+static bool checkLanguageInclusionOTF(
     const CTLAutomaton& automaton_B,
-    const CTLAutomaton& automaton_notA,
-    std::unordered_map<ProductState, std::vector<Move>, ProductStateHash>& product_transitions,
-    std::unordered_set<ProductState, ProductStateHash>& product_states,
-    std::unordered_map<ProductState, std::unordered_set<ProductState, ProductStateHash>, ProductStateHash>& product_successors,
-    ProductState& initial_product_state
+    const CTLAutomaton& automaton_notA
 ) {
-    // Initial product state
-    initial_product_state = ProductState{
-        std::string(automaton_B.getInitialState()), 
-        std::string(automaton_notA.getInitialState())
-    };
-    
-    std::queue<ProductState> worklist;
-    worklist.push(initial_product_state);
-    product_states.insert(initial_product_state);
-    
-    std::unordered_map<std::string_view, std::vector<Move>> moves_cache_B;
-    std::unordered_map<std::string_view, std::vector<Move>> moves_cache_notA;
-    
-    while (!worklist.empty()) {
-        ProductState current = worklist.front();
-        worklist.pop();
-        
-        // Get moves from both component automata
-        auto moves_B = automaton_B.getMoves(current.state_B, moves_cache_B);
-        auto moves_notA = automaton_notA.getMoves(current.state_notA, moves_cache_notA);
-        
-        std::vector<Move> combined_moves;
-        
-        // Try all combinations of moves from both automata
-        for (const auto& move_B : moves_B) {
-            for (const auto& move_notA : moves_notA) {
-                Move product_move;
-                
-                if (combineMoves(move_B, move_notA, product_move, automaton_B, automaton_notA)) {
-                    combined_moves.push_back(product_move);
-                    
-                    // Track successors for SCC computation
-                    for (const auto& ns : product_move.next_states) {
-                        // Parse the product state name "(qB,qNotA)"
-                        std::string state_str(ns.state);
-                        size_t comma_pos = state_str.find(',');
-                        if (comma_pos != std::string::npos && state_str.front() == '(' && state_str.back() == ')') {
-                            std::string sb = state_str.substr(1, comma_pos - 1);
-                            std::string sna = state_str.substr(comma_pos + 1, state_str.length() - comma_pos - 2);
-                            
-                            ProductState next_product{sb, sna};
-                            
-                            // Add to successor relation
-                            product_successors[current].insert(next_product);
-                            
-                            // Add to worklist if not yet visited
-                            if (product_states.find(next_product) == product_states.end()) {
-                                product_states.insert(next_product);
-                                worklist.push(next_product);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        
-        product_transitions[current] = std::move(combined_moves);
+    const StateId init_B = automaton_B.getInitialStateId();
+    const StateId init_notA = automaton_notA.getInitialStateId();
+    if (init_B == INVALID_STATE_ID || init_notA == INVALID_STATE_ID) {
+        return true; // One side has no run at all
     }
-}
 
-// ============================================================================
-// Compute SCCs of the product automaton using Tarjan's algorithm
-// ============================================================================
-static std::vector<std::vector<ProductState>> computeProductSCCs(
-    const std::unordered_set<ProductState, ProductStateHash>& product_states,
-    const std::unordered_map<ProductState, std::unordered_set<ProductState, ProductStateHash>, ProductStateHash>& product_successors
-) {
-    std::unordered_map<ProductState, int, ProductStateHash> index_map;
-    std::unordered_map<ProductState, int, ProductStateHash> lowlink_map;
-    std::unordered_set<ProductState, ProductStateHash> on_stack;
-    std::stack<ProductState> stack;
-    int index = 0;
-    std::vector<std::vector<ProductState>> sccs;
-    
-    std::function<void(const ProductState&)> strongConnect = [&](const ProductState& v) {
-        index_map[v] = index;
-        lowlink_map[v] = index;
-        index++;
-        stack.push(v);
-        on_stack.insert(v);
-        
-        // Process successors
-        auto it = product_successors.find(v);
-        if (it != product_successors.end()) {
-            for (const auto& w : it->second) {
-                if (index_map.find(w) == index_map.end()) {
-                    // Successor w has not yet been visited; recurse
-                    strongConnect(w);
-                    lowlink_map[v] = std::min(lowlink_map[v], lowlink_map[w]);
-                } else if (on_stack.count(w) > 0) {
-                    // Successor w is on the stack and hence in the current SCC
-                    lowlink_map[v] = std::min(lowlink_map[v], index_map[w]);
-                }
+    struct Root { uint32_t index; uint8_t marks; };
+    struct Frame { uint32_t index; std::vector<ProductState> successors; size_t next; };
+
+    std::vector<ProductState> states;                    // by DFS number
+    std::vector<bool> dead;                              // by DFS number
+    std::unordered_map<uint64_t, uint32_t> dfs_number;   // product key -> DFS number
+    std::vector<Root> roots;
+    std::vector<uint32_t> active;                        // states of the open SCCs
+    std::vector<Frame> dfs;
+    size_t product_edges = 0;
+
+    // Enters a product state; returns false if one of its moves is a witness
+    auto enter = [&](const ProductState& ps) {
+        const uint32_t index = static_cast<uint32_t>(states.size());
+        dfs_number.emplace(ps.key(), index);
+        states.push_back(ps);
+        dead.push_back(false);
+
+        uint8_t marks = 0;
+        if (acceptingIn(automaton_B, ps.state_B)) marks |= ACCEPT_B;
+        if (acceptingIn(automaton_notA, ps.state_notA)) marks |= ACCEPT_NOT_A;
+        roots.push_back({index, marks});
+        active.push_back(index);
+
+        // Successors of this state only, generated when it is first entered;
+        // the moves themselves are expanded once per automaton state
+        Frame frame{index, {}, 0};
+        for (const auto& move_B : movesOf(automaton_B, ps.state_B)) {
+            for (const auto& move_notA : movesOf(automaton_notA, ps.state_notA)) {
+                const size_t first = frame.successors.size();
+                if (!combineMoves(move_B, move_notA, frame.successors, automaton_B)) continue;
+                if (frame.successors.size() == first) return false;
             }
         }
-        
-        // If v is a root node, pop the stack and create an SCC
-        if (lowlink_map[v] == index_map[v]) {
-            std::vector<ProductState> scc;
-            ProductState w;
-            do {
-                w = stack.top();
-                stack.pop();
-                on_stack.erase(w);
-                scc.push_back(w);
-            } while (!(w == v));
-            
-            sccs.push_back(scc);
-        }
+        product_edges += frame.successors.size();
+        dfs.push_back(std::move(frame));
+        return true;
     };
-    
-    // Run Tarjan's algorithm on all unvisited states
-    for (const auto& ps : product_states) {
-        if (index_map.find(ps) == index_map.end()) {
-            strongConnect(ps);
-        }
-    }
-    
-    return sccs;
-}
 
-// ============================================================================
-// Determine if a product SCC is accepting
-// ============================================================================
-static bool isProductSCCAccepting(
-    const std::vector<ProductState>& scc,
-    const CTLAutomaton& automaton_B,
-    const CTLAutomaton& automaton_notA
-) {
-    // An SCC in the product is accepting if it satisfies the acceptance
-    // condition from both component automata
-    
-    // For CTL automata with ν/μ fixpoints:
-    // - The product inherits acceptance from both components
-    // - Typically, we need at least one accepting state from each component
-    
-    for (const auto& ps : scc) {
-        bool b_accepting = automaton_B.isAccepting(ps.state_B);
-        bool nota_accepting = automaton_notA.isAccepting(ps.state_notA);
-        
-        // Both must be accepting for the product state to be accepting
-        if (b_accepting && nota_accepting) {
-            return true;
-        }
-    }
-    
-    return false;
-}
+    bool empty = enter({init_B, init_notA});
+    while (empty && !dfs.empty()) {
+        cancellation::checkpoint();
+        Frame& frame = dfs.back();
+        if (frame.next < frame.successors.size()) {
+            const ProductState next = frame.successors[frame.next++];
+            auto it = dfs_number.find(next.key());
+            if (it == dfs_number.end()) {
+                empty = enter(next);  // may invalidate frame
+                continue;
+            }
+            if (dead[it->second]) continue;
 
-// ============================================================================
-// Check if there's a path from initial state to an accepting SCC
-// ============================================================================
-static bool hasPathToAcceptingSCC(
-    const ProductState& initial,
-    const std::vector<std::vector<ProductState>>& sccs,
-    const std::unordered_map<ProductState, std::unordered_set<ProductState, ProductStateHash>, ProductStateHash>& product_successors,
-    const CTLAutomaton& automaton_B,
-    const CTLAutomaton& automaton_notA
-) {
-    // Find accepting SCCs
-    std::unordered_set<ProductState, ProductStateHash> accepting_states;
-    for (const auto& scc : sccs) {
-        if (isProductSCCAccepting(scc, automaton_B, automaton_notA)) {
-            for (const auto& ps : scc) {
-                accepting_states.insert(ps);
+            // Back edge into an open SCC: everything above its root is one SCC
+            uint8_t marks = 0;
+            while (roots.back().index > it->second) {
+                marks |= roots.back().marks;
+                roots.pop_back();
             }
+            roots.back().marks |= marks;
+            if (roots.back().marks == ACCEPT_BOTH) empty = false;
+            continue;
         }
-    }
-    
-    if (accepting_states.empty()) {
-        return false; // No accepting SCCs
-    }
-    
-    // BFS to check reachability from initial to any accepting state
-    std::unordered_set<ProductState, ProductStateHash> visited;
-    std::queue<ProductState> queue;
-    queue.push(initial);
-    visited.insert(initial);
-    
-    while (!queue.empty()) {
-        ProductState current = queue.front();
-        queue.pop();
-        
-        // Check if we reached an accepting state
-        if (accepting_states.count(current) > 0) {
-            return true;
-        }
-        
-        // Explore successors
-        auto it = product_successors.find(current);
-        if (it != product_successors.end()) {
-            for (const auto& succ : it->second) {
-                if (visited.find(succ) == visited.end()) {
-                    visited.insert(succ);
-                    queue.push(succ);
-                }
-            }
+
+        // All successors explored: close the SCC if this state is its root
+        const uint32_t index = frame.index;
+        dfs.pop_back();
+        if (roots.back().index == index) {
+            roots.pop_back();
+            uint32_t member;
+            do {
+                member = active.back();
+                active.pop_back();
+                dead[member] = true;
+            } while (member != index);
         }
     }
-    
-    return false; // No path to accepting SCC
-}
 
-// ============================================================================
-// Helper wrapper for language inclusion checking from member function
-// ============================================================================
-static bool checkLanguageInclusionOTF(
-    const CTLAutomaton& automaton_B,
-    const CTLAutomaton& automaton_notA
-) {
-    std::unordered_map<ProductState, std::vector<Move>, ProductStateHash> product_transitions;
-    std::unordered_set<ProductState, ProductStateHash> product_states;
-    std::unordered_map<ProductState, std::unordered_set<ProductState, ProductStateHash>, ProductStateHash> product_successors;
-    ProductState initial_product_state;
-    
-    buildProductAutomaton(automaton_B, automaton_notA, product_transitions, product_states, product_successors, initial_product_state);
-    
-    auto sccs = computeProductSCCs(product_states, product_successors);
-    
-    bool has_accepting_path = hasPathToAcceptingSCC(initial_product_state, sccs, product_successors, automaton_B, automaton_notA);
-    
-    return !has_accepting_path;
+    Statistics::instance().add(Statistic::PRODUCT_STATES, states.size());
+    Statistics::instance().add(Statistic::PRODUCT_EDGES, product_edges);
+    CTL_LOG(DEBUG, automaton_B.verbose(), "[OTF] Explored " << states.size() << " product states, product is "
+                                          << (empty ? "empty" : "non-empty"));
+    return empty;
 }
 
 
 
 
 // ============================================================================
-// Language inclusion checking L(this) ⊇ L(other)
+// Language inclusion checking L(this) ⊇ L(other), on-the-fly engine
 // ============================================================================
-bool CTLAutomaton::languageIncludes(const CTLAutomaton& other) const {
+bool CTLAutomaton::languageIncludesOF(const CTLAutomaton& other) const {
     // Implementation: checking whether L(this) ⊇ L(other) = L(other & !this) is empty
     if (this->getFormula()->hash() == CTLAutomaton::TRUE_HASH) return true;
     if (other.getFormula()->hash() == CTLAutomaton::FALSE_HASH) return true;
 
-    // Using on-the-fly product construction
-    // Build product automaton for L(other) ∩ L(¬this)
-    
-    // Create negated automaton for L(¬this)
-    auto this_neg = this->getNegatedFormula();
-    CTLAutomaton automaton_notA(*this_neg);
-    
-    // Check if L(other) ∩ L(¬this) is empty using OTF product
-    return checkLanguageInclusionOTF(other, automaton_notA);
+    // Explore the product for L(other) ∩ L(¬this) lazily; ¬this and its
+    // expanded moves are kept for every other pair this automaton includes
+    return checkLanguageInclusionOTF(other, getComplement());
 }
 } // namespace ctl
-#endif // USE_ON_THE_FLY_PRODUCT
-
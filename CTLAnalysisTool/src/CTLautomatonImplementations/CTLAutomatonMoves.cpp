@@ -0,0 +1,135 @@
+#include "CTLautomaton.h"
+#include "trace.h"
+#include "cancellation.h"
+#include "statistics.h"
+#include <algorithm>
+
+// ============================================================================
+// DNF EXPANSION OF TRANSITIONS INTO MOVES
+// ============================================================================
+// A move of state q picks one clause of every transition of q and of every
+// state the chosen clauses reach by ε-literals (direction < 0) at the same
+// tree node. Its atoms are the guards of those transitions, its next states
+// the child obligations of the chosen clauses. Simulation and the on-the-fly
+// product both read moves, so they are expanded once per state and shared by
+// every pair the automaton takes part in.
+// The moves of a state form a disjunction, so a move that subsumes another
+// makes it redundant; only the antichain of minimal moves is kept.
+// ============================================================================
+namespace ctl {
+namespace {
+    // One partial move while clauses are being chosen
+    struct Frame {
+        std::vector<StateId> states;                   // ε-reached states not yet unfolded
+        std::vector<const CTLTransition*> transitions; // transitions without a chosen clause
+        std::vector<bool> unfolded;                    // by state id
+        Move move;
+    };
+} // end anonymous namespace
+
+const std::vector<Move>& CTLAutomaton::getExpandedTransitions(StateId id) const {
+    std::call_once(expanded_once_[id], [&] { expanded_moves_[id] = store_ ? __sharedMoves(id) : __expandMoves(id); });
+    return expanded_moves_[id];
+}
+
+std::vector<Move> CTLAutomaton::__sharedMoves(StateId id) const {
+    // Successors are subformulas of the state's formula, so each has a state here
+    auto localize = [this](const std::vector<Move>& shared, std::vector<Move>& local) {
+        for (const auto& move : shared) {
+            Move& m = local.emplace_back();
+            m.atoms = move.atoms;
+            for (const auto& succ : move.next_states) {
+                auto it = store_states_.find(succ.state);
+                if (it == store_states_.end()) return false;
+                m.addNextState(succ.dir, it->second);
+            }
+        }
+        return true;
+    };
+
+    if (auto shared = store_->moves(store_ids_[id])) {
+        std::vector<Move> moves;
+        if (localize(*shared, moves)) {
+            Statistics::instance().add(Statistic::SHARED_MOVES_REUSED);
+            return moves;
+        }
+    }
+    std::vector<Move> moves = __expandMoves(id);
+    std::vector<Move> shared;
+    shared.reserve(moves.size());
+    for (const auto& move : moves) {
+        Move& m = shared.emplace_back();
+        m.atoms = move.atoms;
+        for (const auto& succ : move.next_states) m.addNextState(succ.dir, store_ids_[succ.state]);
+    }
+    store_->publishMoves(store_ids_[id], std::move(shared));
+    return moves;
+}
+
+std::vector<Move> CTLAutomaton::__expandMoves(StateId id) const {
+    CTL_TRACE_SPAN("automaton", "expand moves");
+    std::vector<Move> moves;
+
+    // Choices only ever add guards and obligations, so a partial move that is
+    // already dominated stays dominated
+    auto dominated = [&moves](const Move& move) {
+        return std::any_of(moves.begin(), moves.end(), [&move](const Move& m) { return m.subsumes(move); });
+    };
+
+    std::vector<Frame> stack;
+    stack.push_back({{id}, {}, std::vector<bool>(numStates(), false), {}});
+    while (!stack.empty()) {
+        cancellation::checkpoint();
+        Frame frame = std::move(stack.back());
+        stack.pop_back();
+        if (dominated(frame.move)) continue;
+
+        // Unfold the states of this node into their transitions
+        while (!frame.states.empty()) {
+            const StateId q = frame.states.back();
+            frame.states.pop_back();
+            if (frame.unfolded[q]) continue;
+            frame.unfolded[q] = true;
+            for (const auto& t : getTransitions(q)) frame.transitions.push_back(t);
+        }
+
+        if (frame.transitions.empty()) {
+            // Not dominated (checked above): drop what it dominates and keep it
+            moves.erase(std::remove_if(moves.begin(), moves.end(),
+                                       [&frame](const Move& m) { return frame.move.subsumes(m); }),
+                        moves.end());
+            moves.push_back(std::move(frame.move));
+            continue;
+        }
+
+        // Fix the transition with the fewest clauses first, so forced guards
+        // prune the unsatisfiable combinations before any real choice
+        size_t pick = 0;
+        for (size_t i = 1; i < frame.transitions.size(); ++i) {
+            if (frame.transitions[i]->clauses.size() < frame.transitions[pick]->clauses.size()) pick = i;
+        }
+        const CTLTransition* t = frame.transitions[pick];
+        frame.transitions[pick] = frame.transitions.back();
+        frame.transitions.pop_back();
+        if (t->guard.isFalse()) continue;
+        if (!t->guard.isTrue() && frame.move.addAtom(t->guard.id) && !isSatisfiable(frame.move.atoms)) {
+            continue;
+        }
+
+        for (const auto& clause : t->clauses) {
+            Frame next = frame;
+            for (const auto& literal : clause.literals) {
+                if (literal.qid == INVALID_STATE_ID) continue;
+                if (literal.dir < 0) {
+                    next.states.push_back(literal.qid);
+                } else {
+                    next.move.addNextState(literal.dir, literal.qid);
+                }
+            }
+            stack.push_back(std::move(next));
+        }
+    }
+    return moves;
+}
+
+} // namespace ctl
@@ -1,81 +1,193 @@
 #include "CTLautomaton.h"
+#include "bit_matrix.h"
+#include "trace.h"
+#include "statistics.h"
+#include "cancellation.h"
+#include "entailment_session.h"
+#include "smt_context_manager.h"
+#include "interval_domain.h"
+#include "truth_table.h"
+#include <algorithm>
+#include <optional>
 #include <queue>
 #include <unordered_set>
 #include <unordered_map>
 
 namespace ctl {
 
-#ifdef USE_Z3
-    
-    
+    // Answers atomic entailment queries for one simulates() call.
+    // Atom sets (sorted guard ids) are interned once; every atom and every
+    // negated conclusion gets an indicator in one entailment session of the
+    // thread's SMT interface, and each query is a check under assumptions.
+    // Verdicts are memoized per (premise, conclusion) set pair,
+    // so later worklist rounds never repeat a solver call.
+    class EntailmentOracle {
+    public:
+        explicit EntailmentOracle(const SMTInterface& smt)
+            : session_(smt.openEntailmentSession()) {}
 
-    // Check if atoms of phi_prime imply atoms of phi (Atomic Entailment)
-    // atoms(φ') => atoms(φ)
-    bool atomicEntailment(const std::unordered_set<std::string>& atoms_phi_prime, 
-                         const std::unordered_set<std::string>& atoms_phi,
-                         z3::context& ctx) {
-        
-        if (atoms_phi.empty()) {
-            return true; // Empty conclusion is always implied
+        // Interns an atom set and returns its id
+        uint32_t intern(std::span<const GuardTable::Id> atoms) {
+            std::vector<GuardTable::Id> key(atoms.begin(), atoms.end());
+            auto [it, inserted] = set_ids_.emplace(std::move(key), static_cast<uint32_t>(sets_.size()));
+            if (inserted) sets_.push_back(&it->first);
+            return it->second;
         }
-        
-        try {
-            // Build conjunction of atoms_phi_prime
-            z3::expr_vector premise_exprs(ctx);
-            for (const auto& atom : atoms_phi_prime) {
-                premise_exprs.push_back(formula_utils::parseStringToZ3(atom, ctx));
+
+        // Check if atoms of phi_prime imply atoms of phi (Atomic Entailment)
+        // atoms(φ') => atoms(φ)
+        bool entails(uint32_t phi_prime, uint32_t phi) {
+            if (sets_[phi]->empty()) {
+                return true; // Empty conclusion is always implied
             }
-            
-            // Build conjunction of atoms_phi  
-            z3::expr_vector conclusion_exprs(ctx);
-            for (const auto& atom : atoms_phi) {
-                conclusion_exprs.push_back(formula_utils::parseStringToZ3(atom, ctx));
+            uint64_t key = (uint64_t{phi_prime} << 32) | phi;
+            auto it = memo_.find(key);
+            if (it != memo_.end()) return it->second;
+            // Bounds on single variables and Boolean atoms need no solver,
+            // nor do propositional guards over few atoms
+            if (auto decided = IntervalDomain::instance().entails(*sets_[phi_prime], *sets_[phi])) {
+                Statistics::instance().add(Statistic::INTERVAL_DECISIONS);
+                memo_.emplace(key, *decided);
+                return *decided;
             }
-            
-            // Check if premise => conclusion
-            // This is equivalent to checking if (premise && !conclusion) is unsat
-            z3::solver s(ctx);
-            if (premise_exprs.size() > 0) {
-                if (premise_exprs.size() == 1) {
-                    s.add(premise_exprs[0]);
-                } else {
-                    s.add(z3::mk_and(premise_exprs));
-                }
+            if (auto decided = TruthTableKernel::instance().entails(*sets_[phi_prime], *sets_[phi])) {
+                Statistics::instance().add(Statistic::TRUTH_TABLE_DECISIONS);
+                memo_.emplace(key, *decided);
+                return *decided;
             }
-            
-            if (conclusion_exprs.size() > 0) {
-                if (conclusion_exprs.size() == 1) {
-                    s.add(!conclusion_exprs[0]);
-                } else {
-                    s.add(!z3::mk_and(conclusion_exprs));
+
+            CTL_TRACE_SPAN("smt", "entailment");
+            SmtQueryScope query;
+            cancellation::checkpoint();
+            bool result = false;
+            try {
+                // premise && !conclusion is unsat iff premise => conclusion
+                std::vector<EntailmentSession::Literal> assumptions;
+                for (GuardTable::Id atom : *sets_[phi_prime]) {
+                    assumptions.push_back(__indicator(atom));
+                }
+                assumptions.push_back(__negatedConclusion(phi));
+                std::optional<unsigned> timeout;
+                if (auto left = cancellation::remaining()) {
+                    timeout = static_cast<unsigned>(std::max<int64_t>(left->count(), 1));
                 }
+                const auto verdict = session_->check(assumptions, timeout);
+                // A query cut off by the check's deadline is no verdict: not memoized
+                if (verdict == EntailmentSession::Verdict::UNKNOWN) cancellation::checkpoint();
+                result = verdict == EntailmentSession::Verdict::UNSAT;
+            } catch (const CheckCancelled&) {
+                throw;
+            } catch (...) {
+                // If we can't parse or check, be conservative
+                result = false;
             }
-            
-            return s.check() == z3::unsat;
-        } catch (...) {
-            // If we can't parse or check, be conservative
-            return false;
+            memo_.emplace(key, result);
+            return result;
         }
-    }
+
+    private:
+        EntailmentSession::Literal __indicator(GuardTable::Id atom) {
+            auto [it, inserted] = atom_indicators_.try_emplace(atom, 0);
+            if (inserted) it->second = session_->assume(atom);
+            return it->second;
+        }
+
+        EntailmentSession::Literal __negatedConclusion(uint32_t phi) {
+            auto [it, inserted] = conclusion_indicators_.try_emplace(phi, 0);
+            if (inserted) it->second = session_->assumeNotAll(*sets_[phi]);
+            return it->second;
+        }
+
+        struct VectorHash {
+            size_t operator()(const std::vector<GuardTable::Id>& v) const {
+                size_t h = 0;
+                for (GuardTable::Id a : v) h = h * 31 + a;
+                return h;
+            }
+        };
+
+        std::unique_ptr<EntailmentSession> session_;
+        std::unordered_map<std::vector<GuardTable::Id>, uint32_t, VectorHash> set_ids_;
+        std::vector<const std::vector<GuardTable::Id>*> sets_;
+        std::unordered_map<GuardTable::Id, EntailmentSession::Literal> atom_indicators_;
+        std::unordered_map<uint32_t, EntailmentSession::Literal> conclusion_indicators_;
+        std::unordered_map<uint64_t, bool> memo_;
+    };
     
-    // Check Successor Consistency for a move (Python-style)
-    // For each next state requirement in move_phi, there must be a corresponding 
-    // requirement in move_phi_prime with the same direction and the pair of 
-    // successor states must be in R
-    bool successorConsistency(const Move& move_phi_prime, const Move& move_phi,
-                              const std::unordered_set<SimPair, SimPairHash>& R) {
-        // For each successor obligation in move_phi (Spoiler's move)
-        for (const auto& pair_phi : move_phi.next_states) {
-            // Find a corresponding successor in move_phi_prime (Duplicator's move)
+    // A move with its atom set interned in the oracle
+    struct IndexedMove {
+        uint32_t atoms;     // interned atom set, see EntailmentOracle
+        StateId base;       // first state of the move's automaton in the relation
+        const Move* move;
+    };
+
+    // The states of one or more automata, numbered one after the other
+    struct SimulationSide {
+        std::vector<std::vector<IndexedMove>> moves;
+        std::vector<std::vector<StateId>> preds;  // states whose moves mention the state
+        std::vector<uint8_t> accepting;
+        std::vector<uint32_t> owner;               // index of the state's automaton
+        std::vector<StateId> base;                 // first state by automaton
+        std::vector<SubformulaStore::Id> ids;      // store id by state, when the automata share a store
+    };
+
+    // The store every automaton uses, null if they do not all use the same one
+    SubformulaStore* sharedStore(std::initializer_list<const CTLAutomaton*> automata) {
+        SubformulaStore* store = (*automata.begin())->subformulaStore();
+        for (const CTLAutomaton* automaton : automata) {
+            if (automaton->subformulaStore() != store) return nullptr;
+        }
+        return store;
+    }
+
+    // Appends owner's states and their DNF moves to side
+    void addAutomaton(SimulationSide& side, const CTLAutomaton& owner, EntailmentOracle& oracle) {
+        CTL_TRACE_SPAN("simulation", "index moves");
+        const StateId base = static_cast<StateId>(side.moves.size());
+        const uint32_t index = static_cast<uint32_t>(side.base.size());
+        side.base.push_back(base);
+        for (StateId id = 0; id < owner.numStates(); ++id) {
+            auto& moves = side.moves.emplace_back();
+            for (const auto& move : owner.getExpandedTransitions(id)) {
+                moves.push_back({oracle.intern(move.atoms), base, &move});
+            }
+            side.accepting.push_back(owner.isAccepting(id));
+            side.owner.push_back(index);
+            if (owner.subformulaStore()) side.ids.push_back(owner.subformulaId(id));
+        }
+    }
 
+    // For every state, the states whose moves mention it as a successor
+    void linkPredecessors(SimulationSide& side) {
+        side.preds.assign(side.moves.size(), {});
+        for (StateId q = 0; q < side.moves.size(); ++q) {
+            for (const auto& move : side.moves[q]) {
+                for (const auto& succ : move.move->next_states) side.preds[move.base + succ.state].push_back(q);
+            }
+        }
+        for (auto& p : side.preds) {
+            std::sort(p.begin(), p.end());
+            p.erase(std::unique(p.begin(), p.end()), p.end());
+        }
+    }
+
+    // Check Successor Consistency for a move (Python-style)
+    // For each next state requirement in move_phi_prime, there must be a
+    // corresponding requirement in move_phi with the same direction and the
+    // pair of successor states must be in R: the Duplicator may not ask a
+    // child for more than the Spoiler already does
+    bool successorConsistency(const IndexedMove& move_phi, const IndexedMove& move_phi_prime,
+                              const BitMatrix& R) {
+        // For each successor obligation in move_phi_prime (Duplicator's move)
+        for (const auto& succ_phi_prime : move_phi_prime.move->next_states) {
+            // Find a corresponding successor in move_phi (Spoiler's move)
             bool found = false;
-            for (const auto& pair_phi_prime : move_phi_prime.next_states) {
+            for (const auto& succ_phi : move_phi.move->next_states) {
                 // Same direction and the pair of states must be in R
-                if (pair_phi.dir == pair_phi_prime.dir) {
-                    if (R.count({pair_phi.state, pair_phi_prime.state}) > 0 || R.count({pair_phi_prime.state, pair_phi.state}) > 0) {
-                        found = true;
-                        break;
-                    }
+                if (succ_phi.dir == succ_phi_prime.dir &&
+                    R.test(move_phi.base + succ_phi.state, move_phi_prime.base + succ_phi_prime.state)) {
+                    found = true;
+                    break;
                 }
             }
             if (!found) {
@@ -89,17 +201,17 @@ namespace ctl {
     // Check if there's a matching move for move_spoiler in the moves of duplicator
     // Returns true if a matching move is found
     // Uses Python-style algorithm logic
-    bool hasMatchingMove(const Move& move_spoiler,
-                        const std::vector<Move>& moves_duplicator,
-                        const std::unordered_set<SimPair, SimPairHash>& R,
-                        z3::context& ctx) {
+    bool hasMatchingMove(const IndexedMove& move_spoiler,
+                        const std::vector<IndexedMove>& moves_duplicator,
+                        const BitMatrix& R,
+                        EntailmentOracle& oracle) {
 
         // For each move from the Duplicator
         for (const auto& move_duplicator : moves_duplicator) {
             // Check (1) Atomic Entailment: atoms(spoiler) => atoms(duplicator)
             // The Spoiler's requirements must be implied by the Duplicator's requirements
             // This means the Duplicator must be "at least as permissive" as the Spoiler
-            if (!atomicEntailment(move_spoiler.atoms, move_duplicator.atoms, ctx)) {
+            if (!oracle.entails(move_spoiler.atoms, move_duplicator.atoms)) {
                 continue; // This move doesn't satisfy atomic entailment
             }
             
@@ -112,6 +224,104 @@ namespace ctl {
         return false; // No matching move found
     }
 
+    // The greatest simulation between the spoiler's and the duplicator's
+    // states. Pairs of states of the same automaton are left out when
+    // cross_only is set: no pair across automata depends on them. With a
+    // store, pairs it has a verdict for are not checked again, and the
+    // verdicts of the other pairs are recorded once the fixpoint is reached.
+    BitMatrix refineSimulation(const SimulationSide& spoiler, const SimulationSide& duplicator,
+                               EntailmentOracle& oracle, bool cross_only, SubformulaStore* store) {
+        const size_t n_self = spoiler.moves.size();
+        const size_t n_other = duplicator.moves.size();
+
+        // Initialize R with all valid pairs (Python approach)
+        // A pair (q_s, q_o) is invalid if q_s is accepting but q_o is not
+        BitMatrix R(n_self, n_other, true);
+        BitMatrix known(n_self, n_other);  // pairs whose verdict came from the store
+        size_t shared = 0;
+        for (StateId i = 0; i < n_self; ++i) {
+            for (StateId j = 0; j < n_other; ++j) {
+                if ((spoiler.accepting[i] && !duplicator.accepting[j]) ||
+                    (cross_only && spoiler.owner[i] == duplicator.owner[j])) {
+                    R.reset(i, j);
+                } else if (store) {
+                    if (auto verdict = store->simulated(spoiler.ids[i], duplicator.ids[j])) {
+                        known.set(i, j);
+                        ++shared;
+                        if (!*verdict) R.reset(i, j);
+                    }
+                }
+            }
+        }
+
+        // Worklist refinement: every pair is checked once, and afterwards only
+        // when a pair its successor check reads has been removed from R
+        CTL_TRACE_SPAN("simulation", "refine relation");
+        const size_t initial_pairs = R.count();
+        size_t iterations = 0;
+        size_t pruned = 0;
+        BitMatrix queued = R;
+        std::vector<std::pair<StateId, StateId>> worklist;
+        worklist.reserve(initial_pairs);
+        for (StateId i = 0; i < n_self; ++i) {
+            for (StateId j = 0; j < n_other; ++j) {
+                if (R.test(i, j) && !known.test(i, j)) worklist.emplace_back(i, j);
+            }
+        }
+
+        auto enqueuePredecessors = [&](StateId s, StateId d) {
+            for (StateId p : spoiler.preds[s]) {
+                for (StateId q : duplicator.preds[d]) {
+                    if (R.test(p, q) && !queued.test(p, q) && !known.test(p, q)) {
+                        queued.set(p, q);
+                        worklist.emplace_back(p, q);
+                    }
+                }
+            }
+        };
+
+        while (!worklist.empty()) {
+            auto [p, q] = worklist.back();
+            worklist.pop_back();
+            queued.reset(p, q);
+            if (!R.test(p, q)) continue;
+            ++iterations;
+            cancellation::checkpoint();
+
+            // For EVERY move the Spoiler makes, the Duplicator must have AT LEAST ONE valid response
+            bool is_pair_good = true;
+            for (const auto& move_spoiler : spoiler.moves[p]) {
+                if (!hasMatchingMove(move_spoiler, duplicator.moves[q], R, oracle)) {
+                    is_pair_good = false;
+                    break;
+                }
+            }
+            if (is_pair_good) continue;
+
+            R.reset(p, q);
+            ++pruned;
+            // Pairs whose successor check reads (p, q)
+            enqueuePredecessors(p, q);
+        }
+        Statistics& statistics = Statistics::instance();
+        statistics.add(Statistic::SIMULATION_CHECKS);
+        statistics.add(Statistic::SIMULATION_INITIAL_PAIRS, initial_pairs);
+        statistics.add(Statistic::SIMULATION_ITERATIONS, iterations);
+        statistics.add(Statistic::SIMULATION_PAIRS_PRUNED, pruned);
+        if (store) {
+            statistics.add(Statistic::SHARED_SIMULATION_VERDICTS, shared);
+            std::vector<SubformulaStore::Verdict> verdicts;
+            for (StateId i = 0; i < n_self; ++i) {
+                for (StateId j = 0; j < n_other; ++j) {
+                    if (known.test(i, j) || (cross_only && spoiler.owner[i] == duplicator.owner[j])) continue;
+                    verdicts.emplace_back(spoiler.ids[i], duplicator.ids[j], R.test(i, j));
+                }
+            }
+            store->recordSimulations(verdicts);
+        }
+        return R;
+    }
+
     bool CTLAutomaton::simulates(const CTLAutomaton& other) const{
         return other.isSimulatedBy(*this);
     }
@@ -138,93 +348,89 @@ namespace ctl {
             // other is empty (false) but this isn't - cannot simulate
             return false;
         }
-        
-        // Create Z3 context for guard checking
-        z3::context ctx;
-        
-        // Pre-compute DNF for all states in both automata (Python approach)
-        auto dnf_self = this->getExpandedTransitions();
-        auto dnf_other = other.getExpandedTransitions();
-        
-        // Initialize R with all valid pairs (Python approach)
-        // A pair (q_s, q_o) is invalid if q_s is accepting but q_o is not
-        std::unordered_set<SimPair, SimPairHash> R;
-        
-        for (const auto& state_this : v_states_) {
-            for (const auto& state_other : other.v_states_) {
-                bool this_accepting = isAccepting(state_this->name);
-                bool other_accepting = other.isAccepting(state_other->name);
-                
-                // Fix the acceptance condition: only exclude if this is accepting but other is not
-                if (!(this_accepting && !other_accepting)) {
-                    SimPair pair{state_this->name, state_other->name};
-                    R.insert(pair);
-                }
-            }
-        }
-
 
-        
-        // Iteratively refine the simulation relation R until fixed point (Python approach)
-        while (true) {
-            std::unordered_set<SimPair, SimPairHash> R_prime;
-            
-            // For each pair currently in the relation
-            for (const auto& pair : R) {
-                bool is_pair_good = true; // Assume valid until proven otherwise
-                
-                const auto& moves_self = dnf_self[pair.q_phi];   // Spoiler's moves
-                const auto& moves_other = dnf_other[pair.q_phi_prime]; // Duplicator's moves
-                
-                // For EVERY move the Spoiler makes...
-                for (const auto& move_spoiler : moves_self) {
-                    // ...the Duplicator must have AT LEAST ONE valid response
-                    if (!hasMatchingMove(move_spoiler, moves_other, R, ctx)) {
-                        // If the Duplicator has no response to this Spoiler move,
-                        // the pair is not in the simulation
-                        is_pair_good = false;
-                        break; // No need to check other moves from the Spoiler
-                    }
-                }
-                
-                // If the Duplicator could counter all of the Spoiler's moves...
-                if (is_pair_good) {
-                    R_prime.insert(pair); // ...keep the pair for the next iteration
-                }
-            }
-            
-            // If the relation did not shrink, we have reached the fixed point
-            if (R == R_prime) {
-                break;
-            }
-            
-            // Otherwise, update R and continue refining
-            R = std::move(R_prime);
-        }
-        
         // The overall simulation holds if the pair of initial states is in the final relation
-        SimPair initial_pair{this->initial_state_, other.initial_state_};
-        bool result = R.count(initial_pair) > 0;
+        return simulationRelation(other).test(getInitialStateId(), other.getInitialStateId());
+    }
 
+    BitMatrix CTLAutomaton::simulationRelation(const CTLAutomaton& other) const {
+        // Borrow this thread's SMT interface (solver + cached guard terms)
+        // and answer every entailment query of this check through one oracle
+        EntailmentOracle oracle(SMTContextManager::local());
         
-        return result;
+        // DNF moves of both automata, expanded once per automaton and reused across pairs
+        SimulationSide self, duplicator;
+        addAutomaton(self, *this, oracle);        // Spoiler's moves
+        addAutomaton(duplicator, other, oracle);  // Duplicator's moves
+        linkPredecessors(self);
+        linkPredecessors(duplicator);
+        return refineSimulation(self, duplicator, oracle, false, sharedStore({this, &other}));
     }
 
-}
+    struct CTLAutomaton::MutualSimulation::Index {
+        EntailmentOracle oracle{SMTContextManager::local()};
+        SimulationSide a, b;
+        SubformulaStore* store = nullptr;
+    };
 
-#else // USE_CVC5 or other solver
+    CTLAutomaton::MutualSimulation::MutualSimulation(const CTLAutomaton& a, const CTLAutomaton& b) : a_(a), b_(b) {}
 
-    // Stub implementation when not using Z3
-    // Simulation checking requires Z3 for the atomic entailment checks
-    bool CTLAutomaton::simulates(const CTLAutomaton& other) const {
-        // Conservative: return false (simulation not supported without Z3)
-        throw std::runtime_error("Simulation checking requires Z3 solver");
-    }
+    CTLAutomaton::MutualSimulation::~MutualSimulation() = default;
 
-    bool CTLAutomaton::isSimulatedBy(const CTLAutomaton& other) const {
-        throw std::runtime_error("Simulation checking requires Z3 solver");
+    bool CTLAutomaton::MutualSimulation::simulated(bool forward) {
+        const CTLAutomaton& self = forward ? a_ : b_;
+        const CTLAutomaton& other = forward ? b_ : a_;
+        // The special cases of isSimulatedBy()
+        if (self.getFormula()->hash() == other.getFormula()->hash() && self.getFormula()->equals(*other.getFormula())) {
+            return true;
+        }
+        if (self.v_states_.empty()) return true;
+        if (other.v_states_.empty()) return false;
+
+        if (!index_) {
+            auto index = std::make_unique<Index>();
+            addAutomaton(index->a, a_, index->oracle);
+            addAutomaton(index->b, b_, index->oracle);
+            linkPredecessors(index->a);
+            linkPredecessors(index->b);
+            index->store = sharedStore({&a_, &b_});
+            index_ = std::move(index);
+        }
+        const SimulationSide& spoiler = forward ? index_->a : index_->b;
+        const SimulationSide& duplicator = forward ? index_->b : index_->a;
+        return refineSimulation(spoiler, duplicator, index_->oracle, false, index_->store)
+            .test(self.getInitialStateId(), other.getInitialStateId());
     }
 
-#endif // USE_Z3
+    BitMatrix CTLAutomaton::simulationPreorder(std::span<const CTLAutomaton* const> automata) {
+        const size_t n = automata.size();
+        BitMatrix preorder(n, n);
+        // The disjoint union of all automata, playing both sides: its
+        // greatest simulation restricted to two automata is their simulation
+        EntailmentOracle oracle(SMTContextManager::local());
+        SimulationSide all;
+        SubformulaStore* store = n > 0 ? automata[0]->subformulaStore() : nullptr;
+        for (const CTLAutomaton* automaton : automata) {
+            addAutomaton(all, *automaton, oracle);
+            if (automaton->subformulaStore() != store) store = nullptr;
+        }
+        linkPredecessors(all);
+        const BitMatrix R = refineSimulation(all, all, oracle, true, store);
 
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                const CTLAutomaton& self = *automata[i];
+                const CTLAutomaton& other = *automata[j];
+                // The special cases of isSimulatedBy()
+                bool simulated;
+                if (i == j || self.getFormula()->equals(*other.getFormula())) simulated = true;
+                else if (self.v_states_.empty()) simulated = true;
+                else if (other.v_states_.empty()) simulated = false;
+                else simulated = R.test(all.base[i] + self.getInitialStateId(), all.base[j] + other.getInitialStateId());
+                if (simulated) preorder.set(i, j);
+            }
+        }
+        return preorder;
+    }
 
+}
@@ -1,6 +1,8 @@
 #include "CTLautomaton.h"
 #include "game_graph.h"
 #include "formula.h"
+#include "log.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -91,21 +93,23 @@ static int assignPriority(const CTLFormula* formula) {
 // Main function to build the symbolic parity game
 SymbolicParityGame CTLAutomaton::buildGameGraph() const {
     SymbolicParityGame game;
+    const size_t n = numStates();
     
     // Store reference to the automaton for move computation
     game.automaton = this;
-    game.initial_state = initial_state_;
+    game.initial_state = getInitialStateId();
     
-    if (verbose_) {
-        std::cout << "\n=== Building Symbolic Parity Game ===" << std::endl;
-        std::cout << "Initial state: " << initial_state_ << std::endl;
-        std::cout << "Total automaton states: " << v_states_.size() << std::endl;
-    }
+    CTL_LOG(DEBUG, verbose_, "\n=== Building Symbolic Parity Game ===\n"
+                             << "Initial state: " << initial_state_ << "\n"
+                             << "Total automaton states: " << v_states_.size());
     
     // For each state in the automaton, create a game node
-    for (const auto& state : v_states_) {
-        std::string_view state_name = state->name;
-        CTLFormulaPtr formula = state->formula;
+    game.nodes.reserve(n);
+    game.owners.reserve(n);
+    game.priorities.reserve(n);
+    for (StateId id = 0; id < n; ++id) {
+        std::string_view state_name = getStateName(id);
+        CTLFormulaPtr formula = v_states_[id]->formula;
         
         // Step 1: Determine the top-level operator for this state
         BinaryOperator top_op = BinaryOperator::NONE;
@@ -127,8 +131,9 @@ SymbolicParityGame CTLAutomaton::buildGameGraph() const {
         int priority = assignPriority(formula.get());
         
         // Create the game node
-        SymbolicGameNode node(state_name, owner, priority, formula, top_op);
-        game.nodes[state_name] = std::move(node);
+        game.nodes.emplace_back(state_name, formula, top_op);
+        game.owners.push_back(owner);
+        game.priorities.push_back(static_cast<uint8_t>(priority));
         
         // Update statistics
         if (owner == Player::Player1_Eloise) {
@@ -143,91 +148,76 @@ SymbolicParityGame CTLAutomaton::buildGameGraph() const {
             game.num_priority1_nodes++;
         }
         
-        if (verbose_ & false) {
-            std::cout << "  State: " << state_name 
-                      << " | Owner: " << (owner == Player::Player1_Eloise ? "P1(Eloise)" : "P2(Abelard)")
-                      << " | Priority: " << priority
-                      << " | Operator: ";
-            switch (top_op) {
-                case BinaryOperator::AND: std::cout << "AND"; break;
-                case BinaryOperator::OR: std::cout << "OR"; break;
-                case BinaryOperator::IMPLIES: std::cout << "IMPLIES"; break;
-                case BinaryOperator::NONE: std::cout << "NONE"; break;
-            }
-            std::cout << std::endl;
-        }
+        CTL_LOG(TRACE, false, "  State: " << state_name
+                              << " | Owner: " << (owner == Player::Player1_Eloise ? "P1(Eloise)" : "P2(Abelard)")
+                              << " | Priority: " << priority
+                              << " | Operator: " << (top_op == BinaryOperator::AND ? "AND"
+                                                     : top_op == BinaryOperator::OR ? "OR"
+                                                     : top_op == BinaryOperator::IMPLIES ? "IMPLIES" : "NONE"));
     }
     
-    // Step 4: Build the edges from transitions
-    if (verbose_) {
-        std::cout << "\n=== Building Edges from Transitions ===" << std::endl;
-    }
+    // Step 4: Build the edges from transitions, grouped by source state
+    CTL_LOG(DEBUG, verbose_, "\n=== Building Edges from Transitions ===");
     
-    for (const auto& state : v_states_) {
-        std::string_view state_name = state->name;
-        
-        // Get transitions for this state
-        auto trans_it = m_transitions_.find(state_name);
-        if (trans_it != m_transitions_.end()) {
-            const auto& transitions = trans_it->second;
+    game.out_offsets.reserve(n + 1);
+    game.out_offsets.push_back(0);
+    game.target_offsets.push_back(0);
+    std::vector<uint32_t> in_degree(n, 0);
+    for (StateId id = 0; id < n; ++id) {
+        for (const CTLTransition* transition : getTransitions(id)) {
+            // Check if the guard is satisfiable using the cached sat_expr pointer
+            // This avoids re-parsing the formula string every time
+            if (!__isSatisfiable(transition->guard))
+                continue;
+            // Each transition is: guard ∧ (∨ Clause)
+            // where Clause is a conjunction of (direction, next_state) pairs
+            game.edges.emplace_back(id, transition);
             
-            for (const auto& transition : transitions) {
-                // Check if the guard is satisfiable using the cached sat_expr pointer
-                // This avoids re-parsing the formula string every time
-                if(!__isSatisfiable(transition->guard))
-                    continue;
-                // Each transition is: guard ∧ (∨ Clause)
-                // where Clause is a conjunction of (direction, next_state) pairs
-                SymbolicGameEdge edge(state_name, transition->guard, transition->clauses);
-                
-                // Add to outgoing edges
-                game.out_edges[state_name].push_back(edge);
-                
-                // Add to incoming edges of all target states
-                // Iterate through all clauses (disjuncts) in the DNF
-                //for (const auto& clause : transition->clauses) {
-                //    // Each clause is a conjunction of (direction, next_state) pairs
-                //    for (const auto& literal : clause.literals) {
-                //        std::string_view target_state = literal.qnext;
-                //        // Ensure the entry exists and add this edge as an incoming edge
-                //        game.in_edges[target_state].push_back(edge);
-                //    }
-                //}
-                
-                game.num_edges++;
-                
-                if (verbose_) {
-                    std::cout << "  Edge from " << state_name 
-                              << " with guard: " << transition->guard.toString()
-                              << " | Clauses: " << transition->clauses.size() << std::endl;
-                }
+            // Its distinct targets, over all clauses (disjuncts) of the DNF
+            const size_t first = game.targets.size();
+            for (const auto& clause : transition->clauses) {
+                for (const auto& literal : clause.literals) game.targets.push_back(literal.qid);
             }
+            std::sort(game.targets.begin() + first, game.targets.end());
+            game.targets.erase(std::unique(game.targets.begin() + first, game.targets.end()), game.targets.end());
+            for (size_t k = first; k < game.targets.size(); ++k) ++in_degree[game.targets[k]];
+            game.target_offsets.push_back(static_cast<uint32_t>(game.targets.size()));
+            
+            game.num_edges++;
+            
+            CTL_LOG(TRACE, verbose_, "  Edge from " << getStateName(id)
+                                     << " with guard: " << transition->guard.toString()
+                                     << " | Clauses: " << transition->clauses.size());
         }
+        game.out_offsets.push_back(static_cast<uint32_t>(game.edges.size()));
     }
     
-    if (verbose_) {
-        std::cout << "\n=== Game Statistics ===" << std::endl;
-        std::cout << "Player 1 (Eloise) nodes: " << game.num_player1_nodes << std::endl;
-        std::cout << "Player 2 (Abelard) nodes: " << game.num_player2_nodes << std::endl;
-        std::cout << "Priority 0 (safe) nodes: " << game.num_priority0_nodes << std::endl;
-        std::cout << "Priority 1 (eventuality) nodes: " << game.num_priority1_nodes << std::endl;
-        std::cout << "Total edges: " << game.num_edges << std::endl;
-        std::cout << "========================\n" << std::endl;
+    // Step 5: Reverse index, each edge once per distinct target
+    game.in_offsets.assign(n + 1, 0);
+    for (StateId id = 0; id < n; ++id) game.in_offsets[id + 1] = game.in_offsets[id] + in_degree[id];
+    game.in_edges.resize(game.in_offsets[n]);
+    std::vector<uint32_t> fill(game.in_offsets.begin(), game.in_offsets.end() - 1);
+    for (uint32_t e = 0; e < game.edges.size(); ++e) {
+        for (StateId target : game.getTargetStates(e)) game.in_edges[fill[target]++] = e;
     }
     
+    CTL_LOG(DEBUG, verbose_, "\n=== Game Statistics ===\n"
+                             << "Player 1 (Eloise) nodes: " << game.num_player1_nodes << "\n"
+                             << "Player 2 (Abelard) nodes: " << game.num_player2_nodes << "\n"
+                             << "Priority 0 (safe) nodes: " << game.num_priority0_nodes << "\n"
+                             << "Priority 1 (eventuality) nodes: " << game.num_priority1_nodes << "\n"
+                             << "Total edges: " << game.num_edges << "\n"
+                             << "========================\n");
+    
     return game;
 }
 
-// Implementation of getMovesFrom for SymbolicParityGame
-// Returns the transition rules for a state (in DNF: list of conjunctions)
-
-
 // Convert the game to a string for debugging
 std::string SymbolicParityGame::toString() const {
     std::ostringstream oss;
     
     oss << "=== Symbolic Parity Game ===" << std::endl;
-    oss << "Initial State: " << initial_state << std::endl;
+    oss << "Initial State: " << (initial_state < nodes.size() ? nodes[initial_state].state_name : "") << std::endl;
     oss << "Total Nodes: " << nodes.size() << std::endl;
     oss << "Player 1 Nodes: " << num_player1_nodes << std::endl;
     oss << "Player 2 Nodes: " << num_player2_nodes << std::endl;
@@ -237,10 +227,11 @@ std::string SymbolicParityGame::toString() const {
     oss << std::endl;
     
     oss << "Nodes:" << std::endl;
-    for (const auto& [state_name, node] : nodes) {
-        oss << "  " << state_name << ":" << std::endl;
-        oss << "    Owner: " << (node.owner == Player::Player1_Eloise ? "Player1 (Eloise)" : "Player2 (Abelard)") << std::endl;
-        oss << "    Priority: " << node.priority << std::endl;
+    for (StateId id = 0; id < nodes.size(); ++id) {
+        const auto& node = nodes[id];
+        oss << "  " << node.state_name << ":" << std::endl;
+        oss << "    Owner: " << (owners[id] == Player::Player1_Eloise ? "Player1 (Eloise)" : "Player2 (Abelard)") << std::endl;
+        oss << "    Priority: " << int(priorities[id]) << std::endl;
         oss << "    Operator: ";
         switch (node.top_operator) {
             case BinaryOperator::AND: oss << "AND"; break;
@@ -255,17 +246,17 @@ std::string SymbolicParityGame::toString() const {
         }
         
         // Print outgoing edges for this node
-        auto edge_it = out_edges.find(state_name);
-        if (edge_it != out_edges.end() && !edge_it->second.empty()) {
-            oss << "    Outgoing Edges: " << edge_it->second.size() << std::endl;
-            for (size_t i = 0; i < edge_it->second.size(); ++i) {
-                const auto& edge = edge_it->second[i];
+        const auto out = getEdgesFrom(id);
+        if (!out.empty()) {
+            oss << "    Outgoing Edges: " << out.size() << std::endl;
+            for (size_t i = 0; i < out.size(); ++i) {
+                const auto& edge = out[i];
                 oss << "      Edge " << (i+1) << ":" << std::endl;
-                oss << "        Guard: " << edge.symbol.toString() << std::endl;
-                oss << "        Clauses: " << edge.clauses.size()  << std::endl;
+                oss << "        Guard: " << edge.symbol().toString() << std::endl;
+                oss << "        Clauses: " << edge.clauses().size()  << std::endl;
                 
-                for (size_t j = 0; j < edge.clauses.size(); ++j) {
-                    const auto& conj = edge.clauses[j];
+                for (size_t j = 0; j < edge.clauses().size(); ++j) {
+                    const auto& conj = edge.clauses()[j];
                     oss << "          Clause " << (j+1) << ": [";
                     for (size_t k = 0; k < conj.literals.size(); ++k) {
                         const auto& literal = conj.literals[k];
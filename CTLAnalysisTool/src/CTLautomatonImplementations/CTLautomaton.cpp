@@ -1,4 +1,5 @@
 #include "CTLautomaton.h"
+#include "automaton_cache.h"
 #include <queue>
 namespace ctl {
 
@@ -104,7 +105,9 @@ std::string_view CTLAutomaton::getStateOfFormula(const CTLFormula& f) const {
     // Use hash-based lookup for O(1) formula comparison
     size_t target_hash = f.hash();
     
-    // Check cache first - this should be the common case after build
+    // Check cache first - this should be the common case after build. The
+    // cache is only written while states are created, so lookups on a frozen
+    // automaton never write
     auto cache_it = formula_hash_to_state_cache_.find(target_hash);
     if (cache_it != formula_hash_to_state_cache_.end()) {
         return cache_it->second;
@@ -116,8 +119,6 @@ std::string_view CTLAutomaton::getStateOfFormula(const CTLFormula& f) const {
         if (state->formula->hash() == target_hash) {
             // Hash matches, now do expensive equals check
             if (state->formula->equals(f)) {
-                // Cache the result for future lookups
-                formula_hash_to_state_cache_[target_hash] = state->name;
                 return state->name;
             }
         }
@@ -129,8 +130,6 @@ std::string_view CTLAutomaton::getStateOfFormula(const CTLFormula& f) const {
     
     for (const auto& state : v_states_) {
         if (state->formula->toString() == target_str) {
-            // Cache this result too
-            formula_hash_to_state_cache_[target_hash] = state->name;
             return state->name;
         }
     }
@@ -149,6 +148,11 @@ bool CTLAutomaton::isAccepting(const std::string_view state_name) const {
     return s_accepting_states_.count(state_name) > 0;
 }
 
+StateId CTLAutomaton::getStateId(std::string_view state_name) const {
+    auto it = state_ids_.find(state_name);
+    return it != state_ids_.end() ? it->second : INVALID_STATE_ID;
+}
+
 std::string CTLAutomaton::getFormulaString() const {
     return p_original_formula_ ? p_original_formula_->toString() : "";
 }
@@ -160,6 +164,28 @@ CTLFormulaPtr CTLAutomaton::getNegatedFormula() const {
     return p_negated_formula_ ? p_negated_formula_->clone() : nullptr;
 }
 
+const CTLAutomaton& CTLAutomaton::getComplement() const {
+    std::call_once(complement_once_, [&] {
+        complement_ = AutomatonCache::instance().obtain(*getNegatedFormula());
+        if (store_) complement_->useSubformulaStore(store_);
+    });
+    return *complement_;
+}
+
+void CTLAutomaton::useSubformulaStore(std::shared_ptr<SubformulaStore> store) {
+    store_ = std::move(store);
+    store_ids_.clear();
+    store_states_.clear();
+    if (complement_) complement_->useSubformulaStore(store_);
+    if (!store_) return;
+    store_ids_.reserve(v_states_.size());
+    for (const auto& state : v_states_) {
+        const SubformulaStore::Id id = store_->id(state->formula);
+        store_ids_.push_back(id);
+        // The state literals of this formula resolve to, as the builder does
+        store_states_.try_emplace(id, getStateId(getStateOfFormula(*state->formula)));
+    }
+}
 
 
 
@@ -167,33 +193,35 @@ CTLFormulaPtr CTLAutomaton::getNegatedFormula() const {
 
 
 
-    std::vector<int>& CTLAutomaton::__getTopologicalOrder() const {
 
-        if (!topological_order_.empty()) {
-            return topological_order_;
+    void CTLAutomaton::__freeze() {
+        // 1) Edges between SCC blocks
+        block_edges_.assign(blocks_->size(), {});
+        for (int i = 0; i < (int)blocks_->size(); ++i) {
+            for (const auto& st : blocks_->blocks[i]) {
+                for (StateId succ : getSuccessors(getStateId(st))) {
+                    int bj = blocks_->getBlockId(getStateName(succ));
+                    if (bj != i) block_edges_[i].insert(bj);
+                }
+            }
         }
 
-        auto& block_edges = __getDAG();
-
-        // 3) Compute topological order of the DAG
-        std::vector<int> topo;
+        // 2) Topological order of the block DAG
         std::vector<int> indeg(blocks_->size(), 0);
         for (int i = 0; i < (int)blocks_->size(); ++i){
-            for (int j : block_edges[i]) indeg[j]++;
+            for (int j : block_edges_[i]) indeg[j]++;
         }
         std::queue<int> q;
         for (int i = 0; i < (int)blocks_->size(); ++i)
             if (indeg[i] == 0) q.push(i);
+        topological_order_.clear();
         while (!q.empty()) {
             int u = q.front(); q.pop();
-            topo.push_back(u);
+            topological_order_.push_back(u);
 
-            for (int v : block_edges[u])
+            for (int v : block_edges_[u])
                 if (--indeg[v] == 0) q.push(v);
         }
-
-        topological_order_ = std::move(topo);
-        return  topological_order_;
     }
 
 
@@ -202,10 +230,7 @@ CTLFormulaPtr CTLAutomaton::getNegatedFormula() const {
 
     bool CTLAutomaton::__isSatisfiable(const Guard& g) const {
         // Use the SMT interface to check satisfiability of the guard
-        if (!smt_interface_) {
-            throw std::runtime_error("SMT interface not initialized");
-        }
-        return smt_interface_->isSatisfiable(g.sat_expr);
+        return __smt().isSatisfiable(g.sat_expr);
     }
 
 
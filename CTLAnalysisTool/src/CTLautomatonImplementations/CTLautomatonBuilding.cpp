@@ -1,26 +1,49 @@
 
 
 #include "CTLautomaton.h"
+#include "guard_sat_cache.h"
+#include "interval_domain.h"
+#include "truth_table.h"
+#include "formula_factory.h"
+#include "flat_formula.h"
+#include "trace.h"
+#include "statistics.h"
+#include "log.h"
+#include "scc.h"
 
 
 #include <sstream>
 #include <algorithm>
 #include <queue>
-#include <stack>
 
 namespace ctl {
 
   void CTLAutomaton::buildFromFormula(const CTLFormula& formula, bool symbolic) {
-    if (verbose_) std::cout << "Building automaton from formula: " << formula.toString() << "\n";
-    p_original_formula_ = std::move(formula_utils::preprocessFormula(formula, false));
-    if (verbose_) std::cout << "Converted formula: " << p_original_formula_->toString() << "\n";
-    p_negated_formula_ = std::move(formula_utils::negateFormula(formula,     false));
-    smt_interface_ = createDefaultSMTInterface();
+    CTL_TRACE_SPAN("automaton", "build");
+    CTL_LOG(DEBUG, verbose_, "Building automaton from formula: " << formula.toString());
+    __setFormula(formula);
     __buildFromFormula( false);
-    blocks_ = std::make_unique<SCCBlocks>(__computeSCCs());
+    Statistics::instance().add(Statistic::AUTOMATA_BUILT);
+    __finishBuild();
+  }
+
+  void CTLAutomaton::__setFormula(const CTLFormula& formula) {
+    // Interned, so closure states share subformula nodes instead of cloning them
+    p_original_formula_ = FormulaFactory::instance().intern(formula_utils::preprocessFormula(formula, false));
+    CTL_LOG(DEBUG, verbose_, "Converted formula: " << p_original_formula_->toString());
+    p_negated_formula_ = FormulaFactory::instance().intern(formula_utils::negateFormula(formula,     false));
+  }
+
+  void CTLAutomaton::__finishBuild() {
+    __buildStateIndex();
+    auto sccs = __computeSCCs();
+    Statistics::instance().add(Statistic::AUTOMATON_STATES, numStates());
+    Statistics::instance().add(Statistic::SCCS, sccs.size());
+    blocks_ = std::make_unique<SCCBlocks>(sccs);
 
     
     //__decideBlockTypes();
+    __freeze();
   }
 
 
@@ -30,43 +53,48 @@ namespace ctl {
 
 
   void CTLAutomaton::__buildFromFormula(bool symbolic) {
-      // Implementation of the actual building logic goes here
+    __createStates();
+    if (p_original_formula_->hash() == TRUE_HASH) {
+        addTransition(initial_state_, GTrue, { Clause{ { /* empty */ } } });
+        return;
+    }
+    if (p_original_formula_->hash() == FALSE_HASH) {
+        __addFalseTransition(initial_state_);
+        return;
+    }
+
+    // 3) Handle state transitions
+    __handleStatesAndTransitions(symbolic);
+
+
+    initial_state_ = getStateOfFormula(*p_original_formula_);
+    
+    
+  }
+
+  void CTLAutomaton::__createStates() {
       s_accepting_states_.clear();
       state_successors_.clear();
       m_transitions_.clear();
       v_states_.clear();
+      arena_ = std::make_unique<Arena>();
 
-    if(p_original_formula_->hash() == TRUE_HASH){
-        auto state = std::make_shared<CTLState>();
-        state->name = "q0";
-        state->formula = p_original_formula_->clone();
-        v_states_.push_back(state);
-        initial_state_ = state->name;
-        formula_hash_to_state_cache_[p_original_formula_->hash()] = state->name;
-        addTransition(state->name, GTrue, { Clause{ { /* empty */ } } });
-        return;
-    }
-
-
-    if (p_original_formula_->hash() == FALSE_HASH)
-    {
-        auto state = std::make_shared<CTLState>();
+    if (p_original_formula_->hash() == TRUE_HASH || p_original_formula_->hash() == FALSE_HASH) {
+        auto state = arena_->create<CTLState>();
         state->name = "q0";
         state->formula = p_original_formula_->clone();
         v_states_.push_back(state);
         initial_state_ = state->name;
         formula_hash_to_state_cache_[p_original_formula_->hash()] = state->name;
-        __addFalseTransition(state->name);
+        s_accepting_states_.insert(state->name);  // non-temporal, like any other such state
         return;
     }
 
-    std::unordered_map<formula_utils::FormulaKey, const CTLFormula*, formula_utils::FormulaKeyHash> seen;
-    std::vector<const CTLFormula*> subs;
-    collectClosureDFS(*p_original_formula_, seen, subs);
+    const std::vector<const CTLFormula*> subs = FlatFormula(*p_original_formula_).closure();
     //std::cout << "Total subformulas collected: " << topo.size() << std::endl;
     // Create one state per subformula
     for (const CTLFormula* sf : subs) {
-        auto state = std::make_shared<CTLState>();
+        auto state = arena_->create<CTLState>();
         state->name = "q" + std::to_string(v_states_.size());
         state->formula = sf->clone();
         v_states_.push_back(state);
@@ -85,13 +113,6 @@ namespace ctl {
             s_accepting_states_.insert(state->name);
         }
     }
-    // 3) Handle state transitions
-    __handleStatesAndTransitions(symbolic);
-
-
-    initial_state_ = getStateOfFormula(*p_original_formula_);
-    
-    
   }
 
 
@@ -100,38 +121,75 @@ void CTLAutomaton::__clean() {
     throw std::runtime_error("CTLAutomaton::__clean not implemented yet.");
 }
 
-bool CTLAutomaton::__isSatisfiable(const std::string& g, bool without_parsing) const {
-    if (!smt_interface_) {
-        throw std::runtime_error("SMT interface not initialized");
+// Bounds on single variables and propositional guards over few atoms need no solver
+static std::optional<bool> decideWithoutSolver(std::span<const GuardTable::Id> ids) {
+    if (auto decided = IntervalDomain::instance().satisfiable(ids)) {
+        Statistics::instance().add(Statistic::INTERVAL_DECISIONS);
+        return decided;
+    }
+    if (auto decided = TruthTableKernel::instance().satisfiable(ids)) {
+        Statistics::instance().add(Statistic::TRUTH_TABLE_DECISIONS);
+        return decided;
     }
+    return std::nullopt;
+}
 
-    bool r= smt_interface_->isSatisfiable(g, without_parsing);
+bool CTLAutomaton::__isSatisfiable(const std::string& g, bool without_parsing) const {
+    auto& cache = GuardSatCache::instance();
+    const std::string key = GuardSatCache::makeKey(g, without_parsing);
+    if (auto cached = cache.lookup(key)) {
+        return *cached;
+    }
+    const GuardTable::Id id = GuardTable::instance().intern(g);
+    std::optional<bool> decided;
+    if (!without_parsing) decided = decideWithoutSolver(std::span(&id, 1));
+    bool r = decided ? *decided : __smt().isSatisfiable(g, without_parsing);
+    cache.insert(key, r);
     return r;
 }
 
 
 bool CTLAutomaton::__isSatisfiable(const std::unordered_set<std::string>& g, bool without_parsing) const {
-    if (!smt_interface_) {
-        throw std::runtime_error("SMT interface not initialized");
+    return guardsSatisfiable(g, without_parsing);
+}
+
+bool CTLAutomaton::guardsSatisfiable(const std::unordered_set<std::string>& g, bool without_parsing) {
+    // A single-atom set shares its entry with the plain string query
+    auto& cache = GuardSatCache::instance();
+    const std::string key = g.size() == 1 ? GuardSatCache::makeKey(*g.begin(), without_parsing)
+                                          : GuardSatCache::makeKey(g, without_parsing);
+    if (auto cached = cache.lookup(key)) {
+        return *cached;
+    }
+    std::optional<bool> decided;
+    if (!without_parsing) {
+        std::vector<GuardTable::Id> ids;
+        ids.reserve(g.size());
+        for (const auto& guard : g) ids.push_back(GuardTable::instance().intern(guard));
+        decided = decideWithoutSolver(ids);
+    }
+    bool r = decided ? *decided : SMTContextManager::guards().isSatisfiable(g, without_parsing);
+    cache.insert(key, r);
+    return r;
+}
+
+bool CTLAutomaton::isSatisfiable(std::span<const GuardTable::Id> atoms) const {
+    std::unordered_set<std::string> texts;
+    for (GuardTable::Id id : atoms) {
+        if (id == GuardTable::FALSE_ID) return false;
+        if (id != GuardTable::TRUE_ID) texts.insert(GuardTable::instance().text(id));
     }
-    return smt_interface_->isSatisfiable(g, without_parsing);
+    if (texts.empty()) return true;
+    return __isSatisfiable(texts);
 }
 
 Guard CTLAutomaton::createGuardFromString(const std::string& guard) const{
-    if (!smt_interface_) {
-        throw std::runtime_error("SMT interface not initialized");
-    }
-    Guard g;
-    g.pretty_string = guard;
-    g.sat_expr = nullptr;  // Not using the pointer due to Z3 lifetime issues
-    
+    // sat_expr stays null: Z3 terms do not outlive their context
     // Check satisfiability - if UNSAT, replace with "false"
     if (!__isSatisfiable(guard, false)) {
-        g.pretty_string = GFalse;
-        return g;
+        return Guard(GFalse);
     }
-    
-    return g;
+    return Guard(guard);
 }
 
 
@@ -164,8 +222,14 @@ Guard CTLAutomaton::createGuardFromString(const std::string& guard) const{
                              const std::string& guard,
                              const std::vector<Clause>& clauses,
                              bool is_dnf) {
+      __addTransition(from, createGuardFromString(guard), clauses, is_dnf);
+  };
+
+  void CTLAutomaton::__addTransition(const std::string_view from,
+                                     Guard guard,
+                                     const std::vector<Clause>& clauses,
+                                     bool is_dnf) {
       // Record edges for SCCs
- 
       auto& succs = state_successors_[from];
       for (const auto& c : clauses) {
           for (const auto& a : c.literals) {
@@ -173,18 +237,22 @@ Guard CTLAutomaton::createGuardFromString(const std::string& guard) const{
           }
       }
       // Single transition object
-      CTLTransitionPtr t = std::make_shared<CTLTransition>();
-        t->guard     = createGuardFromString(guard);
-        t->clauses = clauses;
+      // Clauses and their literals are flattened into the arena
+      CTLTransitionPtr t = arena_->create<CTLTransition>();
+        t->guard     = std::move(guard);
+        t->clauses = arena_->allocateArray<ClauseView>(clauses.size());
+        for (size_t i = 0; i < clauses.size(); ++i) {
+            t->clauses[i].literals = arena_->copyArray<Literal>(clauses[i].literals.begin(), clauses[i].literals.end());
+        }
         t->is_dnf = is_dnf;
         t->from      = from;
-        m_transitions_[from].push_back(std::move(t));
+        m_transitions_[from].push_back(t);
 //
       //
       //t->guard     = createGuardFromString(guard);
       //t->clauses = clauses;
       //t->from      = from;
-      //m_transitions_[from].push_back(std::move(t));
+      //m_transitions_[from].push_back(t);
   };
 
 
@@ -247,6 +315,26 @@ Guard CTLAutomaton::createGuardFromString(const std::string& guard) const{
         addTransition(state->name, GTrue, { Clause{ { { L, sub }, { R, sub } } } });
   }
 
+  std::pair<CTLStatePtr, CTLStatePtr> CTLAutomaton::__addReleaseHelpers(const CTLStatePtr& state) {
+      auto t = std::static_pointer_cast<TemporalFormula>(state->formula);
+      auto helper_ax_formula = std::make_shared<TemporalFormula>(TemporalOperator::AX, t->clone());
+
+      auto helper_or_formula = std::make_shared<BinaryFormula>(
+          t->operand->clone(),
+          BinaryOperator::OR,
+          helper_ax_formula
+      );
+
+      auto new_state_ax = arena_->create<CTLState>(CTLState{ state->name + "_ax", helper_ax_formula->clone() });
+      v_states_.push_back(new_state_ax);
+      formula_hash_to_state_cache_[helper_ax_formula->hash()] = new_state_ax->name;
+
+      auto new_state_or = arena_->create<CTLState>(CTLState{ state->name + "_or", helper_or_formula->clone() });
+      v_states_.push_back(new_state_or);
+      formula_hash_to_state_cache_[helper_or_formula->hash()] = new_state_or->name;
+      return { new_state_ax, new_state_or };
+  }
+
   void CTLAutomaton::__handleStatesAndTransitions(bool symbolic)
   {
 
@@ -547,24 +635,7 @@ Guard CTLAutomaton::createGuardFromString(const std::string& guard) const{
                     // NOTE: 't' is the shared_ptr to the current TemporalFormula A(φ R ψ).
 
 
-                    auto helper_ax_formula = std::make_shared<TemporalFormula>(TemporalOperator::AX, t->clone());
-
-                    auto helper_or_formula = std::make_shared<BinaryFormula>(
-                        phi->clone(),
-                        BinaryOperator::OR,
-                        helper_ax_formula
-                    );
-
-                    std::string s_helper_ax_name = state->name + "_ax";
-                    auto new_state_ax = std::make_shared<CTLState>(CTLState{ s_helper_ax_name, helper_ax_formula->clone() });
-                    v_states_.push_back(new_state_ax);
-                    formula_hash_to_state_cache_[helper_ax_formula->hash()] = new_state_ax->name;
-
-
-                    std::string s_helper_or_name = state->name + "_or";
-                    auto new_state_or = std::make_shared<CTLState>(CTLState{ s_helper_or_name, helper_or_formula->clone() });
-                    v_states_.push_back(new_state_or);
-                    formula_hash_to_state_cache_[helper_or_formula->hash()] = new_state_or->name;
+                    auto [new_state_ax, new_state_or] = __addReleaseHelpers(state);
 
 
 
@@ -669,7 +740,7 @@ Guard CTLAutomaton::createGuardFromString(const std::string& guard) const{
 
 
 
-    void CTLAutomaton::__decideBlockTypes() const {
+    void CTLAutomaton::__decideBlockTypes() {
         // loop through each block, get the state and decide its type
         for (size_t i = 0; i < blocks_->blocks.size(); ++i) {
             // Check for μ/ν
@@ -701,11 +772,11 @@ Guard CTLAutomaton::createGuardFromString(const std::string& guard) const{
                 final_acceptance_type = acceptance_in_block[0];
                 bool all_same = std::all_of(acceptance_in_block.begin(), acceptance_in_block.end(),
                                             [final_acceptance_type](SCCAcceptanceType t) { return t == final_acceptance_type; });
-                if (!all_same) std::cerr << "Warning: Mixed block types in block " << i << "\n";
+                if (!all_same) CTL_LOG_WARN("Warning: Mixed block types in block " << i);
                 final_block_type = block_types_in_block[0];
                 all_same = std::all_of(block_types_in_block.begin(), block_types_in_block.end(),
                                             [final_block_type](SCCBlockType t) { return t == final_block_type; });
-                if (!all_same) std::cerr << "Warning: Mixed existential/universal types in block " << i << "\n";
+                if (!all_same) CTL_LOG_WARN("Warning: Mixed existential/universal types in block " << i);
             }else throw std::runtime_error("Error: Empty block found when deciding block types.");
             // Check for acceptance
             
@@ -717,64 +788,68 @@ Guard CTLAutomaton::createGuardFromString(const std::string& guard) const{
 
 
 
-  std::vector<std::vector<std::string_view>> CTLAutomaton::__computeSCCs() const {
-
-      std::vector<std::string_view> V; V.reserve(state_successors_.size());
-      std::unordered_map<std::string_view, int> idx; idx.reserve(state_successors_.size());
-
-      V.reserve(state_successors_.size());
-      for (const auto& kv : state_successors_) {
-          idx.emplace(kv.first, static_cast<int>(V.size()));
-          V.push_back(kv.first);
-      }
-      if (!idx.count(initial_state_)) {
-          // In case the initial state has no registered successors yet
-          idx.emplace(initial_state_, static_cast<int>(V.size()));
-          V.push_back(initial_state_);
+  void CTLAutomaton::__buildStateIndex() {
+      const size_t n = v_states_.size();
+      state_ids_.clear();
+      state_ids_.reserve(n);
+      for (size_t i = 0; i < n; ++i) {
+          state_ids_.emplace(v_states_[i]->name, static_cast<StateId>(i));
       }
-
-      const int n = static_cast<int>(V.size());
-      std::vector<int> index(n, -1), low(n, 0);
-      std::vector<char> onstack(n, 0);
-      std::stack<int> st;
-      int timer = 0;
-      std::vector<std::vector<std::string_view>> sccs;
-
-      std::function<void(int)> dfs = [&](int v){
-          index[v] = low[v] = timer++;
-          st.push(v); onstack[v] = 1;
-
-          const std::string_view sv = V[v];
-          auto it = state_successors_.find(sv);
-          if (it != state_successors_.end()) {
-              for (const auto& succ : it->second) {
-                  auto jt = idx.find(succ);
-                  if (jt == idx.end()) continue; // unknown state (shouldn't happen)
-                  int w = jt->second;
-                  if (index[w] == -1) {
-                      dfs(w);
-                      low[v] = std::min(low[v], low[w]);
-                  } else if (onstack[w]) {
-                      low[v] = std::min(low[v], index[w]);
+      initial_state_id_ = getStateId(initial_state_);
+
+      // Resolve every literal once so later passes never hash a state name
+      for (auto& [from, tlist] : m_transitions_) {
+          for (auto& t : tlist) {
+              for (auto& clause : t->clauses) {
+                  for (auto& lit : clause.literals) {
+                      lit.qid = getStateId(lit.qnext);
                   }
               }
           }
+      }
 
-          if (low[v] == index[v]) {
-              // root of SCC
-              std::vector<std::string_view> comp;
-              while (true) {
-                  int w = st.top(); st.pop(); onstack[w] = 0;
-                  comp.push_back(std::string_view(V[w]));
-                  if (w == v) break;
+      succ_offsets_.assign(n + 1, 0);
+      succ_targets_.clear();
+      trans_offsets_.assign(n + 1, 0);
+      trans_flat_.clear();
+      accepting_bits_.assign((n + 63) / 64, 0);
+
+      for (size_t i = 0; i < n; ++i) {
+          std::string_view name = v_states_[i]->name;
+
+          auto sit = state_successors_.find(name);
+          if (sit != state_successors_.end()) {
+              for (const auto& succ : sit->second) {
+                  StateId sid = getStateId(succ);
+                  if (sid != INVALID_STATE_ID) succ_targets_.push_back(sid);
               }
+              // Keep each row sorted for deterministic traversal
+              std::sort(succ_targets_.begin() + succ_offsets_[i], succ_targets_.end());
+          }
+          succ_offsets_[i + 1] = static_cast<uint32_t>(succ_targets_.size());
 
-              sccs.push_back(comp);
+          auto tit = m_transitions_.find(name);
+          if (tit != m_transitions_.end()) {
+              trans_flat_.insert(trans_flat_.end(), tit->second.begin(), tit->second.end());
           }
-      };
+          trans_offsets_[i + 1] = static_cast<uint32_t>(trans_flat_.size());
 
-      for (int v = 0; v < n; ++v) {
-          if (index[v] == -1) dfs(v);
+          if (s_accepting_states_.count(name)) {
+              accepting_bits_[i >> 6] |= (uint64_t{1} << (i & 63));
+          }
+      }
+
+      expanded_moves_.assign(n, {});
+      expanded_once_ = std::make_unique<std::once_flag[]>(n);
+  }
+
+  std::vector<std::vector<std::string_view>> CTLAutomaton::__computeSCCs() const {
+      const SCCDecomposition components =
+          stronglyConnectedComponents(CSRGraphView<StateId>{succ_offsets_, succ_targets_});
+      std::vector<std::vector<std::string_view>> sccs(components.size());
+      for (size_t c = 0; c < components.size(); ++c) {
+          sccs[c].reserve(components[c].size());
+          for (uint32_t v : components[c]) sccs[c].push_back(getStateName(static_cast<StateId>(v)));
       }
       return sccs;
   }
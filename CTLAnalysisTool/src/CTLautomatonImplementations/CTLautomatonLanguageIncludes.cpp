@@ -1,28 +1,75 @@
 #include "CTLautomaton.h"
+#include "automaton_cache.h"
+#include "log.h"
+#include "cancellation.h"
 
 #include <queue>
 
 namespace ctl {
 
-    #ifndef USE_ON_THE_FLY_PRODUCT
-        
-        bool CTLAutomaton::languageIncludes(const CTLAutomaton& other) const {
-            //// Implementation
-            //// the implementation is checking whether L(this) ⊇ L(other) = L(other & !this) 
-            if (this->getFormula()->hash() == TRUE_HASH) return true;
-            if (other.getFormula()->hash() == FALSE_HASH) return true;
-            //std::cout << "Checking language inclusion L(this) ⊇ L(other) by checking emptiness of L(other & !this).\n";
-            //std::cout << "This automaton formula: " << this->getFormula()->toString() << "\n";
-            //std::cout << "Other automaton formula: " << other.getFormula()->toString() << "\n";
-            auto this_neg = this->getNegatedFormula();
-            auto other_prop = other.getFormula();
-            auto combined = std::make_shared<BinaryFormula>(
-                other_prop, BinaryOperator::AND, this_neg);
-            CTLAutomaton combined_automaton(*combined);
-
-            return combined_automaton.isEmpty();
+    namespace {
+        // Above this many product states the fixpoint engine is used by AUTO:
+        // every on-the-fly product state pays one SMT query per pair of moves
+        constexpr size_t kOnTheFlyProductLimit = 4096;
+    }
+
+    bool CTLAutomaton::languageIncludes(const CTLAutomaton& other, EmptinessEngine engine) const {
+        switch (engine) {
+            case EmptinessEngine::FIXPOINT:
+                return __languageIncludesFixpoint(other);
+            case EmptinessEngine::ON_THE_FLY:
+                // The pair product only proves inclusion; its witnesses are confirmed
+                return languageIncludesOF(other) || __languageIncludesFixpoint(other);
+            case EmptinessEngine::ANTICHAIN:
+                return languageIncludesAntichain(other);
+            case EmptinessEngine::AUTO:
+                break;
+        }
+
+        if (chooseEmptinessEngine(*this, other) == EmptinessEngine::FIXPOINT) {
+            return __languageIncludesFixpoint(other);
+        }
+        try {
+            return languageIncludesOF(other) || __languageIncludesFixpoint(other);
+        } catch (const CheckCancelled&) {
+            throw;
+        } catch (const std::runtime_error& e) {
+            // AUTO never fails where the fixpoint engine would answer
+            CTL_LOG(DEBUG, verbose_, "On-the-fly product unavailable (" << e.what() << "), using fixpoint engine.");
+            return __languageIncludesFixpoint(other);
         }
-    #endif // USE_ON_THE_FLY_PRODUCT
+    }
+
+    EmptinessEngine CTLAutomaton::chooseEmptinessEngine(const CTLAutomaton& including, const CTLAutomaton& included) {
+        // ¬including has about as many states as including
+        const size_t product_states = including.numStates() * included.numStates();
+        if (product_states > kOnTheFlyProductLimit) return EmptinessEngine::FIXPOINT;
+        // Only simple blocks: the parity game has no alternation and is cheap to solve
+        if (including.numNonSimpleBlocks() + included.numNonSimpleBlocks() == 0) return EmptinessEngine::FIXPOINT;
+        // Small product with fixpoint blocks: try to prove inclusion on the pair product first
+        return EmptinessEngine::ON_THE_FLY;
+    }
+
+    size_t CTLAutomaton::numNonSimpleBlocks() const {
+        if (!blocks_) return 0;
+        size_t count = 0;
+        for (const auto& [id, info] : blocks_->block_info) {
+            if (info.type != SCCAcceptanceType::SIMPLE) ++count;
+        }
+        return count;
+    }
+
+    bool CTLAutomaton::__languageIncludesFixpoint(const CTLAutomaton& other) const {
+        //// Implementation
+        //// the implementation is checking whether L(this) ⊇ L(other) = L(other & !this)
+        if (this->getFormula()->hash() == TRUE_HASH) return true;
+        if (other.getFormula()->hash() == FALSE_HASH) return true;
+        auto this_neg = this->getNegatedFormula();
+        auto other_prop = other.getFormula();
+        auto combined = std::make_shared<BinaryFormula>(
+            other_prop, BinaryOperator::AND, this_neg);
+        return AutomatonCache::instance().obtain(*combined)->isEmpty();
+    }
 
 
-}
\ No newline at end of file
+}
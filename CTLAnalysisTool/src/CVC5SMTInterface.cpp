@@ -1,13 +1,19 @@
 #include "SMTInterfaces/CVC5SMTInterface.h"
+#include "entailment_session.h"
 #include "formula_utils.h"
+#include "trace.h"
+#include "statistics.h"
+#include "cancellation.h"
 #include <stdexcept>
 
 namespace ctl {
 
 #ifdef USE_CVC5
 
-CVC5SMTInterface::CVC5SMTInterface() 
+CVC5SMTInterface::CVC5SMTInterface()
     : solver_(std::make_unique<cvc5::Solver>()) {
+    // Every query is a checkSatAssuming() on this one solver
+    solver_->setOption("incremental", "true");
     // Set logic if needed (optional, CVC5 can auto-detect)
     // solver_->setLogic("QF_LIA"); // Quantifier-free linear integer arithmetic
 }
@@ -16,7 +22,7 @@ bool CVC5SMTInterface::isSatisfiable(const std::string& formula, bool without_pa
     // Handle special cases
     if (formula == "true") return true;
     if (formula.empty() || formula == "false") return false;
-    
+
     // Delegate to the set-based version
     return isSatisfiable(std::unordered_set<std::string>{formula}, without_parsing);
 }
@@ -24,48 +30,156 @@ bool CVC5SMTInterface::isSatisfiable(const std::string& formula, bool without_pa
 bool CVC5SMTInterface::isSatisfiable(const std::unordered_set<std::string>& formulas, bool without_parsing) const {
     // Handle empty set
     if (formulas.empty()) return true;
-    
+    CTL_TRACE_SPAN("smt", "isSatisfiable");
+    SmtQueryScope query;
+
+    // The formulas are assumptions: nothing is asserted, so nothing has to be popped
+    std::vector<cvc5::Term> assumptions;
+    assumptions.reserve(formulas.size());
     try {
-        // Push a new scope to ensure we can clean up
-        solver_->push();
-        
-        // Add all formulas to the solver
         for (const auto& formula : formulas) {
             // Skip special cases
             if (formula == "true" || formula.empty()) continue;
-            if (formula == "false") {
-                solver_->pop();
-                return false;
-            }
-            
-            // Parse and add the formula
-            cvc5::Term term = parseToCVC5Term(formula);
-            solver_->assertFormula(term);
+            if (formula == "false") return false;
+            assumptions.push_back(getTerm(formula));
         }
-        
-        // Check satisfiability
-        cvc5::Result result = solver_->checkSat();
-        bool is_sat = result.isSat();
-        
-        // Pop the scope to clean up
-        solver_->pop();
-        
-        return is_sat;
-        
+        if (assumptions.empty()) return true;
+        return __checkSat(assumptions);
+    } catch (const CheckCancelled&) {
+        throw;
+    } catch (const std::exception& e) {
+        throw std::runtime_error(std::string("CVC5 satisfiability check failed: ") + e.what());
+    }
+}
+
+bool CVC5SMTInterface::isSatisfiable(void* formula) const {
+    if (formula == nullptr) return true; // empty formula is satisfiable
+    CTL_TRACE_SPAN("smt", "isSatisfiable");
+    SmtQueryScope query;
+    try {
+        return __checkSat({*static_cast<cvc5::Term*>(formula)});
+    } catch (const CheckCancelled&) {
+        throw;
     } catch (const std::exception& e) {
-        // Make sure to pop even on exception
+        throw std::runtime_error(std::string("CVC5 satisfiability check failed: ") + e.what());
+    }
+}
+
+std::string CVC5SMTInterface::simplify(const std::string& formula) const {
+    return solver_->simplify(getTerm(formula)).toString();
+}
+
+void* CVC5SMTInterface::createAndSimplify(const std::string& formula) const {
+    return __handle(solver_->simplify(getTerm(formula)));
+}
+
+void* CVC5SMTInterface::makeOr(void* left, void* right) const {
+    return __handle(solver_->mkTerm(cvc5::Kind::OR,
+                                    {*static_cast<cvc5::Term*>(left), *static_cast<cvc5::Term*>(right)}));
+}
+
+void* CVC5SMTInterface::makeAnd(void* left, void* right) const {
+    return __handle(solver_->mkTerm(cvc5::Kind::AND,
+                                    {*static_cast<cvc5::Term*>(left), *static_cast<cvc5::Term*>(right)}));
+}
+
+void* CVC5SMTInterface::__handle(cvc5::Term term) const {
+    handles_.push_back(std::move(term));
+    return &handles_.back();
+}
+
+const cvc5::Term& CVC5SMTInterface::getTerm(const std::string& formula) const {
+    auto it = term_cache_.find(formula);
+    if (it != term_cache_.end()) {
+        return it->second;
+    }
+    // Lower from the formula AST instead of re-scanning the string on every query
+    cvc5::Term term = formula_utils::guardToCVC5(formula, *solver_, symbols_);
+    return term_cache_.emplace(formula, term).first->second;
+}
+
+cvc5::Result CVC5SMTInterface::checkAssuming(const std::vector<cvc5::Term>& assumptions,
+                                             std::optional<unsigned> timeout_ms) const {
+    if (timeout_ms || timeout_set_) {
+        // 0 lifts the limit
+        solver_->setOption("tlimit-per", std::to_string(timeout_ms ? std::max(*timeout_ms, 1u) : 0u));
+        timeout_set_ = timeout_ms.has_value();
+    }
+    return solver_->checkSatAssuming(assumptions);
+}
+
+bool CVC5SMTInterface::__checkSat(const std::vector<cvc5::Term>& assumptions) const {
+    cancellation::checkpoint();
+    std::optional<unsigned> timeout;
+    if (auto remaining = cancellation::remaining()) {
+        timeout = static_cast<unsigned>(std::max<long long>(remaining->count(), 1));
+    }
+    cvc5::Result result = checkAssuming(assumptions, timeout);
+    // unknown from a time-limited query is the deadline if it has passed
+    if (result.isUnknown() && timeout) cancellation::checkpoint();
+    return result.isSat();
+}
+
+namespace {
+
+class CVC5EntailmentSession : public EntailmentSession {
+public:
+    // The indicators live in a scope of their own, popped with the session
+    explicit CVC5EntailmentSession(const CVC5SMTInterface& smt) : smt_(smt), solver_(smt.getSolver()) {
+        solver_.push();
+    }
+    ~CVC5EntailmentSession() override {
         try {
-            solver_->pop();
+            solver_.pop();
         } catch (...) {
             // Ignore errors during cleanup
         }
-        throw std::runtime_error(std::string("CVC5 satisfiability check failed: ") + e.what());
     }
-}
 
-cvc5::Term CVC5SMTInterface::parseToCVC5Term(const std::string& str) const {
-    // Use the formula_utils parser
-    return formula_utils::parseStringToCVC5(str, *solver_);
+    Literal assume(GuardTable::Id guard) override {
+        return __indicate(smt_.getTerm(GuardTable::instance().text(guard)));
+    }
+
+    Literal assumeNotAll(std::span<const GuardTable::Id> guards) override {
+        std::vector<cvc5::Term> conjunction;
+        for (GuardTable::Id guard : guards) {
+            conjunction.push_back(smt_.getTerm(GuardTable::instance().text(guard)));
+        }
+        // AND takes at least two children
+        cvc5::Term all = conjunction.empty() ? solver_.mkTrue()
+                       : conjunction.size() == 1 ? conjunction.front()
+                       : solver_.mkTerm(cvc5::Kind::AND, conjunction);
+        return __indicate(solver_.mkTerm(cvc5::Kind::NOT, {all}));
+    }
+
+    Verdict check(std::span<const Literal> assumptions, std::optional<unsigned> timeout_ms) override {
+        std::vector<cvc5::Term> assumed;
+        assumed.reserve(assumptions.size());
+        for (Literal literal : assumptions) assumed.push_back(indicators_[literal]);
+        const cvc5::Result result = smt_.checkAssuming(assumed, timeout_ms);
+        if (result.isSat()) return Verdict::SAT;
+        if (result.isUnsat()) return Verdict::UNSAT;
+        return Verdict::UNKNOWN;
+    }
+
+private:
+    Literal __indicate(const cvc5::Term& condition) {
+        // mkConst() makes a fresh constant whatever the name
+        cvc5::Term indicator = solver_.mkConst(solver_.getBooleanSort(), "__ent" + std::to_string(indicators_.size()));
+        solver_.assertFormula(solver_.mkTerm(cvc5::Kind::IMPLIES, {indicator, condition}));
+        indicators_.push_back(indicator);
+        return static_cast<Literal>(indicators_.size() - 1);
+    }
+
+    const CVC5SMTInterface& smt_;
+    cvc5::Solver& solver_;
+    std::vector<cvc5::Term> indicators_;  // by literal
+};
+
+} // namespace
+
+std::unique_ptr<EntailmentSession> CVC5SMTInterface::openEntailmentSession() const {
+    return std::make_unique<CVC5EntailmentSession>(*this);
 }
 
 std::unique_ptr<SMTInterface> CVC5SMTInterface::clone() const {
@@ -1,4 +1,5 @@
 #include "ExternalCTLSAT/ctl_sat.h"
+#include "log.h"
 #include <cstdlib>
 #include <sstream>
 #include <stdexcept>
@@ -17,56 +18,76 @@ CTLSATInterface::CTLSATInterface(const std::string& ctl_sat_path)
      }
 
 std::string CTLSATInterface::runCTLSAT(const std::string& formula) const {
-    if (verbose_) std::cout << "Running: "<< formula << "\n";
-    std::string command = sat_path_ + " \"" + formula + "\"";
-    std::array<char, 2048*4> buffer;
-    std::string result;
-    
-    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(command.c_str(), "r"), pclose);
-    if (!pipe) {
-        throw std::runtime_error("Failed to run CTL-SAT command: " + command);
+    CTL_LOG(DEBUG, verbose_, "Running: "<< formula);
+    ProcessResult run = process_pool_->run({sat_path_, formula});
+    if (run.timed_out) {
+        throw std::runtime_error("CTL-SAT timed out after " +
+                                 std::to_string(process_pool_->timeout().count()) + " ms");
     }
     
-    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-        result += buffer.data();
+    return run.output;
+}
+
+SatVerdict CTLSATInterface::checkSatisfiable(const std::string& formula) const {
+    // Each query starts from a fresh (thread-local) atom mapping
+    CTLSATParser::clearComparisonMapping();
+    std::string ctl_sat_formula;
+    try {
+        CTL_LOG(DEBUG, verbose_, "Satisfiability check for formula: " << formula);
+        ctl_sat_formula = toCTLSATSyntax(formula);
+    } catch (const std::exception& e) {
+        CTL_LOG_ERROR("Exception in isSatisfiable: " << e.what());
+        return SatVerdict::ERROR;
     }
-    //std::cout << "Result: "<< result << "\n";
-    
-    return result;
+    return __checkTranslated(ctl_sat_formula, formula);
+}
+
+std::string CTLSATInterface::__translate(const std::string& formula) const {
+    return CTLSATParser::convertString(formula, mapping_);
+}
+
+void CTLSATInterface::__resetMapping() const {
+    mapping_ = CTLSATParser::Mapping();
+}
+
+std::string CTLSATInterface::__refinementQuery(const std::string& refining, const std::string& refined) const {
+    return CTLSATParser::refinementQuery(refining, refined);
 }
 
-bool CTLSATInterface::isSatisfiable(const std::string& formula, bool with_clearing) const {
-    if (with_clearing) CTLSATParser::clearComparisonMapping();
+SatVerdict CTLSATInterface::__checkTranslated(const std::string& ctl_sat_formula, const std::string& formula) const {
     try {
-        //std::cout << "checking for " << formula << "\n";
-        if(verbose_) std::cout << "Satisfiability check for formula: " << formula << "\n";
-        std::string ctl_sat_formula = toCTLSATSyntax(formula);
-        std::string output = runCTLSAT(ctl_sat_formula);
-        //std::cout << "Output: " << output << "\n" << std::endl;
-        // CTL-SAT returns "SAT" for satisfiable, "UNSAT" for unsatisfiable
-        //std::cout << (output.find("Input formula is satisfable") != std::string::npos); //&& output.find("UNSAT") == std::string::npos;
-        //std::cout << output;
-        if (output.find("Input formula is satisfable") != std::string::npos) {
-            return true;
-        } else if (output.find("Input formula is NOT satisfable") != std::string::npos) {
-            return false;
+        CTL_LOG(DEBUG, verbose_, "Running: "<< ctl_sat_formula);
+        ProcessResult run = process_pool_->run({sat_path_, ctl_sat_formula});
+        if (run.timed_out) {
+            CTL_LOG_WARN("CTL-SAT timed out after " << process_pool_->timeout().count()
+                         << " ms on formula: " << formula);
+            return SatVerdict::TIMEOUT;
         }
-        throw std::runtime_error("Unexpected CTL-SAT output: " + output);
+        // CTL-SAT reports "Input formula is (NOT) satisfable"
+        if (run.output.find("Input formula is satisfable") != std::string::npos) {
+            return SatVerdict::SAT;
+        } else if (run.output.find("Input formula is NOT satisfable") != std::string::npos) {
+            return SatVerdict::UNSAT;
+        }
+        throw std::runtime_error("Unexpected CTL-SAT output: " + run.output);
     } catch (const std::exception& e) {
-        std::cerr << "Exception in isSatisfiable: " << e.what() << "\n";
-        return false; // Assume unsatisfiable if there's an error
+        CTL_LOG_ERROR("Exception in isSatisfiable: " << e.what());
+        return SatVerdict::ERROR;
     }
 }
 
+bool CTLSATInterface::isSatisfiable(const std::string& formula, bool /*with_clearing*/) const {
+    // Timeouts and solver errors are reported as unsatisfiable, as before
+    return checkSatisfiable(formula) == SatVerdict::SAT;
+}
+
 
 // WE CHECK FOR RefinesPlus
 bool CTLSATInterface::refines(const std::string& formula1, const std::string& formula2) const {
-    // Clear comparison mapping to ensure consistent atom assignment across both formulas
-    CTLSATParser::clearComparisonMapping();
-    
+    // Both formulas are converted in one query, so they share one atom assignment
     // Check if ¬(formula1 ∧ ¬formula2) is unsatisfiable
     // This is equivalent to checking if formula1 → formula2
-    if (verbose_) std::cout << "Refinement check: " << formula1 << " -> " << formula2 << "\n";
+    CTL_LOG(DEBUG, verbose_, "Refinement check: " << formula1 << " -> " << formula2);
 
     //if(!isSatisfiable(formula1)) {
     //    if (verbose_) std::cout << "Formula 1 is unsat\n\n\n\n\n";
@@ -75,17 +96,10 @@ bool CTLSATInterface::refines(const std::string& formula1, const std::string& fo
 
     // Build implication test in CTLSAT format
     //std::string implication_test = "(" + toCTLSATSyntax(formula1) + "^ ~(" + toCTLSATSyntax(formula2) + ")))";
-    //if (verbose_) std::cout << "Implication test formula: " << implication_test << "\n";
 
     // Run CTLSAT directly on the already-converted formula
-    bool refines =!isSatisfiable(std::string(formula1) + " & !(" + std::string(formula2) + ")", false);
-    if (verbose_) {
-        if (refines) {
-            std::cout << "Result: " << formula1 << " refines " << formula2 << "\n\n\n\n\n";
-        } else {
-            std::cout << "Result: " << formula1 << " does NOT refine " << formula2 << "\n\n\n\n\n";
-        }
-    }
+    bool refines = checkRefinement(formula1, formula2) == SatVerdict::UNSAT;
+    CTL_LOG(DEBUG, verbose_, "Result: " << formula1 << (refines ? " refines " : " does NOT refine ") << formula2);
     return refines;
     //try {
     //    std::string output = runCTLSAT(implication_test);
@@ -116,8 +130,7 @@ std::string CTLSATInterface::toCTLSATSyntax(const std::string& ctl_formula) {
     try {
         return CTLSATParser::convertString(ctl_formula);
     } catch (const std::exception& e) {
-        std::cerr << "Exception in toCTLSATSyntax for formula: " << ctl_formula << "\n";
-        std::cerr << "Error: " << e.what() << "\n";
+        CTL_LOG_ERROR("Exception in toCTLSATSyntax for formula: " << ctl_formula << "\nError: " << e.what());
         throw;
     }
 }
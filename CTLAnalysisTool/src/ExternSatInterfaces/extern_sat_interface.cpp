@@ -0,0 +1,99 @@
+#include "ExternSATInterface.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace ctl {
+
+SatVerdict ExternalCTLSATInterface::checkRefinement(const std::string& formula1, const std::string& formula2) const {
+    const std::string formula = formula1 + " & !(" + formula2 + ")";
+    std::optional<std::string> query = __translatedQuery(formula1, formula2);
+    // Formulas the shared mapping cannot take are translated as one query, as before
+    if (!query) return checkSatisfiable(formula);
+    return __checkTranslated(*query, formula);
+}
+
+std::optional<std::string> ExternalCTLSATInterface::__translatedQuery(const std::string& refining,
+                                                                      const std::string& refined) const {
+    std::lock_guard<std::mutex> lock(translation_mutex_);
+    auto translation = [this](const std::string& formula) -> const std::string& {
+        Translation& entry = translations_[formula];
+        if (entry.generation != translation_generation_) {
+            entry.text = __translate(formula);
+            entry.generation = translation_generation_;
+        }
+        return entry.text;
+    };
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        try {
+            const std::string& left = translation(refining);
+            return __refinementQuery(left, translation(refined));
+        } catch (const std::exception&) {
+            // Backends with few atoms run out of them over a run: start a fresh
+            // mapping and translate the formulas again under it
+            ++translation_generation_;
+            __resetMapping();
+        }
+    }
+    return std::nullopt;
+}
+
+void ExternalCTLSATInterface::clearTranslations() {
+    std::lock_guard<std::mutex> lock(translation_mutex_);
+    translations_.clear();
+    ++translation_generation_;
+    __resetMapping();
+}
+
+size_t ExternalCTLSATInterface::cachedTranslations() const {
+    std::lock_guard<std::mutex> lock(translation_mutex_);
+    return translations_.size();
+}
+
+std::vector<SatVerdict> ExternalCTLSATInterface::checkMany(const std::vector<std::string>& formulas,
+                                                           const VerdictCallback& on_verdict) const {
+    return __dispatch(formulas.size(), [&](size_t i) { return checkSatisfiable(formulas[i]); }, on_verdict);
+}
+
+std::vector<SatVerdict> ExternalCTLSATInterface::__dispatch(size_t count, const std::function<SatVerdict(size_t)>& query,
+                                                            const VerdictCallback& on_verdict) const {
+    std::vector<SatVerdict> verdicts(count, SatVerdict::ERROR);
+    if (count == 0) return verdicts;
+
+    auto check = [&](size_t i) {
+        auto start = std::chrono::steady_clock::now();
+        verdicts[i] = query(i);
+        if (on_verdict) {
+            on_verdict(i, verdicts[i], std::chrono::duration_cast<std::chrono::milliseconds>(
+                                           std::chrono::steady_clock::now() - start));
+        }
+    };
+
+    // One dispatcher per solver slot; the pool itself bounds the live processes
+    const size_t workers = std::min(count, process_pool_->size());
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) check(i);
+        return verdicts;
+    }
+
+    std::atomic<size_t> next{0};
+    auto drain = [&] {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) check(i);
+    };
+    std::vector<std::thread> dispatchers;
+    dispatchers.reserve(workers - 1);
+    for (size_t t = 1; t < workers; ++t) dispatchers.emplace_back(drain);
+    drain();
+    for (auto& d : dispatchers) d.join();
+    return verdicts;
+}
+
+std::vector<SatVerdict> ExternalCTLSATInterface::refinesMany(
+        const std::vector<std::pair<std::string, std::string>>& pairs,
+        const VerdictCallback& on_verdict) const {
+    return __dispatch(pairs.size(), [&](size_t i) { return checkRefinement(pairs[i].first, pairs[i].second); },
+                      on_verdict);
+}
+
+} // namespace ctl
@@ -1,4 +1,5 @@
 #include "ExternalCTLSAT/mlsolver_sat.h"
+#include "log.h"
 #include <cstdlib>
 #include <sstream>
 #include <stdexcept>
@@ -7,7 +8,6 @@
 #include <regex>
 #include <algorithm>
 
-#include "sat_parsers/ctlsat_parser.h"
 
 namespace ctl {
 
@@ -17,59 +17,81 @@ MLSolverInterface::MLSolverInterface(const std::string& mlsolver_sat_path)
      }
 
 std::string MLSolverInterface::runMLSolver(const std::string& formula) const {
-    if (verbose_) std::cout << "Running: "<< formula << "\n";
+    CTL_LOG(DEBUG, verbose_, "Running: "<< formula);
     // MLSolver outputs to stderr, so redirect stderr to stdout
-    std::string command = sat_path_ + " --satisfiability ctl \"" + formula + "\" --pgsolver recursive 2>&1";
-    if (verbose_) std::cout << "Command: " << command << "\n";
-    std::array<char, 2048*4> buffer;
-    std::string result;
-    
-    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(command.c_str(), "r"), pclose);
-    if (!pipe) {
-        throw std::runtime_error("Failed to run MLSolver command: " + command);
+    std::vector<std::string> command = {sat_path_, "--satisfiability", "ctl", formula, "--pgsolver", "recursive"};
+    CTL_LOG(DEBUG, verbose_, "Command: " << sat_path_ << " --satisfiability ctl \"" << formula << "\" --pgsolver recursive");
+    ProcessResult run = process_pool_->run(command, /*merge_stderr=*/true);
+    if (run.timed_out) {
+        throw std::runtime_error("MLSolver timed out after " +
+                                 std::to_string(process_pool_->timeout().count()) + " ms");
     }
     
-    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-        result += buffer.data();
+    return run.output;
+}
+
+SatVerdict MLSolverInterface::checkSatisfiable(const std::string& formula) const {
+    // Each query starts from a fresh (thread-local) atom mapping
+    MLSolverParser::clearComparisonMapping();
+    std::string mlsolver_formula;
+    try {
+        CTL_LOG(DEBUG, verbose_, "Satisfiability check for formula: " << formula);
+        mlsolver_formula = toMLSolverFormat(formula);
+    } catch (const std::exception& e) {
+        CTL_LOG_ERROR("Exception in isSatisfiable: " << e.what());
+        return SatVerdict::ERROR;
     }
-    
-    return result;
+    return __checkTranslated(mlsolver_formula, formula);
+}
+
+std::string MLSolverInterface::__translate(const std::string& formula) const {
+    return MLSolverParser::convertString(formula, mapping_);
+}
+
+void MLSolverInterface::__resetMapping() const {
+    mapping_ = MLSolverParser::Mapping();
+}
+
+std::string MLSolverInterface::__refinementQuery(const std::string& refining, const std::string& refined) const {
+    return MLSolverParser::refinementQuery(refining, refined);
 }
 
-bool MLSolverInterface::isSatisfiable(const std::string& formula, bool with_clearing) const {
-    if (with_clearing) MLSolverParser::clearComparisonMapping();
+SatVerdict MLSolverInterface::__checkTranslated(const std::string& mlsolver_formula, const std::string& formula) const {
     try {
-        std::cout << "checking for " << formula << "\n";
-        if(verbose_) std::cout << "Satisfiability check for formula: " << formula << "\n";
-        std::string mlsolver_formula = toMLSolverFormat(formula);
-        std::cout << "Converted formula: " << mlsolver_formula << "\n";
-        std::string output = runMLSolver(mlsolver_formula);
-
-        //std::cout << "Output: " << output << "\n" << std::endl;
-        // CTL-SAT returns "SAT" for satisfiable, "UNSAT" for unsatisfiable
-        //std::cout << (output.find("Input formula is satisfable") != std::string::npos); //&& output.find("UNSAT") == std::string::npos;
-        //std::cout << output;
-        if (output.find("Formula is satisfiable!") != std::string::npos) {
-            return true;
-        } else if (output.find("Formula is unsatisfiable!") != std::string::npos) {
-            return false;
+        CTL_LOG(TRACE, verbose_, "Converted formula: " << mlsolver_formula);
+        // MLSolver outputs to stderr, so merge it into the captured output
+        std::vector<std::string> command = {sat_path_, "--satisfiability", "ctl", mlsolver_formula, "--pgsolver", "recursive"};
+        CTL_LOG(DEBUG, verbose_, "Command: " << sat_path_ << " --satisfiability ctl \"" << mlsolver_formula << "\" --pgsolver recursive");
+        ProcessResult run = process_pool_->run(command, /*merge_stderr=*/true);
+        if (run.timed_out) {
+            CTL_LOG_WARN("MLSolver timed out after " << process_pool_->timeout().count()
+                         << " ms on formula: " << formula);
+            return SatVerdict::TIMEOUT;
         }
-        throw std::runtime_error("Unexpected CTL-SAT output: " + output);
+        if (run.output.find("Formula is satisfiable!") != std::string::npos) {
+            return SatVerdict::SAT;
+        } else if (run.output.find("Formula is unsatisfiable!") != std::string::npos) {
+            return SatVerdict::UNSAT;
+        }
+        throw std::runtime_error("Unexpected CTL-SAT output: " + run.output);
     } catch (const std::exception& e) {
-        std::cerr << "Exception in isSatisfiable: " << e.what() << "\n";
-        return false; // Assume unsatisfiable if there's an error
+        CTL_LOG_ERROR("Exception in isSatisfiable: " << e.what());
+        return SatVerdict::ERROR;
     }
 }
 
+bool MLSolverInterface::isSatisfiable(const std::string& formula, bool /*with_clearing*/) const {
+    // Timeouts and solver errors are reported as unsatisfiable, as before
+    return checkSatisfiable(formula) == SatVerdict::SAT;
+}
+
 
 // WE CHECK FOR RefinesPlus
 bool MLSolverInterface::refines(const std::string& formula1, const std::string& formula2) const {
-    // Clear comparison mapping to ensure consistent atom assignment across both formulas
-    MLSolverParser::clearComparisonMapping();
-    
+    // Both formulas are converted in one query, so they share one atom assignment
     // Check if ¬(formula1 ∧ ¬formula2) is unsatisfiable
     // This is equivalent to checking if formula1 → formula2
-    if (verbose_) std::cout << "Refinement check: " << formula1 << " -> " << formula2 << "\n";
+    CTL_LOG(DEBUG, verbose_, "Refinement check: " << formula1 << " -> " << formula2);
 
     //if(!isSatisfiable(formula1)) {
     //    if (verbose_) std::cout << "Formula 1 is unsat\n\n\n\n\n";
@@ -78,17 +100,11 @@ bool MLSolverInterface::refines(const std::string& formula1, const std::string&
 
     // Build implication test in CTLSAT format
     //std::string implication_test = "(" + toCTLSATSyntax(formula1) + "^ ~(" + toCTLSATSyntax(formula2) + ")))";
-    //if (verbose_) std::cout << "Implication test formula: " << implication_test << "\n";
+    //CTL_LOG(DEBUG, verbose_, "Implication test formula: " << implication_test);
 
     // Run CTLSAT directly on the already-converted formula
-    bool refines =!isSatisfiable(std::string(formula1) + " & !(" + std::string(formula2) + ")", false);
-    if (verbose_) {
-        if (refines) {
-            std::cout << "Result: " << formula1 << " refines " << formula2 << "\n\n\n\n\n";
-        } else {
-            std::cout << "Result: " << formula1 << " does NOT refine " << formula2 << "\n\n\n\n\n";
-        }
-    }
+    bool refines = checkRefinement(formula1, formula2) == SatVerdict::UNSAT;
+    CTL_LOG(DEBUG, verbose_, "Result: " << formula1 << (refines ? " refines " : " does NOT refine ") << formula2);
     return refines;
     //try {
     //    std::string output = runMLSolver(implication_test);
@@ -119,8 +135,7 @@ std::string MLSolverInterface::toMLSolverFormat(const std::string& ctl_formula)
     try {
         return MLSolverParser::convertString(ctl_formula);
     } catch (const std::exception& e) {
-        std::cerr << "Exception in toMLSolverFormat for formula: " << ctl_formula << "\n";
-        std::cerr << "Error: " << e.what() << "\n";
+        CTL_LOG_ERROR("Exception in toMLSolverFormat for formula: " << ctl_formula << "\nError: " << e.what());
         throw;
     }
 }
@@ -0,0 +1,154 @@
+#include "ExternalCTLSAT/process_pool.h"
+#include "trace.h"
+#include "cancellation.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ctl {
+
+SolverProcessPool::SolverProcessPool(size_t size, std::chrono::milliseconds timeout)
+    : size_(size == 0 ? 1 : size), timeout_ms_(timeout.count()) {}
+
+void SolverProcessPool::setSize(size_t size) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_ = size == 0 ? 1 : size;
+    }
+    slot_free_.notify_all();
+}
+
+size_t SolverProcessPool::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+void SolverProcessPool::__acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    slot_free_.wait(lock, [this] { return active_ < size_; });
+    ++active_;
+}
+
+void SolverProcessPool::__release() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --active_;
+    }
+    slot_free_.notify_one();
+}
+
+ProcessResult SolverProcessPool::run(const std::vector<std::string>& argv, bool merge_stderr) {
+    CTL_TRACE_SPAN("extsat", "solver process");
+    if (argv.empty()) {
+        throw std::runtime_error("SolverProcessPool::run called without a command");
+    }
+
+    // Everything the child needs is prepared before fork()
+    std::vector<char*> args;
+    args.reserve(argv.size() + 1);
+    for (const auto& a : argv) args.push_back(const_cast<char*>(a.c_str()));
+    args.push_back(nullptr);
+
+    __acquire();
+    struct SlotGuard {
+        SolverProcessPool* pool;
+        ~SlotGuard() { pool->__release(); }
+    } slot{this};
+
+    const rlim_t memory_limit = static_cast<rlim_t>(memory_limit_bytes_.load());
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        throw std::runtime_error(std::string("Failed to create solver pipe: ") + std::strerror(errno));
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        throw std::runtime_error(std::string("Failed to start solver: ") + std::strerror(errno));
+    }
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        if (merge_stderr) dup2(fds[1], STDERR_FILENO);
+        if (memory_limit > 0) {
+            struct rlimit limit{memory_limit, memory_limit};
+            setrlimit(RLIMIT_AS, &limit);
+        }
+        execvp(args[0], args.data());
+        _exit(127);
+    }
+    close(fds[1]);
+    launched_.fetch_add(1, std::memory_order_relaxed);
+
+    ProcessResult result;
+    long long timeout_ms = timeout_ms_.load();
+    // A check's cancellation deadline cuts the pool timeout short
+    if (auto remaining = cancellation::remaining()) {
+        long long left = std::max<long long>(remaining->count(), 1);
+        timeout_ms = timeout_ms > 0 ? std::min(timeout_ms, left) : left;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::array<char, 1 << 16> buffer;
+    // A check cancelled before its deadline, e.g. a portfolio race another
+    // engine won, is noticed within this many milliseconds
+    constexpr int kCancelPollMs = 20;
+    const CancellationToken* token = CancellationToken::current();
+    bool cancelled = false;
+
+    while (true) {
+        int wait_ms = -1;
+        if (timeout_ms > 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) {
+                result.timed_out = true;
+                break;
+            }
+            wait_ms = static_cast<int>(left);
+        }
+        if (token) {
+            if (token->cancelled()) {
+                result.timed_out = cancelled = true;
+                break;
+            }
+            wait_ms = wait_ms < 0 ? kCancelPollMs : std::min(wait_ms, kCancelPollMs);
+        }
+        pollfd pfd{fds[0], POLLIN, 0};
+        int ready = poll(&pfd, 1, wait_ms);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (ready == 0) continue;  // deadline and cancellation re-checked at the top
+        ssize_t n = read(fds[0], buffer.data(), buffer.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (n == 0) break;  // solver closed its output
+        result.output.append(buffer.data(), static_cast<size_t>(n));
+    }
+    close(fds[0]);
+
+    if (result.timed_out) {
+        kill(pid, SIGKILL);
+        if (!cancelled) timeouts_.fetch_add(1, std::memory_order_relaxed);
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    if (WIFEXITED(status)) result.exit_code = WEXITSTATUS(status);
+    else if (WIFSIGNALED(status)) result.term_signal = WTERMSIG(status);
+    return result;
+}
+
+} // namespace ctl
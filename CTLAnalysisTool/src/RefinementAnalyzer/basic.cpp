@@ -1,7 +1,10 @@
 #include "Analyzers/Refinement.h"
 #include "CTLautomaton.h"
+#include "automaton_cache.h"
+#include "work_stealing_pool.h"
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <sstream>
 #include <chrono>
@@ -12,6 +15,7 @@
 #include <queue>
 #include <stack>
 #include <numeric>
+#include <unordered_set>
 #ifdef __unix__
 #include <sys/ioctl.h>
 #include <unistd.h>
@@ -24,17 +28,7 @@ namespace ctl {
 
 // RefinementAnalyzer implementation
 RefinementAnalyzer::RefinementAnalyzer(const std::vector<std::string>& property_strings) {
-    properties_.reserve(property_strings.size());
-    for (const auto& prop_str : property_strings) {
-        //std::cout << "Loading property: " << prop_str << std::endl;
-        try {
-            
-            properties_.push_back(CTLProperty::create(prop_str));
-        } catch (const std::exception& e) {
-            std::cerr << "Warning: Failed to parse property '" << prop_str 
-                      << "': " << e.what() << std::endl;
-        }
-    }
+    __initialize_properties(property_strings);
     //std::cout << "Loaded " << properties_.size() << " properties.\n";
 }
 
@@ -45,12 +39,21 @@ RefinementAnalyzer::RefinementAnalyzer(const std::vector<std::shared_ptr<CTLProp
 
 
 RefinementAnalyzer::RefinementAnalyzer(const std::string& filename) {
-    auto property_strings = loadPropertiesFromFile(filename);
-    __initialize_properties(property_strings);
+    __initialize_properties_from_file(filename);
     //std::cout << "Loaded " << properties_.size() << " properties from file: " << filename << "\n";
 }
 
 RefinementAnalyzer::~RefinementAnalyzer() {
+    // Moves expanded by the checks go into the cached automata for the next run
+    if (AutomatonCache::instance().enabled()) {
+        auto update = [](const std::shared_ptr<CTLProperty>& property) {
+            if (auto automaton = property ? property->builtAutomaton() : nullptr) {
+                AutomatonCache::instance().update(*automaton);
+            }
+        };
+        std::for_each(properties_.begin(), properties_.end(), update);
+        for (const auto& eq_class : equivalence_classes_) std::for_each(eq_class.begin(), eq_class.end(), update);
+    }
     // Clear instance caches and Z3 resources
     clearInstanceCaches();
 }
@@ -79,8 +82,13 @@ void RefinementAnalyzer::clearInstanceCaches() {
     properties_.clear();
     equivalence_classes_.clear();
     refinement_graphs_.clear();
+    required_properties_.clear();
     false_properties_strings_.clear();
     false_properties_index_.clear();
+    property_positions_.clear();
+    positions_assigned_ = 0;
+    class_simulations_.clear();
+    witness_pools_.clear();
     result_per_property_.clear();
     
     // Clear CTL-SAT interface (releases Z3 resources if using Z3 backend)
@@ -120,20 +128,40 @@ void RefinementAnalyzer::writeReport(const std::string& filename, const Analysis
     file << "Summary:\n";
     file << "--------\n";
     file << "Total properties: " << result.total_properties << "\n";
+    file << "Duplicate properties merged: " << result.duplicate_properties << "\n";
     file << "Equivalence classes: " << result.equivalence_classes << "\n";
     file << "Total refinements found: " << result.total_refinements << "\n";
+    if (result.unknown_refinements > 0) {
+        file << "Undecided pairs (check timeout): " << result.unknown_refinements << "\n";
+    }
     file << "Parsing time: " << formatDuration(result.parsing_time) << "\n";
     file << "Equivalence analysis time: " << formatDuration(result.equivalence_time) << "\n";
+    file << "Automaton construction time: " << formatDuration(result.automaton_time) << "\n";
     file << "Refinement analysis time: " << formatDuration(result.refinement_time) << "\n";
     file << "Total analysis time: " << formatDuration(result.total_time) << "\n\n";
     file << "Refinement Memory Usage: " << result.refinement_memory_kb << " KB\n";
     file << "Total Analysis Memory Usage: " << result.total_analysis_memory_kb << " KB\n";
     file << "Peak Memory Usage: " << result.peak_memory_kb << " KB\n";
+    file << "Guard SAT cache: " << result.guard_cache_hits << " hits, "
+         << result.guard_cache_misses << " misses\n";
+    file << "Pre-filter: " << result.prefilter_refines << " refining, " << result.prefilter_rejected
+         << " non-refining, " << result.prefilter_undecided << " undecided pairs\n\n";
+
+    if (result.duplicate_properties > 0) {
+        file << "Duplicate properties (analyzed as the listed input):\n";
+        for (size_t k = 0; k < input_properties_.size() && k < input_representatives_.size(); ++k) {
+            if (input_representatives_[k] == input_properties_[k]) continue;
+            file << "  " << k << ". " << input_properties_[k]->toString() << "  ==  "
+                 << __inputIndex(input_representatives_[k].get()) << ". "
+                 << input_representatives_[k]->toString() << "\n";
+        }
+        file << "\n";
+    }
 
     // Write details for each equivalence class
-    for (size_t i = 0; i < result.equivalence_class_properties.size(); ++i) {
-        const auto& class_props = result.equivalence_class_properties[i];
-        const auto& graph = result.class_graphs[i];
+    for (size_t i = 0; i < equivalence_classes_.size() && i < refinement_graphs_.size(); ++i) {
+        const auto& class_props = equivalence_classes_[i];
+        const auto& graph = refinement_graphs_[i];
         
         file << "Equivalence Class " << (i + 1) << ":\n";
         file << "-------------------\n";
@@ -149,7 +177,7 @@ void RefinementAnalyzer::writeReport(const std::string& filename, const Analysis
         file << "\n";
         
         if (!graph.getEdges().empty()) {
-            file << "Refinements (⇒ means 'refines'):\n";
+            file << "Refinements (⇒ means 'refines'; implied ones are left out):\n";
             for (const auto& edge : graph.getEdges()) {
                 file << "  " << class_props[edge.from]->toString() 
                      << "  ⇒  " << class_props[edge.to]->toString() << "\n";
@@ -168,14 +196,55 @@ void RefinementAnalyzer::writeGraphs(const std::string& output_directory, const
     // Create output directory if it doesn't exist
     std::filesystem::create_directories(output_directory);
     
-    for (size_t i = 0; i < refinement_graphs_.size(); ++i) {
+    auto write = [&](size_t i) {
         std::string filename = output_directory + "/" + base_name + "_" + std::to_string(i + 1) + ".dot";
         std::string title = "Refinement Graph - Class " + std::to_string(i + 1);
         refinement_graphs_[i].toDot(filename, title);
+    };
+    const size_t writers = std::min(refinement_graphs_.size(), std::max<size_t>(threads_, 1));
+    if (writers <= 1) {
+        for (size_t i = 0; i < refinement_graphs_.size(); ++i) write(i);
+        return;
+    }
+
+    // A graph derives its reduction on first use, so derive them all before sharing
+    for (const auto& graph : refinement_graphs_) graph.getEdges();
+    std::atomic<size_t> next{0};
+    std::vector<std::future<void>> tasks;
+    for (size_t t = 0; t < writers; ++t) {
+        tasks.push_back(std::async(std::launch::async, [&] {
+            for (size_t i = next.fetch_add(1); i < refinement_graphs_.size(); i = next.fetch_add(1)) write(i);
+        }));
     }
+    for (auto& task : tasks) task.get();
 }
 
-std::vector<std::shared_ptr<CTLProperty>> RefinementAnalyzer::getRequiredProperties() const {
+std::future<void> RefinementAnalyzer::writeOutputsAsync(const std::string& output_directory,
+                                                        const AnalysisResult& result) const {
+    for (const auto& graph : refinement_graphs_) graph.getEdges();
+    std::vector<std::future<void>> writers;
+    auto write = [&writers](auto task) { writers.push_back(std::async(std::launch::async, std::move(task))); };
+    write([this, output_directory, result] { writeReport(output_directory + "/refinement_analysis.txt", result); });
+    write([this, output_directory] { writeGraphs(output_directory); });
+    write([this, output_directory] { writeRequiredProperties(output_directory + "/required_properties.txt"); });
+    write([this, output_directory] { writeEmptyProperties(output_directory + "/false_properties.txt"); });
+    if (result.duplicate_properties > 0) {
+        write([this, output_directory] { writeDuplicateProperties(output_directory + "/duplicate_properties.csv"); });
+    }
+    return std::async(std::launch::async, [writers = std::move(writers)]() mutable {
+        std::exception_ptr failure;
+        for (auto& writer : writers) {
+            try {
+                writer.get();
+            } catch (...) {
+                if (!failure) failure = std::current_exception();
+            }
+        }
+        if (failure) std::rethrow_exception(failure);
+    });
+}
+
+void RefinementAnalyzer::__updateRequiredProperties() {
     std::vector<std::shared_ptr<CTLProperty>> required;
     
     for (const auto& graph : refinement_graphs_) {
@@ -237,7 +306,7 @@ std::vector<std::shared_ptr<CTLProperty>> RefinementAnalyzer::getRequiredPropert
         }
     }
     
-    return required;
+    required_properties_ = std::move(required);
 }
 
 
@@ -265,32 +334,26 @@ void RefinementAnalyzer::updateGraphWithOptimization(RefinementGraph& graph,
     // Sort in descending order to safely remove
     std::sort(indices_to_remove.rbegin(), indices_to_remove.rend());
     
-    // Remove nodes and update adjacency lists
+    // Remove nodes together with their edges
     for (size_t idx : indices_to_remove) {
-        // Remove from nodes
-        graph.nodes_.erase(graph.nodes_.begin() + idx);
-        
-        // Remove from adjacency lists
-        graph.adjacency_.erase(graph.adjacency_.begin() + idx);
-        
-        // Update remaining adjacency lists (decrement indices > removed index)
-        for (auto& adj_list : graph.adjacency_) {
-            adj_list.erase(
-                std::remove_if(adj_list.begin(), adj_list.end(),
-                              [idx](size_t i) { return i == idx; }),
-                adj_list.end()
-            );
-            
-            // Decrement indices greater than removed index
-            for (auto& i : adj_list) {
-                if (i > idx) {
-                    i--;
-                }
-            }
-        }
+        graph.__removeNode(idx);
     }
 }
 
+void RefinementAnalyzer::__recordTransitiveStats(size_t n, size_t skipped_pairs, size_t refuted_pairs,
+                                                 size_t condensed_pairs, size_t condensed_properties) {
+    transitive_stats_.eliminated_per_class.push_back(skipped_pairs);
+    transitive_stats_.total_eliminated += skipped_pairs;
+    transitive_stats_.total_before_optimization += n > 1 ? n * (n - 1) : 0;
+    transitive_stats_.implied_pairs += skipped_pairs - refuted_pairs - condensed_pairs;
+    transitive_stats_.refuted_pairs += refuted_pairs;
+    transitive_stats_.condensed_pairs += condensed_pairs;
+    transitive_stats_.condensed_properties += condensed_properties;
+    transitive_stats_.optimization_ratio = transitive_stats_.total_before_optimization > 0
+        ? static_cast<double>(transitive_stats_.total_eliminated) / transitive_stats_.total_before_optimization
+        : 0.0;
+}
+
 TransitiveOptimizationStats RefinementAnalyzer::getTransitiveOptimizationStats() const {
     return transitive_stats_;
 }
@@ -303,16 +366,34 @@ std::unordered_map<std::string, size_t> RefinementAnalyzer::getStatistics() cons
     stats["equivalence_classes"] = equivalence_classes_.size();
     stats["total_refinements"] = 0;
     
+    stats["unknown_refinements"] = 0;
     for (const auto& graph : refinement_graphs_) {
         stats["total_refinements"] += graph.getEdgeCount();
+        stats["unknown_refinements"] += graph.getUnknownEdges().size();
     }
     
-    auto required = getRequiredProperties();
-    stats["required_properties"] = required.size();
+    stats["required_properties"] = getRequiredProperties().size();
+
+    for (size_t i = 0; i < kStatisticCount; ++i) {
+        stats[StatisticToString(static_cast<Statistic>(i))] = hot_path_statistics_[i];
+    }
     
     return stats;
 }
 
+void RefinementAnalyzer::writeStatisticsJsonRow(std::ostream& out, const std::string& input_name) const {
+    std::string name;
+    for (char c : input_name) {
+        if (c == '"' || c == '\\') name += '\\';
+        name += c;
+    }
+    out << "{\"input\":\"" << name << "\"";
+    for (size_t i = 0; i < kStatisticCount; ++i) {
+        out << ",\"" << StatisticToString(static_cast<Statistic>(i)) << "\":" << hot_path_statistics_[i];
+    }
+    out << "}\n";
+}
+
 std::string RefinementAnalyzer::formatDuration(std::chrono::milliseconds duration) const {
     auto ms = duration.count();
     if (ms < 1000) {
@@ -354,7 +435,9 @@ void RefinementAnalyzer::writeEmptyProperties(const std::string& filename) const
 }
 
 void RefinementAnalyzer::writeRequiredProperties(const std::string& filename) const {
-    auto required = getRequiredProperties();
+    const auto& required = getRequiredProperties();
+    std::unordered_set<const CTLProperty*> is_required;
+    for (const auto& prop : required) is_required.insert(prop.get());
     
     std::ofstream file(filename);
     if (!file.is_open()) {
@@ -373,9 +456,11 @@ void RefinementAnalyzer::writeRequiredProperties(const std::string& filename) co
     file << "# Required Properties (by Index)\n";
     file << "# Format: Index: Property. We index from 0, so when loading remember to add 1\n\n";
 
-    for (size_t i = 0; i < properties_.size(); ++i) {
-        if (std::find(required.begin(), required.end(), properties_[i]) != required.end()) {
-            file << i << ": " << properties_[i]->toString() << "\n";
+    // Indices refer to the input, duplicates are represented by their first occurrence
+    const auto& inputs = input_properties_.empty() ? properties_ : input_properties_;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (is_required.count(inputs[i].get())) {
+            file << i << ": " << inputs[i]->toString() << "\n";
         }
     }
 
@@ -387,9 +472,9 @@ void RefinementAnalyzer::writeRequiredProperties(const std::string& filename) co
         throw std::runtime_error("Cannot open file for writing: " + filename_no_ext + ".csv");
     }
     file_csv << "Index,Property\n";
-    for (size_t i = 0; i < properties_.size(); ++i) {
-        if (std::find(required.begin(), required.end(), properties_[i]) != required.end()) {
-            file_csv << i << ",\"" << properties_[i]->toString() << "\"\n";
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (is_required.count(inputs[i].get())) {
+            file_csv << i << ",\"" << inputs[i]->toString() << "\"\n";
         }
     }
     file_csv.close();
@@ -447,18 +532,19 @@ void RefinementAnalyzer::printProgressBar(int percent, size_t current_class, siz
     }
 }
 
+// Degrees count every recorded refinement, like getEdgeCount
 std::vector<size_t> RefinementGraph::getInDegrees() const {
     std::vector<size_t> in_degrees(nodes_.size(), 0);
-    for (const auto& edge : edges_) {
-        in_degrees[edge.to]++;
+    for (size_t from = 0; from < edge_bits_.rows(); ++from) {
+        edge_bits_.forEachInRow(from, [&](size_t to) { in_degrees[to]++; });
     }
     return in_degrees;
 }
 
 std::vector<size_t> RefinementGraph::getOutDegrees() const {
     std::vector<size_t> out_degrees(nodes_.size(), 0);
-    for (const auto& edge : edges_) {
-        out_degrees[edge.from]++;
+    for (size_t from = 0; from < edge_bits_.rows(); ++from) {
+        edge_bits_.forEachInRow(from, [&](size_t) { out_degrees[from]++; });
     }
     return out_degrees;
 }
@@ -467,7 +553,7 @@ std::vector<size_t> RefinementGraph::getOutDegrees() const {
 namespace analyzer_utils {
 
 
-void exportToCSV(const AnalysisResult& result, const std::string& filename) {
+void exportToCSV(const RefinementAnalyzer& analyzer, const std::string& filename) {
     std::ofstream file(filename);
     if (!file.is_open()) {
         throw std::runtime_error("Cannot open file for writing: " + filename);
@@ -475,9 +561,9 @@ void exportToCSV(const AnalysisResult& result, const std::string& filename) {
     
     file << "class_id,property_index,property,refines_property_index,refines_property\n";
     
-    for (size_t class_id = 0; class_id < result.class_graphs.size(); ++class_id) {
-        const auto& graph = result.class_graphs[class_id];
-        const auto& properties = result.equivalence_class_properties[class_id];
+    for (size_t class_id = 0; class_id < analyzer.getRefinementGraphs().size(); ++class_id) {
+        const auto& graph = analyzer.getRefinementGraphs()[class_id];
+        const auto& properties = analyzer.getEquivalenceClasses()[class_id];
         
         for (const auto& edge : graph.getEdges()) {
             file << class_id << ","
@@ -523,6 +609,50 @@ void RefinementAnalyzer::setUseTransitiveOptimization(bool use_transitive) {
     use_transitive_optimization_ = use_transitive;
 }
 
+void RefinementAnalyzer::setResultStream(const std::string& filename) {
+    auto stream = std::make_unique<std::ofstream>(filename);
+    if (!stream->is_open()) {
+        throw std::runtime_error("Cannot open file for writing: " + filename);
+    }
+    *stream << "Index 1, Index 2, Property 1, Property 2, Time Taken (ms),Memory Used (KB),Verdict\n";
+    stream->flush();
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    result_stream_ = std::move(stream);
+}
+
+void RefinementAnalyzer::__recordResults(std::span<const PropertyResult> results) {
+    if (results.empty()) return;
+    Statistics::instance().add(Statistic::PAIRS_DECIDED, results.size());
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    if (!result_stream_) {
+        result_per_property_.insert(result_per_property_.end(), results.begin(), results.end());
+        return;
+    }
+    for (const auto& result : results) {
+        __writeResultRow(*result_stream_, result);
+    }
+    result_stream_->flush();
+}
+
+void RefinementAnalyzer::__writeResultRow(std::ostream& out, const PropertyResult& result) const {
+    //find property names
+    std::string property1_name = "";
+    std::string property2_name = "";
+    if(result.property1_index < properties_.size()) {
+        property1_name = properties_[result.property1_index]->toString();
+    }
+    if(result.property2_index < properties_.size()) {
+        property2_name = properties_[result.property2_index]->toString();
+    }
+
+    out << result.property1_index << "," << result.property2_index << ","
+        << "\"" << property1_name << "\","
+        << "\"" << property2_name << "\","
+        << result.time_taken.count() << ","
+        << result.memory_used_kb << ","
+        << SatVerdictToString(result.verdict) << "\n";
+}
+
 void RefinementAnalyzer:: writeInfoPerProperty(const std::string& filename) const
 {
     std::ofstream file(filename);
@@ -530,25 +660,9 @@ void RefinementAnalyzer:: writeInfoPerProperty(const std::string& filename) cons
         throw std::runtime_error("Cannot open file for writing: " + filename);
     }
 
-    file << "Index 1, Index 2, Property 1, Property 2, Time Taken (ms),Memory Used (KB)\n";
+    file << "Index 1, Index 2, Property 1, Property 2, Time Taken (ms),Memory Used (KB),Verdict\n";
     for (const auto& result : result_per_property_) {
-
-        //find property names
-        std::string property1_name = "";
-        std::string property2_name = "";
-        if(result.property1_index < properties_.size()) {
-            property1_name = properties_[result.property1_index]->toString();
-        }
-        if(result.property2_index < properties_.size()) {
-            property2_name = properties_[result.property2_index]->toString();
-        }
-
-
-        file << result.property1_index << "," << result.property2_index << ","
-             << "\"" << property1_name << "\","
-             << "\"" << property2_name << "\","
-             << result.time_taken.count() << ","
-             << result.memory_used_kb << "\n";
+        __writeResultRow(file, result);
     }
 
     file.close();
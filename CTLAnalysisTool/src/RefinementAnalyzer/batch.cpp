@@ -0,0 +1,220 @@
+#include "Analyzers/Refinement.h"
+#include "utils.h"
+#include "bit_matrix.h"
+#include "log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+namespace ctl {
+
+void RefinementAnalyzer::analyzeRefinementsBatched() {
+    refinement_graphs_.clear();
+    refinement_graphs_.reserve(equivalence_classes_.size());
+
+    for (size_t i = 0; i < equivalence_classes_.size(); ++i) {
+        CTL_LOG(INFO, false, "Analyzing refinement class " << (i + 1) << "/" << equivalence_classes_.size()
+                                                         << " in solver batches...");
+        refinement_graphs_.push_back(__analyzeClassBatch(equivalence_classes_[i]));
+        __checkpointClass(refinement_graphs_.back());
+    }
+}
+
+RefinementGraph RefinementAnalyzer::__analyzeClassBatch(
+        const std::vector<std::shared_ptr<CTLProperty>>& class_properties) {
+    const size_t n = class_properties.size();
+    RefinementGraph graph;
+    for (const auto& prop : class_properties) {
+        graph.addNode(prop);
+    }
+
+    BitMatrix reach(n, n);
+    auto apply = [&](size_t i, size_t j, bool refines) {
+        if (!refines) return;
+        reach.set(i, j);
+        // TRANSITIVE CLOSURE: If i->j, then i can reach everything j can reach
+        if (use_transitive_optimization_) {
+            reach.orRow(i, j);
+            reach.reset(i, i);
+        }
+    };
+
+    std::vector<std::pair<size_t, size_t>> candidates;
+    candidates.reserve(n > 1 ? n * (n - 1) : 0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (i != j) candidates.emplace_back(i, j);
+        }
+    }
+
+    // Without the transitive skip the whole class is one batch. With it, pairs go
+    // out in waves of one query per solver slot, in the serial order, so verdicts
+    // of earlier waves can still rule out later pairs.
+    const size_t wave = use_transitive_optimization_
+                            ? std::max<size_t>(1, external_sat_interface_->processPool().size())
+                            : candidates.size();
+    const std::string mode = __refinementCacheMode();
+    size_t skipped_pairs = 0;
+    std::vector<std::pair<size_t, size_t>> timed_out;
+    size_t next = 0;
+
+    while (next < candidates.size()) {
+        std::vector<std::pair<size_t, size_t>> batch;
+        std::vector<std::pair<std::string, std::string>> queries;
+        while (next < candidates.size() && queries.size() < wave) {
+            auto [i, j] = candidates[next++];
+            if (use_transitive_optimization_ && reach.test(i, j)) {
+                ++skipped_pairs;
+                Statistics::instance().add(Statistic::PAIRS_DECIDED);
+                continue;
+            }
+            if (auto shortcut = __decideBySatisfiability(*class_properties[i], *class_properties[j])) {
+                Statistics::instance().add(Statistic::SATISFIABILITY_SHORTCUTS);
+                __recordResult({*shortcut, std::chrono::milliseconds(0), i, j, 0,
+                                *shortcut ? SatVerdict::UNSAT : SatVerdict::SAT});
+                apply(i, j, *shortcut);
+                continue;
+            }
+            if (use_prefilter_) {
+                auto decision = prefilter_->check(*class_properties[i], *class_properties[j]);
+                if (decision != RefinementPrefilter::Decision::UNKNOWN) {
+                    const bool refines = decision == RefinementPrefilter::Decision::REFINES;
+                    __recordResult({refines, std::chrono::milliseconds(0), i, j, 0,
+                                    refines ? SatVerdict::UNSAT : SatVerdict::SAT});
+                    apply(i, j, refines);
+                    continue;
+                }
+            }
+            const std::string refining = class_properties[i]->toString();
+            const std::string refined = class_properties[j]->toString();
+            if (checkpoint_) {
+                if (auto restored = checkpoint_->lookupRefinement(refining, refined)) {
+                    __recordResult({*restored, std::chrono::milliseconds(0), i, j, 0,
+                                    *restored ? SatVerdict::UNSAT : SatVerdict::SAT});
+                    apply(i, j, *restored);
+                    continue;
+                }
+            }
+            if (cache_) {
+                if (auto cached = cache_->lookupRefinement(mode, refining, refined)) {
+                    __recordResult({*cached, std::chrono::milliseconds(0), i, j, 0,
+                                    *cached ? SatVerdict::UNSAT : SatVerdict::SAT});
+                    apply(i, j, *cached);
+                    continue;
+                }
+            }
+            batch.emplace_back(i, j);
+            queries.emplace_back(refining, refined);
+        }
+        if (queries.empty()) continue;
+
+        Statistics::instance().add(Statistic::REFINEMENT_CHECKS, queries.size());
+        auto start_time = std::chrono::high_resolution_clock::now();
+        auto verdicts = external_sat_interface_->refinesMany(queries);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start_time);
+        // Queries of one batch run side by side, so each is charged an even share
+        auto share_us = elapsed / static_cast<long>(queries.size());
+        auto share = std::chrono::duration_cast<std::chrono::milliseconds>(share_us);
+
+        for (size_t k = 0; k < batch.size(); ++k) {
+            auto [i, j] = batch[k];
+            const bool refines = verdicts[k] == SatVerdict::UNSAT;
+            if (cache_ && (verdicts[k] == SatVerdict::SAT || refines)) {
+                cache_->storeRefinement(mode, queries[k].first, queries[k].second, refines);
+            }
+            if (checkpoint_ && (verdicts[k] == SatVerdict::SAT || refines)) {
+                checkpoint_->storeRefinement(queries[k].first, queries[k].second, refines);
+            }
+            __recordResult({refines, share, i, j, 0, verdicts[k], share_us});
+            if (verdicts[k] == SatVerdict::TIMEOUT) timed_out.emplace_back(i, j);
+            apply(i, j, refines);
+        }
+        if (checkpoint_) checkpoint_->maybeSave();
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (reach.test(i, j)) graph.addEdge(i, j);
+        }
+    }
+    for (auto [i, j] : timed_out) {
+        if (!graph.hasEdge(i, j)) graph.addUnknownEdge(i, j);
+    }
+    if (use_transitive_optimization_ && skipped_pairs > 0) {
+        CTL_LOG(INFO, false, "    [Transitive Closure] Skipped " << skipped_pairs << "/" << candidates.size() << " pairs");
+    }
+    total_skipped_ += skipped_pairs;
+    return graph;
+}
+
+void RefinementAnalyzer::_checkAndRemoveUnsatisfiablePropertiesBatch() {
+    if (properties_.empty()) return;
+
+    const std::string mode = __satisfiabilityCacheMode();
+    std::vector<char> is_false(properties_.size(), 0);
+    std::vector<size_t> submitted;
+    std::vector<std::string> queries;
+    for (size_t i = 0; i < properties_.size(); ++i) {
+        std::optional<bool> satisfiable;
+        if (checkpoint_) satisfiable = checkpoint_->lookupSatisfiable(properties_[i]->toString());
+        if (!satisfiable && cache_) satisfiable = cache_->lookupSatisfiable(mode, properties_[i]->toString());
+        if (!satisfiable) satisfiable = properties_[i]->knownSatisfiable();
+        if (satisfiable) {
+            properties_[i]->setSatisfiable(*satisfiable);
+            is_false[i] = !*satisfiable;
+            if (*satisfiable) prefilter_->noteSatisfiable(*properties_[i]);
+            continue;
+        }
+        submitted.push_back(i);
+        queries.push_back(properties_[i]->toString());
+    }
+
+    auto verdicts = external_sat_interface_->checkMany(queries);
+    for (size_t k = 0; k < submitted.size(); ++k) {
+        if (verdicts[k] == SatVerdict::TIMEOUT || verdicts[k] == SatVerdict::ERROR) {
+            CTL_LOG_WARN("Satisfiability of " << queries[k] << " is unknown (" << SatVerdictToString(verdicts[k])
+                                              << "), keeping it in the analysis.");
+            continue;
+        }
+        is_false[submitted[k]] = verdicts[k] == SatVerdict::UNSAT;
+        properties_[submitted[k]]->setSatisfiable(verdicts[k] == SatVerdict::SAT);
+        if (verdicts[k] == SatVerdict::SAT) prefilter_->noteSatisfiable(*properties_[submitted[k]]);
+        if (cache_) cache_->storeSatisfiable(mode, queries[k], verdicts[k] == SatVerdict::SAT);
+        if (checkpoint_) checkpoint_->storeSatisfiable(queries[k], verdicts[k] == SatVerdict::SAT);
+    }
+    if (checkpoint_) checkpoint_->maybeSave();
+    __removeProperties(is_false);
+
+    // Validity of the survivors in a second batch, one query per negation;
+    // those with a sampled counter-model are settled without the solver
+    std::vector<size_t> open;
+    std::vector<std::string> negations;
+    for (size_t i = 0; i < properties_.size(); ++i) {
+        const CTLProperty& property = *properties_[i];
+        if (property.knownValid()) continue;
+        if (prefilter_->hasCounterModel(property)) {
+            property.setValid(false);
+            continue;
+        }
+        const std::string negation = "!(" + property.toString() + ")";
+        if (cache_) {
+            if (auto satisfiable = cache_->lookupSatisfiable(mode, negation)) {
+                property.setValid(!*satisfiable);
+                continue;
+            }
+        }
+        open.push_back(i);
+        negations.push_back(negation);
+    }
+    if (negations.empty()) return;
+    auto negation_verdicts = external_sat_interface_->checkMany(negations);
+    for (size_t k = 0; k < open.size(); ++k) {
+        if (negation_verdicts[k] != SatVerdict::SAT && negation_verdicts[k] != SatVerdict::UNSAT) continue;
+        properties_[open[k]]->setValid(negation_verdicts[k] == SatVerdict::UNSAT);
+        if (cache_) cache_->storeSatisfiable(mode, negations[k], negation_verdicts[k] == SatVerdict::SAT);
+    }
+}
+
+} // namespace ctl
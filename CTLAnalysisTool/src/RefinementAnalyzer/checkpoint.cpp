@@ -0,0 +1,73 @@
+#include "Analyzers/Refinement.h"
+
+#include <iostream>
+
+namespace ctl {
+
+void RefinementAnalyzer::setCheckpoint(const std::string& path, std::chrono::seconds interval, bool resume) {
+    checkpoint_ = std::make_unique<RunCheckpoint>(path, interval);
+    resume_ = resume;
+}
+
+uint64_t RefinementAnalyzer::__checkpointFingerprint() const {
+    // FNV-1a over the check mode and the deduplicated input, in order
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const std::string& text) {
+        for (unsigned char c : text) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        hash ^= 0xff;  // separator, so ("ab", "c") and ("a", "bc") differ
+        hash *= 1099511628211ULL;
+    };
+    mix(__refinementCacheMode());
+    for (const auto& property : properties_) mix(property->toString());
+    return hash;
+}
+
+std::vector<std::optional<RefinementGraph>> RefinementAnalyzer::__restoreFinishedClasses() const {
+    std::vector<std::optional<RefinementGraph>> restored(equivalence_classes_.size());
+    for (size_t c = 0; c < equivalence_classes_.size(); ++c) {
+        const auto& class_properties = equivalence_classes_[c];
+        std::vector<std::string> members;
+        members.reserve(class_properties.size());
+        for (const auto& property : class_properties) members.push_back(property->toString());
+        auto finished = checkpoint_->lookupClass(members);
+        if (!finished) continue;
+
+        RefinementGraph graph;
+        for (const auto& property : class_properties) graph.addNode(property);
+        for (auto [from, to] : finished->edges) graph.addEdge(from, to);
+        for (auto [from, to] : finished->unknown_edges) graph.addUnknownEdge(from, to);
+        restored[c] = std::move(graph);
+    }
+    return restored;
+}
+
+void RefinementAnalyzer::__checkpointClass(const RefinementGraph& graph) const {
+    if (!checkpoint_) return;
+    std::vector<std::string> members;
+    members.reserve(graph.getNodeCount());
+    for (const auto& property : graph.getNodes()) members.push_back(property->toString());
+    RunCheckpoint::FinishedClass finished;
+    // Every pair, so a restored class answers hasEdge exactly as before
+    for (const auto& edge : graph.getRecordedEdges()) {
+        finished.edges.emplace_back(static_cast<uint32_t>(edge.from), static_cast<uint32_t>(edge.to));
+    }
+    for (const auto& edge : graph.getUnknownEdges()) {
+        finished.unknown_edges.emplace_back(static_cast<uint32_t>(edge.from), static_cast<uint32_t>(edge.to));
+    }
+    checkpoint_->storeClass(members, std::move(finished));
+    checkpoint_->maybeSave();
+}
+
+void RefinementAnalyzer::__saveCheckpoint() const {
+    if (!checkpoint_) return;
+    try {
+        checkpoint_->save();
+    } catch (const std::exception& e) {
+        std::cerr << "Warning: " << e.what() << "\n";
+    }
+}
+
+} // namespace ctl
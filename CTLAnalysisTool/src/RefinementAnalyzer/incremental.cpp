@@ -0,0 +1,247 @@
+#include "Analyzers/Refinement.h"
+#include "guard_sat_cache.h"
+#include "bit_matrix.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+namespace ctl {
+
+size_t RefinementAnalyzer::addProperties(const std::vector<std::string>& property_strings) {
+    size_t added = 0;
+    for (const auto& prop_str : property_strings) {
+        try {
+            auto property = CTLProperty::create(prop_str, verbose_);
+            pending_properties_.push_back(std::move(property));
+            ++added;
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: Failed to parse property '" << prop_str
+                      << "': " << e.what() << std::endl;
+        }
+    }
+    return added;
+}
+
+void RefinementAnalyzer::addProperties(const std::vector<std::shared_ptr<CTLProperty>>& properties) {
+    pending_properties_.insert(pending_properties_.end(), properties.begin(), properties.end());
+}
+
+bool RefinementAnalyzer::removeProperty(const std::string& formula) {
+    // Match on the canonical printed form so callers may pass the original text
+    std::string canonical;
+    try {
+        canonical = CTLProperty(formula).toString();
+    } catch (const std::exception&) {
+        canonical = formula;
+    }
+
+    auto matches = [&canonical](const std::shared_ptr<CTLProperty>& p) { return p->toString() == canonical; };
+
+    auto pending_it = std::find_if(pending_properties_.begin(), pending_properties_.end(), matches);
+    if (pending_it != pending_properties_.end()) {
+        pending_properties_.erase(pending_it);
+        return true;
+    }
+
+    auto it = std::find_if(properties_.begin(), properties_.end(), matches);
+    if (it == properties_.end()) {
+        return false;
+    }
+    const size_t index = static_cast<size_t>(std::distance(properties_.begin(), it));
+    const CTLProperty* removed = it->get();
+
+    // Forget its verdicts, the pointer may be reused by a later property
+    for (auto v = known_verdicts_.begin(); v != known_verdicts_.end(); ) {
+        if (v->first.refining == removed || v->first.refined == removed) v = known_verdicts_.erase(v);
+        else ++v;
+    }
+
+    // Pruned properties are not in properties_; only the positions follow it
+    if (index < property_positions_.size()) {
+        property_positions_.erase(property_positions_.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+
+    prefilter_->forget(*removed);
+    properties_.erase(it);
+    return true;
+}
+
+void RefinementAnalyzer::__recordVerdicts(const RefinementGraph& graph) {
+    // A finished class graph is the complete relation on its nodes: every pair
+    // without an edge was checked and refuted (only reachable pairs are skipped)
+    const auto& nodes = graph.getNodes();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (size_t j = 0; j < nodes.size(); ++j) {
+            if (i == j || graph.isUnknown(i, j)) continue;  // timed-out pairs are checked again
+            known_verdicts_[{nodes[i].get(), nodes[j].get()}] = graph.hasEdge(i, j);
+        }
+    }
+}
+
+RefinementGraph RefinementAnalyzer::__analyzeClassIncremental(
+        const std::vector<std::shared_ptr<CTLProperty>>& class_properties,
+        size_t& checked_pairs, size_t& reused_pairs) {
+    const size_t n = class_properties.size();
+    RefinementGraph graph;
+    for (const auto& prop : class_properties) {
+        graph.addNode(prop);
+    }
+
+    BitMatrix reach(n, n);
+    std::vector<std::pair<size_t, size_t>> unknown;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (i == j) continue;
+            auto it = known_verdicts_.find({class_properties[i].get(), class_properties[j].get()});
+            if (it == known_verdicts_.end()) {
+                unknown.emplace_back(i, j);
+                continue;
+            }
+            ++reused_pairs;
+            if (it->second) reach.set(i, j);
+        }
+    }
+
+    // Close the known part of the relation so new pairs it implies are skipped
+    if (use_transitive_optimization_) {
+        for (size_t k = 0; k < n; ++k) {
+            for (size_t i = 0; i < n; ++i) {
+                if (!reach.test(i, k)) continue;
+                reach.orRow(i, k);
+                reach.reset(i, i);
+            }
+        }
+    }
+
+    std::vector<std::pair<size_t, size_t>> timed_out;
+    Statistics::instance().add(Statistic::PAIRS_PLANNED, unknown.size());
+    for (auto [i, j] : unknown) {
+        if (use_transitive_optimization_ && reach.test(i, j)) {
+            total_skipped_++;
+            Statistics::instance().add(Statistic::PAIRS_DECIDED);
+            continue;
+        }
+        PropertyResult result = checkRefinement(*class_properties[i], *class_properties[j]);
+        result.property1_index = i;
+        result.property2_index = j;
+        __recordResult(result);
+        ++checked_pairs;
+        if (result.verdict == SatVerdict::TIMEOUT) timed_out.emplace_back(i, j);
+        if (result.passed) {
+            reach.set(i, j);
+            // TRANSITIVE CLOSURE: If i->j, then i can reach everything j can reach
+            if (use_transitive_optimization_) {
+                reach.orRow(i, j);
+                reach.reset(i, i);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (reach.test(i, j)) graph.addEdge(i, j);
+        }
+    }
+    for (auto [i, j] : timed_out) {
+        if (!graph.hasEdge(i, j)) graph.addUnknownEdge(i, j);
+    }
+    __recordVerdicts(graph);
+    return graph;
+}
+
+AnalysisResult RefinementAnalyzer::reanalyze() {
+    if (!analyzed_) {
+        properties_.insert(properties_.end(), pending_properties_.begin(), pending_properties_.end());
+        pending_properties_.clear();
+        return analyze();
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    const StatisticValues statistics_initial = Statistics::instance().snapshot();
+
+    // Only the new properties need a satisfiability check
+    for (auto& property : pending_properties_) {
+        const size_t position = positions_assigned_++;
+        if (__isPropertyEmpty(*property)) {
+            std::cerr << "Property " << property->toString() << " is unsatisfiable and will be removed from analysis.\n";
+            false_properties_strings_.push_back(property->toString());
+            false_properties_index_.push_back(position);
+            continue;
+        }
+        __isPropertyValid(*property);
+        properties_.push_back(property);
+        property_positions_.push_back(position);
+    }
+    pending_properties_.clear();
+
+    // Classes whose member set is unchanged keep their graph as it is
+    std::map<std::vector<const CTLProperty*>, size_t> previous_classes;
+    for (size_t c = 0; c < equivalence_classes_.size(); ++c) {
+        std::vector<const CTLProperty*> key;
+        for (const auto& p : equivalence_classes_[c]) key.push_back(p.get());
+        std::sort(key.begin(), key.end());
+        previous_classes.emplace(std::move(key), c);
+    }
+    auto previous_graphs = std::move(refinement_graphs_);
+
+    buildEquivalenceClasses();
+
+    size_t reused_classes = 0, checked_pairs = 0, reused_pairs = 0;
+    refinement_graphs_.clear();
+    refinement_graphs_.reserve(equivalence_classes_.size());
+    for (const auto& class_properties : equivalence_classes_) {
+        std::vector<const CTLProperty*> key;
+        for (const auto& p : class_properties) key.push_back(p.get());
+        std::sort(key.begin(), key.end());
+
+        auto it = previous_classes.find(key);
+        if (it != previous_classes.end() && it->second < previous_graphs.size() &&
+            previous_graphs[it->second].getNodes() == class_properties) {
+            refinement_graphs_.push_back(std::move(previous_graphs[it->second]));
+            ++reused_classes;
+            continue;
+        }
+        refinement_graphs_.push_back(__analyzeClassIncremental(class_properties, checked_pairs, reused_pairs));
+    }
+
+    if (verbose_) {
+        std::cout << "    [Incremental] Reused " << reused_classes << "/" << equivalence_classes_.size()
+                  << " classes and " << reused_pairs << " verdicts, checked " << checked_pairs
+                  << " new pairs\n";
+    }
+
+    hot_path_statistics_ = Statistics::instance().snapshot() - statistics_initial;
+    __updateRequiredProperties();
+    return __collectResult(start_time);
+}
+
+AnalysisResult RefinementAnalyzer::__collectResult(std::chrono::high_resolution_clock::time_point start_time) const {
+    AnalysisResult result;
+    result.total_properties = properties_.size();
+    result.false_properties = false_properties_strings_.size();
+    result.equivalence_classes = equivalence_classes_.size();
+    result.parsing_time = std::chrono::milliseconds(0);
+    result.equivalence_time = std::chrono::milliseconds(0);
+
+    result.total_refinements = 0;
+    for (const auto& graph : refinement_graphs_) {
+        result.total_refinements += graph.getEdgeCount();
+        result.unknown_refinements += graph.getUnknownEdges().size();
+    }
+    result.required_properties = required_properties_.size();
+    result.transitive_eliminated = use_transitive_optimization_ ? total_skipped_ : -1;
+
+    result.prefilter_refines = prefilter_->decidedRefines();
+    result.prefilter_rejected = prefilter_->decidedNonRefines();
+    result.prefilter_undecided = prefilter_->undecided();
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.total_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    result.refinement_time = result.total_time;
+    result.peak_memory_kb = memory_utils::getPeakMemoryUsage();
+    return result;
+}
+
+} // namespace ctl
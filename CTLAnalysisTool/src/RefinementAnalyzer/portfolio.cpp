@@ -0,0 +1,95 @@
+#include "Analyzers/Refinement.h"
+#include "cancellation.h"
+#include "work_stealing_pool.h"
+
+#include <condition_variable>
+#include <exception>
+
+namespace ctl {
+
+WorkStealingPool& RefinementAnalyzer::__portfolioPool(size_t helpers) const {
+    std::lock_guard<std::mutex> lock(portfolio_pool_mutex_);
+    if (!portfolio_pool_) {
+        // One worker per helper engine of every check that may run at once,
+        // so no engine waits for a worker while its race goes on
+        const size_t checks = use_parallel_analysis_ ? std::max<size_t>(threads_, 1) : 1;
+        portfolio_pool_ = std::make_unique<WorkStealingPool>(checks * helpers);
+    }
+    return *portfolio_pool_;
+}
+
+SatVerdict RefinementAnalyzer::__racePortfolio(const CTLProperty& refining, const CTLProperty& refined) const {
+    // Cheap sound checks first. Both only ever prove a refinement
+    if (use_syntactic_refinement_ && refining.refinesSyntactic(refined)) {
+        Statistics::instance().add(Statistic::PORTFOLIO_SYNTACTIC_WINS);
+        return SatVerdict::UNSAT;
+    }
+    if (use_class_simulation_ && __classSimulation(refining, refined) == std::optional<bool>(true)) {
+        Statistics::instance().add(Statistic::PORTFOLIO_SIMULATION_WINS);
+        return SatVerdict::UNSAT;
+    }
+
+    // An engine answers with a definitive verdict or none. Inclusion is exact;
+    // a pair simulation misses may still refine; a solver may time out or fail
+    struct Engine {
+        Statistic wins;
+        std::function<std::optional<SatVerdict>()> decide;
+    };
+    std::vector<Engine> engines;
+    engines.push_back({Statistic::PORTFOLIO_INCLUSION_WINS, [&]() -> std::optional<SatVerdict> {
+        return refining.refinesSemantic(refined, true, emptiness_engine_) ? SatVerdict::UNSAT : SatVerdict::SAT;
+    }});
+    engines.push_back({Statistic::PORTFOLIO_SIMULATION_WINS, [&]() -> std::optional<SatVerdict> {
+        if (refining.refinesSemantic(refined, false)) return SatVerdict::UNSAT;
+        return std::nullopt;
+    }});
+    if (external_sat_interface_set_ && external_sat_interface_) {
+        engines.push_back({Statistic::PORTFOLIO_EXTERNAL_SAT_WINS, [&]() -> std::optional<SatVerdict> {
+            SatVerdict verdict = external_sat_interface_->checkRefinement(refining.toString(), refined.toString());
+            if (verdict == SatVerdict::SAT || verdict == SatVerdict::UNSAT) return verdict;
+            return std::nullopt;
+        }});
+    }
+
+    // Every engine runs under one token: the check timeout cancels them all,
+    // and so does the winner, at the losers' next checkpoint
+    CancellationToken token = check_timeout_.count() > 0 ? CancellationToken(check_timeout_) : CancellationToken();
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t running = engines.size();
+    std::optional<SatVerdict> winner;
+    std::exception_ptr failure;
+    auto run = [&](const Engine& engine) {
+        CancellationScope scope(&token);
+        std::optional<SatVerdict> verdict;
+        std::exception_ptr error;
+        try {
+            verdict = engine.decide();
+        } catch (const CheckCancelled&) {
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (verdict && !winner) {
+            winner = verdict;
+            Statistics::instance().add(engine.wins);
+            token.cancel();
+        }
+        if (error && !failure) failure = error;
+        if (--running == 0) finished.notify_all();
+    };
+
+    // The calling thread runs inclusion, which decides every pair eventually
+    WorkStealingPool& pool = __portfolioPool(engines.size() - 1);
+    for (size_t e = 1; e < engines.size(); ++e) {
+        pool.submit([&run, &engines, e](size_t) { run(engines[e]); });
+    }
+    run(engines.front());
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&running] { return running == 0; });
+    if (winner) return *winner;
+    if (failure) std::rethrow_exception(failure);
+    return SatVerdict::TIMEOUT;
+}
+
+} // namespace ctl
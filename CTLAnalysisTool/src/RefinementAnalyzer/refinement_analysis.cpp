@@ -2,14 +2,23 @@
 #include "Analyzers/Refinement.h"
 #include "CTLautomaton.h"
 #include "utils.h"
+#include "work_stealing_pool.h"
+#include "guard_sat_cache.h"
+#include "refinement_closure.h"
+#include "automaton_budget.h"
+#include "trace.h"
+#include "cancellation.h"
 
+#include <array>
 #include <chrono>
 #include <algorithm>
 #include <future>
 #include <atomic>
+#include <deque>
 #include <mutex>
 #include <numeric>
 #include <iomanip>
+#include <stdexcept>
 
 namespace ctl {
 
@@ -17,8 +26,31 @@ namespace ctl {
 AnalysisResult RefinementAnalyzer::analyze() {
     auto start_time = std::chrono::high_resolution_clock::now();
     auto mem_initial = memory_utils::getCurrentMemoryUsage();
+    const size_t cache_hits_initial = GuardSatCache::instance().hits();
+    const size_t cache_misses_initial = GuardSatCache::instance().misses();
+    const size_t prefilter_refines_initial = prefilter_->decidedRefines();
+    const size_t prefilter_rejected_initial = prefilter_->decidedNonRefines();
+    const size_t prefilter_undecided_initial = prefilter_->undecided();
+    const StatisticValues statistics_initial = Statistics::instance().snapshot();
     AnalysisResult result;
-    result.total_properties = properties_.size();
+    class_simulations_.clear();
+    witness_pools_.clear();
+    if (external_sat_interface_) external_sat_interface_->clearTranslations();
+    result.duplicate_properties = __deduplicate_properties();
+    result.total_properties = input_properties_.size();
+    if ((shard_count_ > 0 || !shard_results_.empty()) && !checkpoint_) {
+        throw std::runtime_error("Sharded analysis needs a checkpoint");
+    }
+    if (checkpoint_ && checkpoint_->begin(__checkpointFingerprint(), resume_)) {
+        std::cout << "Resuming from " << checkpoint_->path() << ": " << checkpoint_->finishedClasses()
+                  << " finished classes, " << checkpoint_->decidedPairs() << " decided pairs\n";
+    }
+    for (const auto& shard : shard_results_) {
+        if (!checkpoint_->absorb(shard)) {
+            std::cerr << "Warning: no results of this run in shard checkpoint " << shard
+                      << ", its work is done here\n";
+        }
+    }
     //result.initial_memory_mb = mem_initial.getResidentMB();
     // Parse time (already done in constructor, so this is 0)
     auto parse_end = std::chrono::high_resolution_clock::now();
@@ -26,58 +58,153 @@ AnalysisResult RefinementAnalyzer::analyze() {
     
     
     result.false_properties = 0;
-    if (use_parallel_analysis_) {
-        std::cout << "Checking and removing unsatisfiable properties in parallel...\n";
-        _checkAndRemoveUnsatisfiablePropertiesParallel();
-    } else {
-        std::cout << "Checking and removing unsatisfiable properties serially...\n";
-        _checkAndRemoveUnsatisfiableProperties();
+    // The pipeline replaces the phases up to the refinement; it has no
+    // checkpointed variant and the batched external SAT path has no automata
+    const bool pipelined = use_pipeline_ && use_parallel_analysis_ && !external_sat_interface_set_ && !checkpoint_;
+    if (!pipelined) {
+        CTL_TRACE_SPAN("phase", "remove unsatisfiable");
+        if (external_sat_interface_set_) {
+            std::cout << "Checking and removing unsatisfiable properties in one solver batch...\n";
+            _checkAndRemoveUnsatisfiablePropertiesBatch();
+        } else if (use_parallel_analysis_) {
+            std::cout << "Checking and removing unsatisfiable properties in parallel...\n";
+            _checkAndRemoveUnsatisfiablePropertiesParallel();
+        } else {
+            std::cout << "Checking and removing unsatisfiable properties serially...\n";
+            _checkAndRemoveUnsatisfiableProperties();
+        }
     }
 
     
     result.false_properties = false_properties_strings_.size();
     // Build equivalence classes
     auto equiv_start = std::chrono::high_resolution_clock::now();
-    buildEquivalenceClasses();
+    if (!pipelined) {
+        CTL_TRACE_SPAN("phase", "equivalence classes");
+        buildEquivalenceClasses();
+    }
     auto equiv_end = std::chrono::high_resolution_clock::now();
     result.equivalence_time = std::chrono::duration_cast<std::chrono::milliseconds>(equiv_end - equiv_start);
     result.equivalence_classes = equivalence_classes_.size();
-    result.equivalence_class_properties = equivalence_classes_;
-    
+
+    // Classes a resumed run finished before keep their saved graphs; only the
+    // others go through automaton construction and the refinement phase. A
+    // shard worker keeps only its own whole classes and checks its row blocks
+    // of the others afterwards
+    std::vector<std::vector<std::shared_ptr<CTLProperty>>> all_classes;
+    std::vector<std::optional<RefinementGraph>> restored;
+    std::vector<char> owned(equivalence_classes_.size(), shard_count_ == 0);
+    std::vector<ShardUnit> row_blocks;
+    if (shard_count_ > 0) {
+        for (const auto& unit : __shardUnits(equivalence_classes_)) {
+            if (unit.row_begin == 0 && unit.row_end == equivalence_classes_[unit.class_index].size()) {
+                owned[unit.class_index] = 1;
+            } else {
+                row_blocks.push_back(unit);
+            }
+        }
+    }
+    if (checkpoint_) {
+        restored = __restoreFinishedClasses();
+        all_classes = std::move(equivalence_classes_);
+        equivalence_classes_.clear();
+        for (size_t c = 0; c < all_classes.size(); ++c) {
+            if (!restored[c] && owned[c]) equivalence_classes_.push_back(all_classes[c]);
+        }
+        const size_t finished = std::count_if(restored.begin(), restored.end(),
+                                              [](const auto& graph) { return graph.has_value(); });
+        if (finished > 0) std::cout << "Restored " << finished << " finished classes from the checkpoint\n";
+    }
+    // For progress reports: every ordered pair of the classes and row blocks left to analyze
+    size_t planned_pairs = 0;
+    for (const auto& class_properties : equivalence_classes_) {
+        planned_pairs += class_properties.size() * (class_properties.size() - 1);
+    }
+    for (const auto& block : row_blocks) {
+        planned_pairs += (block.row_end - block.row_begin) * (all_classes[block.class_index].size() - 1);
+    }
+    Statistics::instance().add(Statistic::PAIRS_PLANNED, planned_pairs);
     
 
 
 
 
 
+    // Build automata up front. The batched external SAT path never uses them,
+    // and with a persistent cache most pairs are answered without them, so
+    // those build lazily instead, as does a run under a memory budget
+    if (!pipelined && !external_sat_interface_set_ && !cache_ && !AutomatonBudget::instance().enabled()) {
+        auto build_start = std::chrono::high_resolution_clock::now();
+        CTL_TRACE_SPAN("phase", "build automata");
+        __buildAutomata();
+        auto build_end = std::chrono::high_resolution_clock::now();
+        result.automaton_time = std::chrono::duration_cast<std::chrono::milliseconds>(build_end - build_start);
+    }
+
     // Analyze refinements
     auto refine_start = std::chrono::high_resolution_clock::now();
     auto mem_refine_start = memory_utils::getCurrentMemoryUsage();
-    if (use_parallel_analysis_) {
-        if (use_transitive_optimization_) {
-            std::cout << "Analyzing refinements in parallel with transitive optimization in parallel...\n";
-            analyzeRefinementsParallelOptimized();
+    {
+        CTL_TRACE_SPAN("phase", "refinement");
+        if (pipelined) {
+            std::cout << "Pruning, grouping and refining in one pipeline...\n";
+            __analyzePipelined();
+        } else if (external_sat_interface_set_ && !use_portfolio_) {
+            std::cout << "Analyzing refinements through batched external SAT queries...\n";
+            analyzeRefinementsBatched();
+        } else if (use_parallel_analysis_) {
+            if (use_transitive_optimization_) {
+                std::cout << "Analyzing refinements in parallel with transitive optimization in parallel...\n";
+                analyzeRefinementsParallelOptimized();
+            } else {
+                std::cout << "Analyzing refinements in parallel without transitive optimization...\n";
+                analyzeRefinementClassParallel();
+            }
         } else {
-            std::cout << "Analyzing refinements in parallel without transitive optimization...\n";
-            analyzeRefinementClassParallel();
+            std::cout << "Analyzing refinements serially...\n";
+            analyzeRefinements();
         }
-    } else {
-        std::cout << "Analyzing refinements serially...\n";
-        analyzeRefinements();
+    }
+    if (checkpoint_) {
+        __analyzeRowBlocks(all_classes, row_blocks);
+        // Back to class order, with the restored graphs in place and the
+        // classes left to other shards without edges
+        std::vector<RefinementGraph> analyzed = std::move(refinement_graphs_);
+        refinement_graphs_.clear();
+        refinement_graphs_.reserve(all_classes.size());
+        size_t next = 0;
+        for (size_t c = 0; c < all_classes.size(); ++c) {
+            if (restored[c]) {
+                refinement_graphs_.push_back(std::move(*restored[c]));
+            } else if (owned[c]) {
+                refinement_graphs_.push_back(std::move(analyzed[next++]));
+            } else {
+                RefinementGraph graph;
+                for (const auto& prop : all_classes[c]) graph.addNode(prop);
+                refinement_graphs_.push_back(std::move(graph));
+            }
+        }
+        equivalence_classes_ = std::move(all_classes);
+        __saveCheckpoint();
     }
     auto mem_refine_end = memory_utils::getCurrentMemoryUsage();
     auto refine_end = std::chrono::high_resolution_clock::now();
     result.refinement_time = std::chrono::duration_cast<std::chrono::milliseconds>(refine_end - refine_start);
     result.refinement_memory_kb = mem_refine_end.getResident() - mem_refine_start.getResident();
+    if (pipelined) {
+        result.false_properties = false_properties_strings_.size();
+        result.equivalence_classes = equivalence_classes_.size();
+    }
     // Calculate total refinements
     result.total_refinements = 0;
     for (const auto& graph : refinement_graphs_) {
         result.total_refinements += graph.getEdgeCount();
+        result.unknown_refinements += graph.getUnknownEdges().size();
     }
     
     // Calculate required properties (those with in-degree 0)
-    auto required = getRequiredProperties();
-    result.required_properties = required.size();
+    __updateRequiredProperties();
+    result.required_properties = required_properties_.size();
     
     // Apply transitive optimization if enabled (placeholder for now)
     if (use_transitive_optimization_) {
@@ -86,8 +213,6 @@ AnalysisResult RefinementAnalyzer::analyze() {
         result.transitive_eliminated = -1;
     }
     
-    result.class_graphs = refinement_graphs_;
-    
     auto end_time = std::chrono::high_resolution_clock::now();
     result.total_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
     auto mem_final = memory_utils::getCurrentMemoryUsage();
@@ -95,6 +220,19 @@ AnalysisResult RefinementAnalyzer::analyze() {
                                        ? (mem_final.resident_memory_kb - mem_initial.resident_memory_kb)
                                        : 0;
     result.peak_memory_kb = memory_utils::getPeakMemoryUsage();
+    result.guard_cache_hits = GuardSatCache::instance().hits() - cache_hits_initial;
+    result.guard_cache_misses = GuardSatCache::instance().misses() - cache_misses_initial;
+    result.prefilter_refines = prefilter_->decidedRefines() - prefilter_refines_initial;
+    result.prefilter_rejected = prefilter_->decidedNonRefines() - prefilter_rejected_initial;
+    result.prefilter_undecided = prefilter_->undecided() - prefilter_undecided_initial;
+    hot_path_statistics_ = Statistics::instance().snapshot() - statistics_initial;
+
+    // Remember every verdict of this run for reanalyze()
+    known_verdicts_.clear();
+    for (const auto& graph : refinement_graphs_) {
+        __recordVerdicts(graph);
+    }
+    analyzed_ = true;
 
     return result;
 }
@@ -104,55 +242,8 @@ void RefinementAnalyzer::buildEquivalenceClasses() {
         return;
     }
     
-    UnionFind uf;
-    
-    // Initialize all properties in the union-find structure
-    for (size_t i = 0; i < properties_.size(); ++i) {
-        uf.find(i); // This ensures the element is tracked
-    }
-    
-    // Build a map from atomic propositions to property indices
-    // Properties that share at least one atomic proposition should be in the same class
-    std::unordered_map<std::string, std::vector<size_t>> atom_to_properties;
-    
-    for (size_t i = 0; i < properties_.size(); ++i) {
-        //if property in false_properties_index skip it
-        bool skip = false;
-        for (const auto& index : false_properties_index_) {
-            if (i == index) {
-                skip = true;
-                break;
-            }
-        }
-        if (skip) continue;
-
-        const auto& atoms = properties_[i]->getAtomicPropositions();
-        for (const auto& atom : atoms) {
-            // Skip numeric literals - they're not meaningful for grouping
-            if (atom == "true" || atom == "false" || atom == "1" || atom == "0") {
-                continue;
-            }
-            // Skip if it's a pure number
-            try {
-                std::stod(atom);
-                continue; // It's a number, skip it
-            } catch (...) {
-                // Not a number, it's a valid atom
-            }
-            atom_to_properties[atom].push_back(i);
-        }
-    }
-    
-    // Unite all properties that share an atomic proposition
-    for (const auto& [atom, prop_indices] : atom_to_properties) {
-        // Unite all properties that share this atom
-        for (size_t i = 1; i < prop_indices.size(); ++i) {
-            uf.unite(prop_indices[0], prop_indices[i]);
-        }
-    }
-    
     // Build equivalence classes
-    auto classes = uf.getEquivalenceClasses();
+    auto classes = __groupByAtoms(properties_, use_polarity_classes_);
     equivalence_classes_.clear();
     equivalence_classes_.reserve(classes.size());
     
@@ -166,6 +257,79 @@ void RefinementAnalyzer::buildEquivalenceClasses() {
         
         equivalence_classes_.push_back(std::move(class_properties));
     }
+
+    if (use_shared_subformulas_) {
+        for (const auto& members : equivalence_classes_) __shareSubformulas(members);
+    }
+}
+
+void RefinementAnalyzer::__shareSubformulas(const std::vector<std::shared_ptr<CTLProperty>>& members) const {
+    auto store = std::make_shared<SubformulaStore>();
+    for (const auto& property : members) property->setSubformulaStore(store);
+}
+
+std::vector<std::vector<size_t>> RefinementAnalyzer::__groupByAtoms(
+    const std::vector<std::shared_ptr<CTLProperty>>& properties, bool polarity_classes) const {
+    const size_t n = properties.size();
+    UnionFind uf(n);
+    
+    // Properties that share at least one atomic proposition should be in the
+    // same class. Each stripe of properties maps its atoms to the first
+    // property using them and links the later ones to it; merging the maps
+    // of the stripes then links the stripes. Callers pass the satisfiable
+    // properties only, so every index takes part.
+    //
+    // With polarity classes an atom has one map per polarity, and a property
+    // enters those it occurs with: phi -> psi needs a shared atom of the same
+    // polarity in both once phi is satisfiable and psi is not valid. A
+    // property the one-state samples do not prove non-valid enters both maps
+    // with every atom, so it is grouped as before
+    using AtomOwners = std::array<std::unordered_map<std::string_view, size_t>, 2>;
+    constexpr size_t kPropertiesPerStripe = 4096;
+    const size_t stripes = std::clamp<size_t>(n / kPropertiesPerStripe, 1, std::max<size_t>(threads_, 1));
+    std::vector<AtomOwners> owners(stripes);
+    std::vector<std::vector<std::pair<size_t, size_t>>> links(stripes);
+    auto scan = [&](size_t stripe) {
+        for (size_t i = n * stripe / stripes; i < n * (stripe + 1) / stripes; ++i) {
+            const CTLProperty& property = *properties[i];
+            const bool signed_atoms = polarity_classes && prefilter_->hasCounterModel(property);
+            // Without polarities one map is enough; a possibly valid property enters both
+            const uint8_t unsigned_polarities = polarity_classes
+                ? CTLProperty::kPositive | CTLProperty::kNegative : CTLProperty::kPositive;
+            const auto& atoms = property.groupingAtoms();
+            for (size_t k = 0; k < atoms.size(); ++k) {
+                const uint8_t polarities = signed_atoms ? property.groupingPolarities()[k] : unsigned_polarities;
+                for (size_t sign = 0; sign < 2; ++sign) {
+                    if (!(polarities & (CTLProperty::kPositive << sign))) continue;
+                    auto [it, inserted] = owners[stripe][sign].emplace(atoms[k], i);
+                    if (!inserted) links[stripe].emplace_back(it->second, i);
+                }
+            }
+        }
+    };
+    if (stripes == 1) {
+        scan(0);
+    } else {
+        WorkStealingPool pool(stripes);
+        for (size_t stripe = 0; stripe < stripes; ++stripe) {
+            pool.submit([&scan, stripe](size_t) { scan(stripe); });
+        }
+        pool.wait();
+    }
+    
+    for (const auto& stripe_links : links) {
+        for (auto [first, other] : stripe_links) uf.unite(first, other);
+    }
+    for (size_t stripe = 1; stripe < stripes; ++stripe) {
+        for (size_t sign = 0; sign < 2; ++sign) {
+            for (const auto& [atom, first] : owners[stripe][sign]) {
+                auto [it, inserted] = owners[0][sign].emplace(atom, first);
+                if (!inserted) uf.unite(it->second, first);
+            }
+        }
+    }
+    
+    return uf.getEquivalenceClasses();
 }
 
 void RefinementAnalyzer::analyzeRefinements() {
@@ -175,6 +339,7 @@ void RefinementAnalyzer::analyzeRefinements() {
     for (size_t i = 0; i < equivalence_classes_.size(); ++i) {
         std::cout << "Analyzing refinement class " << (i + 1) << "/" << equivalence_classes_.size() << "...\n";
         _analyzeRefinementClassSerial(i, use_transitive_optimization_);
+        __checkpointClass(refinement_graphs_.back());
 
     }
 }
@@ -191,39 +356,81 @@ void RefinementAnalyzer::_analyzeRefinementClassSerial(size_t class_index, bool
     
     size_t n = class_properties.size();
     size_t skipped_pairs = 0;
+    size_t refuted_pairs = 0;
+    size_t condensed_pairs = 0;
+    using Closure = RefinementClosure<BitMatrix>;
+    Closure closure(n);
+    std::vector<std::pair<size_t, size_t>> timed_out;
+    BitMatrix jointly(n, n);  // pairs decided together with their reverse
+
+    // Rows go weakest property first, so the rows of the weaker properties a
+    // row may refine are complete when it is visited; targets go strongest
+    // first, since refining a strong property implies its whole row.
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    if (use_transitive) order = __strengthOrder(class_properties);
     
     // Check all pairs for refinement
     size_t total_operations = n * (n - 1);
     size_t completed_operations = 0;
     int last_printed_percent = -1;
     
-    for (size_t i = 0; i < n; ++i) {
-        for (size_t j = 0; j < n; ++j) {
+    for (size_t a = 0; a < n; ++a) {
+        const size_t i = order[a];
+        for (size_t b = n; b-- > 0; ) {
+            const size_t j = use_transitive ? order[b] : n - 1 - b;
             if (i == j) continue;
-            
-            // OPTIMIZATION: Skip if already reachable (transitive closure)
-            if (use_transitive && graph.hasEdge(i, j)) {
-                skipped_pairs++;
+            if (jointly.test(i, j)) {
                 completed_operations++;
                 continue;
             }
             
-            PropertyResult result = checkRefinement(*class_properties[i], *class_properties[j]);
-            result.property1_index = i;
-            result.property2_index = j;
-            if (result.passed) {
-                graph.addEdge(i, j);
-                
-                // TRANSITIVE CLOSURE: If i->j, then i can reach everything j can reach
-                if (use_transitive) {
-                    for (size_t k = 0; k < n; ++k) {
-                        if (graph.hasEdge(j, k)) {
-                            graph.addEdge(i, k);
-                        }
-                    }
+            // OPTIMIZATION: Skip pairs decided by the closure of known verdicts
+            if (use_transitive) {
+                auto inference = closure.infer(i, j);
+                if (inference != Closure::Inference::UNKNOWN) {
+                    if (inference == Closure::Inference::EQUIVALENT) condensed_pairs++;
+                    else if (inference != Closure::Inference::IMPLIED) refuted_pairs++;
+                    skipped_pairs++;
+                    Statistics::instance().add(Statistic::PAIRS_DECIDED);
+                    completed_operations++;
+                    continue;
+                }
+            }
+            
+            // Condensed properties are checked through their representative
+            const size_t ci = use_transitive ? closure.representative(i) : i;
+            const size_t cj = use_transitive ? closure.representative(j) : j;
+            auto apply = [&](PropertyResult result, size_t from, size_t to) {
+                result.property1_index = from;
+                result.property2_index = to;
+                if (result.passed) {
+                    closure.addRefines(from, to, use_transitive);
+                } else if (result.verdict == SatVerdict::TIMEOUT) {
+                    // Undecided: no refutation to propagate
+                    timed_out.emplace_back(from, to);
+                } else if (result.exact) {
+                    // A pair the engine only failed to prove refutes nothing else
+                    closure.addRefuted(from, to);
+                }
+                __recordResult(result);
+            };
+            // The reverse pair goes along while nothing decides it yet
+            if (use_joint_pairs_ && ci == i && cj == j &&
+                (!use_transitive || closure.infer(j, i) == Closure::Inference::UNKNOWN)) {
+                auto [forward, backward] = __checkBothDirections(*class_properties[i], *class_properties[j]);
+                apply(forward, i, j);
+                apply(backward, j, i);
+                jointly.set(j, i);
+            } else {
+                PropertyResult condensed = checkRefinement(*class_properties[ci], *class_properties[cj]);
+                apply(condensed, ci, cj);
+                // Only an exact verdict stands for the whole group; a miss on
+                // the representatives may still be proven on the pair itself
+                if (!condensed.passed && !condensed.exact && (ci != i || cj != j)) {
+                    apply(checkRefinement(*class_properties[i], *class_properties[j]), i, j);
                 }
             }
-            result_per_property_.push_back(result);
             completed_operations++;
             
             // Update progress bar every 5%
@@ -240,34 +447,336 @@ void RefinementAnalyzer::_analyzeRefinementClassSerial(size_t class_index, bool
         size_t total_pairs = n * (n - 1);
         double skip_ratio = (total_pairs > 0) ? (100.0 * skipped_pairs / total_pairs) : 0.0;
         std::cout << "    [Transitive Closure] Skipped " << skipped_pairs << "/" << total_pairs 
-                  << " pairs (" << std::fixed << std::setprecision(1) << skip_ratio << "%)" << std::endl;
+                  << " pairs (" << std::fixed << std::setprecision(1) << skip_ratio << "%, "
+                  << refuted_pairs << " by refutation, " << condensed_pairs << " by condensing "
+                  << closure.merges() << " equivalent properties)" << std::endl;
         
     }
     total_skipped_ += skipped_pairs;
+    if (use_transitive) __recordTransitiveStats(n, skipped_pairs, refuted_pairs, condensed_pairs, closure.merges());
+    closure.finalize();
     
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (closure.refines(i, j)) graph.addEdge(i, j);
+        }
+    }
+    for (auto [i, j] : timed_out) {
+        if (!graph.hasEdge(i, j)) graph.addUnknownEdge(i, j);
+    }
     refinement_graphs_.push_back(std::move(graph));
 }
 
-PropertyResult RefinementAnalyzer::checkRefinement(const CTLProperty& prop1, const CTLProperty& prop2) const {
-    auto mem_before = memory_utils::getCurrentMemoryUsage();
+std::vector<size_t> RefinementAnalyzer::__strengthOrder(
+        const std::vector<std::shared_ptr<CTLProperty>>& class_properties) const {
+    // A property holding in more of the prefilter's sampled one-state models is
+    // likely weaker; unsampled ones sit in the middle and ties go to the shorter
+    // formula, which tends to be the weaker one.
+    const int unsampled = static_cast<int>(RefinementPrefilter::kSampleWords * 32);
+    std::vector<std::pair<int, size_t>> keys;
+    keys.reserve(class_properties.size());
+    for (const auto& property : class_properties) {
+        int models = prefilter_->sampledModels(*property);
+        keys.emplace_back(models < 0 ? unsampled : models, property->toString().size());
+    }
+
+    std::vector<size_t> order(class_properties.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) {
+        if (keys[a].first != keys[b].first) return keys[a].first > keys[b].first;
+        return keys[a].second < keys[b].second;
+    });
+    return order;
+}
+
+PropertyResult RefinementAnalyzer::checkRefinement(const CTLProperty& prop1, const CTLProperty& prop2,
+                                                   PairSimulation* joint) const {
+    CTL_TRACE_SPAN("check", "refinement");
+    // Heap growth of this thread only: concurrent checks do not blur it
+    memory_utils::AllocationScope allocations;
     auto start_time = std::chrono::high_resolution_clock::now();
     bool res;
-    if (!external_sat_interface_set_) {
-        // Use existing refinement methods
-        res = prop1.refines(prop2, use_syntactic_refinement_, use_full_language_inclusion_);
+    // Query prop1 & !prop2: UNSAT means prop1 refines prop2
+    SatVerdict verdict;
+    // Pairs with an unsatisfiable or a valid side need no check; trivial
+    // ones are decided from the property signatures alone
+    std::optional<bool> shortcut = __decideBySatisfiability(prop1, prop2);
+    if (shortcut) Statistics::instance().add(Statistic::SATISFIABILITY_SHORTCUTS);
+    auto decision = RefinementPrefilter::Decision::UNKNOWN;
+    if (!shortcut && use_prefilter_) decision = prefilter_->check(prop1, prop2);
+    // Consult the persistent cache before any automaton is built
+    std::optional<bool> cached;
+    bool restored = false;
+    if (shortcut) {
+        cached = shortcut;
+    } else if (decision != RefinementPrefilter::Decision::UNKNOWN) {
+        cached = decision == RefinementPrefilter::Decision::REFINES;
+    } else {
+        // A pair decided before a resume, then the persistent cache
+        if (checkpoint_) cached = checkpoint_->lookupRefinement(prop1.toString(), prop2.toString());
+        restored = cached.has_value();
+        if (!cached && cache_) {
+            cached = cache_->lookupRefinement(__refinementCacheMode(), prop1.toString(), prop2.toString());
+        }
+    }
+    // A model of an earlier refutation in the class may refute this pair too
+    std::shared_ptr<WitnessPool> witnesses = !cached && use_witness_pool_ ? __witnessPool(prop1) : nullptr;
+    bool refuted_by_witness = false;
+    if (witnesses && witnesses->refutes(prop1, prop2)) {
+        Statistics::instance().add(Statistic::WITNESS_REFUTATIONS);
+        cached = false;
+        refuted_by_witness = true;
+    }
+    if (cached) {
+        res = *cached;
+        verdict = res ? SatVerdict::UNSAT : SatVerdict::SAT;
     } else {
-        // Use CTL-SAT for refinement checking
-        res = prop1.refines(prop2, *external_sat_interface_);
+        Statistics::instance().add(Statistic::REFINEMENT_CHECKS);
+        std::optional<CancellationToken> token;
+        if (check_timeout_.count() > 0) token.emplace(check_timeout_);
+        std::optional<WitnessCapture> capture;
+        if (witnesses) capture.emplace();
+        try {
+            std::optional<bool> simulated;
+            const bool simulation = !use_portfolio_ && !external_sat_interface_set_ && !use_full_language_inclusion_;
+            if (simulation && use_class_simulation_) {
+                simulated = __classSimulation(prop1, prop2);
+            } else if (simulation && joint) {
+                // The syntactic rules first, as refines() tries them
+                if (use_syntactic_refinement_ && prop1.refinesSyntactic(prop2)) {
+                    simulated = true;
+                } else {
+                    CancellationScope scope(token ? &*token : nullptr);
+                    simulated = __pairSimulation(*joint, prop1);
+                }
+            }
+            // A pair the preorder does not prove may still hold part by part
+            if (simulated && (*simulated || !use_compositional_refinement_)) {
+                // What refines() would find: the syntactic rules, then simulation
+                res = *simulated || (use_syntactic_refinement_ && prop1.refinesSyntactic(prop2));
+                verdict = res ? SatVerdict::UNSAT : SatVerdict::SAT;
+            } else if (use_portfolio_) {
+                verdict = __racePortfolio(prop1, prop2);
+                res = verdict == SatVerdict::UNSAT;
+            } else if (!external_sat_interface_set_) {
+                // Use existing refinement methods
+                res = prop1.refines(prop2, use_syntactic_refinement_, use_full_language_inclusion_, emptiness_engine_,
+                                    token ? &*token : nullptr, use_compositional_refinement_);
+                verdict = res ? SatVerdict::UNSAT : SatVerdict::SAT;
+            } else {
+                // Use CTL-SAT for refinement checking; an inconclusive query counts as no refinement
+                CancellationScope scope(token ? &*token : nullptr);
+                verdict = external_sat_interface_->checkRefinement(prop1.toString(), prop2.toString());
+                res = verdict == SatVerdict::UNSAT;
+            }
+        } catch (const CheckCancelled&) {
+            res = false;
+            verdict = SatVerdict::TIMEOUT;
+        }
+        if (capture) {
+            for (Witness& witness : capture->take()) {
+                if (witnesses->add(std::move(witness))) Statistics::instance().add(Statistic::WITNESSES_KEPT);
+            }
+        }
+    }
+    const bool conclusive = verdict == SatVerdict::SAT || verdict == SatVerdict::UNSAT;
+    if (cache_ && !shortcut && decision == RefinementPrefilter::Decision::UNKNOWN && !cached && conclusive) {
+        cache_->storeRefinement(__refinementCacheMode(), prop1.toString(), prop2.toString(), res);
+    }
+    if (checkpoint_ && !shortcut && decision == RefinementPrefilter::Decision::UNKNOWN && !restored && conclusive) {
+        checkpoint_->storeRefinement(prop1.toString(), prop2.toString(), res);
+        checkpoint_->maybeSave();
     }
     auto end_time = std::chrono::high_resolution_clock::now();
-    auto mem_after = memory_utils::getCurrentMemoryUsage();
-    size_t mem_delta = (mem_after.resident_memory_kb > mem_before.resident_memory_kb) 
-                      ? (mem_after.resident_memory_kb - mem_before.resident_memory_kb) 
-                      : 0;
+    if (cost_model_->recording() && !cached && conclusive) {
+        cost_model_->record(CostModel::features(prop1), CostModel::features(prop2),
+                            std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time));
+    }
+    const size_t mem_delta = allocations.retainedKB();
+    // Signatures, witnesses and the decision procedures refute exactly;
+    // a miss of simulation or the syntactic rules only fails to prove
+    const bool exact = shortcut || decision != RefinementPrefilter::Decision::UNKNOWN || refuted_by_witness ||
+                       (conclusive && (use_portfolio_ || external_sat_interface_set_ || use_full_language_inclusion_));
     return {res, 
             std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time),
-            0, 0, mem_delta};
+            0, 0, mem_delta, verdict,
+            std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time), exact};
+
+}
 
+std::pair<PropertyResult, PropertyResult> RefinementAnalyzer::__checkBothDirections(const CTLProperty& first,
+                                                                                   const CTLProperty& second) const {
+    PairSimulation joint{&first, &second};
+    PropertyResult forward = checkRefinement(first, second, &joint);
+    PropertyResult backward = checkRefinement(second, first, &joint);
+    return {forward, backward};
+}
+
+bool RefinementAnalyzer::__pairSimulation(PairSimulation& pair, const CTLProperty& refining) const {
+    if (!pair.simulation) {
+        pair.first_automaton = pair.first->automatonHandle();
+        pair.second_automaton = pair.second->automatonHandle();
+        pair.simulation = std::make_unique<CTLAutomaton::MutualSimulation>(*pair.first_automaton,
+                                                                           *pair.second_automaton);
+    }
+    return pair.simulation->simulated(&refining == pair.first);
+}
+
+std::optional<bool> RefinementAnalyzer::__classSimulation(const CTLProperty& refining,
+                                                          const CTLProperty& refined) const {
+    // Beyond this many states in a class, R and its worklist outgrow the pair checks
+    constexpr size_t kMaxClassStates = 2048;
+    std::shared_ptr<ClassSimulation> entry;
+    {
+        std::lock_guard<std::mutex> lock(class_simulations_mutex_);
+        auto it = class_simulations_.find(&refining);
+        if (it == class_simulations_.end()) {
+            for (const auto& members : equivalence_classes_) {
+                auto found = std::find_if(members.begin(), members.end(),
+                                          [&refining](const auto& p) { return p.get() == &refining; });
+                if (found == members.end()) continue;
+                __registerClassSimulation(members);
+                break;
+            }
+            it = class_simulations_.find(&refining);
+            if (it == class_simulations_.end()) return std::nullopt;
+        }
+        entry = it->second;
+    }
+    auto j = entry->index.find(&refined);
+    if (j == entry->index.end()) return std::nullopt;
+
+    // Pairs of the class wait here while the first one computes the preorder
+    std::call_once(entry->computed, [this, &entry] {
+        const size_t n = entry->members.size();
+        std::vector<std::shared_ptr<const CTLAutomaton>> handles;
+        std::vector<const CTLAutomaton*> automata;
+        size_t states = 0;
+        for (const auto& member : entry->members) {
+            handles.push_back(member->automatonHandle());
+            automata.push_back(handles.back().get());
+            states += automata.back()->numStates();
+        }
+        if (states > kMaxClassStates) {
+            entry->failed = true;
+            return;
+        }
+        // The time budget of every pair it stands for
+        std::optional<CancellationToken> token;
+        if (check_timeout_.count() > 0) token.emplace(check_timeout_ * std::max<size_t>(n * (n - 1), 1));
+        CancellationScope scope(token ? &*token : nullptr);
+        try {
+            entry->preorder = CTLAutomaton::simulationPreorder(automata);
+            Statistics::instance().add(Statistic::CLASS_SIMULATIONS);
+        } catch (const CheckCancelled&) {
+            entry->failed = true;
+        }
+    });
+    if (entry->failed) return std::nullopt;
+    return entry->preorder.test(entry->index.at(&refining), j->second);
+}
+
+std::shared_ptr<WitnessPool> RefinementAnalyzer::__witnessPool(const CTLProperty& refining) const {
+    std::lock_guard<std::mutex> lock(witness_pools_mutex_);
+    auto it = witness_pools_.find(&refining);
+    if (it != witness_pools_.end()) return it->second;
+    for (const auto& members : equivalence_classes_) {
+        if (std::none_of(members.begin(), members.end(), [&refining](const auto& p) { return p.get() == &refining; })) {
+            continue;
+        }
+        auto pool = std::make_shared<WitnessPool>();
+        for (const auto& member : members) witness_pools_[member.get()] = pool;
+        return pool;
+    }
+    return nullptr;
+}
+
+void RefinementAnalyzer::__registerClassSimulation(const std::vector<std::shared_ptr<CTLProperty>>& members) const {
+    auto created = std::make_shared<ClassSimulation>();
+    created->members = members;
+    for (size_t k = 0; k < members.size(); ++k) {
+        created->index.emplace(members[k].get(), k);
+        class_simulations_[members[k].get()] = created;
+    }
+}
+
+std::string RefinementAnalyzer::__refinementCacheMode() const {
+    if (external_sat_interface_set_ && !use_portfolio_) return __satisfiabilityCacheMode();
+    // Portfolio verdicts are exact, like those of inclusion
+    std::string mode = use_full_language_inclusion_ || use_portfolio_ ? "inclusion" : "simulation";
+    if (use_syntactic_refinement_) mode += "+syntactic";
+    return mode;
+}
+
+bool RefinementAnalyzer::__isPropertyEmpty(const CTLProperty& property, WorkStealingPool* pool) const {
+    const std::string mode = __satisfiabilityCacheMode();
+    std::optional<bool> satisfiable;
+    if (checkpoint_) satisfiable = checkpoint_->lookupSatisfiable(property.toString());
+    if (!satisfiable && cache_) satisfiable = cache_->lookupSatisfiable(mode, property.toString());
+    if (satisfiable) {
+        property.setSatisfiable(*satisfiable);
+        if (*satisfiable) prefilter_->noteSatisfiable(property);
+        return !*satisfiable;
+    }
+    bool is_false;
+    if (auto known = property.knownSatisfiable()) {
+        // Decided earlier, by this or another analyzer sharing the property
+        is_false = !*known;
+    } else if (!external_sat_interface_set_) {
+        // Simplify and check if ABTA is empty
+        property.simplify();
+        is_false = property.isEmpty(pool);
+    } else {
+        // Use CTL-SAT; only a proof of unsatisfiability removes the property
+        SatVerdict verdict = external_sat_interface_->checkSatisfiable(property.toString());
+        if (verdict == SatVerdict::TIMEOUT || verdict == SatVerdict::ERROR) {
+            std::cerr << "Satisfiability of " << property.toString() << " is unknown ("
+                      << SatVerdictToString(verdict) << "), keeping it in the analysis.\n";
+            return false;
+        }
+        is_false = verdict == SatVerdict::UNSAT;
+        property.setSatisfiable(!is_false);
+    }
+    if (cache_) cache_->storeSatisfiable(mode, property.toString(), !is_false);
+    if (checkpoint_) {
+        checkpoint_->storeSatisfiable(property.toString(), !is_false);
+        checkpoint_->maybeSave();
+    }
+    if (!is_false) prefilter_->noteSatisfiable(property);
+    return is_false;
+}
+
+bool RefinementAnalyzer::__isPropertyValid(const CTLProperty& property, WorkStealingPool* pool) const {
+    if (auto valid = property.knownValid()) return *valid;
+    if (prefilter_->hasCounterModel(property)) {
+        property.setValid(false);
+        return false;
+    }
+    // Valid iff the negation is unsatisfiable, cached under the negation
+    const std::string mode = __satisfiabilityCacheMode();
+    const std::string negation = "!(" + property.toString() + ")";
+    std::optional<bool> negation_satisfiable;
+    if (cache_) negation_satisfiable = cache_->lookupSatisfiable(mode, negation);
+    if (!negation_satisfiable) {
+        if (!external_sat_interface_set_) {
+            negation_satisfiable = !property.isValid(pool);
+        } else {
+            SatVerdict verdict = external_sat_interface_->checkSatisfiable(negation);
+            if (verdict == SatVerdict::TIMEOUT || verdict == SatVerdict::ERROR) return false;
+            negation_satisfiable = verdict == SatVerdict::SAT;
+        }
+        if (cache_) cache_->storeSatisfiable(mode, negation, *negation_satisfiable);
+    }
+    property.setValid(!*negation_satisfiable);
+    return !*negation_satisfiable;
+}
+
+std::optional<bool> RefinementAnalyzer::__decideBySatisfiability(const CTLProperty& refining,
+                                                                 const CTLProperty& refined) {
+    if (refining.knownSatisfiable() == false || refined.knownValid() == true) return true;
+    if (refining.knownSatisfiable() == true && refined.knownSatisfiable() == false) return false;
+    if (refining.knownValid() == true && refined.knownValid() == false) return false;
+    return std::nullopt;
 }
 
 void RefinementAnalyzer::analyzeRefinementClassParallel() {
@@ -279,18 +788,287 @@ void RefinementAnalyzer::analyzeRefinementClassParallel() {
     // Collect results
     for (size_t i = 0; i < futures.size(); ++i) {
         refinement_graphs_[i] = futures[i].get();
+        __checkpointClass(refinement_graphs_[i]);
     }
 }
 
+// Per-class reachability matrix shared by all (i, j) tasks of that class
+struct RefinementAnalyzer::PairSchedule {
+    size_t n = 0;
+    std::unique_ptr<RefinementClosure<AtomicBitMatrix>> closure;
+    // With joint pairs: the task that decides each pair, by its own or its
+    // reverse's claim
+    std::unique_ptr<AtomicBitMatrix> claimed;
+    std::atomic<size_t> skipped_pairs{0};
+    std::atomic<size_t> refuted_pairs{0};
+    std::atomic<size_t> condensed_pairs{0};
+    std::atomic<size_t> remaining{0};
+    std::mutex timed_out_mutex;
+    std::vector<std::pair<size_t, size_t>> timed_out;
+};
+
 void RefinementAnalyzer::analyzeRefinementsParallelOptimized() {
     refinement_graphs_.clear();
-    refinement_graphs_.reserve(equivalence_classes_.size());
+    refinement_graphs_.resize(equivalence_classes_.size());
+
+    WorkStealingPool pool(threads_);
+    std::vector<std::unique_ptr<PairSchedule>> states(equivalence_classes_.size());
+    std::atomic<size_t> classes_done(0);
 
-    // Run sequentially over classes (inner level already parallel)
-    int class_count = 0;
-    for (const auto& eq_class : equivalence_classes_) {
-        refinement_graphs_.push_back(_analyzeClassTaskOptimized(eq_class));
-        std::cout << "Equivalence class analyzed. ("<< ++class_count << "/" << equivalence_classes_.size() << ")\n";
+    // Submit the costliest classes first so the long tail of cheap ones fills
+    // the gaps (longest processing time first)
+    std::vector<std::vector<double>> row_costs(equivalence_classes_.size());
+    std::vector<double> class_costs(equivalence_classes_.size());
+    for (size_t c = 0; c < equivalence_classes_.size(); ++c) {
+        class_costs[c] = __classCost(equivalence_classes_[c], row_costs[c]);
+    }
+    std::vector<size_t> order(equivalence_classes_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&class_costs](size_t a, size_t b) {
+        return class_costs[a] > class_costs[b];
+    });
+
+    std::cout << "    [Refinement] Scheduling " << equivalence_classes_.size()
+              << " classes on " << pool.size() << " worker threads...\n";
+
+    for (size_t c : order) {
+        if (equivalence_classes_[c].size() <= 1) classes_done.fetch_add(1);
+        states[c] = __schedulePairs(pool, equivalence_classes_[c], row_costs[c], [this, &classes_done] {
+            std::cout << "Equivalence class analyzed. (" << classes_done.fetch_add(1) + 1
+                      << "/" << equivalence_classes_.size() << ")\n";
+        });
+    }
+
+    pool.wait();
+
+    // Build the graphs from the reachability matrices (single-threaded, no race conditions)
+    for (size_t c = 0; c < equivalence_classes_.size(); ++c) {
+        refinement_graphs_[c] = __scheduledGraph(equivalence_classes_[c], *states[c], c);
+        __checkpointClass(refinement_graphs_[c]);
+    }
+}
+
+double RefinementAnalyzer::__classCost(const std::vector<std::shared_ptr<CTLProperty>>& class_properties,
+                                       std::vector<double>& row_costs) const {
+    std::vector<CostModel::Features> members;
+    members.reserve(class_properties.size());
+    for (const auto& property : class_properties) members.push_back(CostModel::features(*property));
+    return cost_model_->classCost(members, &row_costs);
+}
+
+std::unique_ptr<RefinementAnalyzer::PairSchedule> RefinementAnalyzer::__schedulePairs(
+    WorkStealingPool& pool, const std::vector<std::shared_ptr<CTLProperty>>& class_properties,
+    const std::vector<double>& row_costs, std::function<void()> on_done) {
+    auto state = std::make_unique<PairSchedule>();
+    PairSchedule* st = state.get();
+    st->n = class_properties.size();
+    st->closure = std::make_unique<RefinementClosure<AtomicBitMatrix>>(st->n);
+    if (use_joint_pairs_) st->claimed = std::make_unique<AtomicBitMatrix>(st->n);
+    st->remaining.store(st->n > 1 ? st->n * (st->n - 1) : 0);
+    if (st->n <= 1) return state;
+
+    // One fine-grained task per ordered pair; row-major order keeps the
+    // transitive skip effective because rows tend to finish front to back.
+    // Rows go weakest property first and targets strongest first, as in
+    // the serial analysis. Without the closure nothing depends on the
+    // order, so the costliest rows go first
+    std::vector<size_t> order(st->n);
+    std::iota(order.begin(), order.end(), 0);
+    const bool negative = use_transitive_optimization_;
+    if (negative) {
+        order = __strengthOrder(class_properties);
+    } else {
+        std::stable_sort(order.begin(), order.end(), [&row_costs](size_t a, size_t b) {
+            return row_costs[a] > row_costs[b];
+        });
+    }
+    auto done = std::make_shared<std::function<void()>>(std::move(on_done));
+    // Under a memory budget the pairs go tile by tile, so a tile's
+    // automata stay resident while it is checked. Without one the
+    // single tile is the whole class
+    constexpr size_t kPairTile = 32;
+    const size_t tile = AutomatonBudget::instance().enabled() ? kPairTile : st->n;
+    for (size_t a0 = 0; a0 < st->n; a0 += tile)
+    for (size_t b_end = st->n; b_end > 0; b_end -= std::min(tile, b_end))
+    for (size_t a = a0; a < std::min(a0 + tile, st->n); ++a) {
+        for (size_t b = b_end; b-- > b_end - std::min(tile, b_end); ) {
+            const size_t i = order[a];
+            const size_t j = negative ? order[b] : st->n - 1 - b;
+            if (i == j) continue;
+            pool.submit([this, st, i, j, negative, &class_properties, done](size_t) {
+                using Closure = RefinementClosure<AtomicBitMatrix>;
+                auto apply = [this, st](PropertyResult result, size_t from, size_t to) {
+                    result.property1_index = from;
+                    result.property2_index = to;
+                    __recordResult(result);
+                    if (result.passed) {
+                        st->closure->addRefines(from, to);
+                    } else if (result.verdict == SatVerdict::TIMEOUT) {
+                        std::lock_guard<std::mutex> lock(st->timed_out_mutex);
+                        st->timed_out.emplace_back(from, to);
+                    } else if (result.exact) {
+                        st->closure->addRefuted(from, to);
+                    }
+                };
+                auto inference = Closure::Inference::UNKNOWN;
+                if (st->claimed && st->claimed->testAndSet(i, j)) {
+                    // Decided by the task of (j, i), which records it
+                } else if ((inference = st->closure->infer(i, j, negative)) != Closure::Inference::UNKNOWN) {
+                    st->skipped_pairs.fetch_add(1, std::memory_order_relaxed);
+                    Statistics::instance().add(Statistic::PAIRS_DECIDED);
+                    if (inference == Closure::Inference::EQUIVALENT) {
+                        st->condensed_pairs.fetch_add(1, std::memory_order_relaxed);
+                    } else if (inference != Closure::Inference::IMPLIED) {
+                        st->refuted_pairs.fetch_add(1, std::memory_order_relaxed);
+                    }
+                } else {
+                    // Condensed properties are checked through their representative
+                    const size_t ci = st->closure->representative(i);
+                    const size_t cj = st->closure->representative(j);
+                    // The reverse pair goes along while nothing decides it
+                    // yet and its own task has not started
+                    if (st->claimed && ci == i && cj == j &&
+                        st->closure->infer(j, i, negative) == Closure::Inference::UNKNOWN &&
+                        !st->claimed->testAndSet(j, i)) {
+                        auto [forward, backward] = __checkBothDirections(*class_properties[i], *class_properties[j]);
+                        apply(forward, i, j);
+                        apply(backward, j, i);
+                    } else {
+                        PropertyResult condensed = checkRefinement(*class_properties[ci], *class_properties[cj]);
+                        apply(condensed, ci, cj);
+                        if (!condensed.passed && !condensed.exact && (ci != i || cj != j)) {
+                            apply(checkRefinement(*class_properties[i], *class_properties[j]), i, j);
+                        }
+                    }
+                }
+                if (st->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) (*done)();
+            });
+        }
+    }
+    return state;
+}
+
+RefinementGraph RefinementAnalyzer::__scheduledGraph(const std::vector<std::shared_ptr<CTLProperty>>& class_properties,
+                                                     PairSchedule& st, size_t class_index) {
+    RefinementGraph graph;
+    for (const auto& prop : class_properties) {
+        graph.addNode(prop);
+    }
+
+    if (use_transitive_optimization_ && st.n > 1) {
+        size_t total_pairs = st.n * (st.n - 1);
+        size_t skipped = st.skipped_pairs.load();
+        if (skipped > 0) {
+            double skip_ratio = (total_pairs > 0) ? (100.0 * skipped / total_pairs) : 0.0;
+            std::cout << "    [Transitive Closure] Class " << (class_index + 1) << ": skipped " << skipped << "/" << total_pairs
+                      << " pairs (" << std::fixed << std::setprecision(1) << skip_ratio << "%, "
+                      << st.refuted_pairs.load() << " by refutation, " << st.condensed_pairs.load()
+                      << " by condensing " << st.closure->merges() << " equivalent properties)" << std::endl;
+        }
+        total_skipped_ += skipped;
+        __recordTransitiveStats(st.n, skipped, st.refuted_pairs.load(), st.condensed_pairs.load(),
+                                st.closure->merges());
+    }
+    st.closure->finalize();
+
+    for (size_t i = 0; i < st.n; ++i) {
+        for (size_t j = 0; j < st.n; ++j) {
+            if (st.closure->refines(i, j)) {
+                graph.addEdge(i, j);
+            }
+        }
+    }
+    for (auto [i, j] : st.timed_out) {
+        if (!graph.hasEdge(i, j)) graph.addUnknownEdge(i, j);
+    }
+    return graph;
+}
+
+
+void RefinementAnalyzer::__analyzePipelined() {
+    // Pruning only removes properties, so each final class lies inside one
+    // component of all properties linked by shared atoms. A component's
+    // classes are final once its last member is checked, and their pairs go
+    // on the same pool while other properties are still being checked
+    const auto components = __groupByAtoms(properties_, false);
+    const size_t n = properties_.size();
+    std::vector<size_t> component_of(n);
+    auto pending = std::make_unique<std::atomic<size_t>[]>(components.size());
+    for (size_t c = 0; c < components.size(); ++c) {
+        pending[c].store(components[c].size(), std::memory_order_relaxed);
+        for (size_t i : components[c]) component_of[i] = c;
+    }
+
+    struct FinalClass {
+        size_t first = 0;  // index of its first member in properties_
+        std::vector<std::shared_ptr<CTLProperty>> members;
+        std::unique_ptr<PairSchedule> schedule;
+    };
+    std::mutex classes_mutex;
+    std::deque<FinalClass> classes;  // a deque keeps entries in place while others are added
+    std::vector<char> is_false(n, 0);
+    std::atomic<size_t> classes_done(0);
+    WorkStealingPool pool(threads_);
+
+    // The classes of a checked component: its satisfiable members grouped
+    // by the same rule as buildEquivalenceClasses()
+    auto finalize = [&](size_t component) {
+        std::vector<size_t> survivors;
+        std::vector<std::shared_ptr<CTLProperty>> properties;
+        for (size_t i : components[component]) {
+            if (is_false[i]) continue;
+            survivors.push_back(i);
+            properties.push_back(properties_[i]);
+        }
+        for (const auto& indices : __groupByAtoms(properties, use_polarity_classes_)) {
+            FinalClass* entry;
+            {
+                std::lock_guard<std::mutex> lock(classes_mutex);
+                entry = &classes.emplace_back();
+            }
+            entry->first = survivors[indices.front()];
+            for (size_t k : indices) entry->members.push_back(properties[k]);
+            const size_t size = entry->members.size();
+            if (use_shared_subformulas_) __shareSubformulas(entry->members);
+            if (use_class_simulation_) {
+                std::lock_guard<std::mutex> lock(class_simulations_mutex_);
+                __registerClassSimulation(entry->members);
+            }
+            Statistics::instance().add(Statistic::PAIRS_PLANNED, size * (size - 1));
+            std::vector<double> row_costs;
+            __classCost(entry->members, row_costs);
+            entry->schedule = __schedulePairs(pool, entry->members, row_costs, [&classes_done] {
+                std::cout << "Equivalence class analyzed. (" << classes_done.fetch_add(1) + 1 << " so far)\n";
+            });
+        }
+    };
+
+    // Largest closure first, as in the phased pruning
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return properties_[a]->size() > properties_[b]->size();
+    });
+    for (size_t i : order) {
+        pool.submit([this, i, &is_false, &pending, &component_of, &finalize](size_t) {
+            is_false[i] = __isPropertyEmpty(*properties_[i]);
+            if (!is_false[i]) __isPropertyValid(*properties_[i]);
+            const size_t component = component_of[i];
+            if (pending[component].fetch_sub(1, std::memory_order_acq_rel) == 1) finalize(component);
+        });
+    }
+    pool.wait();
+
+    // Classes in the order buildEquivalenceClasses() gives them: by first member
+    std::sort(classes.begin(), classes.end(), [](const FinalClass& a, const FinalClass& b) {
+        return a.first < b.first;
+    });
+    __removeProperties(is_false);
+    equivalence_classes_.clear();
+    refinement_graphs_.clear();
+    for (auto& entry : classes) {
+        refinement_graphs_.push_back(__scheduledGraph(entry.members, *entry.schedule, equivalence_classes_.size()));
+        equivalence_classes_.push_back(std::move(entry.members));
     }
 }
 
@@ -316,6 +1094,28 @@ void RefinementAnalyzer::analyzeRefinementsParallelOptimized() {
 //    }
 //}
 
+void RefinementAnalyzer::__buildAutomata() {
+    // Properties alone in their class are never compared
+    std::vector<const CTLProperty*> pending;
+    for (const auto& class_properties : equivalence_classes_) {
+        if (class_properties.size() < 2) continue;
+        for (const auto& prop : class_properties) pending.push_back(prop.get());
+    }
+    if (pending.empty()) return;
+
+    std::cout << "Building " << pending.size() << " automata"
+              << (use_parallel_analysis_ ? " in parallel" : "") << "...\n";
+    if (!use_parallel_analysis_ || threads_ <= 1) {
+        for (const CTLProperty* prop : pending) prop->automaton();
+        return;
+    }
+    WorkStealingPool pool(std::min(threads_, pending.size()));
+    for (const CTLProperty* prop : pending) {
+        pool.submit([prop](size_t) { prop->automaton(); });
+    }
+    pool.wait();
+}
+
 std::vector<std::future<RefinementGraph>> RefinementAnalyzer::createAnalysisTasks() {
     std::vector<std::future<RefinementGraph>> futures;
     futures.reserve(equivalence_classes_.size());
@@ -341,185 +1141,46 @@ RefinementGraph RefinementAnalyzer::_analyzeClassTask(const std::vector<std::sha
         graph.addNode(prop);
     }
     
-    // Check all pairs for refinement
+    // Check all pairs for refinement; the automata are shared read-only with
+    // the other class tasks, only the results need the lock
+    std::vector<PropertyResult> results;
+    auto apply = [&graph, &results](PropertyResult result, size_t i, size_t j) {
+        result.property1_index = i;
+        result.property2_index = j;
+        if (result.passed) {
+            graph.addEdge(i, j);
+        } else if (result.verdict == SatVerdict::TIMEOUT) {
+            graph.addUnknownEdge(i, j);
+        }
+        results.push_back(result);
+    };
     for (size_t i = 0; i < class_properties.size(); ++i) {
         for (size_t j = 0; j < class_properties.size(); ++j) {
-            if (i != j) {
-                PropertyResult result = checkRefinement(*class_properties[i], *class_properties[j]);
-                result.property1_index = i;
-                result.property2_index = j;
-                if (result.passed) {
-                    graph.addEdge(i, j);
-                }
-                result_per_property_.push_back(result);
+            if (i == j) continue;
+            if (!use_joint_pairs_) {
+                apply(checkRefinement(*class_properties[i], *class_properties[j]), i, j);
+            } else if (i < j) {
+                // j->i goes along with i->j
+                auto [forward, backward] = __checkBothDirections(*class_properties[i], *class_properties[j]);
+                apply(forward, i, j);
+                apply(backward, j, i);
             }
         }
     }
+    __recordResults(results);
 
 
     
     return graph;
 }
 
-// Optimized version with property-level parallelization and transitive closure
-RefinementGraph RefinementAnalyzer::_analyzeClassTaskOptimized(const std::vector<std::shared_ptr<CTLProperty>>& class_properties) {
-    RefinementGraph graph;
-    
-    // Add all properties as nodes
-    for (const auto& prop : class_properties) {
-        graph.addNode(prop);
-    }
-    
-    size_t n = class_properties.size();
-    if (n <= 1) {
-        return graph;
-    }
-
-    // Simple reachability array - using std::atomic<bool> for thread safety
-    std::unique_ptr<std::atomic<bool>[]> reachability(new std::atomic<bool>[n * n]);
-    for (size_t i = 0; i < n * n; ++i) {
-        reachability[i].store(false, std::memory_order_relaxed);
-    }
-    
-    // Lambda to access reachability[i][j]
-    auto reach = [&](size_t i, size_t j) -> std::atomic<bool>& {
-        if (i >= n || j >= n) {
-            throw std::out_of_range("reachability index out of range");
-        }
-        return reachability[i * n + j];
-    };
-    
-    std::atomic<size_t> skipped_pairs(0);
-    std::mutex update_mutex;  // Protect transitive closure updates
-    std::mutex read_mutex;
-    // Process all pairs in parallel - check refinements and update reachability
-    std::vector<std::future<std::vector<PropertyResult>>> futures;
-    
-    std::cout << "    [Refinement Class] Analyzing " << n << " properties with " << threads_ << " threads...\n";
-    auto num_threads = threads_;
-    for (size_t t = 0; t < num_threads; ++t) {
-        futures.push_back(std::async(std::launch::async, [&, t, num_threads]() -> std::vector<PropertyResult> {
-            std::vector<PropertyResult> results_per_thread;
-            // Each thread handles rows: t, t+threads_, t+2*threads_, ...
-            for (size_t i = t; i < n; i += num_threads) {
-                for (size_t j = 0; j < n; ++j) {
-                    if (i == j) continue;
-                    
-    
-                        if (reach(i, j).load(std::memory_order_acquire)) {
-                            skipped_pairs.fetch_add(true, std::memory_order_relaxed);
-                            continue;
-                        }
-                    
-                    
-                    // Actually test refinement
-                    PropertyResult result = checkRefinement(*class_properties[i], *class_properties[j]);
-                    result.property1_index = i;
-                    result.property2_index = j;
-                    results_per_thread.push_back(result);
-                    if (result.passed) {
-                        // Mark direct reachability
-                        reach(i, j).store(1, std::memory_order_release);
-                        
-                        // TRANSITIVE CLOSURE: If i->j, then i can reach everything j can reach
-                        
-                            for (size_t k = 0; k < n; ++k) {
-                                if (reach(j, k).load(std::memory_order_relaxed)) {
-                                    reach(i, k).store(true, std::memory_order_relaxed);
-                                }
-                            }
-                        
-                    }
-                }
-            }
-            return results_per_thread;
-        }));
-    }
-    
-    // Wait for all threads to complete
-    for (auto& future : futures) {
-        auto results = future.get();
-        result_per_property_.insert(result_per_property_.end(), results.begin(), results.end());
-    }
-    
-    // Print optimization statistics
-    if (use_transitive_optimization_) {
-        size_t total_pairs = n * (n - 1);
-        size_t skipped = skipped_pairs.load();
-        if (skipped > 0) {
-            double skip_ratio = (total_pairs > 0) ? (100.0 * skipped / total_pairs) : 0.0;
-            std::cout << "    [Transitive Closure] Skipped " << skipped << "/" << total_pairs 
-                      << " pairs (" << std::fixed << std::setprecision(1) << skip_ratio << "%)" << std::endl;
-        }
-        total_skipped_ += skipped;
-    }
-    
-    // Now build the graph from the reachability matrix (single-threaded, no race conditions)
-    for (size_t i = 0; i < n; ++i) {
-        for (size_t j = 0; j < n; ++j) {
-            if (reach(i, j).load(std::memory_order_acquire)) {
-                graph.addEdge(i, j);
-            }
-        }
-    }
-    
-    return graph;
-}
-
-
-    void RefinementAnalyzer::_checkAndRemoveUnsatisfiableProperties() {
-
-        for (auto it = properties_.begin(); it != properties_.end(); ) {
-            bool is_false = false;
-
-            if (!external_sat_interface_) {
-                // Simplify and check if ABTA is empty
-                (*it)->simplify();
-                is_false = (*it)->isEmpty();
-            } else {
-                // Use CTL-SAT to check for unsatisfiability
-                is_false = !(*it)->isSatisfiable(*external_sat_interface_);//!ctl_sat_interface_->isSatisfiable((*it)->toString(), true);
-            }
-
-            if (is_false) {
-                std::cerr << "Property " << (*it)->toString() << " is unsatisfiable and will be removed from analysis.\n";
-                false_properties_strings_.push_back((*it)->toString());
-                false_properties_index_.push_back(std::distance(properties_.begin(), it));
-                it = properties_.erase(it); // Remove property if unsatisfiable
-            } else {
-                ++it; // Move to next property
-            }
+    void RefinementAnalyzer::_checkAndRemoveUnsatisfiableProperties(WorkStealingPool* pool) {
+        std::vector<char> is_false(properties_.size(), 0);
+        for (size_t i = 0; i < properties_.size(); ++i) {
+            is_false[i] = __isPropertyEmpty(*properties_[i], pool);
+            if (!is_false[i]) __isPropertyValid(*properties_[i], pool);
         }
-
-        //if (!use_ctl_sat_){
-        //    //create all the abtas before hand. If the abta is empty, we remove the property!
-        //    for (auto it = properties_.begin(); it != properties_.end(); ) {
-        //        it->get()->simplify();
-        //        if(it->get()->isEmpty()) {
-        //            std::cerr << "Property " << it->get()->toString() << " has an empty ABTA and will be removed from analysis.\n";
-        //            false_properties_strings_.push_back(it->get()->toString());
-        //            false_properties_index_.push_back(std::distance(properties_.begin(), it));
-        //            it = properties_.erase(it); // Remove property if ABTA creation fails
-        //        } else {
-        //            ++it; // Move to next property
-        //        }
-        //    }
-        //}else{
-//
-        //    for (auto it = properties_.begin(); it != properties_.end(); ) {
-        //        // Use CTL-SAT to check for unsatisfiability
-        //        std::cout << "Checking property for unsatisfiability using CTL-SAT: " << it->get()->toString() << std::endl;
-        //        bool is_unsat = ctl_sat_interface_->isSatisfiable(it->get()->toString(),true) == false;
-        //        if (is_unsat) {
-        //            std::cerr << "Property " << it->get()->toString() << " is unsatisfiable according to CTL-SAT and will be removed from analysis.\n";
-        //            false_properties_strings_.push_back(it->get()->toString());
-        //            false_properties_index_.push_back(std::distance(properties_.begin(), it));
-        //            it = properties_.erase(it); // Remove property if unsatisfiable
-        //        } else {
-        //            ++it; // Move to next property
-        //        }
-        //    }
-        //}
+        __removeProperties(is_false);
     }
 
 
@@ -527,52 +1188,54 @@ RefinementGraph RefinementAnalyzer::_analyzeClassTaskOptimized(const std::vector
         if (properties_.empty()) return;
         
         size_t n = properties_.size();
-        std::vector<std::future<std::vector<size_t>>> futures;
-        
-        // Launch parallel tasks
-        for (size_t t = 0; t < threads_; ++t) {
-            futures.push_back(std::async(std::launch::async, [this, t, n]() -> std::vector<size_t> {
-                std::vector<size_t> false_indices;
-                
-                // Each thread handles indices: t, t+threads_, t+2*threads_, ...
-                for (size_t i = t; i < n; i += threads_) {
-                    bool is_false = false;
-                    
-                    if (!external_sat_interface_set_) {
-                        // Simplify and check if ABTA is empty
-                        properties_[i]->simplify();
-                        is_false = properties_[i]->isEmpty();
-                    } else {
-                        // Use CTL-SAT to check for unsatisfiability
-                        properties_[i]->isEmpty(*external_sat_interface_);
-                    }
-                    
-                    if (is_false) {
-                        false_indices.push_back(i);
-                    }
-                }
-                
-                return false_indices;
-            }));
+        if (n < threads_) {
+            // Too few properties to go round: check them one by one and
+            // spread the blocks of each automaton over the threads instead
+            WorkStealingPool pool(threads_);
+            _checkAndRemoveUnsatisfiableProperties(&pool);
+            return;
         }
-        
-        // Collect all false property indices from all threads
-        std::vector<size_t> all_false_indices;
-        for (auto& future : futures) {
-            auto thread_false_indices = future.get();
-            all_false_indices.insert(all_false_indices.end(), 
-                                    thread_false_indices.begin(), 
-                                    thread_false_indices.end());
+
+        // One task per property, largest closure first so the expensive
+        // automata do not start last; idle workers steal what is left
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return properties_[a]->size() > properties_[b]->size();
+        });
+        std::vector<char> is_false(n, 0);
+        WorkStealingPool pool(threads_);
+        for (size_t i : order) {
+            pool.submit([this, &is_false, i](size_t) {
+                is_false[i] = __isPropertyEmpty(*properties_[i]);
+                if (!is_false[i]) __isPropertyValid(*properties_[i]);
+            });
         }
-        
-        // Sort indices in descending order to safely remove from properties_ vector
-        std::sort(all_false_indices.rbegin(), all_false_indices.rend());
-        
-        // Store false properties and remove them
-        for (size_t idx : all_false_indices) {
-            false_properties_strings_.push_back(properties_[idx]->toString());
-            false_properties_index_.push_back(idx);
-        }   
+        pool.wait();
+        __removeProperties(is_false);
+    }
+
+    void RefinementAnalyzer::__removeProperties(const std::vector<char>& is_false) {
+        if (property_positions_.size() != properties_.size()) {
+            property_positions_.resize(properties_.size());
+            std::iota(property_positions_.begin(), property_positions_.end(), 0);
+            positions_assigned_ = properties_.size();
+        }
+        // One stable pass: survivors move down, positions move with them
+        size_t kept = 0;
+        for (size_t i = 0; i < properties_.size(); ++i) {
+            if (is_false[i]) {
+                std::cerr << "Property " << properties_[i]->toString() << " is unsatisfiable and will be removed from analysis.\n";
+                false_properties_strings_.push_back(properties_[i]->toString());
+                false_properties_index_.push_back(property_positions_[i]);
+                continue;
+            }
+            properties_[kept] = std::move(properties_[i]);
+            property_positions_[kept] = property_positions_[i];
+            ++kept;
+        }
+        properties_.resize(kept);
+        property_positions_.resize(kept);
     }
 
 
@@ -588,15 +1251,23 @@ RefinementGraph RefinementAnalyzer::_analyzeClassTaskOptimized(const std::vector
             csv_file.open(csv_path, std::ios::app);
         } else {
             csv_file.open(csv_path);
-            // Write header
-            csv_file << "Input,Total_Properties,Equivalence_Classes,Total_Refinements,"
-                    << "Required_Properties,Properties_Removed,TransitiveEliminations,"
-                    << "Parsing_Time_ms,Equivalence_Time_ms,"
-                    << "Refinement_Time_ms,Total_Time_ms,"
-                    << "Total_Analysis_Memory_kB, Refinement_Memory_kB"
-                    << "\n";
+            writeCsvHeader(csv_file);
         }
-        
+        writeCsvRow(csv_file, input_name, result, total_time_ms);
+        csv_file.close();
+    }
+
+    void RefinementAnalyzer::writeCsvHeader(std::ostream& out) {
+        out << "Input,Total_Properties,Equivalence_Classes,Total_Refinements,"
+            << "Required_Properties,Properties_Removed,TransitiveEliminations,"
+            << "Parsing_Time_ms,Equivalence_Time_ms,"
+            << "Refinement_Time_ms,Total_Time_ms,"
+            << "Total_Analysis_Memory_kB, Refinement_Memory_kB"
+            << "\n";
+    }
+
+    void RefinementAnalyzer::writeCsvRow(std::ostream& csv_file, const std::string& input_name,
+                                         const AnalysisResult& result, long long total_time_ms) {
         int properties_removed = result.total_properties - result.required_properties;
         
         csv_file << input_name << ","
@@ -614,8 +1285,30 @@ RefinementGraph RefinementAnalyzer::_analyzeClassTaskOptimized(const std::vector
                 << result.total_analysis_memory_kb << ","
                 << result.refinement_memory_kb
                 << "\n";
+    }
 
-        csv_file.close();
+    void RefinementAnalyzer::writeJsonRow(std::ostream& out, const std::string& input_name,
+                                          const AnalysisResult& result, long long total_time_ms) {
+        std::string name;
+        for (char c : input_name) {
+            if (c == '"' || c == '\\') name += '\\';
+            name += c;
+        }
+        out << "{\"input\":\"" << name << "\""
+            << ",\"total_properties\":" << result.total_properties
+            << ",\"equivalence_classes\":" << result.equivalence_classes
+            << ",\"total_refinements\":" << result.total_refinements
+            << ",\"required_properties\":" << result.required_properties
+            << ",\"properties_removed\":" << (result.total_properties - result.required_properties)
+            << ",\"transitive_eliminations\":" << result.transitive_eliminated
+            << ",\"parsing_time_ms\":" << result.parsing_time.count()
+            << ",\"equivalence_time_ms\":" << result.equivalence_time.count()
+            << ",\"automaton_time_ms\":" << result.automaton_time.count()
+            << ",\"refinement_time_ms\":" << result.refinement_time.count()
+            << ",\"total_time_ms\":" << total_time_ms
+            << ",\"total_analysis_memory_kb\":" << result.total_analysis_memory_kb
+            << ",\"refinement_memory_kb\":" << result.refinement_memory_kb
+            << "}\n";
     }
 
 
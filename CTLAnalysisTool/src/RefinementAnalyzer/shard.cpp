@@ -0,0 +1,81 @@
+#include "Analyzers/Refinement.h"
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace ctl {
+
+void RefinementAnalyzer::setShard(size_t index, size_t count, size_t row_block) {
+    if (count == 0 || index >= count) {
+        throw std::invalid_argument("Shard index " + std::to_string(index) + " out of range for " +
+                                    std::to_string(count) + " shards");
+    }
+    shard_index_ = index;
+    shard_count_ = count;
+    shard_row_block_ = std::max<size_t>(row_block, 1);
+}
+
+std::vector<RefinementAnalyzer::ShardUnit> RefinementAnalyzer::__shardUnits(
+        const std::vector<std::vector<std::shared_ptr<CTLProperty>>>& classes) const {
+    // Estimated from the formulas alone with the default weights: which
+    // automata a worker has built and how it was calibrated differ between
+    // workers, and every worker must compute the same assignment
+    const CostModel model;
+    std::vector<ShardUnit> units;
+    std::vector<double> costs;
+    for (size_t c = 0; c < classes.size(); ++c) {
+        const size_t n = classes[c].size();
+        if (n < 2) continue;  // no pairs
+        std::vector<CostModel::Features> members;
+        members.reserve(n);
+        for (const auto& property : classes[c]) members.push_back(CostModel::features(*property, false));
+        std::vector<double> rows;
+        model.classCost(members, &rows);
+        const size_t block = n > shard_row_block_ ? shard_row_block_ : n;
+        for (size_t row = 0; row < n; row += block) {
+            units.push_back({c, row, std::min(row + block, n)});
+            costs.push_back(std::accumulate(rows.begin() + row, rows.begin() + units.back().row_end, 0.0));
+        }
+    }
+
+    // Costliest first onto the least loaded shard. Every worker computes the
+    // same assignment from the same classes, so no coordination is needed
+    std::vector<size_t> order(units.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&costs](size_t a, size_t b) { return costs[a] > costs[b]; });
+    std::vector<double> load(shard_count_, 0.0);
+    std::vector<ShardUnit> mine;
+    for (size_t u : order) {
+        const size_t shard = std::min_element(load.begin(), load.end()) - load.begin();
+        load[shard] += costs[u];
+        if (shard == shard_index_) mine.push_back(units[u]);
+    }
+    return mine;
+}
+
+void RefinementAnalyzer::__analyzeRowBlocks(const std::vector<std::vector<std::shared_ptr<CTLProperty>>>& classes,
+                                            const std::vector<ShardUnit>& blocks) {
+    if (blocks.empty()) return;
+    // Rows of one class may sit on several workers, so there is no closure to
+    // skip pairs with: every pair is checked and its verdict checkpointed
+    WorkStealingPool pool(use_parallel_analysis_ ? threads_ : 1);
+    for (const auto& block : blocks) {
+        const auto& class_properties = classes[block.class_index];
+        for (size_t i = block.row_begin; i < block.row_end; ++i) {
+            for (size_t j = 0; j < class_properties.size(); ++j) {
+                if (i == j) continue;
+                pool.submit([this, &class_properties, i, j](size_t) {
+                    PropertyResult result = checkRefinement(*class_properties[i], *class_properties[j]);
+                    result.property1_index = i;
+                    result.property2_index = j;
+                    __recordResult(result);
+                });
+            }
+        }
+    }
+    pool.wait();
+}
+
+} // namespace ctl
@@ -14,8 +14,7 @@ SATAnalyzer::SATAnalyzer(const std::vector<std::shared_ptr<CTLProperty>>& proper
 }
 
 SATAnalyzer::SATAnalyzer(const std::string& filename) {
-    auto property_strings = loadPropertiesFromFile(filename);
-    __initialize_properties(property_strings);
+    __initialize_properties_from_file(filename);
     //std::cout << "Loaded " << properties_.size() << " properties from file: " << filename << "\n";
 }
 
@@ -26,6 +25,31 @@ SATAnalyzer::~SATAnalyzer() {
 
 
 
+void SATAnalyzer::setResultStream(const std::string& filename) {
+    auto stream = std::make_unique<std::ofstream>(filename);
+    if (!stream->is_open()) {
+        throw std::runtime_error("Cannot open file for writing: " + filename);
+    }
+    *stream << "Index, Property, Time Taken (ms),Memory Used (KB),Verdict\n";
+    stream->flush();
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    result_stream_ = std::move(stream);
+}
+
+void SATAnalyzer::__writeResultRow(std::ostream& out, const PropertyResult& result) const {
+    //find property names
+    std::string property_name = "";
+    if(result.property1_index < input_properties_.size()) {
+        property_name = input_properties_[result.property1_index]->toString();
+    }
+
+    out << result.property1_index << ","
+        << "\"" << property_name << "\","
+        << result.time_taken.count() << ","
+        << result.memory_used_kb << ","
+        << SatVerdictToString(result.verdict) << "\n";
+}
+
 void SATAnalyzer::writeInfoPerProperty(const std::string& filename) const
 {
     std::ofstream file(filename);
@@ -33,20 +57,9 @@ void SATAnalyzer::writeInfoPerProperty(const std::string& filename) const
         throw std::runtime_error("Cannot open file for writing: " + filename);
     }
 
-    file << "Index, Property, Time Taken (ms),Memory Used (KB)\n";
+    file << "Index, Property, Time Taken (ms),Memory Used (KB),Verdict\n";
     for (const auto& result : result_per_property_) {
-
-        //find property names
-        std::string property_name = "";
-        if(result.property1_index < properties_.size()) {
-            property_name = properties_[result.property1_index]->toString();
-        }
-
-
-        file << result.property1_index << ","
-             << "\"" << property_name << "\","
-             << result.time_taken.count() << ","
-             << result.memory_used_kb << "\n";
+        __writeResultRow(file, result);
     }
 
     file.close();
@@ -1,8 +1,11 @@
 #include "Analyzers/SAT.h"
 #include "utils.h"
 #include "memory_tracker.h"
+#include "guard_sat_cache.h"
+#include "work_stealing_pool.h"
 #include <chrono>
 #include <thread>
+#include <unordered_map>
 namespace ctl {
 
 
@@ -10,22 +13,59 @@ namespace ctl {
     AnalysisResult SATAnalyzer::analyze() {
         auto start_time = std::chrono::high_resolution_clock::now();
         auto mem_initial = memory_utils::getCurrentMemoryUsage();
+        const size_t cache_hits_initial = GuardSatCache::instance().hits();
+        const size_t cache_misses_initial = GuardSatCache::instance().misses();
         AnalysisResult result;
-        result.total_properties = properties_.size();
+        result.duplicate_properties = __deduplicate_properties();
+        result.total_properties = input_properties_.size();
         result.false_properties = 0;
+
+        // Inputs each analyzed property stands for; results are reported per input
+        std::unordered_map<const CTLProperty*, size_t> analyzed_index;
+        for (size_t index = 0; index < properties_.size(); index++) analyzed_index[properties_[index].get()] = index;
+        std::vector<std::vector<size_t>> inputs_of(properties_.size());
+        for (size_t k = 0; k < input_representatives_.size(); k++) {
+            auto it = analyzed_index.find(input_representatives_[k].get());
+            if (it != analyzed_index.end()) inputs_of[it->second].push_back(k);
+        }
         auto parse_end = std::chrono::high_resolution_clock::now();
         result.parsing_time = std::chrono::duration_cast<std::chrono::milliseconds>(parse_end - start_time);
-        //create all the abtas before hand. If the abta is empty, we remove the property!
-        for (size_t index = 0; index < properties_.size(); index++) {
-            auto prop_result = checkSAT(*properties_[index]);
-            prop_result.property1_index = index;
-            if (!prop_result.passed) {
-                false_properties_strings_.push_back(properties_[index]->toString());
-                false_properties_index_.push_back(index);
-                result.false_properties++;
+        // Results are streamed out if requested, otherwise kept for writeInfoPerProperty
+        auto sink = [this, &result, &inputs_of](const PropertyResult& analyzed_result) {
+            std::lock_guard<std::mutex> lock(result_mutex_);
+            for (size_t k : inputs_of[analyzed_result.property1_index]) {
+                PropertyResult prop_result = analyzed_result;
+                prop_result.property1_index = k;
+                if (k != inputs_of[analyzed_result.property1_index].front()) {
+                    // Duplicates share the verdict without costing anything
+                    prop_result.time_taken = std::chrono::milliseconds(0);
+                    prop_result.memory_used_kb = 0;
+                }
+                if (prop_result.verdict == SatVerdict::UNSAT) {
+                    false_properties_strings_.push_back(input_properties_[k]->toString());
+                    false_properties_index_.push_back(k);
+                    result.false_properties++;
+                }
+                if (result_stream_) {
+                    __writeResultRow(*result_stream_, prop_result);
+                } else {
+                    result_per_property_.push_back(prop_result);
+                }
+            }
+            if (result_stream_) result_stream_->flush();
+        };
+        if (external_sat_interface_set_) {
+            // External backends get the whole property set as one batch
+            __checkSATBatch(sink);
+        } else if (use_parallel_analysis_ && threads_ > 1) {
+            __checkSATParallel(sink);
+        } else {
+            //create all the abtas before hand. If the abta is empty, we remove the property!
+            for (size_t index = 0; index < properties_.size(); index++) {
+                auto prop_result = checkSAT(*properties_[index]);
+                prop_result.property1_index = index;
+                sink(prop_result);
             }
-            
-            result_per_property_.push_back(prop_result);
         }
         auto end_time = std::chrono::high_resolution_clock::now();
         result.total_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
@@ -33,6 +73,8 @@ namespace ctl {
         result.total_analysis_memory_kb = (mem_final.resident_memory_kb > mem_initial.resident_memory_kb)
                                         ? (mem_final.resident_memory_kb - mem_initial.resident_memory_kb)
                                         : 0;
+        result.guard_cache_hits = GuardSatCache::instance().hits() - cache_hits_initial;
+        result.guard_cache_misses = GuardSatCache::instance().misses() - cache_misses_initial;
         return result;
 
     }
@@ -40,21 +82,71 @@ namespace ctl {
 
     PropertyResult SATAnalyzer::checkSAT(const CTLProperty& property) const {
         //std::cout << "Checking satisfiability for property: " << property.toString() << std::endl;
-        auto mem_before = memory_utils::getCurrentMemoryUsage();
+        // Heap growth of this thread only: concurrent checks do not blur it
+        memory_utils::AllocationScope allocations;
         auto start_time = std::chrono::high_resolution_clock::now();
         bool is_sat;
-        if (external_sat_interface_set_) {
-            is_sat = property.isSatisfiable(*external_sat_interface_);
+        SatVerdict verdict;
+        std::optional<bool> cached;
+        if (cache_) cached = cache_->lookupSatisfiable(__satisfiabilityCacheMode(), property.toString());
+        if (cached) {
+            is_sat = *cached;
+            verdict = is_sat ? SatVerdict::SAT : SatVerdict::UNSAT;
+        } else if (external_sat_interface_set_) {
+            verdict = external_sat_interface_->checkSatisfiable(property.toString());
+            is_sat = verdict == SatVerdict::SAT;
         } else {
-             is_sat = property.isSatisfiable();
+            is_sat = property.isSatisfiable();
+            verdict = is_sat ? SatVerdict::SAT : SatVerdict::UNSAT;
+        }
+        // Timeouts and solver failures are not verdicts worth remembering
+        const bool conclusive = verdict == SatVerdict::SAT || verdict == SatVerdict::UNSAT;
+        if (cache_ && !cached && conclusive) {
+            cache_->storeSatisfiable(__satisfiabilityCacheMode(), property.toString(), is_sat);
         }
         auto end_time = std::chrono::high_resolution_clock::now();
-        auto mem_after = memory_utils::getCurrentMemoryUsage();
-        size_t mem_delta = (mem_after.resident_memory_kb > mem_before.resident_memory_kb) 
-                          ? (mem_after.resident_memory_kb - mem_before.resident_memory_kb) 
-                          : 0;
+        const size_t mem_delta = allocations.retainedKB();
         return {is_sat, 
                 std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time),
-                0, 0, mem_delta};
+                0, 0, mem_delta, verdict};
+    }
+
+    void SATAnalyzer::__checkSATParallel(const ResultSink& sink) const {
+        WorkStealingPool pool(threads_);
+        for (size_t index = 0; index < properties_.size(); index++) {
+            pool.submit([this, index, &sink](size_t) {
+                auto prop_result = checkSAT(*properties_[index]);
+                prop_result.property1_index = index;
+                sink(prop_result);
+            });
+        }
+        pool.wait();
+    }
+
+    void SATAnalyzer::__checkSATBatch(const ResultSink& sink) const {
+        const std::string mode = __satisfiabilityCacheMode();
+        std::vector<size_t> submitted;
+        std::vector<std::string> queries;
+        for (size_t index = 0; index < properties_.size(); index++) {
+            const std::string formula = properties_[index]->toString();
+            if (cache_) {
+                if (auto cached = cache_->lookupSatisfiable(mode, formula)) {
+                    sink({*cached, std::chrono::milliseconds(0), index, 0, 0,
+                          *cached ? SatVerdict::SAT : SatVerdict::UNSAT});
+                    continue;
+                }
+            }
+            submitted.push_back(index);
+            queries.push_back(formula);
+        }
+        if (queries.empty()) return;
+
+        external_sat_interface_->checkMany(queries, [&](size_t k, SatVerdict verdict, std::chrono::milliseconds time) {
+            const bool is_sat = verdict == SatVerdict::SAT;
+            if (cache_ && (is_sat || verdict == SatVerdict::UNSAT)) {
+                cache_->storeSatisfiable(mode, queries[k], is_sat);
+            }
+            sink({is_sat, time, submitted[k], 0, 0, verdict});
+        });
     }
-}
\ No newline at end of file
+}
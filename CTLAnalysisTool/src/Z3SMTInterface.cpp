@@ -1,5 +1,11 @@
 #include "SMTInterfaces/Z3SMTInterface.h"
+#include "entailment_session.h"
 #include "formula_utils.h"
+#include "trace.h"
+#include "statistics.h"
+#include "log.h"
+#include "cancellation.h"
+#include <limits>
 #include <stdexcept>
 
 namespace ctl {
@@ -8,7 +14,8 @@ namespace ctl {
 
 Z3SMTInterface::Z3SMTInterface() 
     : ctx_(std::make_unique<z3::context>()),
-      solver_(std::make_unique<z3::solver>(*ctx_)) {
+      solver_(std::make_unique<z3::solver>(*ctx_)),
+      solver_pool_(std::make_unique<Z3SolverPool>(*ctx_)) {
 }
 
 // Destructor is defaulted in header, but for clarity:
@@ -38,14 +45,19 @@ std::string Z3SMTInterface::simplify(const std::string& formula) const {
 
 bool Z3SMTInterface::isSatisfiable(void* formula) const {
     if (formula == nullptr) return true; // empty formula is satisfiable
+    CTL_TRACE_SPAN("smt", "isSatisfiable");
+    SmtQueryScope query;
     Z3_ast expr = reinterpret_cast<Z3_ast>(formula);
-    std::cout << "Z3SMTInterface::isSatisfiable called with expr: " << z3::to_expr(*ctx_, expr) << "\n";
+    CTL_LOG(TRACE, false, "Z3SMTInterface::isSatisfiable called with expr: " << z3::to_expr(*ctx_, expr));
     try {
         solver_->push();
         solver_->add(z3::to_expr(*ctx_, expr));
-        bool result = (solver_->check() == z3::sat);
+        bool result = __checkSat();
         solver_->pop();
         return result;
+    } catch (const CheckCancelled&) {
+        solver_->pop();
+        throw;
     } catch (const std::exception& e) {
         try {
             solver_->pop();
@@ -59,6 +71,8 @@ bool Z3SMTInterface::isSatisfiable(void* formula) const {
 bool Z3SMTInterface::isSatisfiable(const std::unordered_set<std::string>& formulas, bool without_parsing) const {
     // Handle empty set
     if (formulas.empty()) return true;
+    CTL_TRACE_SPAN("smt", "isSatisfiable");
+    SmtQueryScope query;
     
     try {
         // Push a new scope to ensure we can clean up
@@ -87,13 +101,16 @@ bool Z3SMTInterface::isSatisfiable(const std::unordered_set<std::string>& formul
 
         //std::cout << "Z3SMTInterface: " << *solver_ << "\n";
         // Check satisfiability
-        bool result = (solver_->check() == z3::sat);
+        bool result = __checkSat();
 
         // Pop the scope to clean up
         solver_->pop();
         
         return result;
         
+    } catch (const CheckCancelled&) {
+        solver_->pop();
+        throw;
     } catch (const std::exception& e) {
         // Make sure to pop even on exception
         try {
@@ -106,8 +123,98 @@ bool Z3SMTInterface::isSatisfiable(const std::unordered_set<std::string>& formul
 }
 
 z3::expr Z3SMTInterface::parseToZ3Expression(const std::string& str) const {
-    // Use the existing formula_utils parser
-    return formula_utils::parseStringToZ3(str, *ctx_);
+    return getExpression(str);
+}
+
+const z3::expr& Z3SMTInterface::getExpression(const std::string& formula) const {
+    auto it = expr_cache_.find(formula);
+    if (it != expr_cache_.end()) {
+        return it->second;
+    }
+    // Lower from the formula AST instead of re-scanning the string on every query
+    z3::expr expr = formula_utils::guardToZ3(formula, *ctx_);
+    // A long-lived thread meets ever new guards
+    if (expr_cache_.size() >= kMaxCachedExpressions) expr_cache_.clear();
+    return expr_cache_.emplace(formula, expr).first->second;
+}
+
+bool Z3SMTInterface::__checkSat() const {
+    cancellation::checkpoint();
+    if (auto remaining = cancellation::remaining()) {
+        z3::params params(*ctx_);
+        params.set("timeout", static_cast<unsigned>(std::max<long long>(remaining->count(), 1)));
+        solver_->set(params);
+        deadline_set_ = true;
+    } else if (deadline_set_) {
+        z3::params params(*ctx_);
+        params.set("timeout", std::numeric_limits<unsigned>::max());
+        solver_->set(params);
+        deadline_set_ = false;
+    }
+    z3::check_result result = solver_->check();
+    // unknown from a timed-out query is the deadline, not an answer
+    if (result == z3::unknown && deadline_set_) {
+        const std::string reason = solver_->reason_unknown();
+        if (reason == "timeout" || reason == "canceled") throw CheckCancelled();
+    }
+    return result == z3::sat;
+}
+
+namespace {
+
+class Z3EntailmentSession : public EntailmentSession {
+public:
+    explicit Z3EntailmentSession(const Z3SMTInterface& smt)
+        : smt_(smt), ctx_(smt.getContext()), solver_(smt.solverPool().acquire()), indicators_(ctx_) {}
+
+    Literal assume(GuardTable::Id guard) override {
+        return __indicate(smt_.getExpression(GuardTable::instance().text(guard)));
+    }
+
+    Literal assumeNotAll(std::span<const GuardTable::Id> guards) override {
+        z3::expr_vector conjunction(ctx_);
+        for (GuardTable::Id guard : guards) {
+            conjunction.push_back(smt_.getExpression(GuardTable::instance().text(guard)));
+        }
+        return __indicate(!z3::mk_and(conjunction));
+    }
+
+    Verdict check(std::span<const Literal> assumptions, std::optional<unsigned> timeout_ms) override {
+        z3::expr_vector assumed(ctx_);
+        for (Literal literal : assumptions) assumed.push_back(indicators_[literal]);
+        if (timeout_ms || timed_) {
+            z3::params limit(ctx_);
+            limit.set("timeout", timeout_ms ? std::max(*timeout_ms, 1u) : std::numeric_limits<unsigned>::max());
+            solver_->set(limit);
+            timed_ = timeout_ms.has_value();
+        }
+        switch (solver_->check(assumed)) {
+            case z3::sat: return Verdict::SAT;
+            case z3::unsat: return Verdict::UNSAT;
+            default: return Verdict::UNKNOWN;
+        }
+    }
+
+private:
+    Literal __indicate(const z3::expr& condition) {
+        // Names only need to be unique per solver, and every session has its own
+        z3::expr indicator = ctx_.bool_const(("__ent" + std::to_string(indicators_.size())).c_str());
+        solver_->add(z3::implies(indicator, condition));
+        indicators_.push_back(indicator);
+        return static_cast<Literal>(indicators_.size() - 1);
+    }
+
+    const Z3SMTInterface& smt_;
+    z3::context& ctx_;
+    Z3SolverPool::Lease solver_;
+    z3::expr_vector indicators_;  // by literal
+    bool timed_ = false;          // solver_ carries a timeout from an earlier check
+};
+
+} // namespace
+
+std::unique_ptr<EntailmentSession> Z3SMTInterface::openEntailmentSession() const {
+    return std::make_unique<Z3EntailmentSession>(*this);
 }
 
 std::unique_ptr<SMTInterface> Z3SMTInterface::clone() const {
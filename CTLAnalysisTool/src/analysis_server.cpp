@@ -0,0 +1,296 @@
+#include "analysis_server.h"
+#include "statistics.h"
+#include "utils.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ctl {
+
+namespace {
+
+std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        const size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+        if (tab == std::string::npos) return fields;
+        start = tab + 1;
+    }
+}
+
+std::string quoted(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += c == '\n' ? "\\n" : c == '\t' ? "\\t" : " ";
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+std::string quotedList(const std::vector<std::string>& texts) {
+    std::string out = "[";
+    for (size_t i = 0; i < texts.size(); ++i) out += (i ? "," : "") + quoted(texts[i]);
+    return out + "]";
+}
+
+const char* boolean(bool value) { return value ? "true" : "false"; }
+
+// Closes a descriptor when it goes out of scope
+class Descriptor {
+public:
+    explicit Descriptor(int fd) : fd_(fd) {}
+    ~Descriptor() {
+        if (fd_ >= 0) close(fd_);
+    }
+    Descriptor(const Descriptor&) = delete;
+    Descriptor& operator=(const Descriptor&) = delete;
+    int get() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        // No SIGPIPE if the client went away; the connection is dropped instead
+        const ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+AnalysisServer::AnalysisServer(std::function<void(RefinementAnalyzer&)> configure, size_t query_capacity)
+    : configure_(std::move(configure)), query_capacity_(query_capacity) {}
+
+RefinementAnalyzer& AnalysisServer::__analyzer() {
+    if (!analyzer_) {
+        analyzer_ = std::make_unique<RefinementAnalyzer>(std::vector<std::string>{});
+        if (configure_) configure_(*analyzer_);
+    }
+    return *analyzer_;
+}
+
+const CTLProperty* AnalysisServer::__suiteMember(const std::string& canonical) const {
+    auto it = members_.find(canonical);
+    return it == members_.end() ? nullptr : it->second.get();
+}
+
+void AnalysisServer::__indexSuite() {
+    members_.clear();
+    if (!analyzer_) return;
+    for (const auto& property : analyzer_->getProperties()) members_.emplace(property->toString(), property);
+}
+
+void AnalysisServer::__forgetQuery(const std::string& canonical) {
+    auto it = queried_index_.find(canonical);
+    if (it == queried_index_.end()) return;
+    queried_.erase(it->second);
+    queried_index_.erase(it);
+}
+
+std::shared_ptr<CTLProperty> AnalysisServer::__property(const std::string& formula) {
+    auto property = CTLProperty::create(formula);
+    const std::string canonical = property->toString();
+    if (auto member = members_.find(canonical); member != members_.end()) return member->second;
+    if (auto known = queried_index_.find(canonical); known != queried_index_.end()) {
+        queried_.splice(queried_.begin(), queried_, known->second);
+        return known->second->second;
+    }
+    queried_.emplace_front(canonical, property);
+    queried_index_.emplace(canonical, queried_.begin());
+    return property;
+}
+
+void AnalysisServer::__trimQueries() {
+    while (queried_.size() > query_capacity_) {
+        if (analyzer_) analyzer_->forgetQuery(*queried_.back().second);
+        queried_index_.erase(queried_.back().first);
+        queried_.pop_back();
+    }
+}
+
+std::string AnalysisServer::__load(std::unique_ptr<RefinementAnalyzer> analyzer) {
+    if (configure_) configure_(*analyzer);
+    // The compositional parts and verdicts of earlier suites would otherwise
+    // stay for the life of the server
+    RefinementAnalyzer::clearGlobalCaches();
+    const AnalysisResult result = analyzer->analyze();
+    analyzer_ = std::move(analyzer);
+    queried_.clear();
+    queried_index_.clear();
+    __indexSuite();
+    return ",\"properties\":" + std::to_string(result.total_properties) +
+           ",\"classes\":" + std::to_string(result.equivalence_classes) +
+           ",\"refinements\":" + std::to_string(result.total_refinements) +
+           ",\"unsatisfiable\":" + std::to_string(result.false_properties);
+}
+
+std::string AnalysisServer::__insert(const std::string& formula) {
+    RefinementAnalyzer& analyzer = __analyzer();
+    auto property = __property(formula);
+    const std::string canonical = property->toString();
+    if (__suiteMember(canonical)) return ",\"duplicate_of\":" + quoted(canonical);
+    // Its automaton, if a query built it, moves into the suite with it
+    __forgetQuery(canonical);
+    analyzer.addProperties(std::vector<std::shared_ptr<CTLProperty>>{property});
+    analyzer.reanalyze();
+    __indexSuite();
+    if (!__suiteMember(canonical)) return ",\"satisfiable\":false";
+
+    // Class graphs are transitively closed, so the edges at the property are
+    // every member it refines or is refined by
+    std::vector<std::string> refines, refined_by, equivalent;
+    for (const auto& graph : analyzer.getRefinementGraphs()) {
+        const auto& nodes = graph.getNodes();
+        for (size_t k = 0; k < nodes.size(); ++k) {
+            if (nodes[k].get() != property.get()) continue;
+            for (size_t other = 0; other < nodes.size(); ++other) {
+                if (other == k) continue;
+                const bool down = graph.hasEdge(k, other), up = graph.hasEdge(other, k);
+                if (down && up) equivalent.push_back(nodes[other]->toString());
+                else if (down) refines.push_back(nodes[other]->toString());
+                else if (up) refined_by.push_back(nodes[other]->toString());
+            }
+            return ",\"satisfiable\":true,\"class_size\":" + std::to_string(nodes.size()) +
+                   ",\"refines\":" + quotedList(refines) + ",\"refined_by\":" + quotedList(refined_by) +
+                   ",\"equivalent\":" + quotedList(equivalent);
+        }
+    }
+    return ",\"satisfiable\":true,\"class_size\":1,\"refines\":[],\"refined_by\":[],\"equivalent\":[]";
+}
+
+std::string AnalysisServer::__stats() const {
+    std::string out = ",\"properties\":" + std::to_string(analyzer_ ? analyzer_->getProperties().size() : 0) +
+                      ",\"classes\":" + std::to_string(analyzer_ ? analyzer_->getEquivalenceClasses().size() : 0) +
+                      ",\"queried\":" + std::to_string(queried_.size());
+    const StatisticValues values = Statistics::instance().snapshot();
+    for (size_t i = 0; i < kStatisticCount; ++i) {
+        out += ",\"" + std::string(StatisticToString(static_cast<Statistic>(i))) + "\":" + std::to_string(values[i]);
+    }
+    return out;
+}
+
+std::string AnalysisServer::handle(const std::string& request) {
+    const auto start = std::chrono::steady_clock::now();
+    auto micros = [&start] {
+        return ",\"micros\":" + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                   std::chrono::steady_clock::now() - start).count());
+    };
+    const std::vector<std::string> fields = splitFields(request);
+    const std::string& command = fields[0];
+    auto expectArguments = [&](size_t count) {
+        if (fields.size() != count + 1) {
+            throw std::invalid_argument(command + " takes " + std::to_string(count) + " tab-separated argument(s)");
+        }
+    };
+
+    std::string body;  // the fields after "ok", each with its leading comma
+    try {
+        if (command == "load") {
+            expectArguments(1);
+            if (!pathExists(fields[1])) throw std::runtime_error("No such file: " + fields[1]);
+            body = __load(std::make_unique<RefinementAnalyzer>(fields[1]));
+        } else if (command == "suite") {
+            body = __load(std::make_unique<RefinementAnalyzer>(std::vector<std::string>(fields.begin() + 1, fields.end())));
+        } else if (command == "sat") {
+            expectArguments(1);
+            auto property = __property(fields[1]);
+            body = std::string(",\"satisfiable\":") + boolean(__analyzer().isSatisfiable(*property));
+        } else if (command == "refines") {
+            expectArguments(2);
+            auto refining = __property(fields[1]);
+            auto refined = __property(fields[2]);
+            const PropertyResult result = __analyzer().checkPair(*refining, *refined);
+            body = std::string(",\"refines\":") + boolean(result.passed);
+            if (result.verdict == SatVerdict::TIMEOUT) body += ",\"timeout\":true";
+        } else if (command == "insert") {
+            expectArguments(1);
+            body = __insert(fields[1]);
+        } else if (command == "remove") {
+            expectArguments(1);
+            const bool removed = __analyzer().removeProperty(fields[1]);
+            if (removed) {
+                __analyzer().reanalyze();
+                __indexSuite();
+            }
+            body = std::string(",\"removed\":") + boolean(removed);
+        } else if (command == "stats") {
+            expectArguments(0);
+            body = __stats();
+        } else if (command == "shutdown") {
+            stopping_.store(true);
+        } else {
+            throw std::invalid_argument("Unknown request: " + command);
+        }
+    } catch (const std::exception& e) {
+        __trimQueries();
+        return "{\"ok\":false,\"error\":" + quoted(e.what()) + micros() + "}";
+    }
+    __trimQueries();
+    return "{\"ok\":true" + body + micros() + "}";
+}
+
+void AnalysisServer::serve(const std::string& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + socket_path);
+    }
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    Descriptor listener(socket(AF_UNIX, SOCK_STREAM, 0));
+    if (listener.get() < 0) throw std::runtime_error("Cannot create socket: " + std::string(std::strerror(errno)));
+    unlink(socket_path.c_str());  // a socket left by an earlier server
+    if (bind(listener.get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener.get(), 16) != 0) {
+        throw std::runtime_error("Cannot listen on " + socket_path + ": " + std::strerror(errno));
+    }
+
+    stopping_.store(false);
+    while (!stopping_.load()) {
+        Descriptor client(accept(listener.get(), nullptr, nullptr));
+        if (client.get() < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        std::string buffer;
+        char chunk[4096];
+        bool connected = true;
+        while (connected && !stopping_.load()) {
+            size_t newline;
+            while (connected && !stopping_.load() && (newline = buffer.find('\n')) != std::string::npos) {
+                std::string line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty()) continue;
+                connected = sendAll(client.get(), handle(line) + "\n");
+            }
+            if (!connected || stopping_.load()) break;
+            const ssize_t n = read(client.get(), chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+    }
+    unlink(socket_path.c_str());
+}
+
+} // namespace ctl
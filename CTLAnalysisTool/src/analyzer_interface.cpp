@@ -0,0 +1,149 @@
+#include "analyzerInterface.h"
+#include "formula_utils.h"
+#include "utils.h"
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace ctl {
+
+namespace {
+
+// Canonical form under which syntactically different spellings coincide
+CTLFormulaPtr normalizedKey(const CTLFormula& formula) {
+    try {
+        auto nnf = formula_utils::toNNF(formula);
+        return CTLFormulaPtr(formula_utils::normalizeToCore(*nnf));
+    } catch (const std::exception&) {
+        // Operators without an NNF rule are compared as written
+        return formula.clone();
+    }
+}
+
+} // namespace
+
+void Analyzer::__initialize_properties(const std::vector<std::string>& property_strings) {
+    __parse_properties(std::vector<std::string_view>(property_strings.begin(), property_strings.end()));
+}
+
+void Analyzer::__initialize_properties_from_file(const std::string& filename) {
+    MappedFile file(filename);
+    __parse_properties(splitPropertyLines(file.contents()));
+}
+
+void Analyzer::__parse_properties(const std::vector<std::string_view>& texts) {
+    std::vector<std::shared_ptr<CTLProperty>> parsed(texts.size());
+    std::vector<std::string> errors(texts.size());
+    auto parseRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            try {
+                parsed[i] = CTLProperty::create(std::string(texts[i]), verbose_);
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        }
+    };
+
+    // Small inputs are not worth the pool start-up
+    constexpr size_t kMinPropertiesPerTask = 64;
+    const size_t tasks = std::min(std::max<size_t>(threads_, 1) * 4, texts.size() / kMinPropertiesPerTask);
+    if (tasks <= 1) {
+        parseRange(0, texts.size());
+    } else {
+        WorkStealingPool pool(std::min(std::max<size_t>(threads_, 1), tasks));
+        for (size_t t = 0; t < tasks; ++t) {
+            pool.submit([&, t](size_t) { parseRange(texts.size() * t / tasks, texts.size() * (t + 1) / tasks); });
+        }
+        pool.wait();
+    }
+
+    properties_.reserve(properties_.size() + texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        if (parsed[i]) {
+            properties_.push_back(std::move(parsed[i]));
+        } else {
+            std::cerr << "Warning: Failed to parse property '" << texts[i]
+                      << "': " << errors[i] << std::endl;
+        }
+    }
+}
+
+size_t Analyzer::__deduplicate_properties() {
+    if (!input_properties_.empty()) return 0;
+    input_properties_ = properties_;
+    if (!deduplicate_) {
+        input_representatives_ = properties_;
+        return 0;
+    }
+
+    struct Entry {
+        CTLFormulaPtr key;
+        size_t group;
+    };
+    std::unordered_map<size_t, std::vector<Entry>> buckets;
+    // The shortest spelling of a group, ties broken by text, stands for it
+    // whatever the input order, so the analysis does not depend on line order
+    std::vector<std::shared_ptr<CTLProperty>> kept;
+    std::vector<std::string> kept_text;
+    std::vector<size_t> group_of;
+    group_of.reserve(properties_.size());
+
+    for (const auto& property : properties_) {
+        CTLFormulaPtr key = normalizedKey(property->getFormula());
+        auto& bucket = buckets[key->hash()];
+        auto it = std::find_if(bucket.begin(), bucket.end(),
+                               [&key](const Entry& e) { return e.key->equals(*key); });
+        std::string text = property->toString();
+        if (it != bucket.end()) {
+            group_of.push_back(it->group);
+            std::string& best = kept_text[it->group];
+            if (text.size() < best.size() || (text.size() == best.size() && text < best)) {
+                kept[it->group] = property;
+                best = std::move(text);
+            }
+            continue;
+        }
+        bucket.push_back({std::move(key), kept.size()});
+        group_of.push_back(kept.size());
+        kept.push_back(property);
+        kept_text.push_back(std::move(text));
+    }
+    input_representatives_.reserve(properties_.size());
+    for (size_t group : group_of) input_representatives_.push_back(kept[group]);
+
+    const size_t merged = properties_.size() - kept.size();
+    if (merged > 0) {
+        std::cout << "Merged " << merged << " duplicate properties, " << kept.size()
+                  << " distinct properties remain.\n";
+    }
+    properties_ = std::move(kept);
+    return merged;
+}
+
+size_t Analyzer::__inputIndex(const CTLProperty* property) const {
+    for (size_t k = 0; k < input_properties_.size(); ++k) {
+        if (input_properties_[k].get() == property) return k;
+    }
+    return static_cast<size_t>(-1);
+}
+
+void Analyzer::writeDuplicateProperties(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file for writing: " + filename);
+    }
+
+    file << "Index,Property,Representative Index\n";
+    for (size_t k = 0; k < input_properties_.size(); ++k) {
+        const size_t representative = k < input_representatives_.size()
+            ? __inputIndex(input_representatives_[k].get())
+            : k;
+        file << k << ",\"" << input_properties_[k]->toString() << "\"," << representative << "\n";
+    }
+}
+
+} // namespace ctl
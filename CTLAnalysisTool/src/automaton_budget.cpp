@@ -0,0 +1,62 @@
+#include "automaton_budget.h"
+#include "property.h"
+
+#include <vector>
+
+namespace ctl {
+
+AutomatonBudget& AutomatonBudget::instance() {
+    static AutomatonBudget budget;
+    return budget;
+}
+
+void AutomatonBudget::admit(const CTLProperty* property, size_t bytes) {
+    std::vector<const CTLProperty*> victims;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(property);
+        if (it != index_.end()) {
+            resident_ -= it->second->bytes;
+            lru_.erase(it->second);
+        }
+        lru_.push_front({property, bytes});
+        index_[property] = lru_.begin();
+        resident_ += bytes;
+
+        const size_t limit = this->limit();
+        while (limit != 0 && resident_ > limit && lru_.size() > 1) {
+            const Entry& victim = lru_.back();
+            resident_ -= victim.bytes;
+            index_.erase(victim.property);
+            victims.push_back(victim.property);
+            lru_.pop_back();
+        }
+    }
+    // Outside the lock: freeing a large automaton takes a while
+    for (const CTLProperty* victim : victims) {
+        victim->releaseAutomaton();
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AutomatonBudget::touch(const CTLProperty* property) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(property);
+    if (it != index_.end()) lru_.splice(lru_.begin(), lru_, it->second);
+}
+
+void AutomatonBudget::forget(const CTLProperty* property) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(property);
+    if (it == index_.end()) return;
+    resident_ -= it->second->bytes;
+    lru_.erase(it->second);
+    index_.erase(it);
+}
+
+size_t AutomatonBudget::residentBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return resident_;
+}
+
+} // namespace ctl
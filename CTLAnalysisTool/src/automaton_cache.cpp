@@ -0,0 +1,335 @@
+#include "automaton_cache.h"
+#include "CTLautomaton.h"
+#include "statistics.h"
+#include "utils.h"
+#include "log.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+namespace ctl {
+
+namespace {
+
+// "CTLABTA" and a format version; integers are stored in host byte order
+constexpr char kMagic[8] = {'C', 'T', 'L', 'A', 'B', 'T', 'A', '1'};
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putString(std::string& out, const std::string& s) {
+    put<uint32_t>(out, static_cast<uint32_t>(s.size()));
+    out += s;
+}
+
+// Bounds-checked reads over a mapped file; any overrun marks it invalid
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data_(data) {}
+    template <typename T>
+    T get() {
+        T value{};
+        if (!ok_ || data_.size() - pos_ < sizeof(T)) {
+            ok_ = false;
+            return value;
+        }
+        std::memcpy(&value, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+    std::string_view string() {
+        const uint32_t size = get<uint32_t>();
+        if (!ok_ || data_.size() - pos_ < size) {
+            ok_ = false;
+            return {};
+        }
+        std::string_view value = data_.substr(pos_, size);
+        pos_ += size;
+        return value;
+    }
+    // An index below bound, invalid otherwise
+    uint32_t index(size_t bound) {
+        const uint32_t i = get<uint32_t>();
+        if (i >= bound) ok_ = false;
+        return ok_ ? i : 0;
+    }
+    // A count of elements of at least the given size, invalid if the data cannot hold them
+    uint32_t count(size_t element_size) {
+        const uint32_t n = get<uint32_t>();
+        if (ok_ && n > (data_.size() - pos_) / element_size) ok_ = false;
+        return ok_ ? n : 0;
+    }
+    bool ok() const { return ok_; }
+    bool done() const { return pos_ == data_.size(); }
+
+private:
+    std::string_view data_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+// Guard texts of a file, each stored once
+class GuardIndex {
+public:
+    uint32_t operator()(GuardTable::Id id) {
+        auto [it, inserted] = index_.try_emplace(id, static_cast<uint32_t>(texts_.size()));
+        if (inserted) texts_.push_back(GuardTable::instance().text(id));
+        return it->second;
+    }
+    const std::vector<std::string>& texts() const { return texts_; }
+
+private:
+    std::unordered_map<GuardTable::Id, uint32_t> index_;
+    std::vector<std::string> texts_;
+};
+
+// States whose moves are expanded; a state without moves counts as unexpanded
+size_t expandedStates(const std::vector<std::vector<Move>>& moves) {
+    size_t states = 0;
+    for (const auto& m : moves) states += !m.empty();
+    return states;
+}
+
+} // namespace
+
+AutomatonCache& AutomatonCache::instance() {
+    static AutomatonCache cache;
+    return cache;
+}
+
+void AutomatonCache::setDirectory(std::string directory) {
+    if (!directory.empty() && !isDirectory(directory) && !createDirectory(directory)) {
+        throw std::runtime_error("Cannot create automaton cache directory: " + directory);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    directory_ = std::move(directory);
+    saved_moves_.clear();
+}
+
+bool AutomatonCache::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !directory_.empty();
+}
+
+std::string AutomatonCache::__path(size_t formula_hash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016" PRIx64 ".abta", static_cast<uint64_t>(formula_hash));
+    std::lock_guard<std::mutex> lock(mutex_);
+    return joinPaths(directory_, name);
+}
+
+std::shared_ptr<CTLAutomaton> AutomatonCache::obtain(const CTLFormula& formula, bool verbose) {
+    if (!enabled()) return std::make_shared<CTLAutomaton>(formula, verbose);
+    if (auto loaded = load(formula, verbose)) return loaded;
+    auto built = std::make_shared<CTLAutomaton>(formula, verbose);
+    save(*built);
+    return built;
+}
+
+// Layout: magic, formula hash and text, guard texts, closure size, owners of
+// helper states, initial state, accepting bits, transitions by state (guard,
+// is_dnf, clauses of (dir, state) literals), then the moves of some states
+std::shared_ptr<CTLAutomaton> AutomatonCache::load(const CTLFormula& formula, bool verbose) {
+    auto automaton = std::make_shared<CTLAutomaton>();
+    automaton->setVerbose(verbose);
+    automaton->__setFormula(formula);
+    const CTLFormula& canonical = *automaton->p_original_formula_;
+    const std::string path = __path(canonical.hash());
+    if (!pathExists(path)) return nullptr;
+
+    std::unique_ptr<MappedFile> file;
+    try {
+        file = std::make_unique<MappedFile>(path);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+    Reader in(file->contents());
+    char magic[sizeof(kMagic)];
+    for (char& c : magic) c = in.get<char>();
+    if (!in.ok() || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) return nullptr;
+    if (in.get<uint64_t>() != canonical.hash() || in.string() != canonical.toString()) return nullptr;
+
+    std::vector<Guard> guards(in.count(sizeof(uint32_t)));
+    for (auto& guard : guards) guard = Guard(std::string(in.string()));
+
+    automaton->__createStates();
+    auto& states = automaton->v_states_;
+    if (in.get<uint32_t>() != states.size()) return nullptr;
+    const size_t closure = states.size();
+    const uint32_t helpers = in.count(sizeof(uint32_t));
+    for (uint32_t h = 0; h < helpers && in.ok(); ++h) {
+        const CTLStatePtr owner = states[in.index(closure)];
+        const auto* temporal = dynamic_cast<const TemporalFormula*>(owner->formula.get());
+        if (!in.ok() || !temporal || temporal->operator_ != TemporalOperator::AR) return nullptr;
+        automaton->__addReleaseHelpers(owner);
+    }
+    const size_t n = states.size();
+    automaton->initial_state_ = states[in.index(n)]->name;
+
+    automaton->s_accepting_states_.clear();
+    for (size_t w = 0; w < (n + 63) / 64; ++w) {
+        const uint64_t bits = in.get<uint64_t>();
+        for (size_t i = w * 64; i < std::min(n, w * 64 + 64); ++i) {
+            if ((bits >> (i & 63)) & 1u) automaton->s_accepting_states_.insert(states[i]->name);
+        }
+    }
+
+    std::vector<Clause> clauses;
+    for (size_t from = 0; from < n && in.ok(); ++from) {
+        const uint32_t transitions = in.count(2 * sizeof(uint32_t));
+        for (uint32_t t = 0; t < transitions && in.ok(); ++t) {
+            const Guard& guard = guards[in.index(guards.size())];
+            const bool is_dnf = in.get<uint8_t>() != 0;
+            clauses.assign(in.count(sizeof(uint32_t)), {});
+            for (auto& clause : clauses) {
+                clause.literals.resize(in.count(2 * sizeof(uint32_t)));
+                for (auto& literal : clause.literals) {
+                    literal.dir = in.get<int32_t>();
+                    literal.qid = in.index(n);
+                    literal.qnext = states[literal.qid]->name;
+                }
+            }
+            if (!in.ok()) return nullptr;
+            // The guard was checked when the automaton was built
+            automaton->__addTransition(states[from]->name, guard, clauses, is_dnf);
+        }
+    }
+    if (!in.ok()) return nullptr;
+    automaton->__finishBuild();
+
+    const uint32_t expanded = in.count(2 * sizeof(uint32_t));
+    for (uint32_t e = 0; e < expanded && in.ok(); ++e) {
+        const StateId state = in.index(n);
+        std::vector<Move> moves(in.count(2 * sizeof(uint32_t)));
+        for (auto& move : moves) {
+            const uint32_t atoms = in.count(sizeof(uint32_t));
+            for (uint32_t a = 0; a < atoms; ++a) move.addAtom(guards[in.index(guards.size())].id);
+            const uint32_t next_states = in.count(2 * sizeof(uint32_t));
+            for (uint32_t s = 0; s < next_states; ++s) {
+                const int32_t dir = in.get<int32_t>();
+                move.addNextState(dir, in.index(n));
+            }
+        }
+        if (!in.ok()) return nullptr;
+        std::call_once(automaton->expanded_once_[state], [&] { automaton->expanded_moves_[state] = std::move(moves); });
+    }
+    if (!in.ok() || !in.done()) return nullptr;
+
+    Statistics::instance().add(Statistic::AUTOMATA_LOADED);
+    std::lock_guard<std::mutex> lock(mutex_);
+    saved_moves_[automaton.get()] = expanded;
+    return automaton;
+}
+
+void AutomatonCache::save(const CTLAutomaton& automaton) {
+    try {
+        __write(automaton);
+    } catch (const std::exception& e) {
+        // A cache that cannot be written only costs the next run a rebuild
+        CTL_LOG_WARN("Warning: " << e.what());
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    saved_moves_[&automaton] = expandedStates(automaton.expanded_moves_);
+}
+
+void AutomatonCache::update(const CTLAutomaton& automaton) {
+    if (automaton.complement_) update(*automaton.complement_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = saved_moves_.find(&automaton);
+        if (it == saved_moves_.end()) return;
+        const size_t saved = it->second;
+        saved_moves_.erase(it);
+        if (expandedStates(automaton.expanded_moves_) <= saved) return;
+    }
+    try {
+        __write(automaton);
+    } catch (const std::exception& e) {
+        CTL_LOG_WARN("Warning: " << e.what());
+    }
+}
+
+void AutomatonCache::__write(const CTLAutomaton& automaton) const {
+    const CTLFormula& canonical = *automaton.p_original_formula_;
+    const auto& states = automaton.v_states_;
+    const size_t n = states.size();
+    GuardIndex guards;
+    std::string body;
+
+    // Helper states come in (q_ax, q_or) pairs after the closure states
+    size_t closure = n;
+    while (closure > 0 && states[closure - 1]->name.ends_with("_or")) closure -= 2;
+    put<uint32_t>(body, static_cast<uint32_t>(closure));
+    put<uint32_t>(body, static_cast<uint32_t>((n - closure) / 2));
+    for (size_t h = closure; h < n; h += 2) {
+        const std::string& name = states[h]->name;
+        put<uint32_t>(body, automaton.getStateId(std::string_view(name).substr(0, name.size() - 3)));
+    }
+    put<uint32_t>(body, automaton.getInitialStateId());
+    for (uint64_t bits : automaton.accepting_bits_) put(body, bits);
+
+    for (StateId from = 0; from < n; ++from) {
+        const auto transitions = automaton.getTransitions(from);
+        put<uint32_t>(body, static_cast<uint32_t>(transitions.size()));
+        for (const CTLTransition* t : transitions) {
+            put<uint32_t>(body, guards(t->guard.id));
+            put<uint8_t>(body, t->is_dnf);
+            put<uint32_t>(body, static_cast<uint32_t>(t->clauses.size()));
+            for (const auto& clause : t->clauses) {
+                put<uint32_t>(body, static_cast<uint32_t>(clause.literals.size()));
+                for (const auto& literal : clause.literals) {
+                    put<int32_t>(body, literal.dir);
+                    put<uint32_t>(body, literal.qid);
+                }
+            }
+        }
+    }
+
+    const auto& expanded = automaton.expanded_moves_;
+    put<uint32_t>(body, static_cast<uint32_t>(expandedStates(expanded)));
+    for (StateId state = 0; state < expanded.size(); ++state) {
+        if (expanded[state].empty()) continue;
+        put<uint32_t>(body, state);
+        put<uint32_t>(body, static_cast<uint32_t>(expanded[state].size()));
+        for (const auto& move : expanded[state]) {
+            put<uint32_t>(body, static_cast<uint32_t>(move.atoms.size()));
+            for (GuardTable::Id atom : move.atoms) put<uint32_t>(body, guards(atom));
+            put<uint32_t>(body, static_cast<uint32_t>(move.next_states.size()));
+            for (const auto& succ : move.next_states) {
+                put<int32_t>(body, succ.dir);
+                put<uint32_t>(body, succ.state);
+            }
+        }
+    }
+
+    std::string data(kMagic, sizeof(kMagic));
+    put<uint64_t>(data, canonical.hash());
+    putString(data, canonical.toString());
+    put<uint32_t>(data, static_cast<uint32_t>(guards.texts().size()));
+    for (const auto& text : guards.texts()) putString(data, text);
+    data += body;
+
+    // A private temporary name, as other threads and runs may write the same file
+    const std::string path = __path(canonical.hash());
+    const std::string temporary = path + ".tmp." + std::to_string(getpid()) + "." +
+                                  std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out) throw std::runtime_error("Cannot write automaton cache file: " + temporary);
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot replace automaton cache file: " + path);
+    }
+}
+
+} // namespace ctl
@@ -0,0 +1,68 @@
+#include "bdd.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ctl {
+
+namespace {
+    constexpr uint32_t TERMINAL_LEVEL = std::numeric_limits<uint32_t>::max();
+}
+
+BddManager::BddManager() {
+    nodes_.push_back({TERMINAL_LEVEL, FALSE_NODE, FALSE_NODE});
+    nodes_.push_back({TERMINAL_LEVEL, TRUE_NODE, TRUE_NODE});
+}
+
+BddManager::Node BddManager::variable(const std::string& atom) {
+    auto [it, inserted] = order_.emplace(atom, static_cast<uint32_t>(order_.size()));
+    return __make(it->second, FALSE_NODE, TRUE_NODE);
+}
+
+BddManager::Node BddManager::negate(Node a) { return __apply(Op::NOT, a, FALSE_NODE); }
+BddManager::Node BddManager::conj(Node a, Node b) { return __apply(Op::AND, a, b); }
+BddManager::Node BddManager::disj(Node a, Node b) { return __apply(Op::OR, a, b); }
+
+BddManager::Node BddManager::__make(uint32_t level, Node low, Node high) {
+    if (low == high) return low;
+    auto [it, inserted] = unique_.emplace(BddNode{level, low, high}, static_cast<Node>(nodes_.size()));
+    if (inserted) nodes_.push_back(it->first);
+    return it->second;
+}
+
+BddManager::Node BddManager::__apply(Op op, Node a, Node b) {
+    switch (op) {
+        case Op::NOT:
+            if (a <= TRUE_NODE) return a ^ 1;
+            break;
+        case Op::AND:
+            if (a == FALSE_NODE || b == FALSE_NODE) return FALSE_NODE;
+            if (a == TRUE_NODE) return b;
+            if (b == TRUE_NODE || a == b) return a;
+            if (a > b) std::swap(a, b);
+            break;
+        case Op::OR:
+            if (a == TRUE_NODE || b == TRUE_NODE) return TRUE_NODE;
+            if (a == FALSE_NODE) return b;
+            if (b == FALSE_NODE || a == b) return a;
+            if (a > b) std::swap(a, b);
+            break;
+    }
+
+    auto& cache = computed_[static_cast<int>(op)];
+    const uint64_t key = __pack(a, b);
+    if (auto it = cache.find(key); it != cache.end()) return it->second;
+
+    const BddNode na = nodes_[a];
+    const BddNode nb = nodes_[b];
+    const uint32_t level = std::min(na.level, nb.level);
+    const Node a0 = na.level == level ? na.low : a, a1 = na.level == level ? na.high : a;
+    const Node b0 = nb.level == level ? nb.low : b, b1 = nb.level == level ? nb.high : b;
+    const Node low = __apply(op, a0, b0);
+    const Node high = __apply(op, a1, b1);
+    const Node result = __make(level, low, high);
+    cache.emplace(key, result);
+    return result;
+}
+
+} // namespace ctl
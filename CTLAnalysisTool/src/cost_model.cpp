@@ -0,0 +1,225 @@
+#include "cost_model.h"
+#include "CTLautomaton.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace ctl {
+
+namespace {
+
+constexpr const char* kFeatureNames[CostModel::kFeatures] = {"size", "states", "moves", "least", "greatest", "next"};
+
+// Rough shares of the check time: the product grows with both automata and
+// each least fixpoint adds a round of the emptiness iteration
+constexpr double kDefaultSideWeights[CostModel::kFeatures] = {0.5, 0.5, 0.5, 0.3, 0.1, 0.05};
+
+// Ridge penalty per sample, keeps the fit stable when features move together
+constexpr double kRidge = 1e-3;
+
+} // namespace
+
+CostModel::CostModel() {
+    weights_[0] = 0.0;
+    for (size_t k = 0; k < kFeatures; ++k) {
+        weights_[1 + k] = kDefaultSideWeights[k];
+        weights_[1 + kFeatures + k] = kDefaultSideWeights[k];
+    }
+}
+
+CostModel::Features CostModel::features(const CTLProperty& property, bool from_automaton) {
+    Features features;
+    features.size = static_cast<double>(property.size());
+    for (const auto& node : property.flat().nodes()) {
+        if (node.type != FormulaType::TEMPORAL) continue;
+        switch (node.temporalOp()) {
+            case TemporalOperator::EF: case TemporalOperator::AF:
+            case TemporalOperator::EU: case TemporalOperator::AU:
+                ++features.least;
+                break;
+            case TemporalOperator::EX: case TemporalOperator::AX:
+                ++features.next;
+                break;
+            default:
+                ++features.greatest;
+                break;
+        }
+    }
+
+    auto automaton = from_automaton ? property.builtAutomaton() : nullptr;
+    if (!automaton) {
+        // One state per closure formula, each with at least one move
+        features.states = features.size;
+        features.moves = features.size;
+        return features;
+    }
+    features.states = static_cast<double>(automaton->numStates());
+    for (StateId id = 0; id < automaton->numStates(); ++id) {
+        for (const auto& transition : automaton->getTransitions(id)) {
+            features.moves += static_cast<double>(transition->clauses.size());
+        }
+    }
+    return features;
+}
+
+std::array<double, CostModel::kFeatures> CostModel::__terms(const Features& features) {
+    return {std::log1p(features.size), std::log1p(features.states), std::log1p(features.moves),
+            features.least, features.greatest, features.next};
+}
+
+CostModel::Row CostModel::__row(const Features& refining, const Features& refined) {
+    Row row;
+    row[0] = 1.0;
+    const auto left = __terms(refining);
+    const auto right = __terms(refined);
+    for (size_t k = 0; k < kFeatures; ++k) {
+        row[1 + k] = left[k];
+        row[1 + kFeatures + k] = right[k];
+    }
+    return row;
+}
+
+double CostModel::refiningFactor(const Features& refining) const {
+    const auto terms = __terms(refining);
+    double exponent = weights_[0];
+    for (size_t k = 0; k < kFeatures; ++k) exponent += weights_[1 + k] * terms[k];
+    return std::exp(exponent);
+}
+
+double CostModel::refinedFactor(const Features& refined) const {
+    const auto terms = __terms(refined);
+    double exponent = 0.0;
+    for (size_t k = 0; k < kFeatures; ++k) exponent += weights_[1 + kFeatures + k] * terms[k];
+    return std::exp(exponent);
+}
+
+double CostModel::estimate(const Features& refining, const Features& refined) const {
+    return refiningFactor(refining) * refinedFactor(refined);
+}
+
+double CostModel::classCost(const std::vector<Features>& members, std::vector<double>* row_costs) const {
+    // sum over i != j of A_i B_j = (sum A)(sum B) - sum A_i B_i
+    std::vector<double> refining(members.size());
+    std::vector<double> refined(members.size());
+    double refined_total = 0.0;
+    for (size_t i = 0; i < members.size(); ++i) {
+        refining[i] = refiningFactor(members[i]);
+        refined[i] = refinedFactor(members[i]);
+        refined_total += refined[i];
+    }
+    if (row_costs) row_costs->assign(members.size(), 0.0);
+    double total = 0.0;
+    for (size_t i = 0; i < members.size(); ++i) {
+        const double row = refining[i] * (refined_total - refined[i]);
+        if (row_costs) (*row_costs)[i] = row;
+        total += row;
+    }
+    return total;
+}
+
+size_t CostModel::calibrate(const std::string& samples_path) {
+    std::ifstream in(samples_path);
+    if (!in) return 0;
+
+    // Normal equations of the ridge regression, accumulated line by line
+    std::array<std::array<double, kWeights>, kWeights> gram{};
+    std::array<double, kWeights> moment{};
+    size_t used = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::array<double, 2 * kFeatures + 1> values;
+        std::istringstream fields(line);
+        std::string field;
+        size_t count = 0;
+        bool valid = true;
+        while (valid && std::getline(fields, field, ',')) {
+            char* end = nullptr;
+            const double value = std::strtod(field.c_str(), &end);
+            valid = count < values.size() && end != field.c_str() && *end == '\0' && std::isfinite(value);
+            if (valid) values[count++] = value;
+        }
+        if (!valid || count != values.size() || values.back() < 0) continue;  // header or damaged line
+
+        Features refining, refined;
+        double* sides[2][kFeatures] = {
+            {&refining.size, &refining.states, &refining.moves, &refining.least, &refining.greatest, &refining.next},
+            {&refined.size, &refined.states, &refined.moves, &refined.least, &refined.greatest, &refined.next}};
+        for (size_t side = 0; side < 2; ++side) {
+            for (size_t k = 0; k < kFeatures; ++k) *sides[side][k] = values[side * kFeatures + k];
+        }
+        const Row row = __row(refining, refined);
+        const double target = std::log1p(values.back());
+        for (size_t r = 0; r < kWeights; ++r) {
+            moment[r] += row[r] * target;
+            for (size_t c = 0; c < kWeights; ++c) gram[r][c] += row[r] * row[c];
+        }
+        ++used;
+    }
+    if (used < kWeights) return 0;
+
+    for (size_t r = 1; r < kWeights; ++r) gram[r][r] += kRidge * static_cast<double>(used);
+
+    // Gaussian elimination with partial pivoting; the ridge keeps the system regular
+    std::array<double, kWeights> solution = moment;
+    for (size_t col = 0; col < kWeights; ++col) {
+        size_t pivot = col;
+        for (size_t r = col + 1; r < kWeights; ++r) {
+            if (std::abs(gram[r][col]) > std::abs(gram[pivot][col])) pivot = r;
+        }
+        if (std::abs(gram[pivot][col]) < 1e-12) return 0;
+        std::swap(gram[col], gram[pivot]);
+        std::swap(solution[col], solution[pivot]);
+        for (size_t r = col + 1; r < kWeights; ++r) {
+            const double factor = gram[r][col] / gram[col][col];
+            for (size_t c = col; c < kWeights; ++c) gram[r][c] -= factor * gram[col][c];
+            solution[r] -= factor * solution[col];
+        }
+    }
+    for (size_t col = kWeights; col-- > 0;) {
+        for (size_t c = col + 1; c < kWeights; ++c) solution[col] -= gram[col][c] * solution[c];
+        solution[col] /= gram[col][col];
+    }
+    weights_ = solution;
+    calibrated_ = true;
+    return used;
+}
+
+void CostModel::record(const Features& refining, const Features& refined, std::chrono::microseconds taken) {
+    if (!recording_) return;
+    std::lock_guard<std::mutex> lock(samples_mutex_);
+    samples_.push_back({refining, refined, static_cast<double>(taken.count())});
+}
+
+size_t CostModel::samples() const {
+    std::lock_guard<std::mutex> lock(samples_mutex_);
+    return samples_.size();
+}
+
+void CostModel::writeSamples(const std::string& path) const {
+    const bool is_new = !std::filesystem::exists(path);
+    std::ofstream out(path, std::ios::app);
+    if (!out) throw std::runtime_error("Cannot write cost samples: " + path);
+    if (is_new) {
+        for (const char* side : {"refining_", "refined_"}) {
+            for (const char* name : kFeatureNames) out << side << name << ",";
+        }
+        out << "latency_us\n";
+    }
+    auto put = [&out](const Features& f) {
+        out << f.size << "," << f.states << "," << f.moves << "," << f.least << "," << f.greatest << "," << f.next
+            << ",";
+    };
+    std::lock_guard<std::mutex> lock(samples_mutex_);
+    for (const auto& sample : samples_) {
+        put(sample.refining);
+        put(sample.refined);
+        out << sample.latency_us << "\n";
+    }
+    if (!out) throw std::runtime_error("Cannot write cost samples: " + path);
+}
+
+} // namespace ctl
@@ -0,0 +1,56 @@
+#include "entailment_session.h"
+#include "SMTInterface.h"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace ctl {
+
+namespace {
+
+class StringEntailmentSession : public EntailmentSession {
+public:
+    explicit StringEntailmentSession(const SMTInterface& smt) : smt_(smt) {}
+
+    Literal assume(GuardTable::Id guard) override {
+        return __add(GuardTable::instance().text(guard));
+    }
+
+    Literal assumeNotAll(std::span<const GuardTable::Id> guards) override {
+        if (guards.empty()) return __add("false");
+        std::string conjunction;
+        for (GuardTable::Id guard : guards) {
+            if (!conjunction.empty()) conjunction += " & ";
+            conjunction += "(" + GuardTable::instance().text(guard) + ")";
+        }
+        return __add("!(" + conjunction + ")");
+    }
+
+    Verdict check(std::span<const Literal> assumptions, std::optional<unsigned>) override {
+        std::unordered_set<std::string> formulas;
+        for (Literal literal : assumptions) formulas.insert(formulas_[literal]);
+        return smt_.isSatisfiable(formulas) ? Verdict::SAT : Verdict::UNSAT;
+    }
+
+private:
+    Literal __add(std::string formula) {
+        formulas_.push_back(std::move(formula));
+        return static_cast<Literal>(formulas_.size() - 1);
+    }
+
+    const SMTInterface& smt_;
+    std::vector<std::string> formulas_;  // by literal
+};
+
+} // namespace
+
+std::unique_ptr<EntailmentSession> openStringEntailmentSession(const SMTInterface& smt) {
+    return std::make_unique<StringEntailmentSession>(smt);
+}
+
+std::unique_ptr<EntailmentSession> SMTInterface::openEntailmentSession() const {
+    return openStringEntailmentSession(*this);
+}
+
+} // namespace ctl
@@ -0,0 +1,134 @@
+#include "flat_formula.h"
+#include "formula_factory.h"
+#include "visitors.h"
+
+#include <unordered_map>
+
+namespace ctl {
+
+namespace {
+    // Structural identity of a node once its children have ids
+    struct NodeKey {
+        FormulaType type;
+        uint8_t op;
+        FlatFormula::NodeId first;
+        FlatFormula::NodeId second;
+        TimeInterval interval;
+        std::string leaf;  // printed atom, comparison or literal
+
+        bool operator==(const NodeKey& o) const {
+            return type == o.type && op == o.op && first == o.first && second == o.second &&
+                   interval == o.interval && leaf == o.leaf;
+        }
+    };
+
+    struct NodeKeyHash {
+        size_t operator()(const NodeKey& k) const noexcept {
+            size_t h = std::hash<std::string>{}(k.leaf);
+            for (uint64_t v : {uint64_t(k.type), uint64_t(k.op), uint64_t(k.first), uint64_t(k.second),
+                               uint64_t(uint32_t(k.interval.lower)), uint64_t(uint32_t(k.interval.upper))}) {
+                h = (h ^ v) * 1099511628211u;
+            }
+            return h;
+        }
+    };
+
+    // Operands of f without building a children() vector
+    std::pair<const CTLFormula*, const CTLFormula*> operands(const CTLFormula& f) {
+        switch (f.getType()) {
+            case FormulaType::NEGATION:
+                return {static_cast<const NegationFormula&>(f).operand.get(), nullptr};
+            case FormulaType::BINARY: {
+                const auto& b = static_cast<const BinaryFormula&>(f);
+                return {b.left.get(), b.right.get()};
+            }
+            case FormulaType::TEMPORAL: {
+                const auto& t = static_cast<const TemporalFormula&>(f);
+                return {t.operand.get(), t.second_operand.get()};
+            }
+            default:
+                return {nullptr, nullptr};
+        }
+    }
+} // end anonymous namespace
+
+FlatFormula::FlatFormula(const CTLFormula& root) {
+    std::unordered_map<const CTLFormula*, NodeId> by_source;  // shared subtrees are walked once
+    std::unordered_map<NodeKey, NodeId, NodeKeyHash> by_key;
+
+    // Explicit post-order stack: a node is emitted once both operands have ids
+    std::vector<std::pair<const CTLFormula*, bool>> stack{{&root, false}};
+    while (!stack.empty()) {
+        auto [f, expanded] = stack.back();
+        if (by_source.count(f)) {
+            stack.pop_back();
+            continue;
+        }
+        auto [first, second] = operands(*f);
+        if (!expanded) {
+            stack.back().second = true;
+            if (second) stack.emplace_back(second, false);
+            if (first) stack.emplace_back(first, false);
+            continue;
+        }
+        stack.pop_back();
+
+        NodeKey key{f->getType(), 0, first ? by_source.at(first) : NONE, second ? by_source.at(second) : NONE, {}, {}};
+        switch (key.type) {
+            case FormulaType::BINARY:
+                key.op = static_cast<uint8_t>(static_cast<const BinaryFormula*>(f)->operator_);
+                break;
+            case FormulaType::TEMPORAL:
+                key.op = static_cast<uint8_t>(static_cast<const TemporalFormula*>(f)->operator_);
+                key.interval = static_cast<const TemporalFormula*>(f)->interval;
+                break;
+            case FormulaType::NEGATION:
+                break;
+            default:
+                key.leaf = f->toString();
+                break;
+        }
+        auto [it, inserted] = by_key.try_emplace(std::move(key), static_cast<NodeId>(nodes_.size()));
+        if (inserted) {
+            nodes_.push_back(Node{it->first.type, it->first.op, it->first.first, it->first.second, f});
+        }
+        by_source.emplace(f, it->second);
+    }
+}
+
+std::vector<const CTLFormula*> FlatFormula::closure() const {
+    std::vector<const CTLFormula*> out;
+    out.reserve(nodes_.size() + nodes_.size() / 2);
+    for (const Node& node : nodes_) {
+        // ¬p was already emitted right after p
+        if (node.type == FormulaType::NEGATION && nodes_[node.first].type == FormulaType::ATOMIC) continue;
+        out.push_back(node.source);
+        if (node.type == FormulaType::ATOMIC) {
+            // The factory owns the interned negation, so the pointer stays valid
+            out.push_back(FormulaFactory::instance()
+                              .intern(std::make_shared<NegationFormula>(node.source->clone())).get());
+        }
+    }
+    return out;
+}
+
+size_t FlatFormula::closureSize() const {
+    size_t n = nodes_.size();
+    for (const Node& node : nodes_) {
+        if (node.type == FormulaType::ATOMIC) ++n;
+        if (node.type == FormulaType::NEGATION && nodes_[node.first].type == FormulaType::ATOMIC) --n;
+    }
+    return n;
+}
+
+std::unordered_set<std::string> FlatFormula::atomicPropositions() const {
+    AtomCollectorVisitor visitor;
+    for (const Node& node : nodes_) {
+        if (node.type == FormulaType::ATOMIC || node.type == FormulaType::COMPARISON) {
+            node.source->accept(visitor);
+        }
+    }
+    return visitor.getAtoms();
+}
+
+} // namespace ctl
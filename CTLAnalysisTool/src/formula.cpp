@@ -6,14 +6,14 @@
 namespace ctl {
 
 // AtomicFormula implementation
-bool AtomicFormula::equals(const CTLFormula& other) const {
+bool AtomicFormula::structurallyEquals(const CTLFormula& other) const {
     if (auto atomic = dynamic_cast<const AtomicFormula*>(&other)) {
         return proposition == atomic->proposition;
     }
     return false;
 }
 
-size_t AtomicFormula::hash() const {
+size_t AtomicFormula::computeHash() const {
     return std::hash<std::string>{}("atomic:" + proposition);
 }
 
@@ -22,7 +22,7 @@ void AtomicFormula::accept(CTLFormulaVisitor& visitor) const {
 }
 
 // ComparisonFormula implementation
-bool ComparisonFormula::equals(const CTLFormula& other) const {
+bool ComparisonFormula::structurallyEquals(const CTLFormula& other) const {
     if (auto comparison = dynamic_cast<const ComparisonFormula*>(&other)) {
         return variable == comparison->variable && 
                operator_ == comparison->operator_ && 
@@ -31,7 +31,7 @@ bool ComparisonFormula::equals(const CTLFormula& other) const {
     return false;
 }
 
-size_t ComparisonFormula::hash() const {
+size_t ComparisonFormula::computeHash() const {
     return std::hash<std::string>{}("comparison:" + variable + operator_ + value);
 }
 
@@ -40,14 +40,14 @@ void ComparisonFormula::accept(CTLFormulaVisitor& visitor) const {
 }
 
 // BooleanLiteral implementation
-bool BooleanLiteral::equals(const CTLFormula& other) const {
+bool BooleanLiteral::structurallyEquals(const CTLFormula& other) const {
     if (auto boolean = dynamic_cast<const BooleanLiteral*>(&other)) {
         return value == boolean->value;
     }
     return false;
 }
 
-size_t BooleanLiteral::hash() const {
+size_t BooleanLiteral::computeHash() const {
     return std::hash<std::string>{}("boolean:" + std::to_string(value));
 }
 
@@ -67,18 +67,18 @@ std::string NegationFormula::toNuSMVString() const {
     return "!" + (operand->isAtomic() ? operand->toNuSMVString() : "(" + operand->toNuSMVString() + ")");
 }
 
-CTLFormulaPtr NegationFormula::clone() const {
+CTLFormulaPtr NegationFormula::copy() const {
     return std::make_shared<NegationFormula>(operand->clone());
 }
 
-bool NegationFormula::equals(const CTLFormula& other) const {
+bool NegationFormula::structurallyEquals(const CTLFormula& other) const {
     if (auto negation = dynamic_cast<const NegationFormula*>(&other)) {
         return operand->equals(*negation->operand);
     }
     return false;
 }
 
-size_t NegationFormula::hash() const {
+size_t NegationFormula::computeHash() const {
     return std::hash<std::string>{}("negation:") ^ (operand->hash() << 1);
 }
 
@@ -117,11 +117,11 @@ std::string BinaryFormula::toNuSMVString() const {
     return leftStr + " " + operatorToNuSMVString() + " " + rightStr;
 }
 
-CTLFormulaPtr BinaryFormula::clone() const {
+CTLFormulaPtr BinaryFormula::copy() const {
     return std::make_shared<BinaryFormula>(left->clone(), operator_, right->clone());
 }
 
-bool BinaryFormula::equals(const CTLFormula& other) const {
+bool BinaryFormula::structurallyEquals(const CTLFormula& other) const {
     if (auto binary = dynamic_cast<const BinaryFormula*>(&other)) {
         return operator_ == binary->operator_ && 
                left->equals(*binary->left) && 
@@ -130,7 +130,7 @@ bool BinaryFormula::equals(const CTLFormula& other) const {
     return false;
 }
 
-size_t BinaryFormula::hash() const {
+size_t BinaryFormula::computeHash() const {
     size_t h1 = std::hash<int>{}(static_cast<int>(operator_));
     size_t h2 = left->hash();
     size_t h3 = right->hash();
@@ -229,7 +229,7 @@ std::string TemporalFormula::toNuSMVString() const {
     return result;
 }
 
-CTLFormulaPtr TemporalFormula::clone() const {
+CTLFormulaPtr TemporalFormula::copy() const {
     if (second_operand) {
         return std::make_shared<TemporalFormula>(operator_, operand->clone(), second_operand->clone());
     } else {
@@ -237,7 +237,7 @@ CTLFormulaPtr TemporalFormula::clone() const {
     }
 }
 
-bool TemporalFormula::equals(const CTLFormula& other) const {
+bool TemporalFormula::structurallyEquals(const CTLFormula& other) const {
     if (auto temporal = dynamic_cast<const TemporalFormula*>(&other)) {
         if (operator_ != temporal->operator_ || interval != temporal->interval) {
             return false;
@@ -258,7 +258,7 @@ bool TemporalFormula::equals(const CTLFormula& other) const {
     return false;
 }
 
-size_t TemporalFormula::hash() const {
+size_t TemporalFormula::computeHash() const {
     size_t h1 = std::hash<int>{}(static_cast<int>(operator_));
     size_t h2 = std::hash<int>{}(interval.lower) ^ (std::hash<int>{}(interval.upper) << 1);
     size_t h3 = operand->hash();
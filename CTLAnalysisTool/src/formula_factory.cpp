@@ -0,0 +1,88 @@
+#include "formula_factory.h"
+
+#include <functional>
+#include <stdexcept>
+
+namespace ctl {
+
+FormulaFactory& FormulaFactory::instance() {
+    static FormulaFactory factory;
+    return factory;
+}
+
+size_t FormulaFactory::NodeKeyHash::operator()(const NodeKey& k) const noexcept {
+    size_t h = std::hash<int>{}(static_cast<int>(k.type));
+    auto mix = [&h](size_t v) { h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+    mix(std::hash<int>{}(k.op));
+    mix(std::hash<int>{}(k.lower));
+    mix(std::hash<int>{}(k.upper));
+    mix(std::hash<std::string>{}(k.payload));
+    mix(std::hash<const void*>{}(k.first));
+    mix(std::hash<const void*>{}(k.second));
+    return h;
+}
+
+CTLFormulaPtr FormulaFactory::intern(const CTLFormulaPtr& formula) {
+    if (!formula || formula->isInterned()) return formula;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return __intern(formula);
+}
+
+size_t FormulaFactory::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return table_.size();
+}
+
+CTLFormulaPtr FormulaFactory::__intern(const CTLFormulaPtr& formula) {
+    if (formula->isInterned()) return formula;
+
+    NodeKey key{formula->getType()};
+    CTLFormulaPtr first, second;
+    std::function<CTLFormulaPtr()> make;
+
+    if (auto a = std::dynamic_pointer_cast<AtomicFormula>(formula)) {
+        key.payload = a->proposition;
+        make = [&] { return std::make_shared<AtomicFormula>(a->proposition); };
+    } else if (auto c = std::dynamic_pointer_cast<ComparisonFormula>(formula)) {
+        key.payload = c->variable + '\0' + c->operator_ + '\0' + c->value;
+        make = [&] { return std::make_shared<ComparisonFormula>(c->variable, c->operator_, c->value); };
+    } else if (auto b = std::dynamic_pointer_cast<BooleanLiteral>(formula)) {
+        key.op = b->value ? 1 : 0;
+        make = [&] { return std::make_shared<BooleanLiteral>(b->value); };
+    } else if (auto n = std::dynamic_pointer_cast<NegationFormula>(formula)) {
+        first = __intern(n->operand);
+        make = [&] { return std::make_shared<NegationFormula>(first); };
+    } else if (auto bin = std::dynamic_pointer_cast<BinaryFormula>(formula)) {
+        first = __intern(bin->left);
+        second = __intern(bin->right);
+        key.op = static_cast<int>(bin->operator_);
+        make = [&] { return std::make_shared<BinaryFormula>(first, bin->operator_, second); };
+    } else if (auto t = std::dynamic_pointer_cast<TemporalFormula>(formula)) {
+        first = __intern(t->operand);
+        if (t->second_operand) second = __intern(t->second_operand);
+        key.op = static_cast<int>(t->operator_);
+        key.lower = t->interval.lower;
+        key.upper = t->interval.upper;
+        make = [&] {
+            auto node = second ? std::make_shared<TemporalFormula>(t->operator_, first, second)
+                               : std::make_shared<TemporalFormula>(t->operator_, t->interval, first);
+            node->interval = t->interval;
+            return node;
+        };
+    } else {
+        throw std::runtime_error("Unknown formula node in FormulaFactory::intern: " + formula->toString());
+    }
+    key.first = first.get();
+    key.second = second.get();
+
+    auto it = table_.find(key);
+    if (it != table_.end()) return it->second;
+
+    CTLFormulaPtr node = make();
+    node->hash_ = node->computeHash();
+    node->interned_ = true;
+    table_.emplace(std::move(key), node);
+    return node;
+}
+
+} // namespace ctl
@@ -1,6 +1,8 @@
 
 #include "formula_utils.h"
 #include "visitors.h"
+#include "parser.h"
+#include "formula_factory.h"
 // Utility functions implementation
 namespace ctl::formula_utils {
 
@@ -229,47 +231,6 @@ std::unique_ptr<CTLFormula> normalizeToCore(const CTLFormula& f) {
     }
     throw std::runtime_error("Unknown formula node in normalizeToCore: " + f.toString());
 }
-void collectClosureDFS(
-    const CTLFormula& f,
-    std::unordered_map<FormulaKey, const CTLFormula*, FormulaKeyHash>& seen,
-    std::vector<const CTLFormula*>& outTopo
-) {
-    FormulaKey k{f};
-    if (seen.count(k)) return;
-
-    // Mark early to avoid cycles
-    seen.emplace(k, &f);
-
-    // 1. Recurse over subformulas
-    if (auto bin = dynamic_cast<const BinaryFormula*>(&f)) {
-        collectClosureDFS(*bin->left,  seen, outTopo);
-        collectClosureDFS(*bin->right, seen, outTopo);
-    }
-    else if (auto t = dynamic_cast<const TemporalFormula*>(&f)) {
-        collectClosureDFS(*t->operand, seen, outTopo);
-        if (t->second_operand)
-            collectClosureDFS(*t->second_operand, seen, outTopo);
-    }
-    else if (auto n = dynamic_cast<const NegationFormula*>(&f)) {
-        // Since in NNF, this is always ¬atom
-        collectClosureDFS(*n->operand, seen, outTopo);
-    }
-
-    // 2. Add the formula itself
-    outTopo.push_back(&f);
-
-    // 3. If this is an atomic formula, add its negation
-    if (auto a = dynamic_cast<const AtomicFormula*>(&f)) {
-        NegationFormula* neg = new NegationFormula(a->clone());
-        FormulaKey nk{*neg};
-        if (!seen.count(nk)) {
-            seen.emplace(nk, neg);
-            outTopo.push_back(neg);
-        }
-    }
-
-    // 4. If this is ¬p, ensure p is present (already covered by normal recursion)
-}
 
 
 #ifdef USE_Z3
@@ -427,6 +388,101 @@ z3::expr parseStringToZ3(const std::string& str, z3::context& ctx, bool as_bool)
     else         return ctx.int_const(trimmed.c_str());
 }
 
+
+namespace {
+    bool isNumericLiteral(const std::string& s) {
+        if (s.empty()) return false;
+        size_t start = (s[0] == '-' || s[0] == '+') ? 1 : 0;
+        if (start == s.size()) return false;
+        for (size_t i = start; i < s.size(); ++i) {
+            if (!std::isdigit(static_cast<unsigned char>(s[i]))) return false;
+        }
+        return true;
+    }
+
+    // The literal as a solver numeral: any width, without a leading '+'
+    std::string integerNumeral(const std::string& literal) {
+        return literal[0] == '+' ? literal.substr(1) : literal;
+    }
+
+    bool isIdentifier(const std::string& s) {
+        if (s.empty()) return false;
+        for (char ch : s) {
+            if (!std::isalnum(static_cast<unsigned char>(ch)) && ch != '_' && ch != '.') return false;
+        }
+        return true;
+    }
+}
+
+z3::expr lowerToZ3(const CTLFormula& formula, z3::context& ctx, bool as_bool) {
+    switch (formula.getType()) {
+        case FormulaType::BOOLEAN_LITERAL:
+            return ctx.bool_val(static_cast<const BooleanLiteral&>(formula).value);
+
+        case FormulaType::ATOMIC: {
+            const auto& prop = static_cast<const AtomicFormula&>(formula).proposition;
+            if (as_bool) {
+                if (prop == "true" || prop == "1")  return ctx.bool_val(true);
+                if (prop == "false" || prop == "0") return ctx.bool_val(false);
+                if (isIdentifier(prop)) return ctx.bool_const(prop.c_str());
+            } else {
+                if (isNumericLiteral(prop)) return ctx.int_val(integerNumeral(prop).c_str());
+                if (isIdentifier(prop)) return ctx.int_const(prop.c_str());
+            }
+            // Arithmetic or otherwise unusual atom text: let the string parser decide
+            return parseStringToZ3(prop, ctx, as_bool);
+        }
+
+        case FormulaType::COMPARISON: {
+            const auto& cmp = static_cast<const ComparisonFormula&>(formula);
+            z3::expr lhs = lowerToZ3(AtomicFormula(cmp.variable), ctx, false);
+            z3::expr rhs = lowerToZ3(AtomicFormula(cmp.value), ctx, false);
+            const auto& op = cmp.operator_;
+            if (op == "==" || op == "=") return lhs == rhs;
+            if (op == "!=") return lhs != rhs;
+            if (op == "<")  return lhs < rhs;
+            if (op == "<=") return lhs <= rhs;
+            if (op == ">")  return lhs > rhs;
+            if (op == ">=") return lhs >= rhs;
+            throw std::runtime_error("Unknown comparison operator in lowerToZ3: " + op);
+        }
+
+        case FormulaType::NEGATION:
+            return !lowerToZ3(*static_cast<const NegationFormula&>(formula).operand, ctx, true);
+
+        case FormulaType::BINARY: {
+            const auto& bin = static_cast<const BinaryFormula&>(formula);
+            z3::expr l = lowerToZ3(*bin.left, ctx, true);
+            z3::expr r = lowerToZ3(*bin.right, ctx, true);
+            switch (bin.operator_) {
+                case BinaryOperator::AND:     return l && r;
+                case BinaryOperator::OR:      return l || r;
+                case BinaryOperator::IMPLIES: return z3::implies(l, r);
+                default: break;
+            }
+            throw std::runtime_error("Unsupported binary operator in lowerToZ3: " + formula.toString());
+        }
+
+        default:
+            throw std::runtime_error("Cannot lower non-propositional formula to Z3: " + formula.toString());
+    }
+}
+
+z3::expr guardToZ3(const std::string& guard, z3::context& ctx) {
+    CTLFormulaPtr ast;
+    try {
+        ast = Parser::parseFormula(guard);
+    } catch (const std::exception&) {
+        return parseStringToZ3(guard, ctx);
+    }
+    try {
+        return lowerToZ3(*ast, ctx);
+    } catch (const std::exception&) {
+        // Atom names that the CTL lexer reads as operators end up here
+        return parseStringToZ3(guard, ctx);
+    }
+}
+
 #endif // USE_Z3
 
 
@@ -594,14 +650,25 @@ CTLFormulaPtr negateFormula(const CTLFormula& formula, bool remove_comparisons)
 
 #ifdef USE_CVC5
 
-cvc5::Term parseStringToCVC5(const std::string_view& str, cvc5::Solver& solver, bool as_bool)
+namespace {
+    // The table's constant for name, created on first use
+    cvc5::Term cvc5Constant(const std::string& name, cvc5::Solver& solver, CVC5Symbols& symbols, bool as_bool) {
+        auto [it, inserted] = symbols.try_emplace((as_bool ? "b:" : "i:") + name);
+        if (inserted) {
+            it->second = solver.mkConst(as_bool ? solver.getBooleanSort() : solver.getIntegerSort(), name);
+        }
+        return it->second;
+    }
+}
+
+cvc5::Term parseStringToCVC5(const std::string_view& str, cvc5::Solver& solver, CVC5Symbols& symbols, bool as_bool)
 {
-    return parseStringToCVC5(std::string(str), solver, as_bool);
+    return parseStringToCVC5(std::string(str), solver, symbols, as_bool);
 }
 
 
 
-cvc5::Term parseStringToCVC5(const std::string& str, cvc5::Solver& solver, bool as_bool)
+cvc5::Term parseStringToCVC5(const std::string& str, cvc5::Solver& solver, CVC5Symbols& symbols, bool as_bool)
 {
     auto trim = [](const std::string& s) -> std::string {
         std::string result;
@@ -657,38 +724,38 @@ cvc5::Term parseStringToCVC5(const std::string& str, cvc5::Solver& solver, bool
     if (imp_pos != -1) {
         std::string left = trimmed.substr(0, imp_pos);
         std::string right = trimmed.substr(imp_pos + 2);
-        auto lhs = parseStringToCVC5(left, solver, true);
-        auto rhs = parseStringToCVC5(right, solver, true);
+        auto lhs = parseStringToCVC5(left, solver, symbols, true);
+        auto rhs = parseStringToCVC5(right, solver, symbols, true);
         return solver.mkTerm(cvc5::Kind::IMPLIES, {lhs, rhs});
     }
 
     if (eqv_pos != -1) {
         std::string left = trimmed.substr(0, eqv_pos);
         std::string right = trimmed.substr(eqv_pos + 3);
-        auto lhs = parseStringToCVC5(left, solver, true);
-        auto rhs = parseStringToCVC5(right, solver, true);
+        auto lhs = parseStringToCVC5(left, solver, symbols, true);
+        auto rhs = parseStringToCVC5(right, solver, symbols, true);
         return solver.mkTerm(cvc5::Kind::EQUAL, {lhs, rhs});
     }
 
     if (or_pos != -1) {
         std::string left = trimmed.substr(0, or_pos);
         std::string right = trimmed.substr(or_pos + 1);
-        auto lhs = parseStringToCVC5(left, solver, true);
-        auto rhs = parseStringToCVC5(right, solver, true);
+        auto lhs = parseStringToCVC5(left, solver, symbols, true);
+        auto rhs = parseStringToCVC5(right, solver, symbols, true);
         return solver.mkTerm(cvc5::Kind::OR, {lhs, rhs});
     }
 
     if (and_pos != -1) {
         std::string left = trimmed.substr(0, and_pos);
         std::string right = trimmed.substr(and_pos + 1);
-        auto lhs = parseStringToCVC5(left, solver, true);
-        auto rhs = parseStringToCVC5(right, solver, true);
+        auto lhs = parseStringToCVC5(left, solver, symbols, true);
+        auto rhs = parseStringToCVC5(right, solver, symbols, true);
         return solver.mkTerm(cvc5::Kind::AND, {lhs, rhs});
     }
 
     // --- Negation ---
     if (trimmed.front() == '!') {
-        auto inner = parseStringToCVC5(trimmed.substr(1), solver, true);
+        auto inner = parseStringToCVC5(trimmed.substr(1), solver, symbols, true);
         return solver.mkTerm(cvc5::Kind::NOT, {inner});
     }
 
@@ -714,8 +781,8 @@ cvc5::Term parseStringToCVC5(const std::string& str, cvc5::Solver& solver, bool
     if (cmp_pos != -1) {
         std::string left = trimmed.substr(0, cmp_pos);
         std::string right = trimmed.substr(cmp_pos + cmp_op.size());
-        auto lhs = parseStringToCVC5(left, solver, false);
-        auto rhs = parseStringToCVC5(right, solver, false);
+        auto lhs = parseStringToCVC5(left, solver, symbols, false);
+        auto rhs = parseStringToCVC5(right, solver, symbols, false);
 
         if (cmp_op == "==") return solver.mkTerm(cvc5::Kind::EQUAL, {lhs, rhs});
         if (cmp_op == "!=") return solver.mkTerm(cvc5::Kind::DISTINCT, {lhs, rhs});
@@ -743,12 +810,90 @@ cvc5::Term parseStringToCVC5(const std::string& str, cvc5::Solver& solver, bool
     }
 
     // Variable / Boolean atom
-    if (as_bool)
-        return solver.mkConst(solver.getBooleanSort(), trimmed);
-    else
-        return solver.mkConst(solver.getIntegerSort(), trimmed);
+    return cvc5Constant(trimmed, solver, symbols, as_bool);
+}
+
+
+
+
+namespace {
+    bool isCVC5NumericLiteral(const std::string& s) {
+        if (s.empty()) return false;
+        size_t start = (s[0] == '-' || s[0] == '+') ? 1 : 0;
+        if (start == s.size()) return false;
+        for (size_t i = start; i < s.size(); ++i)
+            if (!std::isdigit(static_cast<unsigned char>(s[i]))) return false;
+        return true;
+    }
 }
 
+cvc5::Term lowerToCVC5(const CTLFormula& formula, cvc5::Solver& solver, CVC5Symbols& symbols, bool as_bool)
+{
+    switch (formula.getType()) {
+        case FormulaType::BOOLEAN_LITERAL:
+            return static_cast<const BooleanLiteral&>(formula).value ? solver.mkTrue() : solver.mkFalse();
+
+        case FormulaType::ATOMIC: {
+            const auto& prop = static_cast<const AtomicFormula&>(formula).proposition;
+            if (as_bool) {
+                if (prop == "true" || prop == "1")  return solver.mkTrue();
+                if (prop == "false" || prop == "0") return solver.mkFalse();
+            } else if (isCVC5NumericLiteral(prop)) {
+                return solver.mkInteger(prop[0] == '+' ? prop.substr(1) : prop);
+            }
+            return cvc5Constant(prop, solver, symbols, as_bool);
+        }
+
+        case FormulaType::COMPARISON: {
+            const auto& cmp = static_cast<const ComparisonFormula&>(formula);
+            auto lhs = lowerToCVC5(AtomicFormula(cmp.variable), solver, symbols, false);
+            auto rhs = lowerToCVC5(AtomicFormula(cmp.value), solver, symbols, false);
+            const auto& op = cmp.operator_;
+            if (op == "==" || op == "=") return solver.mkTerm(cvc5::Kind::EQUAL, {lhs, rhs});
+            if (op == "!=") return solver.mkTerm(cvc5::Kind::DISTINCT, {lhs, rhs});
+            if (op == "<")  return solver.mkTerm(cvc5::Kind::LT, {lhs, rhs});
+            if (op == "<=") return solver.mkTerm(cvc5::Kind::LEQ, {lhs, rhs});
+            if (op == ">")  return solver.mkTerm(cvc5::Kind::GT, {lhs, rhs});
+            if (op == ">=") return solver.mkTerm(cvc5::Kind::GEQ, {lhs, rhs});
+            throw std::runtime_error("Unknown comparison operator in lowerToCVC5: " + op);
+        }
+
+        case FormulaType::NEGATION:
+            return solver.mkTerm(cvc5::Kind::NOT,
+                {lowerToCVC5(*static_cast<const NegationFormula&>(formula).operand, solver, symbols, true)});
+
+        case FormulaType::BINARY: {
+            const auto& bin = static_cast<const BinaryFormula&>(formula);
+            auto l = lowerToCVC5(*bin.left, solver, symbols, true);
+            auto r = lowerToCVC5(*bin.right, solver, symbols, true);
+            switch (bin.operator_) {
+                case BinaryOperator::AND:     return solver.mkTerm(cvc5::Kind::AND, {l, r});
+                case BinaryOperator::OR:      return solver.mkTerm(cvc5::Kind::OR, {l, r});
+                case BinaryOperator::IMPLIES: return solver.mkTerm(cvc5::Kind::IMPLIES, {l, r});
+                default: break;
+            }
+            throw std::runtime_error("Unsupported binary operator in lowerToCVC5: " + formula.toString());
+        }
+
+        default:
+            throw std::runtime_error("Cannot lower non-propositional formula to CVC5: " + formula.toString());
+    }
+}
+
+cvc5::Term guardToCVC5(const std::string& guard, cvc5::Solver& solver, CVC5Symbols& symbols)
+{
+    CTLFormulaPtr ast;
+    try {
+        ast = Parser::parseFormula(guard);
+    } catch (const std::exception&) {
+        return parseStringToCVC5(guard, solver, symbols);
+    }
+    try {
+        return lowerToCVC5(*ast, solver, symbols);
+    } catch (const std::exception&) {
+        return parseStringToCVC5(guard, solver, symbols);
+    }
+}
 
 #endif // USE_CVC5
 
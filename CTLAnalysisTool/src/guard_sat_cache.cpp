@@ -0,0 +1,102 @@
+#include "guard_sat_cache.h"
+#include "statistics.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ctl {
+
+namespace {
+    // Unit separator: cannot appear in a guard atom
+    constexpr char KEY_SEPARATOR = '\x1f';
+}
+
+GuardSatCache& GuardSatCache::instance() {
+    static GuardSatCache cache;
+    return cache;
+}
+
+std::string GuardSatCache::makeKey(const std::unordered_set<std::string>& atoms, bool without_parsing) {
+    std::vector<const std::string*> sorted;
+    sorted.reserve(atoms.size());
+    size_t length = 1;
+    for (const auto& atom : atoms) {
+        sorted.push_back(&atom);
+        length += atom.size() + 1;
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::string* a, const std::string* b) { return *a < *b; });
+
+    std::string key;
+    key.reserve(length);
+    key.push_back(without_parsing ? 'r' : 'p');
+    for (const auto* atom : sorted) {
+        key.push_back(KEY_SEPARATOR);
+        key += *atom;
+    }
+    return key;
+}
+
+std::string GuardSatCache::makeKey(const std::string& formula, bool without_parsing) {
+    std::string key;
+    key.reserve(formula.size() + 2);
+    key.push_back(without_parsing ? 'r' : 'p');
+    key.push_back(KEY_SEPARATOR);
+    key += formula;
+    return key;
+}
+
+std::optional<bool> GuardSatCache::lookup(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        Statistics::instance().add(Statistic::GUARD_CACHE_MISSES);
+        return std::nullopt;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    Statistics::instance().add(Statistic::GUARD_CACHE_HITS);
+    return it->second->second;
+}
+
+void GuardSatCache::insert(const std::string& key, bool satisfiable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        it->second->second = satisfiable;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+    lru_.emplace_front(key, satisfiable);
+    index_.emplace(key, lru_.begin());
+    __evictIfNeeded();
+}
+
+void GuardSatCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    __evictIfNeeded();
+}
+
+void GuardSatCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    hits_.store(0, std::memory_order_relaxed);
+    misses_.store(0, std::memory_order_relaxed);
+}
+
+size_t GuardSatCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+void GuardSatCache::__evictIfNeeded() {
+    while (index_.size() > capacity_ && !lru_.empty()) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+} // namespace ctl
@@ -0,0 +1,32 @@
+#include "guard_table.h"
+
+namespace ctl {
+
+GuardTable& GuardTable::instance() {
+    static GuardTable table;
+    return table;
+}
+
+GuardTable::GuardTable() {
+    texts_ = {"true", "false"};
+    ids_ = {{"", TRUE_ID}, {"true", TRUE_ID}, {"false", FALSE_ID}};
+}
+
+GuardTable::Id GuardTable::intern(const std::string& guard) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = ids_.emplace(guard, static_cast<Id>(texts_.size()));
+    if (inserted) texts_.push_back(guard);
+    return it->second;
+}
+
+const std::string& GuardTable::text(Id id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return texts_.at(id);
+}
+
+size_t GuardTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return texts_.size();
+}
+
+} // namespace ctl
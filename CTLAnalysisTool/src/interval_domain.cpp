@@ -0,0 +1,296 @@
+#include "interval_domain.h"
+#include "formula.h"
+#include "parser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <limits>
+
+namespace ctl {
+
+namespace {
+
+using Literal = IntervalDomain::Literal;
+using Kind = Literal::Kind;
+
+// Same atom syntax the Z3 lowering treats as a constant
+bool isIdentifier(const std::string& s) {
+    if (s.empty() || std::isdigit(static_cast<unsigned char>(s[0]))) return false;
+    for (char ch : s) {
+        if (!std::isalnum(static_cast<unsigned char>(ch)) && ch != '_' && ch != '.') return false;
+    }
+    return true;
+}
+
+std::optional<int64_t> integer(const std::string& s) {
+    int64_t value;
+    auto [end, error] = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (error != std::errc() || end != s.data() + s.size()) return std::nullopt;
+    return value;
+}
+
+// variable op value as literals, op read left to right; none if not expressible
+std::optional<std::vector<Literal>> comparison(const std::string& variable, std::string op, int64_t value) {
+    constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+    constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+    // Strict bounds become non-strict ones over the integers
+    if (op == "<") {
+        if (value == kMin) return std::nullopt;
+        return std::vector<Literal>{{variable, Kind::LE, value - 1}};
+    }
+    if (op == ">") {
+        if (value == kMax) return std::nullopt;
+        return std::vector<Literal>{{variable, Kind::GE, value + 1}};
+    }
+    // Bounds that always hold have no negation among the literals
+    if (op == "<=" && value != kMax) return std::vector<Literal>{{variable, Kind::LE, value}};
+    if (op == ">=" && value != kMin) return std::vector<Literal>{{variable, Kind::GE, value}};
+    if (op == "==" || op == "=") return std::vector<Literal>{{variable, Kind::EQ, value}};
+    if (op == "!=") return std::vector<Literal>{{variable, Kind::NE, value}};
+    return std::nullopt;
+}
+
+// The operator with its sides swapped: c < x is x > c
+std::string mirrored(const std::string& op) {
+    if (op == "<") return ">";
+    if (op == ">") return "<";
+    if (op == "<=") return ">=";
+    if (op == ">=") return "<=";
+    return op;
+}
+
+bool holds(int64_t left, const std::string& op, int64_t right) {
+    if (op == "<") return left < right;
+    if (op == ">") return left > right;
+    if (op == "<=") return left <= right;
+    if (op == ">=") return left >= right;
+    if (op == "!=") return left != right;
+    return left == right;
+}
+
+// Collects the literals of guard, negated if positive is false; false if relational
+bool collect(const CTLFormula& guard, bool positive, IntervalDomain::Conjunction& out) {
+    switch (guard.getType()) {
+        case FormulaType::BOOLEAN_LITERAL:
+            if (static_cast<const BooleanLiteral&>(guard).value != positive) out.never_holds = true;
+            return true;
+
+        case FormulaType::ATOMIC: {
+            const auto& prop = static_cast<const AtomicFormula&>(guard).proposition;
+            if (prop == "true" || prop == "1" || prop == "false" || prop == "0") {
+                if ((prop == "true" || prop == "1") != positive) out.never_holds = true;
+                return true;
+            }
+            if (!isIdentifier(prop)) return false;
+            out.literals.push_back({prop, positive ? Kind::ATOM : Kind::NOT_ATOM, 0});
+            return true;
+        }
+
+        case FormulaType::COMPARISON: {
+            const auto& cmp = static_cast<const ComparisonFormula&>(guard);
+            auto left = integer(cmp.variable);
+            auto right = integer(cmp.value);
+            std::optional<std::vector<Literal>> literals;
+            if (left && right) {
+                if (holds(*left, cmp.operator_, *right) != positive) out.never_holds = true;
+                return true;
+            }
+            if (!left && !right) return false;  // two variables: relational
+            if (right && isIdentifier(cmp.variable)) literals = comparison(cmp.variable, cmp.operator_, *right);
+            if (left && isIdentifier(cmp.value)) literals = comparison(cmp.value, mirrored(cmp.operator_), *left);
+            if (!literals || literals->size() != 1) return false;
+            out.literals.push_back(positive ? literals->front() : literals->front().negated());
+            return true;
+        }
+
+        case FormulaType::NEGATION:
+            return collect(*static_cast<const NegationFormula&>(guard).operand, !positive, out);
+
+        case FormulaType::BINARY: {
+            // A conjunction, or a negated disjunction; anything else is a disjunction
+            const auto& bin = static_cast<const BinaryFormula&>(guard);
+            const bool conjunction = positive ? bin.operator_ == BinaryOperator::AND
+                                              : bin.operator_ == BinaryOperator::OR;
+            if (conjunction) return collect(*bin.left, positive, out) && collect(*bin.right, positive, out);
+            if (!positive && bin.operator_ == BinaryOperator::IMPLIES) {
+                return collect(*bin.left, true, out) && collect(*bin.right, false, out);
+            }
+            return false;
+        }
+
+        default:
+            return false;
+    }
+}
+
+// The values one variable may take: [lo, hi] without the excluded points
+struct Range {
+    int64_t lo = std::numeric_limits<int64_t>::min();
+    int64_t hi = std::numeric_limits<int64_t>::max();
+    std::vector<int64_t> excluded;
+
+    void add(const Literal& literal) {
+        switch (literal.kind) {
+            case Kind::LE: hi = std::min(hi, literal.value); break;
+            case Kind::GE: lo = std::max(lo, literal.value); break;
+            case Kind::EQ:
+                lo = std::max(lo, literal.value);
+                hi = std::min(hi, literal.value);
+                break;
+            case Kind::NE: excluded.push_back(literal.value); break;
+            default: break;
+        }
+    }
+
+    bool empty() const {
+        if (lo > hi) return true;
+        // Only a range no wider than the excluded points can be used up by them
+        const uint64_t width = static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo);
+        if (width >= excluded.size()) return false;
+        std::vector<int64_t> inside;
+        for (int64_t value : excluded) {
+            if (value >= lo && value <= hi) inside.push_back(value);
+        }
+        std::sort(inside.begin(), inside.end());
+        inside.erase(std::unique(inside.begin(), inside.end()), inside.end());
+        return inside.size() > width;
+    }
+};
+
+// A conjunction of literals, checked as literals are added
+class Constraints {
+public:
+    // False once the conjunction has no model
+    bool add(const Literal& literal) {
+        if (literal.kind == Kind::ATOM || literal.kind == Kind::NOT_ATOM) {
+            const bool value = literal.kind == Kind::ATOM;
+            auto [it, inserted] = atoms_.try_emplace(literal.variable, value);
+            if (!inserted && it->second != value) empty_ = true;
+        } else {
+            Range& range = ranges_[literal.variable];
+            range.add(literal);
+            if (range.empty()) empty_ = true;
+        }
+        return !empty_;
+    }
+
+    bool add(const IntervalDomain::Conjunction& guard) {
+        if (guard.never_holds) empty_ = true;
+        for (const auto& literal : guard.literals) {
+            if (!add(literal)) break;
+        }
+        return !empty_;
+    }
+
+    // No model of this conjunction falsifies the literal
+    bool implies(const Literal& literal) const {
+        if (empty_) return true;
+        if (literal.kind == Kind::ATOM || literal.kind == Kind::NOT_ATOM) {
+            auto it = atoms_.find(literal.variable);
+            return it != atoms_.end() && it->second == (literal.kind == Kind::ATOM);
+        }
+        auto it = ranges_.find(literal.variable);
+        Range range = it != ranges_.end() ? it->second : Range{};
+        range.add(literal.negated());
+        return range.empty();
+    }
+
+private:
+    std::unordered_map<std::string, bool> atoms_;
+    std::unordered_map<std::string, Range> ranges_;
+    bool empty_ = false;
+};
+
+} // namespace
+
+Literal IntervalDomain::Literal::negated() const {
+    switch (kind) {
+        case Kind::ATOM: return {variable, Kind::NOT_ATOM, value};
+        case Kind::NOT_ATOM: return {variable, Kind::ATOM, value};
+        // Bounds always leave room on the other side, see comparison()
+        case Kind::LE: return {variable, Kind::GE, value + 1};
+        case Kind::GE: return {variable, Kind::LE, value - 1};
+        case Kind::EQ: return {variable, Kind::NE, value};
+        case Kind::NE: return {variable, Kind::EQ, value};
+    }
+    return *this;
+}
+
+IntervalDomain& IntervalDomain::instance() {
+    static IntervalDomain domain;
+    return domain;
+}
+
+std::optional<IntervalDomain::Conjunction> IntervalDomain::toConjunction(const CTLFormula& guard) {
+    Conjunction conjunction;
+    if (!collect(guard, true, conjunction)) return std::nullopt;
+    return conjunction;
+}
+
+const IntervalDomain::Conjunction* IntervalDomain::lookup(GuardTable::Id guard) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = conjunctions_.find(guard);
+        if (it != conjunctions_.end()) return it->second ? &*it->second : nullptr;
+    }
+    std::optional<Conjunction> conjunction;
+    if (guard == GuardTable::TRUE_ID) {
+        conjunction.emplace();
+    } else if (guard == GuardTable::FALSE_ID) {
+        conjunction.emplace().never_holds = true;
+    } else {
+        try {
+            conjunction = toConjunction(*Parser::parseFormula(GuardTable::instance().text(guard)));
+        } catch (const std::exception&) {
+            // Text the CTL parser rejects is left to the SMT string parser
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = conjunctions_.try_emplace(guard, std::move(conjunction)).first->second;
+    return entry ? &*entry : nullptr;
+}
+
+std::optional<bool> IntervalDomain::satisfiable(std::span<const GuardTable::Id> guards) {
+    std::vector<const Conjunction*> forms;
+    forms.reserve(guards.size());
+    for (GuardTable::Id guard : guards) {
+        const Conjunction* form = lookup(guard);
+        if (!form) return std::nullopt;
+        forms.push_back(form);
+    }
+    Constraints all;
+    for (const Conjunction* form : forms) {
+        if (!all.add(*form)) return false;
+    }
+    return true;
+}
+
+std::optional<bool> IntervalDomain::entails(std::span<const GuardTable::Id> premise,
+                                            std::span<const GuardTable::Id> conclusion) {
+    std::vector<const Conjunction*> premises, conclusions;
+    for (GuardTable::Id guard : premise) {
+        const Conjunction* form = lookup(guard);
+        if (!form) return std::nullopt;
+        premises.push_back(form);
+    }
+    for (GuardTable::Id guard : conclusion) {
+        const Conjunction* form = lookup(guard);
+        if (!form) return std::nullopt;
+        conclusions.push_back(form);
+    }
+    // The premise implies a conjunction iff it implies each of its literals
+    Constraints assumed;
+    for (const Conjunction* form : premises) {
+        if (!assumed.add(*form)) return true;
+    }
+    for (const Conjunction* form : conclusions) {
+        if (form->never_holds) return false;
+        for (const auto& literal : form->literals) {
+            if (!assumed.implies(literal)) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace ctl
@@ -7,7 +7,7 @@
 
 namespace ctl {
 // Lexer implementation
-Lexer::Lexer(const std::string& input) : input_(input), position_(0) {
+Lexer::Lexer(std::string_view input) : input_(input), position_(0) {
     tokenize();
 }
 
@@ -40,13 +40,13 @@ void Lexer::skip_whitespace() {
 
 Token Lexer::read_identifier() {
     size_t start = position_;
-    std::string value;
     
     while (position_ < input_.length() && 
            (std::isalnum(current_char()) || current_char() == '_' || current_char() == '.' || current_char() == '-')) {
-        value += current_char();
         advance();
-    }    
+    }
+    std::string_view value = input_.substr(start, position_ - start);
+
     // Check for keywords
     if (value == "true") return Token(TokenType::TRUE_LIT, value, start);
     if (value == "false") return Token(TokenType::FALSE_LIT, value, start);
@@ -68,15 +68,13 @@ Token Lexer::read_identifier() {
 
 Token Lexer::read_number() {
     size_t start = position_;
-    std::string value;
     
     while (position_ < input_.length() && 
            (std::isdigit(current_char()) || current_char() == '.')) {
-        value += current_char();
         advance();
     }
     
-    return Token(TokenType::NUMBER, value, start);
+    return Token(TokenType::NUMBER, input_.substr(start, position_ - start), start);
 }
 
 Token Lexer::read_comparison_operator() {
@@ -115,7 +113,7 @@ Token Lexer::read_comparison_operator() {
         return Token(TokenType::EXCLAMATION, "!", start);
     }
     
-    return Token(TokenType::INVALID, std::string(1, first), start);
+    return Token(TokenType::INVALID, input_.substr(start, 1), start);
 }
 
 void Lexer::tokenize() {
@@ -135,11 +133,11 @@ void Lexer::tokenize() {
             tokens_.push_back(read_number());
         } else if (ch == '(' || ch == ')') {
             tokens_.push_back(Token(ch == '(' ? TokenType::LPAREN : TokenType::RPAREN, 
-                                  std::string(1, ch), start));
+                                  input_.substr(start, 1), start));
             advance();
         } else if (ch == '[' || ch == ']') {
             tokens_.push_back(Token(ch == '[' ? TokenType::LBRACKET : TokenType::RBRACKET, 
-                                  std::string(1, ch), start));
+                                  input_.substr(start, 1), start));
             advance();
         } else if (ch == ',') {
             tokens_.push_back(Token(TokenType::COMMA, ",", start));
@@ -173,7 +171,7 @@ std::string Lexer::getErrorContext(size_t pos, size_t context_size) const {
     size_t start = pos >= context_size ? pos - context_size : 0;
     size_t end = std::min(pos + context_size, input_.length());
     
-    std::string context = input_.substr(start, end - start);
+    std::string context(input_.substr(start, end - start));
     std::string marker(pos - start, ' ');
     marker += "^";
     
@@ -0,0 +1,37 @@
+#include "log.h"
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+namespace ctl::log {
+
+namespace {
+    std::atomic<int> runtime_level{static_cast<int>(Level::INFO)};
+    std::mutex output_mutex;
+}
+
+void setLevel(Level level) { runtime_level.store(static_cast<int>(level), std::memory_order_relaxed); }
+
+Level level() { return static_cast<Level>(runtime_level.load(std::memory_order_relaxed)); }
+
+bool levelFromString(const std::string& name, Level& level) {
+    static const std::pair<const char*, Level> names[] = {
+        {"error", Level::ERROR}, {"warn", Level::WARN}, {"info", Level::INFO},
+        {"debug", Level::DEBUG}, {"trace", Level::TRACE}};
+    for (const auto& [text, value] : names) {
+        if (name == text) {
+            level = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+void write(Level message_level, const std::string& line) {
+    std::ostream& out = message_level <= Level::WARN ? std::cerr : std::cout;
+    std::lock_guard<std::mutex> lock(output_mutex);
+    out << line << '\n';
+}
+
+} // namespace ctl::log
@@ -0,0 +1,52 @@
+#include "memory_tracker.h"
+
+#include <cstdlib>
+#include <new>
+
+#if defined(CTL_ALLOCATION_COUNTERS) && defined(__GLIBC__)
+#include <malloc.h>
+#define CTL_COUNT_ALLOCATIONS 1
+#endif
+
+namespace ctl {
+namespace memory_utils {
+
+#ifdef CTL_COUNT_ALLOCATIONS
+namespace {
+    // Constant-initialized, so safe to touch from operator new at any point
+    // of a thread's life
+    thread_local ThreadAllocations thread_allocations;
+} // end anonymous namespace
+
+ThreadAllocations threadAllocations() { return thread_allocations; }
+bool allocationCountersEnabled() { return true; }
+#else
+ThreadAllocations threadAllocations() { return {}; }
+bool allocationCountersEnabled() { return false; }
+#endif
+
+} // namespace memory_utils
+} // namespace ctl
+
+#ifdef CTL_COUNT_ALLOCATIONS
+// Replacement allocation functions. The array, nothrow and sized forms of the
+// standard library forward to these two; over-aligned allocations are not
+// counted. Block sizes come from malloc_usable_size on both sides, so every
+// allocated byte is matched by the same number of freed bytes.
+void* operator new(std::size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    ctl::memory_utils::thread_allocations.allocated_bytes += malloc_usable_size(p);
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    ctl::memory_utils::thread_allocations.freed_bytes += malloc_usable_size(p);
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    ::operator delete(p);
+}
+#endif
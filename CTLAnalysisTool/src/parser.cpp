@@ -8,7 +8,7 @@ namespace ctl {
 
 
 // Parser implementation
-Parser::Parser(const std::vector<Token>& tokens) : tokens_(tokens), current_token_(0) {}
+Parser::Parser(std::span<const Token> tokens) : tokens_(tokens), current_token_(0) {}
 
 const Token& Parser::current() const {
     if (current_token_ < tokens_.size()) {
@@ -47,7 +47,7 @@ bool Parser::check(TokenType type) const {
 
 void Parser::consume(TokenType type, const std::string& error_message) {
     if (!match(type)) {
-        throw ParseException(error_message + ", got: " + current().value, current().position);
+        throw ParseException(error_message + ", got: " + std::string(current().value), current().position);
     }
 }
 
@@ -128,13 +128,13 @@ CTLFormulaPtr Parser::parse_temporal() {
     if ((check(TokenType::EU) || check(TokenType::AU)) && peek().type == TokenType::LPAREN) {
         auto op_token = current();
         advance();
-        consume(TokenType::LPAREN, "Expected '(' after " + op_token.value);
+        consume(TokenType::LPAREN, "Expected '(' after " + std::string(op_token.value));
         
         auto first = parse_expression();
         
         // Look for 'U' or 'W' token
         if (check(TokenType::ATOM)) {
-            std::string token_val = current().value;
+            std::string_view token_val = current().value;
             if (token_val == "U" || token_val == "W" || token_val == "R") {
                 advance(); // consume 'U' or 'W' or 'R'
 
@@ -188,7 +188,7 @@ CTLFormulaPtr Parser::parse_primary() {
             auto op_token = current();
             advance();
             
-            std::string value;
+            std::string_view value;
             if (check(TokenType::NUMBER)) {
                 value = current().value;
                 advance();
@@ -199,13 +199,13 @@ CTLFormulaPtr Parser::parse_primary() {
                 throw ParseException("Expected value after comparison operator", current().position);
             }
             
-            return std::make_shared<ComparisonFormula>(num_token.value, 
+            return std::make_shared<ComparisonFormula>(std::string(num_token.value), 
                                                      comparison_token_to_string(op_token.type), 
-                                                     value);
+                                                     std::string(value));
         }
         
         // If not a comparison, treat as a standalone number (could be an atomic proposition)
-        return std::make_shared<AtomicFormula>(num_token.value);
+        return atom(num_token.value);
     }
     
     if (check(TokenType::ATOM)) {
@@ -220,7 +220,7 @@ CTLFormulaPtr Parser::parse_primary() {
             auto op_token = current();
             advance();
             
-            std::string value;
+            std::string_view value;
             if (check(TokenType::NUMBER)) {
                 value = current().value;
                 advance();
@@ -231,24 +231,33 @@ CTLFormulaPtr Parser::parse_primary() {
                 throw ParseException("Expected value after comparison operator", current().position);
             }
             
-            return std::make_shared<ComparisonFormula>(atom_token.value, 
+            return std::make_shared<ComparisonFormula>(std::string(atom_token.value), 
                                                      comparison_token_to_string(op_token.type), 
-                                                     value);
+                                                     std::string(value));
         }
         
-        return std::make_shared<AtomicFormula>(atom_token.value);
+        return atom(atom_token.value);
     }
     
     throw ParseException("Expected expression", current().position);
 }
 
+// One node per proposition name within a formula; nodes are immutable once built
+CTLFormulaPtr Parser::atom(std::string_view name) {
+    auto it = atoms_.find(name);
+    if (it == atoms_.end()) {
+        it = atoms_.emplace(name, std::make_shared<AtomicFormula>(std::string(name))).first;
+    }
+    return it->second;
+}
+
 TimeInterval Parser::parse_time_interval() {
     consume(TokenType::LBRACKET, "Expected '['");
     
     if (!check(TokenType::NUMBER)) {
         throw ParseException("Expected number for time interval lower bound", current().position);
     }
-    int lower = std::stoi(current().value);
+    int lower = std::stoi(std::string(current().value));
     advance();
     
     consume(TokenType::COMMA, "Expected ',' in time interval");
@@ -256,7 +265,7 @@ TimeInterval Parser::parse_time_interval() {
     if (!check(TokenType::NUMBER)) {
         throw ParseException("Expected number for time interval upper bound", current().position);
     }
-    int upper = std::stoi(current().value);
+    int upper = std::stoi(std::string(current().value));
     advance();
     
     consume(TokenType::RBRACKET, "Expected ']'");
@@ -303,7 +312,7 @@ std::string Parser::comparison_token_to_string(TokenType type) {
     }
 }
 
-CTLFormulaPtr Parser::parseFormula(const std::string& input) {
+CTLFormulaPtr Parser::parseFormula(std::string_view input) {
     Lexer lexer(input);
     Parser parser(lexer.getTokens());
     return parser.parse();
@@ -4,78 +4,83 @@
 
 namespace ctl {
 
-// Initialize static members
-std::unordered_map<std::string, std::string> CTLSATParser::comparison_map_;
-std::unordered_map<std::string, std::string> CTLSATParser::atom_map_;
-int CTLSATParser::next_atom_id_ = 1;
+// Initialize per-thread members
+thread_local CTLSATParser::Mapping CTLSATParser::mapping_;
 
 std::string CTLSATParser::toCtlSatFormat(const CTLFormula& formula) {
-    return convertFormula(formula);
+    return convertFormula(formula, mapping_);
 }
 
 std::string CTLSATParser::convertString(const std::string& formula_str) {
+    return convertString(formula_str, mapping_);
+}
+
+std::string CTLSATParser::convertString(const std::string& formula_str, Mapping& mapping) {
     // Parse the formula string first using the static convenience method
     auto formula = Parser::parseFormula(formula_str);
     
     // Convert to CTLSAT format
-    return convertFormula(*formula);
+    return convertFormula(*formula, mapping);
+}
+
+std::string CTLSATParser::refinementQuery(const std::string& refining, const std::string& refined) {
+    // What convertFormula makes of "(refining) & !(refined)"
+    return "(" + refining + " ^ ~(" + refined + "))";
 }
 
 const std::unordered_map<std::string, std::string>& CTLSATParser::getComparisonMapping() {
-    return comparison_map_;
+    return mapping_.comparisons;
 }
 
 void CTLSATParser::clearComparisonMapping() {
-    comparison_map_.clear();
-    atom_map_.clear();
-    next_atom_id_ = 1;
+    mapping_ = Mapping();
 }
 
-std::string CTLSATParser::getComparisonAtom(const std::string& comparison) {
+std::string CTLSATParser::getComparisonAtom(const std::string& comparison, Mapping& mapping) {
     // Check if we already have a mapping for this comparison
-    auto it = comparison_map_.find(comparison);
-    if (it != comparison_map_.end()) {
+    auto it = mapping.comparisons.find(comparison);
+    if (it != mapping.comparisons.end()) {
         return it->second;
     }
     
     // Create a new atom for this comparison using single letters
     // Format: a, b, c, ..., z (26 possible atoms)
-    if (next_atom_id_ > 26) {
+    if (mapping.next_atom_id > 26) {
         throw std::runtime_error("Too many unique atoms (max 26)");
     }
     
-    char letter = 'a' + (next_atom_id_ - 1);
+    char letter = 'a' + (mapping.next_atom_id - 1);
     std::string atom(1, letter);
-    next_atom_id_++;
-    comparison_map_[comparison] = atom;
+    mapping.next_atom_id++;
+    mapping.comparisons[comparison] = atom;
     return atom;
 }
 
-std::string CTLSATParser::getAtomLetter(const std::string& atom) {
+std::string CTLSATParser::getAtomLetter(const std::string& atom, Mapping& mapping) {
     // Check if we already have a mapping for this atom
-    auto it = atom_map_.find(atom);
-    if (it != atom_map_.end()) {
+    auto it = mapping.atoms.find(atom);
+    if (it != mapping.atoms.end()) {
         return it->second;
     }
     
     // Create a new letter for this atom using single letters
     // Format: a, b, c, ..., z (26 possible atoms total across both maps)
-    if (next_atom_id_ > 26) {
+    if (mapping.next_atom_id > 26) {
         throw std::runtime_error("Too many unique atoms (max 26)");
     }
     
-    char letter = 'a' + (next_atom_id_ - 1);
+    char letter = 'a' + (mapping.next_atom_id - 1);
     std::string letter_str(1, letter);
-    next_atom_id_++;
-    atom_map_[atom] = letter_str;
+    mapping.next_atom_id++;
+    mapping.atoms[atom] = letter_str;
     return letter_str;
 }
 
-std::string CTLSATParser::convertFormula(const CTLFormula& formula) {
+std::string CTLSATParser::convertFormula(const CTLFormula& formula, Mapping& mapping) {
     // Handle comparison formulas - map to unique atoms (p1, p2, p3, etc.)
     if (auto comp = dynamic_cast<const ComparisonFormula*>(&formula)) {
         std::string comparison_str = comp->toString();
-        return getComparisonAtom(comparison_str);
+        return getComparisonAtom(comparison_str, mapping);
     }
     
     // Handle boolean literals (true/false)
@@ -92,18 +97,18 @@ std::string CTLSATParser::convertFormula(const CTLFormula& formula) {
             return "T";
         }
         // Map atomic proposition to a single letter
-        return getAtomLetter(atomic->proposition);
+        return getAtomLetter(atomic->proposition, mapping);
     }
     
     // Handle negation
     if (auto neg = dynamic_cast<const NegationFormula*>(&formula)) {
-        return "~(" + convertFormula(*neg->operand) + ")";
+        return "~(" + convertFormula(*neg->operand, mapping) + ")";
     }
     
     // Handle binary formulas (AND, OR, IMPLIES)
     if (auto binary = dynamic_cast<const BinaryFormula*>(&formula)) {
-        std::string left_str = convertFormula(*binary->left);
-        std::string right_str = convertFormula(*binary->right);
+        std::string left_str = convertFormula(*binary->left, mapping);
+        std::string right_str = convertFormula(*binary->right, mapping);
         
         switch (binary->operator_) {
             case BinaryOperator::AND:
@@ -119,33 +124,33 @@ std::string CTLSATParser::convertFormula(const CTLFormula& formula) {
     if (auto temporal = dynamic_cast<const TemporalFormula*>(&formula)) {
         switch (temporal->operator_) {
             case TemporalOperator::EX:
-                return "EX(" + convertFormula(*temporal->operand) + ")";
+                return "EX(" + convertFormula(*temporal->operand, mapping) + ")";
             case TemporalOperator::AX:
-                return "AX(" + convertFormula(*temporal->operand) + ")";
+                return "AX(" + convertFormula(*temporal->operand, mapping) + ")";
             case TemporalOperator::EF:
-                return "EF(" + convertFormula(*temporal->operand) + ")";
+                return "EF(" + convertFormula(*temporal->operand, mapping) + ")";
             case TemporalOperator::AF:
-                return "AF(" + convertFormula(*temporal->operand) + ")";
+                return "AF(" + convertFormula(*temporal->operand, mapping) + ")";
             case TemporalOperator::EG:
-                return "EG(" + convertFormula(*temporal->operand) + ")";
+                return "EG(" + convertFormula(*temporal->operand, mapping) + ")";
             case TemporalOperator::AG:
-                return "AG(" + convertFormula(*temporal->operand) + ")";
+                return "AG(" + convertFormula(*temporal->operand, mapping) + ")";
             case TemporalOperator::EU:
-                return "E(" + convertFormula(*temporal->operand) + " U " + 
-                       convertFormula(*temporal->second_operand) + ")";
+                return "E(" + convertFormula(*temporal->operand, mapping) + " U " + 
+                       convertFormula(*temporal->second_operand, mapping) + ")";
             case TemporalOperator::AU:
-                return "A(" + convertFormula(*temporal->operand) + " U " + 
-                       convertFormula(*temporal->second_operand) + ")";
+                return "A(" + convertFormula(*temporal->operand, mapping) + " U " + 
+                       convertFormula(*temporal->second_operand, mapping) + ")";
             case TemporalOperator::EW:
                 // E[φ W ψ] is rewritten as E[φ U ψ] | EG φ
-                return "(E(" + convertFormula(*temporal->operand) + " U " + 
-                       convertFormula(*temporal->second_operand) + ") v EG(" + 
-                       convertFormula(*temporal->operand) + "))";
+                return "(E(" + convertFormula(*temporal->operand, mapping) + " U " + 
+                       convertFormula(*temporal->second_operand, mapping) + ") v EG(" + 
+                       convertFormula(*temporal->operand, mapping) + "))";
             case TemporalOperator::AW:
                 // A[φ W ψ] is rewritten as A[φ U ψ] | AG φ
-                return "(A(" + convertFormula(*temporal->operand) + " U " + 
-                       convertFormula(*temporal->second_operand) + ") v AG(" + 
-                       convertFormula(*temporal->operand) + "))";
+                return "(A(" + convertFormula(*temporal->operand, mapping) + " U " + 
+                       convertFormula(*temporal->second_operand, mapping) + ") v AG(" + 
+                       convertFormula(*temporal->operand, mapping) + "))";
         }
     }
     
@@ -4,52 +4,66 @@
 
 namespace ctl {
 
-// Initialize static members
-std::unordered_map<std::string, std::string> MLSolverParser::comparison_map_;
-std::unordered_map<std::string, std::string> MLSolverParser::atom_map_;
-int MLSolverParser::next_atom_id_ = 1;
+// Initialize per-thread members
+thread_local MLSolverParser::Mapping MLSolverParser::mapping_;
 
 std::string MLSolverParser::toMLSolverFormat(const CTLFormula& formula) {
-    return convertFormula(formula);
+    return convertFormula(formula, mapping_);
 }
 
 std::string MLSolverParser::convertString(const std::string& formula_str) {
+    return convertString(formula_str, mapping_);
+}
+
+std::string MLSolverParser::convertString(const std::string& formula_str, Mapping& mapping) {
     // Parse the formula string first using the static convenience method
     auto formula = Parser::parseFormula(formula_str);
     
     // Convert to MLSolver format
-    return convertFormula(*formula);
+    return convertFormula(*formula, mapping);
+}
+
+std::string MLSolverParser::refinementQuery(const std::string& refining, const std::string& refined) {
+    // What convertFormula makes of "(refining) & !(refined)"
+    return "(" + refining + " & " + negate(refined) + ")";
+}
+
+std::string MLSolverParser::negate(const std::string& operand) {
+    // Add parentheses for complex subformulas
+    if (operand.find(' ') != std::string::npos ||
+        operand.find('(') != std::string::npos) {
+        return "! (" + operand + ")";
+    }
+    return "! " + operand;
 }
 
 const std::unordered_map<std::string, std::string>& MLSolverParser::getComparisonMapping() {
-    return comparison_map_;
+    return mapping_.comparisons;
 }
 
 void MLSolverParser::clearComparisonMapping() {
-    comparison_map_.clear();
-    atom_map_.clear();
-    next_atom_id_ = 1;
+    mapping_ = Mapping();
 }
 
-std::string MLSolverParser::getComparisonAtom(const std::string& comparison) {
+std::string MLSolverParser::getComparisonAtom(const std::string& comparison, Mapping& mapping) {
     // Check if we already have a mapping for this comparison
-    auto it = comparison_map_.find(comparison);
-    if (it != comparison_map_.end()) {
+    auto it = mapping.comparisons.find(comparison);
+    if (it != mapping.comparisons.end()) {
         return it->second;
     }
     
     // Create a new atom for this comparison
     // Format: p_1, p_2, p_3, etc.
-    std::string atom = "p_" + std::to_string(next_atom_id_);
-    next_atom_id_++;
-    comparison_map_[comparison] = atom;
+    std::string atom = "p_" + std::to_string(mapping.next_atom_id);
+    mapping.next_atom_id++;
+    mapping.comparisons[comparison] = atom;
     return atom;
 }
 
-std::string MLSolverParser::getAtomIdentifier(const std::string& atom) {
+std::string MLSolverParser::getAtomIdentifier(const std::string& atom, Mapping& mapping) {
     // Check if we already have a mapping for this atom
-    auto it = atom_map_.find(atom);
-    if (it != atom_map_.end()) {
+    auto it = mapping.atoms.find(atom);
+    if (it != mapping.atoms.end()) {
         return it->second;
     }
     
@@ -57,17 +71,17 @@ std::string MLSolverParser::getAtomIdentifier(const std::string& atom) {
     bool is_number = !atom.empty() &&
                      std::all_of(atom.begin(), atom.end(), ::isdigit);
     if (is_number) identifier = atom;
-    else identifier = "p" + std::to_string(next_atom_id_);
-    next_atom_id_++;
-    atom_map_[atom] = identifier;
+    else identifier = "p" + std::to_string(mapping.next_atom_id);
+    mapping.next_atom_id++;
+    mapping.atoms[atom] = identifier;
     return identifier;
 }
 
-std::string MLSolverParser::convertFormula(const CTLFormula& formula) {
+std::string MLSolverParser::convertFormula(const CTLFormula& formula, Mapping& mapping) {
     // Handle comparison formulas - map to unique atoms
     if (auto f = dynamic_cast<const ComparisonFormula*>(&formula)) {
-        std::string left  = getAtomIdentifier(f->variable);
-        std::string right = getAtomIdentifier(f->value);
+        std::string left  = getAtomIdentifier(f->variable, mapping);
+        std::string right = getAtomIdentifier(f->value, mapping);
         std::string tag   = f->tagToOp();
 
         return left+tag+right;
@@ -92,24 +106,18 @@ std::string MLSolverParser::convertFormula(const CTLFormula& formula) {
             return atomic->proposition;
         }
         // For longer names, use the mapping
-        return getAtomIdentifier(atomic->proposition);
+        return getAtomIdentifier(atomic->proposition, mapping);
     }
     
     // Handle negation
     if (auto neg = dynamic_cast<const NegationFormula*>(&formula)) {
-        std::string operand_str = convertFormula(*neg->operand);
-        // Add parentheses for complex subformulas
-        if (operand_str.find(' ') != std::string::npos || 
-            operand_str.find('(') != std::string::npos) {
-            return "! (" + operand_str + ")";
-        }
-        return "! " + operand_str;
+        return negate(convertFormula(*neg->operand, mapping));
     }
     
     // Handle binary formulas (AND, OR, IMPLIES)
     if (auto binary = dynamic_cast<const BinaryFormula*>(&formula)) {
-        std::string left_str = convertFormula(*binary->left);
-        std::string right_str = convertFormula(*binary->right);
+        std::string left_str = convertFormula(*binary->left, mapping);
+        std::string right_str = convertFormula(*binary->right, mapping);
         
         switch (binary->operator_) {
             case BinaryOperator::AND:
@@ -123,7 +131,7 @@ std::string MLSolverParser::convertFormula(const CTLFormula& formula) {
     
     // Handle temporal formulas
     if (auto temporal = dynamic_cast<const TemporalFormula*>(&formula)) {
-        std::string operand_str = convertFormula(*temporal->operand);
+        std::string operand_str = convertFormula(*temporal->operand, mapping);
         
         switch (temporal->operator_) {
             case TemporalOperator::EX:
@@ -139,25 +147,25 @@ std::string MLSolverParser::convertFormula(const CTLFormula& formula) {
             case TemporalOperator::AG:
                 return "A G " + operand_str;
             case TemporalOperator::EU: {
-                std::string second_str = convertFormula(*temporal->second_operand);
+                std::string second_str = convertFormula(*temporal->second_operand, mapping);
                 // Add parentheses around operands to ensure proper parsing
                 return "E ((" + operand_str + ") U (" + second_str + "))";
             }
             case TemporalOperator::AU: {
-                std::string second_str = convertFormula(*temporal->second_operand);
+                std::string second_str = convertFormula(*temporal->second_operand, mapping);
                 // Add parentheses around operands to ensure proper parsing
                 return "A ((" + operand_str + ") U (" + second_str + "))";
             }
             case TemporalOperator::EW: {
                 // E[φ W ψ] = ¬A[(¬ψ) U (¬φ ∧ ¬ψ)]
                 // This is semantically equivalent and valid CTL
-                std::string second_str = convertFormula(*temporal->second_operand);
+                std::string second_str = convertFormula(*temporal->second_operand, mapping);
                 return "! (A ((! (" + second_str + ")) U ((! (" + operand_str + ")) & (! (" + second_str + ")))))";
             }
             case TemporalOperator::AW: {
                 // A[φ W ψ] = ¬E[(¬ψ) U (¬φ ∧ ¬ψ)]
                 // This is semantically equivalent and valid CTL
-                std::string second_str = convertFormula(*temporal->second_operand);
+                std::string second_str = convertFormula(*temporal->second_operand, mapping);
                 return "! (E ((! (" + second_str + ")) U ((! (" + operand_str + ")) & (! (" + second_str + ")))))";
             }
         }
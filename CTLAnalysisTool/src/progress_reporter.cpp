@@ -0,0 +1,141 @@
+#include "progress_reporter.h"
+#include "memory_tracker.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace ctl {
+
+namespace {
+
+// User plus system CPU ticks of every thread of this process
+std::map<long, unsigned long long> threadTicks() {
+    std::map<long, unsigned long long> ticks;
+#ifdef __linux__
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator("/proc/self/task", error)) {
+        std::ifstream stat(entry.path() / "stat");
+        std::string line;
+        if (!std::getline(stat, line)) continue;
+        // The command name may hold spaces; the fields after it are space separated
+        const size_t name_end = line.rfind(')');
+        if (name_end == std::string::npos) continue;
+        std::istringstream fields(line.substr(name_end + 2));
+        std::string field;
+        unsigned long long utime = 0, stime = 0;
+        // Fields 14 and 15 of stat; the state (field 3) comes first here
+        for (int k = 3; k <= 15 && fields >> field; ++k) {
+            if (k == 14) utime = std::stoull(field);
+            if (k == 15) stime = std::stoull(field);
+        }
+        ticks[std::stol(entry.path().filename().string())] = utime + stime;
+    }
+#endif
+    return ticks;
+}
+
+double ticksPerSecond() {
+#ifdef __linux__
+    return static_cast<double>(sysconf(_SC_CLK_TCK));
+#else
+    return 100.0;
+#endif
+}
+
+double rate(uint64_t hits, uint64_t misses) {
+    return hits + misses > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+}
+
+} // namespace
+
+ProgressReporter::ProgressReporter(const std::string& path, std::chrono::milliseconds interval,
+                                   const RefinementCache* cache)
+    : out_(path, std::ios::app), interval_(interval), cache_(cache) {
+    if (!out_) throw std::runtime_error("Cannot open progress file: " + path);
+    start_ = last_time_ = last_progress_ = Clock::now();
+    start_values_ = last_values_ = Statistics::instance().snapshot();
+    last_thread_ticks_ = threadTicks();
+    thread_ = std::thread(&ProgressReporter::__run, this);
+}
+
+ProgressReporter::~ProgressReporter() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        stop_ = true;
+    }
+    stop_cv_.notify_all();
+    thread_.join();
+}
+
+void ProgressReporter::__run() {
+    std::unique_lock<std::mutex> lock(stop_mutex_);
+    bool stopping = false;
+    while (!stopping) {
+        stopping = stop_cv_.wait_for(lock, interval_, [this] { return stop_; });
+        out_ << sample() << "\n";
+        out_.flush();
+    }
+}
+
+std::string ProgressReporter::sample() {
+    std::lock_guard<std::mutex> lock(sample_mutex_);
+    const auto now = Clock::now();
+    const StatisticValues values = Statistics::instance().snapshot();
+    auto since = [&values](const StatisticValues& base, Statistic statistic) {
+        return values[static_cast<size_t>(statistic)] - base[static_cast<size_t>(statistic)];
+    };
+    const double elapsed = std::chrono::duration<double>(now - start_).count();
+    const double interval = std::chrono::duration<double>(now - last_time_).count();
+
+    const uint64_t planned = since(start_values_, Statistic::PAIRS_PLANNED);
+    const uint64_t decided = since(start_values_, Statistic::PAIRS_DECIDED);
+    const uint64_t remaining = planned > decided ? planned - decided : 0;
+    const uint64_t decided_now = since(last_values_, Statistic::PAIRS_DECIDED);
+    if (decided_now > 0) last_progress_ = now;
+
+    std::ostringstream line;
+    line << "{\"elapsed_s\":" << elapsed
+         << ",\"pairs_planned\":" << planned
+         << ",\"pairs_decided\":" << decided
+         << ",\"pairs_remaining\":" << remaining
+         << ",\"checks\":" << since(start_values_, Statistic::REFINEMENT_CHECKS)
+         << ",\"pairs_per_s\":" << (interval > 0 ? decided_now / interval : 0.0)
+         << ",\"checks_per_s\":"
+         << (interval > 0 ? since(last_values_, Statistic::REFINEMENT_CHECKS) / interval : 0.0);
+    // Null until a pair has been decided and while nothing is left
+    line << ",\"eta_s\":";
+    if (decided > 0 && remaining > 0) line << remaining * elapsed / static_cast<double>(decided);
+    else line << "null";
+    line << ",\"seconds_since_progress\":" << std::chrono::duration<double>(now - last_progress_).count()
+         << ",\"guard_cache_hit_rate\":"
+         << rate(since(start_values_, Statistic::GUARD_CACHE_HITS), since(start_values_, Statistic::GUARD_CACHE_MISSES));
+    if (cache_) line << ",\"verdict_cache_hit_rate\":" << rate(cache_->hits(), cache_->misses());
+    line << ",\"rss_kb\":" << memory_utils::getCurrentMemoryUsage().getResident();
+
+    // Utilization of each thread alive at both samples, 1.0 for a busy core
+    const auto ticks = threadTicks();
+    line << ",\"threads\":[";
+    bool first = true;
+    for (const auto& [tid, total] : ticks) {
+        auto it = last_thread_ticks_.find(tid);
+        // A new thread may reuse the id of one that ended
+        if (it == last_thread_ticks_.end() || total < it->second || interval <= 0) continue;
+        const double busy = static_cast<double>(total - it->second) / ticksPerSecond() / interval;
+        line << (first ? "" : ",") << "{\"tid\":" << tid << ",\"cpu\":" << busy << "}";
+        first = false;
+    }
+    line << "]}";
+
+    last_time_ = now;
+    last_values_ = values;
+    last_thread_ticks_ = ticks;
+    return line.str();
+}
+
+} // namespace ctl
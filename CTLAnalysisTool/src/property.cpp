@@ -1,10 +1,121 @@
 #include "property.h"
 #include "parser.h"
+#include "formula_factory.h"
+#include "automaton_budget.h"
+#include "automaton_cache.h"
+#include "memory_tracker.h"
+#include "log.h"
+#include "visitors.h"
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <map>
 #include <unordered_set>
 
 namespace ctl {
 
+namespace {
+
+// Boolean and numeric constants say nothing about which properties are related
+bool isLiteralAtom(const std::string& atom) {
+    if (atom == "true" || atom == "false") return true;
+    double value;
+    const char* end = atom.data() + atom.size();
+    auto [parsed, error] = std::from_chars(atom.data(), end, value);
+    return error == std::errc() && parsed == end;
+}
+
+// Temporal operators as a path quantifier and a modality, so the syntactic
+// order is a product of two small orders: A before E, and G before F; X, U,
+// W and R are only related to themselves
+enum class Modality : uint8_t { G, F, X, U, W, R };
+
+constexpr bool universal(TemporalOperator op) {
+    switch (op) {
+        case TemporalOperator::AF: case TemporalOperator::AG: case TemporalOperator::AU:
+        case TemporalOperator::AW: case TemporalOperator::AX: case TemporalOperator::AR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+constexpr Modality modality(TemporalOperator op) {
+    switch (op) {
+        case TemporalOperator::EG: case TemporalOperator::AG: return Modality::G;
+        case TemporalOperator::EX: case TemporalOperator::AX: return Modality::X;
+        case TemporalOperator::EF: case TemporalOperator::AF: return Modality::F;
+        case TemporalOperator::EU: case TemporalOperator::AU: return Modality::U;
+        case TemporalOperator::EW: case TemporalOperator::AW: return Modality::W;
+        default: return Modality::R;
+    }
+}
+
+constexpr size_t kTemporalOperators = static_cast<size_t>(TemporalOperator::AR) + 1;
+
+// kTemporalRefines[a][b]: op a (phi) implies op b (phi) on every total
+// structure: AG ⊑ AF ⊑ EF, AG ⊑ EG ⊑ EF, and A ⊑ E for the same modality
+constexpr auto kTemporalRefines = [] {
+    std::array<std::array<bool, kTemporalOperators>, kTemporalOperators> table{};
+    for (size_t a = 0; a < kTemporalOperators; ++a) {
+        for (size_t b = 0; b < kTemporalOperators; ++b) {
+            const auto op1 = static_cast<TemporalOperator>(a);
+            const auto op2 = static_cast<TemporalOperator>(b);
+            const Modality m1 = modality(op1), m2 = modality(op2);
+            const bool quantifier = universal(op1) || !universal(op2);
+            const bool ordered = m1 <= Modality::F && m2 <= Modality::F;
+            table[a][b] = quantifier && (m1 == m2 || (ordered && m1 < m2));
+        }
+    }
+    return table;
+}();
+
+static_assert(kTemporalRefines[size_t(TemporalOperator::AG)][size_t(TemporalOperator::EF)]);
+static_assert(kTemporalRefines[size_t(TemporalOperator::AU)][size_t(TemporalOperator::EU)]);
+static_assert(!kTemporalRefines[size_t(TemporalOperator::EG)][size_t(TemporalOperator::AF)]);
+static_assert(!kTemporalRefines[size_t(TemporalOperator::EU)][size_t(TemporalOperator::EW)]);
+
+// Verdicts of subformula pairs of earlier checks on this thread, by
+// interned node: the same subformulas recur across many properties
+struct NodePairHash {
+    size_t operator()(const std::pair<const CTLFormula*, const CTLFormula*>& key) const noexcept {
+        return std::hash<const void*>{}(key.first) * 31 + std::hash<const void*>{}(key.second);
+    }
+};
+thread_local std::unordered_map<std::pair<const CTLFormula*, const CTLFormula*>, bool, NodePairHash>
+    syntactic_verdicts;
+constexpr size_t kMaxSyntacticVerdicts = size_t(1) << 20;
+
+// Verdicts of compositional part pairs for the whole run, by interned node,
+// one map per semantic method: simulation, then each emptiness engine. The
+// parts get properties of their own, so each part builds one automaton
+constexpr size_t kCompositionalModes = static_cast<size_t>(EmptinessEngine::AUTO) + 2;
+struct CompositionalCache {
+    std::mutex mutex;
+    std::array<std::unordered_map<std::pair<const CTLFormula*, const CTLFormula*>, bool, NodePairHash>,
+               kCompositionalModes> verdicts;
+    std::unordered_map<const CTLFormula*, std::shared_ptr<CTLProperty>> parts;
+};
+CompositionalCache& compositionalCache() {
+    static CompositionalCache cache;
+    return cache;
+}
+
+// The operands of nested applications of op at the top of formula
+void collectOperands(const CTLFormulaPtr& formula, BinaryOperator op, std::vector<CTLFormulaPtr>& operands) {
+    if (formula->getType() == FormulaType::BINARY) {
+        const auto& binary = static_cast<const BinaryFormula&>(*formula);
+        if (binary.operator_ == op) {
+            collectOperands(binary.left, op, operands);
+            collectOperands(binary.right, op, operands);
+            return;
+        }
+    }
+    operands.push_back(formula);
+}
+
+} // namespace
+
 // Static cache initialization
 std::unordered_map<std::string, std::shared_ptr<CTLProperty>> CTLProperty::property_cache_;
 
@@ -13,15 +124,82 @@ CTLProperty::CTLProperty(const std::string& formula_str, bool encode_comparison)
     try {
         formula_ = Parser::parseFormula(formula_str);
         if (encode_comparison) formula_ = formula_utils::preprocessFormula(*formula_, true);
+        formula_ = FormulaFactory::instance().intern(formula_);
+        flat_ = FlatFormula(*formula_);
+        __classifyAtoms();
     } catch (const ParseException& e) {
         throw std::invalid_argument("Failed to parse formula '" + formula_str + "': " + e.what());
     }
 }
 
-CTLProperty::CTLProperty(CTLFormulaPtr formula) : formula_(std::move(formula)) {
+CTLProperty::CTLProperty(CTLFormulaPtr formula, bool encode_comparison) : formula_(std::move(formula)) {
     if (!formula_) {
         throw std::invalid_argument("Formula cannot be null");
     }
+    if (encode_comparison) formula_ = formula_utils::preprocessFormula(*formula_, true);
+    formula_ = FormulaFactory::instance().intern(formula_);
+    flat_ = FlatFormula(*formula_);
+    __classifyAtoms();
+}
+
+void CTLProperty::__classifyAtoms() {
+    // Polarities from the root down; children come before their parents, so
+    // a backward pass sees every parent of a node first. Negation and the
+    // left side of -> flip the polarity, the other operators (all temporal
+    // ones included) are monotone in their operands
+    const auto nodes = flat_.nodes();
+    constexpr uint8_t kBoth = kPositive | kNegative;
+    std::vector<uint8_t> polarity(nodes.size(), 0);
+    std::map<std::string, uint8_t> atoms;
+    if (!nodes.empty()) polarity[flat_.root()] = kPositive;
+    for (size_t k = nodes.size(); k-- > 0;) {
+        const auto& node = nodes[k];
+        const uint8_t here = polarity[k];
+        const uint8_t flipped = static_cast<uint8_t>(((here & kPositive) << 1) | ((here & kNegative) >> 1));
+        switch (node.type) {
+            case FormulaType::NEGATION:
+                polarity[node.first] |= flipped;
+                break;
+            case FormulaType::BINARY:
+                switch (node.binaryOp()) {
+                    case BinaryOperator::AND: case BinaryOperator::OR:
+                        polarity[node.first] |= here;
+                        break;
+                    case BinaryOperator::IMPLIES:
+                        polarity[node.first] |= flipped;
+                        break;
+                    default:
+                        polarity[node.first] |= kBoth;
+                        break;
+                }
+                polarity[node.second] |= node.binaryOp() == BinaryOperator::NONE ? kBoth : here;
+                break;
+            case FormulaType::TEMPORAL:
+                polarity[node.first] |= here;
+                if (node.second != FlatFormula::NONE) polarity[node.second] |= here;
+                break;
+            case FormulaType::ATOMIC:
+            case FormulaType::COMPARISON: {
+                AtomCollectorVisitor visitor;
+                node.source->accept(visitor);
+                const auto* atom = node.type == FormulaType::ATOMIC ? static_cast<const AtomicFormula*>(node.source)
+                                                                    : nullptr;
+                for (const auto& variable : visitor.getAtoms()) {
+                    if (isLiteralAtom(variable)) continue;
+                    atoms[variable] |= atom && atom->proposition == variable ? here : kBoth;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    grouping_atoms_.clear();
+    grouping_polarities_.clear();
+    for (const auto& [variable, occurs] : atoms) {
+        grouping_atoms_.push_back(variable);
+        grouping_polarities_.push_back(occurs);
+    }
 }
 
 // Factory methods with caching
@@ -42,12 +220,18 @@ std::shared_ptr<CTLProperty> CTLProperty::create(const std::string& formula_str,
 }
 
 std::shared_ptr<CTLProperty> CTLProperty::create(CTLFormulaPtr formula, bool verbose, bool encode_comparison) {
-    std::string formula_str = formula->toString();
-
-    return create(formula_str, verbose);
+    auto property = std::shared_ptr<CTLProperty>(new CTLProperty(std::move(formula), encode_comparison));
+    property->setVerbose(verbose);
+    return property;
 }
 
 void CTLProperty::clearStaticCaches() {
+    {
+        auto& cache = compositionalCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        for (auto& verdicts : cache.verdicts) verdicts.clear();
+        cache.parts.clear();
+    }
     // Clear the static property cache
     //property_cache_.clear();
     //
@@ -60,8 +244,11 @@ void CTLProperty::clearInstanceCaches() {
     // Clear refinement cache to break potential circular references
     refinement_cache_.clear();
     
-    // Reset automaton shared_ptr to break any circular references
+    // Reset automaton shared_ptr to break any circular references; this also
+    // frees the cached complement
+    automaton_ready_.store(nullptr, std::memory_order_relaxed);
     automaton_.reset();
+    AutomatonBudget::instance().forget(this);
     
     // Clear atomic propositions cache
     atomic_props_.clear();
@@ -71,25 +258,97 @@ void CTLProperty::clearInstanceCaches() {
 // Atomic propositions (cached)
 const std::unordered_set<std::string>& CTLProperty::getAtomicPropositions() const {
     if (!atomic_props_computed_) {
-        auto atoms = formula_utils::collectAtomicPropositions(*formula_);
-        atomic_props_ = std::unordered_set<std::string>(atoms.begin(), atoms.end());
+        atomic_props_ = flat_.atomicPropositions();
         atomic_props_computed_ = true;
     }
     return atomic_props_;
 }
 
 // ABTA (lazy initialization)
+CTLProperty::~CTLProperty() {
+    AutomatonBudget::instance().forget(this);
+}
+
 const CTLAutomaton& CTLProperty::automaton() const {
+    if (const CTLAutomaton* built = automaton_ready_.load(std::memory_order_acquire)) {
+        if (AutomatonBudget::instance().enabled()) AutomatonBudget::instance().touch(this);
+        return *built;
+    }
+    return *automatonHandle();
+}
 
-    if (!automaton_) {
-        automaton_ = std::make_shared<CTLAutomaton>(*formula_, verbose_);
+std::shared_ptr<const CTLAutomaton> CTLProperty::automatonHandle() const {
+    auto& budget = AutomatonBudget::instance();
+    size_t built_bytes = 0;
+    std::shared_ptr<const CTLAutomaton> handle;
+    {
+        std::lock_guard<std::mutex> lock(automaton_mutex_);
+        if (!automaton_) {
+            memory_utils::AllocationScope allocations;
+            automaton_ = AutomatonCache::instance().obtain(*formula_, verbose_);
+            if (subformula_store_) automaton_->useSubformulaStore(subformula_store_);
+            automaton_ready_.store(automaton_.get(), std::memory_order_release);
+            built_bytes = memory_utils::allocationCountersEnabled() ? allocations.retainedKB() * 1024
+                                                                    : automaton_->arenaBytes();
+        }
+        handle = automaton_;
+    }
+    // The budget is consulted outside automaton_mutex_: evicting takes the
+    // victims' locks
+    if (budget.enabled()) {
+        if (built_bytes) budget.admit(this, built_bytes);
+        else budget.touch(this);
     }
-    return *automaton_;
+    return handle;
 }
 
-bool CTLProperty::isEmpty() const {
-    automaton(); // Ensure ABTA is initialized
-    return automaton_->isEmpty();
+std::shared_ptr<const CTLAutomaton> CTLProperty::builtAutomaton() const {
+    std::lock_guard<std::mutex> lock(automaton_mutex_);
+    return automaton_;
+}
+
+void CTLProperty::setSubformulaStore(std::shared_ptr<SubformulaStore> store) {
+    std::lock_guard<std::mutex> lock(automaton_mutex_);
+    subformula_store_ = std::move(store);
+    if (automaton_) automaton_->useSubformulaStore(subformula_store_);
+}
+
+void CTLProperty::releaseAutomaton() const {
+    std::shared_ptr<CTLAutomaton> released;
+    {
+        std::lock_guard<std::mutex> lock(automaton_mutex_);
+        automaton_ready_.store(nullptr, std::memory_order_relaxed);
+        released = std::move(automaton_);
+    }
+    // Freed here, outside the lock, unless a handle still holds it
+}
+
+bool CTLProperty::isEmpty(WorkStealingPool* pool) const {
+    if (auto satisfiable = knownSatisfiable()) return !*satisfiable;
+    const bool empty = automatonHandle()->isEmpty(pool);
+    setSatisfiable(!empty);
+    return empty;
+}
+
+std::optional<bool> CTLProperty::knownSatisfiable() const {
+    const int8_t satisfiable = satisfiable_.load(std::memory_order_relaxed);
+    if (satisfiable < 0) return std::nullopt;
+    return satisfiable != 0;
+}
+
+bool CTLProperty::isValid(WorkStealingPool* pool) const {
+    if (auto valid = knownValid()) return *valid;
+    // The handle keeps the automaton, and so its complement, alive
+    const auto handle = automatonHandle();
+    const bool valid = handle->getComplement().isEmpty(pool);
+    setValid(valid);
+    return valid;
+}
+
+std::optional<bool> CTLProperty::knownValid() const {
+    const int8_t valid = valid_.load(std::memory_order_relaxed);
+    if (valid < 0) return std::nullopt;
+    return valid != 0;
 }
 
 bool CTLProperty::isEmpty(const ExternalCTLSATInterface& sat_interface) const {
@@ -103,7 +362,9 @@ void CTLProperty::simplify() const {
 }
 
 // Refinement checking
-bool CTLProperty::refines(const CTLProperty& other, bool use_syntactic, bool use_full_inclusion) const {
+bool CTLProperty::refines(const CTLProperty& other, bool use_syntactic, bool use_full_inclusion,
+                          EmptinessEngine engine, const CancellationToken* token, bool compositional) const {
+    CancellationScope scope(token);
     // Check cache first
     //auto shared_other = std::shared_ptr<CTLProperty>(const_cast<CTLProperty*>(&other), [](CTLProperty*){});
     //auto cache_it = refinement_cache_.find(shared_other);
@@ -123,18 +384,173 @@ bool CTLProperty::refines(const CTLProperty& other, bool use_syntactic, bool use
     }
     
     // Always do semantic check if syntactic doesn't succeed or isn't used
-    result = refinesSemantic(other, use_full_inclusion);
+    result = compositional ? __refinesComposed(other, use_syntactic, use_full_inclusion, engine)
+                           : refinesSemantic(other, use_full_inclusion, engine);
     
     // Cache the result
     //refinement_cache_[shared_other] = result;
     return result;
 }
 
+// Private syntactic refinement implementation. Runs over node ids of the two
+// flat formulas; a subformula pair shared by several branches is decided once,
+// and pairs of interned compound nodes once per thread. Each pair of node
+// types has its rule in a dense table, so a step is one indexed call.
+struct CTLProperty::SyntacticCheck {
+    using NodeId = FlatFormula::NodeId;
+    using Rule = bool (SyntacticCheck::*)(NodeId, NodeId);
+    const FlatFormula& f1;
+    const FlatFormula& f2;
+    std::vector<int8_t> memo;  // by i * |f2| + j: -1 unknown, else the result
+    std::unique_ptr<SyntacticCheck> reverse;  // f2 against f1, for contrapositives
+
+    SyntacticCheck(const FlatFormula& a, const FlatFormula& b)
+        : f1(a), f2(b), memo(a.size() * b.size(), -1) {}
+
+    bool check(NodeId i, NodeId j) {
+        int8_t& slot = memo[size_t(i) * f2.size() + j];
+        if (slot < 0) slot = __shared(i, j);
+        return slot;
+    }
+
+    bool __shared(NodeId i, NodeId j) {
+        const auto& n1 = f1[i];
+        const auto& n2 = f2[j];
+        if (n1.source == n2.source || n1.source->equals(*n2.source)) return true;
+        if (n1.isLeaf() || n2.isLeaf() || !n1.source->isInterned() || !n2.source->isInterned()) {
+            return __dispatch(i, j);
+        }
+        const std::pair key{n1.source, n2.source};
+        if (auto it = syntactic_verdicts.find(key); it != syntactic_verdicts.end()) return it->second;
+        const bool result = __dispatch(i, j);
+        if (syntactic_verdicts.size() >= kMaxSyntacticVerdicts) syntactic_verdicts.clear();
+        syntactic_verdicts.emplace(key, result);
+        return result;
+    }
+
+    bool __dispatch(NodeId i, NodeId j) {
+        return (this->*kRules[size_t(f1[i].type)][size_t(f2[j].type)])(i, j);
+    }
+
+    bool __never(NodeId, NodeId) { return false; }
+
+    // false refines everything, everything refines true
+    bool __literal(NodeId i, NodeId j) {
+        auto value = [](const FlatFormula::Node& n) -> int {
+            if (n.type != FormulaType::BOOLEAN_LITERAL) return -1;
+            return static_cast<const BooleanLiteral*>(n.source)->value;
+        };
+        return value(f1[i]) == 0 || value(f2[j]) == 1;
+    }
+
+    // ¬φ ⊑ ¬ψ iff ψ ⊑ φ (contrapositive)
+    bool __negations(NodeId i, NodeId j) {
+        if (!reverse) reverse = std::make_unique<SyntacticCheck>(f2, f1);
+        return reverse->check(f2[j].first, f1[i].first);
+    }
+
+    // Decompose the refined side
+    bool __right(NodeId i, NodeId j) {
+        const auto& n2 = f2[j];
+        switch (n2.binaryOp()) {
+            case BinaryOperator::AND:
+                // f1 ⊑ (f2_left ∧ f2_right) iff f1 ⊑ f2_left and f1 ⊑ f2_right
+                return check(i, n2.first) && check(i, n2.second);
+            case BinaryOperator::OR:
+                // f1 ⊑ (f2_left ∨ f2_right) if f1 ⊑ f2_left or f1 ⊑ f2_right
+                return check(i, n2.first) || check(i, n2.second);
+            default:
+                // f1 ⊑ (f2_left → f2_right) is more complex, handle conservatively
+                return false;
+        }
+    }
+
+    // Decompose the refining side
+    bool __left(NodeId i, NodeId j) {
+        const auto& n1 = f1[i];
+        const auto& n2 = f2[j];
+        switch (n1.binaryOp()) {
+            case BinaryOperator::AND:
+                // (φ ∧ ψ) ⊑ χ if φ ⊑ χ or ψ ⊑ χ
+                return check(n1.first, j) || check(n1.second, j);
+            case BinaryOperator::OR:
+                // (φ ∨ ψ) ⊑ χ iff φ ⊑ χ and ψ ⊑ χ
+                return check(n1.first, j) && check(n1.second, j);
+            case BinaryOperator::IMPLIES:
+                // (φ → ψ) ⊑ (χ → δ) if φ = χ and ψ ⊑ δ
+                if (n2.type == FormulaType::BINARY && n2.binaryOp() == BinaryOperator::IMPLIES &&
+                    f1[n1.first].source->equals(*f2[n2.first].source)) {
+                    return check(n1.second, n2.second);
+                }
+                return false;
+            default:
+                return false;
+        }
+    }
+
+    bool __binaries(NodeId i, NodeId j) { return __left(i, j) || __right(i, j); }
+    bool __leftOrLiteral(NodeId i, NodeId j) { return __literal(i, j) || __left(i, j); }
+    bool __rightOrLiteral(NodeId i, NodeId j) { return __literal(i, j) || __right(i, j); }
+
+    bool __temporals(NodeId i, NodeId j) {
+        const auto& n1 = f1[i];
+        const auto& n2 = f2[j];
+        // Check if the temporal operators are in refinement order
+        if (!kTemporalRefines[n1.op][n2.op]) return false;
+
+        // Check time intervals: G is stronger over a longer one, F over a
+        // shorter one; the others need the same interval
+        const TimeInterval& interval1 = static_cast<const TemporalFormula*>(n1.source)->interval;
+        const TimeInterval& interval2 = static_cast<const TemporalFormula*>(n2.source)->interval;
+        switch (modality(n2.temporalOp())) {
+            case Modality::G:
+                if (!intervalSubsumes(interval2, interval1)) return false;
+                break;
+            case Modality::F:
+                if (!intervalSubsumes(interval1, interval2)) return false;
+                break;
+            default:
+                if (interval1 != interval2) return false;
+                break;
+        }
+
+        // Operators in order have the same arity. Every one is monotone in
+        // its operands: E[φ U ψ] ⊑ E[χ U δ] if φ ⊑ χ and ψ ⊑ δ
+        if (!check(n1.first, n2.first)) return false;
+        return n1.second == FlatFormula::NONE || check(n1.second, n2.second);
+    }
+
+    static constexpr size_t kTypes = static_cast<size_t>(FormulaType::TEMPORAL) + 1;
+    // kRules[refining type][refined type], in FormulaType order: ATOMIC,
+    // COMPARISON, BOOLEAN_LITERAL, NEGATION, BINARY, TEMPORAL
+    static constexpr std::array<std::array<Rule, kTypes>, kTypes> kRules = [] {
+        std::array<std::array<Rule, kTypes>, kTypes> rules{};
+        for (auto& row : rules) row.fill(&SyntacticCheck::__never);
+        const size_t literal = size_t(FormulaType::BOOLEAN_LITERAL);
+        const size_t negation = size_t(FormulaType::NEGATION);
+        const size_t binary = size_t(FormulaType::BINARY);
+        const size_t temporal = size_t(FormulaType::TEMPORAL);
+        for (size_t t = 0; t < kTypes; ++t) {
+            rules[t][binary] = &SyntacticCheck::__right;
+            rules[binary][t] = &SyntacticCheck::__left;
+            rules[literal][t] = &SyntacticCheck::__literal;
+            rules[t][literal] = &SyntacticCheck::__literal;
+        }
+        rules[literal][binary] = &SyntacticCheck::__rightOrLiteral;
+        rules[binary][literal] = &SyntacticCheck::__leftOrLiteral;
+        rules[binary][binary] = &SyntacticCheck::__binaries;
+        rules[negation][negation] = &SyntacticCheck::__negations;
+        rules[temporal][temporal] = &SyntacticCheck::__temporals;
+        return rules;
+    }();
+};
+
 bool CTLProperty::refinesSyntactic(const CTLProperty& other) const {
-    return refinementCheck(*formula_, *other.formula_);
+    return SyntacticCheck(flat_, other.flat_).check(flat_.root(), other.flat_.root());
 }
 
-bool CTLProperty::refinesSemantic(const CTLProperty& other, bool use_full_inclusion) const {
+bool CTLProperty::refinesSemantic(const CTLProperty& other, bool use_full_inclusion,
+                                  EmptinessEngine engine) const {
     // Use ABTA language inclusion check
     // self.refines(other) iff L(self) ⊆ L(other)
    
@@ -145,153 +561,69 @@ bool CTLProperty::refinesSemantic(const CTLProperty& other, bool use_full_inclus
         //std::cout << "Checking language inclusion L(this) ⊆ L(other).\n";
         //std::cout << "This property formula: " << this->toString() << "\n";
         //std::cout << "Other property formula: " << other.toString() << "\n";
-        if (verbose_) {
-            std::cout << "Checking if " << this->toString() << " ⊆ " << other.toString() << "\n";
-        }
-        return other.automaton().languageIncludes(automaton());
+        CTL_LOG(DEBUG, verbose_, "Checking if " << this->toString() << " ⊆ " << other.toString());
+        return other.automatonHandle()->languageIncludes(*automatonHandle(), engine);
         
     }
     else
     {
-        const CTLAutomaton& this_abta = automaton();
-        const CTLAutomaton& other_abta = other.automaton();
-        return  other_abta.simulates(this_abta);
+        auto this_abta = automatonHandle();
+        auto other_abta = other.automatonHandle();
+        return  other_abta->simulates(*this_abta);
     }
 }
 
-// Equality and hashing
-bool CTLProperty::equals(const CTLProperty& other) const {
-    return formula_->equals(*other.formula_);
-}
-
-size_t CTLProperty::hash() const {
-    return formula_->hash();
-}
+bool CTLProperty::__refinesComposed(const CTLProperty& other, bool use_syntactic, bool use_full_inclusion,
+                                    EmptinessEngine engine) const {
+    std::vector<CTLFormulaPtr> premises, conclusions;
+    collectOperands(formula_, BinaryOperator::OR, premises);
+    collectOperands(other.formula_, BinaryOperator::AND, conclusions);
+    if (premises.size() == 1 && conclusions.size() == 1) return refinesSemantic(other, use_full_inclusion, engine);
 
-// Private syntactic refinement implementation
-bool CTLProperty::refinementCheck(const CTLFormula& f1, const CTLFormula& f2) const {
-    // Structural equality check first
-    if (f1.equals(f2)) {
-        return true;
-    }
-    
-    // Dispatch based on formula types
-    if (f1.isAtomic() && f2.isAtomic()) {
-        return refinementCheckAtomic(f1, f2);
-    }
-    
-    // Handle negation
-    if (auto neg1 = dynamic_cast<const NegationFormula*>(&f1)) {
-        return refinementCheckNegation(*neg1, f2);
-    }
-    
-    // Handle binary operators
-    if (auto bin1 = dynamic_cast<const BinaryFormula*>(&f1)) {
-        return refinementCheckBinary(*bin1, f2);
-    }
-    
-    // Handle temporal operators
-    if (auto temp1 = dynamic_cast<const TemporalFormula*>(&f1)) {
-        return refinementCheckTemporal(*temp1, f2);
+    // Inclusion is exact, so a failed part refutes the pair. Simulation is
+    // not: a part it misses may still be proven on the whole pair
+    auto failed = [&] { return use_full_inclusion ? false : refinesSemantic(other, use_full_inclusion, engine); };
+    auto& cache = compositionalCache();
+    auto& verdicts = cache.verdicts[use_full_inclusion ? 1 + static_cast<size_t>(engine) : 0];
+    // Pairs earlier checks decided come first: one known failure settles it
+    std::vector<std::pair<const CTLProperty*, const CTLProperty*>> open;
+    bool known_failure = false;
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto part = [&cache](const CTLFormulaPtr& formula) {
+            auto& property = cache.parts[formula.get()];
+            if (!property) property = std::make_shared<CTLProperty>(formula);
+            return property.get();
+        };
+        for (const auto& premise : premises) {
+            for (const auto& conclusion : conclusions) {
+                if (premise == conclusion) continue;
+                auto it = verdicts.find({premise.get(), conclusion.get()});
+                if (it == verdicts.end()) open.emplace_back(part(premise), part(conclusion));
+                else known_failure = known_failure || !it->second;
+            }
+        }
     }
-    
-    // Handle cases where f2 is a binary operator
-    if (auto bin2 = dynamic_cast<const BinaryFormula*>(&f2)) {
-        switch (bin2->operator_) {
-            case BinaryOperator::AND:
-                // f1 ⊑ (f2_left ∧ f2_right) iff f1 ⊑ f2_left and f1 ⊑ f2_right
-                return refinementCheck(f1, *bin2->left) && refinementCheck(f1, *bin2->right);
-                
-            case BinaryOperator::OR:
-                // f1 ⊑ (f2_left ∨ f2_right) iff f1 ⊑ f2_left or f1 ⊑ f2_right
-                return refinementCheck(f1, *bin2->left) || refinementCheck(f1, *bin2->right);
-                
-            case BinaryOperator::IMPLIES:
-                // f1 ⊑ (f2_left → f2_right) is more complex, handle conservatively
-                return false;
+    if (known_failure) return failed();
+    for (const auto& [premise, conclusion] : open) {
+        const bool holds = (use_syntactic && premise->refinesSyntactic(*conclusion)) ||
+                           premise->refinesSemantic(*conclusion, use_full_inclusion, engine);
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            verdicts.emplace(std::pair{premise->formula_.get(), conclusion->formula_.get()}, holds);
         }
+        if (!holds) return failed();
     }
-    
-    return false;
-}
-
-bool CTLProperty::refinementCheckAtomic(const CTLFormula& f1, const CTLFormula& f2) const {
-    // Atomic formulas refine each other only if they are identical
-    return f1.equals(f2);
+    return true;
 }
 
-bool CTLProperty::refinementCheckNegation(const NegationFormula& f1, const CTLFormula& f2) const {
-    // ¬φ ⊑ ψ is handled by contrapositive in some cases
-    if (auto neg2 = dynamic_cast<const NegationFormula*>(&f2)) {
-        // ¬φ ⊑ ¬ψ iff ψ ⊑ φ (contrapositive)
-        return refinementCheck(*neg2->operand, *f1.operand);
-    }
-    
-    return false; // Conservative approach
-}
-
-bool CTLProperty::refinementCheckBinary(const BinaryFormula& f1, const CTLFormula& f2) const {
-    switch (f1.operator_) {
-        case BinaryOperator::AND:
-            // (φ ∧ ψ) ⊑ χ iff φ ⊑ χ or ψ ⊑ χ
-            return refinementCheck(*f1.left, f2) || refinementCheck(*f1.right, f2);
-            
-        case BinaryOperator::OR:
-            // (φ ∨ ψ) ⊑ χ iff φ ⊑ χ and ψ ⊑ χ
-            return refinementCheck(*f1.left, f2) && refinementCheck(*f1.right, f2);
-            
-        case BinaryOperator::IMPLIES:
-            // Handle implication specially
-            if (auto bin2 = dynamic_cast<const BinaryFormula*>(&f2)) {
-                if (bin2->operator_ == BinaryOperator::IMPLIES) {
-                    // (φ → ψ) ⊑ (χ → δ) if φ = χ and ψ ⊑ δ
-                    if (f1.left->equals(*bin2->left)) {
-                        return refinementCheck(*f1.right, *bin2->right);
-                    }
-                }
-            }
-            return false;
-    }
-    
-    return false;
+// Equality and hashing
+bool CTLProperty::equals(const CTLProperty& other) const {
+    return formula_->equals(*other.formula_);
 }
 
-bool CTLProperty::refinementCheckTemporal(const TemporalFormula& f1, const CTLFormula& f2) const {
-    auto temp2 = dynamic_cast<const TemporalFormula*>(&f2);
-    if (!temp2) {
-        return false;
-    }
-    
-    // Check if the temporal operators are in refinement order
-    if (!temporalOperatorRefines(f1.operator_, temp2->operator_)) {
-        return false;
-    }
-    
-    // Check time intervals
-    if (!intervalSubsumes(f1.interval, temp2->interval)) {
-        return false;
-    }
-    
-    // Check operands based on operator type
-    if (f1.second_operand && temp2->second_operand) {
-        // Binary temporal operators (EU, AU, etc.)
-        if (f1.operator_ == temp2->operator_) {
-            switch (f1.operator_) {
-                case TemporalOperator::EU:
-                case TemporalOperator::AU:
-                    // E[φ U ψ] ⊑ E[χ U δ] iff φ ⊑ χ and ψ ⊑ δ
-                    return refinementCheck(*f1.operand, *temp2->operand) && 
-                           refinementCheck(*f1.second_operand, *temp2->second_operand);
-                default:
-                    break;
-            }
-        }
-    } else if (!f1.second_operand && !temp2->second_operand) {
-        // Unary temporal operators
-        return refinementCheck(*f1.operand, *temp2->operand);
-    }
-    
-    return false;
+size_t CTLProperty::hash() const {
+    return formula_->hash();
 }
 
 // Helper methods
@@ -299,31 +631,4 @@ bool CTLProperty::intervalSubsumes(const TimeInterval& inner, const TimeInterval
     return outer.subsumes(inner);
 }
 
-bool CTLProperty::temporalOperatorRefines(TemporalOperator op1, TemporalOperator op2) {
-    // Define refinement relationships between temporal operators
-    // Based on the lattice: AG ⊑ AF ⊑ EF and AG ⊑ EG ⊑ EF
-    
-    if (op1 == op2) {
-        return true;
-    }
-    
-    switch (op1) {
-        case TemporalOperator::AG:
-            return op2 == TemporalOperator::AF || op2 == TemporalOperator::EG || 
-                   op2 == TemporalOperator::EF;
-            
-        case TemporalOperator::AF:
-            return op2 == TemporalOperator::EF;
-            
-        case TemporalOperator::EG:
-            return op2 == TemporalOperator::EF;
-            
-        case TemporalOperator::EF:
-            return false; // EF is the top of the lattice
-            
-        default:
-            return false; // Conservative for other operators
-    }
-}
-
 } // namespace ctl
\ No newline at end of file
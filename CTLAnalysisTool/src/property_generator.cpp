@@ -170,25 +170,26 @@ std::string PropertyGenerator::generateTemporal(size_t class_id, size_t depth) c
 }
 
 std::shared_ptr<CTLProperty> PropertyGenerator::refineProperty(const CTLProperty& base_property, size_t class_id) const {
-    std::string base_formula = base_property.toString();
-    
-    // Different refinement strategies
+    // Different refinement strategies; each yields a conjunct for the base
+    // formula, whose AST is reused rather than printed and parsed again
     std::vector<std::function<std::string()>> strategies;
     
-    strategies.push_back([this, &base_formula, class_id]() { 
-        return strengthenFormula(base_formula, class_id); 
+    strategies.push_back([this, class_id]() { 
+        return generateUnary(class_id, 0);  // strengthen by a conjunct
     });
-    strategies.push_back([this, &base_formula, class_id]() { 
-        return addConjunct(base_formula, class_id); 
+    strategies.push_back([this, class_id]() { 
+        return generateUnary(class_id, 0);  // add a conjunct
     });
-    strategies.push_back([this, &base_formula, class_id]() { 
-        return strengthenTemporal(base_formula, class_id); 
+    strategies.push_back([this, class_id]() { 
+        return generateUnary(class_id, 0);  // strengthen temporally: for now a conjunct
     });
     
-    std::string refined_formula = randomChoice(strategies)();
+    std::string conjunct = randomChoice(strategies)();
     
     try {
-        return CTLProperty::create(refined_formula);
+        auto refined = std::make_shared<BinaryFormula>(base_property.getFormulaPtr(), BinaryOperator::AND,
+                                                       Parser::parseFormula(conjunct));
+        return CTLProperty::create(refined);
     } catch (const std::exception&) {
         // If parsing fails, return the original property
         return std::make_shared<CTLProperty>(base_property.getFormulaPtr());
@@ -0,0 +1,155 @@
+#include "refinement_cache.h"
+#include "utils.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ctl {
+
+namespace {
+
+// Holds an flock() on the log file for the lifetime of the guard
+class FileLock {
+public:
+    FileLock(const std::string& path, int operation) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ >= 0) ::flock(fd_, operation);
+    }
+    ~FileLock() {
+        if (fd_ >= 0) {
+            ::flock(fd_, LOCK_UN);
+            ::close(fd_);
+        }
+    }
+    bool ok() const { return fd_ >= 0; }
+private:
+    int fd_ = -1;
+};
+
+} // namespace
+
+RefinementCache::RefinementCache(const std::string& directory)
+    : directory_(directory), log_path_(directory + "/verdicts.tsv") {
+    if (!pathExists(directory_) && !createDirectory(directory_)) {
+        throw std::runtime_error("Failed to create refinement cache directory: " + directory_);
+    }
+    if (!isDirectory(directory_)) {
+        throw std::runtime_error("Refinement cache path is not a directory: " + directory_);
+    }
+    __load();
+}
+
+RefinementCache::~RefinementCache() {
+    try {
+        flush();
+    } catch (...) {
+        // Losing cached verdicts only costs recomputation on the next run
+    }
+}
+
+std::string RefinementCache::__key(char kind, const std::string& mode,
+                                   const std::string& first, const std::string& second) {
+    std::string key;
+    key.reserve(mode.size() + first.size() + second.size() + 4);
+    key += kind;
+    key += '\t';
+    key += mode;
+    key += '\t';
+    key += first;
+    key += '\t';
+    key += second;
+    return key;
+}
+
+void RefinementCache::__load() {
+    FileLock lock(log_path_, LOCK_SH);
+    std::ifstream in(log_path_);
+    std::string line;
+    std::lock_guard<std::mutex> guard(mutex_);
+    while (std::getline(in, line)) {
+        // <kind>\t<mode>\t<first>\t<second>\t<0|1>; a torn last line has no verdict
+        size_t tab = line.find_last_of('\t');
+        if (tab == std::string::npos || tab + 2 != line.size()) continue;
+        char verdict = line.back();
+        if (verdict != '0' && verdict != '1') continue;
+        verdicts_[line.substr(0, tab)] = (verdict == '1');
+    }
+}
+
+void RefinementCache::flush() {
+    std::vector<std::pair<std::string, bool>> pending;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        pending.swap(pending_);
+    }
+    if (pending.empty()) return;
+
+    FileLock lock(log_path_, LOCK_EX);
+    if (!lock.ok()) {
+        throw std::runtime_error("Failed to open refinement cache log: " + log_path_);
+    }
+    // Terminate a line torn by an interrupted writer so our first entry stays intact
+    bool needs_newline = false;
+    {
+        std::ifstream in(log_path_, std::ios::binary | std::ios::ate);
+        if (in && in.tellg() > 0) {
+            in.seekg(-1, std::ios::end);
+            needs_newline = in.get() != '\n';
+        }
+    }
+    std::ofstream out(log_path_, std::ios::app);
+    if (needs_newline) out << '\n';
+    for (const auto& [key, verdict] : pending) {
+        out << key << '\t' << (verdict ? '1' : '0') << '\n';
+    }
+    out.flush();
+}
+
+std::optional<bool> RefinementCache::__lookup(const std::string& key) const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = verdicts_.find(key);
+    if (it == verdicts_.end()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return it->second;
+}
+
+void RefinementCache::__store(std::string key, bool verdict) {
+    // Entries are single lines, formulas that would break that are not cached
+    if (key.find('\n') != std::string::npos) return;
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto [it, inserted] = verdicts_.emplace(key, verdict);
+    if (!inserted && it->second == verdict) return;
+    it->second = verdict;
+    pending_.emplace_back(std::move(key), verdict);
+}
+
+std::optional<bool> RefinementCache::lookupRefinement(const std::string& mode, const std::string& refining,
+                                                      const std::string& refined) const {
+    return __lookup(__key('R', mode, refining, refined));
+}
+
+void RefinementCache::storeRefinement(const std::string& mode, const std::string& refining,
+                                      const std::string& refined, bool refines) {
+    __store(__key('R', mode, refining, refined), refines);
+}
+
+std::optional<bool> RefinementCache::lookupSatisfiable(const std::string& mode, const std::string& formula) const {
+    return __lookup(__key('S', mode, formula));
+}
+
+void RefinementCache::storeSatisfiable(const std::string& mode, const std::string& formula, bool satisfiable) {
+    __store(__key('S', mode, formula), satisfiable);
+}
+
+size_t RefinementCache::size() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return verdicts_.size();
+}
+
+} // namespace ctl
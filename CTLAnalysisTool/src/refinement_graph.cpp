@@ -1,5 +1,7 @@
 
 #include "refinement_graph.h"
+#include "scc.h"
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -15,34 +17,157 @@ namespace ctl {
 // RefinementGraph implementation
 void RefinementGraph::addNode(std::shared_ptr<CTLProperty> property) {
     nodes_.push_back(std::move(property));
-    adjacency_.resize(nodes_.size()); // Maintain adjacency_ matrix size
+    reduction_valid_ = false;
+}
+
+void RefinementGraph::__growEdgeBits() {
+    BitMatrix bits(nodes_.size(), nodes_.size());
+    for (size_t from = 0; from < edge_bits_.rows(); ++from) {
+        edge_bits_.forEachInRow(from, [&](size_t to) { bits.set(from, to); });
+    }
+    edge_bits_ = std::move(bits);
 }
 
 void RefinementGraph::addEdge(size_t from, size_t to) {
     if (from >= nodes_.size() || to >= nodes_.size()) {
         throw std::out_of_range("Edge indices out of range");
     }
-    
-    edges_.emplace_back(from, to);
-    adjacency_list_[from].push_back(to);
-    adjacency_[from].push_back(to); // Also maintain adjacency_ for optimization access
+    if (edge_bits_.rows() != nodes_.size()) __growEdgeBits();
+    if (edge_bits_.test(from, to)) return;
+
+    edge_bits_.set(from, to);
+    ++edge_count_;
+    reduction_valid_ = false;
 }
 
 bool RefinementGraph::hasEdge(size_t from, size_t to) const {
     if (from >= nodes_.size() || to >= nodes_.size()) {
         return false;
     }
-    
-    // Check in adjacency_ matrix (more efficient for transitive closure)
-    if (from < adjacency_.size()) {
-        const auto& adj = adjacency_[from];
-        return std::find(adj.begin(), adj.end(), to) != adj.end();
+    // Nodes without a row yet have no edges
+    return from < edge_bits_.rows() && to < edge_bits_.cols() && edge_bits_.test(from, to);
+}
+
+bool RefinementGraph::hasPath(size_t from, size_t to) const {
+    if (from >= nodes_.size() || to >= nodes_.size()) {
+        return false;
     }
-    
-    return false;
+    if (!reduction_valid_) __reduce();
+    return closure_.test(from, to);
+}
+
+std::vector<RefinementGraph::Edge> RefinementGraph::getRecordedEdges() const {
+    std::vector<Edge> edges;
+    edges.reserve(edge_count_);
+    for (size_t from = 0; from < edge_bits_.rows(); ++from) {
+        edge_bits_.forEachInRow(from, [&](size_t to) { edges.emplace_back(from, to); });
+    }
+    return edges;
+}
+
+void RefinementGraph::__reduce() const {
+    const size_t n = nodes_.size();
+    closure_ = BitMatrix(n, n);
+    for (size_t from = 0; from < edge_bits_.rows(); ++from) {
+        edge_bits_.forEachInRow(from, [&](size_t to) { closure_.set(from, to); });
+    }
+    // Warshall a row at a time; with the transitive optimization the recorded
+    // edges are closed already and nothing changes
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t i = 0; i < n; ++i) {
+            if (i != k && closure_.test(i, k)) closure_.orRow(i, k);
+        }
+    }
+
+    // Mutually refining nodes form one component, led by its lowest index
+    std::vector<size_t> leader(n);
+    std::vector<std::vector<size_t>> members(n);
+    for (size_t i = 0; i < n; ++i) {
+        leader[i] = i;
+        for (size_t j = 0; j < i; ++j) {
+            if (leader[j] == j && closure_.test(i, j) && closure_.test(j, i)) {
+                leader[i] = j;
+                break;
+            }
+        }
+        members[leader[i]].push_back(i);
+    }
+
+    edges_.clear();
+    adjacency_list_.clear();
+    auto add = [this](size_t from, size_t to) {
+        edges_.emplace_back(from, to);
+        adjacency_list_[from].push_back(to);
+    };
+    for (size_t l = 0; l < n; ++l) {
+        const auto& ring = members[l];
+        if (ring.size() > 1) {
+            for (size_t k = 0; k < ring.size(); ++k) add(ring[k], ring[(k + 1) % ring.size()]);
+        }
+    }
+
+    // below(l): the nodes strictly below the component of l
+    BitMatrix below(n, n);
+    for (size_t l = 0; l < n; ++l) {
+        if (leader[l] != l) continue;
+        std::copy(closure_.rowData(l), closure_.rowData(l) + closure_.wordsPerRow(), below.rowData(l));
+        for (size_t m : members[l]) below.reset(l, m);
+    }
+    // A component covers those below it that are not below another one it reaches
+    std::vector<uint64_t> implied(below.wordsPerRow());
+    for (size_t l = 0; l < n; ++l) {
+        if (leader[l] != l) continue;
+        std::fill(implied.begin(), implied.end(), 0);
+        below.forEachInRow(l, [&](size_t c) {
+            if (leader[c] != c) return;
+            const uint64_t* row = below.rowData(c);
+            for (size_t w = 0; w < implied.size(); ++w) implied[w] |= row[w];
+        });
+        below.forEachInRow(l, [&](size_t c) {
+            if (leader[c] == c && !((implied[c >> 6] >> (c & 63)) & 1u)) add(l, c);
+        });
+    }
+    reduction_valid_ = true;
+}
+
+void RefinementGraph::__removeNode(size_t index) {
+    auto shifted = [index](size_t i) { return i > index ? i - 1 : i; };
+    BitMatrix bits(nodes_.size() - 1, nodes_.size() - 1);
+    edge_count_ = 0;
+    for (size_t from = 0; from < edge_bits_.rows(); ++from) {
+        if (from == index) continue;
+        edge_bits_.forEachInRow(from, [&](size_t to) {
+            if (to == index) return;
+            bits.set(shifted(from), shifted(to));
+            ++edge_count_;
+        });
+    }
+    edge_bits_ = std::move(bits);
+
+    std::vector<Edge> unknown;
+    for (const auto& edge : unknown_edges_) {
+        if (edge.from != index && edge.to != index) unknown.emplace_back(shifted(edge.from), shifted(edge.to));
+    }
+    unknown_edges_ = std::move(unknown);
+    nodes_.erase(nodes_.begin() + index);
+    reduction_valid_ = false;
+}
+
+void RefinementGraph::addUnknownEdge(size_t from, size_t to) {
+    if (from >= nodes_.size() || to >= nodes_.size()) {
+        throw std::out_of_range("Edge indices out of range");
+    }
+    if (isUnknown(from, to)) return;
+    unknown_edges_.emplace_back(from, to);
+}
+
+bool RefinementGraph::isUnknown(size_t from, size_t to) const {
+    return std::any_of(unknown_edges_.begin(), unknown_edges_.end(),
+                       [from, to](const Edge& edge) { return edge.from == from && edge.to == to; });
 }
 
 std::vector<size_t> RefinementGraph::topologicalSort() const {
+    if (!reduction_valid_) __reduce();
     std::vector<size_t> in_degree(nodes_.size(), 0);
     std::vector<size_t> result;
     std::queue<size_t> queue;
@@ -80,65 +205,31 @@ std::vector<size_t> RefinementGraph::topologicalSort() const {
 }
 
 std::vector<std::vector<size_t>> RefinementGraph::findStronglyConnectedComponents() const {
-    // Tarjan's algorithm for finding strongly connected components
-    std::vector<std::vector<size_t>> sccs;
-    std::vector<int> index(nodes_.size(), -1);
-    std::vector<int> lowlink(nodes_.size(), -1);
-    std::vector<bool> on_stack(nodes_.size(), false);
-    std::stack<size_t> stack;
-    int current_index = 0;
-    
-    // Helper function for DFS
-    std::function<void(size_t)> strongconnect = [&](size_t v) {
-        index[v] = current_index;
-        lowlink[v] = current_index;
-        current_index++;
-        stack.push(v);
-        on_stack[v] = true;
-        
-        // Consider successors of v
+    if (!reduction_valid_) __reduce();
+    // Successor lists in CSR form for the shared Tarjan routine
+    std::vector<uint32_t> offsets(nodes_.size() + 1, 0);
+    std::vector<uint32_t> targets;
+    targets.reserve(edges_.size());
+    for (size_t v = 0; v < nodes_.size(); ++v) {
         auto it = adjacency_list_.find(v);
         if (it != adjacency_list_.end()) {
-            for (size_t w : it->second) {
-                if (index[w] == -1) {
-                    // Successor w has not yet been visited; recurse on it
-                    strongconnect(w);
-                    lowlink[v] = std::min(lowlink[v], lowlink[w]);
-                } else if (on_stack[w]) {
-                    // Successor w is in stack S and hence in the current SCC
-                    lowlink[v] = std::min(lowlink[v], index[w]);
-                }
-            }
-        }
-        
-        // If v is a root node, pop the stack and generate an SCC
-        if (lowlink[v] == index[v]) {
-            std::vector<size_t> scc;
-            size_t w;
-            do {
-                w = stack.top();
-                stack.pop();
-                on_stack[w] = false;
-                scc.push_back(w);
-            } while (w != v);
-            sccs.push_back(scc);
-        }
-    };
-    
-    // Call the recursive helper function for all vertices
-    for (size_t v = 0; v < nodes_.size(); ++v) {
-        if (index[v] == -1) {
-            strongconnect(v);
+            for (size_t w : it->second) targets.push_back(static_cast<uint32_t>(w));
         }
+        offsets[v + 1] = static_cast<uint32_t>(targets.size());
+    }
+    const SCCDecomposition components = stronglyConnectedComponents(CSRGraphView<uint32_t>{offsets, targets});
+
+    std::vector<std::vector<size_t>> sccs(components.size());
+    for (size_t c = 0; c < components.size(); ++c) {
+        sccs[c].assign(components[c].begin(), components[c].end());
     }
-    
     return sccs;
 }
 
 double RefinementGraph::getDensity() const {
     size_t n = nodes_.size();
     if (n <= 1) return 0.0;
-    return static_cast<double>(edges_.size()) / (n * (n - 1));
+    return static_cast<double>(edge_count_) / (n * (n - 1));
 }
 
 void RefinementGraph::toDot(const std::string& filename, const std::string& title) const {
@@ -173,10 +264,13 @@ void RefinementGraph::toDot(const std::string& filename, const std::string& titl
     
     file << "\n";
     
-    // Add edges
-    for (const auto& edge : edges_) {
+    // Add edges; implied refinements follow from the drawn paths
+    for (const auto& edge : getEdges()) {
         file << "  n" << edge.from << " -> n" << edge.to << ";\n";
     }
+    for (const auto& edge : unknown_edges_) {
+        file << "  n" << edge.from << " -> n" << edge.to << " [style=dashed, color=gray, label=\"?\"];\n";
+    }
     
     file << "}\n";
     file.close();
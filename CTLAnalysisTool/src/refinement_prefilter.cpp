@@ -0,0 +1,361 @@
+#include "refinement_prefilter.h"
+
+#include <cctype>
+#include <mutex>
+
+namespace ctl {
+
+namespace {
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+bool isIdentifier(const std::string& s) {
+    if (s.empty() || !(std::isalpha(static_cast<unsigned char>(s[0])) || s[0] == '_')) return false;
+    for (char c : s) {
+        if (!(std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.')) return false;
+    }
+    return true;
+}
+
+using ModelWords = std::array<uint64_t, RefinementPrefilter::kModelWords>;
+using ModelTruth = std::array<ModelWords, RefinementPrefilter::kModelStates>;
+constexpr size_t kStates = RefinementPrefilter::kModelStates;
+constexpr size_t kWords = RefinementPrefilter::kModelWords;
+
+// edges[s][t]: bit k set iff s -> t in Kripke model k. Every state has a
+// successor in every model, so paths are infinite as CTL assumes.
+const std::array<ModelTruth, kStates>& kripkeEdges() {
+    static const auto edges = [] {
+        std::array<ModelTruth, kStates> e{};
+        for (size_t s = 0; s < kStates; ++s) {
+            for (size_t w = 0; w < kWords; ++w) {
+                uint64_t any = 0;
+                for (size_t t = 0; t < kStates; ++t) {
+                    e[s][t][w] = splitmix64(~((s * kStates + t) * kWords + w));
+                    any |= e[s][t][w];
+                }
+                // Models where s has no successor get one
+                e[s][splitmix64(s * kWords + w) % kStates][w] |= ~any;
+            }
+        }
+        return e;
+    }();
+    return edges;
+}
+
+ModelTruth fill(uint64_t word) {
+    ModelTruth r;
+    for (auto& state : r) state.fill(word);
+    return r;
+}
+
+template <class Op>
+ModelTruth combine(const ModelTruth& x, const ModelTruth& y, Op op) {
+    ModelTruth r;
+    for (size_t s = 0; s < kStates; ++s) {
+        for (size_t w = 0; w < kWords; ++w) r[s][w] = op(x[s][w], y[s][w]);
+    }
+    return r;
+}
+
+// Some successor (existential) or every successor satisfies x
+ModelTruth next(const ModelTruth& x, bool universal) {
+    const auto& edges = kripkeEdges();
+    ModelTruth r = fill(universal ? ~0ULL : 0ULL);
+    for (size_t s = 0; s < kStates; ++s) {
+        for (size_t t = 0; t < kStates; ++t) {
+            for (size_t w = 0; w < kWords; ++w) {
+                if (universal) r[s][w] &= ~edges[s][t][w] | x[t][w];
+                else r[s][w] |= edges[s][t][w] & x[t][w];
+            }
+        }
+    }
+    return r;
+}
+
+// Least (from false) or greatest (from true) fixpoint of a monotone step,
+// in every model at once
+template <class Step>
+ModelTruth fixpoint(bool greatest, Step step) {
+    ModelTruth z = fill(greatest ? ~0ULL : 0ULL);
+    for (;;) {
+        ModelTruth z2 = step(z);
+        if (z2 == z) return z;
+        z = z2;
+    }
+}
+
+} // namespace
+
+RefinementPrefilter::Decision RefinementPrefilter::check(const CTLProperty& refining, const CTLProperty& refined) {
+    const Signature& a = __signature(refining);
+    const Signature& b = __signature(refined);
+
+    auto decide = [this](Decision d) {
+        if (d == Decision::REFINES) decided_refines_.fetch_add(1, std::memory_order_relaxed);
+        else if (d == Decision::DOES_NOT_REFINE) decided_non_refines_.fetch_add(1, std::memory_order_relaxed);
+        else undecided_.fetch_add(1, std::memory_order_relaxed);
+        return d;
+    };
+
+    if (a.is_false || b.is_true || refining.getFormula().equals(refined.getFormula())) {
+        return decide(Decision::REFINES);
+    }
+
+    bool holds_somewhere = false;   // refining has a sampled model
+    bool fails_somewhere = false;   // refined has a sampled counter-model
+    if (a.sampled && b.sampled) {
+        for (size_t w = 0; w < kSampleWords; ++w) {
+            if (a.truth[w] & ~b.truth[w]) return decide(Decision::DOES_NOT_REFINE);
+        }
+    }
+    if (a.model_checked && b.model_checked) {
+        for (size_t w = 0; w < kModelWords; ++w) {
+            if (a.models[w] & ~b.models[w]) {
+                refuted_by_models_.fetch_add(1, std::memory_order_relaxed);
+                return decide(Decision::DOES_NOT_REFINE);
+            }
+        }
+    }
+    for (size_t w = 0; w < kSampleWords; ++w) {
+        holds_somewhere |= a.sampled && a.truth[w] != 0;
+        fails_somewhere |= b.sampled && b.truth[w] != ~0ULL;
+    }
+    for (size_t w = 0; w < kModelWords; ++w) {
+        holds_somewhere |= a.model_checked && a.models[w] != 0;
+        fails_somewhere |= b.model_checked && b.models[w] != ~0ULL;
+    }
+    holds_somewhere |= a.satisfiable.load(std::memory_order_relaxed);
+
+    if (holds_somewhere && fails_somewhere) {
+        // No variable occurs with the same polarity in both
+        auto meet = [](const std::vector<uint64_t>& x, const std::vector<uint64_t>& y) {
+            for (size_t w = 0; w < x.size() && w < y.size(); ++w) {
+                if (x[w] & y[w]) return true;
+            }
+            return false;
+        };
+        if (!meet(a.positive, b.positive) && !meet(a.negative, b.negative)) {
+            return decide(Decision::DOES_NOT_REFINE);
+        }
+    }
+    return decide(Decision::UNKNOWN);
+}
+
+bool RefinementPrefilter::hasCounterModel(const CTLProperty& property) {
+    const Signature& signature = __signature(property);
+    for (uint64_t w : signature.truth) {
+        if (signature.sampled && w != ~0ULL) return true;
+    }
+    for (uint64_t w : signature.models) {
+        if (signature.model_checked && w != ~0ULL) return true;
+    }
+    return false;
+}
+
+void RefinementPrefilter::noteSatisfiable(const CTLProperty& property) {
+    __signature(property).satisfiable.store(true, std::memory_order_relaxed);
+}
+
+int RefinementPrefilter::sampledModels(const CTLProperty& property) {
+    const Signature& signature = __signature(property);
+    if (!signature.sampled) return -1;
+    int models = 0;
+    for (uint64_t w : signature.truth) models += __builtin_popcountll(w);
+    return models;
+}
+
+void RefinementPrefilter::forget(const CTLProperty& property) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    signatures_.erase(&property);
+}
+
+RefinementPrefilter::Signature& RefinementPrefilter::__signature(const CTLProperty& property) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = signatures_.find(&property);
+        if (it != signatures_.end()) return *it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto& slot = signatures_[&property];
+    if (slot) return *slot;
+
+    auto signature = std::make_unique<Signature>();
+    const auto& atoms = property.groupingAtoms();
+    for (size_t k = 0; k < atoms.size(); ++k) {
+        const uint32_t id = __variableId(atoms[k]);
+        for (auto [bit, set] : {std::pair{CTLProperty::kPositive, &signature->positive},
+                                std::pair{CTLProperty::kNegative, &signature->negative}}) {
+            if (!(property.groupingPolarities()[k] & bit)) continue;
+            if (set->size() <= id / 64) set->resize(id / 64 + 1, 0);
+            (*set)[id / 64] |= 1ULL << (id % 64);
+        }
+    }
+    if (auto literal = dynamic_cast<const BooleanLiteral*>(&property.getFormula())) {
+        signature->is_true = literal->value;
+        signature->is_false = !literal->value;
+    }
+    signature->sampled = __sample(property.getFormula(), signature->truth);
+    ModelTruth truth;
+    if (__modelCheck(property.getFormula(), truth)) {
+        signature->models = truth[0];  // state 0 is initial
+        signature->model_checked = true;
+    }
+    slot = std::move(signature);
+    return *slot;
+}
+
+bool RefinementPrefilter::__sample(const CTLFormula& formula, std::array<uint64_t, kSampleWords>& out) {
+    using Truth = std::array<uint64_t, kSampleWords>;
+    auto combine = [](const Truth& x, const Truth& y, auto op) {
+        Truth r;
+        for (size_t w = 0; w < kSampleWords; ++w) r[w] = op(x[w], y[w]);
+        return r;
+    };
+
+    if (auto atom = dynamic_cast<const AtomicFormula*>(&formula)) {
+        if (!isIdentifier(atom->proposition)) return false;
+        const uint64_t id = __leafId(atom->proposition);
+        for (size_t w = 0; w < kSampleWords; ++w) out[w] = splitmix64(id * kSampleWords + w);
+        // Model 0 falsifies every atom, model 1 satisfies every atom
+        out[0] = (out[0] & ~3ULL) | 2ULL;
+        return true;
+    }
+    if (auto literal = dynamic_cast<const BooleanLiteral*>(&formula)) {
+        out.fill(literal->value ? ~0ULL : 0ULL);
+        return true;
+    }
+    if (auto neg = dynamic_cast<const NegationFormula*>(&formula)) {
+        Truth x;
+        if (!__sample(*neg->operand, x)) return false;
+        for (size_t w = 0; w < kSampleWords; ++w) out[w] = ~x[w];
+        return true;
+    }
+    if (auto bin = dynamic_cast<const BinaryFormula*>(&formula)) {
+        Truth l, r;
+        if (!__sample(*bin->left, l) || !__sample(*bin->right, r)) return false;
+        switch (bin->operator_) {
+            case BinaryOperator::AND: out = combine(l, r, [](uint64_t x, uint64_t y) { return x & y; }); return true;
+            case BinaryOperator::OR: out = combine(l, r, [](uint64_t x, uint64_t y) { return x | y; }); return true;
+            case BinaryOperator::IMPLIES: out = combine(l, r, [](uint64_t x, uint64_t y) { return ~x | y; }); return true;
+            default: return false;
+        }
+    }
+    if (auto temporal = dynamic_cast<const TemporalFormula*>(&formula)) {
+        if (temporal->interval.lower > temporal->interval.upper) return false;
+        Truth first;
+        if (!__sample(*temporal->operand, first)) return false;
+        if (!temporal->second_operand) {
+            // EF, AF, EG, AG, EX, AX: the only path stays in the state forever
+            out = first;
+            return true;
+        }
+        Truth second;
+        if (!__sample(*temporal->second_operand, second)) return false;
+        switch (temporal->operator_) {
+            case TemporalOperator::EU:
+            case TemporalOperator::AU:
+            case TemporalOperator::ER:  // EG(phi) is E(false R phi)
+            case TemporalOperator::AR:
+                out = second;
+                return true;
+            case TemporalOperator::EW:
+            case TemporalOperator::AW:
+                out = combine(first, second, [](uint64_t x, uint64_t y) { return x | y; });
+                return true;
+            default:
+                return false;
+        }
+    }
+    // Comparisons share variables, so their truth values are not independent
+    return false;
+}
+
+bool RefinementPrefilter::__modelCheck(const CTLFormula& formula, ModelTruth& out) {
+    if (auto atom = dynamic_cast<const AtomicFormula*>(&formula)) {
+        if (!isIdentifier(atom->proposition)) return false;
+        const uint64_t id = __leafId(atom->proposition);
+        for (size_t s = 0; s < kModelStates; ++s) {
+            for (size_t w = 0; w < kModelWords; ++w) {
+                out[s][w] = splitmix64(((id * kModelStates + s) * kModelWords + w) ^ 0x6b72697073ULL);
+            }
+        }
+        return true;
+    }
+    if (auto literal = dynamic_cast<const BooleanLiteral*>(&formula)) {
+        out = fill(literal->value ? ~0ULL : 0ULL);
+        return true;
+    }
+    if (auto neg = dynamic_cast<const NegationFormula*>(&formula)) {
+        ModelTruth x;
+        if (!__modelCheck(*neg->operand, x)) return false;
+        out = combine(x, x, [](uint64_t v, uint64_t) { return ~v; });
+        return true;
+    }
+    if (auto bin = dynamic_cast<const BinaryFormula*>(&formula)) {
+        ModelTruth l, r;
+        if (!__modelCheck(*bin->left, l) || !__modelCheck(*bin->right, r)) return false;
+        switch (bin->operator_) {
+            case BinaryOperator::AND: out = combine(l, r, [](uint64_t x, uint64_t y) { return x & y; }); return true;
+            case BinaryOperator::OR: out = combine(l, r, [](uint64_t x, uint64_t y) { return x | y; }); return true;
+            case BinaryOperator::IMPLIES: out = combine(l, r, [](uint64_t x, uint64_t y) { return ~x | y; }); return true;
+            default: return false;
+        }
+    }
+    if (auto temporal = dynamic_cast<const TemporalFormula*>(&formula)) {
+        // A bound would count steps, which these models do not model
+        if (temporal->interval != TimeInterval()) return false;
+        ModelTruth first;
+        if (!__modelCheck(*temporal->operand, first)) return false;
+        ModelTruth second = first;
+        if (temporal->second_operand && !__modelCheck(*temporal->second_operand, second)) return false;
+        auto both = [](const ModelTruth& x, const ModelTruth& y) { return combine(x, y, [](uint64_t a, uint64_t b) { return a & b; }); };
+        auto either = [](const ModelTruth& x, const ModelTruth& y) { return combine(x, y, [](uint64_t a, uint64_t b) { return a | b; }); };
+        const TemporalOperator op = temporal->operator_;
+        const bool universal = op == TemporalOperator::AF || op == TemporalOperator::AG || op == TemporalOperator::AU ||
+                               op == TemporalOperator::AW || op == TemporalOperator::AX || op == TemporalOperator::AR;
+        switch (op) {
+            case TemporalOperator::EX:
+            case TemporalOperator::AX:
+                out = next(first, universal);
+                return true;
+            case TemporalOperator::EF:
+            case TemporalOperator::AF:  // mu Z. phi | X Z
+                out = fixpoint(false, [&](const ModelTruth& z) { return either(first, next(z, universal)); });
+                return true;
+            case TemporalOperator::EG:
+            case TemporalOperator::AG:  // nu Z. phi & X Z
+                out = fixpoint(true, [&](const ModelTruth& z) { return both(first, next(z, universal)); });
+                return true;
+            case TemporalOperator::EU:
+            case TemporalOperator::AU:  // mu Z. psi | (phi & X Z)
+                out = fixpoint(false, [&](const ModelTruth& z) { return either(second, both(first, next(z, universal))); });
+                return true;
+            case TemporalOperator::EW:
+            case TemporalOperator::AW:  // nu Z. psi | (phi & X Z)
+                out = fixpoint(true, [&](const ModelTruth& z) { return either(second, both(first, next(z, universal))); });
+                return true;
+            case TemporalOperator::ER:
+            case TemporalOperator::AR:  // nu Z. psi & (phi | X Z)
+                out = fixpoint(true, [&](const ModelTruth& z) { return both(second, either(first, next(z, universal))); });
+                return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+uint32_t RefinementPrefilter::__variableId(const std::string& name) {
+    return variable_ids_.emplace(name, static_cast<uint32_t>(variable_ids_.size())).first->second;
+}
+
+uint32_t RefinementPrefilter::__leafId(const std::string& leaf) {
+    return leaf_ids_.emplace(leaf, static_cast<uint32_t>(leaf_ids_.size())).first->second;
+}
+
+} // namespace ctl
@@ -0,0 +1,330 @@
+#include "run_checkpoint.h"
+#include "log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace ctl {
+
+namespace {
+
+// "CTLCKPT" and a format version; integers are stored in host byte order
+constexpr char kMagic[8] = {'C', 'T', 'L', 'C', 'K', 'P', 'T', '1'};
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Bounds-checked reads over a loaded file; any overrun marks it invalid
+class Reader {
+public:
+    explicit Reader(const std::string& data) : data_(data) {}
+    template <typename T>
+    T get() {
+        T value{};
+        if (!ok_ || data_.size() - pos_ < sizeof(T)) {
+            ok_ = false;
+            return value;
+        }
+        std::memcpy(&value, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+    std::string bytes(size_t size) {
+        if (!ok_ || data_.size() - pos_ < size) {
+            ok_ = false;
+            return {};
+        }
+        std::string value = data_.substr(pos_, size);
+        pos_ += size;
+        return value;
+    }
+    // A count of elements of the given size, invalid if the data cannot hold them
+    uint32_t count(size_t element_size) {
+        const uint32_t n = get<uint32_t>();
+        if (ok_ && n > (data_.size() - pos_) / element_size) ok_ = false;
+        return ok_ ? n : 0;
+    }
+    void fail() { ok_ = false; }
+    bool ok() const { return ok_; }
+    bool done() const { return pos_ == data_.size(); }
+
+private:
+    const std::string& data_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+uint64_t pairKey(uint32_t refining, uint32_t refined) {
+    return (static_cast<uint64_t>(refining) << 32) | refined;
+}
+
+void putEdges(std::string& out, const std::vector<RunCheckpoint::Edge>& edges) {
+    put<uint32_t>(out, static_cast<uint32_t>(edges.size()));
+    for (auto [from, to] : edges) {
+        put(out, from);
+        put(out, to);
+    }
+}
+
+std::vector<RunCheckpoint::Edge> getEdges(Reader& in, size_t members) {
+    std::vector<RunCheckpoint::Edge> edges(in.count(2 * sizeof(uint32_t)));
+    for (auto& [from, to] : edges) {
+        from = in.get<uint32_t>();
+        to = in.get<uint32_t>();
+        if (from >= members || to >= members) in.fail();
+    }
+    return edges;
+}
+
+} // namespace
+
+RunCheckpoint::RunCheckpoint(std::string path, std::chrono::seconds interval)
+    : path_(std::move(path)), interval_(interval) {}
+
+bool RunCheckpoint::begin(uint64_t fingerprint, bool resume) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fingerprint_ = fingerprint;
+    formulas_.clear();
+    formula_index_.clear();
+    satisfiable_.clear();
+    refinements_.clear();
+    classes_.clear();
+    last_save_ns_.store(nowNs(), std::memory_order_relaxed);
+    if (!resume) return false;
+
+    std::ifstream in(path_, std::ios::binary);
+    if (!in) return false;
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (__deserialize(data, fingerprint)) return true;
+    // Unreadable or from another run: start over
+    formulas_.clear();
+    formula_index_.clear();
+    satisfiable_.clear();
+    refinements_.clear();
+    classes_.clear();
+    return false;
+}
+
+uint32_t RunCheckpoint::__index(const std::string& formula) {
+    auto [it, inserted] = formula_index_.try_emplace(formula, static_cast<uint32_t>(formulas_.size()));
+    if (inserted) formulas_.push_back(formula);
+    return it->second;
+}
+
+std::optional<uint32_t> RunCheckpoint::__find(const std::string& formula) const {
+    auto it = formula_index_.find(formula);
+    if (it == formula_index_.end()) return std::nullopt;
+    return it->second;
+}
+
+std::optional<bool> RunCheckpoint::lookupSatisfiable(const std::string& formula) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto index = __find(formula);
+    if (!index) return std::nullopt;
+    auto it = satisfiable_.find(*index);
+    if (it == satisfiable_.end()) return std::nullopt;
+    return it->second;
+}
+
+void RunCheckpoint::storeSatisfiable(const std::string& formula, bool satisfiable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    satisfiable_[__index(formula)] = satisfiable;
+}
+
+std::optional<bool> RunCheckpoint::lookupRefinement(const std::string& refining, const std::string& refined) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto from = __find(refining);
+    auto to = __find(refined);
+    if (!from || !to) return std::nullopt;
+    auto it = refinements_.find(pairKey(*from, *to));
+    if (it == refinements_.end()) return std::nullopt;
+    return it->second;
+}
+
+void RunCheckpoint::storeRefinement(const std::string& refining, const std::string& refined, bool refines) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t from = __index(refining);
+    refinements_[pairKey(from, __index(refined))] = refines;
+}
+
+std::optional<RunCheckpoint::FinishedClass> RunCheckpoint::lookupClass(
+        const std::vector<std::string>& members) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint32_t> key;
+    key.reserve(members.size());
+    for (const auto& formula : members) {
+        auto index = __find(formula);
+        if (!index) return std::nullopt;
+        key.push_back(*index);
+    }
+    auto it = classes_.find(key);
+    if (it == classes_.end()) return std::nullopt;
+    return it->second;
+}
+
+void RunCheckpoint::storeClass(const std::vector<std::string>& members, FinishedClass finished) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint32_t> key;
+    key.reserve(members.size());
+    for (const auto& formula : members) key.push_back(__index(formula));
+    classes_[std::move(key)] = std::move(finished);
+}
+
+bool RunCheckpoint::absorb(const std::string& path) {
+    uint64_t fingerprint;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fingerprint = fingerprint_;
+    }
+    RunCheckpoint other(path, interval_);
+    if (!other.begin(fingerprint, true)) return false;
+
+    // other is private to this call; its indices are translated into ours
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto translate = [this, &other](uint32_t index) { return __index(other.formulas_[index]); };
+    for (auto [formula, satisfiable] : other.satisfiable_) {
+        satisfiable_.try_emplace(translate(formula), satisfiable);
+    }
+    for (auto [key, refines] : other.refinements_) {
+        const uint32_t refining = translate(static_cast<uint32_t>(key >> 32));
+        refinements_.try_emplace(pairKey(refining, translate(static_cast<uint32_t>(key))), refines);
+    }
+    for (auto& [members, finished] : other.classes_) {
+        std::vector<uint32_t> key;
+        key.reserve(members.size());
+        for (uint32_t member : members) key.push_back(translate(member));
+        classes_.try_emplace(std::move(key), std::move(finished));
+    }
+    return true;
+}
+
+size_t RunCheckpoint::decidedPairs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return refinements_.size();
+}
+
+size_t RunCheckpoint::finishedClasses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return classes_.size();
+}
+
+void RunCheckpoint::maybeSave() {
+    const int64_t now = nowNs();
+    int64_t last = last_save_ns_.load(std::memory_order_relaxed);
+    if (now - last < std::chrono::nanoseconds(interval_).count()) return;
+    // One thread wins the interval, the others go on checking
+    if (!last_save_ns_.compare_exchange_strong(last, now, std::memory_order_relaxed)) return;
+    try {
+        save();
+    } catch (const std::exception& e) {
+        // A missed checkpoint only costs progress on a later resume
+        CTL_LOG_WARN(e.what());
+    }
+}
+
+void RunCheckpoint::save() {
+    // Serialized under save_mutex_ too, so an older snapshot never replaces a newer one
+    std::lock_guard<std::mutex> save_lock(save_mutex_);
+    std::string data;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        data = __serialize();
+    }
+    const std::string temporary = path_ + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out) throw std::runtime_error("Cannot write checkpoint: " + temporary);
+    }
+    if (std::rename(temporary.c_str(), path_.c_str()) != 0) {
+        throw std::runtime_error("Cannot replace checkpoint: " + path_);
+    }
+    last_save_ns_.store(nowNs(), std::memory_order_relaxed);
+}
+
+std::string RunCheckpoint::__serialize() const {
+    std::string out(kMagic, sizeof(kMagic));
+    put(out, fingerprint_);
+
+    put<uint32_t>(out, static_cast<uint32_t>(formulas_.size()));
+    for (const auto& formula : formulas_) {
+        put<uint32_t>(out, static_cast<uint32_t>(formula.size()));
+        out += formula;
+    }
+
+    put<uint32_t>(out, static_cast<uint32_t>(satisfiable_.size()));
+    for (auto [formula, satisfiable] : satisfiable_) {
+        put(out, formula);
+        put<uint8_t>(out, satisfiable);
+    }
+
+    put<uint32_t>(out, static_cast<uint32_t>(refinements_.size()));
+    for (auto [key, refines] : refinements_) {
+        put(out, key);
+        put<uint8_t>(out, refines);
+    }
+
+    put<uint32_t>(out, static_cast<uint32_t>(classes_.size()));
+    for (const auto& [members, finished] : classes_) {
+        put<uint32_t>(out, static_cast<uint32_t>(members.size()));
+        for (uint32_t member : members) put(out, member);
+        putEdges(out, finished.edges);
+        putEdges(out, finished.unknown_edges);
+    }
+    return out;
+}
+
+bool RunCheckpoint::__deserialize(const std::string& data, uint64_t fingerprint) {
+    Reader in(data);
+    if (in.bytes(sizeof(kMagic)) != std::string(kMagic, sizeof(kMagic))) return false;
+    if (in.get<uint64_t>() != fingerprint) return false;
+
+    const uint32_t formulas = in.count(sizeof(uint32_t));
+    for (uint32_t k = 0; k < formulas && in.ok(); ++k) {
+        std::string formula = in.bytes(in.count(1));
+        if (in.ok()) __index(formula);
+    }
+    auto valid = [this](uint32_t index) { return index < formulas_.size(); };
+
+    const uint32_t satisfiable = in.count(sizeof(uint32_t) + 1);
+    for (uint32_t k = 0; k < satisfiable && in.ok(); ++k) {
+        const uint32_t formula = in.get<uint32_t>();
+        const bool value = in.get<uint8_t>() != 0;
+        if (!valid(formula)) return false;
+        satisfiable_[formula] = value;
+    }
+
+    const uint32_t refinements = in.count(sizeof(uint64_t) + 1);
+    for (uint32_t k = 0; k < refinements && in.ok(); ++k) {
+        const uint64_t key = in.get<uint64_t>();
+        const bool refines = in.get<uint8_t>() != 0;
+        if (!valid(static_cast<uint32_t>(key >> 32)) || !valid(static_cast<uint32_t>(key))) return false;
+        refinements_[key] = refines;
+    }
+
+    const uint32_t classes = in.count(3 * sizeof(uint32_t));
+    for (uint32_t k = 0; k < classes && in.ok(); ++k) {
+        std::vector<uint32_t> members(in.count(sizeof(uint32_t)));
+        for (uint32_t& member : members) {
+            member = in.get<uint32_t>();
+            if (!in.ok() || !valid(member)) return false;
+        }
+        FinishedClass finished;
+        finished.edges = getEdges(in, members.size());
+        finished.unknown_edges = getEdges(in, members.size());
+        classes_[std::move(members)] = std::move(finished);
+    }
+    return in.ok() && in.done();
+}
+
+} // namespace ctl
@@ -0,0 +1,213 @@
+#include "scaling_benchmark.h"
+#include "Analyzers/Refinement.h"
+#include "property_generator.h"
+#include "memory_tracker.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ctl {
+
+std::string ScalingEngineToString(ScalingEngine engine) {
+    switch (engine) {
+        case ScalingEngine::SIMULATION: return "simulation";
+        case ScalingEngine::LANGUAGE_INCLUSION: return "inclusion";
+        case ScalingEngine::CTL_SAT: return "ctlsat";
+        case ScalingEngine::MLSOLVER: return "mlsolver";
+    }
+    return "unknown";
+}
+
+std::optional<ScalingEngine> ScalingEngineFromString(const std::string& name) {
+    for (auto engine : {ScalingEngine::SIMULATION, ScalingEngine::LANGUAGE_INCLUSION,
+                        ScalingEngine::CTL_SAT, ScalingEngine::MLSOLVER}) {
+        if (ScalingEngineToString(engine) == name) return engine;
+    }
+    return std::nullopt;
+}
+
+ScalingBenchmark::ScalingBenchmark(ScalingConfig config) : config_(std::move(config)) {}
+
+size_t ScalingBenchmark::run(std::ostream& out) const {
+    size_t failed = 0;
+    for (ScalingEngine engine : config_.engines) {
+        for (size_t depth : config_.depths) {
+            for (size_t class_size : config_.class_sizes) {
+                for (size_t threads : config_.thread_counts) {
+                    std::cout << "[Scaling] " << ScalingEngineToString(engine) << ", depth " << depth
+                              << ", n = " << class_size << ", " << threads << " thread(s)\n";
+                    std::string line = __runPointIsolated(class_size, depth, threads, engine);
+                    if (line.find("\"error\":\"\"") == std::string::npos) ++failed;
+                    out << line;
+                    out.flush();
+                }
+            }
+        }
+    }
+    return failed;
+}
+
+ScalingPoint ScalingBenchmark::runPoint(size_t class_size, size_t depth, size_t threads,
+                                        ScalingEngine engine) const {
+    ScalingPoint point;
+    point.class_size = class_size;
+    point.depth = depth;
+    point.threads = threads;
+    point.engine = engine;
+
+    // One class over one atom pool, so every pair is a candidate
+    GenerationConfig generation;
+    generation.num_classes = 1;
+    generation.max_depth = depth;
+    generation.max_atoms_per_class = config_.atoms;
+    generation.use_time_intervals = false;
+    generation.seed = config_.seed;
+    PropertyGenerator generator(generation);
+    std::vector<std::string> formulas;
+    for (const auto& property : generator.generateEquivalenceClass(0, class_size)) {
+        formulas.push_back(property->toString());
+    }
+
+    try {
+        RefinementAnalyzer analyzer(formulas);
+        analyzer.setParallelAnalysis(threads > 1);
+        analyzer.setThreads(threads);
+        analyzer.setFullLanguageInclusion(engine != ScalingEngine::SIMULATION);
+        analyzer.setEmptinessEngine(config_.emptiness);
+        if (engine == ScalingEngine::CTL_SAT) {
+            analyzer.setExternalSATInterface(AvailableCTLSATInterfaces::CTLSAT, config_.sat_path);
+        } else if (engine == ScalingEngine::MLSOLVER) {
+            analyzer.setExternalSATInterface(AvailableCTLSATInterfaces::MLSOLVER, config_.sat_path);
+        }
+        if (engine == ScalingEngine::CTL_SAT || engine == ScalingEngine::MLSOLVER) {
+            analyzer.setExternalSATLimits(threads, std::chrono::milliseconds(0));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        AnalysisResult result = analyzer.analyze();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        point.properties = analyzer.getProperties().size();
+        point.checks = analyzer.getPropertyResults().size();
+        point.skipped = result.transitive_eliminated;
+        point.wall_ms = std::chrono::duration<double, std::milli>(elapsed).count();
+        if (point.wall_ms > 0) point.checks_per_sec = 1000.0 * point.checks / point.wall_ms;
+        if (point.checks + point.skipped > 0) {
+            point.skip_ratio = static_cast<double>(point.skipped) / (point.checks + point.skipped);
+        }
+
+        std::vector<long long> latencies;
+        latencies.reserve(point.checks);
+        for (const auto& check : analyzer.getPropertyResults()) latencies.push_back(check.latency.count());
+        if (!latencies.empty()) {
+            std::sort(latencies.begin(), latencies.end());
+            // Nearest-rank percentiles
+            auto percentile = [&latencies](double p) {
+                size_t rank = static_cast<size_t>(std::ceil(p * latencies.size()));
+                return latencies[std::max<size_t>(rank, 1) - 1] / 1000.0;
+            };
+            point.p50_ms = percentile(0.50);
+            point.p99_ms = percentile(0.99);
+        }
+    } catch (const std::exception& e) {
+        point.error = e.what();
+    }
+    point.peak_rss_kb = memory_utils::getPeakMemoryUsage();
+    return point;
+}
+
+void ScalingBenchmark::writeJson(std::ostream& out, const ScalingPoint& point) {
+    std::string error;
+    for (char c : point.error) {
+        if (c == '"' || c == '\\') error += '\\';
+        error += (c == '\n') ? ' ' : c;
+    }
+    out << "{\"engine\":\"" << ScalingEngineToString(point.engine) << "\""
+        << ",\"class_size\":" << point.class_size
+        << ",\"depth\":" << point.depth
+        << ",\"threads\":" << point.threads
+        << ",\"properties\":" << point.properties
+        << ",\"checks\":" << point.checks
+        << ",\"skipped\":" << point.skipped
+        << ",\"wall_ms\":" << point.wall_ms
+        << ",\"checks_per_sec\":" << point.checks_per_sec
+        << ",\"p50_ms\":" << point.p50_ms
+        << ",\"p99_ms\":" << point.p99_ms
+        << ",\"skip_ratio\":" << point.skip_ratio
+        << ",\"peak_rss_kb\":" << point.peak_rss_kb
+        << ",\"error\":\"" << error << "\""
+        << "}\n";
+}
+
+std::string ScalingBenchmark::__runPointIsolated(size_t class_size, size_t depth, size_t threads,
+                                                 ScalingEngine engine) const {
+    ScalingPoint failed;
+    failed.class_size = class_size;
+    failed.depth = depth;
+    failed.threads = threads;
+    failed.engine = engine;
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        failed.error = std::string("pipe: ") + std::strerror(errno);
+        std::ostringstream line;
+        writeJson(line, failed);
+        return line.str();
+    }
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        failed.error = std::string("fork: ") + std::strerror(errno);
+        std::ostringstream line;
+        writeJson(line, failed);
+        return line.str();
+    }
+    if (pid == 0) {
+        // The analyzer's progress output is not part of the results
+        close(fds[0]);
+        int null = open("/dev/null", O_WRONLY);
+        if (null >= 0) dup2(null, STDOUT_FILENO);
+        std::ostringstream line;
+        writeJson(line, runPoint(class_size, depth, threads, engine));
+        const std::string text = line.str();
+        for (size_t written = 0; written < text.size(); ) {
+            ssize_t n = write(fds[1], text.data() + written, text.size() - written);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) _exit(1);
+            written += static_cast<size_t>(n);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+
+    std::string output;
+    char buffer[4096];
+    while (true) {
+        ssize_t n = read(fds[0], buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        output.append(buffer, static_cast<size_t>(n));
+    }
+    close(fds[0]);
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+
+    if (!output.empty() && output.back() == '\n') return output;
+    failed.error = WIFSIGNALED(status) ? "killed by signal " + std::to_string(WTERMSIG(status))
+                                       : "exited with status " + std::to_string(WEXITSTATUS(status));
+    std::ostringstream line;
+    writeJson(line, failed);
+    return line.str();
+}
+
+} // namespace ctl
@@ -0,0 +1,45 @@
+#include "smt_context_manager.h"
+#include "SMTInterfaces/BDDSMTInterface.h"
+
+#ifdef USE_Z3
+#include "SMTInterfaces/Z3SMTInterface.h"
+#endif
+
+#include <memory>
+
+namespace ctl {
+
+std::atomic<size_t> SMTContextManager::s_created_{0};
+std::atomic<bool> SMTContextManager::s_bdd_guards_{false};
+
+SMTInterface& SMTContextManager::local() {
+    thread_local std::unique_ptr<SMTInterface> interface;
+    if (!interface) {
+        interface = createDefaultSMTInterface();
+        s_created_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return *interface;
+}
+
+SMTInterface& SMTContextManager::guards() {
+    if (!propositionalGuards()) return local();
+    thread_local std::unique_ptr<BDDSMTInterface> interface;
+    if (!interface) {
+        // Falls back on local(): one context (and solver pool) per thread either way
+        interface = std::make_unique<BDDSMTInterface>(local());
+    }
+    return *interface;
+}
+
+#ifdef USE_Z3
+z3::context& SMTContextManager::localZ3Context() {
+    return localZ3().getContext();
+}
+
+Z3SMTInterface& SMTContextManager::localZ3() {
+    // createDefaultSMTInterface() always yields a Z3SMTInterface when USE_Z3 is set
+    return static_cast<Z3SMTInterface&>(local());
+}
+#endif
+
+} // namespace ctl
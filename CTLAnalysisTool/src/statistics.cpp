@@ -0,0 +1,75 @@
+#include "statistics.h"
+
+namespace ctl {
+
+const char* StatisticToString(Statistic statistic) {
+    switch (statistic) {
+        case Statistic::SMT_QUERIES: return "smt_queries";
+        case Statistic::SMT_TIME_NS: return "smt_time_ns";
+        case Statistic::GUARD_CACHE_HITS: return "guard_cache_hits";
+        case Statistic::GUARD_CACHE_MISSES: return "guard_cache_misses";
+        case Statistic::SIMULATION_CHECKS: return "simulation_checks";
+        case Statistic::SIMULATION_INITIAL_PAIRS: return "simulation_initial_pairs";
+        case Statistic::SIMULATION_ITERATIONS: return "simulation_iterations";
+        case Statistic::SIMULATION_PAIRS_PRUNED: return "simulation_pairs_pruned";
+        case Statistic::PRODUCT_STATES: return "product_states";
+        case Statistic::PRODUCT_EDGES: return "product_edges";
+        case Statistic::GAME_POSITIONS: return "game_positions";
+        case Statistic::GAME_CHOICES: return "game_choices";
+        case Statistic::AUTOMATA_BUILT: return "automata_built";
+        case Statistic::AUTOMATA_LOADED: return "automata_loaded";
+        case Statistic::AUTOMATON_STATES: return "automaton_states";
+        case Statistic::SCCS: return "sccs";
+        case Statistic::PAIRS_PLANNED: return "pairs_planned";
+        case Statistic::PAIRS_DECIDED: return "pairs_decided";
+        case Statistic::REFINEMENT_CHECKS: return "refinement_checks";
+        case Statistic::SATISFIABILITY_SHORTCUTS: return "satisfiability_shortcuts";
+        case Statistic::CLASS_SIMULATIONS: return "class_simulations";
+        case Statistic::SHARED_MOVES_REUSED: return "shared_moves_reused";
+        case Statistic::SHARED_SIMULATION_VERDICTS: return "shared_simulation_verdicts";
+        case Statistic::INTERVAL_DECISIONS: return "interval_decisions";
+        case Statistic::TRUTH_TABLE_DECISIONS: return "truth_table_decisions";
+        case Statistic::PORTFOLIO_SYNTACTIC_WINS: return "portfolio_syntactic_wins";
+        case Statistic::PORTFOLIO_SIMULATION_WINS: return "portfolio_simulation_wins";
+        case Statistic::PORTFOLIO_INCLUSION_WINS: return "portfolio_inclusion_wins";
+        case Statistic::PORTFOLIO_EXTERNAL_SAT_WINS: return "portfolio_external_sat_wins";
+        case Statistic::WITNESSES_KEPT: return "witnesses_kept";
+        case Statistic::WITNESS_REFUTATIONS: return "witness_refutations";
+        case Statistic::COUNT: break;
+    }
+    return "unknown";
+}
+
+Statistics& Statistics::instance() {
+    static Statistics statistics;
+    return statistics;
+}
+
+Statistics::ThreadCounters& Statistics::__local() {
+    thread_local ThreadCounters* counters = nullptr;
+    if (!counters) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.push_back(std::make_unique<ThreadCounters>());
+        counters = threads_.back().get();
+    }
+    return *counters;
+}
+
+void Statistics::add(Statistic statistic, uint64_t amount) {
+    // Only this thread writes its block: no read-modify-write needed
+    auto& value = __local().values[static_cast<size_t>(statistic)];
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+StatisticValues Statistics::snapshot() const {
+    StatisticValues total{};
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& counters : threads_) {
+        for (size_t i = 0; i < kStatisticCount; ++i) {
+            total[i] += counters->values[i].load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+} // namespace ctl
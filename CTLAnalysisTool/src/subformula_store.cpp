@@ -0,0 +1,48 @@
+#include "subformula_store.h"
+#include "formula_factory.h"
+
+namespace ctl {
+
+SubformulaStore::Id SubformulaStore::id(const CTLFormulaPtr& formula) {
+    // Helper states carry formulas built on the fly; interning maps them to
+    // the node every other automaton uses
+    const CTLFormulaPtr canonical = FormulaFactory::instance().intern(formula);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = ids_.try_emplace(canonical.get(), static_cast<Id>(moves_.size()));
+    if (inserted) moves_.emplace_back();
+    return it->second;
+}
+
+size_t SubformulaStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ids_.size();
+}
+
+std::shared_ptr<const std::vector<Move>> SubformulaStore::moves(Id state) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return moves_[state];
+}
+
+std::shared_ptr<const std::vector<Move>> SubformulaStore::publishMoves(Id state, std::vector<Move> moves) {
+    auto published = std::make_shared<const std::vector<Move>>(std::move(moves));
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!moves_[state]) moves_[state] = std::move(published);
+    return moves_[state];
+}
+
+std::optional<bool> SubformulaStore::simulated(Id spoiler, Id duplicator) const {
+    if (spoiler == duplicator) return true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = simulations_.find(__key(spoiler, duplicator));
+    if (it == simulations_.end()) return std::nullopt;
+    return it->second;
+}
+
+void SubformulaStore::recordSimulations(std::span<const Verdict> verdicts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [spoiler, duplicator, holds] : verdicts) {
+        simulations_.emplace(__key(spoiler, duplicator), holds);
+    }
+}
+
+} // namespace ctl
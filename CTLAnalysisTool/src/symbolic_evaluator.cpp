@@ -0,0 +1,193 @@
+#include "symbolic_evaluator.h"
+#include "CTLautomaton.h"
+#include "SCCBlocks.h"
+#include "cancellation.h"
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+namespace ctl {
+
+SymbolicEvaluator::SymbolicEvaluator(const CTLAutomaton& automaton)
+    : automaton_(automaton),
+      block_of_(automaton.numStates(), -1),
+      good_(automaton.numStates(), 1),
+      forced_known_(automaton.numStates(), 0),
+      forced_(automaton.numStates()),
+      forced_satisfiable_(automaton.numStates(), -1) {
+    const SCCBlocks& blocks = *automaton.blocks_;
+    members_.resize(blocks.size());
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        for (std::string_view name : blocks.getStatesInBlock(b)) {
+            const StateId id = automaton.getStateId(name);
+            if (id == INVALID_STATE_ID) continue;
+            block_of_[id] = static_cast<int>(b);
+            members_[b].push_back(id);
+        }
+    }
+    // The topological order starts at the initial block; obligations point
+    // down the DAG, so blocks are evaluated from the end
+    const auto& order = automaton.__getTopologicalOrder();
+    evaluation_order_.assign(order.rbegin(), order.rend());
+    block_done_.assign(blocks.size(), 0);
+}
+
+bool SymbolicEvaluator::mayBeNonEmpty() {
+    const StateId initial = automaton_.getInitialStateId();
+    return initial != INVALID_STATE_ID && isGood(initial);
+}
+
+bool SymbolicEvaluator::isGood(StateId state) {
+    const int block = block_of_[state];
+    if (block < 0) return true;  // outside the block structure: nothing is known
+    __evaluateUpTo(block);
+    return good_[state];
+}
+
+void SymbolicEvaluator::__evaluateUpTo(int block) {
+    while (!block_done_[block] && next_block_ < evaluation_order_.size()) {
+        const int next = evaluation_order_[next_block_++];
+        if (!block_done_[next]) __evaluateBlock(next);
+    }
+}
+
+void SymbolicEvaluator::evaluate(WorkStealingPool& pool) {
+    const auto& successors = automaton_.__getDAG();
+    const size_t n = members_.size();
+    std::vector<std::vector<int>> predecessors(n);
+    auto waiting = std::make_unique<std::atomic<size_t>[]>(n);  // successors not yet done
+    for (size_t b = 0; b < n; ++b) {
+        if (block_done_[b]) continue;
+        for (int s : successors[b]) {
+            predecessors[s].push_back(static_cast<int>(b));
+            if (!block_done_[s]) waiting[b].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Workers run without the caller's token; each task installs it
+    const CancellationToken* token = CancellationToken::current();
+    std::function<void(int)> run = [&](int block) {
+        pool.submit([&, block](size_t) {
+            CancellationScope scope(token);
+            __evaluateBlock(block);
+            // The release orders this block's verdicts before a dependent reads them
+            for (int p : predecessors[block]) {
+                if (waiting[p].fetch_sub(1, std::memory_order_acq_rel) == 1) run(p);
+            }
+        });
+    };
+    for (size_t b = 0; b < n; ++b) {
+        if (!block_done_[b] && waiting[b].load(std::memory_order_relaxed) == 0) run(static_cast<int>(b));
+    }
+    pool.wait();
+}
+
+void SymbolicEvaluator::__evaluateBlock(int block) {
+    const auto& members = members_[block];
+    const bool greatest = std::any_of(members.begin(), members.end(),
+                                      [this](StateId q) { return automaton_.isAccepting(q); });
+    // ν: start from every state and drop the bad ones; μ: add the good ones
+    for (StateId q : members) good_[q] = greatest;
+    bool changed = true;
+    while (changed) {
+        cancellation::checkpoint();
+        changed = false;
+        for (StateId q : members) {
+            if (good_[q] != greatest) continue;  // settled in this direction
+            if (__evaluateState(block, q) != greatest) {
+                good_[q] = !greatest;
+                changed = true;
+            }
+        }
+    }
+    block_done_[block] = 1;
+    evaluated_blocks_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool SymbolicEvaluator::__evaluateState(int block, StateId state) {
+    if (!__forcedSatisfiable(state)) return false;
+    for (const auto& transition : automaton_.getTransitions(state)) {
+        if (transition->guard.isFalse()) return false;
+        if (transition->clauses.size() == 1) {
+            // Its guards are among the forced ones already
+            if (!__clauseHolds(block, transition->clauses.front())) return false;
+            continue;
+        }
+        const bool some = std::any_of(transition->clauses.begin(), transition->clauses.end(),
+                                      [&](const ClauseView& clause) {
+                                          return __clauseHolds(block, clause) && __clauseViable(state, clause);
+                                      });
+        if (!some) return false;
+    }
+    return true;
+}
+
+bool SymbolicEvaluator::__clauseHolds(int block, const ClauseView& clause) {
+    for (const auto& literal : clause.literals) {
+        if (literal.qid == INVALID_STATE_ID) continue;
+        const int target = block_of_[literal.qid];
+        // Blocks below are done; one not yet evaluated puts no constraint
+        if (target >= 0 && (target == block || block_done_[target]) && !good_[literal.qid]) return false;
+    }
+    return true;
+}
+
+bool SymbolicEvaluator::__clauseViable(StateId state, const ClauseView& clause) {
+    // Guards of the clause's same-node obligations, with those of the state
+    std::vector<GuardTable::Id> guards = __forcedGuards(state);
+    bool extended = false;
+    for (const auto& literal : clause.literals) {
+        if (literal.dir >= 0 || literal.qid == INVALID_STATE_ID) continue;
+        const auto& more = __forcedGuards(literal.qid);
+        guards.insert(guards.end(), more.begin(), more.end());
+        extended = true;
+    }
+    if (!extended) return true;  // __forcedSatisfiable(state) holds
+    std::sort(guards.begin(), guards.end());
+    guards.erase(std::unique(guards.begin(), guards.end()), guards.end());
+    if (std::binary_search(guards.begin(), guards.end(), GuardTable::FALSE_ID)) return false;
+    return automaton_.isSatisfiable(guards);
+}
+
+const std::vector<GuardTable::Id>& SymbolicEvaluator::__forcedGuards(StateId state) {
+    auto& guards = forced_[state];
+    if (forced_known_[state]) return guards;
+    forced_known_[state] = 1;
+
+    // States a run must visit at the same node: the targets of same-node
+    // literals of single-clause transitions, transitively
+    std::vector<uint8_t> visited(automaton_.numStates(), 0);
+    std::vector<StateId> stack{state};
+    visited[state] = 1;
+    while (!stack.empty()) {
+        const StateId q = stack.back();
+        stack.pop_back();
+        for (const auto& transition : automaton_.getTransitions(q)) {
+            if (!transition->guard.isTrue()) guards.push_back(transition->guard.id);
+            if (transition->clauses.size() != 1) continue;
+            for (const auto& literal : transition->clauses.front().literals) {
+                if (literal.dir >= 0 || literal.qid == INVALID_STATE_ID || visited[literal.qid]) continue;
+                visited[literal.qid] = 1;
+                stack.push_back(literal.qid);
+            }
+        }
+    }
+    std::sort(guards.begin(), guards.end());
+    guards.erase(std::unique(guards.begin(), guards.end()), guards.end());
+    return guards;
+}
+
+bool SymbolicEvaluator::__forcedSatisfiable(StateId state) {
+    if (forced_satisfiable_[state] == -1) {
+        const auto& guards = __forcedGuards(state);
+        bool satisfiable = true;
+        if (std::binary_search(guards.begin(), guards.end(), GuardTable::FALSE_ID)) satisfiable = false;
+        else if (!guards.empty()) satisfiable = automaton_.isSatisfiable(guards);
+        forced_satisfiable_[state] = satisfiable;
+    }
+    return forced_satisfiable_[state];
+}
+
+} // namespace ctl
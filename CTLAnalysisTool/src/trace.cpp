@@ -0,0 +1,70 @@
+#include "trace.h"
+
+#include <algorithm>
+
+namespace ctl::trace {
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::start(size_t events_per_thread) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = std::max<size_t>(events_per_thread, 1);
+    origin_ns_ = now();
+    for (auto& buffer : buffers_) {
+        buffer->ring.assign(capacity_, Event{});
+        buffer->written = 0;
+    }
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+Tracer::ThreadBuffer& Tracer::__local() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto created = std::make_unique<ThreadBuffer>();
+        created->ring.resize(capacity_);
+        created->tid = static_cast<uint32_t>(buffers_.size() + 1);
+        buffer = created.get();
+        buffers_.push_back(std::move(created));
+    }
+    return *buffer;
+}
+
+void Tracer::record(const char* category, const char* name, int64_t start_ns, int64_t end_ns) {
+    ThreadBuffer& buffer = __local();
+    buffer.ring[buffer.written % buffer.ring.size()] = Event{category, name, start_ns, end_ns - start_ns};
+    ++buffer.written;
+}
+
+size_t Tracer::eventCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& buffer : buffers_) count += std::min<uint64_t>(buffer->written, buffer->ring.size());
+    return count;
+}
+
+void Tracer::writeChromeTrace(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto& buffer : buffers_) {
+        const uint64_t size = buffer->ring.size();
+        const uint64_t kept = std::min<uint64_t>(buffer->written, size);
+        // Oldest kept span first
+        for (uint64_t k = buffer->written - kept; k < buffer->written; ++k) {
+            const Event& event = buffer->ring[k % size];
+            out << (first ? "\n" : ",\n")
+                << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\""
+                << ",\"ts\":" << (event.start_ns - origin_ns_) / 1000.0
+                << ",\"dur\":" << event.duration_ns / 1000.0
+                << ",\"pid\":1,\"tid\":" << buffer->tid << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+}
+
+} // namespace ctl::trace
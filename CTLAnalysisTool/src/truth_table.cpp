@@ -0,0 +1,255 @@
+#include "truth_table.h"
+#include "formula.h"
+#include "parser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+
+namespace ctl {
+
+namespace {
+
+using Program = TruthTableKernel::Program;
+using Op = Program::Op;
+
+// Same atom syntax the Z3 lowering treats as a Boolean constant
+bool isIdentifier(const std::string& s) {
+    if (s.empty() || std::isdigit(static_cast<unsigned char>(s[0]))) return false;
+    for (char ch : s) {
+        if (!std::isalnum(static_cast<unsigned char>(ch)) && ch != '_' && ch != '.') return false;
+    }
+    return true;
+}
+
+// Appends the postfix code of guard, numbering atoms by first occurrence; false if not propositional
+bool emit(const CTLFormula& guard, std::map<std::string, uint16_t>& atoms, Program& out, size_t height) {
+    out.depth = std::max(out.depth, height + 1);
+    switch (guard.getType()) {
+        case FormulaType::BOOLEAN_LITERAL:
+            out.code.push_back({static_cast<const BooleanLiteral&>(guard).value ? Op::TRUE : Op::FALSE});
+            return true;
+
+        case FormulaType::ATOMIC: {
+            const auto& prop = static_cast<const AtomicFormula&>(guard).proposition;
+            if (prop == "true" || prop == "1" || prop == "false" || prop == "0") {
+                out.code.push_back({prop == "true" || prop == "1" ? Op::TRUE : Op::FALSE});
+                return true;
+            }
+            if (!isIdentifier(prop)) return false;
+            auto [it, inserted] = atoms.try_emplace(prop, static_cast<uint16_t>(atoms.size()));
+            if (atoms.size() > TruthTableKernel::kMaxAtoms) return false;
+            out.code.push_back({Op::ATOM, it->second});
+            return true;
+        }
+
+        case FormulaType::NEGATION:
+            if (!emit(*static_cast<const NegationFormula&>(guard).operand, atoms, out, height)) return false;
+            out.code.push_back({Op::NOT});
+            return true;
+
+        case FormulaType::BINARY: {
+            const auto& bin = static_cast<const BinaryFormula&>(guard);
+            if (bin.operator_ == BinaryOperator::NONE) return false;
+            if (!emit(*bin.left, atoms, out, height)) return false;
+            if (bin.operator_ == BinaryOperator::IMPLIES) out.code.push_back({Op::NOT});
+            if (!emit(*bin.right, atoms, out, height + 1)) return false;
+            out.code.push_back({bin.operator_ == BinaryOperator::AND ? Op::AND : Op::OR});
+            return true;
+        }
+
+        default:
+            // Comparisons need arithmetic; temporal operators never occur in guards
+            return false;
+    }
+}
+
+// Truth tables over n atoms: 2^n valuations as bits, valuation v in bit v % 64 of word v / 64
+class Tables {
+public:
+    explicit Tables(size_t atoms)
+        : words_(atoms < 6 ? 1 : size_t{1} << (atoms - 6)),
+          last_(atoms < 6 ? (uint64_t{1} << (size_t{1} << atoms)) - 1 : ~uint64_t{0}) {}
+
+    size_t words() const { return words_; }
+
+    // Row of atom i: bit v is bit i of v
+    static void atom(size_t i, std::span<uint64_t> out) {
+        static constexpr uint64_t kLow[6] = {0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+                                             0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull};
+        if (i < 6) {
+            std::fill(out.begin(), out.end(), kLow[i]);
+            return;
+        }
+        for (size_t w = 0; w < out.size(); ++w) out[w] = (w >> (i - 6)) & 1 ? ~uint64_t{0} : 0;
+    }
+
+    // Table of the program, its atoms placed at the given positions
+    void evaluate(const Program& program, std::span<const size_t> positions, std::span<uint64_t> out) {
+        stack_.resize(program.depth * words_);
+        size_t top = 0;
+        const auto slot = [&](size_t i) { return std::span<uint64_t>(stack_.data() + i * words_, words_); };
+        for (const auto& instruction : program.code) {
+            switch (instruction.op) {
+                case Op::ATOM: atom(positions[instruction.atom], slot(top++)); break;
+                case Op::TRUE: std::ranges::fill(slot(top++), ~uint64_t{0}); break;
+                case Op::FALSE: std::ranges::fill(slot(top++), 0); break;
+                case Op::NOT:
+                    for (uint64_t& w : slot(top - 1)) w = ~w;
+                    break;
+                case Op::AND:
+                case Op::OR: {
+                    auto left = slot(top - 2), right = slot(top - 1);
+                    if (instruction.op == Op::AND) {
+                        for (size_t w = 0; w < words_; ++w) left[w] &= right[w];
+                    } else {
+                        for (size_t w = 0; w < words_; ++w) left[w] |= right[w];
+                    }
+                    --top;
+                    break;
+                }
+            }
+        }
+        std::ranges::copy(slot(0), out.begin());
+    }
+
+    // Whether a valuation of a, and of none of without if given, exists
+    bool any(std::span<const uint64_t> a, std::span<const uint64_t> without = {}) const {
+        uint64_t seen = 0;
+        for (size_t w = 0; w + 1 < words_; ++w) seen |= a[w] & (without.empty() ? ~uint64_t{0} : ~without[w]);
+        seen |= a[words_ - 1] & (without.empty() ? ~uint64_t{0} : ~without[words_ - 1]) & last_;
+        return seen != 0;
+    }
+
+private:
+    size_t words_;
+    uint64_t last_;  // valid bits of the last word
+    std::vector<uint64_t> stack_;
+};
+
+// Conjunction of the programs' tables over the union of their atoms
+class Query {
+public:
+    explicit Query(const std::vector<std::string>& atoms) : atoms_(atoms), tables_(atoms.size()) {}
+
+    const Tables& tables() const { return tables_; }
+
+    void conjoin(std::span<const Program* const> programs, std::vector<uint64_t>& out) {
+        out.assign(tables_.words(), ~uint64_t{0});
+        table_.resize(tables_.words());
+        std::vector<size_t> positions;
+        for (const Program* program : programs) {
+            positions.clear();
+            for (const auto& atom : program->atoms) {
+                positions.push_back(std::lower_bound(atoms_.begin(), atoms_.end(), atom) - atoms_.begin());
+            }
+            tables_.evaluate(*program, positions, table_);
+            for (size_t w = 0; w < out.size(); ++w) out[w] &= table_[w];
+        }
+    }
+
+private:
+    const std::vector<std::string>& atoms_;
+    Tables tables_;
+    std::vector<uint64_t> table_;
+};
+
+// Sorted union of the programs' atoms, none past the width limit
+std::optional<std::vector<std::string>> support(std::span<const Program* const> a, std::span<const Program* const> b) {
+    std::vector<std::string> atoms;
+    for (auto programs : {a, b}) {
+        for (const Program* program : programs) atoms.insert(atoms.end(), program->atoms.begin(), program->atoms.end());
+    }
+    std::sort(atoms.begin(), atoms.end());
+    atoms.erase(std::unique(atoms.begin(), atoms.end()), atoms.end());
+    if (atoms.size() > TruthTableKernel::kMaxAtoms) return std::nullopt;
+    return atoms;
+}
+
+} // namespace
+
+TruthTableKernel& TruthTableKernel::instance() {
+    static TruthTableKernel kernel;
+    return kernel;
+}
+
+std::optional<TruthTableKernel::Program> TruthTableKernel::compile(const CTLFormula& guard) {
+    Program program;
+    std::map<std::string, uint16_t> atoms;
+    if (!emit(guard, atoms, program, 0)) return std::nullopt;
+    // Renumber the atoms in name order, so that queries merge sorted lists
+    std::vector<uint16_t> rank(atoms.size());
+    uint16_t next = 0;
+    for (const auto& [name, index] : atoms) {
+        rank[index] = next++;
+        program.atoms.push_back(name);
+    }
+    for (auto& instruction : program.code) {
+        if (instruction.op == Op::ATOM) instruction.atom = rank[instruction.atom];
+    }
+    return program;
+}
+
+const TruthTableKernel::Program* TruthTableKernel::lookup(GuardTable::Id guard) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = programs_.find(guard);
+        if (it != programs_.end()) return it->second ? &*it->second : nullptr;
+    }
+    std::optional<Program> program;
+    if (guard == GuardTable::TRUE_ID || guard == GuardTable::FALSE_ID) {
+        program.emplace();
+        program->code.push_back({guard == GuardTable::TRUE_ID ? Op::TRUE : Op::FALSE});
+        program->depth = 1;
+    } else {
+        try {
+            program = compile(*Parser::parseFormula(GuardTable::instance().text(guard)));
+        } catch (const std::exception&) {
+            // Text the CTL parser rejects is left to the SMT string parser
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = programs_.try_emplace(guard, std::move(program)).first->second;
+    return entry ? &*entry : nullptr;
+}
+
+std::optional<bool> TruthTableKernel::satisfiable(std::span<const GuardTable::Id> guards) {
+    std::vector<const Program*> programs;
+    programs.reserve(guards.size());
+    for (GuardTable::Id guard : guards) {
+        const Program* program = lookup(guard);
+        if (!program) return std::nullopt;
+        programs.push_back(program);
+    }
+    auto atoms = support(programs, {});
+    if (!atoms) return std::nullopt;
+    Query query(*atoms);
+    std::vector<uint64_t> all;
+    query.conjoin(programs, all);
+    return query.tables().any(all);
+}
+
+std::optional<bool> TruthTableKernel::entails(std::span<const GuardTable::Id> premise,
+                                              std::span<const GuardTable::Id> conclusion) {
+    std::vector<const Program*> premises, conclusions;
+    for (GuardTable::Id guard : premise) {
+        const Program* program = lookup(guard);
+        if (!program) return std::nullopt;
+        premises.push_back(program);
+    }
+    for (GuardTable::Id guard : conclusion) {
+        const Program* program = lookup(guard);
+        if (!program) return std::nullopt;
+        conclusions.push_back(program);
+    }
+    auto atoms = support(premises, conclusions);
+    if (!atoms) return std::nullopt;
+    // The premise implies the conclusion iff no valuation satisfies premise && !conclusion
+    Query query(*atoms);
+    std::vector<uint64_t> assumed, concluded;
+    query.conjoin(premises, assumed);
+    query.conjoin(conclusions, concluded);
+    return !query.tables().any(assumed, concluded);
+}
+
+} // namespace ctl
@@ -1,18 +1,32 @@
-
 #include "union_find.h"
+
+#include <numeric>
+
 namespace ctl{
     // UnionFind implementation
+UnionFind::UnionFind(size_t size) {
+    __grow(size);
+}
+
+void UnionFind::__grow(size_t size) const {
+    if (size <= parent_.size()) return;
+    const size_t old = parent_.size();
+    parent_.resize(size);
+    std::iota(parent_.begin() + old, parent_.end(), old);
+    rank_.resize(size, 0);
+}
+
 size_t UnionFind::find(size_t x) const {
-    auto it = parent_.find(x);
-    if (it == parent_.end()) {
-        parent_[x] = x;
+    if (x >= parent_.size()) {
+        __grow(x + 1);
         return x;
     }
-    
-    if (it->second != x) {
-        parent_[x] = find(it->second); // Path compression
+    // Path halving: every other node on the path skips to its grandparent
+    while (parent_[x] != x) {
+        parent_[x] = parent_[parent_[x]];
+        x = parent_[x];
     }
-    return parent_[x];
+    return x;
 }
 
 void UnionFind::unite(size_t x, size_t y) {
@@ -22,19 +36,13 @@ void UnionFind::unite(size_t x, size_t y) {
     if (root_x == root_y) return;
     
     // Union by rank
-    auto rank_x_it = rank_.find(root_x);
-    auto rank_y_it = rank_.find(root_y);
-    
-    size_t rank_x = (rank_x_it != rank_.end()) ? rank_x_it->second : 0;
-    size_t rank_y = (rank_y_it != rank_.end()) ? rank_y_it->second : 0;
-    
-    if (rank_x < rank_y) {
+    if (rank_[root_x] < rank_[root_y]) {
         parent_[root_x] = root_y;
-    } else if (rank_x > rank_y) {
+    } else if (rank_[root_x] > rank_[root_y]) {
         parent_[root_y] = root_x;
     } else {
         parent_[root_y] = root_x;
-        rank_[root_x] = rank_x + 1;
+        ++rank_[root_x];
     }
 }
 
@@ -43,19 +51,18 @@ bool UnionFind::connected(size_t x, size_t y) const {
 }
 
 std::vector<std::vector<size_t>> UnionFind::getEquivalenceClasses() const {
-    std::unordered_map<size_t, std::vector<size_t>> class_map;
-    
-    // Group elements by their root
-    for (const auto& [element, _] : parent_) {
-        size_t root = find(element);
-        class_map[root].push_back(element);
-    }
-    
+    // Class number by root, in order of the smallest member
+    constexpr size_t NONE = static_cast<size_t>(-1);
+    std::vector<size_t> class_of(parent_.size(), NONE);
     std::vector<std::vector<size_t>> classes;
-    for (const auto& [root, elements] : class_map) {
-        classes.push_back(elements);
+    for (size_t x = 0; x < parent_.size(); ++x) {
+        const size_t root = find(x);
+        if (class_of[root] == NONE) {
+            class_of[root] = classes.size();
+            classes.emplace_back();
+        }
+        classes[class_of[root]].push_back(x);
     }
-    
     return classes;
 }
 
@@ -1,4 +1,9 @@
 #include "utils.h"
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace ctl{
 
@@ -45,22 +50,48 @@ namespace ctl{
 
     
 
-    std::vector<std::string> loadPropertiesFromFile(const std::string& filename) {
-        std::vector<std::string> properties;
-        std::ifstream file(filename);
-        
-        if (!file.is_open()) {
+    MappedFile::MappedFile(const std::string& filename) {
+        const int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
             throw std::runtime_error("Cannot open file: " + filename);
         }
-        
-        std::string line;
-        while (std::getline(file, line)) {
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot stat file: " + filename);
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        if (size_ > 0) {
+            void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Cannot map file: " + filename);
+            }
+            data_ = static_cast<const char*>(data);
+        }
+        // The mapping stays valid after the descriptor is closed
+        close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+    }
+
+    std::vector<std::string_view> splitPropertyLines(std::string_view contents) {
+        std::vector<std::string_view> properties;
+        std::string_view rest = contents;
+        while (!rest.empty()) {
+            const size_t end = rest.find('\n');
+            std::string_view line = rest.substr(0, end);
+            rest = end == std::string_view::npos ? std::string_view{} : rest.substr(end + 1);
+
             // Trim whitespace
-            line.erase(0, line.find_first_not_of(" \t\r\n"));
-            line.erase(line.find_last_not_of(" \t\r\n") + 1);
+            const size_t first = line.find_first_not_of(" \t\r\n");
+            if (first == std::string_view::npos) continue;
+            line = line.substr(first, line.find_last_not_of(" \t\r\n") - first + 1);
             
-            // Skip empty lines and comments
-            if (!line.empty() && line[0] != '#' && line[0] != '/') {
+            // Skip comments
+            if (line[0] != '#' && line[0] != '/') {
                 properties.push_back(line);
             }
         }
@@ -68,6 +99,13 @@ namespace ctl{
         return properties;
     }
 
+    std::vector<std::string> loadPropertiesFromFile(const std::string& filename) {
+        // Lines are sliced out of the mapping; only kept properties are copied
+        MappedFile file(filename);
+        auto lines = splitPropertyLines(file.contents());
+        return std::vector<std::string>(lines.begin(), lines.end());
+    }
+
     std::string joinPaths(const std::string& path1, const std::string& path2) {
         if (path1.empty()) return path2;
         if (path2.empty()) return path1;
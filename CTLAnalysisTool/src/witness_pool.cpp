@@ -0,0 +1,217 @@
+#include "witness_pool.h"
+#include "CTLautomaton.h"
+#include "formula.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <optional>
+#include <unordered_set>
+
+namespace ctl {
+
+namespace {
+
+using States = std::vector<bool>;
+
+// The identifiers a guard or an atom mentions
+void collectIdentifiers(const std::string& text, std::unordered_set<std::string>& out) {
+    for (size_t i = 0; i < text.size();) {
+        if (std::isalpha(static_cast<unsigned char>(text[i])) || text[i] == '_') {
+            size_t j = i + 1;
+            while (j < text.size() && (std::isalnum(static_cast<unsigned char>(text[j])) || text[j] == '_')) ++j;
+            out.insert(text.substr(i, j - i));
+            i = j;
+        } else {
+            ++i;
+        }
+    }
+}
+
+// No temporal operator below: decided at a state from its guards alone
+bool isPropositional(const CTLFormula& formula) {
+    if (formula.getType() == FormulaType::TEMPORAL) return false;
+    for (const auto& child : formula.children()) {
+        if (!isPropositional(*child)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+struct WitnessPool::Entry {
+    Entry(Witness w, std::string k) : witness(std::move(w)), key(std::move(k)), open(witness.states.size()) {
+        // The open subtree is one more state, its own two successors
+        auto index = [this](uint32_t s) { return s == Witness::kUnconstrained ? open : s; };
+        for (const auto& state : witness.states) {
+            successors.push_back({index(state.left), index(state.right)});
+            identifiers.emplace_back();
+            for (const auto& guard : state.guards) collectIdentifiers(guard, identifiers.back());
+        }
+        successors.push_back({open, open});
+    }
+
+    // Whether the property definitely holds (positive) or definitely fails
+    // at the initial state
+    bool definitely(const CTLProperty& property, bool positive) {
+        const std::string key = property.toString();
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& known = verdicts[positive][key];
+        if (!known) known = __holds(property.getFormula(), positive)[0];
+        return *known;
+    }
+
+    Witness witness;
+    std::string key;  // its states, for duplicates
+    size_t open;  // index of the unconstrained state
+    std::vector<std::array<size_t, 2>> successors;
+    std::vector<std::unordered_set<std::string>> identifiers;  // mentioned by the guards, by state
+    std::mutex mutex;
+    std::array<std::unordered_map<std::string, std::optional<bool>>, 2> verdicts;  // by polarity, property text
+    std::array<std::unordered_map<std::string, States>, 2> entailments;             // by polarity, state formula
+
+private:
+    // The states where formula definitely holds (positive) or definitely fails
+    States __holds(const CTLFormula& formula, bool positive) {
+        const size_t n = successors.size();
+        if (auto literal = dynamic_cast<const BooleanLiteral*>(&formula)) return States(n, literal->value == positive);
+        // Asking the guards about a whole state formula keeps what its parts
+        // share: !(p & q) entails neither !p nor !q
+        if (isPropositional(formula)) return __entailed(formula.toString(), positive);
+        if (auto neg = dynamic_cast<const NegationFormula*>(&formula)) return __holds(*neg->operand, !positive);
+
+        // A conjunction holds where both parts hold and fails where either fails
+        auto meet = [positive](States x, const States& y) {
+            for (size_t s = 0; s < x.size(); ++s) x[s] = positive ? x[s] && y[s] : x[s] || y[s];
+            return x;
+        };
+        auto join = [positive](States x, const States& y) {
+            for (size_t s = 0; s < x.size(); ++s) x[s] = positive ? x[s] || y[s] : x[s] && y[s];
+            return x;
+        };
+        if (auto bin = dynamic_cast<const BinaryFormula*>(&formula)) {
+            switch (bin->operator_) {
+                case BinaryOperator::AND: return meet(__holds(*bin->left, positive), __holds(*bin->right, positive));
+                case BinaryOperator::OR: return join(__holds(*bin->left, positive), __holds(*bin->right, positive));
+                case BinaryOperator::IMPLIES: return join(__holds(*bin->left, !positive), __holds(*bin->right, positive));
+                default: return States(n, false);
+            }
+        }
+
+        auto temporal = dynamic_cast<const TemporalFormula*>(&formula);
+        // A bound would count steps, which the witness does not fix
+        if (!temporal || temporal->interval != TimeInterval()) return States(n, false);
+        const States first = __holds(*temporal->operand, positive);
+        const States second = temporal->second_operand ? __holds(*temporal->second_operand, positive) : first;
+        const TemporalOperator op = temporal->operator_;
+        const bool all_paths = op == TemporalOperator::AF || op == TemporalOperator::AG || op == TemporalOperator::AU ||
+                               op == TemporalOperator::AW || op == TemporalOperator::AX || op == TemporalOperator::AR;
+        // Where the formula fails, its dual holds: the other path quantifier,
+        // meet and join swapped, least and greatest fixpoints swapped
+        const bool universal = all_paths == positive;
+        auto next = [&](const States& x) {
+            States r(n);
+            for (size_t s = 0; s < n; ++s) {
+                const bool l = x[successors[s][0]], rr = x[successors[s][1]];
+                r[s] = universal ? l && rr : l || rr;
+            }
+            return r;
+        };
+        auto fixpoint = [n](bool least, auto step) {
+            States z(n, !least);
+            while (true) {
+                States next_z = step(z);
+                if (next_z == z) return z;
+                z = std::move(next_z);
+            }
+        };
+        switch (op) {
+            case TemporalOperator::EX:
+            case TemporalOperator::AX:
+                return next(first);
+            case TemporalOperator::EF:
+            case TemporalOperator::AF:  // mu Z. phi | X Z
+                return fixpoint(positive, [&](const States& z) { return join(first, next(z)); });
+            case TemporalOperator::EG:
+            case TemporalOperator::AG:  // nu Z. phi & X Z
+                return fixpoint(!positive, [&](const States& z) { return meet(first, next(z)); });
+            case TemporalOperator::EU:
+            case TemporalOperator::AU:  // mu Z. psi | (phi & X Z)
+                return fixpoint(positive, [&](const States& z) { return join(second, meet(first, next(z))); });
+            case TemporalOperator::EW:
+            case TemporalOperator::AW:  // nu Z. psi | (phi & X Z)
+                return fixpoint(!positive, [&](const States& z) { return join(second, meet(first, next(z))); });
+            case TemporalOperator::ER:
+            case TemporalOperator::AR:  // nu Z. psi & (phi | X Z)
+                return fixpoint(!positive, [&](const States& z) { return meet(second, join(first, next(z))); });
+        }
+        return States(n, false);
+    }
+
+    // Where the guards entail the state formula (positive) or its negation
+    const States& __entailed(const std::string& formula, bool positive) {
+        auto [it, inserted] = entailments[positive].try_emplace(formula);
+        if (inserted) {
+            States& entailed = it->second;
+            entailed.assign(successors.size(), false);
+            std::unordered_set<std::string> mentioned;
+            collectIdentifiers(formula, mentioned);
+            const std::string refutation = positive ? "!(" + formula + ")" : formula;
+            for (size_t s = 0; s < witness.states.size(); ++s) {
+                // Satisfiable guards over other variables leave the formula open
+                const auto& names = identifiers[s];
+                if (std::none_of(mentioned.begin(), mentioned.end(),
+                                 [&names](const std::string& name) { return names.count(name) > 0; })) {
+                    continue;
+                }
+                std::unordered_set<std::string> query(witness.states[s].guards.begin(), witness.states[s].guards.end());
+                query.insert(refutation);
+                entailed[s] = !CTLAutomaton::guardsSatisfiable(query);
+            }
+        }
+        return it->second;
+    }
+};
+
+bool WitnessPool::add(Witness witness) {
+    if (witness.states.empty()) return false;
+    // Pairs of a class often fail on the same model
+    std::string key;
+    for (const auto& state : witness.states) {
+        for (const auto& guard : state.guards) key += guard + '\n';
+        key += std::to_string(state.left) + ' ' + std::to_string(state.right) + '\n';
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (keys_.count(key)) return false;
+    }
+    auto entry = std::make_shared<Entry>(std::move(witness), key);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (!keys_.insert(key).second) return false;
+    entries_.push_back(std::move(entry));
+    if (entries_.size() > capacity_) {
+        keys_.erase(entries_.front()->key);
+        entries_.erase(entries_.begin());
+    }
+    return true;
+}
+
+bool WitnessPool::refutes(const CTLProperty& refining, const CTLProperty& refined) {
+    std::vector<std::shared_ptr<Entry>> entries;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        entries = entries_;
+    }
+    // Newest first: the latest refutations are the likeliest to recur
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        if ((*it)->definitely(refined, false) && (*it)->definitely(refining, true)) return true;
+    }
+    return false;
+}
+
+size_t WitnessPool::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return entries_.size();
+}
+
+} // namespace ctl
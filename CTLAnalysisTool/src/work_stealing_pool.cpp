@@ -0,0 +1,107 @@
+#include "work_stealing_pool.h"
+
+namespace ctl {
+
+WorkStealingPool::WorkStealingPool(size_t num_threads) {
+    if (num_threads == 0) num_threads = 1;
+    queues_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers_.emplace_back(&WorkStealingPool::__workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    size_t target;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        target = next_queue_;
+        next_queue_ = (next_queue_ + 1) % queues_.size();
+        ++pending_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    {
+        // Publish under the state lock so a worker about to sleep cannot miss it
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        queued_.fetch_add(1, std::memory_order_release);
+    }
+    work_available_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    all_done_.wait(lock, [this] { return pending_ == 0; });
+    if (first_error_) {
+        auto error = first_error_;
+        first_error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+bool WorkStealingPool::__popLocal(size_t worker_id, Task& task) {
+    auto& queue = *queues_[worker_id];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    queued_.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+bool WorkStealingPool::__steal(size_t thief_id, Task& task) {
+    const size_t n = queues_.size();
+    for (size_t offset = 1; offset < n; ++offset) {
+        auto& victim = *queues_[(thief_id + offset) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        // Steal from the opposite end so the owner keeps its cache-warm front
+        task = std::move(victim.tasks.back());
+        victim.tasks.pop_back();
+        queued_.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::__workerLoop(size_t worker_id) {
+    while (true) {
+        Task task;
+        if (__popLocal(worker_id, task) || __steal(worker_id, task)) {
+            std::exception_ptr error;
+            try {
+                task(worker_id);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            if (error && !first_error_) first_error_ = error;
+            if (--pending_ == 0) all_done_.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        work_available_.wait(lock, [this] {
+            return stopping_ || queued_.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping_ && queued_.load(std::memory_order_acquire) == 0) return;
+    }
+}
+
+} // namespace ctl
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "../include/analysis_server.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace ctl;
+
+namespace {
+
+bool contains(const std::string& answer, const std::string& part) {
+    return answer.find(part) != std::string::npos;
+}
+
+// The JSON list answer[key], as text
+std::string listField(const std::string& answer, const std::string& key) {
+    const size_t start = answer.find("\"" + key + "\":[");
+    if (start == std::string::npos) return "";
+    return answer.substr(start, answer.find(']', start) - start + 1);
+}
+
+} // namespace
+
+TEST(AnalysisServerTest, AnswersQueriesAgainstTheResidentSuite) {
+    AnalysisServer server;
+    std::string answer = server.handle("suite\tAG(p)\tAF(p)\tEF(p)\tAG(q)");
+    EXPECT_TRUE(contains(answer, "\"ok\":true")) << answer;
+    EXPECT_TRUE(contains(answer, "\"properties\":4")) << answer;
+
+    answer = server.handle("sat\tAG(p) & EF(!p)");
+    EXPECT_TRUE(contains(answer, "\"satisfiable\":false")) << answer;
+    answer = server.handle("sat\tEG(p)");
+    EXPECT_TRUE(contains(answer, "\"satisfiable\":true")) << answer;
+
+    EXPECT_TRUE(contains(server.handle("refines\tAG(p)\tAF(p)"), "\"refines\":true"));
+    EXPECT_TRUE(contains(server.handle("refines\tAF(p)\tAG(p)"), "\"refines\":false"));
+}
+
+TEST(AnalysisServerTest, InsertReportsTheRelationsOfTheNewProperty) {
+    AnalysisServer server;
+    server.handle("suite\tAG(p)\tAF(p)\tEF(p)\tAG(q)");
+
+    const std::string answer = server.handle("insert\tEG(p)");
+    ASSERT_TRUE(contains(answer, "\"satisfiable\":true")) << answer;
+    EXPECT_TRUE(contains(listField(answer, "refined_by"), "AG")) << answer;
+    EXPECT_TRUE(contains(listField(answer, "refines"), "EF")) << answer;
+    EXPECT_FALSE(contains(listField(answer, "refines"), "q")) << answer;
+    EXPECT_TRUE(contains(server.handle("stats"), "\"properties\":5"));
+
+    EXPECT_TRUE(contains(server.handle("insert\tEG(p)"), "\"duplicate_of\""));
+    EXPECT_TRUE(contains(server.handle("insert\tp & !p"), "\"satisfiable\":false"));
+
+    EXPECT_TRUE(contains(server.handle("remove\tEG(p)"), "\"removed\":true"));
+    EXPECT_TRUE(contains(server.handle("remove\tEG(p)"), "\"removed\":false"));
+    EXPECT_TRUE(contains(server.handle("stats"), "\"properties\":4"));
+}
+
+TEST(AnalysisServerTest, KeepsOnlyTheMostRecentQueries) {
+    AnalysisServer server({}, 2);
+    server.handle("suite\tAG(p)\tAF(p)");
+    for (const char* formula : {"AG(a)", "EF(b)", "EF(c)", "EF(d)"}) {
+        EXPECT_TRUE(contains(server.handle(std::string("sat\t") + formula), "\"satisfiable\":true"));
+    }
+    EXPECT_TRUE(contains(server.handle("stats"), "\"queried\":2"));
+    // Suite members are looked up in the suite, not kept as queries
+    EXPECT_TRUE(contains(server.handle("refines\tAG(p)\tAF(p)"), "\"refines\":true"));
+    EXPECT_TRUE(contains(server.handle("stats"), "\"queried\":2"));
+    // An evicted formula is simply built again
+    const std::string answer = server.handle("refines\tAG(a)\tAF(a)");
+    EXPECT_TRUE(contains(answer, "\"refines\":true")) << answer;
+    EXPECT_TRUE(contains(server.handle("stats"), "\"queried\":2"));
+    // A new suite starts without the queries of the last one
+    server.handle("suite\tAG(q)\tEF(q)");
+    EXPECT_TRUE(contains(server.handle("stats"), "\"queried\":0"));
+    EXPECT_TRUE(contains(server.handle("refines\tAG(a)\tAF(a)"), "\"refines\":true"));
+}
+
+TEST(AnalysisServerTest, MalformedRequestsAreAnsweredWithAnError) {
+    AnalysisServer server;
+    EXPECT_TRUE(contains(server.handle("frobnicate"), "\"ok\":false"));
+    EXPECT_TRUE(contains(server.handle("refines\tAG(p)"), "\"ok\":false"));
+    EXPECT_TRUE(contains(server.handle("load\t/nonexistent/properties.txt"), "\"ok\":false"));
+    // The server keeps answering afterwards
+    EXPECT_TRUE(contains(server.handle("sat\tp"), "\"satisfiable\":true"));
+}
+
+TEST(AnalysisServerTest, ServesRequestsOverAUnixSocket) {
+    const std::string path = (std::filesystem::temp_directory_path() /
+                              ("ctl_server_" + std::to_string(getpid()) + ".sock")).string();
+    AnalysisServer server;
+    std::thread serving([&server, &path] { server.serve(path); });
+
+    int fd = -1;
+    for (int attempt = 0; attempt < 200 && fd < 0; ++attempt) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            fd = -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    ASSERT_GE(fd, 0);
+
+    const std::string requests = "suite\tAG(p)\tAF(p)\r\nrefines\tAG(p)\tAF(p)\nshutdown\n";
+    ASSERT_EQ(write(fd, requests.data(), requests.size()), static_cast<ssize_t>(requests.size()));
+    std::string answers;
+    char chunk[1024];
+    for (ssize_t n; (n = read(fd, chunk, sizeof(chunk))) > 0;) answers.append(chunk, static_cast<size_t>(n));
+    close(fd);
+    serving.join();
+
+    EXPECT_EQ(std::count(answers.begin(), answers.end(), '\n'), 3);
+    EXPECT_TRUE(contains(answers, "\"properties\":2")) << answers;
+    EXPECT_TRUE(contains(answers, "\"refines\":true")) << answers;
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
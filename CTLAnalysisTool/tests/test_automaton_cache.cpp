@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "../include/automaton_cache.h"
+#include "../include/property.h"
+#include "../include/statistics.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace ctl;
+
+namespace {
+
+// A fresh cache directory, removed and the cache disabled at the end of the test
+class AutomatonCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        directory_ = std::filesystem::temp_directory_path() /
+                     ("ctl_automaton_cache_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                      "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(directory_);
+        AutomatonCache::instance().setDirectory(directory_.string());
+    }
+    void TearDown() override {
+        AutomatonCache::instance().setDirectory("");
+        std::filesystem::remove_all(directory_);
+    }
+
+    static uint64_t count(const StatisticValues& delta, Statistic statistic) {
+        return delta[static_cast<size_t>(statistic)];
+    }
+
+    std::filesystem::path directory_;
+};
+
+void expectSameAutomaton(const CTLAutomaton& built, const CTLAutomaton& loaded) {
+    ASSERT_EQ(built.numStates(), loaded.numStates());
+    EXPECT_EQ(built.getInitialStateId(), loaded.getInitialStateId());
+    for (StateId id = 0; id < built.numStates(); ++id) {
+        EXPECT_EQ(built.getStateName(id), loaded.getStateName(id));
+        EXPECT_EQ(built.isAccepting(id), loaded.isAccepting(id));
+        auto a = built.getSuccessors(id), b = loaded.getSuccessors(id);
+        EXPECT_TRUE(std::equal(a.begin(), a.end(), b.begin(), b.end()));
+
+        auto ta = built.getTransitions(id), tb = loaded.getTransitions(id);
+        ASSERT_EQ(ta.size(), tb.size());
+        for (size_t t = 0; t < ta.size(); ++t) {
+            EXPECT_EQ(ta[t]->guard, tb[t]->guard);
+            EXPECT_EQ(ta[t]->is_dnf, tb[t]->is_dnf);
+            ASSERT_EQ(ta[t]->clauses.size(), tb[t]->clauses.size());
+            for (size_t c = 0; c < ta[t]->clauses.size(); ++c) {
+                const auto& la = ta[t]->clauses[c].literals;
+                const auto& lb = tb[t]->clauses[c].literals;
+                ASSERT_EQ(la.size(), lb.size());
+                for (size_t l = 0; l < la.size(); ++l) {
+                    EXPECT_EQ(la[l].dir, lb[l].dir);
+                    EXPECT_EQ(la[l].qid, lb[l].qid);
+                    EXPECT_EQ(la[l].qnext, lb[l].qnext);
+                }
+            }
+        }
+        EXPECT_EQ(built.getExpandedTransitions(id), loaded.getExpandedTransitions(id));
+    }
+}
+
+} // namespace
+
+TEST_F(AutomatonCacheTest, LoadedAutomatonMatchesTheBuiltOne) {
+    const char* formula = "AG(p -> AF(q & x <= 3)) & E(p U !q)";
+    auto built = std::make_shared<CTLProperty>(formula);
+    StatisticValues before = Statistics::instance().snapshot();
+    auto first = built->automatonHandle();
+    StatisticValues delta = Statistics::instance().snapshot() - before;
+    EXPECT_EQ(count(delta, Statistic::AUTOMATA_BUILT), 1u);
+    EXPECT_EQ(count(delta, Statistic::AUTOMATA_LOADED), 0u);
+    // Expanded moves reach the file once the automaton is updated
+    for (StateId id = 0; id < first->numStates(); ++id) first->getExpandedTransitions(id);
+    AutomatonCache::instance().update(*first);
+
+    auto loaded = std::make_shared<CTLProperty>(formula);
+    before = Statistics::instance().snapshot();
+    auto second = loaded->automatonHandle();
+    delta = Statistics::instance().snapshot() - before;
+    EXPECT_EQ(count(delta, Statistic::AUTOMATA_BUILT), 0u);
+    EXPECT_EQ(count(delta, Statistic::AUTOMATA_LOADED), 1u);
+    // The moves come from the file, so expanding them asks no solver
+    before = Statistics::instance().snapshot();
+    for (StateId id = 0; id < second->numStates(); ++id) second->getExpandedTransitions(id);
+    delta = Statistics::instance().snapshot() - before;
+    EXPECT_EQ(count(delta, Statistic::SMT_QUERIES), 0u);
+
+    expectSameAutomaton(*first, *second);
+    EXPECT_EQ(second->isEmpty(), first->isEmpty());
+    auto weaker = std::make_shared<CTLProperty>("AG(p -> AF(q))");
+    EXPECT_EQ(loaded->refines(*weaker, false, false), built->refines(*weaker, false, false));
+}
+
+TEST_F(AutomatonCacheTest, DamagedFilesAreRebuilt) {
+    const char* formula = "EG(a | b) & AF(c)";
+    CTLProperty(formula).automatonHandle();
+    ASSERT_FALSE(std::filesystem::is_empty(directory_));
+    for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+        const auto size = std::filesystem::file_size(entry.path());
+        std::filesystem::resize_file(entry.path(), size / 2);
+    }
+
+    const StatisticValues before = Statistics::instance().snapshot();
+    auto automaton = CTLProperty(formula).automatonHandle();
+    const StatisticValues delta = Statistics::instance().snapshot() - before;
+    EXPECT_EQ(count(delta, Statistic::AUTOMATA_LOADED), 0u);
+    EXPECT_EQ(count(delta, Statistic::AUTOMATA_BUILT), 1u);
+    EXPECT_GT(automaton->numStates(), 0u);
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+#include "../include/bdd.h"
+#include "../include/SMTInterfaces/BDDSMTInterface.h"
+#include "../include/smt_context_manager.h"
+#include "../include/property.h"
+
+using namespace ctl;
+
+TEST(BddManagerTest, EqualFunctionsShareOneNode) {
+    BddManager m;
+    auto p = m.variable("p"), q = m.variable("q");
+    EXPECT_EQ(m.conj(p, q), m.conj(q, p));
+    EXPECT_EQ(m.negate(m.conj(p, q)), m.disj(m.negate(p), m.negate(q)));
+    EXPECT_EQ(m.conj(p, m.negate(p)), BddManager::FALSE_NODE);
+    EXPECT_EQ(m.disj(p, m.negate(p)), BddManager::TRUE_NODE);
+    EXPECT_TRUE(m.implies(m.conj(p, q), p));
+    EXPECT_FALSE(m.implies(p, m.conj(p, q)));
+    EXPECT_EQ(m.numVariables(), 2u);
+}
+
+TEST(BDDSMTInterfaceTest, PropositionalGuardsNeverReachTheSolver) {
+    BDDSMTInterface smt;
+    EXPECT_TRUE(smt.isSatisfiable("p & !q"));
+    EXPECT_FALSE(smt.isSatisfiable("p & !p"));
+    EXPECT_FALSE(smt.isSatisfiable(std::unordered_set<std::string>{"(p | q)", "!p", "!q"}));
+    EXPECT_TRUE(*smt.entails("p & q", "p | r"));
+    EXPECT_TRUE(*smt.equivalent("p -> q", "!p | q"));
+    EXPECT_EQ(smt.fallbackQueries(), 0u);
+}
+
+TEST(BDDSMTInterfaceTest, ComparisonsFallBackToSmt) {
+    BDDSMTInterface smt;
+    EXPECT_FALSE(smt.toBdd("x <= 3").has_value());
+    EXPECT_FALSE(smt.entails("x <= 3", "p").has_value());
+    EXPECT_FALSE(smt.isSatisfiable(std::unordered_set<std::string>{"x <= 3", "x >= 5"}));
+    EXPECT_TRUE(smt.isSatisfiable(std::unordered_set<std::string>{"x <= 3", "p"}));
+    EXPECT_EQ(smt.fallbackQueries(), 2u);
+    // A contradictory propositional part decides without the solver
+    EXPECT_FALSE(smt.isSatisfiable(std::unordered_set<std::string>{"x <= 3", "p", "!p"}));
+    EXPECT_EQ(smt.fallbackQueries(), 2u);
+}
+
+TEST(BDDSMTInterfaceTest, RefinementVerdictsMatchSmt) {
+    SMTContextManager::setPropositionalGuards(true);
+    EXPECT_TRUE(CTLProperty("AG(p & q)").automaton().languageIncludes(CTLProperty("AG(p & q & r)").automaton()));
+    EXPECT_TRUE(CTLProperty("AG(p & !p)").isEmpty());
+    EXPECT_FALSE(CTLProperty("EF(x <= 3) & AG(p)").isEmpty());
+    SMTContextManager::setPropositionalGuards(false);
+}
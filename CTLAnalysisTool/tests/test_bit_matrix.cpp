@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "../include/bit_matrix.h"
+#include "../include/refinement_closure.h"
+#include "../include/refinement_graph.h"
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <thread>
+#include <unistd.h>
+
+using namespace ctl;
+
+TEST(BitMatrixTest, OrRowReportsChanges) {
+    BitMatrix m(3, 130);
+    m.set(1, 0);
+    m.set(1, 129);
+    EXPECT_TRUE(m.orRow(0, 1));
+    EXPECT_TRUE(m.test(0, 0));
+    EXPECT_TRUE(m.test(0, 129));
+    EXPECT_FALSE(m.orRow(0, 1));
+    EXPECT_FALSE(m.orRow(0, 2));
+    EXPECT_EQ(m.count(), 4u);
+}
+
+TEST(BitMatrixTest, AtomicRowsMergeConcurrently) {
+    const size_t n = 256;
+    AtomicBitMatrix m(n);
+    for (size_t c = 0; c < n; ++c) m.set(c % 4 + 1, c);
+
+    std::vector<std::thread> threads;
+    for (size_t src = 1; src <= 4; ++src) {
+        threads.emplace_back([&m, src] { m.orRow(0, src); });
+    }
+    for (auto& t : threads) t.join();
+
+    for (size_t c = 0; c < n; ++c) EXPECT_TRUE(m.test(0, c)) << c;
+    EXPECT_FALSE(m.test(5, 0));
+}
+
+TEST(RefinementGraphTest, EdgesAreDeduplicated) {
+    RefinementGraph graph;
+    for (const char* f : {"AG(p)", "EF(p)", "p"}) graph.addNode(CTLProperty::create(f));
+    graph.addEdge(0, 1);
+    graph.addEdge(0, 1);
+    graph.addEdge(2, 1);
+    EXPECT_EQ(graph.getEdgeCount(), 2u);
+    EXPECT_TRUE(graph.hasEdge(0, 1));
+    EXPECT_FALSE(graph.hasEdge(1, 0));
+    EXPECT_FALSE(graph.hasEdge(0, 7));
+
+    // Nodes added after edges keep the existing edges visible
+    graph.addNode(CTLProperty::create("q"));
+    EXPECT_TRUE(graph.hasEdge(2, 1));
+    graph.addEdge(3, 0);
+    EXPECT_TRUE(graph.hasEdge(0, 1));
+    EXPECT_TRUE(graph.hasEdge(3, 0));
+    EXPECT_EQ(graph.getEdgeCount(), 3u);
+}
+
+TEST(RefinementGraphTest, KeepsTheTransitiveReduction) {
+    RefinementGraph graph;
+    for (const char* f : {"AG(p & q)", "AG(p)", "AF(p)", "EF(p)", "AG(q & p)"}) graph.addNode(CTLProperty::create(f));
+    // A closed chain 0 -> 1 -> 2 -> 3, with 4 equivalent to 0
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = i + 1; j < 4; ++j) graph.addEdge(i, j);
+        if (i > 0) graph.addEdge(4, i);
+    }
+    graph.addEdge(0, 4);
+    graph.addEdge(4, 0);
+    EXPECT_EQ(graph.getEdgeCount(), 11u);
+    EXPECT_TRUE(graph.hasEdge(0, 3));
+
+    std::set<std::pair<size_t, size_t>> reduction;
+    for (const auto& edge : graph.getEdges()) reduction.emplace(edge.from, edge.to);
+    EXPECT_EQ(reduction, (std::set<std::pair<size_t, size_t>>{{0, 4}, {4, 0}, {0, 1}, {1, 2}, {2, 3}}));
+    EXPECT_EQ(graph.getRecordedEdges().size(), 11u);
+    EXPECT_EQ(graph.findStronglyConnectedComponents().size(), 4u);
+
+    const std::string dot = "/tmp/reduction_" + std::to_string(::getpid()) + ".dot";
+    graph.toDot(dot);
+    std::ifstream in(dot);
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    size_t arrows = 0;
+    for (size_t pos = text.find("->"); pos != std::string::npos; pos = text.find("->", pos + 2)) ++arrows;
+    EXPECT_EQ(arrows, 5u);
+
+    // Paths follow recorded edges that were never closed
+    graph.addNode(CTLProperty::create("EF(p | q)"));
+    graph.addEdge(3, 5);
+    EXPECT_FALSE(graph.hasEdge(0, 5));
+    EXPECT_TRUE(graph.hasPath(0, 5));
+    EXPECT_FALSE(graph.hasPath(5, 0));
+    EXPECT_EQ(graph.getEdges().size(), 6u);
+}
+
+TEST(RefinementClosureTest, PropagatesBothPolarities) {
+    using Closure = RefinementClosure<BitMatrix>;
+    Closure closure(4);
+    closure.addRefines(1, 2);
+    closure.addRefines(0, 1);
+    EXPECT_EQ(closure.infer(0, 2), Closure::Inference::IMPLIED);
+
+    // 1->2 and not 3->2 gives not 3->1
+    closure.addRefuted(3, 2);
+    EXPECT_EQ(closure.infer(3, 1), Closure::Inference::REFUTED_BY_TARGET);
+    // 0->1 and not 0->3 gives not 1->3
+    closure.addRefuted(0, 3);
+    EXPECT_EQ(closure.infer(1, 3), Closure::Inference::REFUTED_BY_SOURCE);
+    // Refutations are recorded and feed further inferences
+    EXPECT_EQ(closure.infer(2, 3), Closure::Inference::REFUTED_BY_SOURCE);
+    EXPECT_EQ(closure.infer(2, 0), Closure::Inference::UNKNOWN);
+    EXPECT_FALSE(closure.refines(3, 1));
+}
+
+TEST(RefinementClosureTest, ConcurrentFactsStaySound) {
+    using Closure = RefinementClosure<AtomicBitMatrix>;
+    const size_t n = 96;
+    Closure closure(n);
+    // A chain 0->1->...->n-1, recorded from both ends at once
+    std::thread low([&] { for (size_t i = 0; i + 1 < n / 2; ++i) closure.addRefines(i, i + 1); });
+    std::thread high([&] { for (size_t i = n - 1; i-- > n / 2 - 1; ) closure.addRefines(i, i + 1); });
+    low.join();
+    high.join();
+    for (size_t i = 0; i + 1 < n; ++i) EXPECT_TRUE(closure.refines(i, i + 1));
+    EXPECT_TRUE(closure.refines(n / 2 - 1, n - 1));
+    EXPECT_EQ(closure.infer(n - 1, 0), Closure::Inference::UNKNOWN);
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "../include/cancellation.h"
+#include "../include/property.h"
+#include "../include/refinement_graph.h"
+#include "../include/Analyzers/Refinement.h"
+
+#include <memory>
+
+using namespace ctl;
+
+TEST(CancellationTest, CheckpointWithoutTokenIsNoOp) {
+    EXPECT_EQ(CancellationToken::current(), nullptr);
+    EXPECT_NO_THROW(cancellation::checkpoint());
+    EXPECT_FALSE(cancellation::remaining().has_value());
+}
+
+TEST(CancellationTest, ScopeInstallsAndRestoresToken) {
+    CancellationToken outer;
+    CancellationToken inner(std::chrono::milliseconds(0));
+    {
+        CancellationScope outer_scope(&outer);
+        EXPECT_NO_THROW(cancellation::checkpoint());
+        {
+            CancellationScope inner_scope(&inner);
+            EXPECT_EQ(CancellationToken::current(), &inner);
+            EXPECT_THROW(cancellation::checkpoint(), CheckCancelled);
+            EXPECT_EQ(cancellation::remaining(), std::chrono::milliseconds(0));
+        }
+        EXPECT_EQ(CancellationToken::current(), &outer);
+        outer.cancel();
+        EXPECT_THROW(cancellation::checkpoint(), CheckCancelled);
+    }
+    EXPECT_EQ(CancellationToken::current(), nullptr);
+}
+
+TEST(CancellationTest, ExpiredTokenCancelsSemanticRefinement) {
+    CTLProperty refining("AG(p)");
+    CTLProperty refined("AF(p | q)");
+    CancellationToken expired(std::chrono::milliseconds(0));
+    EXPECT_THROW(refining.refines(refined, false, false, EmptinessEngine::FIXPOINT, &expired), CheckCancelled);
+    EXPECT_THROW(refining.refines(refined, false, true, EmptinessEngine::FIXPOINT, &expired), CheckCancelled);
+    // The cancelled check left nothing behind: without a token it completes
+    // with the verdict of properties that never saw one
+    CTLProperty fresh_refining("AG(p)");
+    CTLProperty fresh_refined("AF(p | q)");
+    EXPECT_EQ(refining.refines(refined, false, true), fresh_refining.refines(fresh_refined, false, true));
+    EXPECT_TRUE(refining.refines(refined, false, true));
+}
+
+TEST(CancellationTest, UnknownEdgesAreKeptApartFromRefinements) {
+    RefinementGraph graph;
+    graph.addNode(std::make_shared<CTLProperty>("AG(p)"));
+    graph.addNode(std::make_shared<CTLProperty>("AF(p)"));
+    graph.addEdge(0, 1);
+    graph.addUnknownEdge(1, 0);
+    graph.addUnknownEdge(1, 0);
+
+    EXPECT_TRUE(graph.hasEdge(0, 1));
+    EXPECT_FALSE(graph.hasEdge(1, 0));
+    EXPECT_TRUE(graph.isUnknown(1, 0));
+    EXPECT_FALSE(graph.isUnknown(0, 1));
+    EXPECT_EQ(graph.getEdgeCount(), 1u);
+    EXPECT_EQ(graph.getUnknownEdges().size(), 1u);
+    EXPECT_THROW(graph.addUnknownEdge(0, 2), std::out_of_range);
+}
+
+TEST(CancellationTest, GenerousTimeoutKeepsTheAnalysis) {
+    const std::vector<std::string> formulas{"AG(p)", "AF(p)", "AG(p & q)", "EF(q)"};
+    RefinementAnalyzer unbounded(formulas);
+    unbounded.setSyntacticRefinement(false);
+    AnalysisResult expected = unbounded.analyze();
+
+    RefinementAnalyzer bounded(formulas);
+    bounded.setSyntacticRefinement(false);
+    bounded.setCheckTimeout(std::chrono::minutes(1));
+    AnalysisResult result = bounded.analyze();
+
+    EXPECT_EQ(result.total_refinements, expected.total_refinements);
+    EXPECT_EQ(result.unknown_refinements, 0u);
+}
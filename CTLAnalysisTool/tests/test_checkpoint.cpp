@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "../include/run_checkpoint.h"
+#include "../include/Analyzers/Refinement.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace ctl;
+
+namespace {
+
+std::string checkpointPath(const std::string& name) {
+    std::string path = testing::TempDir() + "ctl_" + name + ".bin";
+    std::remove(path.c_str());
+    return path;
+}
+
+} // end anonymous namespace
+
+TEST(RunCheckpointTest, RoundTripsThroughTheFile) {
+    const std::string path = checkpointPath("round_trip");
+    {
+        RunCheckpoint checkpoint(path, std::chrono::seconds(60));
+        EXPECT_FALSE(checkpoint.begin(42, true));  // nothing saved yet
+        checkpoint.storeSatisfiable("AG(p)", true);
+        checkpoint.storeSatisfiable("p & !p", false);
+        checkpoint.storeRefinement("AG(p)", "AF(p)", true);
+        checkpoint.storeRefinement("AF(p)", "AG(p)", false);
+        checkpoint.storeClass({"AG(p)", "AF(p)"}, {{{0, 1}}, {}});
+        checkpoint.storeClass({"EF(q)", "EG(q)", "q"}, {{{1, 0}}, {{2, 0}}});
+        checkpoint.save();
+    }
+
+    RunCheckpoint restored(path, std::chrono::seconds(60));
+    ASSERT_TRUE(restored.begin(42, true));
+    EXPECT_EQ(restored.lookupSatisfiable("AG(p)"), true);
+    EXPECT_EQ(restored.lookupSatisfiable("p & !p"), false);
+    EXPECT_FALSE(restored.lookupSatisfiable("EF(q)").has_value());
+    EXPECT_EQ(restored.lookupRefinement("AG(p)", "AF(p)"), true);
+    EXPECT_EQ(restored.lookupRefinement("AF(p)", "AG(p)"), false);
+    EXPECT_FALSE(restored.lookupRefinement("AG(p)", "EF(q)").has_value());
+    EXPECT_EQ(restored.decidedPairs(), 2u);
+
+    auto finished = restored.lookupClass({"EF(q)", "EG(q)", "q"});
+    ASSERT_TRUE(finished.has_value());
+    EXPECT_EQ(finished->edges, (std::vector<RunCheckpoint::Edge>{{1, 0}}));
+    EXPECT_EQ(finished->unknown_edges, (std::vector<RunCheckpoint::Edge>{{2, 0}}));
+    // Same members in another order are another class
+    EXPECT_FALSE(restored.lookupClass({"EG(q)", "EF(q)", "q"}).has_value());
+    std::remove(path.c_str());
+}
+
+TEST(RunCheckpointTest, IgnoresOtherRunsAndDamagedFiles) {
+    const std::string path = checkpointPath("other_run");
+    {
+        RunCheckpoint checkpoint(path, std::chrono::seconds(60));
+        checkpoint.begin(1, false);
+        checkpoint.storeRefinement("AG(p)", "AF(p)", true);
+        checkpoint.save();
+    }
+    RunCheckpoint other(path, std::chrono::seconds(60));
+    EXPECT_FALSE(other.begin(2, true));
+    EXPECT_EQ(other.decidedPairs(), 0u);
+    RunCheckpoint fresh(path, std::chrono::seconds(60));
+    EXPECT_FALSE(fresh.begin(1, false));
+    EXPECT_EQ(fresh.decidedPairs(), 0u);
+
+    // A truncated file is not restored
+    std::ifstream in(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(data.data(), data.size() - 3);
+    RunCheckpoint damaged(path, std::chrono::seconds(60));
+    EXPECT_FALSE(damaged.begin(1, true));
+    EXPECT_EQ(damaged.decidedPairs(), 0u);
+    std::remove(path.c_str());
+}
+
+TEST(RunCheckpointTest, ResumedAnalysisSkipsFinishedWork) {
+    const std::string path = checkpointPath("analysis");
+    const std::vector<std::string> formulas{"AG(p)", "AF(p)", "AG(p & q)", "EF(q)", "AG(r)", "AF(r | s)"};
+
+    RefinementAnalyzer first(formulas);
+    first.setParallelAnalysis(false);
+    first.setCheckpoint(path, std::chrono::seconds(3600), false);
+    AnalysisResult expected = first.analyze();
+    ASSERT_GT(first.getCheckpoint()->finishedClasses(), 0u);
+
+    RefinementAnalyzer resumed(formulas);
+    resumed.setParallelAnalysis(false);
+    resumed.setCheckpoint(path, std::chrono::seconds(3600), true);
+    AnalysisResult result = resumed.analyze();
+
+    EXPECT_EQ(result.total_refinements, expected.total_refinements);
+    EXPECT_EQ(result.equivalence_classes, expected.equivalence_classes);
+    ASSERT_EQ(resumed.getRefinementGraphs().size(), first.getRefinementGraphs().size());
+    for (size_t c = 0; c < first.getRefinementGraphs().size(); ++c) {
+        EXPECT_EQ(resumed.getRefinementGraphs()[c].getEdgeCount(), first.getRefinementGraphs()[c].getEdgeCount());
+    }
+    // Satisfiability and every class came from the checkpoint
+    EXPECT_EQ(resumed.getHotPathStatistics()[static_cast<size_t>(Statistic::AUTOMATA_BUILT)], 0u);
+    EXPECT_EQ(resumed.getHotPathStatistics()[static_cast<size_t>(Statistic::SIMULATION_CHECKS)], 0u);
+    std::remove(path.c_str());
+}
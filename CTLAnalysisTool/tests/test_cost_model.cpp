@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include "../include/cost_model.h"
+#include "../include/Analyzers/Refinement.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+using namespace ctl;
+
+namespace {
+
+std::string samplesPath(const std::string& name) {
+    std::string path = testing::TempDir() + "ctl_cost_" + name + ".csv";
+    std::remove(path.c_str());
+    return path;
+}
+
+} // end anonymous namespace
+
+TEST(CostModelTest, FeaturesCountTheOperatorMix) {
+    auto property = CTLProperty::create("AG(p -> AF(q)) & EX(r) & E(p U q)");
+    auto features = CostModel::features(*property, false);
+    EXPECT_EQ(features.size, static_cast<double>(property->size()));
+    EXPECT_EQ(features.least, 2.0);     // AF, EU
+    EXPECT_EQ(features.greatest, 1.0);  // AG
+    EXPECT_EQ(features.next, 1.0);      // EX
+
+    // Automata have no next states; read the rest off a built one
+    auto buildable = CTLProperty::create("AG(p -> AF(q)) & E(p U q)");
+    EXPECT_EQ(CostModel::features(*buildable).states, static_cast<double>(buildable->size()));
+    buildable->automaton();
+    auto built = CostModel::features(*buildable);
+    EXPECT_EQ(built.states, static_cast<double>(buildable->automaton().numStates()));
+    EXPECT_GT(built.moves, 0.0);
+}
+
+TEST(CostModelTest, DefaultWeightsRankLargerPairsHigher) {
+    CostModel model;
+    auto small = CostModel::features(*CTLProperty::create("AG(p)"), false);
+    auto large = CostModel::features(*CTLProperty::create("AG(p -> AF(q & EF(r | AG(s))))"), false);
+    EXPECT_GT(model.estimate(large, large), model.estimate(small, large));
+    EXPECT_GT(model.estimate(small, large), model.estimate(small, small));
+
+    // The class total is the sum over ordered pairs
+    std::vector<CostModel::Features> members{small, large, small};
+    std::vector<double> rows;
+    const double total = model.classCost(members, &rows);
+    double expected = 0.0;
+    for (size_t i = 0; i < members.size(); ++i) {
+        double row = 0.0;
+        for (size_t j = 0; j < members.size(); ++j) {
+            if (i != j) row += model.estimate(members[i], members[j]);
+        }
+        EXPECT_NEAR(rows[i], row, 1e-9 * row);
+        expected += row;
+    }
+    EXPECT_NEAR(total, expected, 1e-9 * expected);
+}
+
+TEST(CostModelTest, CalibrationFitsRecordedTimes) {
+    // Times that grow with the product of the state counts
+    CostModel recorder;
+    recorder.setRecording(true);
+    for (int a = 1; a <= 8; ++a) {
+        for (int b = 1; b <= 8; ++b) {
+            CostModel::Features refining{static_cast<double>(a), static_cast<double>(3 * a), static_cast<double>(a),
+                                         static_cast<double>(a % 3), 1, 0};
+            CostModel::Features refined{static_cast<double>(b), static_cast<double>(3 * b), static_cast<double>(b), 0,
+                                        static_cast<double>(b % 2), 0};
+            const double micros = 20.0 * (1 + refining.states) * (1 + refined.states) - 1;
+            recorder.record(refining, refined, std::chrono::microseconds(static_cast<long long>(micros)));
+        }
+    }
+    const std::string path = samplesPath("fit");
+    recorder.writeSamples(path);
+
+    CostModel model;
+    EXPECT_EQ(model.calibrate(path), 64u);
+    EXPECT_TRUE(model.calibrated());
+    CostModel::Features probe{5, 15, 5, 2, 1, 0};
+    CostModel::Features target{4, 12, 4, 0, 0, 0};
+    const double actual = 20.0 * 16 * 13;
+    EXPECT_NEAR(model.estimate(probe, target), actual, 0.25 * actual);
+
+    // Too few samples leave the model alone
+    const std::string few = samplesPath("few");
+    std::ofstream(few) << "garbage\n1,2,3,4,5,6,1,2,3,4,5,6,100\n";
+    CostModel untouched;
+    EXPECT_EQ(untouched.calibrate(few), 0u);
+    EXPECT_FALSE(untouched.calibrated());
+    std::remove(path.c_str());
+    std::remove(few.c_str());
+}
+
+TEST(CostModelTest, SchedulingKeepsTheResult) {
+    const std::vector<std::string> formulas{
+        "AG(p)", "AF(p)", "AG(p & q)", "EF(q)", "AG(q)", "EF(p & q)", "AG(r -> AF(s))", "AF(r | s)", "EF(s)"};
+    RefinementAnalyzer serial(formulas);
+    serial.setParallelAnalysis(false);
+    AnalysisResult expected = serial.analyze();
+
+    for (bool transitive : {true, false}) {
+        RefinementAnalyzer parallel(formulas);
+        parallel.setThreads(4);
+        parallel.setUseTransitiveOptimization(transitive);
+        parallel.getCostModel().setRecording(true);
+        EXPECT_EQ(parallel.analyze().total_refinements, expected.total_refinements);
+        if (!transitive) {
+            EXPECT_GT(parallel.getCostModel().samples(), 0u);
+        }
+    }
+}
@@ -35,6 +35,22 @@ TEST(CTLSATParserTest, ComparisonToAtom) {
     EXPECT_EQ(mapping.at("y > 3"), "b");
 }
 
+// Test translations under one mapping combine into the translated query
+TEST(CTLSATParserTest, RefinementQueryFromTranslations) {
+    CTLSATParser::Mapping mapping;
+    std::string refining = CTLSATParser::convertString("AG(x <= 5 & p)", mapping);
+    std::string refined = CTLSATParser::convertString("EF(p | q)", mapping);
+    EXPECT_EQ(refining, "AG((a ^ b))");
+    EXPECT_EQ(refined, "EF((b v c))");
+
+    CTLSATParser::clearComparisonMapping();
+    EXPECT_EQ(CTLSATParser::refinementQuery(refining, refined),
+              CTLSATParser::convertString("(AG(x <= 5 & p)) & !(EF(p | q))"));
+    // The explicit mapping leaves the per-thread one alone
+    EXPECT_EQ(mapping.comparisons.size(), 1u);
+    EXPECT_EQ(mapping.atoms.size(), 2u);
+}
+
 // Test boolean literals
 TEST(CTLSATParserTest, BooleanTrue) {
     auto formula = Parser::parseFormula("true");
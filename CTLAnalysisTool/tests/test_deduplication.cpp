@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include "../include/Analyzers/Refinement.h"
+#include "../include/Analyzers/SAT.h"
+#include "../include/refinement_cache.h"
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+using namespace ctl;
+
+namespace {
+
+std::shared_ptr<RefinementCache> tempCache() {
+    char templ[] = "/tmp/ctl_dedup_testXXXXXX";
+    return std::make_shared<RefinementCache>(mkdtemp(templ));
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+} // namespace
+
+TEST(DeduplicationTest, EqualNormalFormsAreAnalyzedOnce) {
+    // EF(p) and E(true U p), AG(p) and !!AG(p) normalize to the same formula
+    auto cache = tempCache();
+    for (const auto& f : {"EF(p)", "AG(p)"}) cache->storeSatisfiable("automaton", CTLProperty(f).toString(), true);
+    cache->storeRefinement("simulation", CTLProperty("AG(p)").toString(), CTLProperty("EF(p)").toString(), true);
+    cache->storeRefinement("simulation", CTLProperty("EF(p)").toString(), CTLProperty("AG(p)").toString(), false);
+
+    RefinementAnalyzer analyzer(std::vector<std::string>{"EF(p)", "AG(p)", "E(true U p)", "!!AG(p)"});
+    analyzer.setParallelAnalysis(false);
+    analyzer.setSyntacticRefinement(false);
+    analyzer.setUsePrefilter(false);
+    analyzer.setCache(cache);
+    auto result = analyzer.analyze();
+
+    EXPECT_EQ(result.total_properties, 4u);
+    EXPECT_EQ(result.duplicate_properties, 2u);
+    EXPECT_EQ(analyzer.getProperties().size(), 2u);
+    EXPECT_EQ(result.total_refinements, 1u);
+    EXPECT_EQ(cache->misses(), 0u);
+
+    const auto& inputs = analyzer.getInputProperties();
+    const auto& representatives = analyzer.getInputRepresentatives();
+    ASSERT_EQ(inputs.size(), 4u);
+    EXPECT_EQ(representatives[2], inputs[0]);
+    EXPECT_EQ(representatives[3], inputs[1]);
+
+    char dir[] = "/tmp/ctl_dedup_outXXXXXX";
+    const std::string out = mkdtemp(dir);
+    analyzer.writeDuplicateProperties(out + "/duplicates.csv");
+    const std::string csv = readFile(out + "/duplicates.csv");
+    EXPECT_NE(csv.find("2,\"" + inputs[2]->toString() + "\",0"), std::string::npos);
+    EXPECT_NE(csv.find("3,\"" + inputs[3]->toString() + "\",1"), std::string::npos);
+}
+
+TEST(DeduplicationTest, InputOrderDoesNotChooseTheRepresentative) {
+    // !(EF(!p)) and AG(p) share a normal form, but simulation proves
+    // AG(p) -> EF(p) only for the second spelling
+    std::vector<std::string> inputs{"!(EF(!p))", "AG(p)", "EF(p)"};
+    std::sort(inputs.begin(), inputs.end());
+    std::set<std::pair<std::string, std::string>> expected;
+    bool first = true;
+    do {
+        RefinementAnalyzer analyzer(inputs);
+        analyzer.setParallelAnalysis(false);
+        auto result = analyzer.analyze();
+        EXPECT_EQ(result.duplicate_properties, 1u);
+
+        std::set<std::pair<std::string, std::string>> edges;
+        for (const auto& graph : analyzer.getRefinementGraphs()) {
+            const auto& nodes = graph.getNodes();
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                for (size_t j = 0; j < nodes.size(); ++j) {
+                    if (i != j && graph.hasEdge(i, j)) edges.emplace(nodes[i]->toString(), nodes[j]->toString());
+                }
+            }
+        }
+        if (first) {
+            expected = edges;
+            EXPECT_FALSE(expected.empty());
+            first = false;
+        }
+        EXPECT_EQ(edges, expected) << inputs[0] << ", " << inputs[1] << ", " << inputs[2];
+    } while (std::next_permutation(inputs.begin(), inputs.end()));
+}
+
+TEST(DeduplicationTest, DisabledKeepsEveryProperty) {
+    auto cache = tempCache();
+    cache->storeSatisfiable("automaton", CTLProperty("EF(p)").toString(), true);
+    cache->storeSatisfiable("automaton", CTLProperty("E(true U p)").toString(), true);
+    cache->storeRefinement("simulation", CTLProperty("EF(p)").toString(), CTLProperty("E(true U p)").toString(), true);
+    cache->storeRefinement("simulation", CTLProperty("E(true U p)").toString(), CTLProperty("EF(p)").toString(), true);
+
+    RefinementAnalyzer analyzer(std::vector<std::string>{"EF(p)", "E(true U p)"});
+    analyzer.setParallelAnalysis(false);
+    analyzer.setSyntacticRefinement(false);
+    analyzer.setUsePrefilter(false);
+    analyzer.setDeduplication(false);
+    analyzer.setCache(cache);
+    auto result = analyzer.analyze();
+    EXPECT_EQ(result.duplicate_properties, 0u);
+    EXPECT_EQ(analyzer.getProperties().size(), 2u);
+    EXPECT_EQ(result.total_refinements, 2u);
+}
+
+TEST(DeduplicationTest, SATResultsListEveryInput) {
+    auto cache = tempCache();
+    cache->storeSatisfiable("automaton", CTLProperty("AG(p)").toString(), true);
+    cache->storeSatisfiable("automaton", CTLProperty("!AG(p) & AG(p)").toString(), false);
+
+    SATAnalyzer analyzer(std::vector<std::string>{"AG(p)", "!AG(p) & AG(p)", "!!AG(p)", "AG(p)"});
+    analyzer.setParallelAnalysis(false);
+    analyzer.setCache(cache);
+    auto result = analyzer.analyze();
+    EXPECT_EQ(result.total_properties, 4u);
+    EXPECT_EQ(result.duplicate_properties, 2u);
+    EXPECT_EQ(result.false_properties, 1u);
+    EXPECT_EQ(cache->hits(), 2u);
+
+    char dir[] = "/tmp/ctl_dedup_outXXXXXX";
+    const std::string out = mkdtemp(dir);
+    analyzer.writeInfoPerProperty(out + "/info.csv");
+    const std::string csv = readFile(out + "/info.csv");
+    for (const char* row : {"\n0,", "\n1,", "\n2,", "\n3,"}) {
+        EXPECT_NE(csv.find(row), std::string::npos) << row;
+    }
+}
+
+TEST(DeduplicationTest, LargeFilesAreParsedInParallelInInputOrder) {
+    char templ[] = "/tmp/ctl_load_testXXXXXX";
+    const int fd = mkstemp(templ);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    {
+        std::ofstream out(templ);
+        out << "# header\n";
+        for (int i = 0; i < 500; ++i) {
+            out << "AG(p" << i << " | q)\n";
+            if (i == 250) out << "AG(\n";  // parse error, reported and skipped
+        }
+    }
+    RefinementAnalyzer analyzer{std::string(templ)};
+    std::remove(templ);
+
+    const auto& properties = analyzer.getProperties();
+    ASSERT_EQ(properties.size(), 500u);
+    for (size_t i = 0; i < properties.size(); ++i) {
+        EXPECT_EQ(properties[i]->toString(), CTLProperty("AG(p" + std::to_string(i) + " | q)").toString());
+    }
+}
+
+TEST(DeduplicationTest, AutomataAreBuiltBeforeRefinement) {
+    RefinementAnalyzer analyzer(std::vector<std::string>{"AG(p)", "EF(p)", "AG(p & q)", "AF(q)"});
+    analyzer.setThreads(4);
+    analyzer.setUsePrefilter(false);
+    analyzer.setSyntacticRefinement(false);
+    auto result = analyzer.analyze();
+
+    EXPECT_GT(result.total_refinements, 0u);
+    EXPECT_LE(result.automaton_time + result.refinement_time, result.total_time + std::chrono::milliseconds(1));
+}
+
+TEST(DeduplicationTest, ParallelPruningKeepsInputOrder) {
+    std::vector<std::string> inputs;
+    for (size_t i = 0; i < 12; ++i) inputs.push_back("EF(s" + std::to_string(i) + ") & AG(t)");
+    inputs[2] = "EF(a & !a)";
+    inputs[7] = "AG(b) & EF(!b)";
+    RefinementAnalyzer analyzer(inputs);
+    analyzer.setParallelAnalysis(true);
+    analyzer.setThreads(4);
+    analyzer.setSyntacticRefinement(false);
+    auto result = analyzer.analyze();
+
+    EXPECT_EQ(result.false_properties, 2u);
+    const auto& properties = analyzer.getProperties();
+    const std::vector<size_t> expected_positions = {0, 1, 3, 4, 5, 6, 8, 9, 10, 11};
+    EXPECT_EQ(analyzer.getPropertyPositions(), expected_positions);
+    ASSERT_EQ(properties.size(), expected_positions.size());
+    for (size_t k = 0; k < properties.size(); ++k) {
+        EXPECT_EQ(properties[k]->toString(), CTLProperty(inputs[expected_positions[k]]).toString());
+        EXPECT_EQ(properties[k]->knownSatisfiable(), std::optional<bool>(true));
+    }
+
+    // The verdicts stay on the properties: an analyzer sharing them starts with them
+    RefinementAnalyzer again(analyzer.getInputProperties());
+    EXPECT_EQ(again.getProperties()[2]->knownSatisfiable(), std::optional<bool>(false));
+    EXPECT_EQ(again.getProperties()[0]->knownSatisfiable(), std::optional<bool>(true));
+}
+
+TEST(DeduplicationTest, StreamedPairResultsMatchTheStoredOnes) {
+    const std::vector<std::string> inputs{"AG(p)", "EF(p)", "AG(p & q)", "AF(q)"};
+    char dir[] = "/tmp/ctl_stream_outXXXXXX";
+    const std::string out = mkdtemp(dir);
+    auto rowsOf = [](const std::string& csv) {
+        // Pair indices and verdict; times differ from run to run
+        std::multiset<std::string> rows;
+        std::istringstream lines(csv);
+        std::string line;
+        std::getline(lines, line);
+        while (std::getline(lines, line)) {
+            const size_t second = line.find(',', line.find(',') + 1);
+            rows.insert(line.substr(0, second) + line.substr(line.rfind(',')));
+        }
+        return rows;
+    };
+
+    RefinementAnalyzer stored(inputs);
+    stored.setParallelAnalysis(false);
+    stored.analyze();
+    stored.writeInfoPerProperty(out + "/stored.csv");
+
+    RefinementAnalyzer streamed(inputs);
+    streamed.setParallelAnalysis(false);
+    streamed.setResultStream(out + "/streamed.csv");
+    auto result = streamed.analyze();
+    streamed.writeInfoPerProperty(out + "/left_over.csv");
+
+    const auto streamed_rows = rowsOf(readFile(out + "/streamed.csv"));
+    EXPECT_FALSE(streamed_rows.empty());
+    EXPECT_EQ(streamed_rows, rowsOf(readFile(out + "/stored.csv")));
+    EXPECT_TRUE(rowsOf(readFile(out + "/left_over.csv")).empty());
+    EXPECT_GT(result.total_refinements, 0u);
+}
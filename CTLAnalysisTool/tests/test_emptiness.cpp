@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include "../include/CTLautomaton.h"
+#include "../include/property.h"
+
+using namespace ctl;
+
+// The on-the-fly product search decides L(this) ⊇ L(other) by looking for a
+// witness in other x ¬this; true must only come from an empty product
+TEST(OnTheFlyEmptinessTest, EmptyProductsProveInclusion) {
+    auto ag_p = CTLProperty::create("AG(p)");
+    auto ag_pq = CTLProperty::create("AG(p & q)");
+    auto q = CTLProperty::create("q");
+    EXPECT_TRUE(ag_p->automaton().languageIncludesOF(ag_pq->automaton()));
+    // An empty language is included in every other one
+    for (const char* empty : {"EG(false)", "p & !p"}) {
+        auto unsatisfiable = CTLProperty::create(empty);
+        EXPECT_TRUE(q->automaton().languageIncludesOF(unsatisfiable->automaton())) << empty;
+        EXPECT_TRUE(ag_p->automaton().languageIncludesOF(unsatisfiable->automaton())) << empty;
+    }
+}
+
+TEST(OnTheFlyEmptinessTest, EngineConfirmsProductsItCannotEmpty) {
+    // AG(p) & AF(!p) conflicts across branches of one tree, which a pair
+    // product does not see; the engine settles it by the fixpoint game
+    auto unsatisfiable = CTLProperty::create("AG(p) & AF(!p)");
+    auto q = CTLProperty::create("q");
+    EXPECT_TRUE(q->automaton().languageIncludes(unsatisfiable->automaton(), EmptinessEngine::ON_THE_FLY));
+    EXPECT_FALSE(unsatisfiable->automaton().languageIncludes(q->automaton(), EmptinessEngine::ON_THE_FLY));
+}
+
+TEST(OnTheFlyEmptinessTest, WitnessesRefuteInclusion) {
+    auto ag_p = CTLProperty::create("AG(p)");
+    auto ef_p = CTLProperty::create("EF(p)");
+    auto p = CTLProperty::create("p");
+    auto q = CTLProperty::create("q");
+    EXPECT_FALSE(ag_p->automaton().languageIncludesOF(ef_p->automaton()));
+    EXPECT_FALSE(q->automaton().languageIncludesOF(p->automaton()));
+    EXPECT_FALSE(p->automaton().languageIncludesOF(q->automaton()));
+}
+
+// The macro-state Büchi game decides emptiness on the alternating automaton
+// itself, so obligations of different children of one node must agree
+TEST(EmptinessGameTest, ConflictingObligationsAreEmpty) {
+    for (const char* formula : {"AG(p) & AF(!p)", "EG(false)", "AG(!q) & E(p U q)", "EG(p) & AF(!p)",
+                                "AG(AF(p)) & EF(AG(!p))"}) {
+        EXPECT_TRUE(CTLProperty::create(formula)->automaton().isEmpty()) << formula;
+    }
+}
+
+TEST(EmptinessGameTest, SatisfiableFormulasAreNotEmpty) {
+    for (const char* formula : {"p", "AG(p) & EF(q)", "AG(EF(p)) & EF(!p)", "EG(p) & EF(!p)",
+                                "A(p U q)"}) {
+        EXPECT_FALSE(CTLProperty::create(formula)->automaton().isEmpty()) << formula;
+    }
+}
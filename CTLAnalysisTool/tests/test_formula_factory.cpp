@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "../include/formula_factory.h"
+#include "../include/parser.h"
+#include "../include/property.h"
+#include "../include/flat_formula.h"
+#include "../include/utils.h"
+#include <cstdlib>
+#include <unistd.h>
+#include <fstream>
+
+using namespace ctl;
+
+TEST(FormulaFactoryTest, StructurallyEqualFormulasShareOneNode) {
+    auto& factory = FormulaFactory::instance();
+    auto a = factory.intern(Parser::parseFormula("AG(p -> EF(q & r))"));
+    auto b = factory.intern(Parser::parseFormula("AG(p -> EF(q & r))"));
+    EXPECT_EQ(a.get(), b.get());
+    EXPECT_TRUE(a->isInterned());
+    EXPECT_TRUE(a->equals(*b));
+    // Interning is idempotent
+    EXPECT_EQ(factory.intern(a).get(), a.get());
+}
+
+TEST(FormulaFactoryTest, PreservesHashAndEquality) {
+    auto& factory = FormulaFactory::instance();
+    for (const char* text : {"p", "x <= 3", "true", "!(p)", "A(p U q)", "EG(p) | AF(q & !(r))"}) {
+        SCOPED_TRACE(text);
+        auto plain = Parser::parseFormula(text);
+        auto interned = factory.intern(plain);
+        EXPECT_FALSE(plain->isInterned());
+        EXPECT_EQ(interned->hash(), plain->hash());
+        EXPECT_EQ(interned->toString(), plain->toString());
+        EXPECT_TRUE(interned->equals(*plain));
+        EXPECT_TRUE(plain->equals(*interned));
+    }
+    auto p = factory.intern(Parser::parseFormula("AG(p)"));
+    auto q = factory.intern(Parser::parseFormula("AG(q)"));
+    EXPECT_FALSE(p->equals(*q));
+}
+
+TEST(FormulaFactoryTest, SubformulasAreSharedAcrossProperties) {
+    CTLProperty first("AG(p & q)");
+    CTLProperty second("EF(p & q)");
+    auto t1 = std::dynamic_pointer_cast<TemporalFormula>(first.getFormulaPtr());
+    auto t2 = std::dynamic_pointer_cast<TemporalFormula>(second.getFormulaPtr());
+    ASSERT_TRUE(t1 && t2);
+    EXPECT_EQ(t1->operand.get(), t2->operand.get());
+    // clone() of an interned node shares it
+    EXPECT_EQ(t1->operand->clone().get(), t1->operand.get());
+}
+
+TEST(FormulaFactoryTest, PropertiesFromAnAstMatchParsedOnes) {
+    for (const char* text : {"AG(p -> EF(q & r))", "A(p U x <= 3)", "EG(!(p)) | AF(y != 2)"}) {
+        SCOPED_TRACE(text);
+        auto from_text = CTLProperty::create(std::string(text));
+        auto from_ast = CTLProperty::create(Parser::parseFormula(text));
+        EXPECT_EQ(from_ast->getFormulaPtr().get(), from_text->getFormulaPtr().get());
+        EXPECT_EQ(CTLProperty::create(Parser::parseFormula(text), false, true)->getFormulaPtr().get(),
+                  CTLProperty::create(std::string(text), false, true)->getFormulaPtr().get());
+    }
+}
+
+TEST(ParserTest, RepeatedAtomsShareOneNode) {
+    auto formula = Parser::parseFormula("p & (q | p)");
+    auto children = formula->children();
+    ASSERT_EQ(children.size(), 2u);
+    EXPECT_EQ(children[0].get(), children[1]->children()[1].get());
+    EXPECT_EQ(formula->toString(), Parser::parseFormula(std::string("p & (q | p)"))->toString());
+}
+
+TEST(ParserTest, TokensViewTheInput) {
+    const std::string input = "AG(p_1 <= 3)";
+    Lexer lexer(input);
+    const auto& tokens = lexer.getTokens();
+    ASSERT_GE(tokens.size(), 4u);
+    EXPECT_EQ(tokens[2].value, "p_1");
+    EXPECT_EQ(tokens[2].value.data(), input.data() + 3);
+}
+
+TEST(ParserTest, PropertyFilesAreReadThroughMapping) {
+    char templ[] = "/tmp/ctl_properties_testXXXXXX";
+    const int fd = mkstemp(templ);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    {
+        std::ofstream out(templ);
+        out << "# comment\n  AG(p)  \r\n\n// other comment\nEF(q)";
+    }
+    EXPECT_EQ(loadPropertiesFromFile(templ), (std::vector<std::string>{"AG(p)", "EF(q)"}));
+    std::remove(templ);
+    EXPECT_THROW(loadPropertiesFromFile(templ), std::runtime_error);
+}
+
+TEST(FlatFormulaTest, SharedSubformulasBecomeOneNode) {
+    // The parsed tree holds two separate copies of EF(q)
+    auto formula = Parser::parseFormula("EF(q) & AG(p | EF(q))");
+    FlatFormula flat(*formula);
+    ASSERT_FALSE(flat.empty());
+    EXPECT_EQ(flat[flat.root()].source, formula.get());
+    EXPECT_EQ(flat[flat.root()].binaryOp(), BinaryOperator::AND);
+
+    size_t ef_nodes = 0;
+    for (FlatFormula::NodeId id = 0; id < flat.size(); ++id) {
+        const auto& node = flat[id];
+        // Children precede their parents
+        if (node.first != FlatFormula::NONE) {
+            EXPECT_LT(node.first, id);
+        }
+        if (node.second != FlatFormula::NONE) {
+            EXPECT_LT(node.second, id);
+        }
+        if (node.type == FormulaType::TEMPORAL && node.temporalOp() == TemporalOperator::EF) ++ef_nodes;
+    }
+    EXPECT_EQ(ef_nodes, 1u);
+    // q, EF q, p, p | EF q, AG(...), root
+    EXPECT_EQ(flat.size(), 6u);
+    EXPECT_EQ(flat.atomicPropositions(), (std::unordered_set<std::string>{"p", "q"}));
+}
+
+TEST(FlatFormulaTest, ClosureAddsNegatedAtomsOnce) {
+    auto formula = FormulaFactory::instance().intern(Parser::parseFormula("AG(p | !p)"));
+    FlatFormula flat(*formula);
+    auto closure = flat.closure();
+    // p, !p, p | !p, AG(...)
+    ASSERT_EQ(closure.size(), 4u);
+    EXPECT_EQ(closure.size(), flat.closureSize());
+    EXPECT_EQ(closure[1]->getType(), FormulaType::NEGATION);
+    EXPECT_EQ(closure.back(), formula.get());
+}
+
+TEST(FlatFormulaTest, SyntacticRefinementOverFlatNodes) {
+    EXPECT_TRUE(CTLProperty("AG(p & q)").refinesSyntactic(CTLProperty("EF(p)")));
+    EXPECT_TRUE(CTLProperty("!EF(p)").refinesSyntactic(CTLProperty("!AG(p)")));
+    EXPECT_FALSE(CTLProperty("EF(p)").refinesSyntactic(CTLProperty("AG(p)")));
+    EXPECT_TRUE(CTLProperty("E(p U q)").refinesSyntactic(CTLProperty("E(p U (q | r))")));
+}
+
+TEST(FlatFormulaTest, SyntacticRulesCoverEveryTypePair) {
+    // A before E for the binary operators, and the G/F order per quantifier
+    EXPECT_TRUE(CTLProperty("A(p U q)").refinesSyntactic(CTLProperty("E(p U (q | r))")));
+    EXPECT_FALSE(CTLProperty("E(p U q)").refinesSyntactic(CTLProperty("A(p U q)")));
+    EXPECT_FALSE(CTLProperty("EG(p)").refinesSyntactic(CTLProperty("AF(p)")));
+    // Both sides decompose: conjunctions in another order, disjunctions on the right
+    EXPECT_TRUE(CTLProperty("AG(p & q)").refinesSyntactic(CTLProperty("AG(q & p)")));
+    EXPECT_TRUE(CTLProperty("AG(p)").refinesSyntactic(CTLProperty("EF(q) | EG(p)")));
+    EXPECT_TRUE(CTLProperty("!EF(p) & q").refinesSyntactic(CTLProperty("!AG(p) | r")));
+    // Literals
+    EXPECT_TRUE(CTLProperty("AG(p)").refinesSyntactic(CTLProperty("true")));
+    EXPECT_TRUE(CTLProperty("false").refinesSyntactic(CTLProperty("EF(q)")));
+    EXPECT_FALSE(CTLProperty("true").refinesSyntactic(CTLProperty("EF(q)")));
+    // Verdicts kept across checks agree with fresh ones
+    for (int round = 0; round < 2; ++round) {
+        EXPECT_TRUE(CTLProperty("AG(p & q) & EF(r)").refinesSyntactic(CTLProperty("EF(p) & EF(r)")));
+        EXPECT_FALSE(CTLProperty("EF(p) & EF(r)").refinesSyntactic(CTLProperty("AG(p & q) & EF(r)")));
+    }
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "../include/guard_sat_cache.h"
+#include "../include/property.h"
+
+using namespace ctl;
+
+TEST(GuardSatCacheTest, KeyIsIndependentOfAtomOrder) {
+    std::unordered_set<std::string> a = {"p", "q", "x<=3"};
+    std::unordered_set<std::string> b = {"x<=3", "p", "q"};
+    EXPECT_EQ(GuardSatCache::makeKey(a, false), GuardSatCache::makeKey(b, false));
+    EXPECT_NE(GuardSatCache::makeKey(a, false), GuardSatCache::makeKey(a, true));
+}
+
+TEST(GuardSatCacheTest, LookupHitsAndMisses) {
+    auto& cache = GuardSatCache::instance();
+    cache.clear();
+    const auto key = GuardSatCache::makeKey(std::string("p & !p"), false);
+    EXPECT_FALSE(cache.lookup(key).has_value());
+    cache.insert(key, false);
+    auto verdict = cache.lookup(key);
+    ASSERT_TRUE(verdict.has_value());
+    EXPECT_FALSE(*verdict);
+    EXPECT_EQ(cache.hits(), 1u);
+    EXPECT_EQ(cache.misses(), 1u);
+}
+
+TEST(GuardSatCacheTest, EvictsLeastRecentlyUsed) {
+    auto& cache = GuardSatCache::instance();
+    cache.clear();
+    cache.setCapacity(2);
+    cache.insert("a", true);
+    cache.insert("b", true);
+    EXPECT_TRUE(cache.lookup("a").has_value());  // "b" is now the oldest
+    cache.insert("c", false);
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_TRUE(cache.lookup("a").has_value());
+    EXPECT_FALSE(cache.lookup("b").has_value());
+    EXPECT_TRUE(cache.lookup("c").has_value());
+    cache.setCapacity(GuardSatCache::DEFAULT_CAPACITY);
+    cache.clear();
+}
+
+TEST(GuardSatCacheTest, RepeatedAutomataReuseVerdicts) {
+    auto& cache = GuardSatCache::instance();
+    cache.clear();
+    CTLProperty("AG(p & q)").automaton();
+    size_t misses_first = cache.misses();
+    CTLProperty("AG(p & q)").automaton();
+    EXPECT_EQ(cache.misses(), misses_first);
+    EXPECT_GT(cache.hits(), 0u);
+}
+TEST(GuardTableTest, EqualGuardsShareOneId) {
+    Guard a("p & q"), b(std::string("p & ") + "q"), c("q & p");
+    EXPECT_EQ(a.id, b.id);
+    EXPECT_TRUE(a == b);
+    EXPECT_FALSE(a == c);
+    EXPECT_EQ(GuardTable::instance().text(a.id), "p & q");
+}
+
+TEST(GuardTableTest, ConstantsAreDetectedById) {
+    EXPECT_TRUE(Guard().isTrue());
+    EXPECT_TRUE(Guard("true").isTrue());
+    EXPECT_TRUE(Guard("false").isFalse());
+    EXPECT_FALSE(Guard("false").isTrue());
+    EXPECT_FALSE(Guard("p").isFalse());
+}
+
+TEST(GuardTableTest, UnsatisfiableGuardsBecomeFalse) {
+    CTLProperty prop("AG(p & !p)");
+    bool found_false = false;
+    for (StateId q = 0; q < prop.automaton().numStates(); ++q) {
+        for (const auto& t : prop.automaton().getTransitions(q)) {
+            found_false = found_false || t->guard.isFalse();
+        }
+    }
+    EXPECT_TRUE(found_false);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include "../include/Analyzers/Refinement.h"
+#include "../include/refinement_cache.h"
+#include <cstdlib>
+#include <string>
+
+using namespace ctl;
+
+namespace {
+
+// Seeds a verdict cache so the analyzer never needs to build an automaton;
+// every lookup then counts exactly one refinement/satisfiability query.
+std::shared_ptr<RefinementCache> seededCache() {
+    char templ[] = "/tmp/ctl_incremental_testXXXXXX";
+    auto cache = std::make_shared<RefinementCache>(mkdtemp(templ));
+    const std::vector<std::string> formulas = {"AG(p)", "AF(p)", "EF(p)", "EG(p)", "AG(q)"};
+    for (const auto& f : formulas) {
+        cache->storeSatisfiable("automaton", CTLProperty(f).toString(), true);
+    }
+    auto refines = [&](const std::string& a, const std::string& b) {
+        static const std::vector<std::pair<std::string, std::string>> truths = {
+            {"AG(p)", "AF(p)"}, {"AG(p)", "EF(p)"}, {"AF(p)", "EF(p)"},
+            {"AG(p)", "EG(p)"}, {"EG(p)", "EF(p)"}};
+        return std::find(truths.begin(), truths.end(), std::make_pair(a, b)) != truths.end();
+    };
+    for (const auto& a : formulas) {
+        for (const auto& b : formulas) {
+            if (a == b) continue;
+            cache->storeRefinement("simulation", CTLProperty(a).toString(), CTLProperty(b).toString(), refines(a, b));
+        }
+    }
+    return cache;
+}
+
+void configure(RefinementAnalyzer& analyzer, std::shared_ptr<RefinementCache> cache) {
+    analyzer.setParallelAnalysis(false);
+    analyzer.setSyntacticRefinement(false);
+    analyzer.setFullLanguageInclusion(false);
+    analyzer.setUseTransitiveOptimization(false);
+    analyzer.setUsePrefilter(false);
+    analyzer.setCache(std::move(cache));
+}
+
+} // namespace
+
+TEST(IncrementalAnalysisTest, OnlyNewPairsAreChecked) {
+    auto cache = seededCache();
+    RefinementAnalyzer analyzer(std::vector<std::string>{"AG(p)", "AF(p)", "EF(p)", "AG(q)"});
+    configure(analyzer, cache);
+
+    auto first = analyzer.analyze();
+    EXPECT_EQ(first.equivalence_classes, 2u);
+    EXPECT_EQ(first.total_refinements, 3u);
+    EXPECT_EQ(cache->misses(), 0u);
+    const size_t after_first = cache->hits();
+
+    EXPECT_EQ(analyzer.addProperties({"EG(p)"}), 1u);
+    auto second = analyzer.reanalyze();
+    // One satisfiability check plus both directions against the three p-properties
+    EXPECT_EQ(cache->hits() - after_first, 7u);
+    EXPECT_EQ(cache->misses(), 0u);
+    EXPECT_EQ(second.total_properties, 5u);
+    EXPECT_EQ(second.equivalence_classes, 2u);
+    EXPECT_EQ(second.total_refinements, 5u);
+
+    // Removing a property needs no new checks at all
+    const size_t after_second = cache->hits();
+    EXPECT_TRUE(analyzer.removeProperty("AF(p)"));
+    EXPECT_FALSE(analyzer.removeProperty("AF(p)"));
+    auto third = analyzer.reanalyze();
+    EXPECT_EQ(cache->hits(), after_second);
+    EXPECT_EQ(third.total_properties, 4u);
+    EXPECT_EQ(third.total_refinements, 3u);
+    // AG(p) refines everything else in its class, AG(q) stands alone
+    EXPECT_EQ(third.required_properties, 2u);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "../include/interval_domain.h"
+#include "../include/smt_context_manager.h"
+#include "../include/statistics.h"
+#include "../include/property.h"
+
+using namespace ctl;
+
+namespace {
+std::vector<GuardTable::Id> ids(std::initializer_list<const char*> guards) {
+    std::vector<GuardTable::Id> out;
+    for (const char* guard : guards) out.push_back(GuardTable::instance().intern(guard));
+    return out;
+}
+}
+
+TEST(IntervalDomainTest, DecidesBoundsOnOneVariable) {
+    auto& domain = IntervalDomain::instance();
+    EXPECT_EQ(domain.satisfiable(ids({"x <= 5", "x > 3"})), std::optional<bool>(true));
+    EXPECT_EQ(domain.satisfiable(ids({"x <= 5", "x > 5"})), std::optional<bool>(false));
+    // Over the integers 3 < x < 5 leaves 4, and excluding it leaves nothing
+    EXPECT_EQ(domain.satisfiable(ids({"3 < x", "x < 5", "x != 4"})), std::optional<bool>(false));
+    EXPECT_EQ(domain.satisfiable(ids({"!(x >= 2) & p", "!(p) | q", "x == 1"})), std::nullopt);
+    EXPECT_EQ(domain.satisfiable(ids({"!(x >= 2) & p", "!(p)"})), std::optional<bool>(false));
+
+    EXPECT_EQ(domain.entails(ids({"x <= 5"}), ids({"x <= 7"})), std::optional<bool>(true));
+    EXPECT_EQ(domain.entails(ids({"x <= 7"}), ids({"x <= 5"})), std::optional<bool>(false));
+    EXPECT_EQ(domain.entails(ids({"x == 2", "p"}), ids({"x != 3 & p", "1 < x"})), std::optional<bool>(true));
+    EXPECT_EQ(domain.entails(ids({"x > 5", "x < 3"}), ids({"q"})), std::optional<bool>(true));
+    // Comparisons between variables are relational
+    EXPECT_EQ(domain.entails(ids({"x <= y"}), ids({"x <= 7"})), std::nullopt);
+}
+
+TEST(IntervalDomainTest, AgreesWithTheSolver) {
+    const std::vector<const char*> guards{"x <= 5", "x > 3", "!(x == 4)", "x >= 4 & y < 0", "!(x > 2 | p)",
+                                          "p", "y != -1", "0 <= y", "!(y <= -2) & !(q)", "x < 2"};
+    SMTInterface& smt = SMTContextManager::local();
+    for (size_t a = 0; a < guards.size(); ++a) {
+        for (size_t b = 0; b < guards.size(); ++b) {
+            for (size_t c = b; c < guards.size(); ++c) {
+                const std::unordered_set<std::string> texts{guards[a], guards[b], guards[c]};
+                const auto decided = IntervalDomain::instance().satisfiable(ids({guards[a], guards[b], guards[c]}));
+                ASSERT_TRUE(decided.has_value());
+                EXPECT_EQ(*decided, smt.isSatisfiable(texts)) << guards[a] << ", " << guards[b] << ", " << guards[c];
+
+                // a & b => c iff a & b & !c is unsatisfiable
+                const auto entailed = IntervalDomain::instance().entails(ids({guards[a], guards[b]}), ids({guards[c]}));
+                ASSERT_TRUE(entailed.has_value());
+                const std::unordered_set<std::string> counter{guards[a], guards[b], std::string("!(") + guards[c] + ")"};
+                EXPECT_EQ(*entailed, !smt.isSatisfiable(counter)) << guards[a] << ", " << guards[b] << " => " << guards[c];
+            }
+        }
+    }
+}
+
+TEST(IntervalDomainTest, SimulationDecidesComparisonsWithoutTheSolver) {
+    // x <= 5 entails x <= 7, so the stronger invariant refines the weaker one
+    auto strong = std::make_shared<CTLProperty>("AG(x <= 5 & y > 1)");
+    auto weak = std::make_shared<CTLProperty>("AG(x <= 7)");
+    const StatisticValues before = Statistics::instance().snapshot();
+    EXPECT_TRUE(strong->refines(*weak, false, false));
+    EXPECT_FALSE(weak->refines(*strong, false, false));
+    const StatisticValues delta = Statistics::instance().snapshot() - before;
+    EXPECT_GT(delta[static_cast<size_t>(Statistic::INTERVAL_DECISIONS)], 0u);
+}
@@ -2,10 +2,12 @@
 #include "../include/formula.h"
 #include "../include/CTLautomaton.h"
 #include "../include/property.h"
+#include "../include/automaton_budget.h"
 #include <memory>
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 using namespace ctl;
 
@@ -236,7 +238,154 @@ TEST(LanguageInclusionTest, Test344){
     EXPECT_FALSE(prop1->isEmpty());
 }
 
+// ---------------------------------------------------------------------
+// SECTION 4: EMPTINESS ENGINE SELECTION
+// ---------------------------------------------------------------------
+
+TEST(EmptinessEngineTest, EveryEngineDecidesTrivialInclusions) {
+    auto prop_true = makeProperty("true");
+    auto prop_false = makeProperty("false");
+    auto prop_p = makeProperty("p");
+    for (auto engine : {EmptinessEngine::FIXPOINT, EmptinessEngine::ON_THE_FLY, EmptinessEngine::ANTICHAIN,
+                        EmptinessEngine::AUTO}) {
+        EXPECT_TRUE(prop_true->automaton().languageIncludes(prop_p->automaton(), engine));
+        EXPECT_TRUE(prop_p->automaton().languageIncludes(prop_false->automaton(), engine));
+    }
+}
 
+TEST(EmptinessEngineTest, AutoKeepsFixpointWithoutFixpointBlocks) {
+    auto prop_p = makeProperty("p");
+    auto prop_q = makeProperty("q");
+    EXPECT_EQ(prop_p->automaton().numNonSimpleBlocks(), 0u);
+    EXPECT_EQ(CTLAutomaton::chooseEmptinessEngine(prop_p->automaton(), prop_q->automaton()),
+              EmptinessEngine::FIXPOINT);
+}
+
+TEST(EmptinessEngineTest, OnTheFlyAgreesWithFixpoint) {
+    auto prop_ag = makeProperty("AG(p)");
+    auto prop_ef = makeProperty("EF(p)");
+    auto prop_agq = makeProperty("AG(p & q)");
+    for (const auto& [a, b] : {std::pair{prop_ef, prop_ag}, {prop_ag, prop_ef}, {prop_ag, prop_agq}, {prop_agq, prop_ag}}) {
+        EXPECT_EQ(a->automaton().languageIncludes(b->automaton(), EmptinessEngine::ON_THE_FLY),
+                  a->automaton().languageIncludes(b->automaton(), EmptinessEngine::FIXPOINT));
+    }
+}
+
+TEST(EmptinessEngineTest, AntichainAgreesWithFixpoint) {
+    std::vector<std::shared_ptr<CTLProperty>> props = {
+        makeProperty("AG(p)"), makeProperty("EF(p)"), makeProperty("AG(p & q)"),
+        makeProperty("AF(p)"), makeProperty("E(p U q)"), makeProperty("AG(EF(p))")};
+    for (const auto& a : props) {
+        for (const auto& b : props) {
+            EXPECT_EQ(a->automaton().languageIncludes(b->automaton(), EmptinessEngine::ANTICHAIN),
+                      a->automaton().languageIncludes(b->automaton(), EmptinessEngine::FIXPOINT))
+                << a->getFormula().toString() << " vs " << b->getFormula().toString();
+        }
+    }
+}
+
+TEST(EmptinessEngineTest, AntichainReportsFiniteCounterexample) {
+    auto prop_p = makeProperty("p");
+    auto prop_q = makeProperty("q");
+    std::string counterexample;
+    EXPECT_FALSE(prop_p->automaton().languageIncludesAntichain(prop_q->automaton(), &counterexample));
+    EXPECT_NE(counterexample.find("q"), std::string::npos);
+    EXPECT_NE(counterexample.find("!"), std::string::npos);
+
+    counterexample.clear();
+    EXPECT_TRUE(prop_p->automaton().languageIncludesAntichain(makeProperty("p & q")->automaton(), &counterexample));
+    EXPECT_TRUE(counterexample.empty());
+}
+
+TEST(EmptinessEngineTest, ComplementIsBuiltOnce) {
+    auto prop = makeProperty("AG(p)");
+    const CTLAutomaton& complement = prop->complement();
+    EXPECT_EQ(&complement, &prop->automaton().getComplement());
+    EXPECT_EQ(&complement, &prop->complement());
+}
+
+TEST(EmptinessEngineTest, AutomataAreSharedAcrossThreads) {
+    // Neither automaton is built before the threads start
+    auto prop_ag = makeProperty("AG(p)");
+    auto prop_ef = makeProperty("EF(p)");
+    constexpr int kThreads = 8;
+    std::vector<const CTLAutomaton*> seen(kThreads);
+    std::vector<int> included(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            seen[t] = &prop_ag->automaton();
+            included[t] = prop_ef->automaton().languageIncludes(prop_ag->automaton(), EmptinessEngine::ANTICHAIN);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (int t = 0; t < kThreads; ++t) {
+        EXPECT_EQ(seen[t], &prop_ag->automaton());
+        EXPECT_TRUE(included[t]);
+    }
+}
+
+TEST(EmptinessEngineTest, EvictedAutomataAreRebuiltOnDemand) {
+    auto& budget = AutomatonBudget::instance();
+    const size_t evictions_before = budget.evictions();
+    budget.setLimit(1);  // every new automaton evicts the previous one
+
+    auto prop_ag = makeProperty("AG(p)");
+    auto prop_ef = makeProperty("EF(p)");
+    auto prop_eg = makeProperty("EG(p & q)");
+    std::vector<bool> verdicts;
+    for (int round = 0; round < 3; ++round) {
+        verdicts.push_back(prop_ag->refinesSemantic(*prop_ef, true));
+        verdicts.push_back(prop_ef->refinesSemantic(*prop_ag, true));
+        verdicts.push_back(prop_eg->refinesSemantic(*prop_ef, true));
+    }
+    EXPECT_GT(budget.evictions(), evictions_before);
+
+    budget.setLimit(0);
+    for (int round = 0; round < 3; ++round) {
+        EXPECT_TRUE(verdicts[3 * round]);
+        EXPECT_FALSE(verdicts[3 * round + 1]);
+        EXPECT_TRUE(verdicts[3 * round + 2]);
+    }
+    prop_ag.reset();
+    prop_ef.reset();
+    prop_eg.reset();
+    EXPECT_EQ(budget.residentBytes(), 0u);
+}
+
+// ---------------------------------------------------------------------
+// SECTION 5: EXPANDED TRANSITIONS
+// ---------------------------------------------------------------------
+
+TEST(ExpandedTransitionsTest, MovesAreExpandedOnce) {
+    auto prop = makeProperty("AG(p) & EF(q)");
+    const auto& automaton = prop->automaton();
+    const StateId init = automaton.getInitialStateId();
+    const auto& first = automaton.getExpandedTransitions(init);
+    EXPECT_FALSE(first.empty());
+    EXPECT_EQ(&first, &automaton.getExpandedTransitions(init));
+}
+
+TEST(ExpandedTransitionsTest, UnsatisfiableMovesArePruned) {
+    auto prop = makeProperty("AG(p) & AG(!p)");
+    const auto& automaton = prop->automaton();
+    EXPECT_TRUE(automaton.getExpandedTransitions(automaton.getInitialStateId()).empty());
+}
+
+TEST(ExpandedTransitionsTest, DominatedMovesAreDropped) {
+    // The q & AF(p) disjunct only adds the guard q to the moves of AF(p)
+    auto prop = makeProperty("AF(p) | (q & AF(p))");
+    const auto& automaton = prop->automaton();
+    const auto& moves = automaton.getExpandedTransitions(automaton.getInitialStateId());
+    EXPECT_EQ(moves.size(), 2u);
+    for (const auto& a : moves) {
+        for (const auto& b : moves) {
+            if (&a != &b) {
+                EXPECT_FALSE(a.subsumes(b));
+            }
+        }
+    }
+}
 
 
 
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include "../include/log.h"
+
+using namespace ctl;
+
+namespace {
+
+int evaluations = 0;
+
+int counted() { return ++evaluations; }
+
+} // end anonymous namespace
+
+TEST(LogTest, DisabledMessagesAreNotFormatted) {
+    log::setLevel(log::Level::INFO);
+    evaluations = 0;
+    testing::internal::CaptureStdout();
+    CTL_LOG(DEBUG, false, "value " << counted());
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    EXPECT_EQ(evaluations, 0);
+#if CTL_LOG_LEVEL < 4
+    // Compiled out: not even a verbose caller formats it
+    CTL_LOG(TRACE, true, "value " << counted());
+    EXPECT_EQ(evaluations, 0);
+#endif
+}
+
+TEST(LogTest, VerboseCallersAndRuntimeLevelEnableMessages) {
+    log::setLevel(log::Level::INFO);
+    testing::internal::CaptureStdout();
+    CTL_LOG(DEBUG, true, "verbose " << 1);
+    log::setLevel(log::Level::DEBUG);
+    CTL_LOG(DEBUG, false, "level " << 2);
+    log::setLevel(log::Level::INFO);
+#if CTL_LOG_LEVEL >= 3
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "verbose 1\nlevel 2\n");
+#else
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+#endif
+
+    testing::internal::CaptureStderr();
+    CTL_LOG_WARN("warned");
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "warned\n");
+}
+
+TEST(LogTest, LevelsParseFromTheirNames) {
+    log::Level level = log::Level::INFO;
+    EXPECT_TRUE(log::levelFromString("trace", level));
+    EXPECT_EQ(level, log::Level::TRACE);
+    EXPECT_TRUE(log::levelFromString("error", level));
+    EXPECT_EQ(level, log::Level::ERROR);
+    EXPECT_FALSE(log::levelFromString("loud", level));
+    EXPECT_EQ(level, log::Level::ERROR);
+}
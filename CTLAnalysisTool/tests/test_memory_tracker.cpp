@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+#include "../include/memory_tracker.h"
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace ctl;
+
+TEST(MemoryTrackerTest, ScopeCountsRetainedBytesOfThisThread) {
+    if (!memory_utils::allocationCountersEnabled()) GTEST_SKIP() << "allocation counters disabled";
+
+    memory_utils::AllocationScope scope;
+    auto kept = std::make_unique<std::vector<char>>(256 * 1024);
+    EXPECT_GE(scope.retainedKB(), 256u);
+
+    // Allocations of another thread are not attributed to this one
+    std::thread([] { std::vector<char> other(1024 * 1024); }).join();
+    EXPECT_LT(scope.retainedKB(), 512u);
+
+    kept.reset();
+    EXPECT_EQ(scope.retainedKB(), 0u);
+}
+
+TEST(MemoryTrackerTest, CountersAreMonotonic) {
+    const auto before = memory_utils::threadAllocations();
+    { std::vector<int> v(1000); }
+    const auto after = memory_utils::threadAllocations();
+    EXPECT_GE(after.allocated_bytes, before.allocated_bytes);
+    EXPECT_GE(after.freed_bytes, before.freed_bytes);
+    EXPECT_EQ(after.allocated_bytes - before.allocated_bytes, after.freed_bytes - before.freed_bytes);
+}
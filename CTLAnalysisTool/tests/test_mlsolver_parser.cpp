@@ -231,6 +231,21 @@ TEST(MLSolverParserTest, ValidMLSolverFormula) {
     EXPECT_EQ(result, "A (p U q)");
 }
 
+// Test translations under one mapping combine into the translated query
+TEST(MLSolverParserTest, RefinementQueryFromTranslations) {
+    MLSolverParser::Mapping mapping;
+    std::string refining = MLSolverParser::convertString("AG(speed > 5 -> p)", mapping);
+    std::string refined = MLSolverParser::convertString("EF(q)", mapping);
+    std::string atom = MLSolverParser::convertString("q", mapping);
+
+    MLSolverParser::clearComparisonMapping();
+    EXPECT_EQ(MLSolverParser::refinementQuery(refining, refined),
+              MLSolverParser::convertString("(AG(speed > 5 -> p)) & !(EF(q))"));
+    MLSolverParser::clearComparisonMapping();
+    EXPECT_EQ(MLSolverParser::refinementQuery(refining, atom),
+              MLSolverParser::convertString("(AG(speed > 5 -> p)) & !(q)"));
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
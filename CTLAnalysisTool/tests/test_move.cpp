@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "../include/small_vector.h"
+#include "../include/types.h"
+#include "../include/transitions.h"
+#include <unordered_set>
+
+using namespace ctl;
+
+TEST(SmallVectorTest, SpillsToHeapAndKeepsValues) {
+    SmallVector<uint32_t, 2> v;
+    for (uint32_t i = 0; i < 10; ++i) v.push_back(i);
+    ASSERT_EQ(v.size(), 10u);
+    for (uint32_t i = 0; i < 10; ++i) EXPECT_EQ(v[i], i);
+
+    SmallVector<uint32_t, 2> copy = v;
+    EXPECT_EQ(copy, v);
+    SmallVector<uint32_t, 2> moved = std::move(copy);
+    EXPECT_EQ(moved, v);
+    EXPECT_TRUE(copy.empty());
+}
+
+TEST(SmallVectorTest, InsertShiftsTail) {
+    SmallVector<uint32_t, 4> v;
+    v.push_back(1);
+    v.push_back(3);
+    v.insert(v.begin() + 1, 2);
+    v.insert(v.begin(), 0);
+    v.insert(v.end(), 4);
+    ASSERT_EQ(v.size(), 5u);
+    for (uint32_t i = 0; i < 5; ++i) EXPECT_EQ(v[i], i);
+}
+
+TEST(MoveTest, InsertionOrderDoesNotMatter) {
+    Move a, b;
+    EXPECT_TRUE(a.addAtom(7));
+    EXPECT_TRUE(a.addAtom(3));
+    EXPECT_FALSE(a.addAtom(7));
+    a.addNextState(1, 4);
+    a.addNextState(0, 9);
+
+    b.addAtom(3);
+    b.addAtom(7);
+    b.addNextState(0, 9);
+    b.addNextState(1, 4);
+    EXPECT_FALSE(b.addNextState(1, 4));
+
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a.hash(), b.hash());
+    EXPECT_EQ(a.next_states[0].dir, 0);
+
+    std::unordered_set<Move> moves{a, b};
+    EXPECT_EQ(moves.size(), 1u);
+}
+
+TEST(MoveTest, AtomsAndSuccessorsHashApart) {
+    Move atom_only, successor_only;
+    atom_only.addAtom(5);
+    successor_only.addNextState(0, 5);
+    EXPECT_FALSE(atom_only == successor_only);
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include "../include/Analyzers/Refinement.h"
+#include "../include/statistics.h"
+
+using namespace ctl;
+
+namespace {
+
+const std::vector<std::string> kFormulas{"AG(p)", "AF(p)", "AG(p & q)", "EF(q)", "EG(p)", "AG(p -> AF(q))",
+                                         "EF(p & q)", "AG(q)"};
+
+uint64_t count(const StatisticValues& delta, Statistic statistic) { return delta[static_cast<size_t>(statistic)]; }
+
+uint64_t wins(const StatisticValues& delta) {
+    return count(delta, Statistic::PORTFOLIO_SYNTACTIC_WINS) + count(delta, Statistic::PORTFOLIO_SIMULATION_WINS) +
+           count(delta, Statistic::PORTFOLIO_INCLUSION_WINS) + count(delta, Statistic::PORTFOLIO_EXTERNAL_SAT_WINS);
+}
+
+} // namespace
+
+TEST(PortfolioTest, VerdictsMatchFullInclusion) {
+    RefinementAnalyzer inclusion(kFormulas);
+    inclusion.setUsePrefilter(false);
+    inclusion.setFullLanguageInclusion(true);
+    const AnalysisResult expected = inclusion.analyze();
+
+    RefinementAnalyzer portfolio(kFormulas);
+    portfolio.setUsePrefilter(false);
+    portfolio.setPortfolio(true);
+    const StatisticValues before = Statistics::instance().snapshot();
+    const AnalysisResult result = portfolio.analyze();
+    const StatisticValues delta = Statistics::instance().snapshot() - before;
+
+    EXPECT_EQ(result.total_refinements, expected.total_refinements);
+    EXPECT_EQ(result.unknown_refinements, 0u);
+    ASSERT_EQ(portfolio.getRefinementGraphs().size(), inclusion.getRefinementGraphs().size());
+    for (size_t c = 0; c < inclusion.getRefinementGraphs().size(); ++c) {
+        const auto& a = inclusion.getRefinementGraphs()[c];
+        const auto& b = portfolio.getRefinementGraphs()[c];
+        ASSERT_EQ(a.getNodes().size(), b.getNodes().size());
+        for (size_t i = 0; i < a.getNodes().size(); ++i) {
+            for (size_t j = 0; j < a.getNodes().size(); ++j) {
+                if (i != j) {
+                    EXPECT_EQ(a.hasEdge(i, j), b.hasEdge(i, j)) << c << ": " << i << " -> " << j;
+                }
+            }
+        }
+    }
+    // Without a timeout every race has exactly one winner
+    EXPECT_GT(count(delta, Statistic::REFINEMENT_CHECKS), 0u);
+    EXPECT_EQ(wins(delta), count(delta, Statistic::REFINEMENT_CHECKS));
+}
+
+TEST(PortfolioTest, CheapChecksDecideBeforeTheRace) {
+    RefinementAnalyzer analyzer(std::vector<std::string>{});
+    analyzer.setUsePrefilter(false);
+    analyzer.setPortfolio(true);
+    auto refining = CTLProperty::create("AG(p & q)");
+    auto refined = CTLProperty::create("AG(p)");
+
+    StatisticValues before = Statistics::instance().snapshot();
+    EXPECT_TRUE(analyzer.checkPair(*refining, *refined).passed);
+    StatisticValues delta = Statistics::instance().snapshot() - before;
+    EXPECT_EQ(count(delta, Statistic::PORTFOLIO_SYNTACTIC_WINS), 1u);
+    EXPECT_EQ(wins(delta), 1u);
+
+    // Only inclusion refutes a pair
+    before = Statistics::instance().snapshot();
+    EXPECT_FALSE(analyzer.checkPair(*refined, *refining).passed);
+    delta = Statistics::instance().snapshot() - before;
+    EXPECT_EQ(count(delta, Statistic::PORTFOLIO_INCLUSION_WINS), 1u);
+    EXPECT_EQ(wins(delta), 1u);
+}
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include "../include/ExternalCTLSAT/process_pool.h"
+#include "../include/Analyzers/Refinement.h"
+#include "../include/Analyzers/SAT.h"
+#include "../include/ExternalCTLSAT/ctl_sat.h"
+#include "../include/sat_parsers/ctlsat_parser.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sys/stat.h>
+#include <thread>
+
+using namespace ctl;
+
+namespace {
+
+std::string writeScript(const std::string& name, const std::string& body) {
+    std::string path = "/tmp/" + name + "_" + std::to_string(::getpid()) + ".sh";
+    std::ofstream(path) << "#!/bin/sh\n" << body << "\n";
+    chmod(path.c_str(), 0755);
+    return path;
+}
+
+} // namespace
+
+TEST(SolverProcessPoolTest, CapturesOutputWithoutAShell) {
+    SolverProcessPool pool(2);
+    // The argument reaches the process verbatim, quotes and all
+    auto result = pool.run({"/bin/echo", "a \"quoted\" $HOME & !(b)"});
+    EXPECT_FALSE(result.timed_out);
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_EQ(result.output, "a \"quoted\" $HOME & !(b)\n");
+    EXPECT_EQ(pool.launched(), 1u);
+}
+
+TEST(SolverProcessPoolTest, MergesStderrOnRequest) {
+    SolverProcessPool pool(1);
+    auto script = writeScript("stderr_solver", "echo out; echo err 1>&2");
+    EXPECT_EQ(pool.run({script}, true).output, "out\nerr\n");
+}
+
+TEST(SolverProcessPoolTest, KillsQueriesPastTheTimeout) {
+    SolverProcessPool pool(1, std::chrono::milliseconds(100));
+    auto start = std::chrono::steady_clock::now();
+    auto result = pool.run({"/bin/sleep", "5"});
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_TRUE(result.timed_out);
+    EXPECT_LT(elapsed, std::chrono::seconds(2));
+    EXPECT_EQ(pool.timeouts(), 1u);
+}
+
+TEST(SolverProcessPoolTest, BoundsConcurrentProcesses) {
+    SolverProcessPool pool(1);
+    auto start = std::chrono::steady_clock::now();
+    std::thread a([&] { pool.run({"/bin/sleep", "0.2"}); });
+    std::thread b([&] { pool.run({"/bin/sleep", "0.2"}); });
+    a.join();
+    b.join();
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(390));
+}
+
+TEST(SolverProcessPoolTest, DrivesTheCTLSATInterface) {
+    auto sat = writeScript("fake_ctl_sat", "echo 'Input formula is satisfable'");
+    auto unsat = writeScript("fake_ctl_unsat", "echo 'Input formula is NOT satisfable'");
+    EXPECT_TRUE(CTLSATInterface(sat).isSatisfiable("AG(p)"));
+    EXPECT_FALSE(CTLSATInterface(unsat).isSatisfiable("AG(p)"));
+    EXPECT_TRUE(CTLSATInterface(unsat).refines("AG(p)", "AF(p)"));
+}
+
+TEST(SolverProcessPoolTest, CapsTheSolverAddressSpace) {
+    SolverProcessPool pool(1);
+    pool.setMemoryLimit(256u * 1024 * 1024);
+    auto script = writeScript("ulimit_solver", "ulimit -v");
+    EXPECT_EQ(pool.run({script}).output, "262144\n");
+}
+
+TEST(SolverProcessPoolTest, ReportsTimeoutsAndFailuresAsVerdicts) {
+    auto slow = writeScript("slow_ctl_sat", "sleep 5; echo 'Input formula is satisfable'");
+    auto broken = writeScript("broken_ctl_sat", "echo 'Segmentation fault'");
+    CTLSATInterface timed(slow);
+    timed.setQueryTimeout(std::chrono::milliseconds(100));
+    EXPECT_EQ(timed.checkSatisfiable("AG(p)"), SatVerdict::TIMEOUT);
+    EXPECT_EQ(timed.checkRefinement("AG(p)", "AF(p)"), SatVerdict::TIMEOUT);
+    // An inconclusive query never counts as a refinement
+    EXPECT_FALSE(timed.refines("AG(p)", "AF(p)"));
+    EXPECT_EQ(CTLSATInterface(broken).checkSatisfiable("AG(p)"), SatVerdict::ERROR);
+}
+
+TEST(SolverProcessPoolTest, ConcurrentConversionsKeepSeparateMappings) {
+    const std::string formula = "AG(x > 1 -> EF(y < 2 | z))";
+    CTLSATParser::clearComparisonMapping();
+    const std::string expected = CTLSATInterface::toCTLSATSyntax(formula);
+    std::vector<std::thread> workers;
+    std::atomic<int> mismatches{0};
+    for (int t = 0; t < 8; ++t) {
+        workers.emplace_back([&] {
+            for (int k = 0; k < 200; ++k) {
+                CTLSATParser::clearComparisonMapping();
+                if (CTLSATInterface::toCTLSATSyntax(formula) != expected) ++mismatches;
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    EXPECT_EQ(mismatches.load(), 0);
+}
+
+namespace {
+
+// Fake CTL-SAT: a query is unsatisfiable iff it contains a negation
+std::string negationSolver() {
+    return writeScript("negation_ctl_sat",
+                       "case \"$1\" in *'~'*) echo 'Input formula is NOT satisfable';;"
+                       " *) echo 'Input formula is satisfable';; esac");
+}
+
+} // namespace
+
+TEST(SolverProcessPoolTest, CheckManyKeepsInputOrder) {
+    CTLSATInterface solver(negationSolver());
+    solver.setWorkers(4);
+    auto verdicts = solver.checkMany({"AG(p)", "!AG(p)", "EF(q)", "!EF(q)", "AF(r)"});
+    EXPECT_EQ(verdicts, (std::vector<SatVerdict>{SatVerdict::SAT, SatVerdict::UNSAT, SatVerdict::SAT,
+                                                 SatVerdict::UNSAT, SatVerdict::SAT}));
+    EXPECT_EQ(solver.processPool().launched(), 5u);
+    EXPECT_TRUE(solver.checkMany({}).empty());
+
+    auto pairs = solver.refinesMany({{"AG(p)", "AF(p)"}, {"EF(q)", "AG(q)"}});
+    EXPECT_EQ(pairs, (std::vector<SatVerdict>{SatVerdict::UNSAT, SatVerdict::UNSAT}));
+}
+
+TEST(SolverProcessPoolTest, RefinementQueriesReuseTranslations) {
+    // Fake CTL-SAT recording the formula it was given
+    const std::string log = "/tmp/ctl_sat_queries_" + std::to_string(::getpid()) + ".txt";
+    std::remove(log.c_str());
+    CTLSATInterface solver(writeScript("recording_ctl_sat",
+                                       "echo \"$1\" >> " + log + "; echo 'Input formula is satisfable'"));
+
+    EXPECT_EQ(solver.checkRefinement("AG(x > 1 -> p)", "EF(p | q)"), SatVerdict::SAT);
+    EXPECT_EQ(solver.checkSatisfiable("(AG(x > 1 -> p)) & !(EF(p | q))"), SatVerdict::SAT);
+    auto verdicts = solver.refinesMany({{"EF(p | q)", "AG(x > 1 -> p)"}, {"AG(x > 1 -> p)", "EF(p | q)"}});
+    EXPECT_EQ(verdicts, (std::vector<SatVerdict>{SatVerdict::SAT, SatVerdict::SAT}));
+    EXPECT_EQ(solver.cachedTranslations(), 2u);
+
+    std::ifstream in(log);
+    std::vector<std::string> queries;
+    for (std::string line; std::getline(in, line);) queries.push_back(line);
+    ASSERT_EQ(queries.size(), 4u);
+    // The combined translations are the translation of the combined formula
+    EXPECT_EQ(queries[0], queries[1]);
+    // Both properties keep their atoms in every pair
+    EXPECT_EQ(std::count(queries.begin(), queries.end(), queries[0]), 3);
+    EXPECT_NE(std::find(queries.begin(), queries.end(), "(EF((b v c)) ^ ~(AG((a -> b))))"), queries.end());
+
+    solver.clearTranslations();
+    EXPECT_EQ(solver.cachedTranslations(), 0u);
+}
+
+TEST(SolverProcessPoolTest, RefinementAnalyzerSubmitsClassesAsBatches) {
+    RefinementAnalyzer analyzer(std::vector<std::string>{"AG(p)", "AF(p)", "EF(p)"});
+    analyzer.setExternalSATInterface(AvailableCTLSATInterfaces::CTLSAT, negationSolver());
+    analyzer.setExternalSATLimits(4, std::chrono::milliseconds(0));
+    analyzer.setUseTransitiveOptimization(false);
+    // The prefilter's random models would refute the false pairs first
+    analyzer.setUsePrefilter(false);
+    auto result = analyzer.analyze();
+    EXPECT_EQ(result.false_properties, 0u);
+    EXPECT_EQ(result.equivalence_classes, 1u);
+    // Every refinement query carries a negation, so the fake solver proves all six
+    EXPECT_EQ(result.total_refinements, 6u);
+    EXPECT_EQ(analyzer.getExternalSATInterface()->processPool().launched(), 3u + 6u);
+}
+
+TEST(SolverProcessPoolTest, SATAnalyzerStreamsVerdictsAsTheyComplete) {
+    SATAnalyzer analyzer(std::vector<std::string>{"AG(p)", "!AG(p)", "EF(q)"});
+    analyzer.setExternalSATInterface(AvailableCTLSATInterfaces::CTLSAT, negationSolver());
+    analyzer.setExternalSATLimits(3, std::chrono::milliseconds(0));
+    const std::string csv = "/tmp/sat_stream_" + std::to_string(::getpid()) + ".csv";
+    analyzer.setResultStream(csv);
+    auto result = analyzer.analyze();
+    EXPECT_EQ(result.false_properties, 1u);
+
+    std::ifstream in(csv);
+    std::string line;
+    std::getline(in, line);
+    EXPECT_EQ(line, "Index, Property, Time Taken (ms),Memory Used (KB),Verdict");
+    size_t rows = 0, unsat = 0;
+    while (std::getline(in, line)) {
+        ++rows;
+        if (line.size() >= 6 && line.compare(line.size() - 6, 6, ",UNSAT") == 0) ++unsat;
+    }
+    in.close();
+    std::remove(csv.c_str());
+    EXPECT_EQ(rows, 3u);
+    EXPECT_EQ(unsat, 1u);
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "../include/progress_reporter.h"
+#include "../include/Analyzers/Refinement.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace ctl;
+
+namespace {
+
+// Value of a numeric field of a JSON line, -1 if it is missing
+double field(const std::string& line, const std::string& name) {
+    const std::string key = "\"" + name + "\":";
+    const size_t at = line.find(key);
+    if (at == std::string::npos) return -1;
+    return std::stod(line.substr(at + key.size()));
+}
+
+} // end anonymous namespace
+
+TEST(ProgressReporterTest, CountsEveryPairOfTheAnalysis) {
+    const std::string path = testing::TempDir() + "ctl_progress.jsonl";
+    std::remove(path.c_str());
+    const std::vector<std::string> formulas{"AG(p)", "AF(p)", "AG(p & q)", "EF(q)", "AG(q)", "EF(p & q)"};
+
+    for (bool parallel : {false, true}) {
+        ProgressReporter reporter(path, std::chrono::hours(1));
+        RefinementAnalyzer analyzer(formulas);
+        analyzer.setParallelAnalysis(parallel);
+        analyzer.analyze();
+
+        const std::string line = reporter.sample();
+        size_t pairs = 0;
+        for (const auto& class_properties : analyzer.getEquivalenceClasses()) {
+            pairs += class_properties.size() * (class_properties.size() - 1);
+        }
+        EXPECT_EQ(field(line, "pairs_planned"), static_cast<double>(pairs)) << line;
+        EXPECT_EQ(field(line, "pairs_decided"), static_cast<double>(pairs)) << line;
+        EXPECT_EQ(field(line, "pairs_remaining"), 0.0) << line;
+        EXPECT_NE(line.find("\"eta_s\":null"), std::string::npos) << line;
+        EXPECT_GT(field(line, "rss_kb"), 0.0) << line;
+        EXPECT_EQ(line.back(), '}');
+    }
+    std::remove(path.c_str());
+}
+
+TEST(ProgressReporterTest, WritesALineEveryIntervalAndAtTheEnd) {
+    const std::string path = testing::TempDir() + "ctl_progress_lines.jsonl";
+    std::remove(path.c_str());
+    {
+        ProgressReporter reporter(path, std::chrono::milliseconds(20));
+        std::this_thread::sleep_for(std::chrono::milliseconds(110));
+    }
+    std::ifstream in(path);
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(in, line)) {
+        ++lines;
+        EXPECT_EQ(line.front(), '{');
+        EXPECT_NE(line.find("\"threads\":["), std::string::npos);
+        EXPECT_GE(field(line, "seconds_since_progress"), 0.0);
+    }
+    EXPECT_GE(lines, 3u);
+    std::remove(path.c_str());
+}
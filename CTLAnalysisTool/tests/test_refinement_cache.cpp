@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "../include/refinement_cache.h"
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+using namespace ctl;
+
+namespace {
+
+std::string freshDirectory() {
+    char templ[] = "/tmp/ctl_cache_testXXXXXX";
+    const char* dir = mkdtemp(templ);
+    return dir ? std::string(dir) : std::string("/tmp/ctl_cache_test");
+}
+
+} // namespace
+
+TEST(RefinementCacheTest, VerdictsSurviveReopening) {
+    const std::string dir = freshDirectory();
+    {
+        RefinementCache cache(dir);
+        EXPECT_FALSE(cache.lookupRefinement("simulation", "AG(p)", "EF(p)").has_value());
+        cache.storeRefinement("simulation", "AG(p)", "EF(p)", true);
+        cache.storeRefinement("simulation", "EF(p)", "AG(p)", false);
+        cache.storeSatisfiable("automaton", "p & !(p)", false);
+        // Verdicts are visible before they reach the disk
+        EXPECT_EQ(cache.lookupRefinement("simulation", "AG(p)", "EF(p)"), std::optional<bool>(true));
+    } // destructor flushes
+
+    RefinementCache reopened(dir);
+    EXPECT_EQ(reopened.size(), 3u);
+    EXPECT_EQ(reopened.lookupRefinement("simulation", "AG(p)", "EF(p)"), std::optional<bool>(true));
+    EXPECT_EQ(reopened.lookupRefinement("simulation", "EF(p)", "AG(p)"), std::optional<bool>(false));
+    EXPECT_EQ(reopened.lookupSatisfiable("automaton", "p & !(p)"), std::optional<bool>(false));
+    EXPECT_EQ(reopened.hits(), 3u);
+}
+
+TEST(RefinementCacheTest, ModesAreKeptApart) {
+    RefinementCache cache(freshDirectory());
+    cache.storeRefinement("simulation", "AG(p)", "AF(p)", false);
+    EXPECT_FALSE(cache.lookupRefinement("inclusion", "AG(p)", "AF(p)").has_value());
+    EXPECT_FALSE(cache.lookupSatisfiable("simulation", "AG(p)").has_value());
+    EXPECT_EQ(cache.misses(), 2u);
+}
+
+TEST(RefinementCacheTest, IgnoresTornTrailingLine) {
+    const std::string dir = freshDirectory();
+    {
+        RefinementCache cache(dir);
+        cache.storeSatisfiable("automaton", "EG(q)", true);
+    }
+    {
+        std::ofstream log(dir + "/verdicts.tsv", std::ios::app);
+        log << "S\tautomaton\tAG(q)\t";  // interrupted writer, no verdict
+    }
+    {
+        RefinementCache reopened(dir);
+        EXPECT_EQ(reopened.size(), 1u);
+        EXPECT_EQ(reopened.lookupSatisfiable("automaton", "EG(q)"), std::optional<bool>(true));
+        reopened.storeSatisfiable("automaton", "AF(q)", true);
+    }
+    // The next writer does not glue its entry onto the torn line
+    RefinementCache again(dir);
+    EXPECT_EQ(again.lookupSatisfiable("automaton", "AF(q)"), std::optional<bool>(true));
+}
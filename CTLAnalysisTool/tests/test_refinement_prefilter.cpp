@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+#include "../include/refinement_prefilter.h"
+#include "../include/Analyzers/Refinement.h"
+#include "../include/refinement_cache.h"
+#include <cstdlib>
+
+using namespace ctl;
+using Decision = RefinementPrefilter::Decision;
+
+namespace {
+
+Decision check(RefinementPrefilter& filter, const std::string& a, const std::string& b) {
+    static std::vector<std::shared_ptr<CTLProperty>> keep;
+    keep.push_back(CTLProperty::create(a));
+    keep.push_back(CTLProperty::create(b));
+    return filter.check(*keep[keep.size() - 2], *keep.back());
+}
+
+} // namespace
+
+TEST(RefinementPrefilterTest, FindsOneStateCounterexamples) {
+    RefinementPrefilter filter;
+    EXPECT_EQ(check(filter, "AG(p)", "EF(!p)"), Decision::DOES_NOT_REFINE);
+    EXPECT_EQ(check(filter, "AG(p)", "AG(p & q)"), Decision::DOES_NOT_REFINE);
+    EXPECT_EQ(check(filter, "E(p U q)", "AG(p)"), Decision::DOES_NOT_REFINE);
+    EXPECT_EQ(filter.decidedNonRefines(), 3u);
+}
+
+TEST(RefinementPrefilterTest, NeverRejectsGenuineRefinements) {
+    RefinementPrefilter filter;
+    EXPECT_EQ(check(filter, "AG(p & q)", "AG(p)"), Decision::UNKNOWN);
+    EXPECT_EQ(check(filter, "AG(p)", "AF(p)"), Decision::UNKNOWN);
+    EXPECT_EQ(check(filter, "AG(p)", "EF(p)"), Decision::UNKNOWN);
+    EXPECT_EQ(check(filter, "E(p U q)", "EF(q)"), Decision::UNKNOWN);
+    EXPECT_EQ(check(filter, "A(p W q)", "E(p W q)"), Decision::UNKNOWN);
+    EXPECT_EQ(filter.undecided(), 5u);
+}
+
+TEST(RefinementPrefilterTest, RefutesWithRandomKripkeModels) {
+    RefinementPrefilter filter;
+    // Every one-state model agrees on both sides of these
+    EXPECT_EQ(check(filter, "AF(p)", "AG(p)"), Decision::DOES_NOT_REFINE);
+    EXPECT_EQ(check(filter, "EF(p)", "AF(p)"), Decision::DOES_NOT_REFINE);
+    EXPECT_EQ(check(filter, "EX(p)", "AX(p)"), Decision::DOES_NOT_REFINE);
+    EXPECT_EQ(check(filter, "E(p U q)", "A(p U q)"), Decision::DOES_NOT_REFINE);
+    EXPECT_EQ(filter.refutedByModels(), 4u);
+    // Genuine refinements over total transition relations survive
+    EXPECT_EQ(check(filter, "AX(p)", "EX(p)"), Decision::UNKNOWN);
+    EXPECT_EQ(check(filter, "AG(p)", "AX(p)"), Decision::UNKNOWN);
+    EXPECT_EQ(check(filter, "A(p U q)", "AF(q)"), Decision::UNKNOWN);
+    EXPECT_EQ(check(filter, "A(p R q)", "AG(q) | EF(p & q)"), Decision::UNKNOWN);
+    EXPECT_EQ(check(filter, "AG(p)", "A(p W q)"), Decision::UNKNOWN);
+}
+
+TEST(RefinementPrefilterTest, DecidesLiteralsAndIdenticalFormulas) {
+    RefinementPrefilter filter;
+    EXPECT_EQ(check(filter, "false", "AG(p)"), Decision::REFINES);
+    EXPECT_EQ(check(filter, "EF(q)", "true"), Decision::REFINES);
+    EXPECT_EQ(check(filter, "AG(x > 1)", "AG(x > 1)"), Decision::REFINES);
+}
+
+TEST(RefinementPrefilterTest, RejectsVariableDisjointPairs) {
+    RefinementPrefilter filter;
+    auto comparison = CTLProperty::create("AG(x > 1)");
+    auto atom = CTLProperty::create("EF(q)");
+    // Comparisons are not sampled: nothing is known about AG(x > 1) yet
+    EXPECT_EQ(filter.check(*comparison, *atom), Decision::UNKNOWN);
+    filter.noteSatisfiable(*comparison);
+    EXPECT_EQ(filter.check(*comparison, *atom), Decision::DOES_NOT_REFINE);
+    // EF(q) refines a formula over other variables only if that formula is valid
+    EXPECT_EQ(filter.check(*atom, *comparison), Decision::UNKNOWN);
+}
+
+TEST(RefinementPrefilterTest, RejectsOppositePolarityPairs) {
+    RefinementPrefilter filter;
+    auto refining = CTLProperty::create("AG(p & x > 1)");
+    auto opposite = CTLProperty::create("EF(!p)");
+    auto same = CTLProperty::create("EF(p)");
+    filter.noteSatisfiable(*refining);
+    // p only occurs positively in one and negatively in the other
+    EXPECT_EQ(filter.check(*refining, *opposite), Decision::DOES_NOT_REFINE);
+    EXPECT_EQ(filter.check(*refining, *same), Decision::UNKNOWN);
+}
+
+TEST(RefinementPrefilterTest, AnalyzerSkipsAutomataForDecidedPairs) {
+    char templ[] = "/tmp/ctl_prefilter_testXXXXXX";
+    auto cache = std::make_shared<RefinementCache>(mkdtemp(templ));
+    for (const auto& f : {"AG(p)", "EF(!p)"}) {
+        cache->storeSatisfiable("automaton", CTLProperty(f).toString(), true);
+    }
+    RefinementAnalyzer analyzer(std::vector<std::string>{"AG(p)", "EF(!p)"});
+    analyzer.setParallelAnalysis(false);
+    analyzer.setSyntacticRefinement(false);
+    analyzer.setCache(cache);
+    auto result = analyzer.analyze();
+    EXPECT_EQ(result.total_refinements, 0u);
+    EXPECT_EQ(result.prefilter_rejected, 2u);
+    EXPECT_EQ(result.prefilter_undecided, 0u);
+    // No refinement verdict had to be looked up or stored
+    EXPECT_EQ(cache->size(), 2u);
+}
+
+TEST(RefinementPrefilterTest, StrengthOrderingSkipsImpliedPairs) {
+    // A chain listed strongest first, the worst case for row-major visiting
+    const std::vector<std::string> chain = {"AG(p & q & r)", "AG(p & q)", "AG(p)", "EF(p | q)"};
+    for (bool parallel : {false, true}) {
+        for (bool transitive : {false, true}) {
+            char templ[] = "/tmp/ctl_prefilter_testXXXXXX";
+            auto cache = std::make_shared<RefinementCache>(mkdtemp(templ));
+            for (size_t a = 0; a < chain.size(); ++a) {
+                cache->storeSatisfiable("automaton", CTLProperty(chain[a]).toString(), true);
+                for (size_t b = 0; b < chain.size(); ++b) {
+                    if (a == b) continue;
+                    cache->storeRefinement("simulation", CTLProperty(chain[a]).toString(),
+                                           CTLProperty(chain[b]).toString(), a < b);
+                }
+            }
+            RefinementAnalyzer analyzer(chain);
+            analyzer.setParallelAnalysis(parallel);
+            analyzer.setThreads(1);
+            analyzer.setSyntacticRefinement(false);
+            analyzer.setUsePrefilter(false);
+            analyzer.setUseTransitiveOptimization(transitive);
+            analyzer.setCache(cache);
+            auto result = analyzer.analyze();
+
+            EXPECT_EQ(result.total_refinements, 6u) << parallel << transitive;
+            const size_t refinement_lookups = cache->hits() - chain.size();
+            if (transitive) {
+                // Weakest rows first: AG(p & q) and AG(p & q & r) inherit the rows below them
+                EXPECT_EQ(result.transitive_eliminated, 3);
+                EXPECT_EQ(refinement_lookups, 9u);
+            } else {
+                EXPECT_EQ(refinement_lookups, 12u);
+            }
+        }
+    }
+}
+
+TEST(RefinementPrefilterTest, NonRefinementsRefuteFurtherPairs) {
+    // Same sample and length everywhere, so only the class order decides the visiting order
+    const std::vector<std::string> formulas = {"AG(p)", "AF(p)", "EF(p)", "EG(p)"};
+    const std::vector<std::pair<size_t, size_t>> truths = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {3, 2}};
+    char templ[] = "/tmp/ctl_prefilter_testXXXXXX";
+    auto cache = std::make_shared<RefinementCache>(mkdtemp(templ));
+    for (size_t a = 0; a < formulas.size(); ++a) {
+        cache->storeSatisfiable("automaton", CTLProperty(formulas[a]).toString(), true);
+        for (size_t b = 0; b < formulas.size(); ++b) {
+            if (a == b) continue;
+            bool refines = std::find(truths.begin(), truths.end(), std::make_pair(a, b)) != truths.end();
+            cache->storeRefinement("inclusion", CTLProperty(formulas[a]).toString(),
+                                   CTLProperty(formulas[b]).toString(), refines);
+        }
+    }
+    // Only exact verdicts refute: a simulation miss proves nothing
+    RefinementAnalyzer analyzer(formulas);
+    analyzer.setParallelAnalysis(false);
+    analyzer.setSyntacticRefinement(false);
+    analyzer.setFullLanguageInclusion(true);
+    analyzer.setUsePrefilter(false);
+    analyzer.setCache(cache);
+    auto result = analyzer.analyze();
+
+    EXPECT_EQ(result.total_refinements, truths.size());
+    // Every pair AG(p) is not refined by is settled without a check, and with
+    // the class in input order one more pair besides
+    auto stats = analyzer.getTransitiveOptimizationStats();
+    EXPECT_EQ(stats.total_eliminated, 4u);
+    EXPECT_GE(stats.refuted_pairs, 2u);
+    EXPECT_EQ(stats.implied_pairs + stats.refuted_pairs, stats.total_eliminated);
+    EXPECT_EQ(stats.total_before_optimization, 12u);
+    EXPECT_EQ(cache->hits() - formulas.size(), 8u);
+}
+
+TEST(RefinementPrefilterTest, EquivalentPropertiesAreCheckedOnce) {
+    // Two spellings of AG(p) and two of EF(p), plus AF(p) in between
+    const std::vector<std::string> formulas = {"AG(p)", "AG(p & p)", "EF(p)", "AF(p)", "EF(p | p)"};
+    auto strength = [](size_t k) { return k < 2 ? 0 : (k == 3 ? 1 : 2); };
+    for (bool parallel : {false, true}) {
+        char templ[] = "/tmp/ctl_prefilter_testXXXXXX";
+        auto cache = std::make_shared<RefinementCache>(mkdtemp(templ));
+        for (size_t a = 0; a < formulas.size(); ++a) {
+            cache->storeSatisfiable("automaton", CTLProperty(formulas[a]).toString(), true);
+            for (size_t b = 0; b < formulas.size(); ++b) {
+                if (a == b) continue;
+                cache->storeRefinement("inclusion", CTLProperty(formulas[a]).toString(),
+                                       CTLProperty(formulas[b]).toString(), strength(a) <= strength(b));
+            }
+        }
+        // Exact verdicts, so a representative's verdict stands for its group
+        RefinementAnalyzer analyzer(formulas);
+        analyzer.setParallelAnalysis(parallel);
+        analyzer.setThreads(1);
+        analyzer.setSyntacticRefinement(false);
+        analyzer.setFullLanguageInclusion(true);
+        analyzer.setUsePrefilter(false);
+        analyzer.setCache(cache);
+        auto result = analyzer.analyze();
+
+        // 2 + 2 mutual edges, 2 * 3 from the AG spellings, 2 from AF(p)
+        EXPECT_EQ(result.total_refinements, 12u) << parallel;
+        EXPECT_EQ(analyzer.getTransitiveOptimizationStats().condensed_properties, 2u) << parallel;
+        EXPECT_LT(cache->hits() - formulas.size(), 20u) << parallel;
+    }
+}
+
+TEST(RefinementPrefilterTest, CondensedPairsFallBackToTheirMembers) {
+    // The cached simulation verdicts miss AG(p) -> EF(p) but prove it for
+    // the equivalent AG(p & p): the miss of the representative must not
+    // stand for the whole group. Rows go shortest first, so AG(p & p) is
+    // visited once it is condensed into AG(p)
+    const std::vector<std::string> formulas = {"EF(p)", "AG(p)", "AG(p & p)"};
+    const std::vector<std::pair<size_t, size_t>> proven = {{1, 2}, {2, 1}, {2, 0}};
+    for (bool parallel : {false, true}) {
+        char templ[] = "/tmp/ctl_prefilter_testXXXXXX";
+        auto cache = std::make_shared<RefinementCache>(mkdtemp(templ));
+        for (size_t a = 0; a < formulas.size(); ++a) {
+            cache->storeSatisfiable("automaton", CTLProperty(formulas[a]).toString(), true);
+            for (size_t b = 0; b < formulas.size(); ++b) {
+                if (a == b) continue;
+                bool refines = std::find(proven.begin(), proven.end(), std::make_pair(a, b)) != proven.end();
+                cache->storeRefinement("simulation", CTLProperty(formulas[a]).toString(),
+                                       CTLProperty(formulas[b]).toString(), refines);
+            }
+        }
+        RefinementAnalyzer analyzer(formulas);
+        analyzer.setParallelAnalysis(parallel);
+        analyzer.setThreads(1);
+        analyzer.setSyntacticRefinement(false);
+        analyzer.setUsePrefilter(false);
+        analyzer.setCache(cache);
+        analyzer.analyze();
+
+        ASSERT_EQ(analyzer.getRefinementGraphs().size(), 1u);
+        const auto& graph = analyzer.getRefinementGraphs()[0];
+        for (auto [i, j] : proven) {
+            EXPECT_TRUE(graph.hasEdge(i, j)) << parallel << " " << i << " -> " << j;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include "../include/Analyzers/Refinement.h"
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace ctl;
+
+namespace {
+
+std::vector<std::string> lines(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    std::vector<std::string> result;
+    for (std::string line; std::getline(in, line);) result.push_back(line);
+    return result;
+}
+
+} // namespace
+
+TEST(ReportOutputsTest, WritesEveryOutputInTheBackground) {
+    RefinementAnalyzer analyzer(std::vector<std::string>{"AG(p)", "AF(p)", "EF(p)", "AG(q)", "EF(q)", "AG(p)"});
+    analyzer.setUsePrefilter(false);
+    const AnalysisResult result = analyzer.analyze();
+    ASSERT_EQ(result.required_properties, 2u);
+    ASSERT_EQ(analyzer.getRequiredProperties().size(), 2u);
+
+    const auto dir = std::filesystem::temp_directory_path() / ("ctl_outputs_" + std::to_string(getpid()));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::future<void> written = analyzer.writeOutputsAsync(dir.string(), result);
+    ASSERT_NO_THROW(written.get());
+
+    // The required properties, by input index, are the strongest of each class
+    EXPECT_EQ(lines(dir / "required_properties.csv"),
+              (std::vector<std::string>{"Index,Property", "0,\"AG (p)\"", "3,\"AG (q)\""}));
+    for (size_t c = 1; c <= analyzer.getRefinementGraphs().size(); ++c) {
+        EXPECT_TRUE(std::filesystem::exists(dir / ("refinement_class_" + std::to_string(c) + ".dot"))) << c;
+    }
+    EXPECT_TRUE(std::filesystem::exists(dir / "refinement_analysis.txt"));
+    EXPECT_TRUE(std::filesystem::exists(dir / "false_properties.txt"));
+    EXPECT_TRUE(std::filesystem::exists(dir / "duplicate_properties.csv"));
+    std::filesystem::remove_all(dir);
+
+    // A writer that fails reports through the future
+    EXPECT_THROW(analyzer.writeOutputsAsync("/proc/ctl_no_such_dir", result).get(), std::exception);
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include "../include/scaling_benchmark.h"
+#include <sstream>
+
+using namespace ctl;
+
+TEST(ScalingBenchmarkTest, PointReportsChecksAndLatencies) {
+    ScalingConfig config;
+    config.atoms = 3;
+    ScalingBenchmark benchmark(config);
+    ScalingPoint point = benchmark.runPoint(6, 3, 2, ScalingEngine::LANGUAGE_INCLUSION);
+
+    EXPECT_TRUE(point.error.empty()) << point.error;
+    EXPECT_GT(point.checks, 0u);
+    EXPECT_LE(point.checks + point.skipped, point.properties * (point.properties - 1));
+    EXPECT_LE(point.p50_ms, point.p99_ms);
+    EXPECT_GE(point.skip_ratio, 0.0);
+    EXPECT_LE(point.skip_ratio, 1.0);
+    EXPECT_GT(point.peak_rss_kb, 0u);
+}
+
+TEST(ScalingBenchmarkTest, SweepWritesOneLinePerPoint) {
+    ScalingConfig config;
+    config.class_sizes = {4, 6};
+    config.depths = {2};
+    config.thread_counts = {1};
+    config.engines = {ScalingEngine::SIMULATION};
+    std::ostringstream out;
+    EXPECT_EQ(ScalingBenchmark(config).run(out), 0u);
+
+    std::istringstream lines(out.str());
+    size_t count = 0;
+    for (std::string line; std::getline(lines, line); ++count) {
+        EXPECT_EQ(line.front(), '{');
+        EXPECT_NE(line.find("\"engine\":\"simulation\""), std::string::npos);
+        EXPECT_NE(line.find("\"checks_per_sec\":"), std::string::npos);
+    }
+    EXPECT_EQ(count, 2u);
+}
+
+TEST(ScalingBenchmarkTest, EngineNamesRoundTrip) {
+    for (auto engine : {ScalingEngine::SIMULATION, ScalingEngine::LANGUAGE_INCLUSION,
+                        ScalingEngine::CTL_SAT, ScalingEngine::MLSOLVER}) {
+        EXPECT_EQ(ScalingEngineFromString(ScalingEngineToString(engine)), engine);
+    }
+    EXPECT_FALSE(ScalingEngineFromString("nusmv").has_value());
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "../include/scc.h"
+
+#include <algorithm>
+
+using namespace ctl;
+
+namespace {
+
+struct Graph {
+    std::vector<uint32_t> offsets{0};
+    std::vector<uint32_t> targets;
+
+    explicit Graph(const std::vector<std::vector<uint32_t>>& successors) {
+        for (const auto& out : successors) {
+            targets.insert(targets.end(), out.begin(), out.end());
+            offsets.push_back(static_cast<uint32_t>(targets.size()));
+        }
+    }
+    CSRGraphView<uint32_t> view() const { return {offsets, targets}; }
+};
+
+std::vector<uint32_t> sorted(std::span<const uint32_t> members) {
+    std::vector<uint32_t> out(members.begin(), members.end());
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+} // end anonymous namespace
+
+TEST(SCCTest, FindsCyclesAndSingletons) {
+    // 0 <-> 1 -> 2 -> 3 -> 2, 4 alone with a self loop
+    Graph graph({{1}, {0, 2}, {3}, {2}, {4}});
+    const SCCDecomposition sccs = stronglyConnectedComponents(graph.view());
+    ASSERT_EQ(sccs.size(), 3u);
+    EXPECT_EQ(sccs.component[0], sccs.component[1]);
+    EXPECT_EQ(sccs.component[2], sccs.component[3]);
+    EXPECT_NE(sccs.component[0], sccs.component[2]);
+    EXPECT_EQ(sorted(sccs[sccs.component[4]]), std::vector<uint32_t>{4});
+    EXPECT_EQ(sccs.members.size(), 5u);
+}
+
+TEST(SCCTest, ComponentsComeSuccessorsFirst) {
+    // A chain of three components: {0,1} -> {2} -> {3,4}
+    Graph graph({{1}, {0, 2}, {3}, {4}, {3}});
+    const SCCDecomposition sccs = stronglyConnectedComponents(graph.view());
+    ASSERT_EQ(sccs.size(), 3u);
+    EXPECT_EQ(sorted(sccs[0]), (std::vector<uint32_t>{3, 4}));
+    EXPECT_EQ(sorted(sccs[1]), std::vector<uint32_t>{2});
+    EXPECT_EQ(sorted(sccs[2]), (std::vector<uint32_t>{0, 1}));
+}
+
+TEST(SCCTest, DeepGraphsDoNotRecurse) {
+    // A path of a million vertices closed into one cycle
+    const uint32_t n = 1000000;
+    std::vector<std::vector<uint32_t>> successors(n);
+    for (uint32_t v = 0; v < n; ++v) successors[v] = {(v + 1) % n};
+    Graph graph(successors);
+    const SCCDecomposition sccs = stronglyConnectedComponents(graph.view());
+    ASSERT_EQ(sccs.size(), 1u);
+    EXPECT_EQ(sccs[0].size(), n);
+}
+
+TEST(SCCTest, EmptyGraph) {
+    Graph graph({});
+    EXPECT_EQ(stronglyConnectedComponents(graph.view()).size(), 0u);
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "../include/Analyzers/Refinement.h"
+
+#include <cstdio>
+
+using namespace ctl;
+
+namespace {
+
+const std::vector<std::string> kFormulas{
+    "AG(p)", "AF(p)", "AG(p & q)", "EF(q)", "AG(q)", "EF(p & q)", "AG(r)", "AF(r | s)", "EF(s)"};
+
+std::string shardPath(size_t k, size_t n) {
+    return testing::TempDir() + "ctl_shard_" + std::to_string(k) + "_of_" + std::to_string(n) + ".ckpt";
+}
+
+} // end anonymous namespace
+
+TEST(ShardTest, CoordinatorMergesWorkersIntoTheSingleProcessResult) {
+    RefinementAnalyzer single(kFormulas);
+    single.setParallelAnalysis(false);
+    AnalysisResult expected = single.analyze();
+
+    // Row blocks of two rows, so the big class is split across workers
+    constexpr size_t kShards = 3;
+    for (size_t k = 0; k < kShards; ++k) {
+        std::remove(shardPath(k, kShards).c_str());
+        RefinementAnalyzer worker(kFormulas);
+        worker.setParallelAnalysis(false);
+        worker.setCheckpoint(shardPath(k, kShards), std::chrono::seconds(3600), false);
+        worker.setShard(k, kShards, 2);
+        worker.analyze();
+    }
+
+    const std::string merged = testing::TempDir() + "ctl_shard_merged.ckpt";
+    std::remove(merged.c_str());
+    RefinementAnalyzer coordinator(kFormulas);
+    coordinator.setParallelAnalysis(false);
+    coordinator.setCheckpoint(merged, std::chrono::seconds(3600), false);
+    for (size_t k = 0; k < kShards; ++k) coordinator.addShardResults(shardPath(k, kShards));
+    AnalysisResult result = coordinator.analyze();
+
+    EXPECT_EQ(result.total_refinements, expected.total_refinements);
+    ASSERT_EQ(coordinator.getRefinementGraphs().size(), single.getRefinementGraphs().size());
+    for (size_t c = 0; c < single.getRefinementGraphs().size(); ++c) {
+        const auto& want = single.getRefinementGraphs()[c];
+        const auto& got = coordinator.getRefinementGraphs()[c];
+        for (size_t i = 0; i < want.getNodeCount(); ++i) {
+            for (size_t j = 0; j < want.getNodeCount(); ++j) {
+                EXPECT_EQ(got.hasEdge(i, j), want.hasEdge(i, j)) << "class " << c << " pair " << i << "," << j;
+            }
+        }
+    }
+    // Every semantic check was done by a worker
+    EXPECT_EQ(coordinator.getHotPathStatistics()[static_cast<size_t>(Statistic::SIMULATION_CHECKS)], 0u);
+
+    for (size_t k = 0; k < kShards; ++k) std::remove(shardPath(k, kShards).c_str());
+    std::remove(merged.c_str());
+}
+
+TEST(ShardTest, MissingShardIsRedoneByTheCoordinator) {
+    RefinementAnalyzer single(kFormulas);
+    single.setParallelAnalysis(false);
+    AnalysisResult expected = single.analyze();
+
+    const std::string merged = testing::TempDir() + "ctl_shard_missing.ckpt";
+    std::remove(merged.c_str());
+    RefinementAnalyzer coordinator(kFormulas);
+    coordinator.setParallelAnalysis(false);
+    coordinator.setCheckpoint(merged, std::chrono::seconds(3600), false);
+    coordinator.addShardResults(testing::TempDir() + "ctl_shard_never_written.ckpt");
+    EXPECT_EQ(coordinator.analyze().total_refinements, expected.total_refinements);
+    std::remove(merged.c_str());
+}
+
+TEST(ShardTest, RejectsBadShardsAndShardingWithoutCheckpoint) {
+    RefinementAnalyzer analyzer(kFormulas);
+    EXPECT_THROW(analyzer.setShard(3, 3), std::invalid_argument);
+    EXPECT_THROW(analyzer.setShard(0, 0), std::invalid_argument);
+    analyzer.setShard(0, 2);
+    EXPECT_THROW(analyzer.analyze(), std::runtime_error);
+}
@@ -2,6 +2,8 @@
 #include "../include/formula.h"
 #include "../include/CTLautomaton.h"
 #include "../include/property.h"
+#include "../include/statistics.h"
+#include "../include/Analyzers/Refinement.h"
 #include <memory>
 
 using namespace ctl;
@@ -301,6 +303,149 @@ TEST(SimulationTest, Test21_AU_Refines_EU) {
     EXPECT_TRUE(prop_au->refines(*prop_eu, false, false));
     EXPECT_FALSE(prop_eu->refines(*prop_au, false, false));
 }
+
+// ==================== CLASS-WIDE PREORDER ====================
+
+TEST(SimulationTest, Test22_PreorderMatchesPairwiseSimulation) {
+    // One fixpoint over all automata answers every pair as simulates() does
+    std::vector<std::shared_ptr<CTLProperty>> props;
+    for (const char* formula : {"AG(p)", "AG(p & q)", "EF(p)", "AF(p)", "E(p U q)", "A(p U q)", "p", "false"}) {
+        props.push_back(makeProperty(formula));
+    }
+    std::vector<const CTLAutomaton*> automata;
+    for (const auto& prop : props) automata.push_back(&prop->automaton());
+
+    BitMatrix preorder = CTLAutomaton::simulationPreorder(automata);
+    for (size_t i = 0; i < props.size(); ++i) {
+        for (size_t j = 0; j < props.size(); ++j) {
+            EXPECT_EQ(preorder.test(i, j), automata[j]->simulates(*automata[i]))
+                << props[i]->toString() << " vs " << props[j]->toString();
+        }
+    }
+}
+TEST(SimulationTest, Test23_SubformulaStoreKeepsVerdicts) {
+    // Automata sharing a store answer as automata on their own
+    const std::vector<std::string> formulas{"AG(p -> AF(q))", "AG(p -> AF(q)) & EF(r)", "AG(p -> AF(q)) | EG(r)",
+                                            "A(p R q)", "E(p U (q & r))", "EF(q)"};
+    auto store = std::make_shared<SubformulaStore>();
+    std::vector<std::shared_ptr<CTLProperty>> alone, shared;
+    for (const auto& formula : formulas) {
+        alone.push_back(makeProperty(formula));
+        shared.push_back(makeProperty(formula));
+        shared.back()->setSubformulaStore(store);
+    }
+    const StatisticValues before = Statistics::instance().snapshot();
+    for (size_t i = 0; i < formulas.size(); ++i) {
+        for (size_t j = 0; j < formulas.size(); ++j) {
+            EXPECT_EQ(shared[j]->automaton().simulates(shared[i]->automaton()),
+                      alone[j]->automaton().simulates(alone[i]->automaton()))
+                << formulas[i] << " vs " << formulas[j];
+        }
+    }
+    // AG(p -> AF(q)) and its subformulas are expanded once for all of them
+    const StatisticValues delta = Statistics::instance().snapshot() - before;
+    EXPECT_GT(delta[static_cast<size_t>(Statistic::SHARED_MOVES_REUSED)], 0u);
+    EXPECT_GT(delta[static_cast<size_t>(Statistic::SHARED_SIMULATION_VERDICTS)], 0u);
+    EXPECT_LT(store->size(), 40u);
+}
+TEST(SimulationTest, Test24_CompositionalRefinement) {
+    // Part by part the checks prove at least what the whole pairs prove
+    const std::vector<std::string> formulas{"AG(p) | AG(q)", "AG(p & q)", "AG(p) & EF(q)", "EF(p) & EF(q)",
+                                            "EF(p | q)", "AG(p) | (EG(q) | AF(r))"};
+    for (const auto& refining : formulas) {
+        for (const auto& refined : formulas) {
+            auto prop1 = makeProperty(refining);
+            auto prop2 = makeProperty(refined);
+            if (prop1->refines(*prop2, false, false)) {
+                EXPECT_TRUE(prop1->refines(*prop2, false, false, EmptinessEngine::FIXPOINT, nullptr, true))
+                    << refining << " -> " << refined;
+            }
+            // Inclusion is exact, whole or in parts
+            EXPECT_EQ(prop1->refines(*prop2, false, true, EmptinessEngine::FIXPOINT, nullptr, true),
+                      prop1->refines(*prop2, false, true))
+                << refining << " -> " << refined;
+        }
+    }
+    // The verdicts of the parts are kept: a second pair with the same parts holds as well
+    EXPECT_TRUE(makeProperty("AG(p & q) | AG(p & r)")->refines(*makeProperty("EF(p) & AF(p)"), false, false,
+                                                               EmptinessEngine::FIXPOINT, nullptr, true));
+    EXPECT_FALSE(makeProperty("AG(p & q) | EF(r)")->refines(*makeProperty("EF(p) & AF(p)"), false, false,
+                                                            EmptinessEngine::FIXPOINT, nullptr, true));
+}
+TEST(SimulationTest, Test25_MutualSimulationMatchesPairwiseSimulation) {
+    const std::vector<std::string> formulas{"AG(p)", "AG(p & q)", "EF(p)", "A(p U q)", "E(p U q)", "AG(p -> AF(q))",
+                                            "false"};
+    for (size_t i = 0; i < formulas.size(); ++i) {
+        for (size_t j = i + 1; j < formulas.size(); ++j) {
+            auto a = makeProperty(formulas[i]);
+            auto b = makeProperty(formulas[j]);
+            CTLAutomaton::MutualSimulation both(a->automaton(), b->automaton());
+            // Either direction may come first
+            const bool backward = both.simulated(false);
+            EXPECT_EQ(both.simulated(true), b->automaton().simulates(a->automaton()))
+                << formulas[i] << " -> " << formulas[j];
+            EXPECT_EQ(backward, a->automaton().simulates(b->automaton())) << formulas[j] << " -> " << formulas[i];
+        }
+    }
+}
+TEST(SimulationTest, Test26_JointPairsKeepTheGraphs) {
+    const std::vector<std::string> formulas{"AG(p)", "AF(p)", "AG(p & q)", "EF(q)", "EG(p)", "AG(p -> AF(q))",
+                                            "EF(p & q)", "AG(q)"};
+    for (bool transitive : {true, false}) {
+        for (bool parallel : {true, false}) {
+            RefinementAnalyzer separate(formulas), joint(formulas);
+            for (RefinementAnalyzer* analyzer : {&separate, &joint}) {
+                analyzer->setUsePrefilter(false);
+                analyzer->setUseTransitiveOptimization(transitive);
+                analyzer->setParallelAnalysis(parallel);
+            }
+            joint.setJointPairs(true);
+            const AnalysisResult expected = separate.analyze();
+            const AnalysisResult result = joint.analyze();
+            EXPECT_EQ(result.total_refinements, expected.total_refinements);
+            ASSERT_EQ(joint.getRefinementGraphs().size(), separate.getRefinementGraphs().size());
+            for (size_t c = 0; c < separate.getRefinementGraphs().size(); ++c) {
+                const auto& a = separate.getRefinementGraphs()[c];
+                const auto& b = joint.getRefinementGraphs()[c];
+                for (size_t i = 0; i < a.getNodes().size(); ++i) {
+                    for (size_t j = 0; j < a.getNodes().size(); ++j) {
+                        if (i != j) {
+                            EXPECT_EQ(a.hasEdge(i, j), b.hasEdge(i, j)) << transitive << parallel;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+TEST(SimulationTest, Test27_UnprovenPairsRefuteNothing) {
+    // !(EF(!p)) and AG(p) are equivalent, but simulation proves only
+    // AG(p) -> EF(p): its misses must not refute pairs through the closure
+    const std::vector<std::string> formulas{"!(EF(!p))", "AG(p)", "EF(p)"};
+    for (bool parallel : {true, false}) {
+        RefinementAnalyzer direct(formulas), closed(formulas);
+        for (RefinementAnalyzer* analyzer : {&direct, &closed}) {
+            analyzer->setDeduplication(false);
+            analyzer->setParallelAnalysis(parallel);
+        }
+        direct.setUseTransitiveOptimization(false);
+        closed.setUseTransitiveOptimization(true);
+        direct.analyze();
+        closed.analyze();
+        ASSERT_EQ(closed.getRefinementGraphs().size(), direct.getRefinementGraphs().size());
+        for (size_t c = 0; c < direct.getRefinementGraphs().size(); ++c) {
+            const auto& a = direct.getRefinementGraphs()[c];
+            const auto& b = closed.getRefinementGraphs()[c];
+            for (size_t i = 0; i < a.getNodes().size(); ++i) {
+                for (size_t j = 0; j < a.getNodes().size(); ++j) {
+                    if (a.hasEdge(i, j)) {
+                        EXPECT_TRUE(b.hasEdge(i, j)) << parallel << " " << i << " -> " << j;
+                    }
+                }
+            }
+        }
+    }
+}
 /*
 TEST(SimulationTest, Test22_Until_Destination) {
     // A(p U q) should refine AF(q)
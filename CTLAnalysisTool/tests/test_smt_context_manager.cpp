@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "../include/smt_context_manager.h"
+#include "../include/property.h"
+#include "../include/entailment_session.h"
+#include <thread>
+
+using namespace ctl;
+
+TEST(SMTContextManagerTest, SameThreadReusesInterface) {
+    SMTInterface& a = SMTContextManager::local();
+    SMTInterface& b = SMTContextManager::local();
+    EXPECT_EQ(&a, &b);
+    EXPECT_TRUE(a.isSatisfiable(std::string("p & q")));
+    EXPECT_FALSE(a.isSatisfiable(std::string("p & !p")));
+}
+
+TEST(SMTContextManagerTest, ThreadsGetDistinctInterfaces) {
+    SMTInterface* main_iface = &SMTContextManager::local();
+    SMTInterface* other_iface = nullptr;
+    std::thread worker([&]() { other_iface = &SMTContextManager::local(); });
+    worker.join();
+    EXPECT_NE(main_iface, other_iface);
+}
+
+TEST(SMTContextManagerTest, AutomataShareTheThreadContext) {
+    SMTContextManager::local();
+    size_t before = SMTContextManager::contextsCreated();
+    auto p1 = std::make_shared<CTLProperty>("AG(p & q)");
+    auto p2 = std::make_shared<CTLProperty>("EF(p | r)");
+    p1->automaton();
+    p2->automaton();
+    EXPECT_EQ(SMTContextManager::contextsCreated(), before);
+}
+
+TEST(SMTContextManagerTest, BddGuardsFallBackOnTheThreadContext) {
+    SMTContextManager::local();
+    const bool enabled = SMTContextManager::propositionalGuards();
+    SMTContextManager::setPropositionalGuards(true);
+    size_t before = SMTContextManager::contextsCreated();
+    EXPECT_TRUE(SMTContextManager::guards().isSatisfiable(std::string("(x <= 3) & p")));
+    EXPECT_EQ(SMTContextManager::contextsCreated(), before);
+    SMTContextManager::setPropositionalGuards(enabled);
+}
+
+TEST(SMTContextManagerTest, EntailmentSessionsAgreeWithStringQueries) {
+    SMTInterface& smt = SMTContextManager::local();
+    auto native = smt.openEntailmentSession();
+    auto strings = openStringEntailmentSession(smt);
+    auto& table = GuardTable::instance();
+    const GuardTable::Id p = table.intern("p"), q = table.intern("q");
+    const GuardTable::Id low = table.intern("x <= 3"), high = table.intern("x < 5");
+    // premise => conclusion iff premise & !conclusion is unsatisfiable
+    auto entails = [](EntailmentSession& session, std::vector<GuardTable::Id> premise,
+                      std::vector<GuardTable::Id> conclusion) {
+        std::vector<EntailmentSession::Literal> assumptions;
+        for (GuardTable::Id guard : premise) assumptions.push_back(session.assume(guard));
+        assumptions.push_back(session.assumeNotAll(conclusion));
+        return session.check(assumptions, std::nullopt) == EntailmentSession::Verdict::UNSAT;
+    };
+    for (EntailmentSession* session : {native.get(), strings.get()}) {
+        EXPECT_TRUE(entails(*session, {p, q}, {p}));
+        EXPECT_FALSE(entails(*session, {p}, {p, q}));
+        EXPECT_TRUE(entails(*session, {low}, {high}));
+        EXPECT_FALSE(entails(*session, {high}, {low}));
+        // Earlier indicators stay asserted but constrain nothing
+        EXPECT_FALSE(entails(*session, {q}, {p}));
+    }
+}
+
+#ifdef USE_Z3
+#include "../include/SMTInterfaces/Z3SMTInterface.h"
+
+TEST(SMTContextManagerTest, GuardExpressionsAreCachedPerThread) {
+    auto& smt = SMTContextManager::localZ3();
+    const z3::expr& first = smt.getExpression("(x <= 3) & p");
+    const z3::expr& second = smt.getExpression("(x <= 3) & p");
+    EXPECT_EQ(&first, &second);
+}
+
+TEST(SMTContextManagerTest, LoweringAgreesWithStringParser) {
+    z3::context& ctx = SMTContextManager::localZ3Context();
+    for (const std::string guard : {"p & q", "!(p) | q", "(2 <= x) & !(x > 5)", "p -> (y == 1)", "true", "(x != y)"}) {
+        z3::expr lowered = formula_utils::guardToZ3(guard, ctx);
+        z3::expr parsed = formula_utils::parseStringToZ3(guard, ctx);
+        z3::solver s(ctx);
+        s.add(lowered != parsed);
+        EXPECT_EQ(s.check(), z3::unsat) << guard;
+    }
+}
+
+TEST(SMTContextManagerTest, LoweringKeepsLiteralsBeyondInt) {
+    z3::context& ctx = SMTContextManager::localZ3Context();
+    z3::solver s(ctx);
+    s.add(formula_utils::guardToZ3("x >= 99999999999", ctx));
+    s.add(formula_utils::guardToZ3("x < 100000000000", ctx));
+    ASSERT_EQ(s.check(), z3::sat);
+    EXPECT_EQ(s.get_model().eval(ctx.int_const("x")).get_decimal_string(0), "99999999999");
+}
+
+TEST(SMTContextManagerTest, SolverLeasesComeBackEmpty) {
+    Z3SolverPool& pool = SMTContextManager::localZ3().solverPool();
+    z3::context& ctx = SMTContextManager::localZ3Context();
+    z3::solver* first = nullptr;
+    {
+        auto solver = pool.acquire();
+        first = &*solver;
+        solver->add(ctx.bool_const("p") && !ctx.bool_const("p"));
+        EXPECT_EQ(solver->check(), z3::unsat);
+    }
+    auto again = pool.acquire();
+    EXPECT_EQ(&*again, first);
+    EXPECT_EQ(again->assertions().size(), 0u);
+    EXPECT_EQ(again->check(), z3::sat);
+}
+
+TEST(SMTContextManagerTest, SimulationChecksReuseSolvers) {
+    auto weak = std::make_shared<CTLProperty>("AG(p)");
+    auto strong = std::make_shared<CTLProperty>("AG(p & q)");
+    weak->automaton().simulates(strong->automaton());
+    const size_t created = Z3SolverPool::solversCreated();
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(weak->automaton().simulates(strong->automaton()));
+        EXPECT_FALSE(strong->automaton().simulates(weak->automaton()));
+    }
+    EXPECT_EQ(Z3SolverPool::solversCreated(), created);
+}
+#endif
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "../include/property.h"
+#include "../include/arena.h"
+#include "../include/game_graph.h"
+#include <algorithm>
+
+using namespace ctl;
+
+namespace {
+
+void expectIndexMatchesNames(const CTLAutomaton& a) {
+    ASSERT_GT(a.numStates(), 0u);
+    for (StateId id = 0; id < a.numStates(); ++id) {
+        std::string_view name = a.getStateName(id);
+        EXPECT_EQ(a.getStateId(name), id);
+        EXPECT_EQ(a.isAccepting(id), a.isAccepting(name));
+
+        auto succs = a.getSuccessors(id);
+        EXPECT_TRUE(std::is_sorted(succs.begin(), succs.end()));
+        for (const auto& t : a.getTransitions(id)) {
+            EXPECT_EQ(t->from, name);
+            for (const auto& clause : t->clauses) {
+                for (const auto& lit : clause.literals) {
+                    ASSERT_NE(lit.qid, INVALID_STATE_ID);
+                    EXPECT_EQ(a.getStateName(lit.qid), lit.qnext);
+                    EXPECT_TRUE(std::binary_search(succs.begin(), succs.end(), lit.qid));
+                }
+            }
+        }
+    }
+    EXPECT_EQ(a.getStateName(a.getInitialStateId()), a.getInitialState());
+    EXPECT_EQ(a.getStateId("no_such_state"), INVALID_STATE_ID);
+}
+
+} // namespace
+
+TEST(StateIndexTest, DenseIdsAgreeWithNames) {
+    for (const char* formula : {"AG(p)", "EF(p & q)", "A(p U q) & EG(!q)", "AG(EF(p)) | E(p W q)"}) {
+        SCOPED_TRACE(formula);
+        CTLProperty prop(formula, false);
+        expectIndexMatchesNames(prop.automaton());
+    }
+}
+
+TEST(StateIndexTest, GameEdgesAreIndexedBothWays) {
+    for (const char* formula : {"AG(p)", "A(p U q) & EG(!q)", "AG(EF(p)) | E(p W q)"}) {
+        SCOPED_TRACE(formula);
+        CTLProperty prop(formula, false);
+        const auto game = prop.automaton().buildGameGraph();
+        ASSERT_EQ(game.numStates(), prop.automaton().numStates());
+        EXPECT_EQ(game.owners.size(), game.numStates());
+        EXPECT_EQ(game.priorities.size(), game.numStates());
+        EXPECT_EQ(game.initial_state, prop.automaton().getInitialStateId());
+        EXPECT_EQ(game.edges.size(), game.num_edges);
+
+        size_t incoming = 0;
+        for (StateId id = 0; id < game.numStates(); ++id) {
+            for (const auto& edge : game.getEdgesFrom(id)) EXPECT_EQ(edge.source, id);
+            for (uint32_t e : game.getEdgesTo(id)) {
+                const auto targets = game.getTargetStates(e);
+                EXPECT_TRUE(std::binary_search(targets.begin(), targets.end(), id));
+            }
+            incoming += game.getEdgesTo(id).size();
+        }
+        // Every edge is listed once under each of its distinct targets
+        size_t targets = 0;
+        for (uint32_t e = 0; e < game.edges.size(); ++e) {
+            const auto span = game.getTargetStates(e);
+            EXPECT_TRUE(std::adjacent_find(span.begin(), span.end()) == span.end());
+            for (const auto& clause : game.edges[e].clauses()) {
+                for (const auto& lit : clause.literals) {
+                    EXPECT_TRUE(std::binary_search(span.begin(), span.end(), lit.qid));
+                }
+            }
+            targets += span.size();
+        }
+        EXPECT_EQ(incoming, targets);
+    }
+}
+
+TEST(StateIndexTest, ArenaDestroysObjectsAndKeepsArraysAligned) {
+    int destroyed = 0;
+    struct Tracked {
+        int* counter;
+        std::string payload;
+        ~Tracked() { ++*counter; }
+    };
+    {
+        Arena arena(64);
+        for (int i = 0; i < 100; ++i) {
+            Tracked* t = arena.create<Tracked>(Tracked{&destroyed, std::string(40, 'x')});
+            EXPECT_EQ(t->payload.size(), 40u);
+        }
+        destroyed = 0;  // the temporaries above
+        std::vector<Literal> lits = {{0, "q0"}, {-1, "q1"}, {1, "q2"}};
+        auto copy = arena.copyArray<Literal>(lits.begin(), lits.end());
+        ASSERT_EQ(copy.size(), 3u);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(copy.data()) % alignof(Literal), 0u);
+        EXPECT_EQ(copy[1].qnext, "q1");
+        EXPECT_TRUE(arena.allocateArray<ClauseView>(0).empty());
+        // Doubling blocks: far fewer heap blocks than objects
+        EXPECT_LT(arena.numBlocks(), 12u);
+    }
+    EXPECT_EQ(destroyed, 100);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include "../include/statistics.h"
+#include "../include/Analyzers/Refinement.h"
+#include <sstream>
+#include <thread>
+
+using namespace ctl;
+
+TEST(StatisticsTest, CountsOfEveryThreadAreSummed) {
+    const StatisticValues before = Statistics::instance().snapshot();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 100; ++i) Statistics::instance().add(Statistic::PRODUCT_EDGES, 2);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    const StatisticValues delta = Statistics::instance().snapshot() - before;
+    EXPECT_EQ(delta[static_cast<size_t>(Statistic::PRODUCT_EDGES)], 800u);
+    EXPECT_EQ(delta[static_cast<size_t>(Statistic::PRODUCT_STATES)], 0u);
+}
+
+TEST(StatisticsTest, AnalyzerReportsItsOwnHotPathCounters) {
+    RefinementAnalyzer analyzer(std::vector<std::string>{"AG(x > 5 & y < 2)", "AG(x > 3)", "EF(x > 4)"});
+    analyzer.setParallelAnalysis(false);
+    analyzer.setUsePrefilter(false);
+    analyzer.analyze();
+
+    const auto& values = analyzer.getHotPathStatistics();
+    EXPECT_GT(values[static_cast<size_t>(Statistic::SMT_QUERIES)], 0u);
+    EXPECT_GT(values[static_cast<size_t>(Statistic::SIMULATION_CHECKS)], 0u);
+    EXPECT_GE(values[static_cast<size_t>(Statistic::SIMULATION_INITIAL_PAIRS)],
+              values[static_cast<size_t>(Statistic::SIMULATION_PAIRS_PRUNED)]);
+    EXPECT_GE(values[static_cast<size_t>(Statistic::AUTOMATA_BUILT)], 3u);
+    EXPECT_GE(values[static_cast<size_t>(Statistic::SCCS)], values[static_cast<size_t>(Statistic::AUTOMATA_BUILT)]);
+
+    auto stats = analyzer.getStatistics();
+    EXPECT_EQ(stats.at("simulation_checks"), values[static_cast<size_t>(Statistic::SIMULATION_CHECKS)]);
+
+    std::ostringstream out;
+    analyzer.writeStatisticsJsonRow(out, "in\"put.txt");
+    EXPECT_EQ(out.str().rfind("{\"input\":\"in\\\"put.txt\",\"smt_queries\":", 0), 0u);
+    EXPECT_NE(out.str().find("\"sccs\":"), std::string::npos);
+}
+
+TEST(StatisticsTest, ValidPropertiesDecidePairsWithoutChecks) {
+    // AG(p) | EF(!p) is valid: the other two refine it and it refines neither
+    RefinementAnalyzer analyzer(std::vector<std::string>{"AG(p) | EF(!p)", "AG(q & p)", "EF(!p & r)"});
+    analyzer.setParallelAnalysis(false);
+    analyzer.setUsePrefilter(false);
+    analyzer.setUseTransitiveOptimization(false);
+    auto result = analyzer.analyze();
+
+    EXPECT_EQ(analyzer.getProperties()[0]->knownValid(), std::optional<bool>(true));
+    EXPECT_EQ(analyzer.getProperties()[2]->knownValid(), std::optional<bool>(false));
+    const auto& values = analyzer.getHotPathStatistics();
+    EXPECT_EQ(values[static_cast<size_t>(Statistic::SATISFIABILITY_SHORTCUTS)], 4u);
+    EXPECT_EQ(values[static_cast<size_t>(Statistic::REFINEMENT_CHECKS)], 2u);
+    EXPECT_EQ(result.total_refinements, 2u);
+}
+
+TEST(StatisticsTest, ClassSimulationFindsThePairwiseRefinements) {
+    const std::vector<std::string> formulas{"AG(p & q)", "AG(p)", "EF(p)", "AF(p)", "E(p U q)", "A(p U q)", "EG(q)"};
+    for (bool parallel : {false, true}) {
+        RefinementAnalyzer pairwise(formulas);
+        pairwise.setParallelAnalysis(parallel);
+        pairwise.setUsePrefilter(false);
+        pairwise.setUseTransitiveOptimization(false);
+        auto expected = pairwise.analyze();
+
+        RefinementAnalyzer classwide(formulas);
+        classwide.setParallelAnalysis(parallel);
+        classwide.setUsePrefilter(false);
+        classwide.setUseTransitiveOptimization(false);
+        classwide.setClassSimulation(true);
+        auto result = classwide.analyze();
+
+        EXPECT_GT(expected.total_refinements, 0u);
+        EXPECT_EQ(result.total_refinements, expected.total_refinements) << parallel;
+        // One class, one fixpoint
+        EXPECT_EQ(classwide.getHotPathStatistics()[static_cast<size_t>(Statistic::CLASS_SIMULATIONS)], 1u) << parallel;
+    }
+}
+
+TEST(StatisticsTest, SharedSubformulasFindThePairwiseRefinements) {
+    const std::vector<std::string> formulas{"AG(p -> AF(q))", "AG(p -> AF(q)) & EF(r)", "AG(p -> AF(q)) | EG(r)",
+                                            "EF(p & q)", "A(p U q)", "E(p U q)"};
+    RefinementAnalyzer pairwise(formulas);
+    pairwise.setParallelAnalysis(false);
+    pairwise.setUsePrefilter(false);
+    pairwise.setUseTransitiveOptimization(false);
+    auto expected = pairwise.analyze();
+
+    RefinementAnalyzer shared(formulas);
+    shared.setParallelAnalysis(false);
+    shared.setUsePrefilter(false);
+    shared.setUseTransitiveOptimization(false);
+    shared.setSharedSubformulas(true);
+    auto result = shared.analyze();
+
+    EXPECT_GT(expected.total_refinements, 0u);
+    EXPECT_EQ(result.total_refinements, expected.total_refinements);
+    const auto& values = shared.getHotPathStatistics();
+    EXPECT_GT(values[static_cast<size_t>(Statistic::SHARED_MOVES_REUSED)], 0u);
+    EXPECT_GT(values[static_cast<size_t>(Statistic::SHARED_SIMULATION_VERDICTS)], 0u);
+}
+
+TEST(StatisticsTest, PipelinedAnalysisMatchesThePhasedOne) {
+    // The unsatisfiable property links the p/q and r/s groups until it is pruned
+    const std::vector<std::string> formulas{"AG(p & q)", "AG(p)", "EF(p)", "A(p U q)", "AG(q) & AG(!(q)) & EF(r)",
+                                            "EF(r & s)", "EF(r)", "AG(s)", "AF(t)", "EG(t)"};
+    for (bool transitive : {false, true}) {
+        RefinementAnalyzer phased(formulas);
+        phased.setParallelAnalysis(true);
+        phased.setUseTransitiveOptimization(transitive);
+        auto expected = phased.analyze();
+
+        RefinementAnalyzer pipelined(formulas);
+        pipelined.setParallelAnalysis(true);
+        pipelined.setUseTransitiveOptimization(transitive);
+        pipelined.setPipelinedAnalysis(true);
+        pipelined.setSharedSubformulas(true);
+        pipelined.setClassSimulation(true);
+        auto result = pipelined.analyze();
+
+        EXPECT_EQ(result.false_properties, 1u);
+        EXPECT_EQ(result.false_properties, expected.false_properties);
+        EXPECT_EQ(expected.equivalence_classes, 3u);
+        EXPECT_EQ(result.equivalence_classes, expected.equivalence_classes);
+        EXPECT_EQ(result.total_refinements, expected.total_refinements);
+        ASSERT_EQ(pipelined.getEquivalenceClasses().size(), phased.getEquivalenceClasses().size());
+        for (size_t c = 0; c < phased.getEquivalenceClasses().size(); ++c) {
+            const auto& mine = pipelined.getEquivalenceClasses()[c];
+            const auto& theirs = phased.getEquivalenceClasses()[c];
+            ASSERT_EQ(mine.size(), theirs.size()) << c;
+            for (size_t k = 0; k < mine.size(); ++k) EXPECT_EQ(mine[k]->toString(), theirs[k]->toString());
+            for (size_t i = 0; i < mine.size(); ++i) {
+                for (size_t j = 0; j < mine.size(); ++j) {
+                    EXPECT_EQ(pipelined.getRefinementGraphs()[c].hasEdge(i, j),
+                              phased.getRefinementGraphs()[c].hasEdge(i, j)) << c << ": " << i << " -> " << j;
+                }
+            }
+        }
+        EXPECT_EQ(pipelined.getPropertyPositions(), phased.getPropertyPositions());
+    }
+}
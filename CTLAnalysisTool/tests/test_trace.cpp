@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include "../include/trace.h"
+#include "../include/Analyzers/Refinement.h"
+#include <sstream>
+#include <thread>
+
+using namespace ctl;
+using trace::Tracer;
+
+namespace {
+
+size_t occurrences(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) ++count;
+    return count;
+}
+
+} // end anonymous namespace
+
+TEST(TraceTest, SpansOfEveryThreadAreExported) {
+    Tracer& tracer = Tracer::instance();
+    tracer.start();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 5; ++i) trace::Span span("test", "work");
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    tracer.stop();
+    { trace::Span ignored("test", "after stop"); }
+
+    EXPECT_EQ(tracer.eventCount(), 15u);
+    std::ostringstream out;
+    tracer.writeChromeTrace(out);
+    const std::string json = out.str();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+    EXPECT_EQ(occurrences(json, "\"name\":\"work\",\"cat\":\"test\",\"ph\":\"X\""), 15u);
+    EXPECT_EQ(occurrences(json, "after stop"), 0u);
+}
+
+TEST(TraceTest, FullRingKeepsTheLatestSpans) {
+    Tracer& tracer = Tracer::instance();
+    tracer.start(4);
+    std::thread worker([&tracer] {
+        const char* names[] = {"s0", "s1", "s2", "s3", "s4", "s5"};
+        for (const char* name : names) tracer.record("test", name, Tracer::now(), Tracer::now());
+    });
+    worker.join();
+    tracer.stop();
+
+    EXPECT_EQ(tracer.eventCount(), 4u);
+    std::ostringstream out;
+    tracer.writeChromeTrace(out);
+    const std::string json = out.str();
+    EXPECT_EQ(occurrences(json, "\"s0\""), 0u);
+    EXPECT_EQ(occurrences(json, "\"s1\""), 0u);
+    EXPECT_LT(json.find("\"s2\""), json.find("\"s5\""));
+}
+
+#ifdef CTL_TRACING
+TEST(TraceTest, AnalysisRecordsPhasesAndChecks) {
+    Tracer& tracer = Tracer::instance();
+    tracer.start();
+    RefinementAnalyzer analyzer({"AG(x > 5)", "AG(x > 3)", "EF(x < 1)"});
+    analyzer.setParallelAnalysis(false);
+    analyzer.analyze();
+    tracer.stop();
+
+    std::ostringstream out;
+    tracer.writeChromeTrace(out);
+    const std::string json = out.str();
+    EXPECT_EQ(occurrences(json, "\"cat\":\"phase\""), 4u);
+    EXPECT_GT(occurrences(json, "\"name\":\"build\",\"cat\":\"automaton\""), 0u);
+}
+#endif
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "../include/truth_table.h"
+#include "../include/smt_context_manager.h"
+#include "../include/statistics.h"
+#include "../include/property.h"
+
+#include <random>
+
+using namespace ctl;
+
+namespace {
+std::vector<GuardTable::Id> ids(const std::vector<std::string>& guards) {
+    std::vector<GuardTable::Id> out;
+    for (const auto& guard : guards) out.push_back(GuardTable::instance().intern(guard));
+    return out;
+}
+
+// A random propositional guard over atoms a0..a<atoms-1>
+std::string randomGuard(std::mt19937& rng, size_t atoms, int depth) {
+    std::uniform_int_distribution<int> pick(0, 5);
+    const int choice = depth == 0 ? 0 : pick(rng);
+    if (choice <= 1) return "a" + std::to_string(rng() % atoms);
+    if (choice == 2) return "!(" + randomGuard(rng, atoms, depth - 1) + ")";
+    const char* op = choice == 3 ? " & " : choice == 4 ? " | " : " -> ";
+    return "(" + randomGuard(rng, atoms, depth - 1) + op + randomGuard(rng, atoms, depth - 1) + ")";
+}
+}
+
+TEST(TruthTableTest, DecidesPropositionalGuards) {
+    auto& kernel = TruthTableKernel::instance();
+    EXPECT_EQ(kernel.satisfiable(ids({"p | q", "!(p)", "!(q)"})), std::optional<bool>(false));
+    EXPECT_EQ(kernel.satisfiable(ids({"p | q", "!(p)"})), std::optional<bool>(true));
+    EXPECT_EQ(kernel.satisfiable(ids({"p -> q", "p", "!(q) | false"})), std::optional<bool>(false));
+    EXPECT_EQ(kernel.entails(ids({"p & (q | r)"}), ids({"(p & q) | (p & r)"})), std::optional<bool>(true));
+    EXPECT_EQ(kernel.entails(ids({"p | q"}), ids({"p"})), std::optional<bool>(false));
+    EXPECT_EQ(kernel.entails(ids({"p", "!(p)"}), ids({"q"})), std::optional<bool>(true));
+    // Atoms past the sixth span several words
+    EXPECT_EQ(kernel.entails(ids({"a0 & a1 & a2 & a3 & a4 & a5 & a6 & a7"}), ids({"a7 | b"})), std::optional<bool>(true));
+    EXPECT_EQ(kernel.entails(ids({"a0 | a1 | a2 | a3 | a4 | a5 | a6 | a7"}), ids({"a7"})), std::optional<bool>(false));
+
+    // Comparisons and guards over too many atoms are left to the solver
+    EXPECT_EQ(kernel.satisfiable(ids({"p | x > 2"})), std::nullopt);
+    std::string wide = "c0";
+    for (size_t i = 1; i <= TruthTableKernel::kMaxAtoms; ++i) wide += " | c" + std::to_string(i);
+    EXPECT_EQ(kernel.satisfiable(ids({wide})), std::nullopt);
+    EXPECT_EQ(kernel.satisfiable(ids({"c0 | c1 | c2 | c3 | c4 | c5 | c6 | c7 | c8",
+                                      "d0 | d1 | d2 | d3 | d4 | d5 | d6 | d7 | d8"})), std::nullopt);
+}
+
+TEST(TruthTableTest, AgreesWithTheSolver) {
+    std::mt19937 rng(66);
+    SMTInterface& smt = SMTContextManager::local();
+    for (int round = 0; round < 200; ++round) {
+        const size_t atoms = round < 100 ? 4 : 9;
+        const std::vector<std::string> premise{randomGuard(rng, atoms, 3), randomGuard(rng, atoms, 2)};
+        const std::string conclusion = randomGuard(rng, atoms, 3);
+
+        const auto decided = TruthTableKernel::instance().satisfiable(ids(premise));
+        ASSERT_TRUE(decided.has_value());
+        EXPECT_EQ(*decided, smt.isSatisfiable(std::unordered_set<std::string>(premise.begin(), premise.end())))
+            << premise[0] << ", " << premise[1];
+
+        const auto entailed = TruthTableKernel::instance().entails(ids(premise), ids({conclusion}));
+        ASSERT_TRUE(entailed.has_value());
+        const std::unordered_set<std::string> counter{premise[0], premise[1], "!(" + conclusion + ")"};
+        EXPECT_EQ(*entailed, !smt.isSatisfiable(counter)) << premise[0] << ", " << premise[1] << " => " << conclusion;
+    }
+}
+
+TEST(TruthTableTest, SimulationDecidesDisjunctiveGuardsWithoutTheSolver) {
+    auto strong = std::make_shared<CTLProperty>("AG(p & (q | r))");
+    auto weak = std::make_shared<CTLProperty>("AG((p & q) | (p & r))");
+    const StatisticValues before = Statistics::instance().snapshot();
+    EXPECT_TRUE(strong->refines(*weak, false, false));
+    EXPECT_TRUE(weak->refines(*strong, false, false));
+    const StatisticValues delta = Statistics::instance().snapshot() - before;
+    EXPECT_GT(delta[static_cast<size_t>(Statistic::TRUTH_TABLE_DECISIONS)], 0u);
+}
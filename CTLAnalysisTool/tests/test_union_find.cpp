@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "../include/union_find.h"
+#include "../include/Analyzers/Refinement.h"
+
+using namespace ctl;
+
+TEST(UnionFindTest, ClassesComeInIndexOrder) {
+    UnionFind uf(6);
+    uf.unite(4, 1);
+    uf.unite(5, 3);
+    uf.unite(3, 1);
+    EXPECT_TRUE(uf.connected(5, 4));
+    EXPECT_FALSE(uf.connected(0, 2));
+    const std::vector<std::vector<size_t>> expected = {{0}, {1, 3, 4, 5}, {2}};
+    EXPECT_EQ(uf.getEquivalenceClasses(), expected);
+}
+
+TEST(UnionFindTest, FindAddsUnknownIndices) {
+    UnionFind uf;
+    EXPECT_EQ(uf.find(3), 3u);
+    EXPECT_EQ(uf.size(), 4u);
+    uf.unite(7, 0);
+    EXPECT_EQ(uf.size(), 8u);
+    EXPECT_TRUE(uf.connected(0, 7));
+    EXPECT_EQ(uf.getEquivalenceClasses().size(), 7u);
+}
+
+TEST(UnionFindTest, LongChainsStayShallow) {
+    const size_t n = 1 << 20;
+    UnionFind uf(n);
+    for (size_t i = 1; i < n; ++i) uf.unite(i - 1, i);
+    EXPECT_TRUE(uf.connected(0, n - 1));
+    EXPECT_EQ(uf.getEquivalenceClasses().size(), 1u);
+}
+
+TEST(EquivalenceClassTest, LiteralsDoNotLinkProperties) {
+    CTLProperty property("AG(p & info & x > 2.5) | true");
+    // Only whole numbers and booleans are literals: "info" is an atom
+    const auto& atoms = property.groupingAtoms();
+    EXPECT_TRUE(std::find(atoms.begin(), atoms.end(), "info") != atoms.end());
+    EXPECT_TRUE(std::find(atoms.begin(), atoms.end(), "2.5") == atoms.end());
+    EXPECT_TRUE(std::is_sorted(atoms.begin(), atoms.end()));
+}
+
+TEST(EquivalenceClassTest, AtomsKeepTheirPolarity) {
+    CTLProperty property("AG(p -> q) & EF(r & !r) & A(s U t)");
+    const auto& atoms = property.groupingAtoms();
+    const auto& polarities = property.groupingPolarities();
+    auto polarity = [&](const std::string& atom) {
+        return polarities[std::find(atoms.begin(), atoms.end(), atom) - atoms.begin()];
+    };
+    EXPECT_EQ(polarity("p"), CTLProperty::kNegative);
+    EXPECT_EQ(polarity("q"), CTLProperty::kPositive);
+    EXPECT_EQ(polarity("r"), CTLProperty::kPositive | CTLProperty::kNegative);
+    EXPECT_EQ(polarity("s"), CTLProperty::kPositive);
+    EXPECT_EQ(polarity("t"), CTLProperty::kPositive);
+}
+
+TEST(EquivalenceClassTest, PolarityClassesSplitOppositeAtoms) {
+    const std::vector<std::string> formulas = {"AG(p)", "AG(!p)", "AF(p & q)", "AG(p -> r)", "EF(!p)"};
+    RefinementAnalyzer unsigned_classes(formulas);
+    unsigned_classes.buildEquivalenceClasses();
+    EXPECT_EQ(unsigned_classes.getEquivalenceClasses().size(), 1u);
+
+    RefinementAnalyzer split(formulas);
+    split.setPolarityClasses(true);
+    split.buildEquivalenceClasses();
+    const auto& classes = split.getEquivalenceClasses();
+    ASSERT_EQ(classes.size(), 2u);
+    EXPECT_EQ(classes[0].size(), 2u);  // AG(p), AF(p & q)
+    EXPECT_EQ(classes[1].size(), 3u);  // AG(!p), AG(p -> r), EF(!p)
+
+    // No sampled model falsifies AG(p) | EF(!p): it may be valid, so it joins both
+    auto formulas_with_valid = formulas;
+    formulas_with_valid.push_back("AG(p) | EF(!p)");
+    RefinementAnalyzer joined(formulas_with_valid);
+    joined.setPolarityClasses(true);
+    joined.buildEquivalenceClasses();
+    EXPECT_EQ(joined.getEquivalenceClasses().size(), 1u);
+}
+
+TEST(EquivalenceClassTest, StripesAgreeWithOneScan) {
+    // Enough properties for several stripes: chains linked across stripe borders
+    std::vector<std::string> formulas;
+    for (size_t i = 0; i < 9000; ++i) {
+        formulas.push_back("AG(a" + std::to_string(i % 97) + " -> AF(b" + std::to_string(i % 89) + "))");
+    }
+    formulas.push_back("EF(lonely)");
+    RefinementAnalyzer serial(formulas);
+    serial.setThreads(1);
+    serial.buildEquivalenceClasses();
+    RefinementAnalyzer striped(formulas);
+    striped.setThreads(4);
+    striped.buildEquivalenceClasses();
+
+    ASSERT_EQ(serial.getEquivalenceClasses().size(), 2u);
+    ASSERT_EQ(striped.getEquivalenceClasses().size(), 2u);
+    for (size_t c = 0; c < 2; ++c) {
+        const auto& expected = serial.getEquivalenceClasses()[c];
+        const auto& actual = striped.getEquivalenceClasses()[c];
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t k = 0; k < expected.size(); ++k) EXPECT_EQ(expected[k]->toString(), actual[k]->toString());
+    }
+    EXPECT_EQ(striped.getEquivalenceClasses()[1].front()->toString(), CTLProperty("EF(lonely)").toString());
+}
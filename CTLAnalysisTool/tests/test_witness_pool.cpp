@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "../include/witness_pool.h"
+#include "../include/CTLautomaton.h"
+#include "../include/Analyzers/Refinement.h"
+#include "../include/statistics.h"
+
+using namespace ctl;
+
+namespace {
+
+bool refutes(WitnessPool& pool, const std::string& refining, const std::string& refined) {
+    return pool.refutes(*CTLProperty::create(refining), *CTLProperty::create(refined));
+}
+
+} // namespace
+
+TEST(WitnessPoolTest, ThreeValuedCheckOnAPartialModel) {
+    // p at the root, !p at both children, whose subtrees are left open
+    Witness witness;
+    witness.states.push_back({{"p"}, 1, 1});
+    witness.states.push_back({{"!(p)"}, Witness::kUnconstrained, Witness::kUnconstrained});
+    WitnessPool pool;
+    ASSERT_TRUE(pool.add(witness));
+    EXPECT_FALSE(pool.add(witness));
+    EXPECT_EQ(pool.size(), 1u);
+
+    EXPECT_TRUE(refutes(pool, "AX(!p)", "AG(p)"));
+    EXPECT_TRUE(refutes(pool, "p & EX(!p)", "EX(p) | AG(p)"));
+    // AF(p) holds at the root already
+    EXPECT_FALSE(refutes(pool, "AX(!p)", "AF(p)"));
+    // Open below the children and in q
+    EXPECT_FALSE(refutes(pool, "AX(!p)", "AX(AX(p))"));
+    EXPECT_FALSE(refutes(pool, "AX(!p)", "EF(q)"));
+    // Only where the refining property definitely holds
+    EXPECT_FALSE(refutes(pool, "EX(q)", "AG(p)"));
+}
+
+TEST(WitnessPoolTest, StateFormulasAreAskedAsAWhole) {
+    Witness witness;
+    witness.states.push_back({{"!((p) & (q))"}, 0, 0});
+    WitnessPool pool;
+    pool.add(witness);
+    // Neither p nor q is decided, but their conjunction fails everywhere
+    EXPECT_TRUE(refutes(pool, "AG(!(p & q))", "EF(p & q)"));
+    EXPECT_FALSE(refutes(pool, "AG(!(p & q))", "EF(p)"));
+}
+
+TEST(WitnessPoolTest, RefutationsLeaveTheirModels) {
+    auto refining = CTLProperty::create("EF(p)");
+    auto refined = CTLProperty::create("AG(p)");
+    std::vector<Witness> witnesses;
+    {
+        WitnessCapture capture;
+        EXPECT_FALSE(refined->automaton().languageIncludes(refining->automaton(), EmptinessEngine::FIXPOINT));
+        witnesses = capture.take();
+    }
+    ASSERT_EQ(witnesses.size(), 1u);
+    WitnessPool pool;
+    pool.add(std::move(witnesses.front()));
+    EXPECT_TRUE(pool.refutes(*refining, *refined));
+    EXPECT_TRUE(refutes(pool, "EF(p)", "AG(p & q)"));
+    EXPECT_FALSE(refutes(pool, "EF(p)", "EF(p | q)"));
+}
+
+TEST(WitnessPoolTest, AnalysisFindsTheSameRefinements) {
+    const std::vector<std::string> formulas{"AG(p)", "AF(p)", "AG(p & q)", "EF(q)", "EG(p)", "AG(p -> AF(q))",
+                                            "EF(p & q)", "AG(q)", "EF(p)", "EG(q)"};
+    for (bool parallel : {false, true}) {
+        RefinementAnalyzer plain(formulas), pooled(formulas);
+        for (RefinementAnalyzer* analyzer : {&plain, &pooled}) {
+            analyzer->setUsePrefilter(false);
+            analyzer->setFullLanguageInclusion(true);
+            analyzer->setParallelAnalysis(parallel);
+        }
+        pooled.setWitnessPool(true);
+        const AnalysisResult expected = plain.analyze();
+        const StatisticValues before = Statistics::instance().snapshot();
+        const AnalysisResult result = pooled.analyze();
+        const StatisticValues delta = Statistics::instance().snapshot() - before;
+
+        EXPECT_EQ(result.total_refinements, expected.total_refinements);
+        ASSERT_EQ(pooled.getRefinementGraphs().size(), plain.getRefinementGraphs().size());
+        for (size_t c = 0; c < plain.getRefinementGraphs().size(); ++c) {
+            const auto& a = plain.getRefinementGraphs()[c];
+            const auto& b = pooled.getRefinementGraphs()[c];
+            for (size_t i = 0; i < a.getNodes().size(); ++i) {
+                for (size_t j = 0; j < a.getNodes().size(); ++j) {
+                    if (i != j) {
+                        EXPECT_EQ(a.hasEdge(i, j), b.hasEdge(i, j)) << c << ": " << i << " -> " << j;
+                    }
+                }
+            }
+        }
+        EXPECT_GT(delta[static_cast<size_t>(Statistic::WITNESSES_KEPT)], 0u);
+        if (!parallel) {
+            EXPECT_GT(delta[static_cast<size_t>(Statistic::WITNESS_REFUTATIONS)], 0u);
+        }
+    }
+}
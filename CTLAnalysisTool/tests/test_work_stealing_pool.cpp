@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "../include/work_stealing_pool.h"
+#include <atomic>
+#include <stdexcept>
+
+using namespace ctl;
+
+TEST(WorkStealingPoolTest, RunsEverySubmittedTask) {
+    WorkStealingPool pool(4);
+    std::atomic<size_t> counter(0);
+    for (size_t i = 0; i < 1000; ++i) {
+        pool.submit([&](size_t) { counter.fetch_add(1); });
+    }
+    pool.wait();
+    EXPECT_EQ(counter.load(), 1000u);
+}
+
+TEST(WorkStealingPoolTest, ReusableAcrossBatches) {
+    WorkStealingPool pool(3);
+    std::atomic<size_t> counter(0);
+    for (size_t batch = 0; batch < 5; ++batch) {
+        for (size_t i = 0; i < 50; ++i) {
+            pool.submit([&](size_t worker) {
+                EXPECT_LT(worker, 3u);
+                counter.fetch_add(1);
+            });
+        }
+        pool.wait();
+        EXPECT_EQ(counter.load(), (batch + 1) * 50);
+    }
+}
+
+TEST(WorkStealingPoolTest, WaitRethrowsTaskException) {
+    WorkStealingPool pool(2);
+    pool.submit([](size_t) { throw std::runtime_error("boom"); });
+    EXPECT_THROW(pool.wait(), std::runtime_error);
+    // The pool stays usable after an error
+    std::atomic<int> ran(0);
+    pool.submit([&](size_t) { ran = 1; });
+    pool.wait();
+    EXPECT_EQ(ran.load(), 1);
+}
+
+TEST(WorkStealingPoolTest, IdleWorkersStealFromBusyQueue) {
+    WorkStealingPool pool(4);
+    std::atomic<bool> release(false);
+    std::atomic<size_t> counter(0);
+    // The first task blocks its worker; everything queued behind it must still run
+    pool.submit([&](size_t) { while (!release.load()) std::this_thread::yield(); });
+    for (size_t i = 0; i < 200; ++i) {
+        pool.submit([&](size_t) { counter.fetch_add(1); });
+    }
+    while (counter.load() < 200) std::this_thread::yield();
+    release = true;
+    pool.wait();
+    EXPECT_EQ(counter.load(), 200u);
+}
@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+"""Performance regression mode for the refinement tool.
+
+Records a baseline of repeated runs over a set of inputs, then reruns the
+same inputs with the same tool arguments and reports, per input and per
+phase, the changes that are statistically significant.
+
+    # Five runs per input file, stored with the tool arguments
+    python3 scripts/perf_regression.py record --tool ./CTLAnalysisTool/build/ctl_refine_tool \
+        --baseline baseline.json --repetitions 5 ./assets/benchmark/Dataset_clean -- -j 4
+
+    # After a change: rerun the baseline's inputs and compare
+    python3 scripts/perf_regression.py compare --tool ./CTLAnalysisTool/build/ctl_refine_tool \
+        --baseline baseline.json --report comparison.json
+
+Every run goes through one input file with --json and --stats-json, so a
+sample holds the phase times and memory of the JSON row, the peak resident
+set size of the process and the hot-path counters (SMT queries, simulation
+and product work, ...). Lower is better for all of them.
+
+A change is reported when an exact two-sided permutation test on the
+difference of means rejects equality at --alpha and the medians differ by at
+least --threshold (relative). With five repetitions per side the smallest
+attainable p-value is 2/252, so five is the least that supports alpha=0.05.
+Results that differ from the baseline (refinements, required properties) are
+reported separately: a performance change must not change them.
+
+Only the standard library is needed.
+"""
+
+import argparse
+import itertools
+import json
+import math
+import os
+import random
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+# Fields of the JSON row that describe the result rather than its cost
+RESULT_FIELDS = ["total_properties", "equivalence_classes", "total_refinements", "required_properties"]
+# Fields of the JSON row compared as phases, in report order
+PHASE_FIELDS = ["parsing_time_ms", "equivalence_time_ms", "automaton_time_ms", "refinement_time_ms",
+                "total_time_ms", "total_analysis_memory_kb", "refinement_memory_kb"]
+EXACT_PERMUTATION_LIMIT = 20000
+RANDOM_PERMUTATIONS = 20000
+
+
+def expand_inputs(paths):
+    """Input files in a stable order: folders contribute their .txt files."""
+    files = []
+    for path in map(Path, paths):
+        if path.is_dir():
+            files.extend(sorted(str(p) for p in path.glob("*.txt")))
+        else:
+            files.append(str(path))
+    return files
+
+
+def run_once(tool, input_file, tool_args, timeout_s):
+    """One run of the tool on one input; returns (metrics, results) or raises."""
+    with tempfile.TemporaryDirectory(prefix="perf_regression_") as work:
+        json_rows = os.path.join(work, "rows.json")
+        stats_rows = os.path.join(work, "stats.json")
+        cmd = [tool, input_file, "-o", os.path.join(work, "output"),
+               "--json", json_rows, "--stats-json", stats_rows] + list(tool_args)
+        # A file, not a pipe: the tool logs a line per removed property, and a
+        # full pipe would block it while nothing reads until it exits
+        stderr_file = tempfile.TemporaryFile(mode="w+", dir=work)
+        start = time.perf_counter()
+        proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=stderr_file)
+        deadline = start + timeout_s if timeout_s else None
+        # wait4 reports the peak RSS of this child alone
+        while True:
+            pid, status, usage = os.wait4(proc.pid, os.WNOHANG)
+            if pid == proc.pid:
+                break
+            if deadline and time.perf_counter() > deadline:
+                proc.kill()
+                os.wait4(proc.pid, 0)
+                stderr_file.close()
+                raise RuntimeError(f"timed out after {timeout_s} s")
+            time.sleep(0.01)
+        proc.returncode = os.waitstatus_to_exitcode(status)
+        stderr_file.seek(0)
+        stderr = stderr_file.read()
+        stderr_file.close()
+        if proc.returncode != 0:
+            raise RuntimeError(f"exit code {proc.returncode}: {stderr.strip()[-500:]}")
+
+        with open(json_rows) as f:
+            row = json.loads(f.readline())
+        with open(stats_rows) as f:
+            counters = json.loads(f.readline())
+
+    metrics = {field: float(row[field]) for field in PHASE_FIELDS if field in row}
+    metrics["wall_time_ms"] = (time.perf_counter() - start) * 1000.0
+    metrics["peak_rss_kb"] = float(usage.ru_maxrss)
+    for name, value in counters.items():
+        if name != "input":
+            metrics[name] = float(value)
+    results = {field: row[field] for field in RESULT_FIELDS if field in row}
+    return metrics, results
+
+
+def measure(tool, inputs, tool_args, repetitions, timeout_s):
+    """Runs every input `repetitions` times, round robin so drift spreads evenly."""
+    samples = {name: {"metrics": {}, "results": None, "errors": []} for name in inputs}
+    for rep in range(repetitions):
+        for name in inputs:
+            print(f"[{rep + 1}/{repetitions}] {name}", file=sys.stderr)
+            entry = samples[name]
+            try:
+                metrics, results = run_once(tool, name, tool_args, timeout_s)
+            except Exception as e:  # a failed run is recorded, not fatal
+                entry["errors"].append(str(e))
+                continue
+            for metric, value in metrics.items():
+                entry["metrics"].setdefault(metric, []).append(value)
+            entry["results"] = results
+    return samples
+
+
+def permutation_p_value(a, b):
+    """Two-sided p-value of the difference of means under exchangeability."""
+    pooled = a + b
+    n, total = len(a), sum(pooled)
+    observed = abs(sum(a) / len(a) - sum(b) / len(b))
+    eps = 1e-9 * max(1.0, observed)
+
+    def extreme(group_sum):
+        return abs(group_sum / n - (total - group_sum) / len(b)) >= observed - eps
+
+    if math.comb(len(pooled), n) <= EXACT_PERMUTATION_LIMIT:
+        hits = count = 0
+        for chosen in itertools.combinations(range(len(pooled)), n):
+            count += 1
+            hits += extreme(sum(pooled[i] for i in chosen))
+        return hits / count
+    rng = random.Random(0)
+    hits = sum(extreme(sum(rng.sample(pooled, n))) for _ in range(RANDOM_PERMUTATIONS))
+    return (hits + 1) / (RANDOM_PERMUTATIONS + 1)
+
+
+def compare_samples(baseline, current, alpha, threshold):
+    """Verdict of one metric: 'regression', 'improvement' or None, with its numbers."""
+    if len(baseline) < 2 or len(current) < 2:
+        return None, {}
+    base_median, cur_median = statistics.median(baseline), statistics.median(current)
+    change = (cur_median - base_median) / base_median if base_median else (0.0 if cur_median == 0 else math.inf)
+    p = permutation_p_value(current, baseline)
+    verdict = None
+    if p < alpha and abs(change) >= threshold:
+        verdict = "regression" if change > 0 else "improvement"
+    return verdict, {"baseline_median": base_median, "current_median": cur_median,
+                     "relative_change": change, "p_value": p}
+
+
+def compare(baseline, current, alpha, threshold):
+    """Per input and per metric comparison, plus the per-phase totals."""
+    per_input, mismatches, failures = {}, [], []
+    phase_totals = {}
+    for name, base in baseline["inputs"].items():
+        cur = current.get(name)
+        if cur is None or cur["errors"] and not cur["metrics"]:
+            failures.append({"input": name, "errors": cur["errors"] if cur else ["not run"]})
+            continue
+        if base["results"] is not None and cur["results"] != base["results"]:
+            mismatches.append({"input": name, "baseline": base["results"], "current": cur["results"]})
+        entries = {}
+        for metric, base_values in base["metrics"].items():
+            cur_values = cur["metrics"].get(metric, [])
+            verdict, numbers = compare_samples(base_values, cur_values, alpha, threshold)
+            if not numbers:
+                continue
+            entries[metric] = dict(numbers, verdict=verdict)
+            totals = phase_totals.setdefault(metric, {"baseline": 0.0, "current": 0.0,
+                                                      "regressions": 0, "improvements": 0})
+            totals["baseline"] += numbers["baseline_median"]
+            totals["current"] += numbers["current_median"]
+            if verdict:
+                totals[verdict + "s"] += 1
+        per_input[name] = entries
+    return {"alpha": alpha, "threshold": threshold, "inputs": per_input, "phases": phase_totals,
+            "result_mismatches": mismatches, "failures": failures}
+
+
+def print_report(comparison, show_all):
+    def pct(x):
+        return "inf" if math.isinf(x) else f"{x * 100:+.1f}%"
+
+    print(f"\nSignificant changes (p < {comparison['alpha']}, |median change| >= "
+          f"{comparison['threshold'] * 100:.0f}%):")
+    changes = 0
+    for name, entries in comparison["inputs"].items():
+        for metric, e in entries.items():
+            if e["verdict"] or show_all:
+                changes += e["verdict"] is not None
+                label = (e["verdict"] or "unchanged").upper()
+                print(f"  {label:<11} {Path(name).name:<40} {metric:<32} "
+                      f"{e['baseline_median']:>12.1f} -> {e['current_median']:>12.1f}  "
+                      f"{pct(e['relative_change']):>8}  p={e['p_value']:.4f}")
+    if changes == 0:
+        print("  none")
+
+    print("\nPer phase (sum of per-input medians):")
+    ordered = [m for m in PHASE_FIELDS + ["wall_time_ms", "peak_rss_kb"] if m in comparison["phases"]]
+    ordered += sorted(m for m in comparison["phases"] if m not in ordered)
+    for metric in ordered:
+        t = comparison["phases"][metric]
+        if not show_all and t["baseline"] == 0 and t["current"] == 0:
+            continue
+        change = (t["current"] - t["baseline"]) / t["baseline"] if t["baseline"] else 0.0
+        print(f"  {metric:<32} {t['baseline']:>14.1f} -> {t['current']:>14.1f}  {pct(change):>8}  "
+              f"({t['regressions']} inputs regressed, {t['improvements']} improved)")
+
+    for m in comparison["result_mismatches"]:
+        print(f"\nRESULT MISMATCH {m['input']}: baseline {m['baseline']}, now {m['current']}")
+    for f in comparison["failures"]:
+        print(f"\nFAILED {f['input']}: {'; '.join(f['errors'])}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Record a performance baseline or compare against one.")
+    parser.add_argument("mode", choices=["record", "compare"])
+    parser.add_argument("inputs", nargs="*", help="property files or folders (record only)")
+    parser.add_argument("--tool", default="./CTLAnalysisTool/build/ctl_refine_tool")
+    parser.add_argument("--baseline", required=True, help="baseline JSON file")
+    parser.add_argument("--repetitions", type=int,
+                        help="runs per input (record: 5, compare: as many as the baseline has)")
+    parser.add_argument("--timeout", type=float, default=0, help="seconds per run, 0 for none")
+    parser.add_argument("--alpha", type=float, default=0.05)
+    parser.add_argument("--threshold", type=float, default=0.05, help="least relative change reported")
+    parser.add_argument("--report", help="also write the comparison as JSON")
+    parser.add_argument("--all", action="store_true", help="list unchanged metrics too")
+    parser.add_argument("--fail-on-regression", action="store_true",
+                        help="exit with 1 on a significant regression, a result mismatch or a failed input")
+    argv = sys.argv[1:]
+    tool_args = []
+    if "--" in argv:
+        split = argv.index("--")
+        argv, tool_args = argv[:split], argv[split + 1:]
+    args = parser.parse_intermixed_args(argv)
+
+    baseline = None
+    if args.mode == "compare":
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    if args.repetitions is None:
+        args.repetitions = baseline["repetitions"] if baseline else 5
+    if args.repetitions < 2:
+        parser.error("--repetitions must be at least 2")
+    if 2 / math.comb(2 * args.repetitions, args.repetitions) >= args.alpha:
+        print(f"Warning: {args.repetitions} repetitions cannot reach p < {args.alpha}; use more",
+              file=sys.stderr)
+
+    if args.mode == "record":
+        inputs = expand_inputs(args.inputs)
+        if not inputs:
+            parser.error("record needs at least one input")
+        samples = measure(args.tool, inputs, tool_args, args.repetitions, args.timeout)
+        with open(args.baseline, "w") as f:
+            json.dump({"tool_args": tool_args, "repetitions": args.repetitions, "inputs": samples}, f, indent=1)
+        failed = [name for name, s in samples.items() if s["errors"]]
+        print(f"Baseline of {len(inputs)} inputs x {args.repetitions} runs written to {args.baseline}")
+        for name in failed:
+            print(f"  {name}: {len(samples[name]['errors'])} failed runs")
+        return 0
+
+    if args.inputs:
+        parser.error("compare reruns the baseline's inputs; give none")
+    # The same runs as the baseline, unless arguments after -- replace them
+    run_args = tool_args or baseline["tool_args"]
+    current = measure(args.tool, list(baseline["inputs"]), run_args, args.repetitions, args.timeout)
+    comparison = compare(baseline, current, args.alpha, args.threshold)
+    print_report(comparison, args.all)
+    if args.report:
+        with open(args.report, "w") as f:
+            json.dump(comparison, f, indent=1)
+
+    regressed = any(e["verdict"] == "regression" for entries in comparison["inputs"].values()
+                    for e in entries.values())
+    if args.fail_on_regression and (regressed or comparison["result_mismatches"] or comparison["failures"]):
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())